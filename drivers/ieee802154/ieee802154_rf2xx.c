@@ -336,6 +336,8 @@ static enum ieee802154_hw_caps rf2xx_get_capabilities(struct device *dev)
 	       IEEE802154_HW_FILTER |
 	       IEEE802154_HW_CSMA |
 	       IEEE802154_HW_TX_RX_ACK |
+	       IEEE802154_HW_RETRANSMISSION |
+	       IEEE802154_HW_RX_TX_ACK |
 	       IEEE802154_HW_2_4_GHZ;
 }
 
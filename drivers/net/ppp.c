@@ -28,13 +28,14 @@ LOG_MODULE_REGISTER(net_ppp, LOG_LEVEL);
 #include <net/net_if.h>
 #include <net/net_core.h>
 #include <sys/ring_buffer.h>
-#include <sys/crc.h>
 #include <drivers/uart.h>
 #include <drivers/console/uart_mux.h>
 
 #include "../../subsys/net/ip/net_stats.h"
 #include "../../subsys/net/ip/net_private.h"
 
+#include "ppp_hdlc.h"
+
 #define UART_BUF_LEN CONFIG_NET_PPP_UART_BUF_LEN
 
 enum ppp_driver_state {
@@ -58,6 +59,9 @@ struct ppp_driver_context {
 	/* How much free space we have in the net_pkt */
 	size_t available;
 
+	/* FCS of the data in the net_pkt */
+	uint16_t fcs;
+
 	/* ppp data is read into this buf */
 	uint8_t buf[UART_BUF_LEN];
 
@@ -78,6 +82,15 @@ struct ppp_driver_context {
 	struct k_work cb_work;
 	struct k_work_q cb_workq;
 
+#if defined(CONFIG_NET_PPP_ASYNC_UART)
+	/* The UART driver receives data to these buffers in turn */
+	uint8_t rx_async_buf[2][CONFIG_NET_PPP_ASYNC_UART_RX_BUF_LEN];
+	uint8_t rx_async_idx;
+
+	/* Given when the send buffer has been written to the UART */
+	struct k_sem tx_sem;
+#endif
+
 #if defined(CONFIG_NET_STATISTICS_PPP)
 	struct net_stats_ppp stats;
 #endif
@@ -94,8 +107,10 @@ struct ppp_driver_context {
 
 static struct ppp_driver_context ppp_driver_context_data;
 
-static int ppp_save_byte(struct ppp_driver_context *ppp, uint8_t byte)
+static int ppp_save_bytes(struct ppp_driver_context *ppp,
+			  const uint8_t *data, size_t len)
 {
+	size_t count;
 	int ret;
 
 	if (!ppp->pkt) {
@@ -111,39 +126,49 @@ static int ppp_save_byte(struct ppp_driver_context *ppp, uint8_t byte)
 		net_pkt_cursor_init(ppp->pkt);
 
 		ppp->available = net_pkt_available_buffer(ppp->pkt);
+		ppp->fcs = PPP_HDLC_INIT_FCS;
 	}
 
 	/* Extra debugging can be enabled separately if really
 	 * needed. Normally it would just print too much data.
 	 */
 	if (0) {
-		LOG_DBG("Saving byte %02x", byte);
+		LOG_HEXDUMP_DBG(data, len, "Saving bytes");
 	}
 
-	/* This is not very intuitive but we must allocate new buffer
-	 * before we write a byte to last available cursor position.
-	 */
-	if (ppp->available == 1) {
-		ret = net_pkt_alloc_buffer(ppp->pkt,
-					   CONFIG_NET_BUF_DATA_SIZE,
-					   AF_UNSPEC, K_NO_WAIT);
-		if (ret < 0) {
-			LOG_ERR("[%p] cannot allocate new data buffer", ppp);
-			goto out_of_mem;
+	while (len > 0) {
+		/* This is not very intuitive but we must allocate new buffer
+		 * before we write a byte to last available cursor position.
+		 */
+		if (ppp->available <= 1) {
+			ret = net_pkt_alloc_buffer(ppp->pkt,
+						   CONFIG_NET_BUF_DATA_SIZE,
+						   AF_UNSPEC, K_NO_WAIT);
+			if (ret < 0) {
+				LOG_ERR("[%p] cannot allocate new data buffer",
+					ppp);
+				goto out_of_mem;
+			}
+
+			ppp->available = net_pkt_available_buffer(ppp->pkt);
 		}
 
-		ppp->available = net_pkt_available_buffer(ppp->pkt);
-	}
+		count = MIN(len, ppp->available - 1);
 
-	if (ppp->available) {
-		ret = net_pkt_write_u8(ppp->pkt, byte);
+		ret = net_pkt_write(ppp->pkt, data, count);
 		if (ret < 0) {
 			LOG_ERR("[%p] Cannot write to pkt %p (%d)",
 				ppp, ppp->pkt, ret);
 			goto out_of_mem;
 		}
 
-		ppp->available--;
+		if (IS_ENABLED(CONFIG_NET_PPP_VERIFY_FCS)) {
+			ppp->fcs = ppp_hdlc_fcs(ppp->fcs, data, count);
+		}
+
+		ppp->available -= count;
+		data += count;
+		len -= count;
 	}
 
 	return 0;
@@ -154,6 +179,11 @@ out_of_mem:
 	return -ENOMEM;
 }
 
+static inline int ppp_save_byte(struct ppp_driver_context *ppp, uint8_t byte)
+{
+	return ppp_save_bytes(ppp, &byte, 1);
+}
+
 static const char *ppp_driver_state_str(enum ppp_driver_state state)
 {
 #if (CONFIG_NET_PPP_LOG_LEVEL >= LOG_LEVEL_DBG)
@@ -193,13 +223,24 @@ static void ppp_change_state(struct ppp_driver_context *ctx,
 
 static int ppp_send_flush(struct ppp_driver_context *ppp, int off)
 {
-	if (!IS_ENABLED(CONFIG_NET_TEST)) {
-		uint8_t *buf = ppp->send_buf;
+	if (IS_ENABLED(CONFIG_NET_TEST) || off == 0) {
+		return 0;
+	}
 
-		while (off--) {
-			uart_poll_out(ppp->dev, *buf++);
-		}
+#if defined(CONFIG_NET_PPP_ASYNC_UART)
+	if (uart_tx(ppp->dev, ppp->send_buf, off, SYS_FOREVER_MS) == 0) {
+		/* The buffer is reused once it has been written */
+		k_sem_take(&ppp->tx_sem, K_FOREVER);
+	} else {
+		LOG_DBG("[%p] Cannot send %d bytes", ppp, off);
+	}
+#else
+	uint8_t *buf = ppp->send_buf;
+
+	while (off--) {
+		uart_poll_out(ppp->dev, *buf++);
 	}
+#endif
 
 	return 0;
 }
@@ -220,6 +261,28 @@ static int ppp_send_bytes(struct ppp_driver_context *ppp,
 	return off;
 }
 
+static int ppp_send_escaped(struct ppp_driver_context *ppp,
+			    const uint8_t *data, size_t len, int off)
+{
+	size_t count, written;
+
+	while (len > 0) {
+		written = sizeof(ppp->send_buf) - off;
+		count = ppp_hdlc_escape(data, len, &ppp->send_buf[off],
+					&written);
+
+		off += written;
+		data += count;
+		len -= count;
+
+		if (len > 0 || off >= sizeof(ppp->send_buf)) {
+			off = ppp_send_flush(ppp, off);
+		}
+	}
+
+	return off;
+}
+
 #if defined(CONFIG_PPP_CLIENT_CLIENTSERVER)
 
 #define CLIENT "CLIENT"
@@ -314,6 +377,7 @@ static int ppp_input_byte(struct ppp_driver_context *ppp, uint8_t byte)
 		if (byte == 0x7e) {
 			LOG_DBG("End of pkt (0x%02x)", byte);
 			ppp_change_state(ppp, STATE_HDLC_FRAME_ADDRESS);
+			ppp->next_escaped = false;
 			ret = 0;
 		} else {
 			if (byte == 0x7d) {
@@ -348,25 +412,9 @@ static int ppp_input_byte(struct ppp_driver_context *ppp, uint8_t byte)
 
 static bool ppp_check_fcs(struct ppp_driver_context *ppp)
 {
-	struct net_buf *buf;
-	uint16_t crc;
-
-	buf = ppp->pkt->buffer;
-	if (!buf) {
-		return false;
-	}
-
-	crc = crc16_ccitt(0xffff, buf->data, buf->len);
-
-	buf = buf->frags;
-
-	while (buf) {
-		crc = crc16_ccitt(crc, buf->data, buf->len);
-		buf = buf->frags;
-	}
-
-	if (crc != 0xf0b8) {
-		LOG_DBG("Invalid FCS (0x%x)", crc);
+	/* The FCS is calculated while the data is saved */
+	if (ppp->fcs != PPP_HDLC_GOOD_FCS) {
+		LOG_DBG("Invalid FCS (0x%x)", ppp->fcs);
 #if defined(CONFIG_NET_STATISTICS_PPP)
 		ppp->stats.chkerr++;
 #endif
@@ -423,37 +471,57 @@ static void ppp_process_msg(struct ppp_driver_context *ppp)
 	ppp->pkt = NULL;
 }
 
-#if defined(CONFIG_NET_TEST)
-static uint8_t *ppp_recv_cb(uint8_t *buf, size_t *off)
+/* Process received data, which is unescaped in place */
+static void ppp_input(struct ppp_driver_context *ppp, uint8_t *data,
+		      size_t len)
 {
-	struct ppp_driver_context *ppp =
-		CONTAINER_OF(buf, struct ppp_driver_context, buf);
-	size_t i, len = *off;
+	size_t count, unescaped;
+	bool escaped;
 
-	for (i = 0; i < *off; i++) {
-		if (0) {
-			/* Extra debugging can be enabled separately if really
-			 * needed. Normally it would just print too much data.
-			 */
-			LOG_DBG("[%zd] %02x", i, buf[i]);
+	while (len > 0) {
+		if (ppp->state != STATE_HDLC_FRAME_DATA) {
+			(void)ppp_input_byte(ppp, *data++);
+			len--;
+			continue;
 		}
 
-		if (ppp_input_byte(ppp, buf[i]) == 0) {
+		/* Save the frame data up to the next flag at once */
+		escaped = ppp->next_escaped;
+		count = ppp_hdlc_unescape(data, len, data, &unescaped,
+					  &escaped);
+		ppp->next_escaped = escaped;
+
+		if (unescaped > 0 && ppp_save_bytes(ppp, data, unescaped) < 0) {
+			ppp_change_state(ppp, STATE_HDLC_FRAME_START);
+		}
+
+		data += count;
+		len -= count;
+
+		if (len == 0) {
+			break;
+		}
+
+		if (ppp_input_byte(ppp, *data++) == 0) {
 			/* Ignore empty or too short frames */
 			if (ppp->pkt && net_pkt_get_len(ppp->pkt) > 3) {
 				ppp_process_msg(ppp);
-				break;
 			}
 		}
+
+		len--;
 	}
+}
 
-	if (i == *off) {
-		*off = 0;
-	} else {
-		*off = len - i - 1;
+#if defined(CONFIG_NET_TEST)
+static uint8_t *ppp_recv_cb(uint8_t *buf, size_t *off)
+{
+	struct ppp_driver_context *ppp =
+		CONTAINER_OF(buf, struct ppp_driver_context, buf);
 
-		memmove(&buf[0], &buf[i + 1], *off);
-	}
+	ppp_input(ppp, buf, *off);
+
+	*off = 0;
 
 	return buf;
 }
@@ -506,15 +574,15 @@ static bool calc_fcs(struct net_pkt *pkt, uint16_t *fcs, uint16_t protocol)
 	/* HDLC Address and Control fields */
 	c = sys_cpu_to_be16(0xff << 8 | 0x03);
 
-	crc = crc16_ccitt(0xffff, (const uint8_t *)&c, sizeof(c));
+	crc = ppp_hdlc_fcs(PPP_HDLC_INIT_FCS, (const uint8_t *)&c, sizeof(c));
 
 	if (protocol > 0) {
-		crc = crc16_ccitt(crc, (const uint8_t *)&protocol,
-				  sizeof(protocol));
+		crc = ppp_hdlc_fcs(crc, (const uint8_t *)&protocol,
+				   sizeof(protocol));
 	}
 
 	while (buf) {
-		crc = crc16_ccitt(crc, buf->data, buf->len);
+		crc = ppp_hdlc_fcs(crc, buf->data, buf->len);
 		buf = buf->frags;
 	}
 
@@ -524,17 +592,6 @@ static bool calc_fcs(struct net_pkt *pkt, uint16_t *fcs, uint16_t protocol)
 	return true;
 }
 
-static uint16_t ppp_escape_byte(uint8_t byte, int *offset)
-{
-	if (byte == 0x7e || byte == 0x7d || byte < 0x20) {
-		*offset = 0;
-		return (0x7d << 8) | (byte ^ 0x20);
-	}
-
-	*offset = 1;
-	return byte;
-}
-
 static int ppp_send(struct device *dev, struct net_pkt *pkt)
 {
 	struct ppp_driver_context *ppp = dev->driver_data;
@@ -542,9 +599,9 @@ static int ppp_send(struct device *dev, struct net_pkt *pkt)
 	uint16_t protocol = 0;
 	int send_off = 0;
 	uint32_t sync_addr_ctrl;
-	uint16_t fcs, escaped;
+	uint8_t fcs_bytes[2];
+	uint16_t fcs;
 	uint8_t byte;
-	int i, offset;
 
 #if defined(CONFIG_NET_TEST)
 	return 0;
@@ -581,15 +638,8 @@ static int ppp_send(struct device *dev, struct net_pkt *pkt)
 				  sizeof(sync_addr_ctrl), send_off);
 
 	if (protocol > 0) {
-		escaped = htons(ppp_escape_byte(protocol, &offset));
-		send_off = ppp_send_bytes(ppp, (uint8_t *)&escaped + offset,
-					  offset ? 1 : 2,
-					  send_off);
-
-		escaped = htons(ppp_escape_byte(protocol >> 8, &offset));
-		send_off = ppp_send_bytes(ppp, (uint8_t *)&escaped + offset,
-					  offset ? 1 : 2,
-					  send_off);
+		send_off = ppp_send_escaped(ppp, (const uint8_t *)&protocol,
+					    sizeof(protocol), send_off);
 	}
 
 	/* Note that we do not print the first four bytes and FCS bytes at the
@@ -601,27 +651,15 @@ static int ppp_send(struct device *dev, struct net_pkt *pkt)
 	}
 
 	while (buf) {
-		for (i = 0; i < buf->len; i++) {
-			/* Escape illegal bytes */
-			escaped = htons(ppp_escape_byte(buf->data[i], &offset));
-			send_off = ppp_send_bytes(ppp,
-						  (uint8_t *)&escaped + offset,
-						  offset ? 1 : 2,
-						  send_off);
-		}
-
+		/* Escape illegal bytes */
+		send_off = ppp_send_escaped(ppp, buf->data, buf->len,
+					    send_off);
 		buf = buf->frags;
 	}
 
-	escaped = htons(ppp_escape_byte(fcs, &offset));
-	send_off = ppp_send_bytes(ppp, (uint8_t *)&escaped + offset,
-				  offset ? 1 : 2,
-				  send_off);
-
-	escaped = htons(ppp_escape_byte(fcs >> 8, &offset));
-	send_off = ppp_send_bytes(ppp, (uint8_t *)&escaped + offset,
-				  offset ? 1 : 2,
-				  send_off);
+	sys_put_le16(fcs, fcs_bytes);
+	send_off = ppp_send_escaped(ppp, fcs_bytes, sizeof(fcs_bytes),
+				    send_off);
 
 	byte = 0x7e;
 	send_off = ppp_send_bytes(ppp, &byte, 1, send_off);
@@ -637,36 +675,31 @@ static void ppp_isr_cb_work(struct k_work *work)
 	struct ppp_driver_context *ppp =
 		CONTAINER_OF(work, struct ppp_driver_context, cb_work);
 	uint8_t *data;
-	size_t len, tmp;
+	size_t len;
 	int ret;
 
-	len = ring_buf_get_claim(&ppp->rx_ringbuf, &data,
-				 CONFIG_NET_PPP_RINGBUF_SIZE);
-	if (len == 0) {
-		LOG_DBG("Ringbuf %p is empty!", &ppp->rx_ringbuf);
-		return;
-	}
+	/* The data can wrap around the end of the ring buffer */
+	while (true) {
+		len = ring_buf_get_claim(&ppp->rx_ringbuf, &data,
+					 CONFIG_NET_PPP_RINGBUF_SIZE);
+		if (len == 0) {
+			break;
+		}
 
-	/* This will print too much data, enable only if really needed */
-	if (0) {
-		LOG_HEXDUMP_DBG(data, len, ppp->dev->name);
-	}
+		/* This will print too much data, enable only if really
+		 * needed.
+		 */
+		if (0) {
+			LOG_HEXDUMP_DBG(data, len, ppp->dev->name);
+		}
 
-	tmp = len;
+		ppp_input(ppp, data, len);
 
-	do {
-		if (ppp_input_byte(ppp, *data++) == 0) {
-			/* Ignore empty or too short frames */
-			if (ppp->pkt && net_pkt_get_len(ppp->pkt) > 3) {
-				ppp_process_msg(ppp);
-				break;
-			}
+		ret = ring_buf_get_finish(&ppp->rx_ringbuf, len);
+		if (ret < 0) {
+			LOG_DBG("Cannot flush ring buffer (%d)", ret);
+			break;
 		}
-	} while (--tmp);
-
-	ret = ring_buf_get_finish(&ppp->rx_ringbuf, len);
-	if (ret < 0) {
-		LOG_DBG("Cannot flush ring buffer (%d)", ret);
 	}
 }
 #endif /* !CONFIG_NET_TEST */
@@ -686,6 +719,9 @@ static int ppp_driver_init(struct device *dev)
 		       K_PRIO_COOP(PPP_WORKQ_PRIORITY));
 	k_thread_name_set(&ppp->cb_workq.thread, "ppp_workq");
 #endif
+#if defined(CONFIG_NET_PPP_ASYNC_UART)
+	k_sem_init(&ppp->tx_sem, 0, 1);
+#endif
 
 	ppp->pkt = NULL;
 	ppp_change_state(ppp, STATE_HDLC_FRAME_START);
@@ -764,6 +800,82 @@ static struct net_stats_ppp *ppp_get_stats(struct device *dev)
 #endif
 
 #if !defined(CONFIG_NET_TEST)
+static void ppp_rx_put(struct ppp_driver_context *context,
+		       const uint8_t *data, size_t len)
+{
+	int ret;
+
+	ret = ring_buf_put(&context->rx_ringbuf, data, len);
+	if (ret < len) {
+		LOG_ERR("Rx buffer doesn't have enough space. "
+			"Bytes pending: %zu, written: %d", len, ret);
+	}
+
+	k_work_submit_to_queue(&context->cb_workq, &context->cb_work);
+}
+
+#if defined(CONFIG_NET_PPP_ASYNC_UART)
+static int ppp_uart_rx_enable(struct ppp_driver_context *context)
+{
+	context->rx_async_idx = 0U;
+
+	return uart_rx_enable(context->dev, context->rx_async_buf[0],
+			      sizeof(context->rx_async_buf[0]),
+			      CONFIG_NET_PPP_ASYNC_UART_RX_TIMEOUT);
+}
+
+static void ppp_uart_callback(struct uart_event *evt, void *user_data)
+{
+	struct ppp_driver_context *context = user_data;
+	int ret;
+
+	switch (evt->type) {
+	case UART_TX_DONE:
+	case UART_TX_ABORTED:
+		k_sem_give(&context->tx_sem);
+		break;
+
+	case UART_RX_RDY:
+		ppp_rx_put(context, evt->data.rx.buf + evt->data.rx.offset,
+			   evt->data.rx.len);
+		break;
+
+	case UART_RX_BUF_REQUEST:
+		/* Receiving continues to the other buffer once the
+		 * current one is full.
+		 */
+		context->rx_async_idx ^= 1U;
+
+		ret = uart_rx_buf_rsp(
+			context->dev,
+			context->rx_async_buf[context->rx_async_idx],
+			sizeof(context->rx_async_buf[0]));
+		if (ret < 0) {
+			LOG_ERR("Cannot provide RX buffer (%d)", ret);
+		}
+
+		break;
+
+	case UART_RX_DISABLED:
+		/* Receiving stopped because of a line error or because no
+		 * buffer was available in time.
+		 */
+		ret = ppp_uart_rx_enable(context);
+		if (ret < 0) {
+			LOG_ERR("Cannot enable RX (%d)", ret);
+		}
+
+		break;
+
+	case UART_RX_STOPPED:
+		LOG_DBG("RX stopped (0x%x)", evt->data.rx_stop.reason);
+		break;
+
+	default:
+		break;
+	}
+}
+#else
 static void ppp_uart_flush(struct device *dev)
 {
 	uint8_t c;
@@ -777,7 +889,7 @@ static void ppp_uart_isr(void *user_data)
 {
 	struct ppp_driver_context *context = user_data;
 	struct device *uart = context->dev;
-	int rx = 0, ret;
+	int rx = 0;
 
 	/* get all of the data off UART as fast as we can */
 	while (uart_irq_update(uart) && uart_irq_rx_ready(uart)) {
@@ -786,17 +898,10 @@ static void ppp_uart_isr(void *user_data)
 			continue;
 		}
 
-		ret = ring_buf_put(&context->rx_ringbuf, context->buf, rx);
-		if (ret < rx) {
-			LOG_ERR("Rx buffer doesn't have enough space. "
-				"Bytes pending: %d, written: %d",
-				rx, ret);
-			break;
-		}
-
-		k_work_submit_to_queue(&context->cb_workq, &context->cb_work);
+		ppp_rx_put(context, context->buf, rx);
 	}
 }
+#endif /* CONFIG_NET_PPP_ASYNC_UART */
 #endif /* !CONFIG_NET_TEST */
 
 static int ppp_start(struct device *dev)
@@ -845,12 +950,21 @@ static int ppp_start(struct device *dev)
 			return -ENODEV;
 		}
 
+#if defined(CONFIG_NET_PPP_ASYNC_UART)
+		uart_callback_set(context->dev, ppp_uart_callback, context);
+
+		if (ppp_uart_rx_enable(context) < 0) {
+			LOG_ERR("Cannot enable RX on %s", dev_name);
+			return -EIO;
+		}
+#else
 		uart_irq_rx_disable(context->dev);
 		uart_irq_tx_disable(context->dev);
 		ppp_uart_flush(context->dev);
 		uart_irq_callback_user_data_set(context->dev, ppp_uart_isr,
 						context);
 		uart_irq_rx_enable(context->dev);
+#endif
 	}
 #endif /* !CONFIG_NET_TEST */
 
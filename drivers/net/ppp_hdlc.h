@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ *
+ * HDLC-like framing of PPP (RFC 1662): byte stuffing and frame check
+ * sequence. The async control character map is the default one, so all
+ * control characters are escaped.
+ */
+
+#ifndef ZEPHYR_DRIVERS_NET_PPP_HDLC_H_
+#define ZEPHYR_DRIVERS_NET_PPP_HDLC_H_
+
+#include <zephyr/types.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PPP_HDLC_FLAG 0x7e
+#define PPP_HDLC_ESCAPE 0x7d
+#define PPP_HDLC_INIT_FCS 0xffff
+/* FCS over a frame including its FCS field */
+#define PPP_HDLC_GOOD_FCS 0xf0b8
+
+/**
+ * @brief Update a frame check sequence.
+ *
+ * The result is the same as with crc16_ccitt().
+ *
+ * @param fcs FCS of the previous data, PPP_HDLC_INIT_FCS at frame start.
+ * @param data Data to add.
+ * @param len Length of the data.
+ *
+ * @return Updated FCS.
+ */
+uint16_t ppp_hdlc_fcs(uint16_t fcs, const uint8_t *data, size_t len);
+
+/**
+ * @brief Escape frame data.
+ *
+ * Escapes as much of the data as fits in the destination buffer, without
+ * splitting an escape sequence.
+ *
+ * @param src Data to escape.
+ * @param len Length of the data.
+ * @param dst Destination buffer.
+ * @param dst_len Space in the destination buffer, set to the number of
+ * bytes written.
+ *
+ * @return Number of bytes of src escaped.
+ */
+size_t ppp_hdlc_escape(const uint8_t *src, size_t len, uint8_t *dst,
+		       size_t *dst_len);
+
+/**
+ * @brief Unescape frame data up to the next flag sequence.
+ *
+ * @param src Received data.
+ * @param len Length of the data.
+ * @param dst Destination buffer of at least len bytes, can be src.
+ * @param dst_len Set to the number of bytes written.
+ * @param escaped True if the previous data ended with an escape, updated
+ * for the next call.
+ *
+ * @return Number of bytes of src unescaped, less than len if a flag
+ * sequence follows them.
+ */
+size_t ppp_hdlc_unescape(const uint8_t *src, size_t len, uint8_t *dst,
+			 size_t *dst_len, bool *escaped);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ZEPHYR_DRIVERS_NET_PPP_HDLC_H_ */
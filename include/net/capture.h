@@ -0,0 +1,218 @@
+/** @file
+ * @brief Network packet capture API
+ *
+ * Capture the IP packets sent and received by the network stack to a
+ * ring buffer, and export them in the pcapng format.
+ */
+
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_INCLUDE_NET_CAPTURE_H_
+#define ZEPHYR_INCLUDE_NET_CAPTURE_H_
+
+/**
+ * @brief Network packet capture
+ * @defgroup net_capture Network packet capture
+ * @ingroup networking
+ * @{
+ */
+
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <net/net_ip.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct net_if;
+struct net_pkt;
+
+/** Direction of a captured packet */
+enum net_capture_dir {
+	/** Packet received */
+	NET_CAPTURE_IN = 1,
+	/** Packet sent */
+	NET_CAPTURE_OUT = 2,
+};
+
+/** @cond INTERNAL_HIDDEN */
+
+#if defined(CONFIG_NET_CAPTURE_FILTER_MAX_INSNS)
+#define NET_CAPTURE_FILTER_MAX_INSNS CONFIG_NET_CAPTURE_FILTER_MAX_INSNS
+#else
+#define NET_CAPTURE_FILTER_MAX_INSNS 1
+#endif
+
+/* Instruction of a compiled filter, the program is in postfix order */
+struct net_capture_insn {
+	uint8_t op;
+	/* NET_CAPTURE_SRC and/or NET_CAPTURE_DST for ports and hosts */
+	uint8_t flags;
+	/* Port, protocol or direction */
+	uint16_t value;
+	union {
+		struct in_addr in;
+#if defined(CONFIG_NET_IPV6)
+		struct in6_addr in6;
+#endif
+	} addr;
+};
+
+/** @endcond */
+
+/**
+ * Compiled capture filter.
+ */
+struct net_capture_filter {
+	/** @cond INTERNAL_HIDDEN */
+	struct net_capture_insn insns[NET_CAPTURE_FILTER_MAX_INSNS];
+	uint8_t len;
+	/** @endcond */
+};
+
+/** Capture statistics */
+struct net_capture_stats {
+	/** Packets stored in the ring buffer */
+	uint32_t captured;
+	/** Packets not matching the filter */
+	uint32_t filtered;
+	/** Packets dropped because the ring buffer was full */
+	uint32_t dropped;
+};
+
+/**
+ * @typedef net_capture_write_cb_t
+ * @brief Callback writing the exported pcapng data.
+ *
+ * Every call passes one whole pcapng block.
+ *
+ * @param data Data to write.
+ * @param len Length of the data.
+ * @param user_data User data given to net_capture_export().
+ *
+ * @return 0 if ok, <0 to stop the export.
+ */
+typedef int (*net_capture_write_cb_t)(const void *data, size_t len,
+				      void *user_data);
+
+/**
+ * @brief Compile a filter expression.
+ *
+ * The expression combines the following primitives with "and" ("&&"),
+ * "or" ("||"), "not" ("!") and parentheses:
+ * - "ip", "ip6": IPv4 or IPv6 packets,
+ * - "tcp", "udp", "icmp", "icmp6": transport protocols,
+ * - "[src|dst] port <port>": TCP or UDP port,
+ * - "[src|dst] host <address>": IPv4 or IPv6 address,
+ * - "in", "out": received or sent packets.
+ *
+ * An empty expression matches every packet.
+ *
+ * @param filter Filter to compile to.
+ * @param expr Filter expression.
+ *
+ * @return 0 if ok, -EINVAL if the expression is not valid, -ENOMEM if it
+ * needs more than CONFIG_NET_CAPTURE_FILTER_MAX_INSNS instructions.
+ */
+int net_capture_filter_compile(struct net_capture_filter *filter,
+			       const char *expr);
+
+/**
+ * @brief Run a filter on a packet.
+ *
+ * @param filter Compiled filter.
+ * @param pkt IP packet, its data starting with the IP header.
+ * @param dir Direction of the packet.
+ *
+ * @return True if the packet matches the filter.
+ */
+bool net_capture_filter_match(const struct net_capture_filter *filter,
+			      struct net_pkt *pkt, enum net_capture_dir dir);
+
+/**
+ * @brief Start capturing packets.
+ *
+ * Packets are captured until net_capture_stop() is called, or dropped
+ * when the ring buffer is full. Only the first CONFIG_NET_CAPTURE_SNAPLEN
+ * bytes of every packet are stored. The statistics are reset. Waits for
+ * the packets being stored with the previous filter, so must not be
+ * called from an ISR.
+ *
+ * @param iface Network interface to capture, NULL for all of them.
+ * @param expr Filter expression, see net_capture_filter_compile(), NULL
+ * to capture every packet.
+ *
+ * @return 0 if ok, <0 if the filter expression cannot be compiled.
+ */
+int net_capture_start(struct net_if *iface, const char *expr);
+
+/**
+ * @brief Stop capturing packets. The packets captured so far can still be
+ * exported.
+ */
+void net_capture_stop(void);
+
+/**
+ * @brief Check if packets are being captured.
+ *
+ * @return True if the capture is running.
+ */
+bool net_capture_is_active(void);
+
+/**
+ * @brief Get the capture statistics.
+ *
+ * @param stats Statistics to fill.
+ */
+void net_capture_get_stats(struct net_capture_stats *stats);
+
+/**
+ * @brief Export the captured packets in the pcapng format, removing them
+ * from the ring buffer.
+ *
+ * @param cb Callback writing the pcapng blocks.
+ * @param user_data User data passed to the callback.
+ * @param header Write the section header block and the interface
+ * description blocks before the packets, for the start of a file or
+ * stream.
+ *
+ * @return Number of packets exported, or <0 returned by the callback.
+ */
+int net_capture_export(net_capture_write_cb_t cb, void *user_data,
+		       bool header);
+
+/**
+ * @brief Export the captured packets to a connected socket.
+ *
+ * With a UDP socket every pcapng block is sent in its own datagram.
+ *
+ * @param sock Connected TCP or UDP socket.
+ * @param header Write the pcapng header first.
+ *
+ * @return Number of packets exported, or <0 if sending failed.
+ */
+int net_capture_export_socket(int sock, bool header);
+
+/**
+ * @brief Export the captured packets to a new pcapng file.
+ *
+ * @param path Path of the file, which is overwritten.
+ *
+ * @return Number of packets exported, or <0 if writing failed.
+ */
+int net_capture_export_file(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* ZEPHYR_INCLUDE_NET_CAPTURE_H_ */
@@ -191,6 +191,46 @@ struct coap_resource {
 	int age;
 };
 
+/**
+ * @brief Slot of a CoAP resource index.
+ */
+struct coap_resource_slot {
+	uint32_t hash;
+	/** Index of the resource in the array plus one, 0 if free */
+	uint16_t resource;
+};
+
+/**
+ * @brief Hash index over the paths of an array of CoAP resources.
+ *
+ * Lets coap_handle_request_index() find the resource of a request with
+ * one pass over its Uri-Path options instead of comparing them with the
+ * path of every resource. Define it with COAP_RESOURCE_INDEX_DEFINE() and
+ * fill it with coap_resource_index_build().
+ */
+struct coap_resource_index {
+	struct coap_resource *resources;
+	struct coap_resource_slot *slots;
+	uint16_t num_slots;
+};
+
+/**
+ * @brief Define a CoAP resource index.
+ *
+ * @param _name Name of the index.
+ * @param _resources Array of resources, terminated by an entry without
+ * path.
+ * @param _num_slots Number of slots, must be more than the number of
+ * resources. Twice that number keeps the lookups short.
+ */
+#define COAP_RESOURCE_INDEX_DEFINE(_name, _resources, _num_slots)	\
+	static struct coap_resource_slot _name##_slots[_num_slots];	\
+	static struct coap_resource_index _name = {			\
+		.resources = _resources,				\
+		.slots = _name##_slots,					\
+		.num_slots = _num_slots,				\
+	}
+
 /**
  * @brief Represents a remote device that is observing a local resource.
  */
@@ -467,6 +507,40 @@ int coap_handle_request(struct coap_packet *cpkt,
 			uint8_t opt_num,
 			struct sockaddr *addr, socklen_t addr_len);
 
+/**
+ * @brief Build the index of a resource array.
+ *
+ * Must be called again when the paths of the resources change. When
+ * several resources have the same path, the first one is indexed, as
+ * coap_handle_request() would pick it.
+ *
+ * @param index Index defined with COAP_RESOURCE_INDEX_DEFINE()
+ *
+ * @return 0 in case of success or -ENOMEM if the index has too few slots.
+ */
+int coap_resource_index_build(struct coap_resource_index *index);
+
+/**
+ * @brief When a request is received, call the appropriate methods of
+ * the resource found in the index.
+ *
+ * Works like coap_handle_request(), looking the resource up in the index.
+ *
+ * @param cpkt Packet received
+ * @param index Index built with coap_resource_index_build()
+ * @param options Parsed options from coap_packet_parse()
+ * @param opt_num Number of options
+ * @param addr Peer address
+ * @param addr_len Peer address length
+ *
+ * @return 0 in case of success or negative in case of error.
+ */
+int coap_handle_request_index(struct coap_packet *cpkt,
+			      struct coap_resource_index *index,
+			      struct coap_option *options,
+			      uint8_t opt_num,
+			      struct sockaddr *addr, socklen_t addr_len);
+
 /**
  * Represents the size of each block that will be transferred using
  * block-wise transfers [RFC7959]:
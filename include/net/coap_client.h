@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ *
+ * @brief CoAP client engine
+ */
+
+#ifndef ZEPHYR_INCLUDE_NET_COAP_CLIENT_H_
+#define ZEPHYR_INCLUDE_NET_COAP_CLIENT_H_
+
+/**
+ * @brief CoAP client engine
+ * @defgroup coap_client CoAP client engine
+ * @ingroup networking
+ * @{
+ */
+
+#include <zephyr/types.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <kernel.h>
+#include <net/coap.h>
+#include <net/socket.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @typedef coap_client_response_cb_t
+ * @brief Callback delivering the response of a request.
+ *
+ * Called once per block of a block-wise response, in order, and once for
+ * a response which is not block-wise. The payload is only valid during
+ * the call.
+ *
+ * @param result CoAP response code, or a negative error code if the
+ * request failed: -ETIMEDOUT when the server did not answer,
+ * -ECONNRESET when it reset the request, -ECANCELED when the request was
+ * cancelled, -EIO when the response was not valid.
+ * @param offset Offset of the payload in the resource.
+ * @param payload Payload, NULL if there is none.
+ * @param len Length of the payload.
+ * @param last True for the last call made for the request.
+ * @param user_data User data of the request.
+ */
+typedef void (*coap_client_response_cb_t)(int result, size_t offset,
+					  const uint8_t *payload, size_t len,
+					  bool last, void *user_data);
+
+/**
+ * @brief CoAP client request.
+ */
+struct coap_client_request {
+	/** Request method, see enum coap_method */
+	uint8_t method;
+	/** Send the request as a confirmable message */
+	bool confirmable;
+	/** Resource path, segments separated by '/'. It is encoded again
+	 * for each retransmission and block, so it must remain valid until
+	 * the last callback.
+	 */
+	const char *path;
+	/** Value of the Content-Format option, or -1 to omit it */
+	int fmt;
+	/** Payload, must remain valid until the last callback */
+	const uint8_t *payload;
+	/** Length of the payload, sent block-wise when larger than
+	 * CONFIG_COAP_CLIENT_BLOCK_SIZE
+	 */
+	size_t len;
+	/** Callback delivering the response */
+	coap_client_response_cb_t cb;
+	/** User data passed to the callback */
+	void *user_data;
+};
+
+/** @cond INTERNAL_HIDDEN */
+
+enum coap_client_state {
+	COAP_CLIENT_FREE,
+	COAP_CLIENT_QUEUED,
+	/* Waiting for an ACK or a piggybacked response */
+	COAP_CLIENT_WAIT_ACK,
+	/* Waiting for a separate response, or for the response of a NON */
+	COAP_CLIENT_WAIT_RESPONSE,
+};
+
+struct coap_client_exchange {
+	struct coap_client_request req;
+	/* Time of the first transmission of the message */
+	int64_t t0;
+	/* Time of the next retransmission or of the timeout */
+	int64_t deadline;
+	uint32_t seq;
+	uint32_t timeout;
+	/* Retransmission timeout the exchange started with */
+	uint32_t rto;
+	/* Offset and length of the block being sent */
+	size_t block1_offset;
+	size_t block1_len;
+	/* Offset of the next block to receive */
+	size_t block2_offset;
+	uint16_t id;
+	uint8_t token[8];
+	uint8_t state;
+	uint8_t retries;
+	uint8_t block1_szx;
+	uint8_t block2_szx;
+	bool block2;
+};
+
+/** @endcond */
+
+/**
+ * @brief CoAP client.
+ *
+ * Sends requests to one server and runs their exchanges: confirmable
+ * messages are retransmitted with an exponential backoff, at most
+ * CONFIG_COAP_CLIENT_NSTART requests are outstanding at a time and the
+ * others wait in order, and payloads larger than a block are sent and
+ * received block-wise.
+ *
+ * The client does not own a thread. The application calls
+ * coap_client_process() when the socket is readable or when the timeout
+ * returned by the previous call has expired, or coap_client_wait().
+ */
+struct coap_client {
+	/** @cond INTERNAL_HIDDEN */
+	struct k_mutex lock;
+	struct sockaddr addr;
+	socklen_t addrlen;
+	int sock;
+	uint32_t seq;
+	struct coap_client_exchange exchanges[CONFIG_COAP_CLIENT_MAX_REQUESTS];
+	uint8_t tx_buf[CONFIG_COAP_CLIENT_MESSAGE_SIZE];
+	uint8_t rx_buf[CONFIG_COAP_CLIENT_MESSAGE_SIZE];
+#if defined(CONFIG_COAP_CLIENT_COCOA)
+	/* Retransmission timeout estimates of CoCoA, in milliseconds */
+	uint32_t rto;
+	uint32_t strong_srtt;
+	uint32_t strong_rttvar;
+	uint32_t weak_srtt;
+	uint32_t weak_rttvar;
+#endif
+	/** @endcond */
+};
+
+/**
+ * @brief Initialize a CoAP client.
+ *
+ * @param client Client to initialize.
+ * @param sock UDP socket, which the application keeps open while the
+ * client is used.
+ * @param addr Address of the server.
+ * @param addrlen Length of the address.
+ *
+ * @return 0 in case of success or negative in case of error.
+ */
+int coap_client_init(struct coap_client *client, int sock,
+		     const struct sockaddr *addr, socklen_t addrlen);
+
+/**
+ * @brief Send a request.
+ *
+ * The request is sent at once if fewer than CONFIG_COAP_CLIENT_NSTART
+ * requests are outstanding, and queued otherwise. Its response is
+ * delivered to its callback by coap_client_process().
+ *
+ * @param client Client.
+ * @param req Request, copied by the client. The path and the payload it
+ * points to are not copied.
+ *
+ * @return 0 in case of success, -ENOMEM if
+ * CONFIG_COAP_CLIENT_MAX_REQUESTS requests are pending, or another
+ * negative error code.
+ */
+int coap_client_req(struct coap_client *client,
+		    const struct coap_client_request *req);
+
+/**
+ * @brief Process the received messages and the timeouts of a client.
+ *
+ * Reads the messages waiting on the socket without blocking, calls the
+ * callbacks of the responses, retransmits the messages which have not
+ * been acknowledged in time and starts the queued requests.
+ *
+ * @param client Client.
+ *
+ * @return Time in milliseconds until the next retransmission or timeout,
+ * or SYS_FOREVER_MS if no request is pending.
+ */
+int32_t coap_client_process(struct coap_client *client);
+
+/**
+ * @brief Run a client until its requests are done.
+ *
+ * Polls the socket and calls coap_client_process() until no request is
+ * pending.
+ *
+ * @param client Client.
+ * @param timeout Maximum time to wait in milliseconds, or SYS_FOREVER_MS.
+ *
+ * @return 0 once no request is pending, -EAGAIN on timeout, or another
+ * negative error code.
+ */
+int coap_client_wait(struct coap_client *client, int32_t timeout);
+
+/**
+ * @brief Cancel the pending requests of a client.
+ *
+ * Their callbacks are called with -ECANCELED.
+ *
+ * @param client Client.
+ */
+void coap_client_cancel(struct coap_client *client);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* ZEPHYR_INCLUDE_NET_COAP_CLIENT_H_ */
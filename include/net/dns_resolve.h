@@ -399,6 +399,86 @@ static inline int dns_cancel_addr_info(uint16_t dns_id)
 	return dns_resolve_cancel(dns_resolve_get_default(), dns_id);
 }
 
+#if defined(CONFIG_DNS_RESOLVER_CACHE) || defined(__DOXYGEN__)
+/**
+ * Cached answer of a DNS query.
+ */
+struct dns_cache_entry {
+	/** Queried name */
+	char name[CONFIG_DNS_RESOLVER_CACHE_NAME_LEN + 1];
+
+	/** Resolved addresses */
+	struct sockaddr addr[CONFIG_DNS_RESOLVER_CACHE_MAX_ADDRS];
+
+	/** Uptime in ms when the entry expires */
+	int64_t expiry;
+
+	/** Query type, A or AAAA */
+	enum dns_query_type type;
+
+	/** Number of addresses, zero for a negative answer */
+	uint8_t count;
+
+	/** Response code of the answer, non zero for a name error */
+	uint8_t rcode;
+
+	/** Is the entry in use */
+	bool is_used;
+};
+
+/**
+ * DNS answer cache statistics.
+ */
+struct dns_cache_stats {
+	/** Queries answered from a positive entry */
+	uint32_t hits;
+
+	/** Queries answered from a negative entry */
+	uint32_t negative_hits;
+
+	/** Queries not found in the cache */
+	uint32_t misses;
+
+	/** Entries added */
+	uint32_t added;
+
+	/** Entries replaced before they expired */
+	uint32_t evicted;
+};
+
+/**
+ * @typedef dns_cache_cb_t
+ * @brief Callback used while iterating over the DNS answer cache.
+ *
+ * @param entry Cached answer, valid only during the callback.
+ * @param user_data A valid pointer to user data or NULL
+ */
+typedef void (*dns_cache_cb_t)(const struct dns_cache_entry *entry,
+			       void *user_data);
+
+/**
+ * @brief Go through the entries of the DNS answer cache.
+ *
+ * @details Expired entries are released and not passed to the callback.
+ *
+ * @param cb User supplied callback function to call.
+ * @param user_data User specified data.
+ */
+void dns_cache_foreach(dns_cache_cb_t cb, void *user_data);
+
+/**
+ * @brief Remove all the entries of the DNS answer cache.
+ */
+void dns_cache_flush(void);
+
+/**
+ * @brief Get the DNS answer cache statistics.
+ *
+ * @param stats Where to copy the statistics.
+ */
+void dns_cache_get_stats(struct dns_cache_stats *stats);
+#endif /* CONFIG_DNS_RESOLVER_CACHE */
+
 /**
  * @}
  */
@@ -139,6 +139,7 @@ enum ethernet_config_type {
 	ETHERNET_CONFIG_TYPE_PROMISC_MODE,
 	ETHERNET_CONFIG_TYPE_PRIORITY_QUEUES_NUM,
 	ETHERNET_CONFIG_TYPE_FILTER,
+	ETHERNET_CONFIG_TYPE_TX_QUEUES_NUM,
 };
 
 enum ethernet_qav_param_type {
@@ -207,6 +208,8 @@ struct ethernet_config {
 
 		int priority_queues_num;
 
+		int tx_queues_num;
+
 		struct ethernet_filter filter;
 	};
 };
@@ -263,6 +266,14 @@ struct ethernet_api {
 
 	/** Send a network packet */
 	int (*send)(struct device *dev, struct net_pkt *pkt);
+
+	/** Send a network packet using the given TX queue. Drivers having
+	 * several TX queues can set this and report the number of queues
+	 * for ETHERNET_CONFIG_TYPE_TX_QUEUES_NUM. The queue is then selected
+	 * per flow, so that the packets of a flow are sent in order.
+	 */
+	int (*send_queue)(struct device *dev, uint8_t queue,
+			  struct net_pkt *pkt);
 };
 
 /* Make sure that the network interface API is properly setup inside
@@ -375,6 +386,9 @@ struct ethernet_context {
 	int8_t vlan_enabled;
 #endif
 
+	/** Number of TX queues used with the send_queue() API */
+	uint8_t tx_queues;
+
 	/** Is this context already initialized */
 	bool is_init;
 };
@@ -0,0 +1,273 @@
+/** @file
+ * @brief HTTP client session API
+ *
+ * An API for applications to do HTTP/1.1 requests on persistent
+ * connections to a host
+ */
+
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_INCLUDE_NET_HTTP_CLIENT_SESSION_H_
+#define ZEPHYR_INCLUDE_NET_HTTP_CLIENT_SESSION_H_
+
+/**
+ * @brief HTTP client session API
+ * @defgroup http_client_session HTTP client session API
+ * @ingroup networking
+ * @{
+ */
+
+#include <zephyr/types.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <net/socket.h>
+#include <net/http_parser.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct http_session;
+struct http_session_req;
+struct stream_flash_ctx;
+
+/** Range end of a request for everything from the range start */
+#define HTTP_SESSION_RANGE_END ((size_t)-1)
+
+/**
+ * @typedef http_session_body_cb_t
+ * @brief Callback producing the body of a request.
+ *
+ * @param req Request.
+ * @param buf Buffer to fill with the next part of the body.
+ * @param len Size of the buffer.
+ *
+ * @return Number of bytes written to buf, 0 at the end of the body, or a
+ * negative error code to abort the request.
+ */
+typedef int (*http_session_body_cb_t)(struct http_session_req *req,
+				      uint8_t *buf, size_t len);
+
+/**
+ * @typedef http_session_data_cb_t
+ * @brief Callback receiving a fragment of the body of a response.
+ *
+ * The fragment points into the receive buffer of the session and is only
+ * valid during the call.
+ *
+ * @param req Request the response is for.
+ * @param data Fragment of the body.
+ * @param len Length of the fragment.
+ *
+ * @return 0 to continue, or a negative error code to abort the request,
+ * which closes its connection.
+ */
+typedef int (*http_session_data_cb_t)(struct http_session_req *req,
+				      const uint8_t *data, size_t len);
+
+/**
+ * @typedef http_session_done_cb_t
+ * @brief Callback called when a request is complete.
+ *
+ * @param req Request.
+ * @param result HTTP status code of the response, or a negative error
+ * code if no complete response was received.
+ */
+typedef void (*http_session_done_cb_t)(struct http_session_req *req,
+				       int result);
+
+/**
+ * @brief Request of a session.
+ *
+ * The request must remain valid until its done callback is called.
+ */
+struct http_session_req {
+	/* User should fill in following parameters */
+
+	/** The HTTP method: GET, HEAD, POST, ... */
+	enum http_method method;
+
+	/** The URL for this request, for example: /index.html */
+	const char *url;
+
+	/** A NULL terminated list of additional header fields, each ending
+	 * with CRLF, sent without being copied. May be NULL.
+	 */
+	const char **headers;
+
+	/** The value of the Content-Type header field, may be NULL */
+	const char *content_type;
+
+	/** First byte of the range to request, used if range_end is not 0 */
+	size_t range_start;
+
+	/** Last byte of the range to request, HTTP_SESSION_RANGE_END for the
+	 * rest of the resource, or 0 to request the whole resource.
+	 */
+	size_t range_end;
+
+	/** Body of the request, sent without being copied. May be NULL. */
+	const void *payload;
+
+	/** Length of the body. If body_cb is set and this is 0 the body is
+	 * sent with the chunked transfer coding.
+	 */
+	size_t payload_len;
+
+	/** Callback producing the body, used instead of payload if set */
+	http_session_body_cb_t body_cb;
+
+	/** Callback receiving the body of the response, may be NULL */
+	http_session_data_cb_t data_cb;
+
+	/** Stream flash context the body of a successful response is
+	 * written to, may be NULL. It is flushed when the response is
+	 * complete. Needs CONFIG_STREAM_FLASH.
+	 */
+	struct stream_flash_ctx *flash;
+
+	/** Callback called when the request is complete */
+	http_session_done_cb_t done_cb;
+
+	/** User data */
+	void *user_data;
+
+	/* Filled in by the session */
+
+	/** HTTP status code of the response */
+	uint16_t status;
+
+	/** Value of the Content-Length field of the response, 0 if absent */
+	size_t content_length;
+
+	/** Number of body bytes received */
+	size_t received;
+
+	/** @cond INTERNAL_HIDDEN */
+	bool started;
+	bool retried;
+	/** @endcond */
+};
+
+/** @cond INTERNAL_HIDDEN */
+
+struct http_session_conn {
+	struct http_session *session;
+	struct http_parser parser;
+	int64_t last_activity;
+	int sock;
+	/* Requests sent on the connection and waiting for their response,
+	 * in the order they were sent.
+	 */
+	struct http_session_req *pending[CONFIG_HTTP_CLIENT_SESSION_PIPELINE];
+	uint8_t head;
+	uint8_t count;
+	/* The connection is closed once the current response is complete */
+	bool close;
+	int error;
+};
+
+/** @endcond */
+
+/**
+ * @brief HTTP client session.
+ *
+ * A session keeps a pool of up to CONFIG_HTTP_CLIENT_SESSION_MAX_CONNS
+ * persistent connections to one host. GET and HEAD requests are
+ * pipelined, up to CONFIG_HTTP_CLIENT_SESSION_PIPELINE on a connection,
+ * other requests are sent on an idle connection. The session does not own
+ * a thread, the application calls http_session_process() or
+ * http_session_wait() to receive the responses.
+ */
+struct http_session {
+	/** @cond INTERNAL_HIDDEN */
+	struct sockaddr addr;
+	socklen_t addrlen;
+	const char *host;
+	struct http_session_conn conns[CONFIG_HTTP_CLIENT_SESSION_MAX_CONNS];
+	/* Shared by the connections, which are served one at a time */
+	uint8_t rx_buf[CONFIG_HTTP_CLIENT_SESSION_BUF_SIZE];
+	uint8_t tx_buf[CONFIG_HTTP_CLIENT_SESSION_BUF_SIZE];
+	/** @endcond */
+};
+
+/**
+ * @brief Initialize a session. No connection is opened until a request
+ * is sent.
+ *
+ * @param session Session to initialize.
+ * @param addr Address of the server.
+ * @param addrlen Length of the address.
+ * @param host Value of the Host header field, must remain valid while the
+ * session is used.
+ *
+ * @return 0 in case of success or negative in case of error.
+ */
+int http_session_init(struct http_session *session,
+		      const struct sockaddr *addr, socklen_t addrlen,
+		      const char *host);
+
+/**
+ * @brief Send a request.
+ *
+ * The request line and the header fields are sent with the body, or its
+ * first part, in a single call. The response is delivered to the
+ * callbacks of the request from http_session_process().
+ *
+ * @param session Session.
+ * @param req Request.
+ *
+ * @return 0 in case of success, -EAGAIN if no connection can take the
+ * request until responses are received, or another negative error code.
+ */
+int http_session_send(struct http_session *session,
+		      struct http_session_req *req);
+
+/**
+ * @brief Wait for and process the responses of a session.
+ *
+ * Also closes the connections which have been idle for
+ * CONFIG_HTTP_CLIENT_SESSION_IDLE_TIMEOUT milliseconds.
+ *
+ * @param session Session.
+ * @param timeout Maximum time to wait for data, in milliseconds, or
+ * SYS_FOREVER_MS.
+ *
+ * @return Number of requests still waiting for their response, or
+ * negative in case of error.
+ */
+int http_session_process(struct http_session *session, int32_t timeout);
+
+/**
+ * @brief Process the responses of a session until every request sent is
+ * complete.
+ *
+ * @param session Session.
+ * @param timeout Maximum time to wait, in milliseconds, or SYS_FOREVER_MS.
+ *
+ * @return 0 in case of success, -ETIMEDOUT if requests are still waiting
+ * for their response, or another negative error code.
+ */
+int http_session_wait(struct http_session *session, int32_t timeout);
+
+/**
+ * @brief Close all the connections of a session. The requests waiting for
+ * their response complete with -ECONNABORTED.
+ *
+ * @param session Session.
+ */
+void http_session_close(struct http_session *session);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* ZEPHYR_INCLUDE_NET_HTTP_CLIENT_SESSION_H_ */
@@ -0,0 +1,306 @@
+/** @file
+ * @brief HTTP server API
+ *
+ * An API for applications to serve HTTP/1.1 requests
+ */
+
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_INCLUDE_NET_HTTP_SERVER_H_
+#define ZEPHYR_INCLUDE_NET_HTTP_SERVER_H_
+
+/**
+ * @brief HTTP server API
+ * @defgroup http_server HTTP server API
+ * @ingroup networking
+ * @{
+ */
+
+#include <zephyr/types.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <net/socket.h>
+#include <net/http_parser.h>
+
+#if defined(CONFIG_FILE_SYSTEM)
+#include <fs/fs.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct http_server;
+struct http_server_conn;
+
+/**
+ * @brief Request passed to the handler of a dynamic route.
+ */
+struct http_server_request {
+	/** Request method */
+	enum http_method method;
+	/** Request target, NUL terminated, including the query string */
+	const char *url;
+	/** Length of the request target */
+	size_t url_len;
+	/** Request body, up to CONFIG_HTTP_SERVER_MAX_BODY_SIZE bytes */
+	const uint8_t *body;
+	/** Length of the request body */
+	size_t body_len;
+};
+
+/**
+ * @typedef http_server_handler_t
+ * @brief Handler of a dynamic route.
+ *
+ * The handler sends the response with http_server_respond() before
+ * returning. The request is only valid during the call.
+ *
+ * @param conn Connection the request was received on.
+ * @param req Request.
+ * @param user_data User data given to http_server_init().
+ *
+ * @return 0 if the response was sent, or a negative error code, in which
+ * case the server answers with 500 Internal Server Error if nothing was
+ * sent yet.
+ */
+typedef int (*http_server_handler_t)(struct http_server_conn *conn,
+				     const struct http_server_request *req,
+				     void *user_data);
+
+/** Kind of content served by a route */
+enum http_server_route_type {
+	/** Buffer in memory, sent without being copied */
+	HTTP_SERVER_ROUTE_BUF,
+	/** File read through the file system API */
+	HTTP_SERVER_ROUTE_FILE,
+	/** Range of a flash area */
+	HTTP_SERVER_ROUTE_FLASH,
+	/** Response built by a handler */
+	HTTP_SERVER_ROUTE_HANDLER,
+};
+
+/**
+ * @brief Route of the server.
+ *
+ * Routes are kept in a constant array, which is usually built at compile
+ * time with the HTTP_SERVER_ROUTE_* macros. The path of a route is
+ * matched exactly against the request target, without its query string.
+ */
+struct http_server_route {
+	/** Path of the route, for example "/index.html" */
+	const char *path;
+	/** Content-Type of the response */
+	const char *content_type;
+	/** Methods accepted, as BIT64(HTTP_GET) | ... Routes serving
+	 * content accept GET and HEAD.
+	 */
+	uint64_t methods;
+	/** Kind of content */
+	enum http_server_route_type type;
+	union {
+		/** HTTP_SERVER_ROUTE_BUF content */
+		struct {
+			const void *data;
+			size_t len;
+		} buf;
+		/** HTTP_SERVER_ROUTE_FILE path of the file */
+		const char *file;
+		/** HTTP_SERVER_ROUTE_FLASH content */
+		struct {
+			uint8_t id;
+			off_t offset;
+			size_t len;
+		} flash;
+		/** HTTP_SERVER_ROUTE_HANDLER handler */
+		http_server_handler_t handler;
+	};
+};
+
+/** Route serving a buffer */
+#define HTTP_SERVER_ROUTE_BUF(_path, _type, _data, _len)		\
+	{								\
+		.path = (_path),					\
+		.content_type = (_type),				\
+		.methods = BIT64(HTTP_GET) | BIT64(HTTP_HEAD),		\
+		.type = HTTP_SERVER_ROUTE_BUF,				\
+		.buf = { .data = (_data), .len = (_len) },		\
+	}
+
+/** Route serving a file of a mounted file system */
+#define HTTP_SERVER_ROUTE_FILE(_path, _type, _file)			\
+	{								\
+		.path = (_path),					\
+		.content_type = (_type),				\
+		.methods = BIT64(HTTP_GET) | BIT64(HTTP_HEAD),		\
+		.type = HTTP_SERVER_ROUTE_FILE,				\
+		.file = (_file),					\
+	}
+
+/** Route serving _len bytes at _offset of flash area _id */
+#define HTTP_SERVER_ROUTE_FLASH(_path, _type, _id, _offset, _len)	\
+	{								\
+		.path = (_path),					\
+		.content_type = (_type),				\
+		.methods = BIT64(HTTP_GET) | BIT64(HTTP_HEAD),		\
+		.type = HTTP_SERVER_ROUTE_FLASH,			\
+		.flash = { .id = (_id), .offset = (_offset),		\
+			   .len = (_len) },				\
+	}
+
+/** Route answered by a handler for the given methods */
+#define HTTP_SERVER_ROUTE_HANDLER(_path, _methods, _handler)		\
+	{								\
+		.path = (_path),					\
+		.methods = (_methods),					\
+		.type = HTTP_SERVER_ROUTE_HANDLER,			\
+		.handler = (_handler),					\
+	}
+
+/** @cond INTERNAL_HIDDEN */
+
+struct flash_area;
+
+struct http_server_conn {
+	struct http_server *server;
+	struct http_parser parser;
+	int64_t last_activity;
+	size_t url_len;
+	size_t body_len;
+	int sock;
+	/* Status to answer with instead of dispatching, 0 if none */
+	uint16_t error;
+	bool responded;
+	bool close;
+	char url[CONFIG_HTTP_SERVER_MAX_URL_LENGTH + 1];
+	uint8_t body[CONFIG_HTTP_SERVER_MAX_BODY_SIZE];
+
+	/* Response being sent, resumed from the poll loop */
+	struct msghdr tx_msg;
+	struct iovec tx_iov[2];
+	/* Content left to read into tx_buf once tx_msg is sent */
+	size_t tx_left;
+	int (*tx_read)(struct http_server_conn *conn, void *dst, size_t len);
+	void (*tx_done)(struct http_server_conn *conn);
+	/* Time at which the send is retried, 0 to wait for POLLOUT */
+	int64_t tx_retry;
+	/* Time at which the connection is closed if no progress is made */
+	int64_t tx_deadline;
+	union {
+#if defined(CONFIG_FILE_SYSTEM)
+		struct fs_file_t file;
+#endif
+		struct {
+			const struct flash_area *fa;
+			off_t offset;
+		} flash;
+	} src;
+	uint8_t tx_buf[CONFIG_HTTP_SERVER_BUF_SIZE];
+};
+
+/** @endcond */
+
+/**
+ * @brief HTTP server.
+ *
+ * Serves up to CONFIG_HTTP_SERVER_MAX_CLIENTS persistent connections from
+ * a single thread. Requests pipelined on a connection are answered in
+ * order. Responses are sent without blocking: what the socket does not
+ * accept is sent later from http_server_process(), so a client which
+ * does not read its responses does not delay the others. The server does
+ * not own a thread, the application calls http_server_process() or
+ * http_server_run().
+ */
+struct http_server {
+	/** @cond INTERNAL_HIDDEN */
+	const struct http_server_route *routes;
+	size_t num_routes;
+	void *user_data;
+	int sock;
+	struct http_server_conn conns[CONFIG_HTTP_SERVER_MAX_CLIENTS];
+	struct zsock_pollfd fds[CONFIG_HTTP_SERVER_MAX_CLIENTS + 1];
+	/* Shared by the connections, which are read one at a time */
+	uint8_t rx_buf[CONFIG_HTTP_SERVER_BUF_SIZE];
+	/** @endcond */
+};
+
+/**
+ * @brief Initialize a server and start listening.
+ *
+ * @param server Server to initialize.
+ * @param addr Address to listen on.
+ * @param addrlen Length of the address.
+ * @param routes Routes of the server, must remain valid while it runs.
+ * @param num_routes Number of routes.
+ * @param user_data User data passed to the route handlers.
+ *
+ * @return 0 in case of success or negative in case of error.
+ */
+int http_server_init(struct http_server *server, const struct sockaddr *addr,
+		     socklen_t addrlen, const struct http_server_route *routes,
+		     size_t num_routes, void *user_data);
+
+/**
+ * @brief Wait for and process the activity of a server.
+ *
+ * Accepts the new connections, reads and answers the requests received
+ * on the open connections, and closes the connections which have been
+ * idle for CONFIG_HTTP_SERVER_IDLE_TIMEOUT milliseconds.
+ *
+ * @param server Server.
+ * @param timeout Maximum time to wait for activity, in milliseconds, or
+ * SYS_FOREVER_MS.
+ *
+ * @return 0 in case of success or negative in case of error.
+ */
+int http_server_process(struct http_server *server, int32_t timeout);
+
+/**
+ * @brief Run a server until an error occurs.
+ *
+ * @param server Server.
+ *
+ * @return Negative error code.
+ */
+int http_server_run(struct http_server *server);
+
+/**
+ * @brief Close the listening socket and all the connections of a server.
+ *
+ * @param server Server.
+ */
+void http_server_close(struct http_server *server);
+
+/**
+ * @brief Send the response to a request from a route handler.
+ *
+ * @param conn Connection given to the handler.
+ * @param status HTTP status code.
+ * @param content_type Content-Type of the body, or NULL.
+ * @param body Body of the response. It is copied if it fits in the
+ * transmit buffer of the connection along with the header. Otherwise it is
+ * sent without being copied, and must remain valid until the response is
+ * sent, after the handler returns. The request body passed to the handler
+ * remains valid that long.
+ * @param len Length of the body.
+ *
+ * @return 0 if the response was sent or queued, or negative in case of
+ * error.
+ */
+int http_server_respond(struct http_server_conn *conn, uint16_t status,
+			const char *content_type, const void *body,
+			size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* ZEPHYR_INCLUDE_NET_HTTP_SERVER_H_ */
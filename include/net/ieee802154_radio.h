@@ -36,6 +36,8 @@ enum ieee802154_hw_caps {
 	IEEE802154_HW_SUB_GHZ	  = BIT(6), /* Sub-GHz radio supported */
 	IEEE802154_HW_ENERGY_SCAN = BIT(7), /* Energy scan supported */
 	IEEE802154_HW_TXTIME	  = BIT(8), /* TX at specified time supported */
+	IEEE802154_HW_RETRANSMISSION = BIT(9), /* Retransmits until ACKed */
+	IEEE802154_HW_RX_TX_ACK	  = BIT(10), /* Sends ACK on RX */
 };
 
 enum ieee802154_filter_type {
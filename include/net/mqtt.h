@@ -450,6 +450,16 @@ struct mqtt_internal {
 
 	/** Internal. Remaining payload length to read. */
 	uint32_t remaining_payload;
+
+#if defined(CONFIG_MQTT_MAX_INFLIGHT) && (CONFIG_MQTT_MAX_INFLIGHT > 0)
+	/** Internal. Message IDs of the QoS 1 and QoS 2 PUBLISH messages
+	 *  that have been sent but not yet acknowledged.
+	 */
+	uint16_t inflight[CONFIG_MQTT_MAX_INFLIGHT];
+
+	/** Internal. Number of valid entries in inflight. */
+	uint16_t inflight_count;
+#endif
 };
 
 /**
@@ -581,6 +591,15 @@ int mqtt_connect(struct mqtt_client *client);
 /**
  * @brief API to publish messages on topics.
  *
+ * The payload is not copied into the client's transmit buffer, it is handed
+ * to the transport together with the encoded header.
+ *
+ * With CONFIG_MQTT_MAX_INFLIGHT set, the message IDs of QoS 1 and
+ * QoS 2 messages are tracked until the matching PUBACK or PUBCOMP is
+ * received, and publishing a new QoS 1 or QoS 2 message fails with -EAGAIN
+ * while the window is full. Call @ref mqtt_input to process the
+ * acknowledgments and try again.
+ *
  * @param[in] client Client instance for which the procedure is requested.
  *                   Shall not be NULL.
  * @param[in] param Parameters to be used for the publish message.
@@ -738,6 +757,10 @@ uint32_t mqtt_keepalive_time_left(const struct mqtt_client *client);
  * @brief Receive an incoming MQTT packet. The registered callback will be
  *        called with the packet content.
  *
+ * Up to CONFIG_MQTT_RX_BATCH_SIZE packets that are already
+ * available on the transport are processed in one call. Processing stops
+ * after a PUBLISH message, so that its payload can be read.
+ *
  * @note In case of PUBLISH message, the payload has to be read separately with
  *       @ref mqtt_read_publish_payload function. The size of the payload to
  *       read is provided in the publish event structure.
@@ -610,6 +610,32 @@ static inline struct device *net_if_get_device(struct net_if *iface)
  */
 void net_if_queue_tx(struct net_if *iface, struct net_pkt *pkt);
 
+/**
+ * @brief Start holding back the packets queued for TX by this thread
+ *
+ * @details Until net_if_tx_batch_end() is called, the packets the calling
+ * thread queues with net_if_queue_tx() are kept back and then submitted
+ * to the TX queues all at once, so that the TX threads are woken up once
+ * for the whole batch. Only one thread can hold a batch at a time.
+ *
+ * @return True if the batch was started, false if another thread holds
+ * one, in which case the packets are queued as usual.
+ */
+bool net_if_tx_batch_begin(void);
+
+/**
+ * @brief Submit the packets held back by the TX batch of this thread
+ *
+ * @details The batch stays active. This is called before waiting for
+ * memory which the held packets may use.
+ */
+void net_if_tx_batch_flush(void);
+
+/**
+ * @brief Submit the held packets and end the TX batch of this thread
+ */
+void net_if_tx_batch_end(void);
+
 /**
  * @brief Return the IP offload status
  *
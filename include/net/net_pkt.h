@@ -18,6 +18,7 @@
 
 #include <zephyr/types.h>
 #include <stdbool.h>
+#include <string.h>
 
 #include <net/buf.h>
 
@@ -122,6 +123,15 @@ struct net_pkt {
 	};
 #endif /* CONFIG_NET_PKT_TIMESTAMP || CONFIG_NET_PKT_TXTIME */
 
+#if defined(CONFIG_NET_PKT_RXTIME_STATS_DETAIL) || \
+	defined(CONFIG_NET_PKT_TXTIME_STATS_DETAIL)
+	/** Cycle counter at the points of the RX or TX path, see
+	 * enum net_stats_rx_detail and enum net_stats_tx_detail.
+	 */
+	uint32_t stats_tick[MAX((int)NET_STATS_RX_DETAIL_COUNT,
+				(int)NET_STATS_TX_DETAIL_COUNT)];
+#endif
+
 	/** Reference counter */
 	atomic_t atomic_ref;
 
@@ -186,6 +196,13 @@ struct net_pkt {
 				     */
 #endif
 
+#if defined(CONFIG_NET_IPV4_FRAGMENT)
+	uint8_t ipv4_reassembled  : 1; /* Is this pkt reassembled from IPv4
+				     * fragments, in which case it has no
+				     * link layer header.
+				     */
+#endif
+
 	union {
 		/* IPv6 hop limit or IPv4 ttl for this network packet.
 		 * The value is shared between IPv6 and IPv4.
@@ -210,6 +227,14 @@ struct net_pkt {
 	uint8_t priority;
 #endif
 
+#if defined(CONFIG_NET_PKT_FLOW_HASH)
+	/* Hash of the flow this packet belongs to, 0 if not known. Set
+	 * by the driver if the hardware computes one, otherwise by the
+	 * stack when queueing the received packet.
+	 */
+	uint32_t flow_hash;
+#endif
+
 #if defined(CONFIG_NET_VLAN)
 	/* VLAN TCI (Tag Control Information). This contains the Priority
 	 * Code Point (PCP), Drop Eligible Indicator (DEI) and VLAN
@@ -673,6 +698,33 @@ static inline void net_pkt_set_ipv6_fragment_id(struct net_pkt *pkt,
 }
 #endif /* CONFIG_NET_IPV6_FRAGMENT */
 
+#if defined(CONFIG_NET_IPV4_FRAGMENT)
+static inline bool net_pkt_ipv4_reassembled(struct net_pkt *pkt)
+{
+	return !!(pkt->ipv4_reassembled);
+}
+
+static inline void net_pkt_set_ipv4_reassembled(struct net_pkt *pkt,
+						bool reassembled)
+{
+	pkt->ipv4_reassembled = reassembled;
+}
+#else /* CONFIG_NET_IPV4_FRAGMENT */
+static inline bool net_pkt_ipv4_reassembled(struct net_pkt *pkt)
+{
+	ARG_UNUSED(pkt);
+
+	return false;
+}
+
+static inline void net_pkt_set_ipv4_reassembled(struct net_pkt *pkt,
+						bool reassembled)
+{
+	ARG_UNUSED(pkt);
+	ARG_UNUSED(reassembled);
+}
+#endif /* CONFIG_NET_IPV4_FRAGMENT */
+
 #if NET_TC_COUNT > 1
 static inline uint8_t net_pkt_priority(struct net_pkt *pkt)
 {
@@ -694,6 +746,29 @@ static inline uint8_t net_pkt_priority(struct net_pkt *pkt)
 
 #endif /* NET_TC_COUNT > 1 */
 
+#if defined(CONFIG_NET_PKT_FLOW_HASH)
+static inline uint32_t net_pkt_flow_hash(struct net_pkt *pkt)
+{
+	return pkt->flow_hash;
+}
+
+static inline void net_pkt_set_flow_hash(struct net_pkt *pkt,
+					 uint32_t hash)
+{
+	pkt->flow_hash = hash;
+}
+#else
+static inline uint32_t net_pkt_flow_hash(struct net_pkt *pkt)
+{
+	ARG_UNUSED(pkt);
+
+	return 0;
+}
+
+#define net_pkt_set_flow_hash(...)
+
+#endif /* CONFIG_NET_PKT_FLOW_HASH */
+
 #if defined(CONFIG_NET_VLAN)
 static inline uint16_t net_pkt_vlan_tag(struct net_pkt *pkt)
 {
@@ -804,6 +879,53 @@ static inline void net_pkt_set_timestamp(struct net_pkt *pkt,
 }
 #endif /* CONFIG_NET_PKT_TIMESTAMP */
 
+#if defined(CONFIG_NET_PKT_RXTIME_STATS_DETAIL) || \
+	defined(CONFIG_NET_PKT_TXTIME_STATS_DETAIL)
+static inline uint32_t *net_pkt_stats_tick(struct net_pkt *pkt)
+{
+	return pkt->stats_tick;
+}
+
+static inline void net_pkt_stats_tick_reset(struct net_pkt *pkt)
+{
+	memset(pkt->stats_tick, 0, sizeof(pkt->stats_tick));
+}
+#else
+static inline uint32_t *net_pkt_stats_tick(struct net_pkt *pkt)
+{
+	ARG_UNUSED(pkt);
+
+	return NULL;
+}
+
+static inline void net_pkt_stats_tick_reset(struct net_pkt *pkt)
+{
+	ARG_UNUSED(pkt);
+}
+#endif
+
+static inline void net_pkt_set_rx_stats_tick(struct net_pkt *pkt,
+					     enum net_stats_rx_detail point)
+{
+#if defined(CONFIG_NET_PKT_RXTIME_STATS_DETAIL)
+	pkt->stats_tick[point] = k_cycle_get_32();
+#else
+	ARG_UNUSED(pkt);
+	ARG_UNUSED(point);
+#endif
+}
+
+static inline void net_pkt_set_tx_stats_tick(struct net_pkt *pkt,
+					     enum net_stats_tx_detail point)
+{
+#if defined(CONFIG_NET_PKT_TXTIME_STATS_DETAIL)
+	pkt->stats_tick[point] = k_cycle_get_32();
+#else
+	ARG_UNUSED(pkt);
+	ARG_UNUSED(point);
+#endif
+}
+
 #if defined(CONFIG_NET_PKT_TXTIME)
 static inline uint64_t net_pkt_txtime(struct net_pkt *pkt)
 {
@@ -218,6 +218,38 @@ struct net_stats_rx_time {
 	net_stats_t count;
 };
 
+/**
+ * @brief Points in the RX path where the time is recorded for
+ * CONFIG_NET_PKT_RXTIME_STATS_DETAIL
+ */
+enum net_stats_rx_detail {
+	/** Packet given to the stack by the driver */
+	NET_STATS_RX_DETAIL_RECV,
+	/** Packet taken from the RX queue, before L2 */
+	NET_STATS_RX_DETAIL_L2,
+	/** IPv4 or IPv6 input */
+	NET_STATS_RX_DETAIL_IP,
+	/** UDP or TCP input */
+	NET_STATS_RX_DETAIL_L4,
+
+	NET_STATS_RX_DETAIL_COUNT
+};
+
+/**
+ * @brief Points in the TX path where the time is recorded for
+ * CONFIG_NET_PKT_TXTIME_STATS_DETAIL
+ */
+enum net_stats_tx_detail {
+	/** IPv4 or IPv6 header finalized */
+	NET_STATS_TX_DETAIL_IP,
+	/** Packet given to net_send_data() */
+	NET_STATS_TX_DETAIL_SEND,
+	/** Packet taken from the TX queue, before L2 */
+	NET_STATS_TX_DETAIL_L2,
+
+	NET_STATS_TX_DETAIL_COUNT
+};
+
 /**
  * @brief Traffic class statistics
  */
@@ -316,11 +348,27 @@ struct net_stats {
 	struct net_stats_tx_time tx_time;
 #endif
 
+#if defined(CONFIG_NET_PKT_TXTIME_STATS_DETAIL)
+	/** Cycles spent from the creation of the packet to each point of
+	 * the TX path, from one point to the next, and from the last point
+	 * to the packet being sent.
+	 */
+	struct net_stats_tx_time tx_time_detail[NET_STATS_TX_DETAIL_COUNT + 1];
+#endif
+
 #if defined(CONFIG_NET_PKT_RXTIME_STATS)
 	/** Network packet RX time statistics */
 	struct net_stats_rx_time rx_time;
 #endif
 
+#if defined(CONFIG_NET_PKT_RXTIME_STATS_DETAIL)
+	/** Cycles spent from the creation of the packet to each point of
+	 * the RX path, from one point to the next, and from the last point
+	 * to the data being read by the application.
+	 */
+	struct net_stats_rx_time rx_time_detail[NET_STATS_RX_DETAIL_COUNT + 1];
+#endif
+
 #if defined(CONFIG_NET_STATISTICS_POWER_MANAGEMENT)
 	struct net_stats_pm pm;
 #endif
@@ -54,6 +54,8 @@ struct zsock_pollfd {
 
 /** zsock_recv: Read data without removing it from socket input queue */
 #define ZSOCK_MSG_PEEK 0x02
+/** zsock_recvmsg: Datagram was truncated to fit the buffers (output only) */
+#define ZSOCK_MSG_TRUNC 0x20
 /** zsock_recv/zsock_send: Override operation to non-blocking */
 #define ZSOCK_MSG_DONTWAIT 0x40
 
@@ -119,6 +121,29 @@ struct zsock_pollfd {
  *    - 1 - server
  */
 #define TLS_DTLS_ROLE 6
+/** Socket option to enable TLS session resumption. It accepts and returns an
+ *  integer, TLS_SESSION_CACHE_DISABLED (default) or
+ *  TLS_SESSION_CACHE_ENABLED. For TLS clients, the session established with a
+ *  server is kept after the socket is closed, so that the next connection to
+ *  the same server address, with the same TLS_HOSTNAME and TLS_SEC_TAG_LIST,
+ *  can resume it instead of doing a full handshake.
+ *  For TLS servers (set on the listening socket), the sessions of the clients
+ *  are kept so that they can resume them. Requires
+ *  CONFIG_NET_SOCKETS_TLS_SESSION_CACHE.
+ */
+#define TLS_SESSION_CACHE 7
+/** Write-only socket option to remove all the cached TLS client sessions.
+ *  It takes no value.
+ */
+#define TLS_SESSION_CACHE_PURGE 8
+/** Socket option to coalesce small writes into fewer TLS records. It accepts
+ *  and returns an integer, 0 (default) to disable or 1 to enable. When
+ *  enabled, the data of small send() calls is buffered and sent in a single
+ *  record when the buffer is full, before the socket is read or polled, when
+ *  the option is disabled and when the socket is closed. This is similar to
+ *  TCP_CORK. Requires CONFIG_NET_SOCKETS_TLS_COALESCE.
+ */
+#define TLS_TX_COALESCE 9
 
 /** @} */
 
@@ -131,6 +156,10 @@ struct zsock_pollfd {
 #define TLS_DTLS_ROLE_CLIENT 0 /**< Client role in a DTLS session. */
 #define TLS_DTLS_ROLE_SERVER 1 /**< Server role in a DTLS session. */
 
+/* Valid values for TLS_SESSION_CACHE option */
+#define TLS_SESSION_CACHE_DISABLED 0 /**< Disable TLS session caching. */
+#define TLS_SESSION_CACHE_ENABLED 1 /**< Enable TLS session caching. */
+
 struct zsock_addrinfo {
 	struct zsock_addrinfo *ai_next;
 	int ai_flags;
@@ -351,6 +380,45 @@ static inline ssize_t zsock_send(int sock, const void *buf, size_t len,
 __syscall ssize_t zsock_sendmsg(int sock, const struct msghdr *msg,
 				int flags);
 
+/**
+ * @brief Send all the data of a message
+ *
+ * @details
+ * Call zsock_sendmsg() until all the data described by @p msg has been
+ * sent. The ``msg_iov`` pointer, ``msg_iovlen`` and the ``msg_iov``
+ * entries are advanced over the data sent, so they are modified. When a
+ * call fails, for instance with EAGAIN when ``ZSOCK_MSG_DONTWAIT`` is
+ * given, @p msg describes the data left and calling again with it
+ * resumes the send.
+ *
+ * @param sock Socket
+ * @param msg Message to send, advanced over the data sent
+ * @param flags Flags for zsock_sendmsg()
+ *
+ * @return Number of bytes sent, -1 on error with errno set. The data sent
+ *         before the error is no longer part of @p msg.
+ */
+ssize_t zsock_sendmsg_all(int sock, struct msghdr *msg, int flags);
+
+/**
+ * @brief Send multiple messages in one call
+ *
+ * @details
+ * @rst
+ * See `Linux man page
+ * <https://man7.org/linux/man-pages/man2/sendmmsg.2.html>`__
+ * for the description. The number of bytes sent for each message is
+ * stored in its ``msg_len`` field. An error is returned only if no
+ * message could be sent, otherwise the number of sent messages is
+ * returned. With the native network stack, the datagrams of the batch
+ * are queued for transmission together.
+ * This function is also exposed as ``sendmmsg()``
+ * if :option:`CONFIG_NET_SOCKETS_POSIX_NAMES` is defined.
+ * @endrst
+ */
+__syscall int zsock_sendmmsg(int sock, struct mmsghdr *msgvec,
+			     unsigned int vlen, int flags);
+
 /**
  * @brief Receive data from an arbitrary network address
  *
@@ -367,6 +435,104 @@ __syscall ssize_t zsock_recvfrom(int sock, void *buf, size_t max_len,
 				 int flags, struct sockaddr *src_addr,
 				 socklen_t *addrlen);
 
+/**
+ * @brief Receive a message from an arbitrary network address
+ *
+ * @details
+ * @rst
+ * See `POSIX.1-2017 article
+ * <http://pubs.opengroup.org/onlinepubs/9699919799/functions/recvmsg.html>`__
+ * for normative description. Ancillary data is not supported,
+ * ``msg_controllen`` is always set to 0. Sockets not implementing it
+ * (TLS, offloaded, ...) fail with EOPNOTSUPP.
+ * This function is also exposed as ``recvmsg()``
+ * if :option:`CONFIG_NET_SOCKETS_POSIX_NAMES` is defined.
+ * @endrst
+ */
+__syscall ssize_t zsock_recvmsg(int sock, struct msghdr *msg, int flags);
+
+/**
+ * @brief Receive multiple messages in one call
+ *
+ * @details
+ * @rst
+ * See `Linux man page
+ * <https://man7.org/linux/man-pages/man2/recvmmsg.2.html>`__
+ * for the description. Unlike Linux, there is no timeout argument,
+ * and the call behaves as if ``MSG_WAITFORONE`` was given: it blocks
+ * (unless ``ZSOCK_MSG_DONTWAIT`` is set or the socket is non-blocking)
+ * only for the first message and then returns the messages already
+ * queued, up to ``vlen``. The number of bytes received for each
+ * message is stored in its ``msg_len`` field.
+ * This function is also exposed as ``recvmmsg()``
+ * if :option:`CONFIG_NET_SOCKETS_POSIX_NAMES` is defined.
+ * @endrst
+ */
+__syscall int zsock_recvmmsg(int sock, struct mmsghdr *msgvec,
+			     unsigned int vlen, int flags);
+
+/**
+ * @brief Zero-copy receive handle
+ *
+ * Keeps the network buffers lent by zsock_recvmsg_zc() alive. The
+ * fields are informational, the handle must be passed to
+ * zsock_recv_zc_release() once the data has been processed.
+ */
+struct zsock_zc_buf {
+	/** First fragment the lent data starts in */
+	struct net_buf *frag;
+	/** Offset of the lent data in the first fragment */
+	uint16_t offset;
+	/** Total number of bytes lent */
+	size_t len;
+	/** @cond INTERNAL_HIDDEN */
+	void *pkt;
+	void *ctx;
+	size_t wnd;
+	/** @endcond */
+};
+
+/**
+ * @brief Receive data without copying it
+ *
+ * @details
+ * Instead of copying the received data, point the ``msg_iov`` entries
+ * to the network buffer fragments holding it, one entry per fragment.
+ * ``msg_iovlen`` is the number of entries available on input and the
+ * number of entries filled on output. The data stays valid until
+ * zsock_recv_zc_release() is called for @p zc, until then the buffers
+ * are not returned to the network buffer pool. The data is consumed
+ * from the socket when this function returns, but for stream sockets the
+ * receive window is only reopened by zsock_recv_zc_release(), so that
+ * the peer cannot fill the pool while the buffers are held.
+ *
+ * Datagrams not fitting in the available entries are truncated and
+ * ``ZSOCK_MSG_TRUNC`` is set in ``msg_flags``. Stream data which does
+ * not fit is left in the socket for the next call.
+ *
+ * Only available to kernel threads, and only for the native sockets,
+ * other sockets (TLS, offloaded, ...) fail with EOPNOTSUPP. TLS sockets
+ * hold the decrypted data in their own buffer, not in network buffers,
+ * use zsock_recvmsg() with them.
+ *
+ * @param sock Socket
+ * @param msg Message header, the buffers are set by this function
+ * @param flags ZSOCK_MSG_PEEK and ZSOCK_MSG_DONTWAIT are supported
+ * @param zc Handle to release the data with
+ *
+ * @return Number of bytes received, -1 on error with errno set
+ */
+ssize_t zsock_recvmsg_zc(int sock, struct msghdr *msg, int flags,
+			 struct zsock_zc_buf *zc);
+
+/**
+ * @brief Release the data received with zsock_recvmsg_zc()
+ *
+ * @param zc Handle filled by zsock_recvmsg_zc(). It is safe to release
+ *        an already released handle.
+ */
+void zsock_recv_zc_release(struct zsock_zc_buf *zc);
+
 /**
  * @brief Receive data from a connected peer
  *
@@ -691,6 +857,23 @@ static inline ssize_t recvfrom(int sock, void *buf, size_t max_len, int flags,
 	return zsock_recvfrom(sock, buf, max_len, flags, src_addr, addrlen);
 }
 
+static inline ssize_t recvmsg(int sock, struct msghdr *msg, int flags)
+{
+	return zsock_recvmsg(sock, msg, flags);
+}
+
+static inline int sendmmsg(int sock, struct mmsghdr *msgvec,
+			   unsigned int vlen, int flags)
+{
+	return zsock_sendmmsg(sock, msgvec, vlen, flags);
+}
+
+static inline int recvmmsg(int sock, struct mmsghdr *msgvec,
+			   unsigned int vlen, int flags)
+{
+	return zsock_recvmmsg(sock, msgvec, vlen, flags);
+}
+
 static inline int poll(struct zsock_pollfd *fds, int nfds, int timeout)
 {
 	return zsock_poll(fds, nfds, timeout);
@@ -764,6 +947,7 @@ static inline char *inet_ntop(sa_family_t family, const void *src, char *dst,
 #define POLLNVAL ZSOCK_POLLNVAL
 
 #define MSG_PEEK ZSOCK_MSG_PEEK
+#define MSG_TRUNC ZSOCK_MSG_TRUNC
 #define MSG_DONTWAIT ZSOCK_MSG_DONTWAIT
 
 #define SHUT_RD ZSOCK_SHUT_RD
@@ -0,0 +1,162 @@
+/** @file
+ * @brief Socket service API
+ *
+ * Lets network services share a dispatcher thread polling their sockets
+ * instead of blocking a thread of their own on every socket.
+ */
+
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_INCLUDE_NET_SOCKET_SERVICE_H_
+#define ZEPHYR_INCLUDE_NET_SOCKET_SERVICE_H_
+
+/**
+ * @brief Socket service API
+ * @defgroup net_socket_service Socket service API
+ * @ingroup networking
+ * @{
+ */
+
+#include <kernel.h>
+#include <net/socket.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct net_socket_service_desc;
+struct net_socket_service_event;
+
+/**
+ * @typedef net_socket_service_handler_t
+ * @brief Handler called when a socket of a service is ready.
+ *
+ * The handler should consume the events, for example read the data
+ * available, and unregister a socket which reports ZSOCK_POLLERR,
+ * ZSOCK_POLLHUP or ZSOCK_POLLNVAL, otherwise it is called again.
+ *
+ * @param pev Socket and the events that occurred on it.
+ */
+typedef void (*net_socket_service_handler_t)(
+				struct net_socket_service_event *pev);
+
+/** A socket registered to a service */
+struct net_socket_service_event {
+	/** @cond INTERNAL_HIDDEN */
+	struct k_work work;
+	atomic_t busy;
+	/* Changed on every registration, to tell stale poll results */
+	uint32_t gen;
+	/* Registration the pending work was submitted for */
+	uint32_t work_gen;
+	/** @endcond */
+
+	/** Service the socket is registered to */
+	struct net_socket_service_desc *svc;
+
+	/** The socket and the events it is polled for. revents holds the
+	 * events that occurred when the handler is called.
+	 */
+	struct zsock_pollfd event;
+
+	/** User data given when the socket was registered */
+	void *user_data;
+};
+
+/** Socket service, define it with NET_SOCKET_SERVICE_DEFINE() */
+struct net_socket_service_desc {
+	/** @cond INTERNAL_HIDDEN */
+	sys_snode_t node;
+	/** @endcond */
+
+	/** Name of the service, for debugging */
+	const char *owner;
+
+	/** Handler of the ready sockets */
+	net_socket_service_handler_t handler;
+
+	/** Work queue the handler is called from, or NULL to call it from the
+	 * dispatcher thread, which must then not block in it.
+	 */
+	struct k_work_q *work_q;
+
+	/** Sockets of the service */
+	struct net_socket_service_event *pev;
+
+	/** Maximum number of sockets of the service */
+	int pev_len;
+};
+
+/**
+ * @brief Statically define a socket service.
+ *
+ * @param name Name of the service variable.
+ * @param _work_q Work queue the handler is called from, for example
+ * &k_sys_work_q, or NULL to call it from the dispatcher thread.
+ * @param _handler Handler of the ready sockets.
+ * @param _count Maximum number of sockets of the service.
+ */
+#define NET_SOCKET_SERVICE_DEFINE(name, _work_q, _handler, _count)	\
+	static struct net_socket_service_event name##_events[_count];	\
+	static struct net_socket_service_desc name = {			\
+		.owner = STRINGIFY(name),				\
+		.handler = _handler,					\
+		.work_q = _work_q,					\
+		.pev = name##_events,					\
+		.pev_len = _count,					\
+	}
+
+/**
+ * @brief Set the sockets of a service.
+ *
+ * Replaces the sockets the service was registered with, if any. Entries
+ * with a negative fd are ignored. At most CONFIG_NET_SOCKETS_POLL_MAX - 1
+ * sockets are polled by the dispatcher for all the services together.
+ *
+ * While the handler of a socket is pending on the work queue of the
+ * service, the socket is not polled, so the handler is not called again
+ * until it has returned.
+ *
+ * @param svc Service.
+ * @param fds Sockets and the events to poll them for, copied.
+ * @param len Number of sockets, 0 to unregister the service.
+ * @param user_data User data passed to the handler.
+ *
+ * @return 0 in case of success, -EINVAL if len is larger than the
+ * service allows, or -ENOMEM if the dispatcher cannot poll that many
+ * sockets. In case of error the service keeps the sockets it was
+ * registered with.
+ */
+int net_socket_service_register(struct net_socket_service_desc *svc,
+				struct zsock_pollfd *fds, int len,
+				void *user_data);
+
+/**
+ * @brief Unregister the sockets of a service.
+ *
+ * The handler is not called for the sockets any more, unless it is already
+ * running on the work queue of the service.
+ *
+ * @param svc Service.
+ *
+ * @return 0 in case of success or negative in case of error.
+ */
+static inline int net_socket_service_unregister(
+				struct net_socket_service_desc *svc)
+{
+	return net_socket_service_register(svc, NULL, 0, NULL);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* ZEPHYR_INCLUDE_NET_SOCKET_SERVICE_H_ */
@@ -151,11 +151,37 @@ int websocket_send_msg(int ws_sock, const uint8_t *payload, size_t payload_len,
 		       enum websocket_opcode opcode, bool mask, bool final,
 		       int32_t timeout);
 
+/**
+ * @brief Send websocket msg to peer, masking the payload in place.
+ *
+ * @details Same as websocket_send_msg(), but the payload is masked in the
+ * buffer of the caller instead of in a copy. The content of the payload
+ * is undefined after the call.
+ *
+ * @param ws_sock Websocket id returned by websocket_connect().
+ * @param payload Websocket data to send.
+ * @param payload_len Length of the data to be sent.
+ * @param opcode Operation code (text, binary, ping, pong, close)
+ * @param mask Mask the data, see RFC 6455 for details
+ * @param final Is this final message for this message send.
+ * @param timeout How long to try to send the message. The value is in
+ *        milliseconds. Value SYS_FOREVER_MS means to wait forever.
+ *
+ * @return <0 if error, >=0 amount of bytes sent
+ */
+int websocket_send_msg_in_place(int ws_sock, uint8_t *payload,
+				size_t payload_len,
+				enum websocket_opcode opcode, bool mask,
+				bool final, int32_t timeout);
+
 /**
  * @brief Receive websocket msg from peer.
  *
  * @details The function will automatically remove websocket header from the
- * message.
+ * message. If the permessage-deflate extension was negotiated, a compressed
+ * message is returned decompressed and whole, so buf must be large enough
+ * for it. On a frame which cannot be received, the connection is failed
+ * with a close frame, and later calls return -ECONNABORTED.
  *
  * @param ws_sock Websocket id returned by websocket_connect().
  * @param buf Buffer where websocket data is read.
@@ -12,6 +12,7 @@
 #include <zephyr.h>
 #include <init.h>
 #include <net/socket.h>
+#include <net/socket_service.h>
 #include <errno.h>
 #include <mgmt/mgmt.h>
 #include <mgmt/smp_udp.h>
@@ -27,8 +28,7 @@ struct config {
 	const char *proto;
 	struct zephyr_smp_transport smp_transport;
 	char recv_buffer[CONFIG_MCUMGR_SMP_UDP_MTU];
-	struct k_thread thread;
-	K_THREAD_STACK_MEMBER(stack, CONFIG_MCUMGR_SMP_UDP_STACK_SIZE);
+	struct net_socket_service_desc *service;
 };
 
 struct configs {
@@ -98,40 +98,45 @@ static int smp_udp_ud_copy(struct net_buf *dst, const struct net_buf *src)
 	return MGMT_ERR_EOK;
 }
 
-static void smp_udp_receive_thread(void *p1, void *p2, void *p3)
+static void smp_udp_receive_handler(struct net_socket_service_event *pev)
 {
-	struct config *conf = (struct config *)p1;
-
-	ARG_UNUSED(p2);
-	ARG_UNUSED(p3);
-
-	LOG_INF("Started (%s)", conf->proto);
-
-	while (1) {
-		struct sockaddr addr;
-		socklen_t addr_len = sizeof(addr);
-
-		int len = recvfrom(conf->sock, conf->recv_buffer,
-				   CONFIG_MCUMGR_SMP_UDP_MTU,
-				   0, &addr, &addr_len);
-
-		if (len > 0) {
-			struct sockaddr *ud;
-			struct net_buf *nb;
-
-			/* store sender address in user data for reply */
-			nb = mcumgr_buf_alloc();
-			net_buf_add_mem(nb, conf->recv_buffer, len);
-			ud = net_buf_user_data(nb);
-			net_ipaddr_copy(ud, &addr);
-
-			zephyr_smp_rx_req(&conf->smp_transport, nb);
-		} else if (len < 0) {
-			LOG_ERR("recvfrom error (%s): %i", conf->proto, errno);
-		}
+	struct config *conf = pev->user_data;
+	struct sockaddr addr;
+	socklen_t addr_len = sizeof(addr);
+	int len;
+
+	len = recvfrom(conf->sock, conf->recv_buffer,
+		       CONFIG_MCUMGR_SMP_UDP_MTU,
+		       MSG_DONTWAIT, &addr, &addr_len);
+
+	if (len > 0) {
+		struct sockaddr *ud;
+		struct net_buf *nb;
+
+		/* store sender address in user data for reply */
+		nb = mcumgr_buf_alloc();
+		net_buf_add_mem(nb, conf->recv_buffer, len);
+		ud = net_buf_user_data(nb);
+		net_ipaddr_copy(ud, &addr);
+
+		zephyr_smp_rx_req(&conf->smp_transport, nb);
+	} else if (len < 0 && errno != EAGAIN) {
+		LOG_ERR("recvfrom error (%s): %i", conf->proto, errno);
+		net_socket_service_unregister(conf->service);
 	}
 }
 
+/* The requests are handed over to the SMP work queue, so they are received
+ * from the socket service dispatcher thread.
+ */
+#if CONFIG_MCUMGR_SMP_UDP_IPV4
+NET_SOCKET_SERVICE_DEFINE(smp_udp4_service, NULL, smp_udp_receive_handler, 1);
+#endif
+
+#if CONFIG_MCUMGR_SMP_UDP_IPV6
+NET_SOCKET_SERVICE_DEFINE(smp_udp6_service, NULL, smp_udp_receive_handler, 1);
+#endif
+
 static int smp_udp_init(struct device *dev)
 {
 	ARG_UNUSED(dev);
@@ -172,15 +177,24 @@ static int create_socket(struct sockaddr *addr, const char *proto)
 	return sock;
 }
 
-static void create_thread(struct config *conf, const char *name)
+static int register_service(struct config *conf)
 {
-	k_thread_create(&(conf->thread), conf->stack,
-			K_THREAD_STACK_SIZEOF(conf->stack),
-			smp_udp_receive_thread, conf, NULL, NULL,
-			CONFIG_MCUMGR_SMP_UDP_THREAD_PRIO, 0, K_FOREVER);
+	struct zsock_pollfd fds = {
+		.fd = conf->sock,
+		.events = ZSOCK_POLLIN,
+	};
+	int ret;
+
+	ret = net_socket_service_register(conf->service, &fds, 1, conf);
+	if (ret < 0) {
+		LOG_ERR("Could not register socket service (%s), err: %i",
+			conf->proto, ret);
+		return ret;
+	}
 
-	k_thread_name_set(&(conf->thread), name);
-	k_thread_start(&(conf->thread));
+	LOG_INF("Started (%s)", conf->proto);
+
+	return 0;
 }
 
 SYS_INIT(smp_udp_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
@@ -204,7 +218,10 @@ int smp_udp_open(void)
 		return -MGMT_ERR_EUNKNOWN;
 	}
 
-	create_thread(conf, "smp_udp4");
+	conf->service = &smp_udp4_service;
+	if (register_service(conf) < 0) {
+		return -MGMT_ERR_EUNKNOWN;
+	}
 #endif
 
 #if CONFIG_MCUMGR_SMP_UDP_IPV6
@@ -222,7 +239,10 @@ int smp_udp_open(void)
 		return -MGMT_ERR_EUNKNOWN;
 	}
 
-	create_thread(conf, "smp_udp6");
+	conf->service = &smp_udp6_service;
+	if (register_service(conf) < 0) {
+		return -MGMT_ERR_EUNKNOWN;
+	}
 #endif
 
 	return MGMT_ERR_EOK;
@@ -231,12 +251,12 @@ int smp_udp_open(void)
 int smp_udp_close(void)
 {
 #if CONFIG_MCUMGR_SMP_UDP_IPV4
-	k_thread_abort(&(configs.ipv4.thread));
+	net_socket_service_unregister(&smp_udp4_service);
 	close(configs.ipv4.sock);
 #endif
 
 #if CONFIG_MCUMGR_SMP_UDP_IPV6
-	k_thread_abort(&(configs.ipv6.thread));
+	net_socket_service_unregister(&smp_udp6_service);
 	close(configs.ipv6.sock);
 #endif
 
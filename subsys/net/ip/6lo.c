@@ -107,6 +107,14 @@ static int get_ihpc_inlined_size(uint16_t iphc)
 	size += sa_inline_size_table[(iphc & NET_6LO_IPHC_SA_MASK) >>
 				      NET_6LO_IPHC_SAM_POS];
 
+	/* M=1 DAC=1 is either unsupported or reserved, the table has no
+	 * entries for it.
+	 */
+	if ((iphc & NET_6LO_IPHC_M_MASK) && (iphc & NET_6LO_IPHC_DAC_MASK)) {
+		NET_DBG("Unsupported DAM options");
+		return -1;
+	}
+
 	size += da_inline_size_table[(iphc & NET_6LO_IPHC_DA_MASK) >>
 				      NET_6LO_IPHC_DAM_POS];
 
@@ -210,43 +218,63 @@ void net_6lo_set_context(struct net_if *iface,
 	NET_DBG("Either no free slots in the table or exceeds limit");
 }
 
-/* Get the context by matching cid */
-static inline struct net_6lo_context *
-get_6lo_context_by_cid(struct net_if *iface, uint8_t cid)
+/* Get the source and destination contexts by matching cid, in one pass
+ * over the table.
+ */
+static inline void get_6lo_contexts_by_cid(struct net_if *iface,
+					   uint8_t src_cid, uint8_t dst_cid,
+					   struct net_6lo_context **src,
+					   struct net_6lo_context **dst)
 {
 	uint8_t i;
 
+	*src = NULL;
+	*dst = NULL;
+
 	for (i = 0U; i < CONFIG_NET_MAX_6LO_CONTEXTS; i++) {
-		if (!ctx_6co[i].is_used) {
+		if (!ctx_6co[i].is_used || ctx_6co[i].iface != iface) {
 			continue;
 		}
 
-		if (ctx_6co[i].iface == iface && ctx_6co[i].cid == cid) {
-			return &ctx_6co[i];
+		if (!*src && ctx_6co[i].cid == src_cid) {
+			*src = &ctx_6co[i];
 		}
-	}
 
-	return NULL;
+		if (!*dst && ctx_6co[i].cid == dst_cid) {
+			*dst = &ctx_6co[i];
+		}
+	}
 }
 
-/* Get the context by addr */
-static inline struct net_6lo_context *
-get_6lo_context_by_addr(struct net_if *iface, struct in6_addr *addr)
+/* Get the contexts of the source and destination addresses, in one pass
+ * over the table. Only the contexts usable for compression are returned.
+ */
+static inline void get_6lo_contexts_by_addr(struct net_if *iface,
+					    struct net_ipv6_hdr *ipv6,
+					    struct net_6lo_context **src,
+					    struct net_6lo_context **dst)
 {
 	uint8_t i;
 
+	*src = NULL;
+	*dst = NULL;
+
 	for (i = 0U; i < CONFIG_NET_MAX_6LO_CONTEXTS; i++) {
-		if (!ctx_6co[i].is_used) {
+		if (!ctx_6co[i].is_used || !ctx_6co[i].compress ||
+		    ctx_6co[i].iface != iface) {
 			continue;
 		}
 
-		if (ctx_6co[i].iface == iface &&
-		    !memcmp(ctx_6co[i].prefix.s6_addr, addr->s6_addr, 8)) {
-			return &ctx_6co[i];
+		if (!*src &&
+		    !memcmp(ctx_6co[i].prefix.s6_addr, ipv6->src.s6_addr, 8)) {
+			*src = &ctx_6co[i];
 		}
-	}
 
-	return NULL;
+		if (!*dst &&
+		    !memcmp(ctx_6co[i].prefix.s6_addr, ipv6->dst.s6_addr, 8)) {
+			*dst = &ctx_6co[i];
+		}
+	}
 }
 
 #endif
@@ -679,37 +707,6 @@ static inline uint8_t *compress_nh_udp(struct net_udp_hdr *udp, uint8_t *inline_
 	return inline_ptr_udp;
 }
 
-#if defined(CONFIG_NET_6LO_CONTEXT)
-
-static struct net_6lo_context *get_src_addr_ctx(struct net_pkt *pkt,
-						struct net_ipv6_hdr *ipv6)
-{
-	/* If compress flag is unset means use only in uncompression. */
-	struct net_6lo_context *src;
-
-	src = get_6lo_context_by_addr(net_pkt_iface(pkt), &ipv6->src);
-	if (!src || !src->compress) {
-		return NULL;
-	}
-
-	return src;
-}
-
-static struct net_6lo_context *get_dst_addr_ctx(struct net_pkt *pkt,
-						struct net_ipv6_hdr *ipv6)
-{
-	/* If compress flag is unset means use only in uncompression. */
-	struct net_6lo_context *dst;
-
-	dst = get_6lo_context_by_addr(net_pkt_iface(pkt), &ipv6->dst);
-	if (!dst || !dst->compress) {
-		return NULL;
-	}
-
-	return dst;
-}
-#endif /* CONFIG_NET_6LO_CONTEXT */
-
 /* RFC 6282 LOWPAN IPHC Encoding format (3.1)
  *  Base Format
  *   0                                       1
@@ -743,6 +740,23 @@ static inline int compress_IPHC_header(struct net_pkt *pkt)
 		return -EINVAL;
 	}
 
+#if defined(CONFIG_NET_6LO_CONTEXT)
+	get_6lo_contexts_by_addr(net_pkt_iface(pkt), ipv6, &src_ctx, &dst_ctx);
+
+	/* Link local, multicast and unspecified addresses are compressed
+	 * without context.
+	 */
+	if (net_6lo_ll_prefix_padded_with_zeros(&ipv6->dst) ||
+	    net_ipv6_is_addr_mcast(&ipv6->dst)) {
+		dst_ctx = NULL;
+	}
+
+	if (net_6lo_ll_prefix_padded_with_zeros(&ipv6->src) ||
+	    net_ipv6_is_addr_unspecified(&ipv6->src)) {
+		src_ctx = NULL;
+	}
+#endif
+
 	inline_pos = pkt->buffer->data + NET_IPV6H_LEN;
 
 	if (ipv6->nexthdr == IPPROTO_UDP) {
@@ -763,7 +777,6 @@ static inline int compress_IPHC_header(struct net_pkt *pkt)
 	}
 
 #if defined(CONFIG_NET_6LO_CONTEXT)
-	dst_ctx = get_dst_addr_ctx(pkt, ipv6);
 	if (dst_ctx) {
 		iphc |= NET_6LO_IPHC_CID_1;
 		inline_pos = compress_da_ctx(ipv6, inline_pos, pkt, &iphc,
@@ -789,7 +802,6 @@ da_end:
 	}
 
 #if defined(CONFIG_NET_6LO_CONTEXT)
-	src_ctx = get_src_addr_ctx(pkt, ipv6);
 	if (src_ctx) {
 		inline_pos = compress_sa_ctx(ipv6, inline_pos, pkt, &iphc,
 					     src_ctx);
@@ -849,7 +861,7 @@ static inline uint8_t *uncompress_tfl(uint16_t iphc, uint8_t *cursor,
 		ipv6->tcflow = ((tcl & 0x0F) << 4) | (*cursor & 0x0F);
 		cursor++;
 
-		memmove(&ipv6->flow, cursor, sizeof(ipv6->flow));
+		memcpy(&ipv6->flow, cursor, sizeof(ipv6->flow));
 		cursor += sizeof(ipv6->flow);
 		break;
 	case NET_6LO_IPHC_TF_01:
@@ -859,7 +871,7 @@ static inline uint8_t *uncompress_tfl(uint16_t iphc, uint8_t *cursor,
 		ipv6->tcflow = ((tcl & 0x0F) << 4) | (*cursor & 0x0F);
 		cursor++;
 
-		memmove(&ipv6->flow, cursor, sizeof(ipv6->flow));
+		memcpy(&ipv6->flow, cursor, sizeof(ipv6->flow));
 		cursor += sizeof(ipv6->flow);
 
 		break;
@@ -926,14 +938,14 @@ static inline uint8_t *uncompress_sa(uint16_t iphc, uint8_t *cursor,
 	case NET_6LO_IPHC_SAM_00:
 		NET_DBG("SAM_00 full src addr inlined");
 
-		memmove(ipv6->src.s6_addr, cursor, sizeof(ipv6->src.s6_addr));
+		memcpy(ipv6->src.s6_addr, cursor, sizeof(ipv6->src.s6_addr));
 		cursor += sizeof(ipv6->src.s6_addr);
 
 		break;
 	case NET_6LO_IPHC_SAM_01:
 		NET_DBG("SAM_01 last 64 bits are inlined");
 
-		memmove(&ipv6->src.s6_addr[8], cursor, 8);
+		memcpy(&ipv6->src.s6_addr[8], cursor, 8);
 		cursor += 8U;
 
 		ipv6->src.s6_addr32[0] = 0x00;
@@ -945,7 +957,7 @@ static inline uint8_t *uncompress_sa(uint16_t iphc, uint8_t *cursor,
 	case NET_6LO_IPHC_SAM_10:
 		NET_DBG("SAM_10 src addr 16 bit compressed");
 
-		memmove(&ipv6->src.s6_addr[14], cursor, 2);
+		memcpy(&ipv6->src.s6_addr[14], cursor, 2);
 		cursor += 2U;
 		ipv6->src.s6_addr16[6] = 0x00;
 
@@ -980,10 +992,10 @@ static inline uint8_t *uncompress_sa_ctx(uint16_t iphc, uint8_t *cursor,
 		NET_DBG("SAM_01 last 64 bits are inlined");
 
 		/* First 8 bytes are from context */
-		memmove(&ipv6->src.s6_addr[0], &ctx->prefix.s6_addr[0], 8);
+		memcpy(&ipv6->src.s6_addr[0], &ctx->prefix.s6_addr[0], 8);
 
 		/* And the rest are carried in-line*/
-		memmove(&ipv6->src.s6_addr[8], cursor, 8);
+		memcpy(&ipv6->src.s6_addr[8], cursor, 8);
 		cursor += 8U;
 
 		break;
@@ -991,11 +1003,11 @@ static inline uint8_t *uncompress_sa_ctx(uint16_t iphc, uint8_t *cursor,
 		NET_DBG("SAM_10 src addr 16 bit compressed");
 
 		/* 16 bit carried in-line */
-		memmove(&ipv6->src.s6_addr[14], cursor, 2);
+		memcpy(&ipv6->src.s6_addr[14], cursor, 2);
 		cursor += 2U;
 
 		/* First 8 bytes are from context */
-		memmove(&ipv6->src.s6_addr[0], &ctx->prefix.s6_addr[0], 8);
+		memcpy(&ipv6->src.s6_addr[0], &ctx->prefix.s6_addr[0], 8);
 
 		ipv6->src.s6_addr32[2] = 0x00;
 		ipv6->src.s6_addr16[6] = 0x00;
@@ -1017,7 +1029,7 @@ static inline uint8_t *uncompress_sa_ctx(uint16_t iphc, uint8_t *cursor,
 		 * as link local prefix.
 		 * Overwrite first 8 bytes from context prefix here.
 		 */
-		memmove(&ipv6->src.s6_addr[0], &ctx->prefix.s6_addr[0], 8);
+		memcpy(&ipv6->src.s6_addr[0], &ctx->prefix.s6_addr[0], 8);
 		break;
 	}
 
@@ -1047,7 +1059,7 @@ static inline uint8_t *uncompress_da_mcast(uint16_t iphc, uint8_t *cursor,
 	case NET_6LO_IPHC_DAM_00:
 		NET_DBG("DAM_00 full dst addr inlined");
 
-		memmove(&ipv6->dst.s6_addr[0], cursor,
+		memcpy(&ipv6->dst.s6_addr[0], cursor,
 			sizeof(ipv6->dst.s6_addr));
 
 		cursor += sizeof(ipv6->dst.s6_addr);
@@ -1057,7 +1069,7 @@ static inline uint8_t *uncompress_da_mcast(uint16_t iphc, uint8_t *cursor,
 
 		ipv6->dst.s6_addr[1] = *cursor;
 		cursor++;
-		memmove(&ipv6->dst.s6_addr[11], cursor, 5);
+		memcpy(&ipv6->dst.s6_addr[11], cursor, 5);
 		cursor += 5U;
 
 
@@ -1073,7 +1085,7 @@ static inline uint8_t *uncompress_da_mcast(uint16_t iphc, uint8_t *cursor,
 
 		ipv6->dst.s6_addr[1] = *cursor;
 		cursor++;
-		memmove(&ipv6->dst.s6_addr[13], cursor, 3);
+		memcpy(&ipv6->dst.s6_addr[13], cursor, 3);
 		cursor += 3U;
 
 		ipv6->dst.s6_addr[0] = 0xFF;
@@ -1114,7 +1126,7 @@ static inline uint8_t *uncompress_da(uint16_t iphc, uint8_t *cursor,
 	case NET_6LO_IPHC_DAM_00:
 		NET_DBG("DAM_00 full dst addr inlined");
 
-		memmove(&ipv6->dst.s6_addr[0], cursor,
+		memcpy(&ipv6->dst.s6_addr[0], cursor,
 			sizeof(ipv6->dst.s6_addr));
 		cursor += sizeof(ipv6->dst.s6_addr);
 
@@ -1122,7 +1134,7 @@ static inline uint8_t *uncompress_da(uint16_t iphc, uint8_t *cursor,
 	case NET_6LO_IPHC_DAM_01:
 		NET_DBG("DAM_01 last 64 bits are inlined");
 
-		memmove(&ipv6->dst.s6_addr[8], cursor, 8);
+		memcpy(&ipv6->dst.s6_addr[8], cursor, 8);
 		cursor += 8U;
 
 		ipv6->dst.s6_addr32[0] = 0x00;
@@ -1136,7 +1148,7 @@ static inline uint8_t *uncompress_da(uint16_t iphc, uint8_t *cursor,
 	case NET_6LO_IPHC_DAM_10:
 		NET_DBG("DAM_10 dst addr 16 bit compressed");
 
-		memmove(&ipv6->dst.s6_addr[14], cursor, 2);
+		memcpy(&ipv6->dst.s6_addr[14], cursor, 2);
 		cursor += 2U;
 
 		ipv6->dst.s6_addr32[0] = 0x00;
@@ -1173,22 +1185,22 @@ static inline uint8_t *uncompress_da_ctx(uint16_t iphc, uint8_t *cursor,
 		NET_DBG("DAM_01 last 64 bits are inlined");
 
 		/* Last 8 bytes carried in-line */
-		memmove(&ipv6->dst.s6_addr[8], cursor, 8);
+		memcpy(&ipv6->dst.s6_addr[8], cursor, 8);
 		cursor += 8U;
 
 		/* First 8 bytes are from context */
-		memmove(&ipv6->dst.s6_addr[0], &ctx->prefix.s6_addr[0], 8);
+		memcpy(&ipv6->dst.s6_addr[0], &ctx->prefix.s6_addr[0], 8);
 
 		break;
 	case NET_6LO_IPHC_DAM_10:
 		NET_DBG("DAM_10 src addr 16 bit compressed");
 
 		/* 16 bit carried in-line */
-		memmove(&ipv6->dst.s6_addr[14], cursor, 2);
+		memcpy(&ipv6->dst.s6_addr[14], cursor, 2);
 		cursor += 2U;
 
 		/* First 8 bytes are from context */
-		memmove(&ipv6->dst.s6_addr[0], &ctx->prefix.s6_addr[0], 8);
+		memcpy(&ipv6->dst.s6_addr[0], &ctx->prefix.s6_addr[0], 8);
 
 		ipv6->dst.s6_addr32[2] = 0x00;
 		ipv6->dst.s6_addr16[6] = 0x00;
@@ -1210,7 +1222,7 @@ static inline uint8_t *uncompress_da_ctx(uint16_t iphc, uint8_t *cursor,
 		 * as link local prefix.
 		 * Overwrite first 8 bytes from context prefix here.
 		 */
-		memmove(&ipv6->dst.s6_addr[0], &ctx->prefix.s6_addr[0], 8);
+		memcpy(&ipv6->dst.s6_addr[0], &ctx->prefix.s6_addr[0], 8);
 
 		break;
 	}
@@ -1236,16 +1248,16 @@ static uint8_t *uncompress_nh_udp(uint8_t nhc, uint8_t *cursor,
 	case NET_6LO_NHC_UDP_PORT_00:
 		NET_DBG("src and dst ports are inlined");
 
-		memmove(&udp->src_port, cursor, sizeof(udp->src_port));
+		memcpy(&udp->src_port, cursor, sizeof(udp->src_port));
 		cursor += sizeof(udp->src_port);
-		memmove(&udp->dst_port, cursor, sizeof(udp->dst_port));
+		memcpy(&udp->dst_port, cursor, sizeof(udp->dst_port));
 		cursor += sizeof(udp->dst_port);
 
 		break;
 	case NET_6LO_NHC_UDP_PORT_01:
 		NET_DBG("src full, dst 8 bits inlined");
 
-		memmove(&udp->src_port, cursor, sizeof(udp->src_port));
+		memcpy(&udp->src_port, cursor, sizeof(udp->src_port));
 		cursor += sizeof(udp->src_port);
 		udp->dst_port = htons(((uint16_t)NET_6LO_NHC_UDP_8_BIT_PORT << 8) |
 				*cursor);
@@ -1258,7 +1270,7 @@ static uint8_t *uncompress_nh_udp(uint8_t nhc, uint8_t *cursor,
 		udp->src_port = htons(((uint16_t)NET_6LO_NHC_UDP_8_BIT_PORT << 8) |
 				*cursor);
 		cursor++;
-		memmove(&udp->dst_port, cursor, sizeof(udp->dst_port));
+		memcpy(&udp->dst_port, cursor, sizeof(udp->dst_port));
 		cursor += sizeof(udp->dst_port);
 
 		break;
@@ -1276,7 +1288,7 @@ static uint8_t *uncompress_nh_udp(uint8_t nhc, uint8_t *cursor,
 	}
 
 	if (!(nhc & NET_6LO_NHC_UDP_CHECKSUM)) {
-		memmove(&udp->chksum, cursor, sizeof(udp->chksum));
+		memcpy(&udp->chksum, cursor, sizeof(udp->chksum));
 		cursor += sizeof(udp->chksum);
 	}
 
@@ -1284,90 +1296,116 @@ static uint8_t *uncompress_nh_udp(uint8_t nhc, uint8_t *cursor,
 }
 
 #if defined(CONFIG_NET_6LO_CONTEXT)
-/* Helper function to uncompress src and dst contexts */
+/* Helper function to uncompress src and dst contexts, both are looked up
+ * in one pass over the context table.
+ */
 static inline void uncompress_cid(struct net_pkt *pkt, uint8_t cid,
 				  struct net_6lo_context **src,
 				  struct net_6lo_context **dst)
 {
-	uint8_t cid_tmp;
+	get_6lo_contexts_by_cid(net_pkt_iface(pkt), (cid >> 4) & 0x0F,
+				cid & 0x0F, src, dst);
 
-	/* Extract source and destination Context Index,
-	 * Either src or dest address is context based or both.
-	 */
-	cid_tmp = (cid >> 4) & 0x0F;
-	*src = get_6lo_context_by_cid(net_pkt_iface(pkt), cid_tmp);
 	if (!(*src)) {
-		NET_DBG("Unknown src cid %d", cid_tmp);
+		NET_DBG("Unknown src cid %d", (cid >> 4) & 0x0F);
 	}
 
-	cid_tmp = cid & 0x0F;
-	*dst = get_6lo_context_by_cid(net_pkt_iface(pkt), cid_tmp);
 	if (!(*dst)) {
-		NET_DBG("Unknown dst cid %d", cid_tmp);
+		NET_DBG("Unknown dst cid %d", cid & 0x0F);
 	}
 }
 #endif
 
-static bool uncompress_IPHC_header(struct net_pkt *pkt)
+/* Size of the compressed IPHC and UDP NHC headers at the beginning of
+ * data, and how much bigger they get once uncompressed. Everything is
+ * looked up from the inline size tables, nothing is parsed twice.
+ */
+static bool get_iphc_hdr_sizes(const uint8_t *data, size_t len,
+			       int *compressed_hdr_size, int *diff)
 {
-	struct net_udp_hdr *udp = NULL;
-	struct net_buf *frag = NULL;
-	uint8_t nhc = 0;
-	int nhc_inline_size = 0;
-	struct net_ipv6_hdr *ipv6;
-	uint16_t len;
+	int inline_size, nhc_inline_size;
 	uint16_t iphc;
-	int inline_size, compressed_hdr_size;
-	size_t diff;
-	uint8_t *cursor;
-#if defined(CONFIG_NET_6LO_CONTEXT)
-	struct net_6lo_context *src = NULL;
-	struct net_6lo_context *dst = NULL;
-#endif
+	uint8_t nhc;
+
+	if (len < sizeof(iphc)) {
+		return false;
+	}
 
-	iphc = ntohs(UNALIGNED_GET((uint16_t *)pkt->buffer->data));
+	iphc = sys_get_be16(data);
 
 	inline_size = get_ihpc_inlined_size(iphc);
 	if (inline_size < 0) {
 		return false;
 	}
 
-	compressed_hdr_size = sizeof(iphc) + inline_size;
-	diff = sizeof(struct net_ipv6_hdr) - compressed_hdr_size;
+	*compressed_hdr_size = sizeof(iphc) + inline_size;
+	*diff = sizeof(struct net_ipv6_hdr) - *compressed_hdr_size;
 
 	if (iphc & NET_6LO_IPHC_NH_MASK) {
-		nhc = *(pkt->buffer->data + sizeof(iphc) + inline_size);
+		if (len <= *compressed_hdr_size) {
+			return false;
+		}
+
+		nhc = data[*compressed_hdr_size];
 		if ((nhc & 0xF8) != NET_6LO_NHC_UDP_BARE) {
 			NET_ERR("Unsupported next header");
 			return false;
 		}
 
 		nhc_inline_size = get_udp_nhc_inlined_size(nhc);
-		compressed_hdr_size += sizeof(uint8_t) + nhc_inline_size;
-		diff += sizeof(struct net_udp_hdr) - sizeof(uint8_t) -
-			nhc_inline_size;
+		*compressed_hdr_size += sizeof(uint8_t) + nhc_inline_size;
+		*diff += sizeof(struct net_udp_hdr) - sizeof(uint8_t) -
+			 nhc_inline_size;
 	}
 
-	if (net_buf_tailroom(pkt->buffer) >= diff) {
-		NET_DBG("Enough tailroom. Uncompress inplace");
-		frag = pkt->buffer;
-		net_buf_add(frag, diff);
-		cursor = frag->data + diff;
-		memmove(cursor, frag->data, frag->len - diff);
-	} else {
-		NET_DBG("Not enough tailroom. Get new fragment");
-		cursor =  pkt->buffer->data;
-		frag = net_pkt_get_frag(pkt, NET_6LO_RX_PKT_TIMEOUT);
-		if (!frag) {
-			NET_ERR("Can't get frag for uncompression");
-			return false;
-		}
+	if (len < *compressed_hdr_size) {
+		NET_DBG("Compressed header %d does not fit %zd bytes",
+			*compressed_hdr_size, len);
+		return false;
+	}
 
-		net_buf_pull(pkt->buffer, compressed_hdr_size);
-		net_buf_add(frag, nhc ? NET_IPV6UDPH_LEN : NET_IPV6H_LEN);
+	return true;
+}
+
+/* The uncompressed headers are first written in one pass to a local
+ * buffer, then put in place of the compressed ones. This is done in the
+ * first buffer when the headers are not larger than the compressed ones,
+ * or when its tailroom holds the difference, in which case only the rest
+ * of that buffer is moved. A buffer is only allocated for the headers
+ * otherwise. The link layer header found in the headroom of the first
+ * buffer is kept intact in all cases.
+ */
+static bool uncompress_IPHC_header(struct net_pkt *pkt)
+{
+	struct {
+		struct net_ipv6_hdr ipv6;
+		struct net_udp_hdr udp;
+	} __packed hdr;
+	struct net_ipv6_hdr *ipv6 = &hdr.ipv6;
+	struct net_udp_hdr *udp = NULL;
+	struct net_buf *buf = pkt->buffer;
+	uint8_t nhc = 0;
+	uint16_t len;
+	uint16_t iphc;
+	int compressed_hdr_size;
+	int hdr_len;
+	uint8_t *cursor;
+	int diff;
+#if defined(CONFIG_NET_6LO_CONTEXT)
+	struct net_6lo_context *src = NULL;
+	struct net_6lo_context *dst = NULL;
+#endif
+
+	cursor = buf->data;
+
+	if (!get_iphc_hdr_sizes(cursor, buf->len,
+				&compressed_hdr_size, &diff)) {
+		return false;
 	}
 
-	ipv6 = (struct net_ipv6_hdr *)(frag->data);
+	iphc = sys_get_be16(cursor);
+	hdr_len = (iphc & NET_6LO_IPHC_NH_MASK) ? NET_IPV6UDPH_LEN :
+		NET_IPV6H_LEN;
 	cursor += sizeof(iphc);
 
 	if (iphc & NET_6LO_IPHC_CID_1) {
@@ -1376,7 +1414,7 @@ static bool uncompress_IPHC_header(struct net_pkt *pkt)
 		cursor++;
 #else
 		NET_ERR("Context based uncompression not enabled");
-		return false;
+		goto fail;
 #endif
 	}
 
@@ -1451,27 +1489,49 @@ static bool uncompress_IPHC_header(struct net_pkt *pkt)
 
 	if (iphc & NET_6LO_IPHC_NH_MASK) {
 		ipv6->nexthdr = IPPROTO_UDP;
-		udp = (struct net_udp_hdr *)(frag->data + NET_IPV6H_LEN);
-		/* skip nhc */
+		udp = &hdr.udp;
+		nhc = *cursor;
 		cursor++;
 		cursor = uncompress_nh_udp(nhc, cursor, udp);
 	}
 
-	if (frag != pkt->buffer) {
-		/* Insert the fragment (this one holds uncompressed headers) */
-		net_pkt_frag_insert(pkt, frag);
-	}
+	NET_ASSERT(cursor == buf->data + compressed_hdr_size);
 
 	/* Set IPv6 header and UDP (if next header is) length */
-	len = net_pkt_get_len(pkt) - NET_IPV6H_LEN;
+	len = net_pkt_get_len(pkt) + diff - NET_IPV6H_LEN;
 	ipv6->len = htons(len);
 
-	if (ipv6->nexthdr == IPPROTO_UDP && udp) {
+	if (udp) {
 		udp->len = htons(len);
+	}
 
-		if (nhc & NET_6LO_NHC_UDP_CHECKSUM) {
-			udp->chksum = net_calc_chksum_udp(pkt);
+	if (diff <= 0) {
+		NET_DBG("Uncompress in place");
+		net_buf_pull(buf, -diff);
+	} else if (net_buf_tailroom(buf) >= (size_t)diff) {
+		NET_DBG("Enough tailroom. Uncompress in place");
+		net_buf_add(buf, diff);
+		memmove(buf->data + hdr_len, buf->data + compressed_hdr_size,
+			buf->len - hdr_len);
+	} else {
+		NET_DBG("Not enough tailroom. Get new fragment");
+		buf = net_pkt_get_frag(pkt, NET_6LO_RX_PKT_TIMEOUT);
+		if (!buf) {
+			NET_ERR("Can't get frag for uncompression");
+			return false;
 		}
+
+		net_buf_pull(pkt->buffer, compressed_hdr_size);
+		net_buf_add(buf, hdr_len);
+		net_pkt_frag_insert(pkt, buf);
+	}
+
+	memcpy(buf->data, &hdr, hdr_len);
+
+	if (udp && (nhc & NET_6LO_NHC_UDP_CHECKSUM)) {
+		udp = (struct net_udp_hdr *)(buf->data + NET_IPV6H_LEN);
+		udp->chksum = 0U;
+		udp->chksum = net_calc_chksum_udp(pkt);
 	}
 
 	net_pkt_cursor_init(pkt);
@@ -1479,10 +1539,6 @@ static bool uncompress_IPHC_header(struct net_pkt *pkt)
 	return true;
 
 fail:
-	if (frag != pkt->buffer) {
-		net_pkt_frag_unref(frag);
-	}
-
 	return false;
 }
 
@@ -1491,6 +1547,11 @@ static inline int compress_ipv6_header(struct net_pkt *pkt)
 {
 	struct net_buf *buffer = pkt->buffer;
 
+	if (net_buf_headroom(buffer) >= 1U) {
+		*(uint8_t *)net_buf_push(buffer, 1U) = NET_6LO_DISPATCH_IPV6;
+		return 0;
+	}
+
 	if (net_buf_tailroom(buffer) >= 1U) {
 		memmove(buffer->data + 1U, buffer->data, buffer->len);
 		net_buf_add(buffer, 1U);
@@ -1554,9 +1615,8 @@ bool net_6lo_uncompress(struct net_pkt *pkt)
 
 int net_6lo_uncompress_hdr_diff(struct net_pkt *pkt)
 {
-	int inline_size, compressed_hdr_size, nhc_inline_size, diff;
-	uint16_t iphc;
-	uint8_t nhc;
+	int compressed_hdr_size;
+	int diff;
 
 	if (pkt->frags->data[0] == NET_6LO_DISPATCH_IPV6) {
 		return -1;
@@ -1567,28 +1627,10 @@ int net_6lo_uncompress_hdr_diff(struct net_pkt *pkt)
 		return 0;
 	}
 
-	iphc = ntohs(UNALIGNED_GET((uint16_t *)pkt->buffer->data));
-
-	inline_size = get_ihpc_inlined_size(iphc);
-	if (inline_size < 0) {
+	if (!get_iphc_hdr_sizes(pkt->buffer->data, pkt->buffer->len,
+				&compressed_hdr_size, &diff)) {
 		return INT_MAX;
 	}
 
-	compressed_hdr_size = sizeof(iphc) + inline_size;
-	diff = sizeof(struct net_ipv6_hdr) - compressed_hdr_size;
-
-	if (iphc & NET_6LO_IPHC_NH_MASK) {
-		nhc = *(pkt->buffer->data + sizeof(iphc) + inline_size);
-		if ((nhc & 0xF8) != NET_6LO_NHC_UDP_BARE) {
-			NET_ERR("Unsupported next header");
-			return INT_MAX;
-		}
-
-		nhc_inline_size = get_udp_nhc_inlined_size(nhc);
-		compressed_hdr_size += sizeof(uint8_t) + nhc_inline_size;
-		diff += sizeof(struct net_udp_hdr) - sizeof(uint8_t) -
-			nhc_inline_size;
-	}
-
 	return diff;
 }
@@ -47,8 +47,8 @@ static inline int net_6lo_compress(struct net_pkt *pkt, bool iphc)
  *  @brief Uncompress IPv6 packet as per RFC 6282
  *
  *  @details After this IPv6 packet and next header(if UDP), headers
- *  are uncompressed as per RFC 6282. After header uncompression data
- *  will be adjusted according to remaining space in fragments.
+ *  are uncompressed as per RFC 6282. The uncompressed headers are put
+ *  in a new fragment in front of the packet data, which is not moved.
  *
  *  @param Pointer to network packet
  *
@@ -0,0 +1,833 @@
+/** @file
+ * @brief Network packet capture
+ *
+ * Store the IP packets matching a filter in a ring buffer, and export them
+ * in the pcapng format.
+ */
+
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_capture, CONFIG_NET_CAPTURE_LOG_LEVEL);
+
+#include <kernel.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <sys/byteorder.h>
+
+#include <net/net_if.h>
+#include <net/net_core.h>
+#include <net/net_pkt.h>
+#include <net/capture.h>
+
+#if defined(CONFIG_NET_SOCKETS)
+#include <net/socket.h>
+#endif
+
+#if defined(CONFIG_FILE_SYSTEM)
+#include <fs/fs.h>
+#endif
+
+#include "capture.h"
+
+#define CAPTURE_SLOTS CONFIG_NET_CAPTURE_SLOTS
+#define CAPTURE_SNAPLEN CONFIG_NET_CAPTURE_SNAPLEN
+
+BUILD_ASSERT((CAPTURE_SLOTS & (CAPTURE_SLOTS - 1)) == 0,
+	     "CONFIG_NET_CAPTURE_SLOTS must be a power of two");
+
+/* Enough for an IPv4 header with options, or an IPv6 header, and the
+ * ports of the transport header.
+ */
+#define CAPTURE_HDR_LEN 64
+
+enum capture_op {
+	OP_IPV4,
+	OP_IPV6,
+	OP_PROTO,
+	OP_PORT,
+	OP_HOST4,
+	OP_HOST6,
+	OP_DIR,
+	OP_NOT,
+	OP_AND,
+	OP_OR,
+};
+
+#define NET_CAPTURE_SRC BIT(0)
+#define NET_CAPTURE_DST BIT(1)
+
+/* Fields of the packet the filter looks at */
+struct capture_hdr {
+	const uint8_t *src;
+	const uint8_t *dst;
+	uint16_t src_port;
+	uint16_t dst_port;
+	uint8_t version;
+	uint8_t proto;
+	bool has_ports;
+};
+
+/* Slot of the ring buffer, filled by the thread which reserved it and
+ * released to the exporter by setting seq.
+ */
+struct capture_slot {
+	atomic_t seq;
+	uint64_t timestamp;
+	uint32_t orig_len;
+	uint16_t cap_len;
+	uint8_t iface;
+	uint8_t dir;
+	uint8_t data[CAPTURE_SNAPLEN];
+};
+
+atomic_t net_capture_enabled;
+
+/* The filter and the interface are only changed while capturing is
+ * disabled and no thread is storing a packet, which users counts.
+ */
+static struct net_capture_filter capture_filter;
+static struct net_if *capture_iface;
+static atomic_t users;
+
+static struct capture_slot slots[CAPTURE_SLOTS];
+static atomic_t head;
+static atomic_t tail;
+
+static atomic_t captured;
+static atomic_t filtered;
+static atomic_t dropped;
+
+static K_MUTEX_DEFINE(export_lock);
+
+/* pcapng block types and constants */
+#define PCAPNG_SHB 0x0A0D0D0A
+#define PCAPNG_IDB 0x00000001
+#define PCAPNG_EPB 0x00000006
+#define PCAPNG_MAGIC 0x1A2B3C4D
+#define PCAPNG_LINKTYPE_RAW 101
+#define PCAPNG_EPB_FLAGS 2
+
+struct pcapng_shb {
+	uint32_t type;
+	uint32_t len;
+	uint32_t magic;
+	uint16_t major;
+	uint16_t minor;
+	int64_t section_len;
+	uint32_t len_end;
+} __packed;
+
+struct pcapng_idb {
+	uint32_t type;
+	uint32_t len;
+	uint16_t linktype;
+	uint16_t reserved;
+	uint32_t snaplen;
+	uint32_t len_end;
+} __packed;
+
+struct pcapng_epb {
+	uint32_t type;
+	uint32_t len;
+	uint32_t iface;
+	uint32_t ts_high;
+	uint32_t ts_low;
+	uint32_t cap_len;
+	uint32_t orig_len;
+} __packed;
+
+/* Packet data, then the epb_flags and end of options options, then the
+ * block length again.
+ */
+#define EPB_OPTIONS_LEN 12
+#define EPB_MAX_LEN (sizeof(struct pcapng_epb) + ROUND_UP(CAPTURE_SNAPLEN, 4) + \
+		     EPB_OPTIONS_LEN + sizeof(uint32_t))
+
+static uint32_t epb_buf[EPB_MAX_LEN / sizeof(uint32_t)];
+
+static size_t pkt_copy(struct net_pkt *pkt, uint8_t *dst, size_t len)
+{
+	struct net_buf *buf;
+	size_t copied = 0;
+
+	for (buf = pkt->buffer; buf && copied < len; buf = buf->frags) {
+		size_t frag_len = MIN(buf->len, len - copied);
+
+		memcpy(dst + copied, buf->data, frag_len);
+		copied += frag_len;
+	}
+
+	return copied;
+}
+
+static void parse_hdr(const uint8_t *data, size_t len, struct capture_hdr *hdr)
+{
+	size_t l4 = 0;
+
+	memset(hdr, 0, sizeof(*hdr));
+
+	if (len < 1) {
+		return;
+	}
+
+	switch (data[0] & 0xf0) {
+	case 0x40:
+		if (len < NET_IPV4H_LEN) {
+			return;
+		}
+
+		hdr->version = 4U;
+		hdr->proto = data[9];
+		hdr->src = &data[12];
+		hdr->dst = &data[16];
+
+		/* Only the first fragment has the transport header */
+		if ((sys_get_be16(&data[6]) & 0x1fff) == 0U) {
+			l4 = (data[0] & 0x0f) * 4U;
+		}
+
+		break;
+	case 0x60:
+		if (len < NET_IPV6H_LEN) {
+			return;
+		}
+
+		hdr->version = 6U;
+		hdr->proto = data[6];
+		hdr->src = &data[8];
+		hdr->dst = &data[24];
+		l4 = NET_IPV6H_LEN;
+		break;
+	default:
+		return;
+	}
+
+	if ((hdr->proto == IPPROTO_TCP || hdr->proto == IPPROTO_UDP) &&
+	    l4 > 0 && len >= l4 + 4) {
+		hdr->has_ports = true;
+		hdr->src_port = sys_get_be16(&data[l4]);
+		hdr->dst_port = sys_get_be16(&data[l4 + 2]);
+	}
+}
+
+static bool match_addr(const struct capture_hdr *hdr,
+		       const struct net_capture_insn *insn,
+		       const void *addr, size_t len)
+{
+	return ((insn->flags & NET_CAPTURE_SRC) &&
+		memcmp(hdr->src, addr, len) == 0) ||
+	       ((insn->flags & NET_CAPTURE_DST) &&
+		memcmp(hdr->dst, addr, len) == 0);
+}
+
+static bool filter_eval(const struct net_capture_filter *filter,
+			const struct capture_hdr *hdr,
+			enum net_capture_dir dir)
+{
+	bool stack[CONFIG_NET_CAPTURE_FILTER_MAX_INSNS];
+	int sp = 0;
+	int i;
+
+	if (filter->len == 0U) {
+		return true;
+	}
+
+	for (i = 0; i < filter->len; i++) {
+		const struct net_capture_insn *insn = &filter->insns[i];
+		bool result = false;
+
+		switch (insn->op) {
+		case OP_IPV4:
+			result = hdr->version == 4U;
+			break;
+		case OP_IPV6:
+			result = hdr->version == 6U;
+			break;
+		case OP_PROTO:
+			result = hdr->version && hdr->proto == insn->value;
+			break;
+		case OP_PORT:
+			result = hdr->has_ports &&
+				 (((insn->flags & NET_CAPTURE_SRC) &&
+				   hdr->src_port == insn->value) ||
+				  ((insn->flags & NET_CAPTURE_DST) &&
+				   hdr->dst_port == insn->value));
+			break;
+		case OP_HOST4:
+			result = hdr->version == 4U &&
+				 match_addr(hdr, insn, &insn->addr,
+					    sizeof(struct in_addr));
+			break;
+#if defined(CONFIG_NET_IPV6)
+		case OP_HOST6:
+			result = hdr->version == 6U &&
+				 match_addr(hdr, insn, &insn->addr,
+					    sizeof(struct in6_addr));
+			break;
+#endif
+		case OP_DIR:
+			result = insn->value == dir;
+			break;
+		case OP_NOT:
+			stack[sp - 1] = !stack[sp - 1];
+			continue;
+		case OP_AND:
+			sp--;
+			stack[sp - 1] = stack[sp - 1] && stack[sp];
+			continue;
+		case OP_OR:
+			sp--;
+			stack[sp - 1] = stack[sp - 1] || stack[sp];
+			continue;
+		}
+
+		stack[sp++] = result;
+	}
+
+	return stack[0];
+}
+
+bool net_capture_filter_match(const struct net_capture_filter *filter,
+			      struct net_pkt *pkt, enum net_capture_dir dir)
+{
+	uint8_t data[CAPTURE_HDR_LEN];
+	struct capture_hdr hdr;
+
+	parse_hdr(data, pkt_copy(pkt, data, sizeof(data)), &hdr);
+
+	return filter_eval(filter, &hdr, dir);
+}
+
+/* Recursive descent compiler of the filter expressions, emitting the
+ * instructions in postfix order.
+ */
+struct compiler {
+	struct net_capture_filter *filter;
+	const char *pos;
+	char tok[NET_IPV6_ADDR_LEN];
+	int depth;
+	int err;
+};
+
+static void next_token(struct compiler *c)
+{
+	const char *start;
+	size_t len;
+
+	while (isspace((unsigned char)*c->pos)) {
+		c->pos++;
+	}
+
+	start = c->pos;
+
+	if (*c->pos == '(' || *c->pos == ')' || *c->pos == '!') {
+		c->pos++;
+	} else if ((*c->pos == '&' || *c->pos == '|') &&
+		   c->pos[1] == *c->pos) {
+		c->pos += 2;
+	} else {
+		while (*c->pos && !isspace((unsigned char)*c->pos) &&
+		       !strchr("()!&|", *c->pos)) {
+			c->pos++;
+		}
+	}
+
+	len = c->pos - start;
+	if (len >= sizeof(c->tok)) {
+		c->err = -EINVAL;
+		len = 0;
+	}
+
+	memcpy(c->tok, start, len);
+	c->tok[len] = '\0';
+}
+
+static bool accept_token(struct compiler *c, const char *tok)
+{
+	if (strcmp(c->tok, tok) != 0) {
+		return false;
+	}
+
+	next_token(c);
+
+	return true;
+}
+
+static struct net_capture_insn *emit(struct compiler *c, uint8_t op)
+{
+	struct net_capture_insn *insn;
+
+	if (c->filter->len >= ARRAY_SIZE(c->filter->insns)) {
+		if (!c->err) {
+			c->err = -ENOMEM;
+		}
+
+		return NULL;
+	}
+
+	insn = &c->filter->insns[c->filter->len++];
+	memset(insn, 0, sizeof(*insn));
+	insn->op = op;
+
+	/* Operands push a result, operators pop one or leave it */
+	if (op < OP_NOT) {
+		c->depth++;
+	} else if (op != OP_NOT) {
+		c->depth--;
+	}
+
+	return insn;
+}
+
+static void compile_or(struct compiler *c);
+
+static void compile_primary(struct compiler *c)
+{
+	static const struct {
+		const char *name;
+		uint8_t op;
+		uint16_t value;
+	} keywords[] = {
+		{ "ip", OP_IPV4, 0 },
+		{ "ip6", OP_IPV6, 0 },
+		{ "tcp", OP_PROTO, IPPROTO_TCP },
+		{ "udp", OP_PROTO, IPPROTO_UDP },
+		{ "icmp", OP_PROTO, IPPROTO_ICMP },
+		{ "icmp6", OP_PROTO, IPPROTO_ICMPV6 },
+		{ "in", OP_DIR, NET_CAPTURE_IN },
+		{ "out", OP_DIR, NET_CAPTURE_OUT },
+	};
+	struct net_capture_insn *insn;
+	uint8_t flags = NET_CAPTURE_SRC | NET_CAPTURE_DST;
+	char *end;
+	long port;
+	int i;
+
+	if (accept_token(c, "(")) {
+		compile_or(c);
+
+		if (!accept_token(c, ")")) {
+			c->err = -EINVAL;
+		}
+
+		return;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(keywords); i++) {
+		if (accept_token(c, keywords[i].name)) {
+			insn = emit(c, keywords[i].op);
+			if (insn) {
+				insn->value = keywords[i].value;
+			}
+
+			return;
+		}
+	}
+
+	if (accept_token(c, "src")) {
+		flags = NET_CAPTURE_SRC;
+	} else if (accept_token(c, "dst")) {
+		flags = NET_CAPTURE_DST;
+	}
+
+	if (accept_token(c, "port")) {
+		port = strtol(c->tok, &end, 10);
+		if (*end || end == c->tok || port < 0 || port > UINT16_MAX) {
+			c->err = -EINVAL;
+			return;
+		}
+
+		insn = emit(c, OP_PORT);
+		if (insn) {
+			insn->flags = flags;
+			insn->value = port;
+		}
+
+		next_token(c);
+		return;
+	}
+
+	if (accept_token(c, "host")) {
+		struct in_addr in;
+#if defined(CONFIG_NET_IPV6)
+		struct in6_addr in6;
+#endif
+
+		if (net_addr_pton(AF_INET, c->tok, &in) == 0) {
+			insn = emit(c, OP_HOST4);
+			if (insn) {
+				insn->flags = flags;
+				net_ipaddr_copy(&insn->addr.in, &in);
+			}
+#if defined(CONFIG_NET_IPV6)
+		} else if (net_addr_pton(AF_INET6, c->tok, &in6) == 0) {
+			insn = emit(c, OP_HOST6);
+			if (insn) {
+				insn->flags = flags;
+				net_ipaddr_copy(&insn->addr.in6, &in6);
+			}
+#endif
+		} else {
+			c->err = -EINVAL;
+			return;
+		}
+
+		next_token(c);
+		return;
+	}
+
+	c->err = -EINVAL;
+}
+
+static void compile_not(struct compiler *c)
+{
+	if (accept_token(c, "not") || accept_token(c, "!")) {
+		compile_not(c);
+		emit(c, OP_NOT);
+		return;
+	}
+
+	compile_primary(c);
+}
+
+static void compile_and(struct compiler *c)
+{
+	compile_not(c);
+
+	while (!c->err && (accept_token(c, "and") || accept_token(c, "&&"))) {
+		compile_not(c);
+		emit(c, OP_AND);
+	}
+}
+
+static void compile_or(struct compiler *c)
+{
+	compile_and(c);
+
+	while (!c->err && (accept_token(c, "or") || accept_token(c, "||"))) {
+		compile_and(c);
+		emit(c, OP_OR);
+	}
+}
+
+int net_capture_filter_compile(struct net_capture_filter *filter,
+			       const char *expr)
+{
+	struct compiler c = {
+		.filter = filter,
+		.pos = expr ? expr : "",
+	};
+
+	filter->len = 0U;
+
+	next_token(&c);
+	if (c.tok[0] == '\0') {
+		return c.err;
+	}
+
+	compile_or(&c);
+
+	if (!c.err && (c.tok[0] != '\0' || c.depth != 1)) {
+		c.err = -EINVAL;
+	}
+
+	if (c.err) {
+		filter->len = 0U;
+	}
+
+	return c.err;
+}
+
+static void capture_store(struct net_if *iface, struct net_pkt *pkt,
+			  enum net_capture_dir dir)
+{
+	struct capture_slot *slot;
+	atomic_val_t h;
+
+	if (capture_iface && capture_iface != iface) {
+		return;
+	}
+
+	if (capture_filter.len > 0U &&
+	    !net_capture_filter_match(&capture_filter, pkt, dir)) {
+		atomic_inc(&filtered);
+		return;
+	}
+
+	/* Reserve a slot, several threads can capture at the same time */
+	do {
+		h = atomic_get(&head);
+		if ((uint32_t)(h - atomic_get(&tail)) >= CAPTURE_SLOTS) {
+			atomic_inc(&dropped);
+			return;
+		}
+	} while (!atomic_cas(&head, h, h + 1));
+
+	slot = &slots[h & (CAPTURE_SLOTS - 1)];
+
+	slot->timestamp = k_ticks_to_us_floor64(k_uptime_ticks());
+	slot->orig_len = net_pkt_get_len(pkt);
+	slot->cap_len = pkt_copy(pkt, slot->data, sizeof(slot->data));
+	slot->iface = net_if_get_by_iface(iface);
+	slot->dir = dir;
+
+	atomic_inc(&captured);
+
+	/* Release the slot to the exporter */
+	atomic_set(&slot->seq, h + 1);
+}
+
+void net_capture_pkt_store(struct net_if *iface, struct net_pkt *pkt,
+			   enum net_capture_dir dir)
+{
+	atomic_inc(&users);
+
+	/* Capturing may have been disabled to change the filter */
+	if (atomic_get(&net_capture_enabled)) {
+		capture_store(iface, pkt, dir);
+	}
+
+	atomic_dec(&users);
+}
+
+int net_capture_start(struct net_if *iface, const char *expr)
+{
+	struct net_capture_filter filter;
+	int ret;
+
+	ret = net_capture_filter_compile(&filter, expr);
+	if (ret < 0) {
+		return ret;
+	}
+
+	atomic_clear(&net_capture_enabled);
+
+	/* Wait for the threads still using the previous filter */
+	while (atomic_get(&users) != 0) {
+		k_sleep(K_MSEC(1));
+	}
+
+	memcpy(&capture_filter, &filter, sizeof(capture_filter));
+	capture_iface = iface;
+
+	atomic_clear(&captured);
+	atomic_clear(&filtered);
+	atomic_clear(&dropped);
+
+	atomic_set(&net_capture_enabled, 1);
+
+	NET_DBG("Capture started (%d instructions)", filter.len);
+
+	return 0;
+}
+
+void net_capture_stop(void)
+{
+	atomic_clear(&net_capture_enabled);
+}
+
+bool net_capture_is_active(void)
+{
+	return atomic_get(&net_capture_enabled) != 0;
+}
+
+void net_capture_get_stats(struct net_capture_stats *stats)
+{
+	stats->captured = atomic_get(&captured);
+	stats->filtered = atomic_get(&filtered);
+	stats->dropped = atomic_get(&dropped);
+}
+
+static int write_header(net_capture_write_cb_t cb, void *user_data)
+{
+	struct pcapng_shb shb = {
+		.type = PCAPNG_SHB,
+		.len = sizeof(shb),
+		.magic = PCAPNG_MAGIC,
+		.major = 1U,
+		.minor = 0U,
+		.section_len = -1,
+		.len_end = sizeof(shb),
+	};
+	struct pcapng_idb idb = {
+		.type = PCAPNG_IDB,
+		.len = sizeof(idb),
+		.linktype = PCAPNG_LINKTYPE_RAW,
+		.snaplen = CAPTURE_SNAPLEN,
+		.len_end = sizeof(idb),
+	};
+	int ret;
+	int i;
+
+	ret = cb(&shb, sizeof(shb), user_data);
+	if (ret < 0) {
+		return ret;
+	}
+
+	/* The interface index minus one is the pcapng interface id */
+	for (i = 1; net_if_get_by_index(i); i++) {
+		ret = cb(&idb, sizeof(idb), user_data);
+		if (ret < 0) {
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+static size_t build_epb(const struct capture_slot *slot)
+{
+	struct pcapng_epb *epb = (struct pcapng_epb *)epb_buf;
+	uint8_t *data = (uint8_t *)(epb + 1);
+	size_t data_len = ROUND_UP(slot->cap_len, 4);
+	size_t len = sizeof(*epb) + data_len + EPB_OPTIONS_LEN +
+		     sizeof(uint32_t);
+	uint32_t *options = (uint32_t *)(data + data_len);
+
+	epb->type = PCAPNG_EPB;
+	epb->len = len;
+	epb->iface = slot->iface - 1;
+	epb->ts_high = slot->timestamp >> 32;
+	epb->ts_low = (uint32_t)slot->timestamp;
+	epb->cap_len = slot->cap_len;
+	epb->orig_len = slot->orig_len;
+
+	memcpy(data, slot->data, slot->cap_len);
+	memset(data + slot->cap_len, 0, data_len - slot->cap_len);
+
+	/* epb_flags: inbound is 1 and outbound is 2, as in the enum */
+	options[0] = PCAPNG_EPB_FLAGS | (sizeof(uint32_t) << 16);
+	options[1] = slot->dir;
+	options[2] = 0U;
+	options[3] = len;
+
+	return len;
+}
+
+int net_capture_export(net_capture_write_cb_t cb, void *user_data,
+		       bool header)
+{
+	struct capture_slot *slot;
+	atomic_val_t t;
+	int count = 0;
+	int ret = 0;
+
+	k_mutex_lock(&export_lock, K_FOREVER);
+
+	if (header) {
+		ret = write_header(cb, user_data);
+		if (ret < 0) {
+			goto out;
+		}
+	}
+
+	t = atomic_get(&tail);
+
+	while (t != atomic_get(&head)) {
+		slot = &slots[t & (CAPTURE_SLOTS - 1)];
+
+		/* Reserved but still being filled */
+		if (atomic_get(&slot->seq) != t + 1) {
+			break;
+		}
+
+		ret = cb(epb_buf, build_epb(slot), user_data);
+		if (ret < 0) {
+			goto out;
+		}
+
+		/* Give the slot back to the producers */
+		atomic_set(&tail, ++t);
+		count++;
+	}
+
+	ret = count;
+
+out:
+	k_mutex_unlock(&export_lock);
+
+	return ret;
+}
+
+#if defined(CONFIG_NET_SOCKETS)
+static int write_socket(const void *data, size_t len, void *user_data)
+{
+	int sock = POINTER_TO_INT(user_data);
+	const uint8_t *pos = data;
+	ssize_t ret;
+
+	while (len > 0) {
+		ret = zsock_send(sock, pos, len, 0);
+		if (ret < 0) {
+			return -errno;
+		}
+
+		pos += ret;
+		len -= ret;
+	}
+
+	return 0;
+}
+
+int net_capture_export_socket(int sock, bool header)
+{
+	return net_capture_export(write_socket, INT_TO_POINTER(sock), header);
+}
+#else
+int net_capture_export_socket(int sock, bool header)
+{
+	ARG_UNUSED(sock);
+	ARG_UNUSED(header);
+
+	return -ENOTSUP;
+}
+#endif /* CONFIG_NET_SOCKETS */
+
+#if defined(CONFIG_FILE_SYSTEM)
+static int write_file(const void *data, size_t len, void *user_data)
+{
+	ssize_t ret;
+
+	ret = fs_write(user_data, data, len);
+	if (ret < 0) {
+		return ret;
+	}
+
+	return ret == len ? 0 : -ENOSPC;
+}
+
+int net_capture_export_file(const char *path)
+{
+	struct fs_file_t file;
+	int ret;
+
+	(void)fs_unlink(path);
+
+	memset(&file, 0, sizeof(file));
+
+	ret = fs_open(&file, path);
+	if (ret < 0) {
+		return ret;
+	}
+
+	ret = net_capture_export(write_file, &file, true);
+
+	fs_close(&file);
+
+	return ret;
+}
+#else
+int net_capture_export_file(const char *path)
+{
+	ARG_UNUSED(path);
+
+	return -ENOTSUP;
+}
+#endif /* CONFIG_FILE_SYSTEM */
@@ -0,0 +1,48 @@
+/** @file
+ * @brief Packet capture hooks of the network stack
+ *
+ * This is not to be included by the application.
+ */
+
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __CAPTURE_H
+#define __CAPTURE_H
+
+#include <kernel.h>
+
+#include <net/net_if.h>
+#include <net/net_pkt.h>
+#include <net/capture.h>
+
+#if defined(CONFIG_NET_CAPTURE)
+extern atomic_t net_capture_enabled;
+
+void net_capture_pkt_store(struct net_if *iface, struct net_pkt *pkt,
+			   enum net_capture_dir dir);
+
+/* Called with every IP packet sent or received, keep it cheap when the
+ * capture is not running.
+ */
+static inline void net_capture_pkt(struct net_if *iface, struct net_pkt *pkt,
+				   enum net_capture_dir dir)
+{
+	if (unlikely(atomic_get(&net_capture_enabled))) {
+		net_capture_pkt_store(iface, pkt, dir);
+	}
+}
+#else
+static inline void net_capture_pkt(struct net_if *iface, struct net_pkt *pkt,
+				   enum net_capture_dir dir)
+{
+	ARG_UNUSED(iface);
+	ARG_UNUSED(pkt);
+	ARG_UNUSED(dir);
+}
+#endif /* CONFIG_NET_CAPTURE */
+
+#endif /* __CAPTURE_H */
@@ -68,6 +68,7 @@ int net_ipv4_finalize(struct net_pkt *pkt, uint8_t next_header_proto)
 	NET_PKT_DATA_ACCESS_CONTIGUOUS_DEFINE(ipv4_access, struct net_ipv4_hdr);
 	struct net_ipv4_hdr *ipv4_hdr;
 
+	net_pkt_set_tx_stats_tick(pkt, NET_STATS_TX_DETAIL_IP);
 	net_pkt_set_overwrite(pkt, true);
 
 	ipv4_hdr = (struct net_ipv4_hdr *)net_pkt_get_data(pkt, &ipv4_access);
@@ -210,6 +211,7 @@ enum net_verdict net_ipv4_input(struct net_pkt *pkt)
 	uint8_t opts_len;
 	int pkt_len;
 
+	net_pkt_set_rx_stats_tick(pkt, NET_STATS_RX_DETAIL_IP);
 	net_stats_update_ipv4_recv(net_pkt_iface(pkt));
 
 	hdr = (struct net_ipv4_hdr *)net_pkt_get_data(pkt, &ipv4_access);
@@ -291,6 +293,19 @@ enum net_verdict net_ipv4_input(struct net_pkt *pkt)
 
 	net_pkt_set_family(pkt, PF_INET);
 
+	if ((hdr->offset[0] << 8 | hdr->offset[1]) &
+	    (NET_IPV4_MORE_FRAG_MASK | NET_IPV4_FRAG_OFFSET_MASK)) {
+		/* The reassembled packet comes back here through
+		 * net_recv_data() once all the fragments are received.
+		 */
+		verdict = net_ipv4_handle_fragment(pkt, hdr);
+		if (verdict == NET_DROP) {
+			goto drop;
+		}
+
+		return verdict;
+	}
+
 	NET_DBG("IPv4 packet received from %s to %s",
 		log_strdup(net_sprint_ipv4_addr(&hdr->src)),
 		log_strdup(net_sprint_ipv4_addr(&hdr->dst)));
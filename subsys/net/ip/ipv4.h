@@ -20,8 +20,15 @@
 #include <net/net_if.h>
 #include <net/net_context.h>
 
+#include "reassembly.h"
+
 #define NET_IPV4_IHL_MASK 0x0F
 
+/* IPv4 fragment offset field, in host byte order */
+#define NET_IPV4_DO_NOT_FRAG_MASK 0x4000
+#define NET_IPV4_MORE_FRAG_MASK   0x2000
+#define NET_IPV4_FRAG_OFFSET_MASK 0x1FFF
+
 /* IPv4 Options */
 #define NET_IPV4_OPTS_EO   0   /* End of Options */
 #define NET_IPV4_OPTS_NOP  1   /* No operation */
@@ -132,4 +139,73 @@ static inline int net_ipv4_parse_hdr_options(struct net_pkt *pkt,
 }
 #endif
 
+/**
+ * @typedef net_ipv4_frag_cb_t
+ * @brief Callback used while iterating over pending IPv4 fragments.
+ *
+ * @param reass IPv4 fragment reassembly struct
+ * @param user_data A valid pointer on some user data or NULL
+ */
+typedef void (*net_ipv4_frag_cb_t)(struct net_reassembly *reass,
+				   void *user_data);
+
+#if defined(CONFIG_NET_IPV4_FRAGMENT)
+/**
+ * @brief Go through all the currently pending IPv4 fragments.
+ *
+ * @param cb Callback to call for each pending IPv4 fragment.
+ * @param user_data User specified data or NULL.
+ */
+void net_ipv4_frag_foreach(net_ipv4_frag_cb_t cb, void *user_data);
+
+/**
+ * @brief Handles IPv4 fragmented packets.
+ *
+ * The packet is kept until all the fragments have been received, the
+ * reassembled packet is then fed back to the IP stack.
+ *
+ * @param pkt Network packet, the cursor is at the payload.
+ * @param hdr The IPv4 header of the packet.
+ *
+ * @return Return verdict about the packet.
+ */
+enum net_verdict net_ipv4_handle_fragment(struct net_pkt *pkt,
+					  struct net_ipv4_hdr *hdr);
+
+/**
+ * @brief Prepare IPv4 packet for sending. The packet is fragmented if
+ * it does not fit the MTU of the network interface.
+ *
+ * @param pkt Network packet.
+ *
+ * @return NET_OK if the packet can be sent as is, NET_CONTINUE if it
+ * was sent as fragments, NET_DROP if it cannot be sent.
+ */
+enum net_verdict net_ipv4_prepare_for_send(struct net_pkt *pkt);
+#else
+static inline void net_ipv4_frag_foreach(net_ipv4_frag_cb_t cb,
+					 void *user_data)
+{
+	ARG_UNUSED(cb);
+	ARG_UNUSED(user_data);
+}
+
+static inline
+enum net_verdict net_ipv4_handle_fragment(struct net_pkt *pkt,
+					  struct net_ipv4_hdr *hdr)
+{
+	ARG_UNUSED(pkt);
+	ARG_UNUSED(hdr);
+
+	return NET_DROP;
+}
+
+static inline enum net_verdict net_ipv4_prepare_for_send(struct net_pkt *pkt)
+{
+	ARG_UNUSED(pkt);
+
+	return NET_OK;
+}
+#endif /* CONFIG_NET_IPV4_FRAGMENT */
+
 #endif /* __IPV4_H */
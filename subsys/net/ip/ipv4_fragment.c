@@ -0,0 +1,343 @@
+/** @file
+ * @brief IPv4 Fragment related functions
+ */
+
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_DECLARE(net_ipv4, CONFIG_NET_IPV4_LOG_LEVEL);
+
+#include <errno.h>
+#include <random/rand32.h>
+#include <net/net_core.h>
+#include <net/net_pkt.h>
+#include <net/net_stats.h>
+#include <net/net_context.h>
+#include "net_private.h"
+#include "ipv4.h"
+#include "reassembly.h"
+
+#define IPV4_REASSEMBLY_TIMEOUT K_SECONDS(CONFIG_NET_IPV4_FRAGMENT_TIMEOUT)
+
+#define BUF_ALLOC_TIMEOUT K_MSEC(100)
+
+static struct net_reassembly reassembly[CONFIG_NET_IPV4_FRAGMENT_MAX_COUNT];
+static struct net_reassembly_frag
+reassembly_frags[CONFIG_NET_IPV4_FRAGMENT_MAX_COUNT *
+		 CONFIG_NET_IPV4_FRAGMENT_MAX_PKT];
+static struct net_reassembly_table reassembly_table;
+static bool reassembly_init_done;
+
+static inline uint16_t ipv4_frag_field(struct net_ipv4_hdr *hdr)
+{
+	return (hdr->offset[0] << 8) | hdr->offset[1];
+}
+
+static void reassembly_info(char *str, struct net_reassembly *reass)
+{
+	NET_DBG("%s id 0x%x src %s dst %s remain %d ms", str, reass->id,
+		log_strdup(net_sprint_ipv4_addr(&reass->src.in)),
+		log_strdup(net_sprint_ipv4_addr(&reass->dst.in)),
+		k_delayed_work_remaining_get(&reass->timer));
+}
+
+static void reassemble_packet(struct net_pkt *pkt)
+{
+	NET_PKT_DATA_ACCESS_CONTIGUOUS_DEFINE(ipv4_access, struct net_ipv4_hdr);
+	struct net_ipv4_hdr *hdr;
+
+	/* The payload of the other fragments has been appended to the
+	 * first one, only its header needs to be fixed.
+	 */
+	hdr = (struct net_ipv4_hdr *)net_pkt_get_data(pkt, &ipv4_access);
+	if (!hdr) {
+		goto error;
+	}
+
+	hdr->len = htons(net_pkt_get_len(pkt));
+	hdr->offset[0] &= NET_IPV4_DO_NOT_FRAG_MASK >> 8;
+	hdr->offset[1] = 0U;
+	hdr->chksum = 0U;
+	hdr->chksum = net_calc_chksum_ipv4(pkt);
+
+	net_pkt_set_data(pkt, &ipv4_access);
+
+	NET_DBG("New pkt %p IPv4 len is %zd bytes", pkt, net_pkt_get_len(pkt));
+
+	/* Feed the packet back to the IP stack through the queue, see the
+	 * IPv6 reassembly for details. The flag tells process_data() that
+	 * the packet has no link layer header.
+	 */
+	net_pkt_set_ipv4_reassembled(pkt, true);
+
+	if (net_recv_data(net_pkt_iface(pkt), pkt) >= 0) {
+		return;
+	}
+error:
+	net_pkt_unref(pkt);
+}
+
+void net_ipv4_frag_foreach(net_ipv4_frag_cb_t cb, void *user_data)
+{
+	if (!reassembly_init_done) {
+		return;
+	}
+
+	net_reassembly_foreach(&reassembly_table, cb, user_data);
+}
+
+enum net_verdict net_ipv4_handle_fragment(struct net_pkt *pkt,
+					  struct net_ipv4_hdr *hdr)
+{
+	struct net_reassembly *reass;
+	uint16_t flag = ipv4_frag_field(hdr);
+	uint16_t offset = (flag & NET_IPV4_FRAG_OFFSET_MASK) * 8U;
+	bool more = flag & NET_IPV4_MORE_FRAG_MASK;
+	uint16_t id = (hdr->id[0] << 8) | hdr->id[1];
+	uint16_t len;
+	int ret;
+
+	if (!reassembly_init_done) {
+		net_reassembly_init(&reassembly_table, reassembly,
+				    ARRAY_SIZE(reassembly), reassembly_frags,
+				    CONFIG_NET_IPV4_FRAGMENT_MAX_PKT,
+				    IPV4_REASSEMBLY_TIMEOUT);
+
+		reassembly_init_done = true;
+	}
+
+	len = net_pkt_get_len(pkt) - net_pkt_get_current_offset(pkt);
+
+	/* All but the last fragment carry a multiple of 8 bytes */
+	if (more && len % 8) {
+		NET_DBG("DROP: fragment length %u", len);
+		return NET_DROP;
+	}
+
+	net_reassembly_lock();
+
+	reass = net_reassembly_get(&reassembly_table, AF_INET, &hdr->src,
+				   &hdr->dst, id, hdr->proto);
+	if (!reass) {
+		NET_DBG("Cannot get reassembly slot, dropping pkt %p", pkt);
+		goto drop;
+	}
+
+	ret = net_reassembly_add(reass, pkt, offset, len, more);
+	if (ret == -EALREADY) {
+		NET_DBG("Duplicate fragment offset %u of 0x%x", offset, id);
+		goto drop;
+	} else if (ret < 0) {
+		NET_DBG("Cannot add fragment offset %u of 0x%x (%d)",
+			offset, id, ret);
+		net_reassembly_cancel(reass);
+		goto drop;
+	} else if (ret == 0) {
+		reassembly_info("Reassembly pending", reass);
+		net_reassembly_unlock();
+
+		return NET_OK;
+	}
+
+	reassembly_info("Reassembly last pkt", reass);
+
+	pkt = net_reassembly_join(reass);
+
+	net_reassembly_unlock();
+
+	if (pkt) {
+		reassemble_packet(pkt);
+	}
+
+	return NET_OK;
+
+drop:
+	net_reassembly_unlock();
+
+	return NET_DROP;
+}
+
+static int send_ipv4_fragment(struct net_pkt *pkt, uint16_t hdr_len,
+			      uint16_t fit_len, uint16_t frag_offset,
+			      uint16_t id, bool final)
+{
+	NET_PKT_DATA_ACCESS_CONTIGUOUS_DEFINE(ipv4_access, struct net_ipv4_hdr);
+	struct net_ipv4_hdr *hdr;
+	struct net_pkt *frag_pkt;
+	uint16_t flag;
+	int ret = -ENOBUFS;
+
+	frag_pkt = net_pkt_alloc_with_buffer(net_pkt_iface(pkt),
+					     hdr_len + fit_len,
+					     AF_INET, 0, BUF_ALLOC_TIMEOUT);
+	if (!frag_pkt) {
+		return -ENOMEM;
+	}
+
+	net_pkt_cursor_init(pkt);
+
+	/* Every fragment gets a copy of the header, including the options,
+	 * followed by its part of the payload.
+	 */
+	if (net_pkt_copy(frag_pkt, pkt, hdr_len) ||
+	    net_pkt_skip(pkt, frag_offset) ||
+	    net_pkt_copy(frag_pkt, pkt, fit_len)) {
+		goto fail;
+	}
+
+	net_pkt_cursor_init(frag_pkt);
+	net_pkt_set_overwrite(frag_pkt, true);
+
+	hdr = (struct net_ipv4_hdr *)net_pkt_get_data(frag_pkt, &ipv4_access);
+	if (!hdr) {
+		goto fail;
+	}
+
+	flag = frag_offset / 8U;
+	if (!final) {
+		flag |= NET_IPV4_MORE_FRAG_MASK;
+	}
+
+	hdr->len = htons(hdr_len + fit_len);
+	hdr->id[0] = id >> 8;
+	hdr->id[1] = id;
+	hdr->offset[0] = flag >> 8;
+	hdr->offset[1] = flag;
+	hdr->chksum = 0U;
+
+	net_pkt_set_ip_hdr_len(frag_pkt, sizeof(struct net_ipv4_hdr));
+	net_pkt_set_ipv4_opts_len(frag_pkt,
+				  hdr_len - sizeof(struct net_ipv4_hdr));
+
+	if (net_if_need_calc_tx_checksum(net_pkt_iface(frag_pkt))) {
+		hdr->chksum = net_calc_chksum_ipv4(frag_pkt);
+	}
+
+	if (net_pkt_set_data(frag_pkt, &ipv4_access)) {
+		goto fail;
+	}
+
+	ret = net_send_data(frag_pkt);
+	if (ret < 0) {
+		goto fail;
+	}
+
+	/* Let this packet to be sent and hopefully it will release
+	 * the memory that can be utilized for next sent IPv4 fragment.
+	 */
+	k_yield();
+
+	return 0;
+
+fail:
+	NET_DBG("Cannot send fragment (%d)", ret);
+	net_pkt_unref(frag_pkt);
+
+	return ret;
+}
+
+static int send_fragmented_pkt(struct net_pkt *pkt, struct net_ipv4_hdr *hdr,
+			       uint16_t mtu)
+{
+	uint16_t hdr_len = (hdr->vhl & NET_IPV4_IHL_MASK) * 4U;
+	uint16_t id = (hdr->id[0] << 8) | hdr->id[1];
+	uint16_t frag_offset = 0U;
+	size_t length;
+	int fit_len;
+	int ret;
+
+	/* Fragment offsets are in 8 byte units */
+	fit_len = (mtu - hdr_len) & ~7;
+	if (fit_len <= 0) {
+		NET_DBG("No room for IPv4 payload MTU %d hdr_len %d",
+			mtu, hdr_len);
+		return -EINVAL;
+	}
+
+	if (!id) {
+		id = (sys_rand32_get() % UINT16_MAX) + 1;
+	}
+
+	length = net_pkt_get_len(pkt) - hdr_len;
+	while (length) {
+		bool final = false;
+
+		if (fit_len >= length) {
+			final = true;
+			fit_len = length;
+		}
+
+		ret = send_ipv4_fragment(pkt, hdr_len, fit_len, frag_offset,
+					 id, final);
+		if (ret < 0) {
+			return ret;
+		}
+
+		length -= fit_len;
+		frag_offset += fit_len;
+	}
+
+	return 0;
+}
+
+enum net_verdict net_ipv4_prepare_for_send(struct net_pkt *pkt)
+{
+	NET_PKT_DATA_ACCESS_CONTIGUOUS_DEFINE(ipv4_access, struct net_ipv4_hdr);
+	uint16_t mtu = net_if_get_mtu(net_pkt_iface(pkt));
+	size_t pkt_len = net_pkt_get_len(pkt);
+	struct net_ipv4_hdr *hdr;
+	int ret;
+
+	mtu = MAX(NET_IPV4_MTU, mtu);
+	if (pkt_len <= mtu) {
+		return NET_OK;
+	}
+
+	net_pkt_cursor_init(pkt);
+	net_pkt_set_overwrite(pkt, true);
+
+	hdr = (struct net_ipv4_hdr *)net_pkt_get_data(pkt, &ipv4_access);
+	if (!hdr) {
+		return NET_DROP;
+	}
+
+	if (ipv4_frag_field(hdr) & NET_IPV4_DO_NOT_FRAG_MASK) {
+		NET_DBG("DROP: pkt %p len %zd > MTU %d and DF set",
+			pkt, pkt_len, mtu);
+		return NET_DROP;
+	}
+
+	ret = send_fragmented_pkt(pkt, hdr, mtu);
+	if (ret < 0) {
+		NET_DBG("Cannot fragment IPv4 pkt (%d)", ret);
+
+		if (ret == -ENOMEM) {
+			/* Try to send the original packet if we could not
+			 * allocate the fragments, like IPv6 does.
+			 */
+			net_pkt_cursor_init(pkt);
+			return NET_OK;
+		}
+
+		/* Some fragments may have been sent, but the packet was
+		 * not, let the caller drop it.
+		 */
+		return NET_DROP;
+	}
+
+	/* The packet is now split and its fragments sent separately, so
+	 * "fake" the sending of the original one. See IPv6 for why TCP
+	 * needs this.
+	 */
+	if (IS_ENABLED(CONFIG_NET_TCP)) {
+		net_pkt_set_sent(pkt, true);
+	}
+
+	net_pkt_unref(pkt);
+
+	return NET_CONTINUE;
+}
@@ -86,6 +86,7 @@ int net_ipv6_finalize(struct net_pkt *pkt, uint8_t next_header_proto)
 	NET_PKT_DATA_ACCESS_CONTIGUOUS_DEFINE(ipv6_access, struct net_ipv6_hdr);
 	struct net_ipv6_hdr *ipv6_hdr;
 
+	net_pkt_set_tx_stats_tick(pkt, NET_STATS_TX_DETAIL_IP);
 	net_pkt_set_overwrite(pkt, true);
 
 	ipv6_hdr = (struct net_ipv6_hdr *)net_pkt_get_data(pkt, &ipv6_access);
@@ -377,6 +378,7 @@ enum net_verdict net_ipv6_input(struct net_pkt *pkt, bool is_loopback)
 	union net_ip_header ip;
 	int pkt_len;
 
+	net_pkt_set_rx_stats_tick(pkt, NET_STATS_RX_DETAIL_IP);
 	net_stats_update_ipv6_recv(net_pkt_iface(pkt));
 
 	hdr = (struct net_ipv6_hdr *)net_pkt_get_data(pkt, &ipv6_access);
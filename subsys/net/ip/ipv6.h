@@ -22,6 +22,8 @@
 
 #include "icmpv6.h"
 #include "nbr.h"
+#include "nbr_cache.h"
+#include "reassembly.h"
 
 #define NET_IPV6_ND_HOP_LIMIT 255
 #define NET_IPV6_ND_INFINITE_LIFETIME 0xFFFFFFFF
@@ -80,8 +82,16 @@ const char *net_ipv6_nbr_state2str(enum net_ipv6_nbr_state state);
  * @brief IPv6 neighbor information.
  */
 struct net_ipv6_nbr_data {
-	/** Any pending packet waiting ND to finish. */
-	struct net_pkt *pending;
+#if defined(CONFIG_NET_IPV6_NBR_CACHE)
+	/** Node in the neighbor cache hash index. */
+	sys_snode_t hash_node;
+
+	/** Node in the least recently used order of the neighbor cache. */
+	sys_dnode_t lru_node;
+#endif
+
+	/** Packets waiting ND to finish. */
+	struct net_nbr_pending pending;
 
 	/** IPv6 address. */
 	struct in6_addr addr;
@@ -106,13 +116,6 @@ struct net_ipv6_nbr_data {
 
 	/** Is the neighbor a router */
 	bool is_router;
-
-#if defined(CONFIG_NET_IPV6_NBR_CACHE) || defined(CONFIG_NET_IPV6_ND)
-	/** Stale counter used to removed oldest nbr in STALE state,
-	 *  when table is full.
-	 */
-	uint32_t stale_counter;
-#endif
 };
 
 static inline struct net_ipv6_nbr_data *net_ipv6_nbr_data(struct net_nbr *nbr)
@@ -390,27 +393,6 @@ static inline void net_ipv6_nbr_set_reachable_timer(struct net_if *iface,
 #define NET_IPV6_FRAGMENTS_MAX_PKT 2
 #endif
 
-/** Store pending IPv6 fragment information that is needed for reassembly. */
-struct net_ipv6_reassembly {
-	/** IPv6 source address of the fragment */
-	struct in6_addr src;
-
-	/** IPv6 destination address of the fragment */
-	struct in6_addr dst;
-
-	/**
-	 * Timeout for cancelling the reassembly. The timer is used
-	 * also to detect if this reassembly slot is used or not.
-	 */
-	struct k_delayed_work timer;
-
-	/** Pointers to pending fragments */
-	struct net_pkt *pkt[NET_IPV6_FRAGMENTS_MAX_PKT];
-
-	/** IPv6 fragment identification */
-	uint32_t id;
-};
-
 /**
  * @typedef net_ipv6_frag_cb_t
  * @brief Callback used while iterating over pending IPv6 fragments.
@@ -418,7 +400,7 @@ struct net_ipv6_reassembly {
  * @param reass IPv6 fragment reassembly struct
  * @param user_data A valid pointer on some user data or NULL
  */
-typedef void (*net_ipv6_frag_cb_t)(struct net_ipv6_reassembly *reass,
+typedef void (*net_ipv6_frag_cb_t)(struct net_reassembly *reass,
 				   void *user_data);
 
 /**
@@ -30,6 +30,7 @@ LOG_MODULE_DECLARE(net_ipv6, CONFIG_NET_IPV6_LOG_LEVEL);
 #include "tcp_internal.h"
 #include "ipv6.h"
 #include "nbr.h"
+#include "nbr_cache.h"
 #include "6lo.h"
 #include "route.h"
 #include "net_stats.h"
@@ -53,19 +54,6 @@ LOG_MODULE_DECLARE(net_ipv6, CONFIG_NET_IPV6_LOG_LEVEL);
 #define MIN_IPV6_MTU NET_IPV6_MTU
 #define MAX_IPV6_MTU 0xffff
 
-#if defined(CONFIG_NET_IPV6_NBR_CACHE) || defined(CONFIG_NET_IPV6_ND)
-/* Global stale counter, whenever ipv6 neighbor enters into
- * stale state, stale counter is incremented by one.
- * When network stack tries to add new neighbor and if table
- * is full, oldest (oldest stale counter) neighbor in stale
- * state will be removed from the table and new entry will be
- * added.
- */
-static uint32_t stale_counter;
-
-static struct k_sem nbr_lock;
-#endif
-
 #if defined(CONFIG_NET_IPV6_ND)
 static struct k_delayed_work ipv6_nd_reachable_timer;
 static void ipv6_nd_reachable_timeout(struct k_work *work);
@@ -97,6 +85,16 @@ NET_NBR_TABLE_INIT(NET_NBR_GLOBAL,
 		   net_neighbor_pool,
 		   net_neighbor_table_clear);
 
+/* Neighbors in use by IPv6 address */
+static struct net_nbr_hash nbr_hash;
+
+/* Neighbors in use, the most recently used first. When the cache is
+ * full, the least recently used neighbor is removed to make room for
+ * a new one.
+ */
+static sys_dlist_t nbr_lru;
+static struct k_spinlock nbr_lru_lock;
+
 const char *net_ipv6_nbr_state2str(enum net_ipv6_nbr_state state)
 {
 	switch (state) {
@@ -150,43 +148,6 @@ static void ipv6_nbr_set_state(struct net_nbr *nbr,
 		net_ipv6_nbr_state2str(new_state));
 
 	net_ipv6_nbr_data(nbr)->state = new_state;
-
-	if (net_ipv6_nbr_data(nbr)->state == NET_IPV6_NBR_STATE_STALE) {
-		if (stale_counter + 1 != UINT32_MAX) {
-			net_ipv6_nbr_data(nbr)->stale_counter = stale_counter++;
-		} else {
-			/* Global stale counter reached UINT32_MAX, reset it and
-			 * respective neighbors stale counter too.
-			 */
-			struct net_nbr *n = NULL;
-			struct net_ipv6_nbr_data *data = NULL;
-			int i;
-
-			k_sem_take(&nbr_lock, K_FOREVER);
-
-			stale_counter = 0U;
-
-			for (i = 0; i < CONFIG_NET_IPV6_MAX_NEIGHBORS; i++) {
-				n = get_nbr(i);
-				if (!n || !n->ref) {
-					continue;
-				}
-
-				data = net_ipv6_nbr_data(nbr);
-				if (!data) {
-					continue;
-				}
-
-				if (data->state != NET_IPV6_NBR_STATE_STALE) {
-					continue;
-				}
-
-				data->stale_counter = stale_counter++;
-			}
-
-			k_sem_give(&nbr_lock);
-		}
-	}
 }
 
 struct iface_cb_data {
@@ -235,13 +196,13 @@ void nbr_print(void)
 			continue;
 		}
 
-		NET_DBG("[%d] %p %d/%d/%d/%d/%d pending %p iface %p/%d "
+		NET_DBG("[%d] %p %d/%d/%d/%d/%d pending %d iface %p/%d "
 			"ll %s addr %s",
 			i, nbr, nbr->ref, net_ipv6_nbr_data(nbr)->ns_count,
 			net_ipv6_nbr_data(nbr)->is_router,
 			net_ipv6_nbr_data(nbr)->state,
 			net_ipv6_nbr_data(nbr)->link_metric,
-			net_ipv6_nbr_data(nbr)->pending,
+			net_ipv6_nbr_data(nbr)->pending.count,
 			nbr->iface, nbr->idx,
 			nbr->idx == NET_NBR_LLADDR_UNKNOWN ? "?" :
 			log_strdup(net_sprint_ll_addr(
@@ -259,10 +220,12 @@ static struct net_nbr *nbr_lookup(struct net_nbr_table *table,
 				  struct net_if *iface,
 				  const struct in6_addr *addr)
 {
-	int i;
+	struct net_ipv6_nbr_data *data;
 
-	for (i = 0; i < CONFIG_NET_IPV6_MAX_NEIGHBORS; i++) {
-		struct net_nbr *nbr = get_nbr(i);
+	NET_NBR_HASH_FOR_EACH(&nbr_hash, addr, sizeof(struct in6_addr),
+			      data, hash_node) {
+		struct net_nbr *nbr = CONTAINER_OF((uint8_t *)data,
+						   struct net_nbr, __nbr);
 
 		if (!nbr->ref) {
 			continue;
@@ -272,7 +235,7 @@ static struct net_nbr *nbr_lookup(struct net_nbr_table *table,
 			continue;
 		}
 
-		if (net_ipv6_addr_cmp(&net_ipv6_nbr_data(nbr)->addr, addr)) {
+		if (net_ipv6_addr_cmp(&data->addr, addr)) {
 			return nbr;
 		}
 	}
@@ -280,13 +243,50 @@ static struct net_nbr *nbr_lookup(struct net_nbr_table *table,
 	return NULL;
 }
 
+static inline void nbr_lru_touch(struct net_nbr *nbr)
+{
+	k_spinlock_key_t key = k_spin_lock(&nbr_lru_lock);
+
+	net_nbr_lru_touch(&nbr_lru, &net_ipv6_nbr_data(nbr)->lru_node);
+
+	k_spin_unlock(&nbr_lru_lock, key);
+}
+
+/* A pending packet holds the reference of its sender and the one taken
+ * when it was queued.
+ */
 static inline void nbr_clear_ns_pending(struct net_ipv6_nbr_data *data)
 {
+	struct net_pkt *pkts[NET_NBR_PENDING_QUEUE_SIZE];
+	int count;
+	int i;
+
 	data->send_ns = 0;
 
-	if (data->pending) {
-		net_pkt_unref(data->pending);
-		data->pending = NULL;
+	count = net_nbr_pending_take(&data->pending, pkts);
+	for (i = 0; i < count; i++) {
+		net_pkt_unref(pkts[i]);
+		net_pkt_unref(pkts[i]);
+	}
+}
+
+static void nbr_send_pending(struct net_nbr *nbr)
+{
+	struct net_pkt *pkts[NET_NBR_PENDING_QUEUE_SIZE];
+	int count;
+	int i;
+
+	count = net_nbr_pending_take(&net_ipv6_nbr_data(nbr)->pending, pkts);
+	for (i = 0; i < count; i++) {
+		NET_DBG("Sending pending %p to %s", pkts[i],
+			log_strdup(net_sprint_ipv6_addr(
+					   &NET_IPV6_HDR(pkts[i])->dst)));
+
+		if (net_send_data(pkts[i]) < 0) {
+			net_pkt_unref(pkts[i]);
+		}
+
+		net_pkt_unref(pkts[i]);
 	}
 }
 
@@ -376,25 +376,18 @@ static void ipv6_ns_reply_timeout(struct k_work *work)
 		data->send_ns = 0;
 
 		/* We did not receive reply to a sent NS */
-		if (!data->pending) {
+		if (!data->pending.count) {
 			/* Silently return, this is not an error as the work
 			 * cannot be cancelled in certain cases.
 			 */
 			continue;
 		}
 
-		NET_DBG("NS nbr %p pending %p timeout to %s", nbr,
-			data->pending,
-			log_strdup(net_sprint_ipv6_addr(
-					 &NET_IPV6_HDR(data->pending)->dst)));
-
-		/* To unref when pending variable was set */
-		net_pkt_unref(data->pending);
-
-		/* To unref the original pkt allocation */
-		net_pkt_unref(data->pending);
+		NET_DBG("NS nbr %p %d pending timeout to %s", nbr,
+			data->pending.count,
+			log_strdup(net_sprint_ipv6_addr(&data->addr)));
 
-		data->pending = NULL;
+		nbr_clear_ns_pending(data);
 
 		net_nbr_unref(nbr);
 	}
@@ -408,10 +401,13 @@ static void nbr_init(struct net_nbr *nbr, struct net_if *iface,
 	nbr->iface = iface;
 
 	net_ipaddr_copy(&net_ipv6_nbr_data(nbr)->addr, addr);
+	net_nbr_hash_add(&nbr_hash, &net_ipv6_nbr_data(nbr)->hash_node,
+			 addr, sizeof(struct in6_addr));
 	ipv6_nbr_set_state(nbr, state);
 	net_ipv6_nbr_data(nbr)->is_router = is_router;
-	net_ipv6_nbr_data(nbr)->pending = NULL;
+	net_ipv6_nbr_data(nbr)->pending.count = 0U;
 	net_ipv6_nbr_data(nbr)->send_ns = 0;
+	nbr_lru_touch(nbr);
 
 #if defined(CONFIG_NET_IPV6_ND)
 	net_ipv6_nbr_data(nbr)->reachable = 0;
@@ -500,53 +496,47 @@ static void dbg_update_neighbor_lladdr_raw(uint8_t *new_lladdr,
 #define dbg_addr_sent_tgt(pkt_str, src, dst, tgt, pkt)		\
 	dbg_addr_with_tgt("Sent", pkt_str, src, dst, tgt, pkt)
 
-static void ipv6_nd_remove_old_stale_nbr(void)
+/* The least recently used neighbor in STALE state is removed first,
+ * as it has not been confirmed lately. Routers, static neighbors and
+ * neighbors being resolved are not removed.
+ */
+static void ipv6_nbr_remove_lru(void)
 {
+	struct net_ipv6_nbr_data *oldest = NULL;
+	struct net_ipv6_nbr_data *data;
 	struct net_nbr *nbr = NULL;
-	struct net_ipv6_nbr_data *data = NULL;
-	int nbr_idx = -1;
-	uint32_t oldest = UINT32_MAX;
-	int i;
+	k_spinlock_key_t key;
 
-	k_sem_take(&nbr_lock, K_FOREVER);
+	key = k_spin_lock(&nbr_lru_lock);
 
-	for (i = 0; i < CONFIG_NET_IPV6_MAX_NEIGHBORS; i++) {
-		nbr = get_nbr(i);
-		if (!nbr || !nbr->ref) {
+	NET_NBR_LRU_FOR_EACH_OLDEST(&nbr_lru, data, lru_node) {
+		if (data->is_router ||
+		    data->state == NET_IPV6_NBR_STATE_STATIC ||
+		    data->state == NET_IPV6_NBR_STATE_INCOMPLETE) {
 			continue;
 		}
 
-		data = net_ipv6_nbr_data(nbr);
-		if (!data || data->is_router ||
-		    data->state != NET_IPV6_NBR_STATE_STALE) {
-			continue;
+		if (!oldest) {
+			oldest = data;
 		}
 
-		if (nbr_idx == -1) {
-			nbr_idx = i;
-			oldest = data->stale_counter;
-			continue;
-		}
-
-		if (oldest == MIN(oldest, data->stale_counter)) {
-			continue;
+		if (data->state == NET_IPV6_NBR_STATE_STALE) {
+			oldest = data;
+			break;
 		}
+	}
 
-		nbr_idx = i;
-		oldest = data->stale_counter;
+	if (oldest) {
+		nbr = CONTAINER_OF((uint8_t *)oldest, struct net_nbr, __nbr);
 	}
 
-	if (nbr_idx != -1) {
-		nbr = get_nbr(nbr_idx);
-		if (!nbr) {
-			return;
-		}
+	k_spin_unlock(&nbr_lru_lock, key);
 
-		net_ipv6_nbr_rm(nbr->iface,
-				&net_ipv6_nbr_data(nbr)->addr);
-	}
+	if (nbr) {
+		NET_DBG("Removing least recently used nbr %p", nbr);
 
-	k_sem_give(&nbr_lock);
+		net_ipv6_nbr_rm(nbr->iface, &net_ipv6_nbr_data(nbr)->addr);
+	}
 }
 
 static struct net_nbr *add_nbr(struct net_if *iface,
@@ -566,10 +556,10 @@ static struct net_nbr *add_nbr(struct net_if *iface,
 		return nbr;
 	}
 
-	/* Check if there are any stale neighbors, delete the oldest
-	 * one and try to add new neighbor.
+	/* The cache is full, remove the least recently used neighbor
+	 * and try to add new neighbor.
 	 */
-	ipv6_nd_remove_old_stale_nbr();
+	ipv6_nbr_remove_lru();
 
 	nbr = nbr_new(iface, addr, is_router, state);
 	if (!nbr) {
@@ -651,8 +641,18 @@ struct net_nbr *net_ipv6_nbr_add(struct net_if *iface,
 
 void net_neighbor_data_remove(struct net_nbr *nbr)
 {
+	k_spinlock_key_t key;
+
 	NET_DBG("Neighbor %p removed", nbr);
 
+	net_nbr_hash_del(&nbr_hash, &net_ipv6_nbr_data(nbr)->hash_node,
+			 &net_ipv6_nbr_data(nbr)->addr,
+			 sizeof(struct in6_addr));
+
+	key = k_spin_lock(&nbr_lru_lock);
+	net_nbr_lru_del(&net_ipv6_nbr_data(nbr)->lru_node);
+	k_spin_unlock(&nbr_lru_lock, key);
+
 	return;
 }
 
@@ -930,6 +930,8 @@ try_send:
 							DELAY_FIRST_PROBE_TIME);
 		}
 #endif
+		nbr_lru_touch(nbr);
+
 		return NET_OK;
 	}
 
@@ -1539,7 +1541,6 @@ static inline bool handle_na_neighbor(struct net_pkt *pkt,
 	struct net_linkaddr_storage lladdr = { 0 };
 	bool lladdr_changed = false;
 	struct net_linkaddr_storage *cached_lladdr;
-	struct net_pkt *pending;
 	struct net_nbr *nbr;
 
 	nbr = nbr_lookup(&net_neighbor.table, net_pkt_iface(pkt), &na_hdr->tgt);
@@ -1690,20 +1691,7 @@ static inline bool handle_na_neighbor(struct net_pkt *pkt,
 
 send_pending:
 	/* Next send any pending messages to the peer. */
-	pending = net_ipv6_nbr_data(nbr)->pending;
-	if (pending) {
-		NET_DBG("Sending pending %p to lladdr %s", pending,
-			log_strdup(net_sprint_ll_addr(cached_lladdr->addr,
-						      cached_lladdr->len)));
-
-		if (net_send_data(pending) < 0) {
-			nbr_clear_ns_pending(net_ipv6_nbr_data(nbr));
-		} else {
-			net_ipv6_nbr_data(nbr)->pending = NULL;
-		}
-
-		net_pkt_unref(pending);
-	}
+	nbr_send_pending(nbr);
 
 	return true;
 }
@@ -1834,6 +1822,26 @@ int net_ipv6_send_ns(struct net_if *iface,
 	struct net_nbr *nbr;
 	uint8_t llao_len;
 
+	if (pending) {
+		nbr = nbr_lookup(&net_neighbor.table, iface, tgt);
+		if (nbr && net_ipv6_nbr_data(nbr)->pending.count) {
+			/* The NS sent for the first pending packet is waiting
+			 * for a reply, the packet is sent with the others
+			 * once it arrives.
+			 */
+			if (!net_nbr_pending_add(
+				    &net_ipv6_nbr_data(nbr)->pending, pending)) {
+				NET_DBG("Pending queue for %s full, "
+					"discarding %p",
+					log_strdup(net_sprint_ipv6_addr(tgt)),
+					pending);
+				goto drop;
+			}
+
+			return 0;
+		}
+	}
+
 	if (!dst) {
 		net_ipv6_addr_create_solicited_node(tgt, &node_dst);
 		dst = &node_dst;
@@ -1906,12 +1914,10 @@ int net_ipv6_send_ns(struct net_if *iface,
 	}
 
 	if (pending) {
-		if (!net_ipv6_nbr_data(nbr)->pending) {
-			net_ipv6_nbr_data(nbr)->pending = net_pkt_ref(pending);
-		} else {
-			NET_DBG("Packet %p already pending for "
-				"operation. Discarding pending %p and pkt %p",
-				net_ipv6_nbr_data(nbr)->pending, pending, pkt);
+		if (!net_nbr_pending_add(&net_ipv6_nbr_data(nbr)->pending,
+					 pending)) {
+			NET_DBG("Cannot queue pending %p, discarding pkt %p",
+				pending, pkt);
 			goto drop;
 		}
 
@@ -2444,16 +2450,8 @@ static enum net_verdict handle_ra_input(struct net_pkt *pkt,
 				       &ip_hdr->src, router_lifetime);
 	}
 
-	if (nbr && net_ipv6_nbr_data(nbr)->pending) {
-		NET_DBG("Sending pending pkt %p to %s",
-			net_ipv6_nbr_data(nbr)->pending,
-			log_strdup(net_sprint_ipv6_addr(&NET_IPV6_HDR(
-				net_ipv6_nbr_data(nbr)->pending)->dst)));
-
-		if (net_send_data(net_ipv6_nbr_data(nbr)->pending) < 0) {
-			net_pkt_unref(net_ipv6_nbr_data(nbr)->pending);
-		}
-
+	if (nbr && net_ipv6_nbr_data(nbr)->pending.count) {
+		nbr_send_pending(nbr);
 		nbr_clear_ns_pending(net_ipv6_nbr_data(nbr));
 	}
 
@@ -2496,6 +2494,8 @@ static struct net_icmpv6_handler ra_input_handler = {
 void net_ipv6_nbr_init(void)
 {
 #if defined(CONFIG_NET_IPV6_NBR_CACHE)
+	net_nbr_hash_init(&nbr_hash);
+	sys_dlist_init(&nbr_lru);
 	net_icmpv6_register_handler(&ns_input_handler);
 	net_icmpv6_register_handler(&na_input_handler);
 	k_delayed_work_init(&ipv6_ns_reply_timer, ipv6_ns_reply_timeout);
@@ -2504,6 +2504,5 @@ void net_ipv6_nbr_init(void)
 	net_icmpv6_register_handler(&ra_input_handler);
 	k_delayed_work_init(&ipv6_nd_reachable_timer,
 			    ipv6_nd_reachable_timeout);
-	k_sem_init(&nbr_lock, 1, UINT_MAX);
 #endif
 }
@@ -44,8 +44,10 @@ struct net_nbr_lladdr {
  * data at the end of the node.
  */
 struct net_nbr {
-	/** Reference count. */
-	uint8_t ref;
+	/** Reference count. A nexthop neighbor is referenced by every
+	 * route going through it, so this can exceed 255.
+	 */
+	uint16_t ref;
 
 	/** Link to ll address. This is the index into lladdr array.
 	 * The value NET_NBR_LLADDR_UNKNOWN tells that this neighbor
@@ -0,0 +1,187 @@
+/** @file
+ *  @brief Helpers shared by the neighbor caches.
+ *
+ * The ARP cache and the IPv6 neighbor cache index their entries by
+ * a hash of the IP address, so that the lookup done for every sent
+ * packet only compares the entries of one bucket. They keep their
+ * entries in least recently used order to pick the entry to evict
+ * when the cache is full, and queue the packets sent to an address
+ * while it is being resolved.
+ */
+
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __NET_NBR_CACHE_H
+#define __NET_NBR_CACHE_H
+
+#include <string.h>
+#include <zephyr/types.h>
+#include <sys/dlist.h>
+#include <sys/slist.h>
+#include <sys/util.h>
+#include <net/net_pkt.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(CONFIG_NET_NBR_HASH_BUCKETS)
+#define NET_NBR_HASH_BUCKETS CONFIG_NET_NBR_HASH_BUCKETS
+#else
+#define NET_NBR_HASH_BUCKETS 1
+#endif
+
+#if defined(CONFIG_NET_NBR_PENDING_QUEUE_SIZE)
+#define NET_NBR_PENDING_QUEUE_SIZE CONFIG_NET_NBR_PENDING_QUEUE_SIZE
+#else
+#define NET_NBR_PENDING_QUEUE_SIZE 1
+#endif
+
+BUILD_ASSERT((NET_NBR_HASH_BUCKETS & (NET_NBR_HASH_BUCKETS - 1)) == 0,
+	     "CONFIG_NET_NBR_HASH_BUCKETS must be a power of two");
+
+struct net_nbr_hash {
+	sys_slist_t buckets[NET_NBR_HASH_BUCKETS];
+};
+
+/* FNV-1a, the interface is not hashed so that entries can be looked up
+ * on any interface.
+ */
+static inline uint32_t net_nbr_hash_key(const void *addr, size_t len)
+{
+	const uint8_t *p = addr;
+	uint32_t hash = 2166136261U;
+
+	while (len--) {
+		hash = (hash ^ *p++) * 16777619U;
+	}
+
+	return hash ^ (hash >> 16);
+}
+
+static inline sys_slist_t *net_nbr_hash_bucket(struct net_nbr_hash *hash,
+					       const void *addr, size_t len)
+{
+	return &hash->buckets[net_nbr_hash_key(addr, len) &
+			      (NET_NBR_HASH_BUCKETS - 1)];
+}
+
+static inline void net_nbr_hash_init(struct net_nbr_hash *hash)
+{
+	int i;
+
+	for (i = 0; i < NET_NBR_HASH_BUCKETS; i++) {
+		sys_slist_init(&hash->buckets[i]);
+	}
+}
+
+static inline void net_nbr_hash_add(struct net_nbr_hash *hash,
+				    sys_snode_t *node,
+				    const void *addr, size_t len)
+{
+	sys_slist_prepend(net_nbr_hash_bucket(hash, addr, len), node);
+}
+
+static inline void net_nbr_hash_del(struct net_nbr_hash *hash,
+				    sys_snode_t *node,
+				    const void *addr, size_t len)
+{
+	sys_slist_find_and_remove(net_nbr_hash_bucket(hash, addr, len), node);
+}
+
+/* Iterate over the entries hashed like addr, the caller compares the
+ * addresses.
+ */
+#define NET_NBR_HASH_FOR_EACH(_hash, _addr, _len, _entry, _node)	\
+	SYS_SLIST_FOR_EACH_CONTAINER(					\
+		net_nbr_hash_bucket(_hash, _addr, _len), _entry, _node)
+
+/* Move an entry first in the least recently used order, the entry is
+ * added if it is not in the list yet.
+ */
+static inline void net_nbr_lru_touch(sys_dlist_t *lru, sys_dnode_t *node)
+{
+	if (sys_dlist_is_head(lru, node)) {
+		return;
+	}
+
+	if (sys_dnode_is_linked(node)) {
+		sys_dlist_remove(node);
+	}
+
+	sys_dlist_prepend(lru, node);
+}
+
+static inline void net_nbr_lru_del(sys_dnode_t *node)
+{
+	if (sys_dnode_is_linked(node)) {
+		sys_dlist_remove(node);
+	}
+}
+
+/* Iterate over the entries from the least recently used one */
+#define NET_NBR_LRU_FOR_EACH_OLDEST(_lru, _entry, _node)		\
+	for (_entry = SYS_DLIST_CONTAINER(sys_dlist_peek_tail(_lru),	\
+					  _entry, _node);		\
+	     _entry != NULL;						\
+	     _entry = SYS_DLIST_CONTAINER(				\
+		     sys_dlist_peek_prev(_lru, &(_entry)->_node),	\
+		     _entry, _node))
+
+/* Packets waiting for an address to be resolved */
+struct net_nbr_pending {
+	struct net_pkt *pkts[NET_NBR_PENDING_QUEUE_SIZE];
+	uint8_t count;
+};
+
+/* Queue a packet, a reference is taken. Returns false if the queue is
+ * full, the packet is then not queued.
+ */
+static inline bool net_nbr_pending_add(struct net_nbr_pending *pending,
+				       struct net_pkt *pkt)
+{
+	if (pending->count == ARRAY_SIZE(pending->pkts)) {
+		return false;
+	}
+
+	pending->pkts[pending->count++] = net_pkt_ref(pkt);
+
+	return true;
+}
+
+/* Move the queued packets to pkts, which has room for
+ * NET_NBR_PENDING_QUEUE_SIZE packets, and return their count. The caller
+ * owns the references taken when the packets were queued.
+ */
+static inline int net_nbr_pending_take(struct net_nbr_pending *pending,
+				       struct net_pkt **pkts)
+{
+	int count = pending->count;
+
+	memcpy(pkts, pending->pkts, count * sizeof(struct net_pkt *));
+	pending->count = 0U;
+
+	return count;
+}
+
+/* Drop the queued packets with the references taken when queued */
+static inline void net_nbr_pending_clear(struct net_nbr_pending *pending)
+{
+	int i;
+
+	for (i = 0; i < pending->count; i++) {
+		net_pkt_unref(pending->pkts[i]);
+	}
+
+	pending->count = 0U;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __NET_NBR_CACHE_H */
@@ -76,6 +76,13 @@ static int check_used_port(enum net_ip_protocol ip_proto,
 			continue;
 		}
 
+		/* The port was given to a context not bound to an address
+		 * yet, e.g. one created for an incoming TCP connection.
+		 */
+		if (!net_sin_ptr(&contexts[i].local)->sin_addr) {
+			return -EEXIST;
+		}
+
 		if (IS_ENABLED(CONFIG_NET_IPV6) &&
 		    local_addr->sa_family == AF_INET6) {
 			if (net_ipv6_addr_cmp(
@@ -1281,8 +1288,8 @@ static void context_finalize_packet(struct net_context *context,
 	}
 }
 
-static struct net_pkt *context_alloc_pkt(struct net_context *context,
-					 size_t len, k_timeout_t timeout)
+static struct net_pkt *context_alloc_pkt_wait(struct net_context *context,
+					      size_t len, k_timeout_t timeout)
 {
 	struct net_pkt *pkt;
 
@@ -1318,6 +1325,24 @@ static struct net_pkt *context_alloc_pkt(struct net_context *context,
 	return pkt;
 }
 
+static struct net_pkt *context_alloc_pkt(struct net_context *context,
+					 size_t len, k_timeout_t timeout)
+{
+	struct net_pkt *pkt;
+
+	pkt = context_alloc_pkt_wait(context, len, K_NO_WAIT);
+	if (pkt || K_TIMEOUT_EQ(timeout, K_NO_WAIT)) {
+		return pkt;
+	}
+
+	/* The packets held back by a TX batch of this thread may be the
+	 * ones using up the memory, send them before waiting.
+	 */
+	net_if_tx_batch_flush();
+
+	return context_alloc_pkt_wait(context, len, timeout);
+}
+
 static void set_pkt_txtime(struct net_pkt *pkt, const struct msghdr *msghdr)
 {
 	struct cmsghdr *cmsg;
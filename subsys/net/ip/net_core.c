@@ -54,6 +54,7 @@ LOG_MODULE_REGISTER(net_core, CONFIG_NET_CORE_LOG_LEVEL);
 #include "ipv4_autoconf_internal.h"
 
 #include "net_stats.h"
+#include "capture.h"
 
 static inline enum net_verdict process_data(struct net_pkt *pkt,
 					    bool is_loopback)
@@ -76,6 +77,11 @@ static inline enum net_verdict process_data(struct net_pkt *pkt,
 	}
 #endif
 
+	/* Same for the reassembled IPv4 packets */
+	if (net_pkt_ipv4_reassembled(pkt)) {
+		locally_routed = true;
+	}
+
 	/* If there is no data, then drop the packet. */
 	if (!pkt->frags) {
 		NET_DBG("Corrupted packet (frags %p)", pkt->frags);
@@ -107,6 +113,11 @@ static inline enum net_verdict process_data(struct net_pkt *pkt,
 	 */
 	net_pkt_cursor_init(pkt);
 
+	/* Looped back packets were captured when they were sent */
+	if (!is_loopback && !locally_routed) {
+		net_capture_pkt(net_pkt_iface(pkt), pkt, NET_CAPTURE_IN);
+	}
+
 	/* IP version and header length. */
 	switch (NET_IPV6_HDR(pkt)->vtc & 0xf0) {
 #if defined(CONFIG_NET_IPV6)
@@ -286,6 +297,8 @@ int net_send_data(struct net_pkt *pkt)
 		return -EINVAL;
 	}
 
+	net_pkt_set_tx_stats_tick(pkt, NET_STATS_TX_DETAIL_SEND);
+
 #if defined(CONFIG_NET_STATISTICS)
 	switch (net_pkt_family(pkt)) {
 	case AF_INET:
@@ -303,11 +316,16 @@ int net_send_data(struct net_pkt *pkt)
 	status = check_ip_addr(pkt);
 	if (status < 0) {
 		return status;
-	} else if (status > 0) {
+	}
+
+	net_capture_pkt(net_pkt_iface(pkt), pkt, NET_CAPTURE_OUT);
+
+	if (status > 0) {
 		/* Packet is destined back to us so send it directly
 		 * to RX processing.
 		 */
 		NET_DBG("Loopback pkt %p back to us", pkt);
+		net_pkt_stats_tick_reset(pkt);
 		processing_data(pkt, true);
 		return 0;
 	}
@@ -324,6 +342,8 @@ static void net_rx(struct net_if *iface, struct net_pkt *pkt)
 	bool is_loopback = false;
 	size_t pkt_len;
 
+	net_pkt_set_rx_stats_tick(pkt, NET_STATS_RX_DETAIL_L2);
+
 	pkt_len = net_pkt_get_len(pkt);
 
 	NET_DBG("Received pkt %p len %zu", pkt, pkt_len);
@@ -388,6 +408,10 @@ int net_recv_data(struct net_if *iface, struct net_pkt *pkt)
 		return -ENETDOWN;
 	}
 
+	/* A looped back packet is a clone of a sent one */
+	net_pkt_stats_tick_reset(pkt);
+	net_pkt_set_rx_stats_tick(pkt, NET_STATS_RX_DETAIL_RECV);
+
 	net_pkt_set_overwrite(pkt, true);
 	net_pkt_cursor_init(pkt);
 
@@ -423,6 +447,7 @@ static inline void l3_init(void)
 	net_tcp_init();
 
 	net_route_init();
+	net_route_ipv4_init();
 
 	NET_DBG("Network L3 init done");
 }
@@ -21,6 +21,7 @@ LOG_MODULE_REGISTER(net_if, CONFIG_NET_IF_LOG_LEVEL);
 
 #include "net_private.h"
 #include "ipv6.h"
+#include "ipv4.h"
 #include "ipv4_autoconf_internal.h"
 
 #include "net_stats.h"
@@ -95,6 +96,11 @@ static sys_slist_t link_callbacks;
 static sys_slist_t mcast_monitor_callbacks;
 #endif
 
+/* Packets held back by the TX batch of tx_batch_owner */
+static K_FIFO_DEFINE(tx_batch_queue);
+static k_tid_t tx_batch_owner;
+static struct k_spinlock tx_batch_lock;
+
 #if defined(CONFIG_NET_PKT_TIMESTAMP_THREAD)
 #if !defined(CONFIG_NET_PKT_TIMESTAMP_STACK_SIZE)
 #define CONFIG_NET_PKT_TIMESTAMP_STACK_SIZE 1024
@@ -157,6 +163,9 @@ static bool net_if_tx(struct net_if *iface, struct net_pkt *pkt)
 	/* Timestamp of the current network packet sent if enabled */
 	struct net_ptp_time start_timestamp;
 	uint32_t curr_time = 0;
+#if defined(CONFIG_NET_PKT_TXTIME_STATS_DETAIL)
+	uint32_t stats_tick[NET_STATS_TX_DETAIL_COUNT];
+#endif
 
 	/* We collect send statistics for each socket priority if enabled */
 	uint8_t pkt_priority;
@@ -204,6 +213,12 @@ static bool net_if_tx(struct net_if *iface, struct net_pkt *pkt)
 			pkt_priority = net_pkt_priority(pkt);
 		}
 
+#if defined(CONFIG_NET_PKT_TXTIME_STATS_DETAIL)
+		/* The packet can be freed when it has been sent */
+		net_pkt_set_tx_stats_tick(pkt, NET_STATS_TX_DETAIL_L2);
+		memcpy(stats_tick, net_pkt_stats_tick(pkt), sizeof(stats_tick));
+#endif
+
 		status = net_if_l2(iface)->send(iface, pkt);
 
 		if (IS_ENABLED(CONFIG_NET_CONTEXT_TIMESTAMP) && status >= 0 &&
@@ -220,6 +235,14 @@ static bool net_if_tx(struct net_if *iface, struct net_pkt *pkt)
 						    k_cycle_get_32());
 		}
 
+#if defined(CONFIG_NET_PKT_TXTIME_STATS_DETAIL)
+		if (status >= 0) {
+			net_stats_update_tx_time_detail(iface,
+							start_timestamp.nanosecond,
+							stats_tick, k_cycle_get_32());
+		}
+#endif
+
 	} else {
 		/* Drop packet if interface is not up */
 		NET_WARN("iface %p is down", iface);
@@ -274,7 +297,7 @@ static void process_tx_packet(struct k_work *work)
 #endif
 }
 
-void net_if_queue_tx(struct net_if *iface, struct net_pkt *pkt)
+static void submit_tx_packet(struct net_if *iface, struct net_pkt *pkt)
 {
 	uint8_t prio = net_pkt_priority(pkt);
 	uint8_t tc = net_tx_priority2tc(prio);
@@ -301,6 +324,65 @@ void net_if_queue_tx(struct net_if *iface, struct net_pkt *pkt)
 	}
 }
 
+static bool tx_batch_is_mine(void)
+{
+	return !k_is_in_isr() && tx_batch_owner == k_current_get();
+}
+
+void net_if_queue_tx(struct net_if *iface, struct net_pkt *pkt)
+{
+	if (tx_batch_is_mine()) {
+		k_fifo_put(&tx_batch_queue, pkt);
+		return;
+	}
+
+	submit_tx_packet(iface, pkt);
+}
+
+bool net_if_tx_batch_begin(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&tx_batch_lock);
+	bool started = false;
+
+	if (!tx_batch_owner) {
+		tx_batch_owner = k_current_get();
+		started = true;
+	}
+
+	k_spin_unlock(&tx_batch_lock, key);
+
+	return started;
+}
+
+void net_if_tx_batch_flush(void)
+{
+	struct net_pkt *pkt;
+
+	if (!tx_batch_is_mine()) {
+		return;
+	}
+
+	/* The TX threads run once the whole batch is queued */
+	k_sched_lock();
+
+	while ((pkt = k_fifo_get(&tx_batch_queue, K_NO_WAIT)) != NULL) {
+		submit_tx_packet(net_pkt_iface(pkt), pkt);
+	}
+
+	k_sched_unlock();
+}
+
+void net_if_tx_batch_end(void)
+{
+	if (!tx_batch_is_mine()) {
+		return;
+	}
+
+	net_if_tx_batch_flush();
+
+	tx_batch_owner = NULL;
+}
+
 void net_if_stats_reset(struct net_if *iface)
 {
 #if defined(CONFIG_NET_STATISTICS_PER_INTERFACE)
@@ -387,6 +469,9 @@ enum net_verdict net_if_send_data(struct net_if *iface, struct net_pkt *pkt)
 	 */
 	if (IS_ENABLED(CONFIG_NET_IPV6) && net_pkt_family(pkt) == AF_INET6) {
 		verdict = net_ipv6_prepare_for_send(pkt);
+	} else if (IS_ENABLED(CONFIG_NET_IPV4) &&
+		   net_pkt_family(pkt) == AF_INET) {
+		verdict = net_ipv4_prepare_for_send(pkt);
 	}
 
 done:
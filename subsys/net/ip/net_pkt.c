@@ -119,6 +119,38 @@ NET_BUF_POOL_FIXED_DEFINE(rx_bufs, CONFIG_NET_BUF_RX_COUNT,
 NET_BUF_POOL_FIXED_DEFINE(tx_bufs, CONFIG_NET_BUF_TX_COUNT,
 			  CONFIG_NET_BUF_DATA_SIZE, NULL);
 
+#if defined(CONFIG_NET_BUF_SIZE_CLASSES)
+
+BUILD_ASSERT(CONFIG_NET_BUF_DATA_SIZE < CONFIG_NET_BUF_MEDIUM_DATA_SIZE &&
+	     CONFIG_NET_BUF_MEDIUM_DATA_SIZE < CONFIG_NET_BUF_LARGE_DATA_SIZE,
+	     "Network buffer size classes must be in increasing order");
+
+NET_BUF_POOL_FIXED_DEFINE(rx_bufs_medium, CONFIG_NET_BUF_RX_MEDIUM_COUNT,
+			  CONFIG_NET_BUF_MEDIUM_DATA_SIZE, NULL);
+NET_BUF_POOL_FIXED_DEFINE(tx_bufs_medium, CONFIG_NET_BUF_TX_MEDIUM_COUNT,
+			  CONFIG_NET_BUF_MEDIUM_DATA_SIZE, NULL);
+NET_BUF_POOL_FIXED_DEFINE(rx_bufs_large, CONFIG_NET_BUF_RX_LARGE_COUNT,
+			  CONFIG_NET_BUF_LARGE_DATA_SIZE, NULL);
+NET_BUF_POOL_FIXED_DEFINE(tx_bufs_large, CONFIG_NET_BUF_TX_LARGE_COUNT,
+			  CONFIG_NET_BUF_LARGE_DATA_SIZE, NULL);
+
+/* Size classes, from the smallest to the largest */
+static const size_t size_classes[] = {
+	CONFIG_NET_BUF_DATA_SIZE,
+	CONFIG_NET_BUF_MEDIUM_DATA_SIZE,
+	CONFIG_NET_BUF_LARGE_DATA_SIZE,
+};
+
+static struct net_buf_pool * const rx_classes[] = {
+	&rx_bufs, &rx_bufs_medium, &rx_bufs_large,
+};
+
+static struct net_buf_pool * const tx_classes[] = {
+	&tx_bufs, &tx_bufs_medium, &tx_bufs_large,
+};
+
+#endif /* CONFIG_NET_BUF_SIZE_CLASSES */
+
 #else /* !CONFIG_NET_BUF_FIXED_DATA_SIZE */
 
 NET_BUF_POOL_VAR_DEFINE(rx_bufs, CONFIG_NET_BUF_RX_COUNT,
@@ -277,6 +309,14 @@ const char *net_pkt_pool2str(struct net_buf_pool *pool)
 		return "TDATA";
 	}
 
+#if defined(CONFIG_NET_BUF_SIZE_CLASSES)
+	if (pool == &rx_bufs_medium || pool == &rx_bufs_large) {
+		return "RDATA";
+	} else if (pool == &tx_bufs_medium || pool == &tx_bufs_large) {
+		return "TDATA";
+	}
+#endif
+
 	return "EDATA";
 }
 #endif
@@ -848,6 +888,112 @@ void net_pkt_print(void)
 
 #if defined(CONFIG_NET_BUF_FIXED_DATA_SIZE)
 
+#if defined(CONFIG_NET_BUF_SIZE_CLASSES)
+/* Smallest class holding size, or the largest class if none does */
+static int size_class_fit(size_t size)
+{
+	int class;
+
+	for (class = 0; class < ARRAY_SIZE(size_classes) - 1; class++) {
+		if (size <= size_classes[class]) {
+			break;
+		}
+	}
+
+	return class;
+}
+
+/* Largest class not bigger than size */
+static int size_class_below(size_t size)
+{
+	int class;
+
+	for (class = ARRAY_SIZE(size_classes) - 1; class > 0; class--) {
+		if (size_classes[class] <= size) {
+			break;
+		}
+	}
+
+	return class;
+}
+
+/* Bytes left unused when size is filled with the largest buffers not
+ * bigger than the rest, and a small buffer for the last bytes.
+ */
+static size_t size_class_fill_waste(size_t size)
+{
+	while (size > size_classes[0]) {
+		size -= size_classes[size_class_below(size)];
+	}
+
+	return size ? size_classes[0] - size : 0;
+}
+
+/* Class of the next buffer for size bytes. One buffer holding all of it
+ * is preferred, unless filling it with smaller buffers wastes less. For
+ * instance 576 bytes take two medium and one small buffer instead of a
+ * large one.
+ */
+static int size_class_pick(size_t size)
+{
+	int class = size_class_fit(size);
+
+	if (size <= size_classes[0] || size >= size_classes[class]) {
+		return class;
+	}
+
+	if (size_classes[class] - size > size_class_fill_waste(size)) {
+		return size_class_below(size);
+	}
+
+	return class;
+}
+
+/* Allocate from the class picked for size. When that class is exhausted,
+ * try the larger classes and then the smaller ones before waiting on the
+ * picked class.
+ */
+static struct net_buf *pkt_alloc_size_class(struct net_buf_pool *pool,
+					    size_t size, k_timeout_t timeout)
+{
+	struct net_buf_pool * const *classes;
+	struct net_buf *buf;
+	int class;
+	int i;
+
+	if (pool == &rx_bufs) {
+		classes = rx_classes;
+	} else if (pool == &tx_bufs) {
+		classes = tx_classes;
+	} else {
+		/* Data pool of a net_context */
+		return net_buf_alloc_fixed(pool, timeout);
+	}
+
+	class = size_class_pick(size);
+
+	for (i = class; i < ARRAY_SIZE(size_classes); i++) {
+		buf = net_buf_alloc_fixed(classes[i], K_NO_WAIT);
+		if (buf) {
+			return buf;
+		}
+	}
+
+	for (i = class - 1; i >= 0; i--) {
+		buf = net_buf_alloc_fixed(classes[i], K_NO_WAIT);
+		if (buf) {
+			return buf;
+		}
+	}
+
+	if (K_TIMEOUT_EQ(timeout, K_NO_WAIT)) {
+		return NULL;
+	}
+
+	return net_buf_alloc_fixed(classes[class], timeout);
+}
+#endif /* CONFIG_NET_BUF_SIZE_CLASSES */
+
 #if NET_LOG_LEVEL >= LOG_LEVEL_DBG
 static struct net_buf *pkt_alloc_buffer(struct net_buf_pool *pool,
 					size_t size, k_timeout_t timeout,
@@ -864,7 +1010,11 @@ static struct net_buf *pkt_alloc_buffer(struct net_buf_pool *pool,
 	while (size) {
 		struct net_buf *new;
 
+#if defined(CONFIG_NET_BUF_SIZE_CLASSES)
+		new = pkt_alloc_size_class(pool, size, timeout);
+#else
 		new = net_buf_alloc_fixed(pool, timeout);
+#endif
 		if (!new) {
 			goto error;
 		}
@@ -968,6 +1118,11 @@ static size_t pkt_buffer_length(struct net_pkt *pkt,
 
 		max_len = MAX(max_len, NET_IPV6_MTU);
 	} else if (IS_ENABLED(CONFIG_NET_IPV4) && family == AF_INET) {
+		if (IS_ENABLED(CONFIG_NET_IPV4_FRAGMENT) && (size > max_len)) {
+			/* Same for IPv4 */
+			max_len = size;
+		}
+
 		max_len = MAX(max_len, NET_IPV4_MTU);
 	} else { /* family == AF_UNSPEC */
 #if defined (CONFIG_NET_L2_ETHERNET)
@@ -1724,8 +1879,15 @@ static void clone_pkt_attributes(struct net_pkt *pkt, struct net_pkt *clone_pkt)
 	net_pkt_set_vlan_tag(clone_pkt, net_pkt_vlan_tag(pkt));
 	net_pkt_set_timestamp(clone_pkt, net_pkt_timestamp(pkt));
 	net_pkt_set_priority(clone_pkt, net_pkt_priority(pkt));
+	net_pkt_set_flow_hash(clone_pkt, net_pkt_flow_hash(pkt));
 	net_pkt_set_orig_iface(clone_pkt, net_pkt_orig_iface(pkt));
 
+#if defined(CONFIG_NET_PKT_RXTIME_STATS_DETAIL) || \
+	defined(CONFIG_NET_PKT_TXTIME_STATS_DETAIL)
+	memcpy(net_pkt_stats_tick(clone_pkt), net_pkt_stats_tick(pkt),
+	       sizeof(pkt->stats_tick));
+#endif
+
 	if (IS_ENABLED(CONFIG_NET_IPV4) && net_pkt_family(pkt) == AF_INET) {
 		net_pkt_set_ipv4_ttl(clone_pkt, net_pkt_ipv4_ttl(pkt));
 		net_pkt_set_ipv4_opts_len(clone_pkt,
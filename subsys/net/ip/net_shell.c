@@ -35,7 +35,12 @@ LOG_MODULE_REGISTER(net_shell, LOG_LEVEL_DBG);
 #include "tcp_internal.h"
 #endif
 
+#if defined(CONFIG_NET_TCP2)
+#include "tcp2.h"
+#endif
+
 #include "ipv6.h"
+#include "ipv4.h"
 
 #if defined(CONFIG_NET_ARP)
 #include "ethernet/arp.h"
@@ -69,6 +74,14 @@ LOG_MODULE_REGISTER(net_shell, LOG_LEVEL_DBG);
 #include <sys/fdtable.h>
 #include "websocket/websocket_internal.h"
 
+#if defined(CONFIG_NET_CAPTURE)
+#include <net/capture.h>
+#endif
+
+#if defined(CONFIG_NET_SOCKETS)
+#include <net/socket.h>
+#endif
+
 #define PR(fmt, ...)						\
 	shell_fprintf(shell, SHELL_NORMAL, fmt, ##__VA_ARGS__)
 
@@ -848,6 +861,60 @@ static void print_tc_rx_stats(const struct shell *shell, struct net_if *iface)
 #endif /* NET_TC_RX_COUNT > 1 */
 }
 
+static void print_tx_time_detail_stats(const struct shell *shell,
+				       struct net_if *iface)
+{
+#if defined(CONFIG_NET_PKT_TXTIME_STATS_DETAIL)
+	static const char * const names[] = { "l4", "ip", "queue", "l2" };
+	net_stats_t count;
+	int i;
+
+	BUILD_ASSERT(ARRAY_SIZE(names) == NET_STATS_TX_DETAIL_COUNT + 1);
+
+	PR("Avg %s net_pkt time per layer (cycles):", "TX");
+
+	for (i = 0; i < ARRAY_SIZE(names); i++) {
+		count = GET_STAT(iface, tx_time_detail[i].count);
+		PR(" %s %u", names[i], count == 0 ? 0 :
+		   (uint32_t)(GET_STAT(iface, tx_time_detail[i].sum) /
+			      (uint64_t)count));
+	}
+
+	PR("\n");
+#else
+	ARG_UNUSED(shell);
+	ARG_UNUSED(iface);
+#endif /* CONFIG_NET_PKT_TXTIME_STATS_DETAIL */
+}
+
+static void print_rx_time_detail_stats(const struct shell *shell,
+				       struct net_if *iface)
+{
+#if defined(CONFIG_NET_PKT_RXTIME_STATS_DETAIL)
+	static const char * const names[] = {
+		"driver", "queue", "l2", "ip", "l4"
+	};
+	net_stats_t count;
+	int i;
+
+	BUILD_ASSERT(ARRAY_SIZE(names) == NET_STATS_RX_DETAIL_COUNT + 1);
+
+	PR("Avg %s net_pkt time per layer (cycles):", "RX");
+
+	for (i = 0; i < ARRAY_SIZE(names); i++) {
+		count = GET_STAT(iface, rx_time_detail[i].count);
+		PR(" %s %u", names[i], count == 0 ? 0 :
+		   (uint32_t)(GET_STAT(iface, rx_time_detail[i].sum) /
+			      (uint64_t)count));
+	}
+
+	PR("\n");
+#else
+	ARG_UNUSED(shell);
+	ARG_UNUSED(iface);
+#endif /* CONFIG_NET_PKT_RXTIME_STATS_DETAIL */
+}
+
 static void print_net_pm_stats(const struct shell *shell, struct net_if *iface)
 {
 #if defined(CONFIG_NET_STATISTICS_POWER_MANAGEMENT)
@@ -974,6 +1041,8 @@ static void net_shell_print_statistics(struct net_if *iface, void *user_data)
 
 	print_tc_tx_stats(shell, iface);
 	print_tc_rx_stats(shell, iface);
+	print_tx_time_detail_stats(shell, iface);
+	print_rx_time_detail_stats(shell, iface);
 
 #if defined(CONFIG_NET_STATISTICS_ETHERNET) && \
 					defined(CONFIG_NET_STATISTICS_USER_API)
@@ -1220,50 +1289,73 @@ static void tcp_sent_list_cb(struct net_tcp *tcp, void *user_data)
 #endif /* CONFIG_NET_TCP_LOG_LEVEL >= LOG_LEVEL_DBG */
 #endif
 
-#if defined(CONFIG_NET_IPV6_FRAGMENT)
-static void ipv6_frag_cb(struct net_ipv6_reassembly *reass,
-			 void *user_data)
+#if defined(CONFIG_NET_TCP2) && defined(CONFIG_NET_NATIVE)
+static void tcp_info_cb(const struct net_tcp_info *info, void *user_data)
 {
 	struct net_shell_user_data *data = user_data;
 	const struct shell *shell = data->shell;
 	int *count = data->user_data;
+
+	PR("%p   %5u    %5u %10u %10u %5u   %s\n",
+	   info->context,
+	   ntohs(net_sin6_ptr(&info->context->local)->sin6_port),
+	   ntohs(net_sin6(&info->context->remote)->sin6_port),
+	   info->seq, info->ack, info->mss, info->state);
+	PR("           %-8s cwnd %u ssthresh %u wnd %u unacked %d "
+	   "srtt %u rttvar %u rto %u ms\n",
+	   info->cc ? info->cc : "none", info->cwnd, info->ssthresh,
+	   info->send_win, info->unacked_len, info->srtt, info->rttvar,
+	   info->rto);
+
+	(*count)++;
+}
+#endif /* CONFIG_NET_TCP2 && CONFIG_NET_NATIVE */
+
+#if defined(CONFIG_NET_IPV6_FRAGMENT) || defined(CONFIG_NET_IPV4_FRAGMENT)
+static void frag_cb(struct net_reassembly *reass,
+		    void *user_data)
+{
+	struct net_shell_user_data *data = user_data;
+	const struct shell *shell = data->shell;
+	int *count = data->user_data;
+	struct net_reassembly_frag *frag;
 	char src[ADDR_LEN];
-	int i;
 
 	if (!*count) {
-		PR("\nIPv6 reassembly Id         Remain "
-		   "Src             \tDst\n");
+		PR("\n%s reassembly Id         Remain "
+		   "Src             \tDst\n",
+		   reass->family == AF_INET6 ? "IPv6" : "IPv4");
 	}
 
-	snprintk(src, ADDR_LEN, "%s", net_sprint_ipv6_addr(&reass->src));
+	snprintk(src, ADDR_LEN, "%s",
+		 net_sprint_addr(reass->family, &reass->src));
 
 	PR("%p      0x%08x  %5d %16s\t%16s\n",
 	   reass, reass->id,
 	   k_delayed_work_remaining_get(&reass->timer),
-	   src, net_sprint_ipv6_addr(&reass->dst));
+	   src, net_sprint_addr(reass->family, &reass->dst));
 
-	for (i = 0; i < NET_IPV6_FRAGMENTS_MAX_PKT; i++) {
-		if (reass->pkt[i]) {
-			struct net_buf *frag = reass->pkt[i]->frags;
+	NET_REASSEMBLY_FOR_EACH_FRAG(reass, frag) {
+		struct net_buf *buf = frag->pkt->frags;
 
-			PR("[%d] pkt %p->", i, reass->pkt[i]);
+		PR("[%u-%u] pkt %p->", frag->offset, frag->offset + frag->len,
+		   frag->pkt);
 
-			while (frag) {
-				PR("%p", frag);
+		while (buf) {
+			PR("%p", buf);
 
-				frag = frag->frags;
-				if (frag) {
-					PR("->");
-				}
+			buf = buf->frags;
+			if (buf) {
+				PR("->");
 			}
-
-			PR("\n");
 		}
+
+		PR("\n");
 	}
 
 	(*count)++;
 }
-#endif /* CONFIG_NET_IPV6_FRAGMENT */
+#endif /* CONFIG_NET_IPV6_FRAGMENT || CONFIG_NET_IPV4_FRAGMENT */
 
 #if defined(CONFIG_NET_DEBUG_NET_PKT_ALLOC)
 static void allocs_cb(struct net_pkt *pkt,
@@ -1424,6 +1516,222 @@ static int cmd_net_arp_flush(const struct shell *shell, size_t argc,
 	return 0;
 }
 
+#if defined(CONFIG_NET_CAPTURE)
+struct capture_dump_data {
+	const struct shell *shell;
+	size_t offset;
+};
+
+/* Print the pcapng data in the xxd format, "xxd -r" restores the file */
+static int capture_dump_cb(const void *data, size_t len, void *user_data)
+{
+	struct capture_dump_data *dump = user_data;
+	const struct shell *shell = dump->shell;
+	const uint8_t *pos = data;
+	char line[8 * 5 + 1];
+	size_t chunk;
+	int i;
+
+	while (len > 0) {
+		chunk = MIN(len, 16);
+
+		for (i = 0; i < chunk; i++) {
+			snprintk(&line[i * 5 / 2], sizeof(line) - i * 5 / 2,
+				 (i & 1) ? "%02x " : "%02x", pos[i]);
+		}
+
+		PR("%08zx: %s\n", dump->offset, line);
+
+		dump->offset += chunk;
+		pos += chunk;
+		len -= chunk;
+	}
+
+	return 0;
+}
+#endif /* CONFIG_NET_CAPTURE */
+
+#if !defined(CONFIG_NET_CAPTURE)
+static void print_capture_error(const struct shell *shell)
+{
+	PR_INFO("Set %s to enable %s support.\n", "CONFIG_NET_CAPTURE",
+		"packet capture");
+}
+#endif
+
+static int cmd_net_capture(const struct shell *shell, size_t argc,
+			   char *argv[])
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+#if defined(CONFIG_NET_CAPTURE)
+	struct net_capture_stats stats;
+
+	net_capture_get_stats(&stats);
+
+	PR("Capture is %s\n", net_capture_is_active() ? "running" : "stopped");
+	PR("Captured %u filtered %u dropped %u\n", stats.captured,
+	   stats.filtered, stats.dropped);
+#else
+	print_capture_error(shell);
+#endif
+
+	return 0;
+}
+
+static int cmd_net_capture_dump(const struct shell *shell, size_t argc,
+				char *argv[])
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+#if defined(CONFIG_NET_CAPTURE)
+	struct capture_dump_data dump = {
+		.shell = shell,
+	};
+	int ret;
+
+	ret = net_capture_export(capture_dump_cb, &dump, true);
+
+	PR("Dumped %d packets\n", ret);
+#else
+	print_capture_error(shell);
+#endif
+
+	return 0;
+}
+
+static int cmd_net_capture_send(const struct shell *shell, size_t argc,
+				char *argv[])
+{
+#if defined(CONFIG_NET_CAPTURE) && defined(CONFIG_NET_SOCKETS)
+	bool tcp = argc > 2 && strcmp(argv[2], "tcp") == 0;
+	struct sockaddr addr;
+	int sock, ret;
+
+	memset(&addr, 0, sizeof(addr));
+
+	if (argc < 2 || !net_ipaddr_parse(argv[1], strlen(argv[1]), &addr) ||
+	    net_sin(&addr)->sin_port == 0U) {
+		PR_WARNING("Invalid address, give <address>:<port>\n");
+		return -ENOEXEC;
+	}
+
+	sock = zsock_socket(addr.sa_family, tcp ? SOCK_STREAM : SOCK_DGRAM,
+			    tcp ? IPPROTO_TCP : IPPROTO_UDP);
+	if (sock < 0) {
+		PR_WARNING("Cannot create socket (%d)\n", -errno);
+		return -ENOEXEC;
+	}
+
+	if (zsock_connect(sock, &addr, addr.sa_family == AF_INET ?
+			  sizeof(struct sockaddr_in) :
+			  sizeof(struct sockaddr_in6)) < 0) {
+		PR_WARNING("Cannot connect (%d)\n", -errno);
+		zsock_close(sock);
+		return -ENOEXEC;
+	}
+
+	ret = net_capture_export_socket(sock, true);
+	if (ret < 0) {
+		PR_WARNING("Cannot send packets (%d)\n", ret);
+	} else {
+		PR("Sent %d packets\n", ret);
+	}
+
+	zsock_close(sock);
+#elif defined(CONFIG_NET_CAPTURE)
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	PR_INFO("Set %s to enable %s support.\n", "CONFIG_NET_SOCKETS",
+		"sending captured packets");
+#else
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	print_capture_error(shell);
+#endif
+
+	return 0;
+}
+
+static int cmd_net_capture_start(const struct shell *shell, size_t argc,
+				 char *argv[])
+{
+#if defined(CONFIG_NET_CAPTURE)
+	struct net_if *iface = NULL;
+	char expr[128];
+	size_t len = 0;
+	int arg = 1;
+	char *endptr;
+	int ret, idx;
+
+	if (argv[arg] && strcmp(argv[arg], "-i") == 0) {
+		if (!argv[++arg]) {
+			PR_WARNING("Interface index is missing.\n");
+			return -ENOEXEC;
+		}
+
+		idx = strtol(argv[arg], &endptr, 10);
+		iface = net_if_get_by_index(idx);
+		if (*endptr != '\0' || !iface) {
+			PR_WARNING("Invalid index %s\n", argv[arg]);
+			return -ENOEXEC;
+		}
+
+		arg++;
+	}
+
+	/* The rest of the arguments is the filter expression */
+	expr[0] = '\0';
+
+	for (; arg < argc; arg++) {
+		ret = snprintk(&expr[len], sizeof(expr) - len, "%s%s",
+			       len ? " " : "", argv[arg]);
+		if (ret < 0 || ret >= sizeof(expr) - len) {
+			PR_WARNING("Filter is too long.\n");
+			return -ENOEXEC;
+		}
+
+		len += ret;
+	}
+
+	ret = net_capture_start(iface, expr);
+	if (ret < 0) {
+		PR_WARNING("Invalid filter '%s' (%d)\n", expr, ret);
+		return -ENOEXEC;
+	}
+
+	PR("Capturing packets\n");
+#else
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	print_capture_error(shell);
+#endif
+
+	return 0;
+}
+
+static int cmd_net_capture_stop(const struct shell *shell, size_t argc,
+				char *argv[])
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+#if defined(CONFIG_NET_CAPTURE)
+	net_capture_stop();
+
+	PR("Capture stopped\n");
+#else
+	print_capture_error(shell);
+#endif
+
+	return 0;
+}
+
 static int cmd_net_conn(const struct shell *shell, size_t argc, char *argv[])
 {
 	ARG_UNUSED(argc);
@@ -1479,16 +1787,33 @@ static int cmd_net_conn(const struct shell *shell, size_t argc, char *argv[])
 		"CONFIG_NET_TCP_LOG_LEVEL_DBG", "TCP debugging");
 #endif /* CONFIG_NET_TCP_LOG_LEVEL < LOG_LEVEL_DBG */
 
+#elif defined(CONFIG_NET_TCP2) && defined(CONFIG_NET_NATIVE)
+	PR("\nContext          Src port Dst port   "
+	   "Send-Seq   Send-Ack  MSS    State\n");
+
+	count = 0;
+
+	net_tcp_info_foreach(tcp_info_cb, &user_data);
+
+	if (count == 0) {
+		PR("No TCP connections\n");
+	}
 #endif
 
 #if defined(CONFIG_NET_IPV6_FRAGMENT)
 	count = 0;
 
-	net_ipv6_frag_foreach(ipv6_frag_cb, &user_data);
+	net_ipv6_frag_foreach(frag_cb, &user_data);
 
 	/* Do not print anything if no fragments are pending atm */
 #endif
 
+#if defined(CONFIG_NET_IPV4_FRAGMENT)
+	count = 0;
+
+	net_ipv4_frag_foreach(frag_cb, &user_data);
+#endif
+
 #else
 	PR_INFO("Set %s to enable %s support.\n",
 		"CONFIG_NET_OFFLOAD or CONFIG_NET_NATIVE",
@@ -1640,6 +1965,92 @@ static int cmd_net_dns_cancel(const struct shell *shell, size_t argc,
 	return 0;
 }
 
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+static void dns_cache_cb(const struct dns_cache_entry *entry, void *user_data)
+{
+	struct net_shell_user_data *data = user_data;
+	const struct shell *shell = data->shell;
+	int *count = data->user_data;
+	int32_t remaining = (entry->expiry - k_uptime_get()) / MSEC_PER_SEC;
+	char addr[NET_IPV6_ADDR_LEN];
+	int i;
+
+	if (*count == 0) {
+		PR("     Name                     Type TTL   Addresses\n");
+	}
+
+	PR("[%2d] %-24s %-4s %-5d%s\n", ++(*count), entry->name,
+	   entry->type == DNS_QUERY_TYPE_A ? "A" : "AAAA", remaining,
+	   entry->count ? "" : (entry->rcode ? "<no name>" : "<none>"));
+
+	for (i = 0; i < entry->count; i++) {
+		const struct sockaddr *sa = &entry->addr[i];
+
+		if (sa->sa_family == AF_INET) {
+			net_addr_ntop(AF_INET, &net_sin(sa)->sin_addr,
+				      addr, sizeof(addr));
+		} else {
+			net_addr_ntop(AF_INET6, &net_sin6(sa)->sin6_addr,
+				      addr, sizeof(addr));
+		}
+
+		PR("%40s%s\n", "", addr);
+	}
+}
+#endif /* CONFIG_DNS_RESOLVER_CACHE */
+
+static int cmd_net_dns_cache(const struct shell *shell, size_t argc,
+			     char *argv[])
+{
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+	struct net_shell_user_data user_data;
+	struct dns_cache_stats stats;
+	int count = 0;
+#endif
+
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+	user_data.shell = shell;
+	user_data.user_data = &count;
+
+	dns_cache_foreach(dns_cache_cb, &user_data);
+
+	if (count == 0) {
+		PR("DNS cache is empty.\n");
+	}
+
+	dns_cache_get_stats(&stats);
+
+	PR("Hits %u negative %u misses %u added %u evicted %u\n",
+	   stats.hits, stats.negative_hits, stats.misses, stats.added,
+	   stats.evicted);
+#else
+	PR_INFO("Set %s to enable %s support.\n",
+		"CONFIG_DNS_RESOLVER_CACHE", "DNS cache");
+#endif
+
+	return 0;
+}
+
+static int cmd_net_dns_flush(const struct shell *shell, size_t argc,
+			     char *argv[])
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+	PR("Flushing DNS cache.\n");
+	dns_cache_flush();
+#else
+	PR_INFO("Set %s to enable %s support.\n",
+		"CONFIG_DNS_RESOLVER_CACHE", "DNS cache");
+#endif
+
+	return 0;
+}
+
 static int cmd_net_dns_query(const struct shell *shell, size_t argc,
 			     char *argv[])
 {
@@ -4274,9 +4685,31 @@ SHELL_STATIC_SUBCMD_SET_CREATE(net_cmd_arp,
 	SHELL_SUBCMD_SET_END
 );
 
+SHELL_STATIC_SUBCMD_SET_CREATE(net_cmd_capture,
+	SHELL_CMD(dump, NULL,
+		  "Print the captured packets as a pcapng file in hex, "
+		  "'xxd -r' converts it back to binary.",
+		  cmd_net_capture_dump),
+	SHELL_CMD(send, NULL,
+		  "'net capture send <address>:<port> [tcp]' sends the "
+		  "captured packets as a pcapng stream over UDP or TCP.",
+		  cmd_net_capture_send),
+	SHELL_CMD(start, NULL,
+		  "'net capture start [-i <index>] [<filter>]' captures the "
+		  "packets matching a filter like 'udp and port 5353'.",
+		  cmd_net_capture_start),
+	SHELL_CMD(stop, NULL, "Stop capturing packets.",
+		  cmd_net_capture_stop),
+	SHELL_SUBCMD_SET_END
+);
+
 SHELL_STATIC_SUBCMD_SET_CREATE(net_cmd_dns,
+	SHELL_CMD(cache, NULL, "Show the cached DNS answers.",
+		  cmd_net_dns_cache),
 	SHELL_CMD(cancel, NULL, "Cancel all pending requests.",
 		  cmd_net_dns_cancel),
+	SHELL_CMD(flush, NULL, "Remove all the cached DNS answers.",
+		  cmd_net_dns_flush),
 	SHELL_CMD(query, NULL,
 		  "'net dns <hostname> [A or AAAA]' queries IPv4 address "
 		  "(default) or IPv6 address for a host name.",
@@ -4567,6 +5000,9 @@ SHELL_STATIC_SUBCMD_SET_CREATE(net_commands,
 		  cmd_net_allocs),
 	SHELL_CMD(arp, &net_cmd_arp, "Print information about IPv4 ARP cache.",
 		  cmd_net_arp),
+	SHELL_CMD(capture, &net_cmd_capture,
+		  "Capture packets and show the capture statistics.",
+		  cmd_net_capture),
 	SHELL_CMD(conn, NULL, "Print information about network connections.",
 		  cmd_net_conn),
 	SHELL_CMD(dns, &net_cmd_dns, "Show how DNS is configured.",
@@ -349,6 +349,65 @@ static inline void net_stats_update_rx_time(struct net_if *iface,
 #define net_stats_update_rx_time(iface, start_time, end_time)
 #endif /* NET_CONTEXT_TIMESTAMP && STATISTICS */
 
+#if defined(CONFIG_NET_PKT_TXTIME_STATS_DETAIL) && \
+	defined(CONFIG_NET_STATISTICS)
+/* The ticks of the points the packet did not pass are zero, and their
+ * time is counted to the next point.
+ */
+static inline void net_stats_update_tx_time_detail(struct net_if *iface,
+						   uint32_t start_time,
+						   const uint32_t *ticks,
+						   uint32_t end_time)
+{
+	uint32_t prev = start_time;
+	int i;
+
+	for (i = 0; i < NET_STATS_TX_DETAIL_COUNT; i++) {
+		if (ticks[i] == 0U) {
+			continue;
+		}
+
+		UPDATE_STAT(iface, stats.tx_time_detail[i].sum +=
+			    ticks[i] - prev);
+		UPDATE_STAT(iface, stats.tx_time_detail[i].count += 1);
+		prev = ticks[i];
+	}
+
+	UPDATE_STAT(iface, stats.tx_time_detail[i].sum += end_time - prev);
+	UPDATE_STAT(iface, stats.tx_time_detail[i].count += 1);
+}
+#else
+#define net_stats_update_tx_time_detail(iface, start_time, ticks, end_time)
+#endif /* NET_PKT_TXTIME_STATS_DETAIL && NET_STATISTICS */
+
+#if defined(CONFIG_NET_PKT_RXTIME_STATS_DETAIL) && \
+	defined(CONFIG_NET_STATISTICS)
+static inline void net_stats_update_rx_time_detail(struct net_if *iface,
+						   uint32_t start_time,
+						   const uint32_t *ticks,
+						   uint32_t end_time)
+{
+	uint32_t prev = start_time;
+	int i;
+
+	for (i = 0; i < NET_STATS_RX_DETAIL_COUNT; i++) {
+		if (ticks[i] == 0U) {
+			continue;
+		}
+
+		UPDATE_STAT(iface, stats.rx_time_detail[i].sum +=
+			    ticks[i] - prev);
+		UPDATE_STAT(iface, stats.rx_time_detail[i].count += 1);
+		prev = ticks[i];
+	}
+
+	UPDATE_STAT(iface, stats.rx_time_detail[i].sum += end_time - prev);
+	UPDATE_STAT(iface, stats.rx_time_detail[i].count += 1);
+}
+#else
+#define net_stats_update_rx_time_detail(iface, start_time, ticks, end_time)
+#endif /* NET_PKT_RXTIME_STATS_DETAIL && NET_STATISTICS */
+
 #if (NET_TC_COUNT > 1) && defined(CONFIG_NET_STATISTICS) \
 	&& defined(CONFIG_NET_NATIVE)
 static inline void net_stats_update_tc_sent_pkt(struct net_if *iface, uint8_t tc)
@@ -13,6 +13,7 @@ LOG_MODULE_REGISTER(net_tc, CONFIG_NET_TC_LOG_LEVEL);
 #include <net/net_core.h>
 #include <net/net_pkt.h>
 #include <net/net_stats.h>
+#include <net/ethernet.h>
 
 #include "net_private.h"
 #include "net_stats.h"
@@ -22,12 +23,14 @@ LOG_MODULE_REGISTER(net_tc, CONFIG_NET_TC_LOG_LEVEL);
 K_THREAD_STACK_ARRAY_DEFINE(tx_stack, NET_TC_TX_COUNT,
 			    CONFIG_NET_TX_STACK_SIZE);
 
-/* Stacks for RX work queue */
-K_THREAD_STACK_ARRAY_DEFINE(rx_stack, NET_TC_RX_COUNT,
+/* Stacks for RX work queue, NET_RX_FLOW_QUEUES for each traffic class */
+#define RX_QUEUE_COUNT (NET_TC_RX_COUNT * NET_RX_FLOW_QUEUES)
+
+K_THREAD_STACK_ARRAY_DEFINE(rx_stack, RX_QUEUE_COUNT,
 			    CONFIG_NET_RX_STACK_SIZE);
 
 static struct net_traffic_class tx_classes[NET_TC_TX_COUNT];
-static struct net_traffic_class rx_classes[NET_TC_RX_COUNT];
+static struct net_traffic_class rx_classes[RX_QUEUE_COUNT];
 
 bool net_tc_submit_to_tx_queue(uint8_t tc, struct net_pkt *pkt)
 {
@@ -40,9 +43,137 @@ bool net_tc_submit_to_tx_queue(uint8_t tc, struct net_pkt *pkt)
 	return true;
 }
 
+#if NET_RX_FLOW_QUEUES > 1
+static uint32_t flow_hash_add(uint32_t hash, const uint8_t *data, size_t len)
+{
+	/* FNV-1a */
+	while (len--) {
+		hash ^= *data++;
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+/* Return the length of the link layer header in front of an IP packet,
+ * or -1 if the packet does not carry IP or the L2 is not known.
+ */
+static int rx_l2_hdr_len(struct net_if *iface, const uint8_t *data,
+			 size_t len)
+{
+#if defined(CONFIG_NET_L2_ETHERNET)
+	if (net_if_l2(iface) == &NET_L2_GET_NAME(ETHERNET)) {
+		const struct net_eth_hdr *hdr = (const void *)data;
+		uint16_t type;
+
+		if (len < sizeof(struct net_eth_vlan_hdr)) {
+			return -1;
+		}
+
+		type = ntohs(hdr->type);
+		if (type == NET_ETH_PTYPE_VLAN) {
+			const struct net_eth_vlan_hdr *vlan = (const void *)data;
+
+			if (ntohs(vlan->type) != NET_ETH_PTYPE_IP &&
+			    ntohs(vlan->type) != NET_ETH_PTYPE_IPV6) {
+				return -1;
+			}
+
+			return sizeof(struct net_eth_vlan_hdr);
+		}
+
+		if (type != NET_ETH_PTYPE_IP && type != NET_ETH_PTYPE_IPV6) {
+			return -1;
+		}
+
+		return sizeof(struct net_eth_hdr);
+	}
+#endif
+
+#if defined(CONFIG_NET_L2_DUMMY)
+	if (net_if_l2(iface) == &NET_L2_GET_NAME(DUMMY)) {
+		return 0;
+	}
+#endif
+
+	return -1;
+}
+
+/* Hash the addresses and ports of the packet. The headers are expected
+ * to be in the first fragment, if they are not the packet goes to the
+ * first flow queue.
+ */
+static uint32_t rx_flow_hash(struct net_pkt *pkt)
+{
+	struct net_buf *buf = pkt->buffer;
+	uint32_t hash = 2166136261U;
+	uint8_t *data = buf->data;
+	size_t len = buf->len;
+	size_t hdr_len;
+	uint8_t proto;
+	int l2_len;
+
+	l2_len = rx_l2_hdr_len(net_pkt_iface(pkt), data, len);
+	if (l2_len < 0) {
+		return 0;
+	}
+
+	data += l2_len;
+	len -= l2_len;
+
+	if (IS_ENABLED(CONFIG_NET_IPV4) && len >= NET_IPV4H_LEN &&
+	    (data[0] & 0xf0) == 0x40) {
+		struct net_ipv4_hdr *hdr = (struct net_ipv4_hdr *)data;
+
+		hdr_len = (hdr->vhl & 0x0f) * 4U;
+		proto = hdr->proto;
+		hash = flow_hash_add(hash, (uint8_t *)&hdr->src,
+				     2 * sizeof(struct in_addr));
+
+		/* Fragments (MF flag or offset set) go by addresses only,
+		 * as only the first one has the ports.
+		 */
+		if ((hdr->offset[0] & 0x3f) || hdr->offset[1]) {
+			return hash;
+		}
+	} else if (IS_ENABLED(CONFIG_NET_IPV6) && len >= NET_IPV6H_LEN &&
+		   (data[0] & 0xf0) == 0x60) {
+		struct net_ipv6_hdr *hdr = (struct net_ipv6_hdr *)data;
+
+		hdr_len = NET_IPV6H_LEN;
+		proto = hdr->nexthdr;
+		hash = flow_hash_add(hash, (uint8_t *)&hdr->src,
+				     2 * sizeof(struct in6_addr));
+	} else {
+		return 0;
+	}
+
+	if ((proto == IPPROTO_TCP || proto == IPPROTO_UDP) &&
+	    len >= hdr_len + 2 * sizeof(uint16_t)) {
+		hash = flow_hash_add(hash, data + hdr_len,
+				     2 * sizeof(uint16_t));
+	}
+
+	return hash;
+}
+#endif /* NET_RX_FLOW_QUEUES > 1 */
+
 void net_tc_submit_to_rx_queue(uint8_t tc, struct net_pkt *pkt)
 {
-	k_work_submit_to_queue(&rx_classes[tc].work_q, net_pkt_work(pkt));
+	uint8_t queue = tc;
+
+#if NET_RX_FLOW_QUEUES > 1
+	uint32_t hash = net_pkt_flow_hash(pkt);
+
+	if (!hash) {
+		hash = rx_flow_hash(pkt);
+		net_pkt_set_flow_hash(pkt, hash);
+	}
+
+	queue = tc * NET_RX_FLOW_QUEUES + hash % NET_RX_FLOW_QUEUES;
+#endif
+
+	k_work_submit_to_queue(&rx_classes[queue].work_q, net_pkt_work(pkt));
 }
 
 int net_tx_priority2tc(enum net_priority prio)
@@ -256,10 +387,10 @@ void net_tc_rx_init(void)
 	net_if_foreach(net_tc_rx_stats_priority_setup, NULL);
 #endif
 
-	for (i = 0; i < NET_TC_RX_COUNT; i++) {
+	for (i = 0; i < RX_QUEUE_COUNT; i++) {
 		uint8_t thread_priority;
 
-		thread_priority = rx_tc2thread(i);
+		thread_priority = rx_tc2thread(i / NET_RX_FLOW_QUEUES);
 		rx_classes[i].tc = thread_priority;
 
 		NET_DBG("[%d] Starting RX queue %p stack size %zd "
@@ -273,5 +404,16 @@ void net_tc_rx_init(void)
 			       K_THREAD_STACK_SIZEOF(rx_stack[i]),
 			       K_PRIO_COOP(thread_priority));
 		k_thread_name_set(&rx_classes[i].work_q.thread, "rx_workq");
+
+#if NET_RX_FLOW_QUEUES > 1 && defined(CONFIG_SCHED_CPU_MASK) && \
+	CONFIG_MP_NUM_CPUS > 1
+		/* Each flow queue of a traffic class gets its own CPU */
+		k_thread_suspend(&rx_classes[i].work_q.thread);
+		k_thread_cpu_mask_clear(&rx_classes[i].work_q.thread);
+		k_thread_cpu_mask_enable(&rx_classes[i].work_q.thread,
+					 (i % NET_RX_FLOW_QUEUES) %
+					 CONFIG_MP_NUM_CPUS);
+		k_thread_resume(&rx_classes[i].work_q.thread);
+#endif
 	}
 }
@@ -0,0 +1,331 @@
+/** @file
+ * @brief IP fragment reassembly shared by IPv4 and IPv6.
+ */
+
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_reassembly, CONFIG_NET_REASSEMBLY_LOG_LEVEL);
+
+#include <errno.h>
+#include <string.h>
+#include <sys/util.h>
+
+#include <net/net_core.h>
+#include <net/net_pkt.h>
+
+#include "reassembly.h"
+
+/* Recursive, so that the timeout cannot release a slot which is in use */
+static K_MUTEX_DEFINE(lock);
+
+static inline size_t addr_len(uint8_t family)
+{
+	return family == AF_INET6 ? sizeof(struct in6_addr) :
+				    sizeof(struct in_addr);
+}
+
+static void reassembly_clear(struct net_reassembly *reass)
+{
+	int i;
+
+	for (i = 0; i < reass->max_frags; i++) {
+		if (reass->frags[i].pkt) {
+			net_pkt_unref(reass->frags[i].pkt);
+			reass->frags[i].pkt = NULL;
+		}
+	}
+
+	reass->head = -1;
+	reass->count = 0U;
+	reass->received = 0U;
+	reass->total = 0U;
+	reass->in_use = false;
+}
+
+/* Link the buffers after last, leaving out the empty ones as the checksum
+ * calculation stops at the first empty buffer.
+ */
+static struct net_buf *append_bufs(struct net_buf *last, struct net_buf *buf)
+{
+	while (buf) {
+		if (!buf->len) {
+			buf = net_buf_frag_del(NULL, buf);
+			continue;
+		}
+
+		last->frags = buf;
+		last = buf;
+		buf = buf->frags;
+	}
+
+	last->frags = NULL;
+
+	return last;
+}
+
+static void reassembly_timeout(struct k_work *work)
+{
+	struct net_reassembly *reass =
+		CONTAINER_OF(work, struct net_reassembly, timer);
+
+	k_mutex_lock(&lock, K_FOREVER);
+
+	/* The slot might have been completed or reused while we were
+	 * waiting for the lock.
+	 */
+	if (reass->in_use && !k_delayed_work_remaining_get(&reass->timer)) {
+		NET_DBG("Reassembly id 0x%x timed out", reass->id);
+		reassembly_clear(reass);
+	}
+
+	k_mutex_unlock(&lock);
+}
+
+void net_reassembly_init(struct net_reassembly_table *table,
+			 struct net_reassembly *slots, uint8_t count,
+			 struct net_reassembly_frag *frags,
+			 uint8_t frags_per_slot, k_timeout_t timeout)
+{
+	int i;
+
+	(void)memset(slots, 0, count * sizeof(*slots));
+	(void)memset(frags, 0, count * frags_per_slot * sizeof(*frags));
+
+	for (i = 0; i < count; i++) {
+		k_delayed_work_init(&slots[i].timer, reassembly_timeout);
+
+		slots[i].frags = &frags[i * frags_per_slot];
+		slots[i].max_frags = frags_per_slot;
+		slots[i].head = -1;
+	}
+
+	table->slots = slots;
+	table->count = count;
+	table->timeout = timeout;
+}
+
+void net_reassembly_lock(void)
+{
+	k_mutex_lock(&lock, K_FOREVER);
+}
+
+void net_reassembly_unlock(void)
+{
+	k_mutex_unlock(&lock);
+}
+
+struct net_reassembly *net_reassembly_get(struct net_reassembly_table *table,
+					  uint8_t family, const void *src,
+					  const void *dst, uint32_t id,
+					  uint8_t proto)
+{
+	struct net_reassembly *avail = NULL;
+	size_t len = addr_len(family);
+	int same_src = 0;
+	int i;
+
+	for (i = 0; i < table->count; i++) {
+		struct net_reassembly *reass = &table->slots[i];
+
+		if (!reass->in_use) {
+			if (!avail) {
+				avail = reass;
+			}
+
+			continue;
+		}
+
+		if (reass->family != family || memcmp(&reass->src, src, len)) {
+			continue;
+		}
+
+		if (reass->id == id && reass->proto == proto &&
+		    !memcmp(&reass->dst, dst, len)) {
+			return reass;
+		}
+
+		same_src++;
+	}
+
+	if (!avail || same_src >= CONFIG_NET_REASSEMBLY_MAX_PER_SOURCE) {
+		NET_DBG("No reassembly slot for id 0x%x (%d from source)",
+			id, same_src);
+		return NULL;
+	}
+
+	memcpy(&avail->src, src, len);
+	memcpy(&avail->dst, dst, len);
+	avail->family = family;
+	avail->proto = proto;
+	avail->id = id;
+	avail->in_use = true;
+
+	k_delayed_work_submit(&avail->timer, table->timeout);
+
+	return avail;
+}
+
+int net_reassembly_add(struct net_reassembly *reass, struct net_pkt *pkt,
+		       uint16_t offset, uint16_t len, bool more)
+{
+	struct net_reassembly_frag *frag;
+	uint32_t end = (uint32_t)offset + len;
+	int8_t *link = &reass->head;
+	int8_t prev = -1;
+	int i;
+
+	if (end > UINT16_MAX || (reass->total && end > reass->total)) {
+		return -EINVAL;
+	}
+
+	if (!more) {
+		if (reass->total && end != reass->total) {
+			return -EINVAL;
+		}
+	} else if (!len) {
+		return -EINVAL;
+	}
+
+	/* Find the fragments surrounding the new one */
+	while (*link >= 0 && reass->frags[*link].offset < offset) {
+		prev = *link;
+		link = &reass->frags[prev].next;
+	}
+
+	if (*link >= 0) {
+		frag = &reass->frags[*link];
+
+		if (frag->offset == offset && frag->len == len) {
+			return -EALREADY;
+		}
+
+		if (end > frag->offset) {
+			return -EINVAL;
+		}
+	}
+
+	if (prev >= 0 &&
+	    reass->frags[prev].offset + reass->frags[prev].len > offset) {
+		return -EINVAL;
+	}
+
+	if (!more) {
+		/* Everything must fit before the end of the packet */
+		for (i = *link; i >= 0; i = reass->frags[i].next) {
+			if (reass->frags[i].offset + reass->frags[i].len > end) {
+				return -EINVAL;
+			}
+		}
+	}
+
+	if (reass->count >= reass->max_frags) {
+		return -ENOMEM;
+	}
+
+	for (i = 0; reass->frags[i].pkt; i++) {
+	}
+
+	frag = &reass->frags[i];
+	frag->pkt = pkt;
+	frag->offset = offset;
+	frag->len = len;
+	frag->next = *link;
+	*link = i;
+
+	reass->count++;
+	reass->received += len;
+
+	if (!more) {
+		reass->total = end;
+	}
+
+	/* As the fragments cannot overlap, having received as many bytes
+	 * as the packet has means that there are no holes left.
+	 */
+	return reass->total && reass->received == reass->total;
+}
+
+struct net_pkt *net_reassembly_join(struct net_reassembly *reass)
+{
+	struct net_reassembly_frag *frag;
+	struct net_pkt *head = NULL;
+	struct net_pkt *pkt;
+	struct net_buf *last;
+	struct net_buf *buf;
+
+	NET_ASSERT(reass->head >= 0);
+
+	frag = &reass->frags[reass->head];
+	if (frag->offset != 0U) {
+		goto out;
+	}
+
+	head = frag->pkt;
+	frag->pkt = NULL;
+
+	last = head->buffer;
+	buf = last->frags;
+	last->frags = NULL;
+	last = append_bufs(last, buf);
+
+	while (frag->next >= 0) {
+		frag = &reass->frags[frag->next];
+
+		pkt = frag->pkt;
+		frag->pkt = NULL;
+
+		/* Get rid of the headers in front of the payload */
+		net_pkt_cursor_init(pkt);
+
+		if (net_pkt_pull(pkt, net_pkt_get_len(pkt) - frag->len)) {
+			NET_ERR("Failed to pull headers");
+			net_pkt_unref(pkt);
+			net_pkt_unref(head);
+			head = NULL;
+			goto out;
+		}
+
+		last = append_bufs(last, pkt->buffer);
+
+		pkt->buffer = NULL;
+		net_pkt_unref(pkt);
+	}
+
+	net_pkt_cursor_init(head);
+
+out:
+	net_reassembly_cancel(reass);
+
+	return head;
+}
+
+void net_reassembly_cancel(struct net_reassembly *reass)
+{
+	k_mutex_lock(&lock, K_FOREVER);
+
+	k_delayed_work_cancel(&reass->timer);
+	reassembly_clear(reass);
+
+	k_mutex_unlock(&lock);
+}
+
+void net_reassembly_foreach(struct net_reassembly_table *table,
+			    net_reassembly_cb_t cb, void *user_data)
+{
+	int i;
+
+	k_mutex_lock(&lock, K_FOREVER);
+
+	for (i = 0; i < table->count; i++) {
+		if (table->slots[i].in_use) {
+			cb(&table->slots[i], user_data);
+		}
+	}
+
+	k_mutex_unlock(&lock);
+}
@@ -0,0 +1,230 @@
+/** @file
+ * @brief IP fragment reassembly shared by IPv4 and IPv6
+ *
+ * This is not to be included by the application.
+ */
+
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __REASSEMBLY_H
+#define __REASSEMBLY_H
+
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <kernel.h>
+
+#include <net/net_ip.h>
+#include <net/net_pkt.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Fragment waiting for reassembly.
+ *
+ * The fragments of a packet form a list sorted by offset, linked by
+ * their index in the fragment array of the reassembly slot.
+ */
+struct net_reassembly_frag {
+	/** Network packet of the fragment, NULL if the entry is free */
+	struct net_pkt *pkt;
+
+	/** Offset of the fragment payload in the reassembled payload */
+	uint16_t offset;
+
+	/** Length of the fragment payload at the end of pkt */
+	uint16_t len;
+
+	/** Index of the next fragment by offset, -1 for the last one */
+	int8_t next;
+};
+
+/** Pending packet reassembly. */
+struct net_reassembly {
+	/** Timeout for cancelling the reassembly */
+	struct k_delayed_work timer;
+
+	/** Source address of the fragments */
+	union {
+		struct in_addr in;
+		struct in6_addr in6;
+	} src;
+
+	/** Destination address of the fragments */
+	union {
+		struct in_addr in;
+		struct in6_addr in6;
+	} dst;
+
+	/** Fragment storage, max_frags entries */
+	struct net_reassembly_frag *frags;
+
+	/** Fragment identification */
+	uint32_t id;
+
+	/** Payload bytes received so far */
+	uint16_t received;
+
+	/** Payload length, zero until the last fragment is received */
+	uint16_t total;
+
+	/** Size of the fragment storage */
+	uint8_t max_frags;
+
+	/** Number of fragments received */
+	uint8_t count;
+
+	/** Index of the fragment with the lowest offset, -1 if none */
+	int8_t head;
+
+	/** Upper layer protocol, only used by IPv4 */
+	uint8_t proto;
+
+	/** AF_INET or AF_INET6 */
+	uint8_t family;
+
+	/** Is the slot in use */
+	bool in_use;
+};
+
+/**
+ * @brief Set of reassembly slots of an IP version.
+ */
+struct net_reassembly_table {
+	struct net_reassembly *slots;
+	k_timeout_t timeout;
+	uint8_t count;
+};
+
+/**
+ * @typedef net_reassembly_cb_t
+ * @brief Callback used while iterating over pending reassemblies.
+ *
+ * @param reass Reassembly slot in use
+ * @param user_data A valid pointer on some user data or NULL
+ */
+typedef void (*net_reassembly_cb_t)(struct net_reassembly *reass,
+				    void *user_data);
+
+/**
+ * @brief Initialize the reassembly slots of a table.
+ *
+ * @param table Table to initialize.
+ * @param slots Reassembly slots.
+ * @param count Number of slots.
+ * @param frags Fragment storage, count * frags_per_slot entries.
+ * @param frags_per_slot How many fragments one packet can have.
+ * @param timeout How long to wait for the rest of the fragments.
+ */
+void net_reassembly_init(struct net_reassembly_table *table,
+			 struct net_reassembly *slots, uint8_t count,
+			 struct net_reassembly_frag *frags,
+			 uint8_t frags_per_slot, k_timeout_t timeout);
+
+/**
+ * @brief Lock the reassembly slots.
+ *
+ * The slot returned by net_reassembly_get() must only be used while
+ * the lock is held, as the timeout can release it at any time.
+ */
+void net_reassembly_lock(void);
+
+/**
+ * @brief Unlock the reassembly slots.
+ */
+void net_reassembly_unlock(void);
+
+/**
+ * @brief Find the reassembly slot of a fragment or start a new one.
+ *
+ * A new reassembly is only started if the source address has less
+ * than CONFIG_NET_REASSEMBLY_MAX_PER_SOURCE pending reassemblies in
+ * the table, so that a single peer cannot take all the slots.
+ *
+ * @param table Table to use.
+ * @param family AF_INET or AF_INET6.
+ * @param src Source address, struct in_addr or struct in6_addr.
+ * @param dst Destination address, struct in_addr or struct in6_addr.
+ * @param id Fragment identification.
+ * @param proto Upper layer protocol, zero if not part of the key.
+ *
+ * @return Reassembly slot, NULL if no slot is available.
+ */
+struct net_reassembly *net_reassembly_get(struct net_reassembly_table *table,
+					  uint8_t family, const void *src,
+					  const void *dst, uint32_t id,
+					  uint8_t proto);
+
+/**
+ * @brief Add a fragment to a reassembly.
+ *
+ * The fragment is inserted in offset order by walking the fragment
+ * list, nothing is moved. On success the reassembly owns the packet.
+ *
+ * @param reass Reassembly slot.
+ * @param pkt Fragment, the payload is the last len bytes of the packet.
+ * @param offset Offset of the payload in bytes.
+ * @param len Length of the payload in bytes.
+ * @param more True if this is not the last fragment.
+ *
+ * @return 1 if the packet is complete, 0 if more fragments are needed,
+ * -EALREADY if the fragment is a duplicate, -EINVAL if it overlaps other
+ * fragments or does not fit the packet length, -ENOMEM if the slot
+ * cannot hold more fragments.
+ */
+int net_reassembly_add(struct net_reassembly *reass, struct net_pkt *pkt,
+		       uint16_t offset, uint16_t len, bool more);
+
+/**
+ * @brief Join the fragments of a complete reassembly.
+ *
+ * The first fragment keeps its headers, the headers of the other
+ * fragments are removed and their payload appended to it. The slot is
+ * released.
+ *
+ * @param reass Complete reassembly slot.
+ *
+ * @return The reassembled packet, NULL if it could not be joined in
+ * which case all the fragments are released.
+ */
+struct net_pkt *net_reassembly_join(struct net_reassembly *reass);
+
+/**
+ * @brief Release a reassembly slot and the fragments it holds.
+ *
+ * @param reass Reassembly slot.
+ */
+void net_reassembly_cancel(struct net_reassembly *reass);
+
+/**
+ * @brief Go through the pending reassemblies of a table.
+ *
+ * @param table Table to use.
+ * @param cb Callback to call for each pending reassembly.
+ * @param user_data User specified data or NULL.
+ */
+void net_reassembly_foreach(struct net_reassembly_table *table,
+			    net_reassembly_cb_t cb, void *user_data);
+
+/**
+ * @brief Iterate over the fragments of a reassembly in offset order.
+ *
+ * @param reass Reassembly slot.
+ * @param frag Iterator, struct net_reassembly_frag pointer.
+ */
+#define NET_REASSEMBLY_FOR_EACH_FRAG(reass, frag)			\
+	for (frag = (reass)->head < 0 ? NULL :				\
+		     &(reass)->frags[(reass)->head];			\
+	     frag;							\
+	     frag = frag->next < 0 ? NULL : &(reass)->frags[frag->next])
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __REASSEMBLY_H */
@@ -28,6 +28,7 @@ LOG_MODULE_REGISTER(net_route, CONFIG_NET_ROUTE_LOG_LEVEL);
 #include "icmpv6.h"
 #include "nbr.h"
 #include "route.h"
+#include "route_trie.h"
 
 #if !defined(NET_ROUTE_EXTRA_DATA_SIZE)
 #define NET_ROUTE_EXTRA_DATA_SIZE 0
@@ -36,7 +37,19 @@ LOG_MODULE_REGISTER(net_route, CONFIG_NET_ROUTE_LOG_LEVEL);
 /* We keep track of the routes in a separate list so that we can remove
  * the oldest routes (at tail) if needed.
  */
-static sys_slist_t routes;
+static sys_dlist_t routes = SYS_DLIST_STATIC_INIT(&routes);
+
+#if defined(CONFIG_NET_ROUTE_LPM)
+static struct net_route_trie route_trie;
+static struct net_route_trie_node
+	route_trie_nodes[NET_ROUTE_TRIE_NODES(CONFIG_NET_MAX_ROUTES)];
+
+static bool route_trie_match(sys_snode_t *entry, struct net_if *iface)
+{
+	return CONTAINER_OF(entry, struct net_route_entry,
+			    trie_node)->iface == iface;
+}
+#endif
 
 static void net_route_nexthop_remove(struct net_nbr *nbr)
 {
@@ -86,6 +99,21 @@ static struct net_nbr *get_nexthop_route(void)
 	return NULL;
 }
 
+static void put_nexthop_route(struct net_route_nexthop *nexthop_route)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_NET_MAX_NEXTHOPS; i++) {
+		struct net_nbr *nbr = get_nexthop_nbr(
+			(struct net_nbr *)net_route_nexthop_pool, i);
+
+		if (nbr->ref && nbr->data == (uint8_t *)nexthop_route) {
+			net_nbr_unref(nbr);
+			return;
+		}
+	}
+}
+
 static void net_route_entry_remove(struct net_nbr *nbr)
 {
 	NET_DBG("Route %p removed", nbr);
@@ -253,12 +281,26 @@ static int nbr_nexthop_put(struct net_nbr *nbr)
 /* Route was accessed, so place it in front of the routes list */
 static inline void update_route_access(struct net_route_entry *route)
 {
-	sys_slist_find_and_remove(&routes, &route->node);
-	sys_slist_prepend(&routes, &route->node);
+	sys_dlist_remove(&route->node);
+	sys_dlist_prepend(&routes, &route->node);
 }
 
-struct net_route_entry *net_route_lookup(struct net_if *iface,
-					 struct in6_addr *dst)
+#if defined(CONFIG_NET_ROUTE_LPM)
+static struct net_route_entry *route_find(struct net_if *iface,
+					  struct in6_addr *dst)
+{
+	sys_snode_t *entry;
+
+	entry = net_route_trie_lookup(&route_trie, iface, (uint8_t *)dst);
+	if (!entry) {
+		return NULL;
+	}
+
+	return CONTAINER_OF(entry, struct net_route_entry, trie_node);
+}
+#else
+static struct net_route_entry *route_find(struct net_if *iface,
+					  struct in6_addr *dst)
 {
 	struct net_route_entry *route, *found = NULL;
 	uint8_t longest_match = 0U;
@@ -286,6 +328,16 @@ struct net_route_entry *net_route_lookup(struct net_if *iface,
 		}
 	}
 
+	return found;
+}
+#endif /* CONFIG_NET_ROUTE_LPM */
+
+struct net_route_entry *net_route_lookup(struct net_if *iface,
+					 struct in6_addr *dst)
+{
+	struct net_route_entry *found;
+
+	found = route_find(iface, dst);
 	if (found) {
 		net_route_info("Found", found, dst);
 
@@ -295,6 +347,34 @@ struct net_route_entry *net_route_lookup(struct net_if *iface,
 	return found;
 }
 
+/* Find the route having exactly the given prefix */
+static struct net_route_entry *route_find_prefix(struct net_if *iface,
+						 struct in6_addr *addr,
+						 uint8_t prefix_len)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_NET_MAX_ROUTES; i++) {
+		struct net_nbr *nbr = get_nbr(i);
+		struct net_route_entry *route;
+
+		if (!nbr->ref || nbr->iface != iface) {
+			continue;
+		}
+
+		route = net_route_data(nbr);
+
+		if (route->prefix_len == prefix_len &&
+		    net_ipv6_is_prefix((uint8_t *)addr,
+				       (uint8_t *)&route->addr,
+				       prefix_len)) {
+			return route;
+		}
+	}
+
+	return NULL;
+}
+
 struct net_route_entry *net_route_add(struct net_if *iface,
 				      struct in6_addr *addr,
 				      uint8_t prefix_len,
@@ -333,7 +413,7 @@ struct net_route_entry *net_route_add(struct net_if *iface,
 		log_strdup(net_sprint_ll_addr(nexthop_lladdr->addr,
 					      nexthop_lladdr->len)));
 
-	route = net_route_lookup(iface, addr);
+	route = route_find_prefix(iface, addr, prefix_len);
 	if (route) {
 		/* Update nexthop if not the same */
 		struct in6_addr *nexthop_addr;
@@ -353,9 +433,7 @@ struct net_route_entry *net_route_add(struct net_if *iface,
 	nbr = nbr_new(iface, addr, prefix_len);
 	if (!nbr) {
 		/* Remove the oldest route and try again */
-		sys_snode_t *last = sys_slist_peek_tail(&routes);
-
-		sys_slist_find_and_remove(&routes, last);
+		sys_dnode_t *last = sys_dlist_peek_tail(&routes);
 
 		route = CONTAINER_OF(last,
 				     struct net_route_entry,
@@ -401,7 +479,17 @@ struct net_route_entry *net_route_add(struct net_if *iface,
 	route = net_route_data(nbr);
 	route->iface = iface;
 
-	sys_slist_prepend(&routes, &route->node);
+#if defined(CONFIG_NET_ROUTE_LPM)
+	if (net_route_trie_insert(&route_trie, (uint8_t *)addr, prefix_len,
+				  &route->trie_node) < 0) {
+		NET_ERR("No route trie node available!");
+		nbr_nexthop_put(tmp);
+		nbr_free(nbr);
+		return NULL;
+	}
+#endif
+
+	sys_dlist_prepend(&routes, &route->node);
 
 	tmp = nbr_nexthop_get(iface, nexthop);
 
@@ -454,7 +542,14 @@ int net_route_del(struct net_route_entry *route)
 	net_mgmt_event_notify(NET_EVENT_IPV6_ROUTE_DEL, route->iface);
 #endif
 
-	sys_slist_find_and_remove(&routes, &route->node);
+	if (sys_dnode_is_linked(&route->node)) {
+		sys_dlist_remove(&route->node);
+	}
+
+#if defined(CONFIG_NET_ROUTE_LPM)
+	(void)net_route_trie_remove(&route_trie, (uint8_t *)&route->addr,
+				    route->prefix_len, &route->trie_node);
+#endif
 
 	nbr = net_route_get_nbr(route);
 	if (!nbr) {
@@ -469,6 +564,7 @@ int net_route_del(struct net_route_entry *route)
 		}
 
 		nbr_nexthop_put(nexthop_route->nbr);
+		put_nexthop_route(nexthop_route);
 	}
 
 	nbr_free(nbr);
@@ -853,6 +949,12 @@ int net_route_packet_if(struct net_pkt *pkt, struct net_if *iface)
 
 void net_route_init(void)
 {
+#if defined(CONFIG_NET_ROUTE_LPM)
+	net_route_trie_init(&route_trie, route_trie_nodes,
+			    ARRAY_SIZE(route_trie_nodes),
+			    sizeof(struct in6_addr), route_trie_match);
+#endif
+
 	NET_DBG("Allocated %d routing entries (%zu bytes)",
 		CONFIG_NET_MAX_ROUTES, sizeof(net_route_entries_pool));
 
@@ -0,0 +1,208 @@
+/** @file
+ * @brief IPv4 route handling.
+ */
+
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_route_ipv4, CONFIG_NET_ROUTE_LOG_LEVEL);
+
+#include <kernel.h>
+#include <errno.h>
+#include <zephyr/types.h>
+
+#include <net/net_core.h>
+#include <net/net_if.h>
+#include <net/net_ip.h>
+
+#include "net_private.h"
+#include "route.h"
+#include "route_trie.h"
+
+static struct net_route_entry_ipv4 routes[CONFIG_NET_MAX_ROUTES_IPV4];
+
+static struct net_route_trie route_trie;
+static struct net_route_trie_node
+	route_trie_nodes[NET_ROUTE_TRIE_NODES(CONFIG_NET_MAX_ROUTES_IPV4)];
+
+static K_MUTEX_DEFINE(lock);
+
+static bool route_trie_match(sys_snode_t *entry, struct net_if *iface)
+{
+	return CONTAINER_OF(entry, struct net_route_entry_ipv4,
+			    node)->iface == iface;
+}
+
+static inline bool route_prefix_cmp(struct in_addr *addr1,
+				    struct in_addr *addr2,
+				    uint8_t prefix_len)
+{
+	uint32_t mask;
+
+	if (!prefix_len) {
+		return true;
+	}
+
+	mask = htonl(UINT32_MAX << (32 - prefix_len));
+
+	return ((UNALIGNED_GET(&addr1->s_addr) ^
+		 UNALIGNED_GET(&addr2->s_addr)) & mask) == 0U;
+}
+
+static struct net_route_entry_ipv4 *route_find(struct net_if *iface,
+					       struct in_addr *addr,
+					       uint8_t prefix_len)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(routes); i++) {
+		if (!routes[i].is_used || routes[i].iface != iface ||
+		    routes[i].prefix_len != prefix_len) {
+			continue;
+		}
+
+		if (route_prefix_cmp(addr, &routes[i].addr, prefix_len)) {
+			return &routes[i];
+		}
+	}
+
+	return NULL;
+}
+
+struct net_route_entry_ipv4 *net_route_ipv4_add(struct net_if *iface,
+						struct in_addr *addr,
+						uint8_t prefix_len,
+						struct in_addr *gw)
+{
+	struct net_route_entry_ipv4 *route;
+	int i;
+
+	NET_ASSERT(iface);
+	NET_ASSERT(addr);
+	NET_ASSERT(gw);
+
+	if (prefix_len > 32) {
+		return NULL;
+	}
+
+	k_mutex_lock(&lock, K_FOREVER);
+
+	route = route_find(iface, addr, prefix_len);
+	if (route) {
+		net_ipaddr_copy(&route->gw, gw);
+		goto out;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(routes); i++) {
+		if (!routes[i].is_used) {
+			route = &routes[i];
+			break;
+		}
+	}
+
+	if (!route) {
+		NET_DBG("No free IPv4 route entry");
+		goto out;
+	}
+
+	route->iface = iface;
+	route->prefix_len = prefix_len;
+	net_ipaddr_copy(&route->addr, addr);
+	net_ipaddr_copy(&route->gw, gw);
+
+	if (net_route_trie_insert(&route_trie, (uint8_t *)&route->addr,
+				  prefix_len, &route->node) < 0) {
+		NET_ERR("No route trie node available!");
+		route = NULL;
+		goto out;
+	}
+
+	route->is_used = true;
+
+	NET_DBG("Added route to %s/%d via %s (iface %p)",
+		log_strdup(net_sprint_ipv4_addr(addr)), prefix_len,
+		log_strdup(net_sprint_ipv4_addr(gw)), iface);
+
+out:
+	k_mutex_unlock(&lock);
+
+	return route;
+}
+
+int net_route_ipv4_del(struct net_route_entry_ipv4 *route)
+{
+	int ret;
+
+	if (!route) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&lock, K_FOREVER);
+
+	if (!route->is_used) {
+		ret = -ENOENT;
+		goto out;
+	}
+
+	ret = net_route_trie_remove(&route_trie, (uint8_t *)&route->addr,
+				    route->prefix_len, &route->node);
+
+	route->is_used = false;
+
+	NET_DBG("Deleted route to %s/%d (iface %p)",
+		log_strdup(net_sprint_ipv4_addr(&route->addr)),
+		route->prefix_len, route->iface);
+
+out:
+	k_mutex_unlock(&lock);
+
+	return ret;
+}
+
+struct net_route_entry_ipv4 *net_route_ipv4_lookup(struct net_if *iface,
+						   struct in_addr *dst)
+{
+	sys_snode_t *entry;
+
+	k_mutex_lock(&lock, K_FOREVER);
+	entry = net_route_trie_lookup(&route_trie, iface, (uint8_t *)dst);
+	k_mutex_unlock(&lock);
+
+	if (!entry) {
+		return NULL;
+	}
+
+	return CONTAINER_OF(entry, struct net_route_entry_ipv4, node);
+}
+
+int net_route_ipv4_foreach(net_route_ipv4_cb_t cb, void *user_data)
+{
+	int i, ret = 0;
+
+	for (i = 0; i < ARRAY_SIZE(routes); i++) {
+		if (!routes[i].is_used) {
+			continue;
+		}
+
+		cb(&routes[i], user_data);
+
+		ret++;
+	}
+
+	return ret;
+}
+
+void net_route_ipv4_init(void)
+{
+	net_route_trie_init(&route_trie, route_trie_nodes,
+			    ARRAY_SIZE(route_trie_nodes),
+			    sizeof(struct in_addr), route_trie_match);
+
+	NET_DBG("Allocated %d IPv4 routing entries (%zu bytes)",
+		CONFIG_NET_MAX_ROUTES_IPV4,
+		sizeof(routes) + sizeof(route_trie_nodes));
+}
@@ -0,0 +1,301 @@
+/** @file
+ * @brief Longest prefix match trie for the routing tables.
+ */
+
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <sys/util.h>
+
+#include <net/net_core.h>
+
+#include "route_trie.h"
+
+static inline int key_bit(const uint8_t *key, uint8_t bit)
+{
+	return (key[bit / 8] >> (7 - (bit % 8))) & 1;
+}
+
+/* Number of leading bits the keys have in common, at most max_len */
+static uint8_t common_len(const uint8_t *a, const uint8_t *b, uint8_t max_len)
+{
+	unsigned int len = 0U;
+	int i;
+
+	for (i = 0; len < max_len; i++) {
+		uint8_t diff = a[i] ^ b[i];
+
+		if (diff) {
+			len += __builtin_clz(diff) - 24;
+			break;
+		}
+
+		len += 8U;
+	}
+
+	return MIN(len, max_len);
+}
+
+static inline bool prefix_match(const uint8_t *prefix, const uint8_t *addr,
+				uint8_t prefix_len)
+{
+	return common_len(prefix, addr, prefix_len) == prefix_len;
+}
+
+static inline void cache_flush(struct net_route_trie *trie)
+{
+#if CONFIG_NET_ROUTE_CACHE_SIZE > 0
+	(void)memset(trie->cache, 0, sizeof(trie->cache));
+#endif
+}
+
+#if CONFIG_NET_ROUTE_CACHE_SIZE > 0
+static struct net_route_trie_cache *cache_slot(struct net_route_trie *trie,
+					       struct net_if *iface,
+					       const uint8_t *addr)
+{
+	uint32_t hash = 2166136261U ^ POINTER_TO_UINT(iface);
+	int i;
+
+	for (i = 0; i < trie->key_len; i++) {
+		hash = (hash ^ addr[i]) * 16777619U;
+	}
+
+	return &trie->cache[hash % CONFIG_NET_ROUTE_CACHE_SIZE];
+}
+#endif
+
+static struct net_route_trie_node *node_alloc(struct net_route_trie *trie,
+					      const uint8_t *prefix,
+					      uint8_t prefix_len)
+{
+	struct net_route_trie_node *node = trie->free;
+
+	NET_ASSERT(node);
+
+	trie->free = node->child[0];
+	trie->free_count--;
+
+	(void)memset(node, 0, sizeof(*node));
+
+	memcpy(node->prefix, prefix, prefix_len / 8);
+	if (prefix_len % 8) {
+		node->prefix[prefix_len / 8] = prefix[prefix_len / 8] &
+					       (0xff << (8 - prefix_len % 8));
+	}
+
+	node->prefix_len = prefix_len;
+	sys_slist_init(&node->entries);
+
+	return node;
+}
+
+static void node_free(struct net_route_trie *trie,
+		      struct net_route_trie_node *node)
+{
+	node->child[0] = trie->free;
+	trie->free = node;
+	trie->free_count++;
+}
+
+static struct net_route_trie_node **node_link(struct net_route_trie *trie,
+					      struct net_route_trie_node *node)
+{
+	struct net_route_trie_node *parent = node->parent;
+
+	if (!parent) {
+		return &trie->root;
+	}
+
+	return &parent->child[parent->child[1] == node];
+}
+
+static inline void node_set_child(struct net_route_trie_node *parent,
+				  struct net_route_trie_node *child)
+{
+	parent->child[key_bit(child->prefix, parent->prefix_len)] = child;
+	child->parent = parent;
+}
+
+void net_route_trie_init(struct net_route_trie *trie,
+			 struct net_route_trie_node *nodes, size_t count,
+			 uint8_t key_len, net_route_trie_match_cb_t match)
+{
+	size_t i;
+
+	NET_ASSERT(key_len <= NET_ROUTE_TRIE_KEY_LEN);
+
+	(void)memset(trie, 0, sizeof(*trie));
+
+	trie->key_len = key_len;
+	trie->match = match;
+
+	for (i = 0; i < count; i++) {
+		node_free(trie, &nodes[i]);
+	}
+}
+
+int net_route_trie_insert(struct net_route_trie *trie, const uint8_t *prefix,
+			  uint8_t prefix_len, sys_snode_t *entry)
+{
+	struct net_route_trie_node **link = &trie->root;
+	struct net_route_trie_node *parent = NULL;
+	struct net_route_trie_node *node, *glue;
+	uint8_t common;
+
+	NET_ASSERT(prefix_len <= trie->key_len * 8);
+
+	while (*link) {
+		node = *link;
+
+		common = common_len(node->prefix, prefix,
+				    MIN(node->prefix_len, prefix_len));
+		if (common < node->prefix_len) {
+			break;
+		}
+
+		if (node->prefix_len == prefix_len) {
+			goto found;
+		}
+
+		parent = node;
+		link = &node->child[key_bit(prefix, node->prefix_len)];
+	}
+
+	if (!*link) {
+		if (!trie->free_count) {
+			return -ENOMEM;
+		}
+
+		node = node_alloc(trie, prefix, prefix_len);
+		node->parent = parent;
+		*link = node;
+
+		goto found;
+	}
+
+	/* The new prefix diverges from the current node in the middle of
+	 * the compressed path, so the path is split. If the new prefix is
+	 * a prefix of the current node, it becomes its parent, otherwise
+	 * a branching node is needed for the two.
+	 */
+	glue = *link;
+
+	if (common == prefix_len) {
+		if (!trie->free_count) {
+			return -ENOMEM;
+		}
+
+		node = node_alloc(trie, prefix, prefix_len);
+		node->parent = parent;
+		*link = node;
+		node_set_child(node, glue);
+
+		goto found;
+	}
+
+	if (trie->free_count < 2) {
+		return -ENOMEM;
+	}
+
+	node = node_alloc(trie, prefix, common);
+	node->parent = parent;
+	*link = node;
+	node_set_child(node, glue);
+
+	glue = node;
+	node = node_alloc(trie, prefix, prefix_len);
+	node_set_child(glue, node);
+
+found:
+	sys_slist_append(&node->entries, entry);
+	cache_flush(trie);
+
+	return 0;
+}
+
+int net_route_trie_remove(struct net_route_trie *trie, const uint8_t *prefix,
+			  uint8_t prefix_len, sys_snode_t *entry)
+{
+	struct net_route_trie_node *node = trie->root;
+
+	while (node && node->prefix_len < prefix_len) {
+		node = node->child[key_bit(prefix, node->prefix_len)];
+	}
+
+	if (!node || node->prefix_len != prefix_len ||
+	    !prefix_match(node->prefix, prefix, prefix_len)) {
+		return -ENOENT;
+	}
+
+	if (!sys_slist_find_and_remove(&node->entries, entry)) {
+		return -ENOENT;
+	}
+
+	cache_flush(trie);
+
+	/* Drop the nodes which neither have routes nor branch */
+	while (node && sys_slist_is_empty(&node->entries) &&
+	       !(node->child[0] && node->child[1])) {
+		struct net_route_trie_node *parent = node->parent;
+		struct net_route_trie_node *child;
+
+		child = node->child[0] ? node->child[0] : node->child[1];
+		if (child) {
+			child->parent = parent;
+		}
+
+		*node_link(trie, node) = child;
+		node_free(trie, node);
+
+		node = parent;
+	}
+
+	return 0;
+}
+
+sys_snode_t *net_route_trie_lookup(struct net_route_trie *trie,
+				   struct net_if *iface, const uint8_t *addr)
+{
+	struct net_route_trie_node *node = trie->root;
+	sys_snode_t *found = NULL;
+	sys_snode_t *entry;
+#if CONFIG_NET_ROUTE_CACHE_SIZE > 0
+	struct net_route_trie_cache *slot = cache_slot(trie, iface, addr);
+
+	if (slot->entry && slot->iface == iface &&
+	    !memcmp(slot->addr, addr, trie->key_len)) {
+		return slot->entry;
+	}
+#endif
+
+	while (node && prefix_match(node->prefix, addr, node->prefix_len)) {
+		SYS_SLIST_FOR_EACH_NODE(&node->entries, entry) {
+			if (!iface || trie->match(entry, iface)) {
+				found = entry;
+				break;
+			}
+		}
+
+		if (node->prefix_len == trie->key_len * 8) {
+			break;
+		}
+
+		node = node->child[key_bit(addr, node->prefix_len)];
+	}
+
+#if CONFIG_NET_ROUTE_CACHE_SIZE > 0
+	if (found) {
+		slot->iface = iface;
+		memcpy(slot->addr, addr, trie->key_len);
+		slot->entry = found;
+	}
+#endif
+
+	return found;
+}
@@ -0,0 +1,152 @@
+/** @file
+ * @brief Longest prefix match trie for the routing tables
+ *
+ * This is not to be included by the application.
+ */
+
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __ROUTE_TRIE_H
+#define __ROUTE_TRIE_H
+
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <sys/slist.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct net_if;
+
+/* Longest key supported, an IPv6 address */
+#define NET_ROUTE_TRIE_KEY_LEN 16
+
+/**
+ * @brief Trie node.
+ *
+ * The trie is a path compressed binary trie, a node either has route
+ * entries attached to it or it is a branching point having two children.
+ */
+struct net_route_trie_node {
+	/** Parent node, NULL for the root */
+	struct net_route_trie_node *parent;
+
+	/** Children, selected by the first bit after the prefix */
+	struct net_route_trie_node *child[2];
+
+	/** Route entries having this prefix */
+	sys_slist_t entries;
+
+	/** Prefix of the node, the bits after prefix_len are zero */
+	uint8_t prefix[NET_ROUTE_TRIE_KEY_LEN];
+
+	/** Prefix length in bits */
+	uint8_t prefix_len;
+};
+
+#if CONFIG_NET_ROUTE_CACHE_SIZE > 0
+struct net_route_trie_cache {
+	struct net_if *iface;
+	sys_snode_t *entry;
+	uint8_t addr[NET_ROUTE_TRIE_KEY_LEN];
+};
+#endif
+
+/**
+ * @brief Check if a route entry is usable for the given interface.
+ *
+ * @param entry Route entry node given to net_route_trie_insert().
+ * @param iface Network interface given to net_route_trie_lookup().
+ *
+ * @return True if the entry matches, false otherwise.
+ */
+typedef bool (*net_route_trie_match_cb_t)(sys_snode_t *entry,
+					  struct net_if *iface);
+
+/**
+ * @brief Trie with its node pool and lookup cache.
+ */
+struct net_route_trie {
+	struct net_route_trie_node *root;
+	struct net_route_trie_node *free;
+	net_route_trie_match_cb_t match;
+	uint16_t free_count;
+	uint8_t key_len;
+#if CONFIG_NET_ROUTE_CACHE_SIZE > 0
+	struct net_route_trie_cache cache[CONFIG_NET_ROUTE_CACHE_SIZE];
+#endif
+};
+
+/**
+ * @brief Node pool size needed for a given number of routes.
+ *
+ * Each route adds at most one prefix node and one branching node.
+ */
+#define NET_ROUTE_TRIE_NODES(routes) (2 * (routes))
+
+/**
+ * @brief Initialize an empty trie.
+ *
+ * @param trie Trie to initialize.
+ * @param nodes Node pool for the trie.
+ * @param count Number of nodes in the pool.
+ * @param key_len Address length in bytes, 4 for IPv4 and 16 for IPv6.
+ * @param match Callback checking the interface of a route entry.
+ */
+void net_route_trie_init(struct net_route_trie *trie,
+			 struct net_route_trie_node *nodes, size_t count,
+			 uint8_t key_len, net_route_trie_match_cb_t match);
+
+/**
+ * @brief Attach a route entry to a prefix.
+ *
+ * @param trie Trie to use.
+ * @param prefix Address prefix, key_len bytes.
+ * @param prefix_len Prefix length in bits.
+ * @param entry Route entry node, must not be in any trie.
+ *
+ * @return 0 if ok, -ENOMEM if the node pool is exhausted.
+ */
+int net_route_trie_insert(struct net_route_trie *trie, const uint8_t *prefix,
+			  uint8_t prefix_len, sys_snode_t *entry);
+
+/**
+ * @brief Detach a route entry from a prefix.
+ *
+ * @param trie Trie to use.
+ * @param prefix Address prefix the entry was inserted with.
+ * @param prefix_len Prefix length in bits.
+ * @param entry Route entry node.
+ *
+ * @return 0 if ok, -ENOENT if the entry was not found.
+ */
+int net_route_trie_remove(struct net_route_trie *trie, const uint8_t *prefix,
+			  uint8_t prefix_len, sys_snode_t *entry);
+
+/**
+ * @brief Find the route entry with the longest prefix matching an address.
+ *
+ * The lookup visits at most one node per prefix bit. Recent results are
+ * kept in a small direct mapped cache which is flushed whenever the trie
+ * changes.
+ *
+ * @param trie Trie to use.
+ * @param iface Network interface passed to the match callback, NULL
+ * matches all the interfaces.
+ * @param addr Destination address, key_len bytes.
+ *
+ * @return Route entry node, NULL if no route matches.
+ */
+sys_snode_t *net_route_trie_lookup(struct net_route_trie *trie,
+				   struct net_if *iface, const uint8_t *addr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ROUTE_TRIE_H */
@@ -2742,6 +2742,8 @@ struct net_tcp_hdr *net_tcp_input(struct net_pkt *pkt,
 {
 	struct net_tcp_hdr *tcp_hdr;
 
+	net_pkt_set_rx_stats_tick(pkt, NET_STATS_RX_DETAIL_L4);
+
 	if (IS_ENABLED(CONFIG_NET_TCP_CHECKSUM) &&
 	    net_if_need_calc_rx_checksum(net_pkt_iface(pkt)) &&
 	    net_calc_chksum_tcp(pkt) != 0U) {
@@ -19,17 +19,32 @@ LOG_MODULE_REGISTER(net_tcp, CONFIG_NET_TCP_LOG_LEVEL);
 #include "connection.h"
 #include "net_stats.h"
 #include "net_private.h"
+#include "tcp2.h"
 #include "tcp2_priv.h"
 
 static int tcp_rto = CONFIG_NET_TCP_INIT_RETRANSMISSION_TIMEOUT;
+static int tcp_rto_min = CONFIG_NET_TCP_MIN_RETRANSMISSION_TIMEOUT;
 static int tcp_retries = 3;
 static int tcp_window = NET_IPV6_MTU;
 
 static sys_slist_t tcp_conns = SYS_SLIST_STATIC_INIT(&tcp_conns);
 
+/* Connections having their endpoints set, hashed by the endpoints */
+static sys_slist_t tcp_conn_hash[CONFIG_NET_TCP_CONN_HASH_SIZE];
+
+/* SYN queue of the listening connections */
+static struct tcp_backlog_entry tcp_backlog[CONFIG_NET_TCP_BACKLOG_SIZE];
+
+#if defined(CONFIG_NET_TCP_SYN_COOKIES)
+static uint32_t tcp_syn_cookie_secret;
+#endif
+
 static K_MEM_SLAB_DEFINE(tcp_conns_slab, sizeof(struct tcp),
 				CONFIG_NET_MAX_CONTEXTS, 4);
 
+/* RFC 6298, ch. 2.5, maximum value of the RTO (in milliseconds) */
+#define TCP_RTO_MAX 60000
+
 static void tcp_in(struct tcp *conn, struct net_pkt *pkt);
 
 int (*tcp_send_cb)(struct net_pkt *pkt) = NULL;
@@ -168,6 +183,48 @@ static int tcp_endpoint_set(union tcp_endpoint *ep, struct net_pkt *pkt,
 	return ret;
 }
 
+static uint32_t tcp_hash_add(uint32_t hash, const void *data, size_t len)
+{
+	const uint8_t *p = data;
+
+	while (len--) {
+		hash = (hash ^ *p++) * 16777619U;
+	}
+
+	return hash;
+}
+
+static sys_slist_t *tcp_conn_bucket(union tcp_endpoint *src,
+				    union tcp_endpoint *dst)
+{
+	size_t len = tcp_endpoint_len(src->sa.sa_family);
+	uint32_t hash = 2166136261U;
+
+	hash = tcp_hash_add(hash, src, len);
+	hash = tcp_hash_add(hash, dst, len);
+
+	return &tcp_conn_hash[hash % CONFIG_NET_TCP_CONN_HASH_SIZE];
+}
+
+/* Make the connection visible to tcp_conn_search(), the endpoints
+ * must not change afterwards
+ */
+static void tcp_conn_hash_add(struct tcp *conn)
+{
+	int key = irq_lock();
+
+	sys_slist_append(tcp_conn_bucket(&conn->src, &conn->dst),
+			 &conn->hash_next);
+
+	irq_unlock(key);
+}
+
+static uint32_t tcp_isn(void)
+{
+	return (IS_ENABLED(CONFIG_NET_TEST_PROTOCOL) ||
+		IS_ENABLED(CONFIG_NET_TEST)) ? 0 : sys_rand32_get();
+}
+
 static const char *tcp_flags(uint8_t flags)
 {
 #define BUF_SIZE 25 /* 6 * 4 + 1 */
@@ -278,6 +335,22 @@ static void tcp_send_queue_flush(struct tcp *conn)
 	}
 }
 
+static void tcp_backlog_purge(struct tcp *listener);
+
+/* Wake up the thread waiting for the connection to be established */
+static void tcp_connect_done(struct tcp *conn, int result)
+{
+	int key = irq_lock();
+
+	if (conn->connect_wait) {
+		conn->connect_wait->result = result;
+		k_sem_give(&conn->connect_wait->sem);
+		conn->connect_wait = NULL;
+	}
+
+	irq_unlock(key);
+}
+
 static int tcp_conn_unref(struct tcp *conn)
 {
 	int ref_count = atomic_dec(&conn->ref_count) - 1;
@@ -293,6 +366,9 @@ static int tcp_conn_unref(struct tcp *conn)
 
 	key = irq_lock();
 
+	tcp_connect_done(conn, conn->state == TCP_CLOSED ? -ECONNREFUSED :
+			 -ETIMEDOUT);
+
 	if (conn->context->conn_handler) {
 		net_conn_unregister(conn->context->conn_handler);
 		conn->context->conn_handler = NULL;
@@ -316,10 +392,14 @@ static int tcp_conn_unref(struct tcp *conn)
 
 	k_delayed_work_cancel(&conn->timewait_timer);
 
-	memset(conn, 0, sizeof(*conn));
+	tcp_backlog_purge(conn);
 
+	sys_slist_find_and_remove(tcp_conn_bucket(&conn->src, &conn->dst),
+				  &conn->hash_next);
 	sys_slist_find_and_remove(&tcp_conns, (sys_snode_t *)conn);
 
+	memset(conn, 0, sizeof(*conn));
+
 	k_mem_slab_free(&tcp_conns_slab, (void **)&conn);
 
 	irq_unlock(key);
@@ -340,6 +420,53 @@ int net_tcp_unref(struct net_context *context)
 	return ref_count;
 }
 
+static uint32_t tcp_rtt_rto(struct tcp_rtt *rtt)
+{
+	uint32_t rto;
+
+	if (!rtt->sampled) {
+		return tcp_rto;
+	}
+
+	/* RFC 6298, ch. 2.3, RTO = SRTT + max(G, 4 * RTTVAR) */
+	rto = (rtt->srtt >> 3) + MAX(1U, rtt->rttvar);
+
+	return MIN(MAX(rto, tcp_rto_min), TCP_RTO_MAX);
+}
+
+static void tcp_rtt_update(struct tcp *conn, uint32_t r)
+{
+	struct tcp_rtt *rtt = &conn->rtt;
+
+	if (!rtt->sampled) {
+		/* RFC 6298, ch. 2.2, the first measurement */
+		rtt->srtt = r << 3;
+		rtt->rttvar = r << 1;
+		rtt->sampled = true;
+	} else {
+		/* RFC 6298, ch. 2.3, alpha = 1/8 and beta = 1/4 */
+		int32_t delta = r - (rtt->srtt >> 3);
+
+		rtt->srtt += delta;
+		if (delta < 0) {
+			delta = -delta;
+		}
+		rtt->rttvar += delta - (rtt->rttvar >> 2);
+	}
+
+	rtt->rto = tcp_rtt_rto(rtt);
+
+	NET_DBG("conn: %p rtt=%u srtt=%u rttvar=%u rto=%u", conn, r,
+		rtt->srtt >> 3, rtt->rttvar >> 2, rtt->rto);
+}
+
+/* RFC 6298, ch. 5.5, back off the timer */
+static void tcp_rto_backoff(struct tcp *conn)
+{
+	conn->rtt.rto = MIN(conn->rtt.rto * 2U, TCP_RTO_MAX);
+	conn->rtt.timing = false; /* Karn's algorithm */
+}
+
 static void tcp_send_process(struct k_work *work)
 {
 	struct tcp *conn = CONTAINER_OF(work, struct tcp, send_timer);
@@ -353,6 +480,7 @@ static void tcp_send_process(struct k_work *work)
 		if (conn->send_retries > 0) {
 			tcp_send(tcp_pkt_clone(pkt));
 			conn->send_retries--;
+			tcp_rto_backoff(conn);
 		} else {
 			tcp_conn_unref(conn);
 			conn = NULL;
@@ -380,7 +508,8 @@ static void tcp_send_process(struct k_work *work)
 	}
 
 	if (conn && conn->in_retransmission) {
-		k_delayed_work_submit(&conn->send_timer, K_MSEC(tcp_rto));
+		k_delayed_work_submit(&conn->send_timer,
+				      K_MSEC(conn->rtt.rto));
 	}
 }
 
@@ -390,6 +519,8 @@ static void tcp_send_timer_cancel(struct tcp *conn)
 
 	k_delayed_work_cancel(&conn->send_timer);
 
+	conn->rtt.rto = tcp_rtt_rto(&conn->rtt);
+
 	{
 		struct net_pkt *pkt = tcp_slist(&conn->send_queue, get,
 						struct net_pkt, next);
@@ -401,7 +532,8 @@ static void tcp_send_timer_cancel(struct tcp *conn)
 		conn->in_retransmission = false;
 	} else {
 		conn->send_retries = tcp_retries;
-		k_delayed_work_submit(&conn->send_timer, K_MSEC(tcp_rto));
+		k_delayed_work_submit(&conn->send_timer,
+				      K_MSEC(conn->rtt.rto));
 	}
 }
 
@@ -703,9 +835,21 @@ static void tcp_pkt_peek(struct net_pkt *to, struct net_pkt *from, size_t pos,
 	net_pkt_copy(to, from, len);
 }
 
+/* Usable send window, the smaller of the peer's receive window and
+ * the congestion window
+ */
+static int tcp_send_window(struct tcp *conn)
+{
+#if defined(CONFIG_NET_TCP_CONGESTION_CONTROL)
+	return MIN(conn->send_win, conn->cc.cwnd);
+#else
+	return conn->send_win;
+#endif
+}
+
 static bool tcp_window_full(struct tcp *conn)
 {
-	bool window_full = !(conn->unacked_len < conn->send_win);
+	bool window_full = !(conn->unacked_len < tcp_send_window(conn));
 
 	NET_DBG("conn: %p window_full=%hu", conn, window_full);
 
@@ -738,7 +882,7 @@ static int tcp_send_data(struct tcp *conn)
 
 	pos = conn->unacked_len;
 	len = MIN3(conn->send_data_total - conn->unacked_len,
-		   conn->send_win - conn->unacked_len,
+		   tcp_send_window(conn) - conn->unacked_len,
 		   conn_mss(conn));
 
 	pkt = tcp_pkt_alloc(conn, len);
@@ -750,6 +894,13 @@ static int tcp_send_data(struct tcp *conn)
 
 	tcp_pkt_peek(pkt, conn->send_data, pos, len);
 
+	/* Time one segment at a time, never a retransmitted one */
+	if (conn->data_mode == TCP_DATA_MODE_SEND && !conn->rtt.timing) {
+		conn->rtt.timing = true;
+		conn->rtt.seq = conn->seq + conn->unacked_len + len;
+		conn->rtt.timestamp = k_uptime_get_32();
+	}
+
 	tcp_out_ext(conn, PSH | ACK, pkt, conn->seq + conn->unacked_len);
 
 	conn->unacked_len += len;
@@ -793,12 +944,57 @@ static int tcp_send_queued_data(struct tcp *conn)
 
 	if (subscribe) {
 		conn->send_data_retries = 0;
-		k_delayed_work_submit(&conn->send_data_timer, K_MSEC(tcp_rto));
+		k_delayed_work_submit(&conn->send_data_timer,
+				      K_MSEC(conn->rtt.rto));
 	}
  out:
 	return ret;
 }
 
+#if defined(CONFIG_NET_TCP_CONGESTION_CONTROL)
+/* Resend the first unacknowledged segment without waiting for the
+ * retransmission timer, RFC 5681, ch. 3.2
+ */
+static void tcp_fast_retransmit(struct tcp *conn)
+{
+	NET_DBG("conn: %p fast retransmit", conn);
+
+	conn->rtt.timing = false;
+	conn->data_mode = TCP_DATA_MODE_RESEND;
+	conn->unacked_len = 0;
+	tcp_send_data(conn);
+}
+#endif
+
+/* Check for a duplicate ACK as defined in RFC 5681, ch. 2, and feed it
+ * to the congestion control. The send_win is the window before this
+ * segment was received.
+ */
+static void tcp_dup_ack_check(struct tcp *conn, struct tcphdr *th,
+			      size_t len, uint16_t send_win)
+{
+#if defined(CONFIG_NET_TCP_CONGESTION_CONTROL)
+	if (th->th_flags != ACK || len || th_ack(th) != conn->seq ||
+	    conn->unacked_len <= 0 || conn->send_win != send_win) {
+		return;
+	}
+
+	if (conn->data_mode != TCP_DATA_MODE_SEND && !conn->cc.in_recovery) {
+		return;
+	}
+
+	if (tcp_cc_dup_ack(&conn->cc, conn->unacked_len,
+			   conn->seq + conn->unacked_len)) {
+		tcp_fast_retransmit(conn);
+	}
+#else
+	ARG_UNUSED(conn);
+	ARG_UNUSED(th);
+	ARG_UNUSED(len);
+	ARG_UNUSED(send_win);
+#endif
+}
+
 static void tcp_resend_data(struct k_work *work)
 {
 	struct tcp *conn = CONTAINER_OF(work, struct tcp, send_data_timer);
@@ -812,12 +1008,17 @@ static void tcp_resend_data(struct k_work *work)
 		goto out;
 	}
 
+#if defined(CONFIG_NET_TCP_CONGESTION_CONTROL)
+	tcp_cc_timeout(&conn->cc, conn->unacked_len);
+#endif
+	tcp_rto_backoff(conn);
+
 	conn->data_mode = TCP_DATA_MODE_RESEND;
 	conn->unacked_len = 0;
 	tcp_send_data(conn);
 
 	conn->send_data_retries++;
-	k_delayed_work_submit(&conn->send_data_timer, K_MSEC(tcp_rto));
+	k_delayed_work_submit(&conn->send_data_timer, K_MSEC(conn->rtt.rto));
  out:
 	if (conn_unref) {
 		tcp_conn_unref(conn);
@@ -858,8 +1059,13 @@ static struct tcp *tcp_conn_alloc(void)
 
 	conn->recv_win = tcp_window;
 
-	conn->seq = (IS_ENABLED(CONFIG_NET_TEST_PROTOCOL) ||
-		     IS_ENABLED(CONFIG_NET_TEST)) ? 0 : sys_rand32_get();
+	conn->rtt.rto = tcp_rto;
+
+#if defined(CONFIG_NET_TCP_CONGESTION_CONTROL)
+	tcp_cc_init(&conn->cc, tcp_cc_find(NULL), conn_mss(conn));
+#endif
+
+	conn->seq = tcp_isn();
 
 	sys_slist_init(&conn->send_queue);
 
@@ -899,41 +1105,376 @@ out:
 	return ret;
 }
 
-static bool tcp_endpoint_cmp(union tcp_endpoint *ep, struct net_pkt *pkt,
-			     enum pkt_addr which)
+static struct tcp *tcp_conn_search(struct net_pkt *pkt)
+{
+	union tcp_endpoint src, dst;
+	struct tcp *conn;
+	size_t len;
+	int key;
+
+	if (tcp_endpoint_set(&src, pkt, TCP_EP_DST) < 0 ||
+	    tcp_endpoint_set(&dst, pkt, TCP_EP_SRC) < 0) {
+		return NULL;
+	}
+
+	len = tcp_endpoint_len(src.sa.sa_family);
+
+	key = irq_lock();
+
+	SYS_SLIST_FOR_EACH_CONTAINER(tcp_conn_bucket(&src, &dst), conn,
+				     hash_next) {
+		if (!memcmp(&conn->src, &src, len) &&
+		    !memcmp(&conn->dst, &dst, len)) {
+			break;
+		}
+	}
+
+	irq_unlock(key);
+
+	return conn;
+}
+
+static struct tcp *tcp_conn_new(struct net_pkt *pkt);
+
+/* Fill in the endpoints of a half-open connection from a packet
+ * received by the listener
+ */
+static int tcp_backlog_entry_set(struct tcp_backlog_entry *entry,
+				 struct tcp *listener, struct net_pkt *pkt)
 {
-	union tcp_endpoint ep_tmp;
+	memset(entry, 0, sizeof(*entry));
+
+	entry->listener = listener;
+	entry->iface = net_pkt_iface(pkt);
+
+	if (tcp_endpoint_set(&entry->src, pkt, TCP_EP_DST) < 0 ||
+	    tcp_endpoint_set(&entry->dst, pkt, TCP_EP_SRC) < 0) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static bool tcp_backlog_expired(struct tcp_backlog_entry *entry)
+{
+	return k_uptime_get_32() - entry->timestamp >
+		CONFIG_NET_TCP_ACK_TIMEOUT;
+}
+
+/* Must be called with interrupts locked */
+static struct tcp_backlog_entry *tcp_backlog_find(
+					struct tcp_backlog_entry *key)
+{
+	size_t len = tcp_endpoint_len(key->src.sa.sa_family);
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(tcp_backlog); i++) {
+		if (tcp_backlog[i].listener == key->listener &&
+		    !memcmp(&tcp_backlog[i].src, &key->src, len) &&
+		    !memcmp(&tcp_backlog[i].dst, &key->dst, len)) {
+			return &tcp_backlog[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* Must be called with interrupts locked */
+static struct tcp_backlog_entry *tcp_backlog_get(void)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(tcp_backlog); i++) {
+		if (!tcp_backlog[i].listener ||
+		    tcp_backlog_expired(&tcp_backlog[i])) {
+			return &tcp_backlog[i];
+		}
+	}
+
+	return NULL;
+}
+
+static void tcp_backlog_purge(struct tcp *listener)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(tcp_backlog); i++) {
+		if (tcp_backlog[i].listener == listener) {
+			tcp_backlog[i].listener = NULL;
+		}
+	}
+}
+
+/* Send a segment on behalf of a half-open connection, it has no
+ * net_context of its own so the one of the listener is used
+ */
+static void tcp_backlog_send(struct tcp_backlog_entry *entry, uint8_t flags)
+{
+	NET_PKT_DATA_ACCESS_DEFINE(tcp_access, struct tcphdr);
+	struct net_context *context = entry->listener->context;
+	sa_family_t af = entry->src.sa.sa_family;
+	struct net_pkt *pkt;
+	struct tcphdr *th;
+	int ret = -EINVAL;
+
+	pkt = net_pkt_alloc_with_buffer(entry->iface, sizeof(struct tcphdr),
+					af, IPPROTO_TCP,
+					TCP_PKT_ALLOC_TIMEOUT);
+	if (!pkt) {
+		return;
+	}
+
+	tp_pkt_alloc(pkt, tp_basename(__FILE__), __LINE__);
+
+	if (IS_ENABLED(CONFIG_NET_IPV4) && af == AF_INET) {
+		ret = net_context_create_ipv4_new(context, pkt,
+						  &entry->src.sin.sin_addr,
+						  &entry->dst.sin.sin_addr);
+	} else if (IS_ENABLED(CONFIG_NET_IPV6) && af == AF_INET6) {
+		ret = net_context_create_ipv6_new(context, pkt,
+						  &entry->src.sin6.sin6_addr,
+						  &entry->dst.sin6.sin6_addr);
+	}
+
+	if (ret < 0) {
+		goto fail;
+	}
 
-	if (tcp_endpoint_set(&ep_tmp, pkt, which) < 0) {
+	th = (struct tcphdr *)net_pkt_get_data(pkt, &tcp_access);
+	if (!th) {
+		goto fail;
+	}
+
+	memset(th, 0, sizeof(struct tcphdr));
+
+	th->th_sport = entry->src.sin.sin_port;
+	th->th_dport = entry->dst.sin.sin_port;
+	th->th_off = 5;
+	th->th_flags = flags;
+	th->th_win = htons(tcp_window);
+	th->th_seq = htonl(entry->seq);
+
+	if (ACK & flags) {
+		th->th_ack = htonl(entry->ack);
+	}
+
+	if (net_pkt_set_data(pkt, &tcp_access) < 0 ||
+	    tcp_finalize_pkt(pkt) < 0) {
+		goto fail;
+	}
+
+	tcp_send(pkt);
+
+	return;
+fail:
+	tcp_pkt_unref(pkt);
+}
+
+#if defined(CONFIG_NET_TCP_SYN_COOKIES)
+/* The cookie is our initial sequence number: a 5 bit counter of
+ * TCP_SYN_COOKIE_PERIOD intervals, 3 bits selecting the peer MSS and
+ * a 24 bit hash of the connection, the counter and the MSS.
+ */
+#define TCP_SYN_COOKIE_PERIOD 64000 /* ms */
+
+static const uint16_t tcp_syn_cookie_mss[] = { 536, 1220, 1440, 1460 };
+
+static uint32_t tcp_syn_cookie_count(void)
+{
+	return (k_uptime_get_32() / TCP_SYN_COOKIE_PERIOD) & 0x1f;
+}
+
+static uint32_t tcp_syn_cookie_hash(struct tcp_backlog_entry *entry,
+				    uint32_t count, uint32_t mss_idx)
+{
+	size_t len = tcp_endpoint_len(entry->src.sa.sa_family);
+	uint32_t hash = 2166136261U ^ tcp_syn_cookie_secret;
+
+	hash = tcp_hash_add(hash, &entry->src, len);
+	hash = tcp_hash_add(hash, &entry->dst, len);
+	hash = tcp_hash_add(hash, &entry->ack, sizeof(entry->ack));
+	hash = tcp_hash_add(hash, &count, sizeof(count));
+	hash = tcp_hash_add(hash, &mss_idx, sizeof(mss_idx));
+
+	/* Mix the last bytes into the upper bits too */
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bU;
+	hash ^= hash >> 13;
+
+	return hash & 0xffffff;
+}
+
+static uint32_t tcp_syn_cookie(struct tcp_backlog_entry *entry)
+{
+	uint16_t mss = entry->recv_options.mss_found ?
+		entry->recv_options.mss : tcp_syn_cookie_mss[0];
+	uint32_t count = tcp_syn_cookie_count();
+	uint32_t idx;
+
+	for (idx = ARRAY_SIZE(tcp_syn_cookie_mss) - 1; idx > 0; idx--) {
+		if (tcp_syn_cookie_mss[idx] <= mss) {
+			break;
+		}
+	}
+
+	return count << 27 | idx << 24 |
+		tcp_syn_cookie_hash(entry, count, idx);
+}
+
+/* Check the cookie echoed in the final ACK of the handshake and
+ * restore the state which was not kept
+ */
+static bool tcp_syn_cookie_check(struct tcp_backlog_entry *entry,
+				 uint32_t cookie)
+{
+	uint32_t count = cookie >> 27;
+	uint32_t idx = (cookie >> 24) & 0x7;
+
+	if (((tcp_syn_cookie_count() - count) & 0x1f) > 1 ||
+	    idx >= ARRAY_SIZE(tcp_syn_cookie_mss) ||
+	    (cookie & 0xffffff) != tcp_syn_cookie_hash(entry, count, idx)) {
 		return false;
 	}
 
-	return !memcmp(ep, &ep_tmp, tcp_endpoint_len(ep->sa.sa_family));
+	entry->seq = cookie;
+	entry->recv_options.mss = tcp_syn_cookie_mss[idx];
+	entry->recv_options.mss_found = true;
+
+	return true;
 }
+#endif /* CONFIG_NET_TCP_SYN_COOKIES */
 
-static bool tcp_conn_cmp(struct tcp *conn, struct net_pkt *pkt)
+/* SYN to a listener: queue a half-open connection and reply with
+ * SYN-ACK, the connection itself is created by tcp_backlog_ack()
+ */
+static void tcp_backlog_syn(struct tcp *listener, struct net_pkt *pkt,
+			    struct tcphdr *th)
 {
-	return tcp_endpoint_cmp(&conn->src, pkt, TCP_EP_DST) &&
-		tcp_endpoint_cmp(&conn->dst, pkt, TCP_EP_SRC);
+	size_t options_len = (th->th_off - 5) * 4;
+	struct tcp_backlog_entry tmp, *entry;
+	int key;
+
+	if (th->th_off < 5 || tcp_backlog_entry_set(&tmp, listener, pkt) < 0) {
+		return;
+	}
+
+	if (options_len && !tcp_options_check(&tmp.recv_options, pkt,
+					      options_len)) {
+		NET_DBG("DROP: Invalid TCP option list");
+		return;
+	}
+
+	tmp.ack = th_seq(th) + 1;
+	tmp.timestamp = k_uptime_get_32();
+
+	key = irq_lock();
+
+	entry = tcp_backlog_find(&tmp);
+	if (entry) {
+		/* Retransmitted SYN, our SYN-ACK was lost */
+		entry->ack = tmp.ack;
+		entry->timestamp = tmp.timestamp;
+		tmp = *entry;
+	} else {
+		entry = tcp_backlog_get();
+		if (entry) {
+			tmp.seq = tcp_isn();
+			*entry = tmp;
+		}
+	}
+
+	irq_unlock(key);
+
+	if (!entry) {
+#if defined(CONFIG_NET_TCP_SYN_COOKIES)
+		tmp.seq = tcp_syn_cookie(&tmp);
+#else
+		NET_DBG("DROP: SYN queue full");
+		return;
+#endif
+	}
+
+	tcp_backlog_send(&tmp, SYN | ACK);
 }
 
-static struct tcp *tcp_conn_search(struct net_pkt *pkt)
+/* ACK to a listener: complete the handshake of a half-open connection
+ * and create the connection for it
+ */
+static struct tcp *tcp_backlog_ack(struct tcp *listener, struct net_pkt *pkt,
+				   struct tcphdr *th)
 {
-	bool found = false;
+	struct tcp_backlog_entry tmp, *entry;
 	struct tcp *conn;
+	int key;
 
-	SYS_SLIST_FOR_EACH_CONTAINER(&tcp_conns, conn, next) {
+	if (tcp_backlog_entry_set(&tmp, listener, pkt) < 0) {
+		return NULL;
+	}
 
-		found = tcp_conn_cmp(conn, pkt);
-		if (found) {
-			break;
+	key = irq_lock();
+
+	entry = tcp_backlog_find(&tmp);
+	if (entry && th_ack(th) == entry->seq + 1 && th_seq(th) == entry->ack) {
+		tmp = *entry;
+		entry->listener = NULL;
+	} else {
+		entry = NULL;
+	}
+
+	irq_unlock(key);
+
+	if (!entry) {
+#if defined(CONFIG_NET_TCP_SYN_COOKIES)
+		tmp.ack = th_seq(th);
+
+		if (!tcp_syn_cookie_check(&tmp, th_ack(th) - 1)) {
+			goto reset;
 		}
+#else
+		goto reset;
+#endif
+	}
+
+	conn = tcp_conn_new(pkt);
+	if (!conn) {
+		goto reset;
 	}
 
-	return found ? conn : NULL;
+	conn->seq = tmp.seq + 1;
+	conn->ack = tmp.ack;
+	conn->recv_options = tmp.recv_options;
+#if defined(CONFIG_NET_TCP_CONGESTION_CONTROL)
+	tcp_cc_set_mss(&conn->cc, conn_mss(conn));
+#endif
+	conn_state(conn, TCP_SYN_RECEIVED);
+
+	return conn;
+reset:
+	tmp.seq = th_ack(th);
+	tcp_backlog_send(&tmp, RST);
+
+	return NULL;
 }
 
-static struct tcp *tcp_conn_new(struct net_pkt *pkt);
+/* RST to a listener: forget the half-open connection */
+static void tcp_backlog_rst(struct tcp *listener, struct net_pkt *pkt)
+{
+	struct tcp_backlog_entry tmp, *entry;
+	int key;
+
+	if (tcp_backlog_entry_set(&tmp, listener, pkt) < 0) {
+		return;
+	}
+
+	key = irq_lock();
+
+	entry = tcp_backlog_find(&tmp);
+	if (entry) {
+		entry->listener = NULL;
+	}
+
+	irq_unlock(key);
+}
 
 static enum net_verdict tcp_recv(struct net_conn *net_conn,
 				 struct net_pkt *pkt,
@@ -941,6 +1482,7 @@ static enum net_verdict tcp_recv(struct net_conn *net_conn,
 				 union net_proto_header *proto,
 				 void *user_data)
 {
+	struct tcp *conn_old = ((struct net_context *)user_data)->tcp;
 	struct tcp *conn;
 	struct tcphdr *th;
 
@@ -954,10 +1496,21 @@ static enum net_verdict tcp_recv(struct net_conn *net_conn,
 
 	th = th_get(pkt);
 
-	if (th->th_flags & SYN && !(th->th_flags & ACK)) {
-		struct tcp *conn_old = ((struct net_context *)user_data)->tcp;
+	if (!th || !conn_old || !conn_old->accept_cb) {
+		goto out;
+	}
 
-		conn = tcp_conn_new(pkt);
+	if (th->th_flags & RST) {
+		tcp_backlog_rst(conn_old, pkt);
+	} else if (th->th_flags & SYN) {
+		if (!(th->th_flags & ACK)) {
+			tcp_backlog_syn(conn_old, pkt, th);
+		}
+	} else if (th->th_flags & ACK) {
+		conn = tcp_backlog_ack(conn_old, pkt, th);
+		if (!conn) {
+			goto out;
+		}
 
 		net_ipaddr_copy(&conn_old->context->remote, &conn->dst.sa);
 
@@ -970,7 +1523,7 @@ static enum net_verdict tcp_recv(struct net_conn *net_conn,
 	if (conn) {
 		tcp_in(conn, pkt);
 	}
-
+ out:
 	return NET_DROP;
 }
 
@@ -1014,6 +1567,8 @@ static struct tcp *tcp_conn_new(struct net_pkt *pkt)
 		log_strdup(net_sprint_addr(conn->dst.sa.sa_family,
 				(const void *)&conn->dst.sin.sin_addr)));
 
+	tcp_conn_hash_add(conn);
+
 	memcpy(&context->remote, &conn->dst, sizeof(context->remote));
 	context->flags |= NET_CONTEXT_REMOTE_ADDR_SET;
 
@@ -1065,6 +1620,7 @@ static void tcp_in(struct tcp *conn, struct net_pkt *pkt)
 	struct tcphdr *th = pkt ? th_get(pkt) : NULL;
 	uint8_t next = 0, fl = th ? th->th_flags : 0;
 	size_t tcp_options_len = th ? (th->th_off - 5) * 4 : 0;
+	uint16_t send_win = conn->send_win;
 	size_t len;
 
 	k_mutex_lock(&conn->lock, K_FOREVER);
@@ -1085,6 +1641,12 @@ static void tcp_in(struct tcp *conn, struct net_pkt *pkt)
 		goto next_state;
 	}
 
+#if defined(CONFIG_NET_TCP_CONGESTION_CONTROL)
+	if (tcp_options_len) {
+		tcp_cc_set_mss(&conn->cc, conn_mss(conn));
+	}
+#endif
+
 	if (th) {
 		conn->send_win = ntohs(th->th_win);
 	}
@@ -1111,7 +1673,12 @@ next_state:
 	case TCP_SYN_RECEIVED:
 		if (FL(&fl, &, ACK, th_ack(th) == conn->seq &&
 				th_seq(th) == conn->ack)) {
-			tcp_send_timer_cancel(conn);
+			/* The SYN-ACK was not queued if it was sent on
+			 * behalf of the listener
+			 */
+			if (conn->in_retransmission) {
+				tcp_send_timer_cancel(conn);
+			}
 			next = TCP_ESTABLISHED;
 			net_context_set_state(conn->context,
 					      NET_CONTEXT_CONNECTED);
@@ -1134,6 +1701,7 @@ next_state:
 			next = TCP_ESTABLISHED;
 			net_context_set_state(conn->context,
 					      NET_CONTEXT_CONNECTED);
+			tcp_connect_done(conn, 0);
 			if (FL(&fl, &, PSH)) {
 				if (tcp_data_get(conn, pkt) < 0) {
 					break;
@@ -1181,6 +1749,19 @@ next_state:
 
 			conn_send_data_dump(conn);
 
+			if (conn->rtt.timing &&
+			    net_tcp_seq_cmp(th_ack(th), conn->rtt.seq) >= 0) {
+				conn->rtt.timing = false;
+				tcp_rtt_update(conn, k_uptime_get_32() -
+					       conn->rtt.timestamp);
+			}
+			conn->rtt.rto = tcp_rtt_rto(&conn->rtt);
+
+#if defined(CONFIG_NET_TCP_CONGESTION_CONTROL)
+			tcp_cc_ack(&conn->cc, th_ack(th), len_acked,
+				   k_uptime_get_32());
+#endif
+
 			if (!k_delayed_work_remaining_get(&conn->send_data_timer)) {
 				NET_ERR("conn: %p, Missing a subscription "
 					"of the send_data queue timer", conn);
@@ -1200,6 +1781,8 @@ next_state:
 				conn_state(conn, TCP_CLOSED);
 				break;
 			}
+		} else if (th) {
+			tcp_dup_ack_check(conn, th, len, send_win);
 		}
 
 		if (len) {
@@ -1283,7 +1866,10 @@ int net_tcp_put(struct net_context *context)
 
 	NET_DBG("%s", conn ? log_strdup(tcp_conn_state(conn, NULL)) : "");
 
-	if (conn) {
+	/* A listener or a connection not yet established has nobody to
+	 * send the FIN to
+	 */
+	if (conn && conn->state == TCP_ESTABLISHED) {
 		k_mutex_lock(&conn->lock, K_FOREVER);
 
 		tcp_out(conn, FIN | ACK);
@@ -1372,10 +1958,10 @@ int net_tcp_connect(struct net_context *context,
 		    k_timeout_t timeout, net_context_connect_cb_t cb,
 		    void *user_data)
 {
+	struct tcp_connect_wait connect_wait;
 	struct tcp *conn;
-	int ret;
-
-	ARG_UNUSED(timeout);
+	bool wait;
+	int ret, key;
 
 	NET_DBG("context: %p, local: %s, remote: %s", context,
 		log_strdup(net_sprint_addr(
@@ -1442,6 +2028,8 @@ int net_tcp_connect(struct net_context *context,
 		log_strdup(net_sprint_addr(conn->dst.sa.sa_family,
 				(const void *)&conn->dst.sin.sin_addr)));
 
+	tcp_conn_hash_add(conn);
+
 	net_context_set_state(context, NET_CONTEXT_CONNECTING);
 
 	ret = net_conn_register(net_context_get_ip_proto(context),
@@ -1454,12 +2042,42 @@ int net_tcp_connect(struct net_context *context,
 		return ret;
 	}
 
+	wait = !IS_ENABLED(CONFIG_NET_TEST_PROTOCOL) &&
+		!K_TIMEOUT_EQ(timeout, K_NO_WAIT);
+	if (wait) {
+		k_sem_init(&connect_wait.sem, 0, 1);
+		connect_wait.result = -EINPROGRESS;
+		conn->connect_wait = &connect_wait;
+	}
+
 	/* Input of a (nonexistent) packet with no flags set will cause
 	 * a TCP connection to be established
 	 */
 	tcp_in(conn, NULL);
 
-	return 0;
+	if (!wait) {
+		return 0;
+	}
+
+	/* The connection may be reset, or give up sending the SYN, and be
+	 * released while waiting. It then reports the result through
+	 * connect_wait before it goes, so conn is only used again if the
+	 * wait timed out before that.
+	 */
+	k_sem_take(&connect_wait.sem, timeout);
+
+	key = irq_lock();
+
+	if (connect_wait.result == -EINPROGRESS) {
+		conn->connect_wait = NULL;
+		ret = -ETIMEDOUT;
+	} else {
+		ret = connect_wait.result;
+	}
+
+	irq_unlock(key);
+
+	return ret;
 }
 
 int net_tcp_accept(struct net_context *context, net_tcp_accept_cb_t cb,
@@ -1572,6 +2190,8 @@ struct net_tcp_hdr *net_tcp_input(struct net_pkt *pkt,
 {
 	struct net_tcp_hdr *tcp_hdr;
 
+	net_pkt_set_rx_stats_tick(pkt, NET_STATS_RX_DETAIL_L4);
+
 	if (IS_ENABLED(CONFIG_NET_TCP_CHECKSUM) &&
 			net_if_need_calc_rx_checksum(net_pkt_iface(pkt)) &&
 			net_calc_chksum_tcp(pkt) != 0U) {
@@ -1589,6 +2209,52 @@ drop:
 	return NULL;
 }
 
+static void tcp_info_get(struct tcp *conn, struct net_tcp_info *info)
+{
+	memset(info, 0, sizeof(*info));
+
+	info->context = conn->context;
+	info->state = tcp_state_to_str(conn->state, false);
+	info->seq = conn->seq;
+	info->ack = conn->ack;
+	info->mss = conn_mss(conn);
+	info->send_win = conn->send_win;
+	info->unacked_len = conn->unacked_len;
+	info->srtt = conn->rtt.srtt >> 3;
+	info->rttvar = conn->rtt.rttvar >> 2;
+	info->rto = conn->rtt.rto;
+#if defined(CONFIG_NET_TCP_CONGESTION_CONTROL)
+	info->cc = conn->cc.ops->name;
+	info->cwnd = conn->cc.cwnd;
+	info->ssthresh = conn->cc.ssthresh;
+#endif
+}
+
+void net_tcp_info_foreach(net_tcp_info_cb_t cb, void *user_data)
+{
+	struct tcp *conn, *tmp;
+	struct net_tcp_info info;
+	int key;
+
+	key = irq_lock();
+
+	SYS_SLIST_FOR_EACH_CONTAINER_SAFE(&tcp_conns, conn, tmp, next) {
+		if (conn->context == NULL) {
+			continue;
+		}
+
+		tcp_info_get(conn, &info);
+
+		irq_unlock(key);
+
+		cb(&info, user_data);
+
+		key = irq_lock();
+	}
+
+	irq_unlock(key);
+}
+
 #if defined(CONFIG_NET_TEST_PROTOCOL)
 static enum net_verdict tcp_input(struct net_conn *net_conn,
 				  struct net_pkt *pkt,
@@ -1609,6 +2275,7 @@ static enum net_verdict tcp_input(struct net_conn *net_conn,
 			conn = context->tcp;
 			tcp_endpoint_set(&conn->dst, pkt, TCP_EP_SRC);
 			tcp_endpoint_set(&conn->src, pkt, TCP_EP_DST);
+			tcp_conn_hash_add(conn);
 			/* Make an extra reference, the sanity check suite
 			 * will delete the connection explicitly
 			 */
@@ -1840,6 +2507,10 @@ static void test_cb_register(sa_family_t family, uint8_t proto, uint16_t remote_
 
 void net_tcp_init(void)
 {
+#if defined(CONFIG_NET_TCP_SYN_COOKIES)
+	tcp_syn_cookie_secret = sys_rand32_get();
+#endif
+
 #if defined(CONFIG_NET_TEST_PROTOCOL)
 	/* Register inputs for TTCN-3 based TCP2 sanity check */
 	test_cb_register(AF_INET,  IPPROTO_TCP, 4242, 4242, tcp_input);
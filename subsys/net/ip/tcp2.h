@@ -115,6 +115,40 @@ struct net_tcp_hdr *net_tcp_input(struct net_pkt *pkt,
  *       re-factorig
  */
 
+/**
+ * @brief TCP connection information, see net_tcp_info_foreach()
+ */
+struct net_tcp_info {
+	struct net_context *context;
+	const char *state;
+	/** Congestion control algorithm, NULL if not enabled */
+	const char *cc;
+	uint32_t seq;
+	uint32_t ack;
+	/** Congestion window and slow start threshold (bytes) */
+	uint32_t cwnd;
+	uint32_t ssthresh;
+	/** Smoothed RTT, RTT variation and retransmission timeout (ms) */
+	uint32_t srtt;
+	uint32_t rttvar;
+	uint32_t rto;
+	int unacked_len;
+	uint16_t mss;
+	uint16_t send_win;
+};
+
+typedef void (*net_tcp_info_cb_t)(const struct net_tcp_info *info,
+				  void *user_data);
+
+/**
+ * @brief Go through all the TCP connections and call the callback
+ *        with a snapshot of the connection state
+ *
+ * @param cb		Callback to call for each connection
+ * @param user_data	User data passed as an argument in the callback
+ */
+void net_tcp_info_foreach(net_tcp_info_cb_t cb, void *user_data);
+
 /* No ops, provided for compatibility with the old TCP */
 
 void net_tcp_init(void);
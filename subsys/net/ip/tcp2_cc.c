@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_DECLARE(net_tcp, CONFIG_NET_TCP_LOG_LEVEL);
+
+#include <string.h>
+#include <zephyr.h>
+#include <net/net_core.h>
+#include <net/net_ip.h>
+
+#include "tcp2_cc.h"
+
+static const struct tcp_cc_ops *const tcp_cc_algos[] = {
+	&tcp_cc_newreno,
+	&tcp_cc_cubic,
+};
+
+const struct tcp_cc_ops *tcp_cc_find(const char *name)
+{
+	int i;
+
+	if (name == NULL) {
+		return IS_ENABLED(CONFIG_NET_TCP_CC_CUBIC) ?
+			&tcp_cc_cubic : &tcp_cc_newreno;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(tcp_cc_algos); i++) {
+		if (strcmp(tcp_cc_algos[i]->name, name) == 0) {
+			return tcp_cc_algos[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* RFC 6928, initial window */
+static uint32_t tcp_cc_initial_window(uint16_t mss)
+{
+	return MIN(10U * mss, MAX(2U * mss, 14600U));
+}
+
+void tcp_cc_init(struct tcp_cc *cc, const struct tcp_cc_ops *ops,
+		 uint16_t mss)
+{
+	memset(cc, 0, sizeof(*cc));
+
+	cc->ops = ops;
+	cc->mss = mss;
+	cc->cwnd = tcp_cc_initial_window(mss);
+	cc->ssthresh = TCP_CC_CWND_MAX;
+
+	if (cc->ops->init) {
+		cc->ops->init(cc);
+	}
+}
+
+void tcp_cc_set_mss(struct tcp_cc *cc, uint16_t mss)
+{
+	if (mss == 0U || mss == cc->mss) {
+		return;
+	}
+
+	/* Until the first loss the window is still the initial one,
+	 * recalculate it for the negotiated MSS.
+	 */
+	if (cc->ssthresh == TCP_CC_CWND_MAX &&
+	    cc->cwnd == tcp_cc_initial_window(cc->mss)) {
+		cc->cwnd = tcp_cc_initial_window(mss);
+	}
+
+	cc->mss = mss;
+}
+
+static void tcp_cc_slow_start(struct tcp_cc *cc, uint32_t acked)
+{
+	/* RFC 5681, ch. 3.1, increase by at most SMSS per ACK */
+	cc->cwnd += MIN(acked, cc->mss);
+}
+
+void tcp_cc_ack(struct tcp_cc *cc, uint32_t ack, uint32_t acked,
+		uint32_t now)
+{
+	cc->dup_acks = 0U;
+
+	if (cc->in_recovery) {
+		if (net_tcp_seq_cmp(ack, cc->recover) >= 0) {
+			/* Full ACK, RFC 6582, deflate the window */
+			cc->in_recovery = false;
+			cc->cwnd = cc->ssthresh;
+			NET_DBG("cc: %p recovered, cwnd=%u", cc, cc->cwnd);
+		} else {
+			/* Partial ACK, RFC 6582, ch. 3.2, step 5 */
+			cc->cwnd -= MIN(acked, cc->cwnd - cc->mss);
+			if (acked >= cc->mss) {
+				cc->cwnd += cc->mss;
+			}
+		}
+
+		return;
+	}
+
+	if (cc->cwnd < cc->ssthresh) {
+		tcp_cc_slow_start(cc, acked);
+	} else {
+		cc->ops->cong_avoid(cc, acked, now);
+	}
+
+	cc->cwnd = MIN(cc->cwnd, TCP_CC_CWND_MAX);
+}
+
+bool tcp_cc_dup_ack(struct tcp_cc *cc, uint32_t flight, uint32_t snd_nxt)
+{
+	if (cc->in_recovery) {
+		/* RFC 6582, ch. 3.2, step 4, inflate the window */
+		cc->cwnd = MIN(cc->cwnd + cc->mss, TCP_CC_CWND_MAX);
+		return false;
+	}
+
+	if (++cc->dup_acks < TCP_CC_DUPACK_THRESHOLD) {
+		return false;
+	}
+
+	cc->ssthresh = cc->ops->ssthresh(cc, flight);
+	cc->cwnd = MIN(cc->ssthresh + TCP_CC_DUPACK_THRESHOLD * cc->mss,
+		       TCP_CC_CWND_MAX);
+	cc->recover = snd_nxt;
+	cc->in_recovery = true;
+	cc->bytes_acked = 0U;
+
+	NET_DBG("cc: %p fast retransmit, cwnd=%u ssthresh=%u", cc,
+		cc->cwnd, cc->ssthresh);
+
+	return true;
+}
+
+void tcp_cc_timeout(struct tcp_cc *cc, uint32_t flight)
+{
+	/* RFC 5681, ch. 3.1, equation (4) and the loss window */
+	cc->ssthresh = cc->ops->ssthresh(cc, flight);
+	cc->cwnd = cc->mss;
+	cc->dup_acks = 0U;
+	cc->in_recovery = false;
+	cc->bytes_acked = 0U;
+
+	NET_DBG("cc: %p timeout, cwnd=%u ssthresh=%u", cc,
+		cc->cwnd, cc->ssthresh);
+}
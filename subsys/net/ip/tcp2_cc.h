@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @brief TCP congestion control
+ *
+ * The generic part (slow start, duplicate ACK counting, fast
+ * retransmit/fast recovery and the retransmission timeout reaction)
+ * lives in tcp2_cc.c, the algorithms only provide the congestion
+ * avoidance increase and the slow start threshold after a loss.
+ *
+ * All the window values are in bytes.
+ */
+
+#ifndef TCP2_CC_H
+#define TCP2_CC_H
+
+#include <zephyr/types.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of duplicate ACKs which trigger the fast retransmit */
+#define TCP_CC_DUPACK_THRESHOLD 3
+
+/* No window scaling is supported, so the congestion window is capped
+ * by the largest window a peer is able to advertise.
+ */
+#define TCP_CC_CWND_MAX UINT16_MAX
+
+struct tcp_cc;
+
+struct tcp_cc_ops {
+	/** Name of the algorithm, f.ex. "newreno" */
+	const char *name;
+
+	/** Reset the algorithm specific state */
+	void (*init)(struct tcp_cc *cc);
+
+	/** Increase cwnd in the congestion avoidance phase */
+	void (*cong_avoid)(struct tcp_cc *cc, uint32_t acked, uint32_t now);
+
+	/** Return the slow start threshold after a loss event */
+	uint32_t (*ssthresh)(struct tcp_cc *cc, uint32_t flight);
+};
+
+struct tcp_cc_cubic {
+	uint32_t w_max;
+	uint32_t w_last_max;
+	uint32_t w_est;
+	uint32_t epoch_start;
+	uint32_t k;
+	uint32_t ack_cnt;
+};
+
+struct tcp_cc {
+	const struct tcp_cc_ops *ops;
+	uint32_t cwnd;
+	uint32_t ssthresh;
+	uint32_t recover;
+	uint32_t bytes_acked;
+	uint16_t mss;
+	uint8_t dup_acks;
+	bool in_recovery : 1;
+	union {
+		struct tcp_cc_cubic cubic;
+	};
+};
+
+extern const struct tcp_cc_ops tcp_cc_newreno;
+extern const struct tcp_cc_ops tcp_cc_cubic;
+
+/**
+ * @brief Find a congestion control algorithm by name
+ *
+ * @param name Algorithm name, NULL selects the default algorithm
+ *
+ * @return Pointer to the algorithm, NULL if not found
+ */
+const struct tcp_cc_ops *tcp_cc_find(const char *name);
+
+/**
+ * @brief Initialize the congestion control state of a connection
+ *
+ * @param cc Congestion control state
+ * @param ops Algorithm to use
+ * @param mss Sender maximum segment size
+ */
+void tcp_cc_init(struct tcp_cc *cc, const struct tcp_cc_ops *ops,
+		 uint16_t mss);
+
+/**
+ * @brief Update the sender maximum segment size
+ *
+ * @param cc Congestion control state
+ * @param mss Sender maximum segment size
+ */
+void tcp_cc_set_mss(struct tcp_cc *cc, uint16_t mss);
+
+/**
+ * @brief Process an ACK which acknowledges new data
+ *
+ * @param cc Congestion control state
+ * @param ack Acknowledgment number of the segment
+ * @param acked Number of newly acknowledged bytes
+ * @param now Current time in milliseconds
+ */
+void tcp_cc_ack(struct tcp_cc *cc, uint32_t ack, uint32_t acked,
+		uint32_t now);
+
+/**
+ * @brief Process a duplicate ACK
+ *
+ * @param cc Congestion control state
+ * @param flight Number of bytes in flight
+ * @param snd_nxt Sequence number of the next new byte to be sent
+ *
+ * @return true if the first unacknowledged segment should be
+ *         retransmitted (fast retransmit), false otherwise
+ */
+bool tcp_cc_dup_ack(struct tcp_cc *cc, uint32_t flight, uint32_t snd_nxt);
+
+/**
+ * @brief React to a retransmission timeout
+ *
+ * @param cc Congestion control state
+ * @param flight Number of bytes in flight when the timer expired
+ */
+void tcp_cc_timeout(struct tcp_cc *cc, uint32_t flight);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TCP2_CC_H */
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* CUBIC congestion control, RFC 8312
+ *
+ * Fixed point version of the window growth function
+ * W(t) = C * (t - K)^3 + W_max, with C = 0.4 and beta = 0.7, where
+ * the time is kept in milliseconds and the windows in bytes.
+ */
+
+#include <string.h>
+#include <zephyr.h>
+
+#include "tcp2_cc.h"
+
+/* beta = 7 / 10 */
+#define CUBIC_BETA_NUM 7U
+#define CUBIC_BETA_DEN 10U
+
+/* Bound |t - K| so that the cube multiplied by the MSS fits 64 bits */
+#define CUBIC_DELTA_MAX_MS 100000
+
+static uint32_t cubic_cbrt(uint64_t x)
+{
+	uint64_t y = 0U;
+	int s;
+
+	for (s = 63; s >= 0; s -= 3) {
+		uint64_t b;
+
+		y <<= 1;
+		b = 3U * y * (y + 1U) + 1U;
+
+		if ((x >> s) >= b) {
+			x -= b << s;
+			y++;
+		}
+	}
+
+	return (uint32_t)y;
+}
+
+static void cubic_init(struct tcp_cc *cc)
+{
+	memset(&cc->cubic, 0, sizeof(cc->cubic));
+}
+
+static void cubic_epoch_start(struct tcp_cc *cc, uint32_t now)
+{
+	struct tcp_cc_cubic *c = &cc->cubic;
+
+	c->epoch_start = now ? now : 1U;
+	c->ack_cnt = 0U;
+	c->w_est = cc->cwnd;
+
+	if (cc->cwnd < c->w_max) {
+		/* K = cbrt((W_max - cwnd) / C), in milliseconds */
+		c->k = cubic_cbrt((uint64_t)(c->w_max - cc->cwnd) *
+				  2500000000ULL / cc->mss);
+	} else {
+		c->k = 0U;
+		c->w_max = cc->cwnd;
+	}
+}
+
+static void cubic_cong_avoid(struct tcp_cc *cc, uint32_t acked, uint32_t now)
+{
+	struct tcp_cc_cubic *c = &cc->cubic;
+	int64_t delta, target;
+	uint64_t num;
+
+	if (c->epoch_start == 0U) {
+		cubic_epoch_start(cc, now);
+	}
+
+	delta = (int32_t)(now - c->epoch_start) - (int64_t)c->k;
+	delta = MAX(MIN(delta, CUBIC_DELTA_MAX_MS), -CUBIC_DELTA_MAX_MS);
+
+	/* W_cubic(t) = C * (t - K)^3 + W_max, C = 0.4 = 2 / 5 */
+	target = c->w_max + (delta * delta * delta * cc->mss * 2) /
+		5000000000LL;
+	target = MIN(target, (int64_t)cc->cwnd + cc->cwnd / 2U);
+
+	/* TCP friendly region, ch. 4.2:
+	 * W_est += 3 * (1 - beta) / (1 + beta) * acked / cwnd
+	 */
+	num = c->ack_cnt + (uint64_t)acked * 9U * cc->mss;
+	c->w_est += num / (17U * cc->cwnd);
+	c->ack_cnt = num % (17U * cc->cwnd);
+
+	if (c->w_est > target) {
+		target = c->w_est;
+	}
+
+	if (target <= cc->cwnd) {
+		return;
+	}
+
+	/* Grow by (target - cwnd) / cwnd per acknowledged byte */
+	num = cc->bytes_acked + (uint64_t)(target - cc->cwnd) * acked;
+	cc->cwnd += num / cc->cwnd;
+	cc->bytes_acked = num % cc->cwnd;
+}
+
+static uint32_t cubic_ssthresh(struct tcp_cc *cc, uint32_t flight)
+{
+	struct tcp_cc_cubic *c = &cc->cubic;
+
+	ARG_UNUSED(flight);
+
+	c->epoch_start = 0U;
+
+	/* Fast convergence, ch. 4.6 */
+	if (cc->cwnd < c->w_last_max) {
+		c->w_last_max = cc->cwnd;
+		c->w_max = cc->cwnd * (CUBIC_BETA_DEN + CUBIC_BETA_NUM) /
+			(2U * CUBIC_BETA_DEN);
+	} else {
+		c->w_last_max = cc->cwnd;
+		c->w_max = cc->cwnd;
+	}
+
+	return MAX(cc->cwnd * CUBIC_BETA_NUM / CUBIC_BETA_DEN, 2U * cc->mss);
+}
+
+const struct tcp_cc_ops tcp_cc_cubic = {
+	.name = "cubic",
+	.init = cubic_init,
+	.cong_avoid = cubic_cong_avoid,
+	.ssthresh = cubic_ssthresh,
+};
@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* NewReno congestion control, RFC 5681 and RFC 6582 */
+
+#include <zephyr.h>
+
+#include "tcp2_cc.h"
+
+static void newreno_cong_avoid(struct tcp_cc *cc, uint32_t acked,
+			       uint32_t now)
+{
+	ARG_UNUSED(now);
+
+	/* RFC 5681, ch. 3.1, appropriate byte counting: increase by
+	 * one SMSS per cwnd worth of acknowledged data.
+	 */
+	cc->bytes_acked += acked;
+
+	if (cc->bytes_acked >= cc->cwnd) {
+		cc->bytes_acked -= cc->cwnd;
+		cc->cwnd += cc->mss;
+	}
+}
+
+static uint32_t newreno_ssthresh(struct tcp_cc *cc, uint32_t flight)
+{
+	return MAX(flight / 2U, 2U * cc->mss);
+}
+
+const struct tcp_cc_ops tcp_cc_newreno = {
+	.name = "newreno",
+	.cong_avoid = newreno_cong_avoid,
+	.ssthresh = newreno_ssthresh,
+};
@@ -5,6 +5,7 @@
  */
 
 #include "tp.h"
+#include "tcp2_cc.h"
 
 #define is(_a, _b) (strcmp((_a), (_b)) == 0)
 
@@ -176,8 +177,30 @@ struct tcp_options {
 	bool wnd_found : 1;
 };
 
+/* Round trip time estimation, RFC 6298. The smoothed RTT is kept
+ * scaled by 8 and the RTT variation scaled by 4, all in milliseconds.
+ */
+struct tcp_rtt {
+	uint32_t srtt;
+	uint32_t rttvar;
+	uint32_t rto;
+	uint32_t seq; /* the end of the timed segment */
+	uint32_t timestamp;
+	bool timing : 1;
+	bool sampled : 1;
+};
+
+/* A thread waiting in net_tcp_connect(), lives on the stack of that
+ * thread so that it stays valid when the connection is released.
+ */
+struct tcp_connect_wait {
+	struct k_sem sem;
+	int result;
+};
+
 struct tcp { /* TCP connection */
 	sys_snode_t next;
+	sys_snode_t hash_next; /* in the connection hash table */
 	struct net_context *context;
 	struct k_mutex lock;
 	void *recv_user_data;
@@ -199,12 +222,32 @@ struct tcp { /* TCP connection */
 	enum tcp_data_mode data_mode;
 	bool in_retransmission;
 	size_t send_retries;
+	struct tcp_rtt rtt;
+#if defined(CONFIG_NET_TCP_CONGESTION_CONTROL)
+	struct tcp_cc cc;
+#endif
 	struct k_delayed_work timewait_timer;
 	struct net_if *iface;
 	net_tcp_accept_cb_t accept_cb;
+	struct tcp_connect_wait *connect_wait;
 	atomic_t ref_count;
 };
 
+/* Half-open connection, a SYN has been received and SYN-ACK sent but
+ * the final ACK of the handshake is still missing. Only this much
+ * state is kept until the connection is established.
+ */
+struct tcp_backlog_entry {
+	struct tcp *listener; /* NULL if the entry is free */
+	struct net_if *iface;
+	union tcp_endpoint src;
+	union tcp_endpoint dst;
+	struct tcp_options recv_options;
+	uint32_t seq; /* our initial sequence number */
+	uint32_t ack; /* peer initial sequence number + 1 */
+	uint32_t timestamp;
+};
+
 #define _flags(_fl, _op, _mask, _cond)					\
 ({									\
 	bool result = false;						\
@@ -148,6 +148,8 @@ struct net_udp_hdr *net_udp_input(struct net_pkt *pkt,
 {
 	struct net_udp_hdr *udp_hdr;
 
+	net_pkt_set_rx_stats_tick(pkt, NET_STATS_RX_DETAIL_L4);
+
 	udp_hdr = (struct net_udp_hdr *)net_pkt_get_data(pkt, udp_access);
 	if (!udp_hdr || net_pkt_set_data(pkt, udp_access)) {
 		NET_DBG("DROP: corrupted header");
@@ -19,6 +19,8 @@ LOG_MODULE_REGISTER(net_arp, CONFIG_NET_ARP_LOG_LEVEL);
 
 #include "arp.h"
 #include "net_private.h"
+#include "route.h"
+#include "nbr_cache.h"
 
 #define NET_BUF_TIMEOUT K_MSEC(100)
 #define ARP_REQUEST_TIMEOUT (2 * MSEC_PER_SEC)
@@ -26,38 +28,53 @@ LOG_MODULE_REGISTER(net_arp, CONFIG_NET_ARP_LOG_LEVEL);
 static bool arp_cache_initialized;
 static struct arp_entry arp_entries[CONFIG_NET_ARP_TABLE_SIZE];
 
-static sys_slist_t arp_free_entries;
-static sys_slist_t arp_pending_entries;
-static sys_slist_t arp_table;
+static sys_dlist_t arp_free_entries;
+static sys_dlist_t arp_pending_entries;
+/* Most recently used entry first */
+static sys_dlist_t arp_table;
+/* Table and pending entries by IP address */
+static struct net_nbr_hash arp_hash;
 
 struct k_delayed_work arp_request_timer;
 
+static inline bool arp_entry_is_pending(struct arp_entry *entry)
+{
+	return entry->pending.count > 0;
+}
+
 static void arp_entry_cleanup(struct arp_entry *entry, bool pending)
 {
 	NET_DBG("%p", entry);
 
 	if (pending) {
-		NET_DBG("Releasing pending pkt %p (ref %d)",
-			entry->pending,
-			atomic_get(&entry->pending->atomic_ref) - 1);
-		net_pkt_unref(entry->pending);
-		entry->pending = NULL;
+		NET_DBG("Releasing %d pending pkts", entry->pending.count);
+
+		net_nbr_pending_clear(&entry->pending);
 	}
 
+	net_nbr_hash_del(&arp_hash, &entry->hash_node, &entry->ip,
+			 sizeof(struct in_addr));
+
 	entry->iface = NULL;
 
 	(void)memset(&entry->ip, 0, sizeof(struct in_addr));
 	(void)memset(&entry->eth, 0, sizeof(struct net_eth_addr));
 }
 
-static struct arp_entry *arp_entry_find(sys_slist_t *list,
-					struct net_if *iface,
-					struct in_addr *dst,
-					sys_snode_t **previous)
+static void arp_entry_add_hash(struct arp_entry *entry)
+{
+	net_nbr_hash_add(&arp_hash, &entry->hash_node, &entry->ip,
+			 sizeof(struct in_addr));
+}
+
+/* Find a table or a pending entry */
+static struct arp_entry *arp_entry_find(struct net_if *iface,
+					struct in_addr *dst)
 {
 	struct arp_entry *entry;
 
-	SYS_SLIST_FOR_EACH_CONTAINER(list, entry, node) {
+	NET_NBR_HASH_FOR_EACH(&arp_hash, dst, sizeof(struct in_addr),
+			      entry, hash_node) {
 		NET_DBG("iface %p dst %s",
 			iface, log_strdup(net_sprint_ipv4_addr(&entry->ip)));
 
@@ -65,63 +82,51 @@ static struct arp_entry *arp_entry_find(sys_slist_t *list,
 		    net_ipv4_addr_cmp(&entry->ip, dst)) {
 			return entry;
 		}
-
-		if (previous) {
-			*previous = &entry->node;
-		}
 	}
 
 	return NULL;
 }
 
-static inline struct arp_entry *arp_entry_find_move_first(struct net_if *iface,
-							  struct in_addr *dst)
+static inline struct arp_entry *arp_entry_find_table(struct net_if *iface,
+						     struct in_addr *dst)
 {
-	sys_snode_t *prev = NULL;
 	struct arp_entry *entry;
 
-	NET_DBG("dst %s", log_strdup(net_sprint_ipv4_addr(dst)));
-
-	entry = arp_entry_find(&arp_table, iface, dst, &prev);
-	if (entry) {
-		/* Let's assume the target is going to be accessed
-		 * more than once here in a short time frame. So we
-		 * place the entry first in position into the table
-		 * in order to reduce subsequent find.
-		 */
-		if (&entry->node != sys_slist_peek_head(&arp_table)) {
-			sys_slist_remove(&arp_table, prev, &entry->node);
-			sys_slist_prepend(&arp_table, &entry->node);
-		}
+	entry = arp_entry_find(iface, dst);
+	if (entry && arp_entry_is_pending(entry)) {
+		return NULL;
 	}
 
 	return entry;
 }
 
-static inline
-struct arp_entry *arp_entry_find_pending(struct net_if *iface,
-					 struct in_addr *dst)
+static inline void arp_entry_move_first(struct arp_entry *entry)
 {
-	NET_DBG("dst %s", log_strdup(net_sprint_ipv4_addr(dst)));
-
-	return arp_entry_find(&arp_pending_entries, iface, dst, NULL);
+	/* Let's assume the target is going to be accessed
+	 * more than once here in a short time frame. So we
+	 * place the entry first in position into the table
+	 * so that the least recently used entry is evicted
+	 * when the table is full.
+	 */
+	net_nbr_lru_touch(&arp_table, &entry->node);
 }
 
 static struct arp_entry *arp_entry_get_pending(struct net_if *iface,
 					       struct in_addr *dst)
 {
-	sys_snode_t *prev = NULL;
 	struct arp_entry *entry;
 
 	NET_DBG("dst %s", log_strdup(net_sprint_ipv4_addr(dst)));
 
-	entry = arp_entry_find(&arp_pending_entries, iface, dst, &prev);
-	if (entry) {
+	entry = arp_entry_find(iface, dst);
+	if (entry && arp_entry_is_pending(entry)) {
 		/* We remove the entry from the pending list */
-		sys_slist_remove(&arp_pending_entries, prev, &entry->node);
+		sys_dlist_remove(&entry->node);
+	} else {
+		entry = NULL;
 	}
 
-	if (sys_slist_is_empty(&arp_pending_entries)) {
+	if (sys_dlist_is_empty(&arp_pending_entries)) {
 		k_delayed_work_cancel(&arp_request_timer);
 	}
 
@@ -130,43 +135,55 @@ static struct arp_entry *arp_entry_get_pending(struct net_if *iface,
 
 static struct arp_entry *arp_entry_get_free(void)
 {
-	sys_snode_t *node;
+	sys_dnode_t *node;
 
-	node = sys_slist_peek_head(&arp_free_entries);
+	/* We remove the node from the free list */
+	node = sys_dlist_get(&arp_free_entries);
 	if (!node) {
 		return NULL;
 	}
 
-	/* We remove the node from the free list */
-	sys_slist_remove(&arp_free_entries, NULL, node);
-
 	return CONTAINER_OF(node, struct arp_entry, node);
 }
 
 static struct arp_entry *arp_entry_get_last_from_table(void)
 {
-	sys_snode_t *node;
+	struct arp_entry *entry;
+	sys_dnode_t *node;
 
 	/* We assume last entry is the oldest one,
 	 * so is the preferred one to be taken out.
 	 */
 
-	node = sys_slist_peek_tail(&arp_table);
+	node = sys_dlist_peek_tail(&arp_table);
 	if (!node) {
 		return NULL;
 	}
 
-	sys_slist_find_and_remove(&arp_table, node);
+	entry = CONTAINER_OF(node, struct arp_entry, node);
 
-	return CONTAINER_OF(node, struct arp_entry, node);
+	sys_dlist_remove(&entry->node);
+	net_nbr_hash_del(&arp_hash, &entry->hash_node, &entry->ip,
+			 sizeof(struct in_addr));
+
+	return entry;
 }
 
+static void arp_entry_queue_pending(struct arp_entry *entry,
+				    struct net_pkt *pkt)
+{
+	if (!net_nbr_pending_add(&entry->pending, pkt)) {
+		NET_DBG("Pending queue for %s full, discarding %p",
+			log_strdup(net_sprint_ipv4_addr(&entry->ip)), pkt);
+	}
+}
 
 static void arp_entry_register_pending(struct arp_entry *entry)
 {
 	NET_DBG("dst %s", log_strdup(net_sprint_ipv4_addr(&entry->ip)));
 
-	sys_slist_append(&arp_pending_entries, &entry->node);
+	sys_dlist_append(&arp_pending_entries, &entry->node);
+	arp_entry_add_hash(entry);
 
 	entry->req_start = k_uptime_get_32();
 
@@ -184,7 +201,7 @@ static void arp_request_timeout(struct k_work *work)
 
 	ARG_UNUSED(work);
 
-	SYS_SLIST_FOR_EACH_CONTAINER_SAFE(&arp_pending_entries,
+	SYS_DLIST_FOR_EACH_CONTAINER_SAFE(&arp_pending_entries,
 					  entry, next, node) {
 		if ((int32_t)(entry->req_start +
 			    ARP_REQUEST_TIMEOUT - current) > 0) {
@@ -193,8 +210,8 @@ static void arp_request_timeout(struct k_work *work)
 
 		arp_entry_cleanup(entry, true);
 
-		sys_slist_remove(&arp_pending_entries, NULL, &entry->node);
-		sys_slist_append(&arp_free_entries, &entry->node);
+		sys_dlist_remove(&entry->node);
+		sys_dlist_append(&arp_free_entries, &entry->node);
 
 		entry = NULL;
 	}
@@ -266,7 +283,8 @@ static inline struct net_pkt *arp_prepare(struct net_if *iface,
 	 * request and we want to send it again.
 	 */
 	if (entry) {
-		entry->pending = net_pkt_ref(pending);
+		entry->pending.count = 0U;
+		net_nbr_pending_add(&entry->pending, pending);
 		entry->iface = net_pkt_iface(pkt);
 
 		net_ipaddr_copy(&entry->ip, next_addr);
@@ -325,13 +343,21 @@ struct net_pkt *net_arp_prepare(struct net_pkt *pkt,
 	}
 
 	/* Is the destination in the local network, if not route via
-	 * the gateway address.
+	 * the gateway of the matching route or the default gateway.
 	 */
 	if (!current_ip &&
 	    !net_if_ipv4_addr_mask_cmp(net_pkt_iface(pkt), request_ip)) {
 		struct net_if_ipv4 *ipv4 = net_pkt_iface(pkt)->config.ip.ipv4;
+		struct net_route_entry_ipv4 *route;
 
-		if (ipv4) {
+		route = net_route_ipv4_lookup(net_pkt_iface(pkt), request_ip);
+		if (route) {
+			if (net_ipv4_is_addr_unspecified(&route->gw)) {
+				addr = request_ip;
+			} else {
+				addr = &route->gw;
+			}
+		} else if (ipv4) {
 			addr = &ipv4->gw;
 			if (net_ipv4_is_addr_unspecified(addr)) {
 				NET_ERR("Gateway not set for iface %p",
@@ -349,11 +375,10 @@ struct net_pkt *net_arp_prepare(struct net_pkt *pkt,
 	/* If the destination address is already known, we do not need
 	 * to send any ARP packet.
 	 */
-	entry = arp_entry_find_move_first(net_pkt_iface(pkt), addr);
-	if (!entry) {
+	entry = arp_entry_find(net_pkt_iface(pkt), addr);
+	if (!entry || arp_entry_is_pending(entry)) {
 		struct net_pkt *req;
 
-		entry = arp_entry_find_pending(net_pkt_iface(pkt), addr);
 		if (!entry) {
 			/* No pending, let's try to get a new entry */
 			entry = arp_entry_get_free();
@@ -362,7 +387,13 @@ struct net_pkt *net_arp_prepare(struct net_pkt *pkt,
 				entry = arp_entry_get_last_from_table();
 			}
 		} else {
-			/* There is a pending already */
+			/* There is a pending already, the packet is sent
+			 * with the others once the reply is received.
+			 */
+			if (!current_ip) {
+				arp_entry_queue_pending(entry, pkt);
+			}
+
 			entry = NULL;
 		}
 
@@ -370,9 +401,10 @@ struct net_pkt *net_arp_prepare(struct net_pkt *pkt,
 				  current_ip);
 
 		if (!entry) {
-			/* We cannot send the packet, the ARP cache is full
-			 * or there is already a pending query to this IP
-			 * address, so this packet must be discarded.
+			/* The ARP cache is full or there is already a
+			 * pending query to this IP address, so this packet
+			 * is either discarded or queued in the pending
+			 * entry.
 			 */
 			NET_DBG("Resending ARP %p", req);
 		}
@@ -380,6 +412,8 @@ struct net_pkt *net_arp_prepare(struct net_pkt *pkt,
 		return req;
 	}
 
+	arp_entry_move_first(entry);
+
 	net_pkt_lladdr_src(pkt)->addr =
 		(uint8_t *)net_if_get_link_addr(entry->iface)->addr;
 	net_pkt_lladdr_src(pkt)->len = sizeof(struct net_eth_addr);
@@ -399,10 +433,9 @@ static void arp_gratuitous(struct net_if *iface,
 			   struct in_addr *src,
 			   struct net_eth_addr *hwaddr)
 {
-	sys_snode_t *prev = NULL;
 	struct arp_entry *entry;
 
-	entry = arp_entry_find(&arp_table, iface, src, &prev);
+	entry = arp_entry_find_table(iface, src);
 	if (entry) {
 		NET_DBG("Gratuitous ARP hwaddr %s -> %s",
 			log_strdup(net_sprint_ll_addr(
@@ -422,8 +455,10 @@ static void arp_update(struct net_if *iface,
 		       bool gratuitous,
 		       bool force)
 {
+	struct net_pkt *pkts[NET_NBR_PENDING_QUEUE_SIZE];
 	struct arp_entry *entry;
-	struct net_pkt *pkt;
+	int count;
+	int i;
 
 	NET_DBG("src %s", log_strdup(net_sprint_ipv4_addr(src)));
 
@@ -434,10 +469,9 @@ static void arp_update(struct net_if *iface,
 		}
 
 		if (force) {
-			sys_snode_t *prev = NULL;
 			struct arp_entry *entry;
 
-			entry = arp_entry_find(&arp_table, iface, src, &prev);
+			entry = arp_entry_find_table(iface, src);
 			if (entry) {
 				memcpy(&entry->eth, hwaddr,
 				       sizeof(struct net_eth_addr));
@@ -456,7 +490,10 @@ static void arp_update(struct net_if *iface,
 					entry->iface = iface;
 					net_ipaddr_copy(&entry->ip, src);
 					memcpy(&entry->eth, hwaddr, sizeof(entry->eth));
-					sys_slist_prepend(&arp_table, &entry->node);
+					entry->pending.count = 0U;
+					arp_entry_add_hash(entry);
+					net_nbr_lru_touch(&arp_table,
+							  &entry->node);
 				}
 			}
 		}
@@ -464,24 +501,25 @@ static void arp_update(struct net_if *iface,
 		return;
 	}
 
-	/* Set the dst in the pending packet */
-	net_pkt_lladdr_dst(entry->pending)->len = sizeof(struct net_eth_addr);
-	net_pkt_lladdr_dst(entry->pending)->addr =
-		(uint8_t *) &NET_ETH_HDR(entry->pending)->dst.addr;
-
-	NET_DBG("dst %s pending %p frag %p",
-		log_strdup(net_sprint_ipv4_addr(&entry->ip)),
-		entry->pending, entry->pending->frags);
-
-	pkt = entry->pending;
-	entry->pending = NULL;
+	count = net_nbr_pending_take(&entry->pending, pkts);
 
 	memcpy(&entry->eth, hwaddr, sizeof(struct net_eth_addr));
 
 	/* Inserting entry into the table */
-	sys_slist_prepend(&arp_table, &entry->node);
+	net_nbr_lru_touch(&arp_table, &entry->node);
+
+	for (i = 0; i < count; i++) {
+		/* Set the dst in the pending packet */
+		net_pkt_lladdr_dst(pkts[i])->len = sizeof(struct net_eth_addr);
+		net_pkt_lladdr_dst(pkts[i])->addr =
+			(uint8_t *) &NET_ETH_HDR(pkts[i])->dst.addr;
+
+		NET_DBG("dst %s pending %p frag %p",
+			log_strdup(net_sprint_ipv4_addr(&entry->ip)),
+			pkts[i], pkts[i]->frags);
 
-	net_if_queue_tx(iface, pkt);
+		net_if_queue_tx(iface, pkts[i]);
+	}
 }
 
 static inline struct net_pkt *arp_prepare_reply(struct net_if *iface,
@@ -669,41 +707,36 @@ enum net_verdict net_arp_input(struct net_pkt *pkt,
 
 void net_arp_clear_cache(struct net_if *iface)
 {
-	sys_snode_t *prev = NULL;
 	struct arp_entry *entry, *next;
 
 	NET_DBG("Flushing ARP table");
 
-	SYS_SLIST_FOR_EACH_CONTAINER_SAFE(&arp_table, entry, next, node) {
+	SYS_DLIST_FOR_EACH_CONTAINER_SAFE(&arp_table, entry, next, node) {
 		if (iface && iface != entry->iface) {
-			prev = &entry->node;
 			continue;
 		}
 
 		arp_entry_cleanup(entry, false);
 
-		sys_slist_remove(&arp_table, prev, &entry->node);
-		sys_slist_prepend(&arp_free_entries, &entry->node);
+		sys_dlist_remove(&entry->node);
+		sys_dlist_prepend(&arp_free_entries, &entry->node);
 	}
 
-	prev = NULL;
-
 	NET_DBG("Flushing ARP pending requests");
 
-	SYS_SLIST_FOR_EACH_CONTAINER_SAFE(&arp_pending_entries,
+	SYS_DLIST_FOR_EACH_CONTAINER_SAFE(&arp_pending_entries,
 					  entry, next, node) {
 		if (iface && iface != entry->iface) {
-			prev = &entry->node;
 			continue;
 		}
 
 		arp_entry_cleanup(entry, true);
 
-		sys_slist_remove(&arp_pending_entries, prev, &entry->node);
-		sys_slist_prepend(&arp_free_entries, &entry->node);
+		sys_dlist_remove(&entry->node);
+		sys_dlist_prepend(&arp_free_entries, &entry->node);
 	}
 
-	if (sys_slist_is_empty(&arp_pending_entries)) {
+	if (sys_dlist_is_empty(&arp_pending_entries)) {
 		k_delayed_work_cancel(&arp_request_timer);
 	}
 }
@@ -713,7 +746,7 @@ int net_arp_foreach(net_arp_cb_t cb, void *user_data)
 	int ret = 0;
 	struct arp_entry *entry;
 
-	SYS_SLIST_FOR_EACH_CONTAINER(&arp_table, entry, node) {
+	SYS_DLIST_FOR_EACH_CONTAINER(&arp_table, entry, node) {
 		ret++;
 		cb(entry, user_data);
 	}
@@ -729,13 +762,14 @@ void net_arp_init(void)
 		return;
 	}
 
-	sys_slist_init(&arp_free_entries);
-	sys_slist_init(&arp_pending_entries);
-	sys_slist_init(&arp_table);
+	sys_dlist_init(&arp_free_entries);
+	sys_dlist_init(&arp_pending_entries);
+	sys_dlist_init(&arp_table);
+	net_nbr_hash_init(&arp_hash);
 
 	for (i = 0; i < CONFIG_NET_ARP_TABLE_SIZE; i++) {
 		/* Inserting entry as free */
-		sys_slist_prepend(&arp_free_entries, &arp_entries[i].node);
+		sys_dlist_prepend(&arp_free_entries, &arp_entries[i].node);
 	}
 
 	k_delayed_work_init(&arp_request_timer, arp_request_timeout);
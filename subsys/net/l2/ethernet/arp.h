@@ -10,8 +10,11 @@
 #if defined(CONFIG_NET_ARP) && defined(CONFIG_NET_NATIVE)
 
 #include <sys/slist.h>
+#include <sys/dlist.h>
 #include <net/ethernet.h>
 
+#include "nbr_cache.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -50,14 +53,16 @@ enum net_verdict net_arp_input(struct net_pkt *pkt,
 			       struct net_eth_hdr *eth_hdr);
 
 struct arp_entry {
-	sys_snode_t node;
+	sys_dnode_t node;
+	sys_snode_t hash_node;
 	uint32_t req_start;
 	struct net_if *iface;
 	struct in_addr ip;
-	union {
-		struct net_pkt *pending;
-		struct net_eth_addr eth;
-	};
+	struct net_eth_addr eth;
+	/* Packets waiting for the reply, empty once the address is
+	 * resolved
+	 */
+	struct net_nbr_pending pending;
 };
 
 typedef void (*net_arp_cb_t)(struct arp_entry *entry,
@@ -554,6 +554,23 @@ static void ethernet_remove_l2_header(struct net_pkt *pkt)
 	net_pkt_frag_unref(buf);
 }
 
+/* Select the TX queue by the flow of the packet, i.e. its hash if known,
+ * otherwise its net_context. Packets without either use the first queue.
+ */
+static uint8_t ethernet_tx_queue(struct ethernet_context *ctx,
+				 struct net_pkt *pkt)
+{
+	uint32_t hash = net_pkt_flow_hash(pkt);
+
+	if (!hash) {
+		/* Knuth's multiplicative hash */
+		hash = POINTER_TO_UINT(net_pkt_context(pkt)) * 2654435761U;
+		hash >>= 16;
+	}
+
+	return hash % ctx->tx_queues;
+}
+
 static int ethernet_send(struct net_if *iface, struct net_pkt *pkt)
 {
 	const struct ethernet_api *api = net_if_get_device(iface)->driver_api;
@@ -637,7 +654,13 @@ static int ethernet_send(struct net_if *iface, struct net_pkt *pkt)
 	net_pkt_cursor_init(pkt);
 
 send:
-	ret = api->send(net_if_get_device(iface), pkt);
+	if (ctx->tx_queues > 1) {
+		ret = api->send_queue(net_if_get_device(iface),
+				      ethernet_tx_queue(ctx, pkt), pkt);
+	} else {
+		ret = api->send(net_if_get_device(iface), pkt);
+	}
+
 	if (ret != 0) {
 		eth_stats_update_errors_tx(iface);
 		ethernet_remove_l2_header(pkt);
@@ -1105,6 +1128,28 @@ int net_eth_promisc_mode(struct net_if *iface, bool enable)
 			&params, sizeof(struct ethernet_req_params));
 }
 
+static void ethernet_tx_queues_init(struct ethernet_context *ctx,
+				    struct net_if *iface)
+{
+	const struct ethernet_api *api = net_if_get_device(iface)->driver_api;
+	struct ethernet_config config;
+
+	ctx->tx_queues = 1U;
+
+	if (!api->send_queue || !api->get_config) {
+		return;
+	}
+
+	if (api->get_config(net_if_get_device(iface),
+			    ETHERNET_CONFIG_TYPE_TX_QUEUES_NUM, &config)) {
+		return;
+	}
+
+	ctx->tx_queues = MIN(MAX(config.tx_queues_num, 1), UINT8_MAX);
+
+	NET_DBG("iface %p uses %d TX queues", iface, ctx->tx_queues);
+}
+
 void ethernet_init(struct net_if *iface)
 {
 	struct ethernet_context *ctx = net_if_l2_data(iface);
@@ -1121,6 +1166,8 @@ void ethernet_init(struct net_if *iface)
 		ctx->ethernet_l2_flags |= NET_L2_PROMISC_MODE;
 	}
 
+	ethernet_tx_queues_init(ctx, iface);
+
 #if defined(CONFIG_NET_VLAN)
 	if (!(net_eth_get_hw_capabilities(iface) & ETHERNET_HW_VLAN)) {
 		return;
@@ -28,6 +28,7 @@ LOG_MODULE_REGISTER(net_ieee802154, CONFIG_NET_L2_IEEE802154_LOG_LEVEL);
 
 #define BUF_TIMEOUT K_MSEC(50)
 
+#ifndef CONFIG_NET_L2_IEEE802154_TX_PIPELINE
 /* No need to hold space for the FCS */
 static uint8_t frame_buffer_data[IEEE802154_MTU - 2];
 
@@ -37,6 +38,7 @@ static struct net_buf frame_buf = {
 	.frags = NULL,
 	.__buf = frame_buffer_data,
 };
+#endif
 
 #define PKT_TITLE      "IEEE 802.15.4 packet content:"
 #define TX_PKT_TITLE   "> " PKT_TITLE
@@ -70,7 +72,8 @@ static inline void ieee802154_acknowledge(struct net_if *iface,
 {
 	struct net_pkt *pkt;
 
-	if (!mpdu->mhr.fs->fc.ar) {
+	if (!mpdu->mhr.fs->fc.ar ||
+	    ieee802154_get_hw_capabilities(iface) & IEEE802154_HW_RX_TX_ACK) {
 		return;
 	}
 
@@ -119,6 +122,21 @@ static inline void set_pkt_ll_addr(struct net_linkaddr *addr, bool comp,
 }
 
 #ifdef CONFIG_NET_6LO
+/* Start of the buffer holding the received frame. The uncompressed IPv6
+ * header is put in a buffer of its own in front of it, so look for the
+ * first buffer having the link layer header in its headroom.
+ */
+static inline uint8_t *frame_start(struct net_pkt *pkt, size_t hdr_len)
+{
+	struct net_buf *buf = pkt->buffer;
+
+	while (buf->frags && net_buf_headroom(buf) < hdr_len) {
+		buf = buf->frags;
+	}
+
+	return buf->data - net_buf_headroom(buf);
+}
+
 static inline
 enum net_verdict ieee802154_manage_recv_packet(struct net_if *iface,
 					       struct net_pkt *pkt,
@@ -143,15 +161,15 @@ enum net_verdict ieee802154_manage_recv_packet(struct net_if *iface,
 			     net_pkt_lladdr_dst(pkt)->len);
 	}
 
-	/** Uncompress will drop the current fragment. Pkt ll src/dst address
+	/** Reassembly will drop the current fragment. Pkt ll src/dst address
 	 * will then be wrong and must be updated according to the new fragment.
 	 */
 	src = net_pkt_lladdr_src(pkt)->addr ?
 		net_pkt_lladdr_src(pkt)->addr -
-		(net_pkt_data(pkt) - hdr_len) : 0;
+		frame_start(pkt, hdr_len) : 0;
 	dst = net_pkt_lladdr_dst(pkt)->addr ?
 		net_pkt_lladdr_dst(pkt)->addr -
-		(net_pkt_data(pkt) - hdr_len) : 0;
+		frame_start(pkt, hdr_len) : 0;
 
 #ifdef CONFIG_NET_L2_IEEE802154_FRAGMENT
 	verdict = ieee802154_reassemble(pkt);
@@ -166,9 +184,9 @@ enum net_verdict ieee802154_manage_recv_packet(struct net_if *iface,
 	}
 #endif
 	net_pkt_lladdr_src(pkt)->addr = src ?
-		(net_pkt_data(pkt) - hdr_len) + src : NULL;
+		frame_start(pkt, hdr_len) + src : NULL;
 	net_pkt_lladdr_dst(pkt)->addr = dst ?
-		(net_pkt_data(pkt) - hdr_len) + dst : NULL;
+		frame_start(pkt, hdr_len) + dst : NULL;
 
 	pkt_hexdump(RX_PKT_TITLE, pkt, true);
 out:
@@ -225,13 +243,147 @@ static enum net_verdict ieee802154_recv(struct net_if *iface,
 
 }
 
+static int ieee802154_send_frame(struct net_if *iface, struct net_pkt *pkt,
+				 struct net_buf *frame)
+{
+	if (IS_ENABLED(CONFIG_NET_L2_IEEE802154_RADIO_CSMA_CA) &&
+	    ieee802154_get_hw_capabilities(iface) & IEEE802154_HW_CSMA) {
+		return ieee802154_tx(iface, IEEE802154_TX_MODE_CSMA_CA,
+				     pkt, frame);
+	}
+
+	return ieee802154_radio_send(iface, pkt, frame);
+}
+
+#ifdef CONFIG_NET_L2_IEEE802154_TX_PIPELINE
+/* A frame built ahead, waiting for the radio */
+struct tx_frame {
+	void *fifo_reserved;
+	struct net_pkt *pkt;
+	bool first;
+	struct net_buf buf;
+	/* No need to hold space for the FCS */
+	uint8_t data[IEEE802154_MTU - 2];
+};
+
+static K_MEM_SLAB_DEFINE(tx_frames, sizeof(struct tx_frame),
+			 CONFIG_NET_L2_IEEE802154_TX_QUEUE_DEPTH,
+			 __alignof__(struct tx_frame));
+
+static K_FIFO_DEFINE(tx_queue);
+
+static struct net_buf *tx_frame_alloc(void)
+{
+	struct tx_frame *frame;
+
+	/* Waits for the radio when the queue is full */
+	(void)k_mem_slab_alloc(&tx_frames, (void **)&frame, K_FOREVER);
+
+	frame->buf = (struct net_buf) {
+		.data = frame->data,
+		.size = sizeof(frame->data),
+		.__buf = frame->data,
+	};
+
+	return &frame->buf;
+}
+
+static void tx_frame_free(struct net_buf *buf)
+{
+	struct tx_frame *frame = CONTAINER_OF(buf, struct tx_frame, buf);
+
+	k_mem_slab_free(&tx_frames, (void **)&frame);
+}
+
+static int tx_frame_send(struct net_if *iface, struct net_pkt *pkt,
+			 struct net_buf *buf, bool first)
+{
+	struct tx_frame *frame = CONTAINER_OF(buf, struct tx_frame, buf);
+
+	ARG_UNUSED(iface);
+
+	frame->pkt = net_pkt_ref(pkt);
+	frame->first = first;
+	k_fifo_put(&tx_queue, frame);
+
+	return 0;
+}
+
+static void tx_thread(void *p1, void *p2, void *p3)
+{
+	/* Packet which had a frame not sent, until the next one starts */
+	struct net_pkt *failed = NULL;
+	struct tx_frame *frame;
+	int ret;
+
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	while (true) {
+		frame = k_fifo_get(&tx_queue, K_FOREVER);
+
+		if (frame->first) {
+			failed = NULL;
+		}
+
+		/* Like without the queue, a packet is not sent any further
+		 * once one of its frames failed.
+		 */
+		if (frame->pkt == failed) {
+			ret = -ECANCELED;
+		} else {
+			ret = ieee802154_send_frame(net_pkt_iface(frame->pkt),
+						    frame->pkt, &frame->buf);
+		}
+
+		if (ret) {
+			NET_DBG("Frame of pkt %p not sent (%d)", frame->pkt,
+				ret);
+			failed = frame->pkt;
+		}
+
+		net_pkt_unref(frame->pkt);
+		k_mem_slab_free(&tx_frames, (void **)&frame);
+	}
+}
+
+/* Above the TX threads of the stack, so that the radio gets the next
+ * frame as soon as it is done with the current one.
+ */
+K_THREAD_DEFINE(ieee802154_tx_thread, CONFIG_NET_L2_IEEE802154_TX_STACK_SIZE,
+		tx_thread, NULL, NULL, NULL, K_PRIO_COOP(6), 0, 0);
+#else
+static struct net_buf *tx_frame_alloc(void)
+{
+	frame_buf.len = 0U;
+
+	return &frame_buf;
+}
+
+static void tx_frame_free(struct net_buf *buf)
+{
+	ARG_UNUSED(buf);
+}
+
+static int tx_frame_send(struct net_if *iface, struct net_pkt *pkt,
+			 struct net_buf *buf, bool first)
+{
+	ARG_UNUSED(first);
+
+	return ieee802154_send_frame(iface, pkt, buf);
+}
+#endif /* CONFIG_NET_L2_IEEE802154_TX_PIPELINE */
+
 static int ieee802154_send(struct net_if *iface, struct net_pkt *pkt)
 {
 	struct ieee802154_context *ctx = net_if_l2_data(iface);
 	struct ieee802154_fragment_ctx f_ctx;
+	struct net_buf *frame;
 	struct net_buf *buf;
 	uint8_t ll_hdr_size;
 	bool fragment;
+	bool first;
 	int len;
 
 	if (net_pkt_family(pkt) != AF_INET6) {
@@ -251,46 +403,39 @@ static int ieee802154_send(struct net_if *iface, struct net_pkt *pkt)
 	ieee802154_fragment_ctx_init(&f_ctx, pkt, len, true);
 
 	len = 0;
-	frame_buf.len = 0U;
 	buf = pkt->buffer;
+	first = true;
 
 	while (buf) {
 		int ret;
 
-		net_buf_add(&frame_buf, ll_hdr_size);
+		frame = tx_frame_alloc();
+		net_buf_add(frame, ll_hdr_size);
 
 		if (fragment) {
-			ieee802154_fragment(&f_ctx, &frame_buf, true);
+			ieee802154_fragment(&f_ctx, frame, true);
 			buf = f_ctx.buf;
 		} else {
-			memcpy(frame_buf.data + frame_buf.len,
-			       buf->data, buf->len);
-			net_buf_add(&frame_buf, buf->len);
+			memcpy(frame->data + frame->len, buf->data, buf->len);
+			net_buf_add(frame, buf->len);
 			buf = buf->frags;
 		}
 
 		if (!ieee802154_create_data_frame(ctx, net_pkt_lladdr_dst(pkt),
-						  &frame_buf, ll_hdr_size)) {
+						  frame, ll_hdr_size)) {
+			tx_frame_free(frame);
 			return -EINVAL;
 		}
 
-		if (IS_ENABLED(CONFIG_NET_L2_IEEE802154_RADIO_CSMA_CA) &&
-		    ieee802154_get_hw_capabilities(iface) &
-		    IEEE802154_HW_CSMA) {
-			ret = ieee802154_tx(iface, IEEE802154_TX_MODE_CSMA_CA,
-					    pkt, &frame_buf);
-		} else {
-			ret = ieee802154_radio_send(iface, pkt, &frame_buf);
-		}
+		/* A queued frame belongs to the TX thread */
+		len += frame->len;
 
+		ret = tx_frame_send(iface, pkt, frame, first);
 		if (ret) {
 			return ret;
 		}
 
-		len += frame_buf.len;
-
-		/* Reinitializing frame_buf */
-		frame_buf.len = 0U;
+		first = false;
 	}
 
 	net_pkt_unref(pkt);
@@ -20,7 +20,7 @@ static inline int aloha_radio_send(struct net_if *iface,
 				   struct net_pkt *pkt,
 				   struct net_buf *frag)
 {
-	uint8_t retries = CONFIG_NET_L2_IEEE802154_RADIO_TX_RETRIES;
+	uint8_t retries = tx_attempts(iface);
 	struct ieee802154_context *ctx = net_if_l2_data(iface);
 	bool ack_required = prepare_for_ack(ctx, pkt, frag);
 	int ret = -EIO;
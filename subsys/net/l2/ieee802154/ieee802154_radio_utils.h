@@ -21,6 +21,19 @@ extern int ieee802154_radio_send(struct net_if *iface,
 				 struct net_pkt *pkt,
 				 struct net_buf *frag);
 
+/* Radios which retransmit until the frame is acknowledged are given
+ * each frame once.
+ */
+static inline uint8_t tx_attempts(struct net_if *iface)
+{
+	if (ieee802154_get_hw_capabilities(iface) &
+	    IEEE802154_HW_RETRANSMISSION) {
+		return 1;
+	}
+
+	return CONFIG_NET_L2_IEEE802154_RADIO_TX_RETRIES;
+}
+
 static inline bool prepare_for_ack(struct ieee802154_context *ctx,
 				   struct net_pkt *pkt,
 				   struct net_buf *frag)
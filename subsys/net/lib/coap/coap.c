@@ -811,6 +811,20 @@ static bool is_request(const struct coap_packet *cpkt)
 	return !(code & ~COAP_REQUEST_MASK);
 }
 
+static int call_method(struct coap_resource *resource,
+		       struct coap_packet *cpkt,
+		       struct sockaddr *addr, socklen_t addr_len)
+{
+	coap_method_t method;
+
+	method = method_from_code(resource, coap_header_get_code(cpkt));
+	if (!method) {
+		return -EPERM;
+	}
+
+	return method(resource, cpkt, addr, addr_len);
+}
+
 int coap_handle_request(struct coap_packet *cpkt,
 			struct coap_resource *resources,
 			struct coap_option *options,
@@ -825,20 +839,149 @@ int coap_handle_request(struct coap_packet *cpkt,
 
 	/* FIXME: deal with hierarchical resources */
 	for (resource = resources; resource && resource->path; resource++) {
-		coap_method_t method;
-		uint8_t code;
-
 		if (!uri_path_eq(cpkt, resource->path, options, opt_num)) {
 			continue;
 		}
 
-		code = coap_header_get_code(cpkt);
-		method = method_from_code(resource, code);
-		if (!method) {
-			return -EPERM;
+		return call_method(resource, cpkt, addr, addr_len);
+	}
+
+	NET_DBG("%d", __LINE__);
+	return -ENOENT;
+}
+
+/* FNV-1a over the path segments, each one preceded by its length so that
+ * the paths "a/b" and "ab" hash differently.
+ */
+#define PATH_HASH_BASIS 2166136261U
+#define PATH_HASH_PRIME 16777619U
+
+static uint32_t path_hash_add(uint32_t hash, const uint8_t *segment,
+			      uint16_t len)
+{
+	uint16_t i;
+
+	hash = (hash ^ len) * PATH_HASH_PRIME;
+
+	for (i = 0U; i < len; i++) {
+		hash = (hash ^ segment[i]) * PATH_HASH_PRIME;
+	}
+
+	return hash;
+}
+
+static uint32_t resource_path_hash(const char * const *path)
+{
+	uint32_t hash = PATH_HASH_BASIS;
+
+	for (; *path; path++) {
+		hash = path_hash_add(hash, (const uint8_t *)*path,
+				     strlen(*path));
+	}
+
+	return hash;
+}
+
+static uint32_t request_path_hash(struct coap_option *options,
+				  uint8_t opt_num)
+{
+	uint32_t hash = PATH_HASH_BASIS;
+	uint8_t i;
+
+	for (i = 0U; i < opt_num; i++) {
+		if (options[i].delta == COAP_OPTION_URI_PATH) {
+			hash = path_hash_add(hash, options[i].value,
+					     options[i].len);
+		}
+	}
+
+	return hash;
+}
+
+static bool resource_path_eq(const char * const *a, const char * const *b)
+{
+	for (; *a && *b; a++, b++) {
+		if (strcmp(*a, *b)) {
+			return false;
+		}
+	}
+
+	return !*a && !*b;
+}
+
+int coap_resource_index_build(struct coap_resource_index *index)
+{
+	struct coap_resource *resource;
+	struct coap_resource_slot *slot;
+	uint16_t count = 0U;
+	uint16_t i;
+	uint32_t hash;
+
+	memset(index->slots, 0, index->num_slots * sizeof(*index->slots));
+
+	for (resource = index->resources; resource && resource->path;
+	     resource++) {
+		/* Keep a free slot to end the lookups */
+		if (++count >= index->num_slots) {
+			return -ENOMEM;
+		}
+
+		hash = resource_path_hash(resource->path);
+
+		for (i = hash % index->num_slots; ;
+		     i = (i + 1U) % index->num_slots) {
+			slot = &index->slots[i];
+
+			if (!slot->resource) {
+				slot->hash = hash;
+				slot->resource = count;
+				break;
+			}
+
+			if (slot->hash == hash &&
+			    resource_path_eq(index->resources[slot->resource -
+							      1U].path,
+					     resource->path)) {
+				break;
+			}
+		}
+	}
+
+	return 0;
+}
+
+int coap_handle_request_index(struct coap_packet *cpkt,
+			      struct coap_resource_index *index,
+			      struct coap_option *options,
+			      uint8_t opt_num,
+			      struct sockaddr *addr, socklen_t addr_len)
+{
+	struct coap_resource *resource;
+	struct coap_resource_slot *slot;
+	uint32_t hash;
+	uint16_t i;
+
+	if (!is_request(cpkt)) {
+		return 0;
+	}
+
+	if (!index->num_slots) {
+		return -ENOENT;
+	}
+
+	hash = request_path_hash(options, opt_num);
+
+	for (i = hash % index->num_slots; index->slots[i].resource;
+	     i = (i + 1U) % index->num_slots) {
+		slot = &index->slots[i];
+		if (slot->hash != hash) {
+			continue;
 		}
 
-		return method(resource, cpkt, addr, addr_len);
+		resource = &index->resources[slot->resource - 1U];
+		if (uri_path_eq(cpkt, resource->path, options, opt_num)) {
+			return call_method(resource, cpkt, addr, addr_len);
+		}
 	}
 
 	NET_DBG("%d", __LINE__);
@@ -0,0 +1,737 @@
+/** @file
+ * @brief CoAP client engine
+ *
+ * Runs the exchanges of the requests of a client: retransmission of
+ * confirmable messages (RFC 7252 section 4.2, or CoCoA), NSTART
+ * (RFC 7252 section 4.7) and block-wise transfers (RFC 7959).
+ */
+
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_DECLARE(net_coap, CONFIG_COAP_LOG_LEVEL);
+
+#include <string.h>
+#include <errno.h>
+#include <kernel.h>
+#include <random/rand32.h>
+#include <sys/util.h>
+
+#include <net/socket.h>
+#include <net/coap.h>
+#include <net/coap_client.h>
+
+#define ACK_TIMEOUT CONFIG_COAP_CLIENT_ACK_TIMEOUT_MS
+#define MAX_RETRANSMIT CONFIG_COAP_CLIENT_MAX_RETRANSMIT
+#define BLOCK_SIZE CONFIG_COAP_CLIENT_BLOCK_SIZE
+
+/* Upper bound of the retransmission timeout estimated by CoCoA */
+#define MAX_RTO 32000
+
+/* Block option value, see RFC 7959 section 2.2 */
+#define BLOCK_NUM(v) ((v) >> 4)
+#define BLOCK_MORE(v) (((v) & 0x08) != 0)
+#define BLOCK_SZX(v) ((v) & 0x07)
+#define BLOCK_VALUE(num, more, szx) (((num) << 4) | ((more) << 3) | (szx))
+#define BLOCK_BYTES(szx) (16U << (szx))
+
+BUILD_ASSERT((BLOCK_SIZE & (BLOCK_SIZE - 1)) == 0,
+	     "CONFIG_COAP_CLIENT_BLOCK_SIZE must be a power of two");
+BUILD_ASSERT(CONFIG_COAP_CLIENT_MESSAGE_SIZE > BLOCK_SIZE,
+	     "CONFIG_COAP_CLIENT_MESSAGE_SIZE must hold a block");
+
+static uint8_t block_szx(void)
+{
+	uint8_t szx = 0U;
+
+	while (BLOCK_BYTES(szx) < BLOCK_SIZE) {
+		szx++;
+	}
+
+	return szx;
+}
+
+static inline bool is_outstanding(struct coap_client_exchange *e)
+{
+	return e->state == COAP_CLIENT_WAIT_ACK ||
+	       e->state == COAP_CLIENT_WAIT_RESPONSE;
+}
+
+/* Whether the exchange sends the payload of the request block-wise */
+static inline bool sends_blocks(struct coap_client_exchange *e)
+{
+	return !e->block2 && e->req.len > BLOCK_SIZE;
+}
+
+static int outstanding(struct coap_client *client)
+{
+	int count = 0;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(client->exchanges); i++) {
+		if (is_outstanding(&client->exchanges[i])) {
+			count++;
+		}
+	}
+
+	return count;
+}
+
+#if defined(CONFIG_COAP_CLIENT_COCOA)
+static inline uint32_t rto_get(struct coap_client *client)
+{
+	return client->rto;
+}
+
+/* Variable backoff factor of CoCoA, larger for short timeouts */
+static uint32_t backoff(struct coap_client_exchange *e)
+{
+	if (e->rto < 1000) {
+		return e->timeout * 3U;
+	}
+
+	if (e->rto > 3000) {
+		return e->timeout + e->timeout / 2U;
+	}
+
+	return e->timeout * 2U;
+}
+
+/* RFC 6298 section 2 */
+static void rtt_estimate(uint32_t *srtt, uint32_t *rttvar, uint32_t rtt)
+{
+	uint32_t delta;
+
+	if (!*srtt) {
+		*srtt = rtt;
+		*rttvar = rtt / 2U;
+		return;
+	}
+
+	delta = *srtt > rtt ? *srtt - rtt : rtt - *srtt;
+	*rttvar = (3U * *rttvar + delta) / 4U;
+	*srtt = (7U * *srtt + rtt) / 8U;
+}
+
+/* The strong estimator takes the round trip times of the messages which
+ * were not retransmitted. The weak one takes the times since the first
+ * transmission of the messages which were retransmitted once or twice,
+ * which may be the round trip times of any of the transmissions.
+ */
+static void rtt_update(struct coap_client *client,
+		       struct coap_client_exchange *e, int64_t now)
+{
+	uint32_t rtt = MAX(now - e->t0, 1);
+	uint32_t rto;
+
+	if (e->retries == 0U) {
+		rtt_estimate(&client->strong_srtt, &client->strong_rttvar, rtt);
+		rto = client->strong_srtt + 4U * client->strong_rttvar;
+		client->rto = (rto + client->rto) / 2U;
+	} else if (e->retries <= 2U) {
+		rtt_estimate(&client->weak_srtt, &client->weak_rttvar, rtt);
+		rto = client->weak_srtt + client->weak_rttvar;
+		client->rto = (rto + 3U * client->rto) / 4U;
+	} else {
+		return;
+	}
+
+	client->rto = MIN(client->rto, MAX_RTO);
+
+	NET_DBG("RTT %u ms, RTO %u ms", rtt, client->rto);
+}
+#else
+static inline uint32_t rto_get(struct coap_client *client)
+{
+	return ACK_TIMEOUT;
+}
+
+static inline uint32_t backoff(struct coap_client_exchange *e)
+{
+	return e->timeout * 2U;
+}
+
+static inline void rtt_update(struct coap_client *client,
+			      struct coap_client_exchange *e, int64_t now)
+{
+}
+#endif /* CONFIG_COAP_CLIENT_COCOA */
+
+/* How long to wait for a response which is not piggybacked, about
+ * MAX_TRANSMIT_WAIT of RFC 7252.
+ */
+static inline uint32_t response_wait(struct coap_client_exchange *e)
+{
+	return e->rto * ((1U << (MAX_RETRANSMIT + 1)) - 1U) * 3U / 2U;
+}
+
+static int append_path(struct coap_packet *cpkt, const char *path)
+{
+	const char *end;
+	int r;
+
+	while (*path) {
+		end = strchr(path, '/');
+		if (!end) {
+			end = path + strlen(path);
+		}
+
+		if (end > path) {
+			r = coap_packet_append_option(cpkt,
+						      COAP_OPTION_URI_PATH,
+						      (const uint8_t *)path,
+						      end - path);
+			if (r < 0) {
+				return r;
+			}
+		}
+
+		path = *end ? end + 1 : end;
+	}
+
+	return 0;
+}
+
+/* Build the current message of the exchange and send it */
+static int send_message(struct coap_client *client,
+			struct coap_client_exchange *e)
+{
+	const struct coap_client_request *req = &e->req;
+	struct coap_packet cpkt;
+	const uint8_t *payload = NULL;
+	size_t len = 0;
+	bool more;
+	int r;
+
+	r = coap_packet_init(&cpkt, client->tx_buf, sizeof(client->tx_buf),
+			     1, req->confirmable ? COAP_TYPE_CON :
+						   COAP_TYPE_NON_CON,
+			     sizeof(e->token), e->token, req->method, e->id);
+	if (r < 0) {
+		return r;
+	}
+
+	r = append_path(&cpkt, req->path);
+	if (r < 0) {
+		return r;
+	}
+
+	if (!e->block2 && req->len) {
+		payload = req->payload;
+		len = req->len;
+
+		if (req->fmt >= 0) {
+			r = coap_append_option_int(&cpkt,
+						   COAP_OPTION_CONTENT_FORMAT,
+						   req->fmt);
+			if (r < 0) {
+				return r;
+			}
+		}
+	}
+
+	if (e->block2) {
+		r = coap_append_option_int(&cpkt, COAP_OPTION_BLOCK2,
+				BLOCK_VALUE(e->block2_offset >>
+					    (e->block2_szx + 4), 0,
+					    e->block2_szx));
+		if (r < 0) {
+			return r;
+		}
+	}
+
+	if (sends_blocks(e)) {
+		e->block1_len = MIN(BLOCK_BYTES(e->block1_szx),
+				    req->len - e->block1_offset);
+		more = e->block1_offset + e->block1_len < req->len;
+
+		r = coap_append_option_int(&cpkt, COAP_OPTION_BLOCK1,
+				BLOCK_VALUE(e->block1_offset >>
+					    (e->block1_szx + 4), more,
+					    e->block1_szx));
+		if (r < 0) {
+			return r;
+		}
+
+		if (!e->block1_offset) {
+			r = coap_append_option_int(&cpkt, COAP_OPTION_SIZE1,
+						   req->len);
+			if (r < 0) {
+				return r;
+			}
+		}
+
+		payload += e->block1_offset;
+		len = e->block1_len;
+	}
+
+	if (len) {
+		r = coap_packet_append_payload_marker(&cpkt);
+		if (r < 0) {
+			return r;
+		}
+
+		r = coap_packet_append_payload(&cpkt, (uint8_t *)payload, len);
+		if (r < 0) {
+			return r;
+		}
+	}
+
+	r = zsock_sendto(client->sock, client->tx_buf, cpkt.offset, 0,
+			 &client->addr, client->addrlen);
+	if (r < 0) {
+		return -errno;
+	}
+
+	return 0;
+}
+
+static void send_empty(struct coap_client *client, uint8_t type, uint16_t id)
+{
+	struct coap_packet cpkt;
+	uint8_t buf[4];
+
+	if (coap_packet_init(&cpkt, buf, sizeof(buf), 1, type, 0, NULL,
+			     COAP_CODE_EMPTY, id) < 0) {
+		return;
+	}
+
+	(void)zsock_sendto(client->sock, buf, cpkt.offset, 0,
+			   &client->addr, client->addrlen);
+}
+
+/* Send the next message of the exchange, with a new ID and token */
+static int start_message(struct coap_client *client,
+			 struct coap_client_exchange *e, int64_t now)
+{
+	e->id = coap_next_id();
+	memcpy(e->token, coap_next_token(), sizeof(e->token));
+	e->t0 = now;
+	e->retries = 0U;
+	e->rto = rto_get(client);
+
+	/* Random value between RTO and 1.5 * RTO, RFC 7252 section 4.8 */
+	e->timeout = e->rto + sys_rand32_get() % (e->rto / 2U + 1U);
+
+	if (e->req.confirmable) {
+		e->state = COAP_CLIENT_WAIT_ACK;
+		e->deadline = now + e->timeout;
+	} else {
+		e->state = COAP_CLIENT_WAIT_RESPONSE;
+		e->deadline = now + response_wait(e);
+	}
+
+	return send_message(client, e);
+}
+
+static void finish(struct coap_client_exchange *e, int result)
+{
+	e->state = COAP_CLIENT_FREE;
+
+	e->req.cb(result, 0, NULL, 0, true, e->req.user_data);
+}
+
+static void next_message(struct coap_client *client,
+			 struct coap_client_exchange *e, int64_t now)
+{
+	int r;
+
+	r = start_message(client, e, now);
+	if (r < 0) {
+		NET_DBG("Cannot send %p (%d)", e, r);
+		finish(e, r);
+	}
+}
+
+static void start_queued(struct coap_client *client, int64_t now)
+{
+	struct coap_client_exchange *e;
+	int i;
+
+	while (outstanding(client) < CONFIG_COAP_CLIENT_NSTART) {
+		e = NULL;
+
+		for (i = 0; i < ARRAY_SIZE(client->exchanges); i++) {
+			if (client->exchanges[i].state == COAP_CLIENT_QUEUED &&
+			    (!e || (int32_t)(client->exchanges[i].seq -
+					     e->seq) < 0)) {
+				e = &client->exchanges[i];
+			}
+		}
+
+		if (!e) {
+			break;
+		}
+
+		next_message(client, e, now);
+	}
+}
+
+static struct coap_client_exchange *find_by_id(struct coap_client *client,
+					       uint16_t id)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(client->exchanges); i++) {
+		if (client->exchanges[i].state == COAP_CLIENT_WAIT_ACK &&
+		    client->exchanges[i].id == id) {
+			return &client->exchanges[i];
+		}
+	}
+
+	return NULL;
+}
+
+static struct coap_client_exchange *find_by_token(struct coap_client *client,
+						  const uint8_t *token,
+						  uint8_t tkl)
+{
+	int i;
+
+	if (tkl != sizeof(client->exchanges[0].token)) {
+		return NULL;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(client->exchanges); i++) {
+		if (is_outstanding(&client->exchanges[i]) &&
+		    !memcmp(client->exchanges[i].token, token, tkl)) {
+			return &client->exchanges[i];
+		}
+	}
+
+	return NULL;
+}
+
+static void handle_response(struct coap_client *client,
+			    struct coap_client_exchange *e,
+			    const struct coap_packet *cpkt, int64_t now)
+{
+	uint8_t code = coap_header_get_code(cpkt);
+	const uint8_t *payload;
+	uint16_t len;
+	size_t offset;
+	int block;
+	uint8_t szx;
+	bool more;
+
+	payload = coap_packet_get_payload(cpkt, &len);
+
+	if (code == COAP_RESPONSE_CODE_CONTINUE) {
+		block = coap_get_option_int(cpkt, COAP_OPTION_BLOCK1);
+		if (block < 0 || !sends_blocks(e) ||
+		    e->block1_offset + e->block1_len >= e->req.len) {
+			finish(e, -EIO);
+			return;
+		}
+
+		/* The server may ask for smaller blocks */
+		szx = BLOCK_SZX(block);
+		if (szx == e->block1_szx &&
+		    BLOCK_NUM(block) != e->block1_offset >> (szx + 4)) {
+			finish(e, -EIO);
+			return;
+		}
+
+		e->block1_offset += e->block1_len;
+		e->block1_szx = MIN(e->block1_szx, szx);
+
+		next_message(client, e, now);
+		return;
+	}
+
+	block = coap_get_option_int(cpkt, COAP_OPTION_BLOCK2);
+	if (block < 0) {
+		e->state = COAP_CLIENT_FREE;
+		e->req.cb(code, 0, payload, len, true, e->req.user_data);
+		return;
+	}
+
+	szx = BLOCK_SZX(block);
+	offset = BLOCK_NUM(block) << (szx + 4);
+	more = BLOCK_MORE(block);
+
+	if (szx > COAP_BLOCK_1024 || offset != e->block2_offset ||
+	    (more && len != BLOCK_BYTES(szx))) {
+		finish(e, -EIO);
+		return;
+	}
+
+	if (!more) {
+		e->state = COAP_CLIENT_FREE;
+		e->req.cb(code, offset, payload, len, true, e->req.user_data);
+		return;
+	}
+
+	e->req.cb(code, offset, payload, len, false, e->req.user_data);
+
+	/* The callback may have cancelled the request */
+	if (!is_outstanding(e)) {
+		return;
+	}
+
+	e->block2 = true;
+	e->block2_offset = offset + len;
+	e->block2_szx = szx;
+
+	next_message(client, e, now);
+}
+
+static void handle_message(struct coap_client *client, uint8_t *data,
+			   uint16_t len, int64_t now)
+{
+	struct coap_client_exchange *e;
+	struct coap_packet cpkt;
+	uint8_t token[8];
+	uint8_t type;
+	uint8_t code;
+	uint8_t tkl;
+	uint16_t id;
+
+	if (coap_packet_parse(&cpkt, data, len, NULL, 0) < 0) {
+		return;
+	}
+
+	type = coap_header_get_type(&cpkt);
+	code = coap_header_get_code(&cpkt);
+	id = coap_header_get_id(&cpkt);
+
+	if (code == COAP_CODE_EMPTY) {
+		/* Answer CoAP pings */
+		if (type == COAP_TYPE_CON) {
+			send_empty(client, COAP_TYPE_RESET, id);
+			return;
+		}
+
+		e = find_by_id(client, id);
+		if (!e) {
+			return;
+		}
+
+		if (type == COAP_TYPE_RESET) {
+			finish(e, -ECONNRESET);
+			return;
+		}
+
+		/* The response will be separate */
+		rtt_update(client, e, now);
+		e->state = COAP_CLIENT_WAIT_RESPONSE;
+		e->deadline = now + response_wait(e);
+		return;
+	}
+
+	/* Requests are for servers */
+	if ((code >> 5) == 0U) {
+		return;
+	}
+
+	tkl = coap_header_get_token(&cpkt, token);
+	e = find_by_token(client, token, tkl);
+
+	if (type == COAP_TYPE_CON) {
+		send_empty(client, e ? COAP_TYPE_ACK : COAP_TYPE_RESET, id);
+	}
+
+	if (!e) {
+		return;
+	}
+
+	if (type == COAP_TYPE_ACK) {
+		if (e->state != COAP_CLIENT_WAIT_ACK || e->id != id) {
+			return;
+		}
+
+		rtt_update(client, e, now);
+	}
+
+	handle_response(client, e, &cpkt, now);
+}
+
+static void handle_timeouts(struct coap_client *client, int64_t now)
+{
+	struct coap_client_exchange *e;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(client->exchanges); i++) {
+		e = &client->exchanges[i];
+
+		if (!is_outstanding(e) || e->deadline > now) {
+			continue;
+		}
+
+		if (e->state == COAP_CLIENT_WAIT_ACK &&
+		    e->retries < MAX_RETRANSMIT) {
+			e->retries++;
+			e->timeout = backoff(e);
+			e->deadline = now + e->timeout;
+
+			NET_DBG("Retransmitting %p (%u)", e, e->retries);
+
+			if (send_message(client, e) < 0) {
+				finish(e, -EIO);
+			}
+
+			continue;
+		}
+
+		finish(e, -ETIMEDOUT);
+	}
+}
+
+int coap_client_init(struct coap_client *client, int sock,
+		     const struct sockaddr *addr, socklen_t addrlen)
+{
+	if (!client || sock < 0 || !addr || addrlen > sizeof(client->addr)) {
+		return -EINVAL;
+	}
+
+	memset(client, 0, sizeof(*client));
+
+	k_mutex_init(&client->lock);
+	memcpy(&client->addr, addr, addrlen);
+	client->addrlen = addrlen;
+	client->sock = sock;
+
+#if defined(CONFIG_COAP_CLIENT_COCOA)
+	client->rto = ACK_TIMEOUT;
+#endif
+
+	return 0;
+}
+
+int coap_client_req(struct coap_client *client,
+		    const struct coap_client_request *req)
+{
+	struct coap_client_exchange *e = NULL;
+	int r = 0;
+	int i;
+
+	if (!client || !req || !req->cb || !req->path ||
+	    (req->len && !req->payload)) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&client->lock, K_FOREVER);
+
+	for (i = 0; i < ARRAY_SIZE(client->exchanges); i++) {
+		if (client->exchanges[i].state == COAP_CLIENT_FREE) {
+			e = &client->exchanges[i];
+			break;
+		}
+	}
+
+	if (!e) {
+		r = -ENOMEM;
+		goto out;
+	}
+
+	memset(e, 0, sizeof(*e));
+	memcpy(&e->req, req, sizeof(e->req));
+	e->seq = client->seq++;
+	e->block1_szx = block_szx();
+	e->block2_szx = e->block1_szx;
+	e->state = COAP_CLIENT_QUEUED;
+
+	if (outstanding(client) < CONFIG_COAP_CLIENT_NSTART) {
+		r = start_message(client, e, k_uptime_get());
+		if (r < 0) {
+			e->state = COAP_CLIENT_FREE;
+		}
+	}
+
+out:
+	k_mutex_unlock(&client->lock);
+
+	return r;
+}
+
+int32_t coap_client_process(struct coap_client *client)
+{
+	int32_t next = SYS_FOREVER_MS;
+	int64_t now;
+	ssize_t len;
+	int i;
+
+	k_mutex_lock(&client->lock, K_FOREVER);
+
+	while (true) {
+		len = zsock_recvfrom(client->sock, client->rx_buf,
+				     sizeof(client->rx_buf),
+				     ZSOCK_MSG_DONTWAIT, NULL, NULL);
+		if (len < 0) {
+			break;
+		}
+
+		handle_message(client, client->rx_buf, len, k_uptime_get());
+	}
+
+	now = k_uptime_get();
+
+	handle_timeouts(client, now);
+	start_queued(client, now);
+
+	for (i = 0; i < ARRAY_SIZE(client->exchanges); i++) {
+		struct coap_client_exchange *e = &client->exchanges[i];
+
+		if (!is_outstanding(e)) {
+			continue;
+		}
+
+		if (next == SYS_FOREVER_MS || e->deadline - now < next) {
+			next = MAX(e->deadline - now, 0);
+		}
+	}
+
+	k_mutex_unlock(&client->lock);
+
+	return next;
+}
+
+int coap_client_wait(struct coap_client *client, int32_t timeout)
+{
+	struct zsock_pollfd fds = {
+		.fd = client->sock,
+		.events = ZSOCK_POLLIN,
+	};
+	int64_t end = k_uptime_get() + timeout;
+	int64_t remaining;
+	int32_t next;
+
+	while (true) {
+		next = coap_client_process(client);
+		if (next == SYS_FOREVER_MS) {
+			return 0;
+		}
+
+		if (timeout != SYS_FOREVER_MS) {
+			remaining = end - k_uptime_get();
+			if (remaining <= 0) {
+				return -EAGAIN;
+			}
+
+			next = MIN(next, remaining);
+		}
+
+		if (zsock_poll(&fds, 1, next) < 0) {
+			return -errno;
+		}
+	}
+}
+
+void coap_client_cancel(struct coap_client *client)
+{
+	int i;
+
+	k_mutex_lock(&client->lock, K_FOREVER);
+
+	for (i = 0; i < ARRAY_SIZE(client->exchanges); i++) {
+		if (client->exchanges[i].state != COAP_CLIENT_FREE) {
+			finish(&client->exchanges[i], -ECANCELED);
+		}
+	}
+
+	k_mutex_unlock(&client->lock);
+}
@@ -0,0 +1,206 @@
+/** @file
+ * @brief DNS answer cache
+ *
+ * Keeps the answers to A and AAAA queries until their TTL expires.
+ */
+
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_DECLARE(net_dns_resolve, CONFIG_DNS_RESOLVER_LOG_LEVEL);
+
+#include <zephyr/types.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <kernel.h>
+#include <sys/util.h>
+
+#include <net/dns_resolve.h>
+#include "dns_cache.h"
+
+static struct dns_cache_entry cache[CONFIG_DNS_RESOLVER_CACHE_MAX_ENTRIES];
+static struct dns_cache_stats stats;
+static K_MUTEX_DEFINE(lock);
+
+static inline bool is_cached_type(enum dns_query_type type)
+{
+	return type == DNS_QUERY_TYPE_A || type == DNS_QUERY_TYPE_AAAA;
+}
+
+/* Release the entry if it has expired */
+static bool entry_valid(struct dns_cache_entry *entry, int64_t now)
+{
+	if (!entry->is_used) {
+		return false;
+	}
+
+	if (entry->expiry - now <= 0) {
+		entry->is_used = false;
+		return false;
+	}
+
+	return true;
+}
+
+static struct dns_cache_entry *entry_find(const char *name,
+					  enum dns_query_type type,
+					  int64_t now)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(cache); i++) {
+		if (!entry_valid(&cache[i], now)) {
+			continue;
+		}
+
+		/* Names are case insensitive, see RFC 4343 */
+		if (cache[i].type == type &&
+		    !strncasecmp(cache[i].name, name, sizeof(cache[i].name))) {
+			return &cache[i];
+		}
+	}
+
+	return NULL;
+}
+
+int dns_cache_find(const char *name, enum dns_query_type type,
+		   struct dns_cache_entry *entry)
+{
+	struct dns_cache_entry *found;
+
+	if (!is_cached_type(type)) {
+		return -ENOENT;
+	}
+
+	k_mutex_lock(&lock, K_FOREVER);
+
+	found = entry_find(name, type, k_uptime_get());
+	if (!found) {
+		stats.misses++;
+		k_mutex_unlock(&lock);
+
+		return -ENOENT;
+	}
+
+	if (found->count) {
+		stats.hits++;
+	} else {
+		stats.negative_hits++;
+	}
+
+	memcpy(entry, found, sizeof(*entry));
+
+	k_mutex_unlock(&lock);
+
+	return 0;
+}
+
+void dns_cache_add(const char *name, enum dns_query_type type, uint8_t rcode,
+		   const struct sockaddr *addr, int count, uint32_t ttl)
+{
+	struct dns_cache_entry *entry;
+	size_t len = strlen(name);
+	int64_t now;
+	int i;
+
+	if (!is_cached_type(type) || len > CONFIG_DNS_RESOLVER_CACHE_NAME_LEN) {
+		return;
+	}
+
+	if (!count) {
+		ttl = CONFIG_DNS_RESOLVER_CACHE_NEGATIVE_TTL;
+	}
+
+	/* A zero TTL means that the answer must not be cached */
+	ttl = MIN(ttl, CONFIG_DNS_RESOLVER_CACHE_MAX_TTL);
+	if (!ttl) {
+		return;
+	}
+
+	count = MIN(count, CONFIG_DNS_RESOLVER_CACHE_MAX_ADDRS);
+
+	k_mutex_lock(&lock, K_FOREVER);
+
+	now = k_uptime_get();
+
+	entry = entry_find(name, type, now);
+	if (!entry) {
+		/* Take a free slot, or replace the entry which would have
+		 * expired first.
+		 */
+		for (i = 0; i < ARRAY_SIZE(cache); i++) {
+			if (!entry_valid(&cache[i], now)) {
+				entry = &cache[i];
+				break;
+			}
+
+			if (!entry || cache[i].expiry < entry->expiry) {
+				entry = &cache[i];
+			}
+		}
+
+		if (entry->is_used) {
+			NET_DBG("Evicting %s", log_strdup(entry->name));
+			stats.evicted++;
+		}
+
+		memcpy(entry->name, name, len + 1);
+		entry->type = type;
+		entry->is_used = true;
+	}
+
+	memcpy(entry->addr, addr, count * sizeof(struct sockaddr));
+	entry->count = count;
+	entry->rcode = rcode;
+	entry->expiry = now + (int64_t)ttl * MSEC_PER_SEC;
+
+	stats.added++;
+
+	k_mutex_unlock(&lock);
+
+	NET_DBG("Cached %s type %d rcode %u addrs %d ttl %u", log_strdup(name),
+		type, rcode, count, ttl);
+}
+
+void dns_cache_foreach(dns_cache_cb_t cb, void *user_data)
+{
+	int64_t now;
+	int i;
+
+	k_mutex_lock(&lock, K_FOREVER);
+
+	now = k_uptime_get();
+
+	for (i = 0; i < ARRAY_SIZE(cache); i++) {
+		if (entry_valid(&cache[i], now)) {
+			cb(&cache[i], user_data);
+		}
+	}
+
+	k_mutex_unlock(&lock);
+}
+
+void dns_cache_flush(void)
+{
+	int i;
+
+	k_mutex_lock(&lock, K_FOREVER);
+
+	for (i = 0; i < ARRAY_SIZE(cache); i++) {
+		cache[i].is_used = false;
+	}
+
+	k_mutex_unlock(&lock);
+}
+
+void dns_cache_get_stats(struct dns_cache_stats *copy)
+{
+	k_mutex_lock(&lock, K_FOREVER);
+	memcpy(copy, &stats, sizeof(*copy));
+	k_mutex_unlock(&lock);
+}
@@ -0,0 +1,50 @@
+/** @file
+ * @brief DNS answer cache
+ *
+ * This is not to be included by the application.
+ */
+
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __DNS_CACHE_H
+#define __DNS_CACHE_H
+
+#include <zephyr/types.h>
+#include <net/dns_resolve.h>
+
+struct dns_cache_entry;
+
+/**
+ * @brief Look up the cached answer of a query.
+ *
+ * @param name Queried name.
+ * @param type Query type.
+ * @param entry Where to copy the cached answer.
+ *
+ * @return 0 if found, -ENOENT otherwise.
+ */
+int dns_cache_find(const char *name, enum dns_query_type type,
+		   struct dns_cache_entry *entry);
+
+/**
+ * @brief Add the answer of a query to the cache.
+ *
+ * An answer without addresses is a negative one, it is kept for
+ * CONFIG_DNS_RESOLVER_CACHE_NEGATIVE_TTL seconds and the ttl parameter is
+ * ignored.
+ *
+ * @param name Queried name.
+ * @param type Query type.
+ * @param rcode Response code of the answer.
+ * @param addr Resolved addresses.
+ * @param count Number of addresses.
+ * @param ttl Smallest TTL of the answer records in seconds.
+ */
+void dns_cache_add(const char *name, enum dns_query_type type, uint8_t rcode,
+		   const struct sockaddr *addr, int count, uint32_t ttl);
+
+#endif /* __DNS_CACHE_H */
@@ -217,9 +217,10 @@ int dns_unpack_response_header(struct dns_msg_t *msg, int src_id)
 	ancount = dns_unpack_header_ancount(dns_header);
 
 	/* For mDNS (when src_id == 0) the query count is 0 so accept
-	 * the packet in that case.
+	 * the packet in that case. A DNS answer without records tells that
+	 * the name has no record of the queried type (NODATA).
 	 */
-	if ((qdcount < 1 && src_id > 0) || ancount < 1) {
+	if ((qdcount < 1 && src_id > 0) || (ancount < 1 && src_id == 0)) {
 		return -EINVAL;
 	}
 
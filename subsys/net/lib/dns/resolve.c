@@ -24,6 +24,7 @@ LOG_MODULE_REGISTER(net_dns_resolve, CONFIG_DNS_RESOLVER_LOG_LEVEL);
 #include <net/net_mgmt.h>
 #include <net/dns_resolve.h>
 #include "dns_pack.h"
+#include "dns_cache.h"
 
 #define DNS_SERVER_COUNT CONFIG_DNS_RESOLVER_MAX_SERVERS
 #define SERVER_COUNT     (DNS_SERVER_COUNT + DNS_MAX_MCAST_SERVERS)
@@ -368,8 +369,12 @@ static int dns_read(struct dns_resolve_context *ctx,
 {
 	struct dns_addrinfo info = { 0 };
 	/* Helper struct to track the dns msg received from the server */
-	struct dns_msg_t dns_msg;
+	struct dns_msg_t dns_msg = DNS_MSG_INIT(NULL, 0);
 	uint32_t ttl; /* RR ttl, so far it is not passed to caller */
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+	struct sockaddr cache_addr[CONFIG_DNS_RESOLVER_CACHE_MAX_ADDRS];
+	uint32_t cache_ttl = UINT32_MAX;
+#endif
 	uint8_t *src, *addr;
 	const char *query_name;
 	int address_size;
@@ -458,22 +463,29 @@ static int dns_read(struct dns_resolve_context *ctx,
 			goto quit;
 		}
 
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+		/* The answer is valid as long as all of its records are */
+		cache_ttl = MIN(cache_ttl, ttl);
+#endif
+
 		switch (dns_msg.response_type) {
 		case DNS_RESPONSE_IP:
-			if (query_idx >= 0) {
-				goto query_known;
-			}
-
-			query_name = dns_msg.msg + dns_msg.query_offset;
-
-			/* Add \0 and query type (A or AAAA) to the hash */
-			*query_hash = crc16_ansi(query_name,
-						 strlen(query_name) + 1 + 2);
-
-			query_idx = get_slot_by_id(ctx, *dns_id, *query_hash);
 			if (query_idx < 0) {
-				ret = DNS_EAI_SYSTEM;
-				goto quit;
+				query_name = dns_msg.msg + dns_msg.query_offset;
+
+				/* Add \0 and query type (A or AAAA) to the
+				 * hash
+				 */
+				*query_hash = crc16_ansi(query_name,
+							 strlen(query_name) +
+							 1 + 2);
+
+				query_idx = get_slot_by_id(ctx, *dns_id,
+							   *query_hash);
+				if (query_idx < 0) {
+					ret = DNS_EAI_SYSTEM;
+					goto quit;
+				}
 			}
 
 			if (ctx->queries[query_idx].query_type ==
@@ -529,7 +541,13 @@ static int dns_read(struct dns_resolve_context *ctx,
 			src = dns_msg.msg + dns_msg.response_position;
 			memcpy(addr, src, address_size);
 
-		query_known:
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+			if (items < ARRAY_SIZE(cache_addr)) {
+				memcpy(&cache_addr[items], &info.ai_addr,
+				       sizeof(struct sockaddr));
+			}
+#endif
+
 			ctx->queries[query_idx].cb(DNS_EAI_INPROGRESS, &info,
 					ctx->queries[query_idx].user_data);
 			items++;
@@ -588,12 +606,27 @@ static int dns_read(struct dns_resolve_context *ctx,
 		}
 	}
 
-	if (items == 0) {
-		ret = DNS_EAI_NODATA;
-	} else {
+	if (items) {
 		ret = DNS_EAI_ALLDONE;
+	} else if (dns_header_rcode(dns_msg.msg) == DNS_HEADER_NAMEERROR) {
+		ret = DNS_EAI_NONAME;
+	} else {
+		ret = DNS_EAI_NODATA;
 	}
 
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+	/* The original name is cached, not the CNAME target. Only the
+	 * name errors and empty answers are negative, not server failures.
+	 */
+	if (items || dns_header_rcode(dns_msg.msg) == DNS_HEADER_NOERROR ||
+	    dns_header_rcode(dns_msg.msg) == DNS_HEADER_NAMEERROR) {
+		dns_cache_add(ctx->queries[query_idx].query,
+			      ctx->queries[query_idx].query_type,
+			      dns_header_rcode(dns_msg.msg), cache_addr,
+			      MIN(items, ARRAY_SIZE(cache_addr)), cache_ttl);
+	}
+#endif
+
 	if (k_delayed_work_remaining_get(&ctx->queries[query_idx].timer) > 0) {
 		k_delayed_work_cancel(&ctx->queries[query_idx].timer);
 	}
@@ -884,6 +917,52 @@ static void query_timeout(struct k_work *work)
 					   pending_query->query);
 }
 
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+static bool resolve_from_cache(const char *query, enum dns_query_type type,
+			       dns_resolve_cb_t cb, void *user_data)
+{
+	struct dns_cache_entry entry;
+	struct dns_addrinfo info;
+	int i;
+
+	if (dns_cache_find(query, type, &entry) < 0) {
+		return false;
+	}
+
+	NET_DBG("Cached answer for %s", log_strdup(query));
+
+	for (i = 0; i < entry.count; i++) {
+		(void)memset(&info, 0, sizeof(info));
+
+		memcpy(&info.ai_addr, &entry.addr[i], sizeof(info.ai_addr));
+		info.ai_family = entry.addr[i].sa_family;
+		info.ai_addrlen = info.ai_family == AF_INET6 ?
+					sizeof(struct sockaddr_in6) :
+					sizeof(struct sockaddr_in);
+
+		cb(DNS_EAI_INPROGRESS, &info, user_data);
+	}
+
+	/* A negative answer is reported as it was when received */
+	if (entry.count) {
+		cb(DNS_EAI_ALLDONE, NULL, user_data);
+	} else if (entry.rcode == DNS_HEADER_NAMEERROR) {
+		cb(DNS_EAI_NONAME, NULL, user_data);
+	} else {
+		cb(DNS_EAI_NODATA, NULL, user_data);
+	}
+
+	return true;
+}
+#else
+static inline bool resolve_from_cache(const char *query,
+				      enum dns_query_type type,
+				      dns_resolve_cb_t cb, void *user_data)
+{
+	return false;
+}
+#endif /* CONFIG_DNS_RESOLVER_CACHE */
+
 int dns_resolve_name(struct dns_resolve_context *ctx,
 		     const char *query,
 		     enum dns_query_type type,
@@ -964,6 +1043,14 @@ int dns_resolve_name(struct dns_resolve_context *ctx,
 	}
 
 try_resolve:
+	if (resolve_from_cache(query, type, cb, user_data)) {
+		if (dns_id) {
+			*dns_id = 0U;
+		}
+
+		return 0;
+	}
+
 	i = get_cb_slot(ctx);
 	if (i < 0) {
 		return -EAGAIN;
@@ -1131,6 +1218,11 @@ int dns_resolve_close(struct dns_resolve_context *ctx)
 
 	ctx->is_used = false;
 
+	/* The answers might have come from the servers which are now gone */
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+	dns_cache_flush();
+#endif
+
 	return 0;
 }
 
@@ -0,0 +1,754 @@
+/** @file
+ * @brief HTTP client session API
+ *
+ * An API for applications to do HTTP/1.1 requests on persistent
+ * connections to a host
+ */
+
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_http_session, CONFIG_NET_HTTP_LOG_LEVEL);
+
+#include <kernel.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <sys/util.h>
+
+#include <net/socket.h>
+#include <net/http_client_session.h>
+
+#if defined(CONFIG_STREAM_FLASH)
+#include <storage/stream_flash.h>
+#endif
+
+BUILD_ASSERT(CONFIG_NET_SOCKETS_POLL_MAX >=
+	     CONFIG_HTTP_CLIENT_SESSION_MAX_CONNS,
+	     "CONFIG_NET_SOCKETS_POLL_MAX must cover the connections");
+
+/* Request line and generated header fields, user header fields, end of
+ * the header, body
+ */
+#define MAX_IOV (CONFIG_HTTP_CLIENT_SESSION_MAX_HEADERS + 3)
+
+static const char crlf[] = "\r\n";
+
+static int req_send(struct http_session *session,
+		    struct http_session_req *req);
+
+static int sendv_all(int sock, struct iovec *iov, size_t iovcnt)
+{
+	struct msghdr msg = {
+		.msg_iov = iov,
+		.msg_iovlen = iovcnt,
+	};
+
+	if (zsock_sendmsg_all(sock, &msg, 0) < 0) {
+		return -errno;
+	}
+
+	return 0;
+}
+
+/* Only requests which can safely be sent again are pipelined, RFC 7230
+ * section 6.3.2.
+ */
+static bool req_pipelined(const struct http_session_req *req)
+{
+	return (req->method == HTTP_GET || req->method == HTTP_HEAD) &&
+	       !req->payload && !req->body_cb;
+}
+
+static bool req_chunked(const struct http_session_req *req)
+{
+	return req->body_cb && req->payload_len == 0;
+}
+
+static struct http_session_req *conn_req(struct http_session_conn *conn)
+{
+	if (conn->count == 0) {
+		return NULL;
+	}
+
+	return conn->pending[conn->head];
+}
+
+static int count_pending(struct http_session *session)
+{
+	int count = 0;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(session->conns); i++) {
+		count += session->conns[i].count;
+	}
+
+	return count;
+}
+
+/* Format the request line and the generated header fields into tx_buf */
+static int format_header(struct http_session *session,
+			 const struct http_session_req *req)
+{
+	char *buf = (char *)session->tx_buf;
+	size_t size = sizeof(session->tx_buf);
+	int len;
+	int ret;
+
+	len = snprintk(buf, size, "%s %s HTTP/1.1\r\nHost: %s\r\n",
+		       http_method_str(req->method), req->url, session->host);
+	if (len < 0 || len >= size) {
+		return -ENOMEM;
+	}
+
+	if (req->content_type) {
+		ret = snprintk(buf + len, size - len, "Content-Type: %s\r\n",
+			       req->content_type);
+		if (ret < 0 || ret >= size - len) {
+			return -ENOMEM;
+		}
+
+		len += ret;
+	}
+
+	if (req_chunked(req)) {
+		ret = snprintk(buf + len, size - len,
+			       "Transfer-Encoding: chunked\r\n");
+	} else if (req->payload || req->body_cb) {
+		ret = snprintk(buf + len, size - len,
+			       "Content-Length: %zu\r\n", req->payload_len);
+	} else {
+		ret = 0;
+	}
+
+	if (ret < 0 || ret >= size - len) {
+		return -ENOMEM;
+	}
+
+	len += ret;
+
+	if (req->range_end == HTTP_SESSION_RANGE_END) {
+		ret = snprintk(buf + len, size - len, "Range: bytes=%zu-\r\n",
+			       req->range_start);
+	} else if (req->range_end > 0) {
+		ret = snprintk(buf + len, size - len,
+			       "Range: bytes=%zu-%zu\r\n", req->range_start,
+			       req->range_end);
+	} else {
+		ret = 0;
+	}
+
+	if (ret < 0 || ret >= size - len) {
+		return -ENOMEM;
+	}
+
+	return len + ret;
+}
+
+/* Send the body produced by the callback of the request. The first part
+ * is produced behind the header, which is at the start of tx_buf, so that
+ * both are sent at once.
+ */
+static int send_body_cb(struct http_session_conn *conn,
+			struct http_session_req *req, struct iovec *iov,
+			size_t iovcnt, size_t offset)
+{
+	static const char last_chunk[] = "0\r\n\r\n";
+	struct http_session *session = conn->session;
+	bool chunked = req_chunked(req);
+	char chunk[sizeof("ffffffff\r\n")];
+	int len;
+	int ret;
+
+	do {
+		len = req->body_cb(req, session->tx_buf + offset,
+				   sizeof(session->tx_buf) - offset);
+		if (len < 0) {
+			return len;
+		}
+
+		if (chunked && len > 0) {
+			iov[iovcnt].iov_base = chunk;
+			iov[iovcnt++].iov_len = snprintk(chunk, sizeof(chunk),
+							 "%x\r\n", len);
+		}
+
+		if (len > 0) {
+			iov[iovcnt].iov_base = session->tx_buf + offset;
+			iov[iovcnt++].iov_len = len;
+		}
+
+		if (chunked) {
+			iov[iovcnt].iov_base = (void *)(len > 0 ? crlf :
+							last_chunk);
+			iov[iovcnt++].iov_len = len > 0 ? sizeof(crlf) - 1 :
+					       sizeof(last_chunk) - 1;
+		}
+
+		ret = sendv_all(conn->sock, iov, iovcnt);
+		if (ret < 0) {
+			return ret;
+		}
+
+		iovcnt = 0;
+		offset = 0;
+	} while (len > 0);
+
+	return 0;
+}
+
+static int send_request(struct http_session_conn *conn,
+			struct http_session_req *req)
+{
+	struct http_session *session = conn->session;
+	/* Room for a chunk size line and trailing CRLF behind the body */
+	struct iovec iov[MAX_IOV + 2];
+	size_t iovcnt = 0;
+	int len;
+	int i;
+
+	len = format_header(session, req);
+	if (len < 0) {
+		return len;
+	}
+
+	iov[iovcnt].iov_base = session->tx_buf;
+	iov[iovcnt++].iov_len = len;
+
+	for (i = 0; req->headers && req->headers[i]; i++) {
+		if (i == CONFIG_HTTP_CLIENT_SESSION_MAX_HEADERS) {
+			return -E2BIG;
+		}
+
+		iov[iovcnt].iov_base = (void *)req->headers[i];
+		iov[iovcnt++].iov_len = strlen(req->headers[i]);
+	}
+
+	iov[iovcnt].iov_base = (void *)crlf;
+	iov[iovcnt++].iov_len = sizeof(crlf) - 1;
+
+	if (req->body_cb) {
+		return send_body_cb(conn, req, iov, iovcnt, len);
+	}
+
+	if (req->payload && req->payload_len > 0) {
+		iov[iovcnt].iov_base = (void *)req->payload;
+		iov[iovcnt++].iov_len = req->payload_len;
+	}
+
+	return sendv_all(conn->sock, iov, iovcnt);
+}
+
+static int on_message_begin(struct http_parser *parser)
+{
+	struct http_session_conn *conn =
+		CONTAINER_OF(parser, struct http_session_conn, parser);
+	struct http_session_req *req = conn_req(conn);
+
+	if (!req) {
+		LOG_DBG("Unexpected response on %d", conn->sock);
+		conn->error = -EBADMSG;
+		return -1;
+	}
+
+	req->started = true;
+	req->status = 0U;
+	req->content_length = 0;
+	req->received = 0;
+
+	return 0;
+}
+
+static int on_headers_complete(struct http_parser *parser)
+{
+	struct http_session_conn *conn =
+		CONTAINER_OF(parser, struct http_session_conn, parser);
+	struct http_session_req *req = conn_req(conn);
+
+	req->status = parser->status_code;
+	if (parser->content_length != ULLONG_MAX) {
+		req->content_length = parser->content_length;
+	}
+
+	/* The response to a HEAD request has no body */
+	return req->method == HTTP_HEAD ? 1 : 0;
+}
+
+static bool status_ok(uint16_t status)
+{
+	return status >= 200U && status < 300U;
+}
+
+static int on_body(struct http_parser *parser, const char *at, size_t length)
+{
+	struct http_session_conn *conn =
+		CONTAINER_OF(parser, struct http_session_conn, parser);
+	struct http_session_req *req = conn_req(conn);
+	int ret;
+
+	req->received += length;
+
+	/* Fragments are delivered from the receive buffer, which the
+	 * stream flash context copies straight into its write buffer.
+	 */
+	if (req->flash && status_ok(req->status)) {
+#if defined(CONFIG_STREAM_FLASH)
+		ret = stream_flash_buffered_write(req->flash,
+						  (const uint8_t *)at, length,
+						  false);
+#else
+		ret = -ENOTSUP;
+#endif
+		if (ret < 0) {
+			conn->error = ret;
+			return -1;
+		}
+	}
+
+	if (req->data_cb) {
+		ret = req->data_cb(req, (const uint8_t *)at, length);
+		if (ret < 0) {
+			conn->error = ret;
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static int on_message_complete(struct http_parser *parser)
+{
+	struct http_session_conn *conn =
+		CONTAINER_OF(parser, struct http_session_conn, parser);
+	struct http_session_req *req = conn_req(conn);
+
+	/* An interim response, the final one follows */
+	if (req->status >= 100U && req->status < 200U &&
+	    req->status != 101U) {
+		return 0;
+	}
+
+#if defined(CONFIG_STREAM_FLASH)
+	if (req->flash && status_ok(req->status)) {
+		int ret = stream_flash_buffered_write(req->flash, NULL, 0,
+						      true);
+
+		if (ret < 0) {
+			conn->error = ret;
+			return -1;
+		}
+	}
+#endif
+
+	conn->head = (conn->head + 1) % ARRAY_SIZE(conn->pending);
+	conn->count--;
+	conn->close = !http_should_keep_alive(parser);
+
+	if (req->done_cb) {
+		req->done_cb(req, req->status);
+	}
+
+	/* Stop parsing if the connection is to be closed */
+	return conn->close ? 1 : 0;
+}
+
+static const struct http_parser_settings parser_settings = {
+	.on_message_begin = on_message_begin,
+	.on_headers_complete = on_headers_complete,
+	.on_body = on_body,
+	.on_message_complete = on_message_complete,
+};
+
+static int conn_open(struct http_session_conn *conn)
+{
+	struct http_session *session = conn->session;
+	int ret;
+
+	conn->sock = zsock_socket(session->addr.sa_family, SOCK_STREAM,
+				  IPPROTO_TCP);
+	if (conn->sock < 0) {
+		return -errno;
+	}
+
+	if (zsock_connect(conn->sock, &session->addr, session->addrlen) < 0) {
+		ret = -errno;
+		(void)zsock_close(conn->sock);
+		conn->sock = -1;
+		return ret;
+	}
+
+	LOG_DBG("Opened connection %d", conn->sock);
+
+	conn->head = 0U;
+	conn->count = 0U;
+	conn->close = false;
+	conn->error = 0;
+	conn->last_activity = k_uptime_get();
+	http_parser_init(&conn->parser, HTTP_RESPONSE);
+
+	return 0;
+}
+
+/* Check whether the server closed an idle connection, in which case
+ * nothing but the end of the connection can be waiting on it.
+ */
+static bool conn_alive(struct http_session_conn *conn)
+{
+	struct zsock_pollfd fd = {
+		.fd = conn->sock,
+		.events = ZSOCK_POLLIN,
+	};
+	uint8_t c;
+
+	if (zsock_poll(&fd, 1, 0) <= 0) {
+		return true;
+	}
+
+	return (fd.revents & ZSOCK_POLLIN) &&
+	       zsock_recv(conn->sock, &c, 1, ZSOCK_MSG_PEEK |
+			  ZSOCK_MSG_DONTWAIT) > 0;
+}
+
+static void conn_fail(struct http_session_conn *conn, int err, bool retry);
+
+/* Pick the connection to send a request on: an idle connection, then an
+ * open connection with room in its pipeline, then a new connection.
+ */
+static struct http_session_conn *conn_get(struct http_session *session,
+					  struct http_session_req *req,
+					  int *err)
+{
+	struct http_session_conn *best = NULL;
+	struct http_session_conn *unused = NULL;
+	struct http_session_conn *conn;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(session->conns); i++) {
+		conn = &session->conns[i];
+
+		if (conn->sock < 0) {
+			if (!unused) {
+				unused = conn;
+			}
+
+			continue;
+		}
+
+		if (conn->close) {
+			continue;
+		}
+
+		if (conn->count == 0 && !conn_alive(conn)) {
+			conn_fail(conn, 0, false);
+			if (!unused) {
+				unused = conn;
+			}
+
+			continue;
+		}
+
+		if (conn->count > 0 &&
+		    (!req_pipelined(req) ||
+		     conn->count == ARRAY_SIZE(conn->pending) ||
+		     !req_pipelined(conn->pending[(conn->head + conn->count - 1) %
+						  ARRAY_SIZE(conn->pending)]))) {
+			continue;
+		}
+
+		if (!best || conn->count < best->count) {
+			best = conn;
+		}
+	}
+
+	if (best) {
+		return best;
+	}
+
+	if (!unused) {
+		*err = -EAGAIN;
+		return NULL;
+	}
+
+	*err = conn_open(unused);
+	if (*err < 0) {
+		return NULL;
+	}
+
+	return unused;
+}
+
+/* Close a connection and complete the requests waiting on it. The
+ * requests whose response has not started are sent again once if retry
+ * is set, the server may have closed an idle connection as they were sent.
+ */
+static void conn_fail(struct http_session_conn *conn, int err, bool retry)
+{
+	struct http_session_req *reqs[ARRAY_SIZE(conn->pending)];
+	struct http_session_req *req;
+	int count = conn->count;
+	int ret;
+	int i;
+
+	LOG_DBG("Closing connection %d (%d)", conn->sock, err);
+
+	for (i = 0; i < count; i++) {
+		reqs[i] = conn->pending[(conn->head + i) %
+					ARRAY_SIZE(conn->pending)];
+	}
+
+	(void)zsock_close(conn->sock);
+	conn->sock = -1;
+	conn->count = 0U;
+
+	for (i = 0; i < count; i++) {
+		req = reqs[i];
+
+		if (retry && !req->started && !req->retried &&
+		    req_pipelined(req)) {
+			req->retried = true;
+			ret = req_send(conn->session, req);
+			if (ret == 0) {
+				continue;
+			}
+		} else {
+			ret = err;
+		}
+
+		if (req->done_cb) {
+			req->done_cb(req, ret);
+		}
+	}
+}
+
+static void conn_recv(struct http_session_conn *conn)
+{
+	struct http_session *session = conn->session;
+	ssize_t len;
+
+	len = zsock_recv(conn->sock, session->rx_buf, sizeof(session->rx_buf),
+			 ZSOCK_MSG_DONTWAIT);
+	if (len < 0 && errno == EAGAIN) {
+		return;
+	}
+
+	if (len < 0) {
+		conn_fail(conn, -errno, true);
+		return;
+	}
+
+	if (len == 0) {
+		/* Completes a response delimited by the end of the
+		 * connection.
+		 */
+		(void)http_parser_execute(&conn->parser, &parser_settings,
+					  NULL, 0);
+		conn_fail(conn, -ECONNRESET, true);
+		return;
+	}
+
+	conn->last_activity = k_uptime_get();
+
+	(void)http_parser_execute(&conn->parser, &parser_settings,
+				  (const char *)session->rx_buf, len);
+
+	if (conn->error < 0) {
+		conn_fail(conn, conn->error, true);
+	} else if (conn->close) {
+		conn_fail(conn, -ECONNRESET, true);
+	} else if (HTTP_PARSER_ERRNO(&conn->parser) != HPE_OK) {
+		LOG_DBG("Bad response: %s", http_errno_name(
+				HTTP_PARSER_ERRNO(&conn->parser)));
+		conn_fail(conn, -EBADMSG, true);
+	}
+}
+
+/* Close the idle connections and return the time in milliseconds until
+ * the next one becomes idle.
+ */
+static int32_t conn_expire(struct http_session *session)
+{
+	int32_t next = SYS_FOREVER_MS;
+	int64_t now = k_uptime_get();
+	int64_t left;
+	int i;
+
+	if (CONFIG_HTTP_CLIENT_SESSION_IDLE_TIMEOUT == 0) {
+		return SYS_FOREVER_MS;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(session->conns); i++) {
+		struct http_session_conn *conn = &session->conns[i];
+
+		if (conn->sock < 0 || conn->count > 0) {
+			continue;
+		}
+
+		left = conn->last_activity +
+		       CONFIG_HTTP_CLIENT_SESSION_IDLE_TIMEOUT - now;
+		if (left <= 0) {
+			conn_fail(conn, 0, false);
+		} else if (next == SYS_FOREVER_MS || left < next) {
+			next = left;
+		}
+	}
+
+	return next;
+}
+
+int http_session_init(struct http_session *session,
+		      const struct sockaddr *addr, socklen_t addrlen,
+		      const char *host)
+{
+	int i;
+
+	if (!session || !addr || !host || addrlen > sizeof(session->addr)) {
+		return -EINVAL;
+	}
+
+	memset(session, 0, sizeof(*session));
+	memcpy(&session->addr, addr, addrlen);
+	session->addrlen = addrlen;
+	session->host = host;
+
+	for (i = 0; i < ARRAY_SIZE(session->conns); i++) {
+		session->conns[i].session = session;
+		session->conns[i].sock = -1;
+	}
+
+	return 0;
+}
+
+static int req_send(struct http_session *session, struct http_session_req *req)
+{
+	struct http_session_conn *conn;
+	int ret;
+
+	conn = conn_get(session, req, &ret);
+	if (!conn) {
+		return ret;
+	}
+
+	req->started = false;
+
+	ret = send_request(conn, req);
+	if (ret < 0) {
+		/* Part of the request may have been sent. A connection
+		 * closed by the server while idle is only noticed here.
+		 */
+		conn_fail(conn, ret, true);
+		if (req->retried || !req_pipelined(req)) {
+			return ret;
+		}
+
+		req->retried = true;
+		return req_send(session, req);
+	}
+
+	conn->pending[(conn->head + conn->count) %
+		      ARRAY_SIZE(conn->pending)] = req;
+	conn->count++;
+	conn->last_activity = k_uptime_get();
+
+	return 0;
+}
+
+int http_session_send(struct http_session *session,
+		      struct http_session_req *req)
+{
+	if (!session || !req || !req->url) {
+		return -EINVAL;
+	}
+
+	req->retried = false;
+
+	return req_send(session, req);
+}
+
+int http_session_process(struct http_session *session, int32_t timeout)
+{
+	struct zsock_pollfd fds[CONFIG_HTTP_CLIENT_SESSION_MAX_CONNS];
+	struct http_session_conn *conns[ARRAY_SIZE(fds)];
+	int32_t idle;
+	int nfds = 0;
+	int ret;
+	int i;
+
+	idle = conn_expire(session);
+	if (idle != SYS_FOREVER_MS &&
+	    (timeout == SYS_FOREVER_MS || idle < timeout)) {
+		timeout = idle;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(session->conns); i++) {
+		if (session->conns[i].sock < 0) {
+			continue;
+		}
+
+		conns[nfds] = &session->conns[i];
+		fds[nfds].fd = session->conns[i].sock;
+		fds[nfds].events = ZSOCK_POLLIN;
+		nfds++;
+	}
+
+	if (nfds == 0) {
+		return 0;
+	}
+
+	ret = zsock_poll(fds, nfds, timeout);
+	if (ret < 0) {
+		return -errno;
+	}
+
+	for (i = 0; i < nfds; i++) {
+		/* A connection may have been closed and reopened by a
+		 * callback of a request processed before.
+		 */
+		if (!fds[i].revents || conns[i]->sock != fds[i].fd) {
+			continue;
+		}
+
+		if (fds[i].revents & ZSOCK_POLLIN) {
+			conn_recv(conns[i]);
+		} else {
+			/* POLLERR, POLLHUP or POLLNVAL */
+			conn_fail(conns[i], -ECONNRESET, true);
+		}
+	}
+
+	return count_pending(session);
+}
+
+int http_session_wait(struct http_session *session, int32_t timeout)
+{
+	int64_t end = k_uptime_get() + timeout;
+	int32_t left = timeout;
+	int ret;
+
+	while ((ret = http_session_process(session, left)) > 0) {
+		if (timeout == SYS_FOREVER_MS) {
+			continue;
+		}
+
+		left = end - k_uptime_get();
+		if (left <= 0) {
+			return -ETIMEDOUT;
+		}
+	}
+
+	return ret;
+}
+
+void http_session_close(struct http_session *session)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(session->conns); i++) {
+		if (session->conns[i].sock >= 0) {
+			conn_fail(&session->conns[i], -ECONNABORTED, false);
+		}
+	}
+}
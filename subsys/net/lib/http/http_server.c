@@ -0,0 +1,874 @@
+/** @file
+ * @brief HTTP server API
+ *
+ * An API for applications to serve HTTP/1.1 requests
+ */
+
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_http_server, CONFIG_NET_HTTP_LOG_LEVEL);
+
+#include <kernel.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/util.h>
+
+#include <net/socket.h>
+#include <net/http_server.h>
+
+#if defined(CONFIG_FILE_SYSTEM)
+#include <fs/fs.h>
+#endif
+
+#if defined(CONFIG_FLASH_MAP)
+#include <storage/flash_map.h>
+#endif
+
+BUILD_ASSERT(CONFIG_NET_SOCKETS_POLL_MAX >= CONFIG_HTTP_SERVER_MAX_CLIENTS + 1,
+	     "CONFIG_NET_SOCKETS_POLL_MAX must cover the clients and the "
+	     "listening socket");
+
+static const char *status_str(uint16_t status)
+{
+	switch (status) {
+	case 200:
+		return "OK";
+	case 201:
+		return "Created";
+	case 204:
+		return "No Content";
+	case 400:
+		return "Bad Request";
+	case 404:
+		return "Not Found";
+	case 405:
+		return "Method Not Allowed";
+	case 413:
+		return "Payload Too Large";
+	case 414:
+		return "URI Too Long";
+	case 503:
+		return "Service Unavailable";
+	default:
+		return status < 500 ? "Error" : "Internal Server Error";
+	}
+}
+
+/* Period at which a send which made no progress is retried. The stack
+ * does not tell when buffers become available again.
+ */
+#define SEND_RETRY_MS 10
+
+static struct zsock_pollfd *conn_pollfd(struct http_server_conn *conn)
+{
+	struct http_server *server = conn->server;
+
+	return &server->fds[conn - server->conns + 1];
+}
+
+static size_t tx_pending(struct http_server_conn *conn)
+{
+	size_t len = conn->tx_left;
+	int i;
+
+	for (i = 0; i < conn->tx_msg.msg_iovlen; i++) {
+		len += conn->tx_msg.msg_iov[i].iov_len;
+	}
+
+	return len;
+}
+
+static void tx_end(struct http_server_conn *conn)
+{
+	if (conn->tx_done) {
+		conn->tx_done(conn);
+	}
+
+	conn->tx_msg.msg_iovlen = 0;
+	conn->tx_left = 0;
+	conn->tx_read = NULL;
+	conn->tx_done = NULL;
+}
+
+/* Send as much of the response as the socket takes without blocking,
+ * reading the streamed content into tx_buf as it goes. Returns 0 once the
+ * response is sent, -EAGAIN if the rest has to wait, or another negative
+ * error code.
+ */
+static int tx_send(struct http_server_conn *conn)
+{
+	size_t chunk;
+	int ret;
+
+	while (true) {
+		if (conn->tx_msg.msg_iovlen == 0) {
+			if (conn->tx_left == 0) {
+				break;
+			}
+
+			chunk = MIN(conn->tx_left, sizeof(conn->tx_buf));
+			ret = conn->tx_read(conn, conn->tx_buf, chunk);
+			if (ret < 0) {
+				return ret;
+			}
+
+			conn->tx_left -= chunk;
+			conn->tx_iov[0].iov_base = conn->tx_buf;
+			conn->tx_iov[0].iov_len = chunk;
+			conn->tx_msg.msg_iov = conn->tx_iov;
+			conn->tx_msg.msg_iovlen = 1;
+		}
+
+		if (zsock_sendmsg_all(conn->sock, &conn->tx_msg,
+				      ZSOCK_MSG_DONTWAIT) < 0) {
+			if (errno == EAGAIN || errno == ENOMEM ||
+			    errno == ENOBUFS) {
+				return -EAGAIN;
+			}
+
+			return -errno;
+		}
+	}
+
+	tx_end(conn);
+
+	return 0;
+}
+
+/* Resume the response of a connection. Whatever cannot be sent is left for
+ * the poll loop: after progress the socket is polled for POLLOUT, otherwise
+ * the send is retried after SEND_RETRY_MS. The connection is given up on
+ * when no progress is made for CONFIG_HTTP_SERVER_SEND_TIMEOUT.
+ */
+static int conn_send(struct http_server_conn *conn)
+{
+	struct zsock_pollfd *pfd = conn_pollfd(conn);
+	size_t pending = tx_pending(conn);
+	int64_t now;
+	int ret;
+
+	ret = tx_send(conn);
+	if (ret != -EAGAIN) {
+		if (ret < 0) {
+			tx_end(conn);
+		}
+
+		pfd->events = ZSOCK_POLLIN;
+		return ret;
+	}
+
+	now = k_uptime_get();
+
+	if (tx_pending(conn) < pending) {
+		conn->tx_deadline = now + CONFIG_HTTP_SERVER_SEND_TIMEOUT;
+		conn->tx_retry = 0;
+		pfd->events = ZSOCK_POLLOUT;
+	} else {
+		conn->tx_retry = now + SEND_RETRY_MS;
+		pfd->events = 0;
+	}
+
+	return 0;
+}
+
+/* Start sending the response set up in the transmit state */
+static int conn_respond(struct http_server_conn *conn)
+{
+	conn->tx_deadline = k_uptime_get() + CONFIG_HTTP_SERVER_SEND_TIMEOUT;
+
+	return conn_send(conn);
+}
+
+static bool conn_sending(struct http_server_conn *conn)
+{
+	return conn->tx_msg.msg_iovlen > 0 || conn->tx_left > 0;
+}
+
+/* Format the status line and the headers of a response into tx_buf */
+static int format_header(struct http_server_conn *conn, uint16_t status,
+			 const char *content_type, size_t len)
+{
+	char *buf = (char *)conn->tx_buf;
+	size_t size = sizeof(conn->tx_buf);
+	const char *connection = "";
+	int ret;
+
+	if (conn->close) {
+		connection = "Connection: close\r\n";
+	} else if (conn->parser.http_major == 1 &&
+		   conn->parser.http_minor == 0) {
+		connection = "Connection: keep-alive\r\n";
+	}
+
+	ret = snprintk(buf, size, "HTTP/1.1 %u %s\r\n%s%s%s"
+		       "Content-Length: %zu\r\n%s\r\n",
+		       status, status_str(status),
+		       content_type ? "Content-Type: " : "",
+		       content_type ? content_type : "",
+		       content_type ? "\r\n" : "", len, connection);
+	if (ret < 0 || ret >= size) {
+		return -ENOMEM;
+	}
+
+	return ret;
+}
+
+/* Respond with a body in memory, copied behind the header if asked to
+ * and if it fits.
+ */
+static int respond(struct http_server_conn *conn, uint16_t status,
+		   const char *content_type, const void *body, size_t len,
+		   bool copy)
+{
+	int ret;
+
+	if (conn->responded) {
+		return -EALREADY;
+	}
+
+	conn->responded = true;
+
+	ret = format_header(conn, status, content_type, len);
+	if (ret < 0) {
+		return ret;
+	}
+
+	if (conn->parser.method == HTTP_HEAD) {
+		len = 0;
+	}
+
+	if (copy && len <= sizeof(conn->tx_buf) - ret) {
+		memcpy(conn->tx_buf + ret, body, len);
+		ret += len;
+		len = 0;
+	}
+
+	conn->tx_iov[0].iov_base = conn->tx_buf;
+	conn->tx_iov[0].iov_len = ret;
+	conn->tx_iov[1].iov_base = (void *)body;
+	conn->tx_iov[1].iov_len = len;
+	conn->tx_msg.msg_iov = conn->tx_iov;
+	conn->tx_msg.msg_iovlen = len > 0 ? 2 : 1;
+
+	return conn_respond(conn);
+}
+
+int http_server_respond(struct http_server_conn *conn, uint16_t status,
+			const char *content_type, const void *body,
+			size_t len)
+{
+	return respond(conn, status, content_type, body, len, true);
+}
+
+#if defined(CONFIG_FILE_SYSTEM) || defined(CONFIG_FLASH_MAP)
+/* Send content which is not in memory. It is read into the transmit
+ * buffer of the connection, the first chunk behind the header, and sent
+ * one buffer at a time. The source is closed by tx_done once the response
+ * is sent or the connection closed.
+ */
+static int respond_stream(struct http_server_conn *conn,
+			  const char *content_type, size_t len)
+{
+	size_t chunk;
+	int pos;
+	int ret;
+
+	conn->responded = true;
+
+	pos = format_header(conn, 200, content_type, len);
+	if (pos < 0) {
+		tx_end(conn);
+		return pos;
+	}
+
+	if (conn->parser.method == HTTP_HEAD) {
+		len = 0;
+	}
+
+	chunk = MIN(len, sizeof(conn->tx_buf) - pos);
+	if (chunk > 0) {
+		ret = conn->tx_read(conn, conn->tx_buf + pos, chunk);
+		if (ret < 0) {
+			tx_end(conn);
+			return ret;
+		}
+	}
+
+	conn->tx_iov[0].iov_base = conn->tx_buf;
+	conn->tx_iov[0].iov_len = pos + chunk;
+	conn->tx_msg.msg_iov = conn->tx_iov;
+	conn->tx_msg.msg_iovlen = 1;
+	conn->tx_left = len - chunk;
+
+	ret = conn_respond(conn);
+	if (ret < 0) {
+		/* The header may be out, the connection cannot be used any
+		 * more.
+		 */
+		conn->close = true;
+	}
+
+	return ret;
+}
+#endif
+
+#if defined(CONFIG_FILE_SYSTEM)
+static int file_read(struct http_server_conn *conn, void *dst, size_t len)
+{
+	ssize_t ret;
+
+	/* The file is read sequentially */
+	ret = fs_read(&conn->src.file, dst, len);
+	if (ret < 0) {
+		return ret;
+	}
+
+	return ret == len ? 0 : -EIO;
+}
+
+static void file_done(struct http_server_conn *conn)
+{
+	(void)fs_close(&conn->src.file);
+}
+
+static int respond_file(struct http_server_conn *conn,
+			const struct http_server_route *route)
+{
+	struct fs_dirent entry;
+	int ret;
+
+	ret = fs_stat(route->file, &entry);
+	if (ret < 0 || entry.type != FS_DIR_ENTRY_FILE) {
+		return respond(conn, 404, NULL, NULL, 0, false);
+	}
+
+	ret = fs_open(&conn->src.file, route->file);
+	if (ret < 0) {
+		return ret;
+	}
+
+	conn->tx_read = file_read;
+	conn->tx_done = file_done;
+
+	return respond_stream(conn, route->content_type, entry.size);
+}
+#else
+static int respond_file(struct http_server_conn *conn,
+			const struct http_server_route *route)
+{
+	return -ENOTSUP;
+}
+#endif /* CONFIG_FILE_SYSTEM */
+
+#if defined(CONFIG_FLASH_MAP)
+static int flash_read(struct http_server_conn *conn, void *dst, size_t len)
+{
+	int ret;
+
+	ret = flash_area_read(conn->src.flash.fa, conn->src.flash.offset,
+			      dst, len);
+	if (ret < 0) {
+		return ret;
+	}
+
+	conn->src.flash.offset += len;
+
+	return 0;
+}
+
+static void flash_done(struct http_server_conn *conn)
+{
+	flash_area_close(conn->src.flash.fa);
+}
+
+static int respond_flash(struct http_server_conn *conn,
+			 const struct http_server_route *route)
+{
+	const struct flash_area *fa;
+	off_t offset = route->flash.offset;
+	size_t len = route->flash.len;
+	int ret;
+
+	ret = flash_area_open(route->flash.id, &fa);
+	if (ret < 0) {
+		return ret;
+	}
+
+	/* A length of 0 serves the rest of the area */
+	if (len == 0 && offset < fa->fa_size) {
+		len = fa->fa_size - offset;
+	}
+
+	if (offset + len > fa->fa_size) {
+		flash_area_close(fa);
+		return -EINVAL;
+	}
+
+	conn->src.flash.fa = fa;
+	conn->src.flash.offset = offset;
+	conn->tx_read = flash_read;
+	conn->tx_done = flash_done;
+
+	return respond_stream(conn, route->content_type, len);
+}
+#else
+static int respond_flash(struct http_server_conn *conn,
+			 const struct http_server_route *route)
+{
+	return -ENOTSUP;
+}
+#endif /* CONFIG_FLASH_MAP */
+
+static const struct http_server_route *find_route(struct http_server *server,
+						  const char *path,
+						  size_t len)
+{
+	const struct http_server_route *route;
+
+	for (route = server->routes;
+	     route < server->routes + server->num_routes; route++) {
+		if (strncmp(route->path, path, len) == 0 &&
+		    route->path[len] == '\0') {
+			return route;
+		}
+	}
+
+	return NULL;
+}
+
+static int handle_request(struct http_server_conn *conn)
+{
+	const struct http_server_route *route;
+	struct http_server_request req;
+	int ret;
+
+	if (conn->error) {
+		return http_server_respond(conn, conn->error, NULL, NULL, 0);
+	}
+
+	route = find_route(conn->server, conn->url, strcspn(conn->url, "?"));
+	if (!route) {
+		return http_server_respond(conn, 404, NULL, NULL, 0);
+	}
+
+	/* The mask does not cover methods the parser may add later */
+	if (conn->parser.method >= 64 ||
+	    !(route->methods & BIT64(conn->parser.method))) {
+		return http_server_respond(conn, 405, NULL, NULL, 0);
+	}
+
+	switch (route->type) {
+	case HTTP_SERVER_ROUTE_BUF:
+		/* The route content remains valid, it is not copied */
+		ret = respond(conn, 200, route->content_type,
+			      route->buf.data, route->buf.len, false);
+		break;
+	case HTTP_SERVER_ROUTE_FILE:
+		ret = respond_file(conn, route);
+		break;
+	case HTTP_SERVER_ROUTE_FLASH:
+		ret = respond_flash(conn, route);
+		break;
+	case HTTP_SERVER_ROUTE_HANDLER:
+		req.method = conn->parser.method;
+		req.url = conn->url;
+		req.url_len = conn->url_len;
+		req.body = conn->body;
+		req.body_len = conn->body_len;
+
+		ret = route->handler(conn, &req, conn->server->user_data);
+		if (ret == 0 && !conn->responded) {
+			LOG_WRN("No response to %s", log_strdup(conn->url));
+			ret = -EINVAL;
+		}
+		break;
+	default:
+		ret = -EINVAL;
+		break;
+	}
+
+	if (ret < 0 && !conn->responded) {
+		LOG_DBG("Cannot serve %s (%d)", log_strdup(conn->url), ret);
+		ret = http_server_respond(conn, 500, NULL, NULL, 0);
+	}
+
+	return ret;
+}
+
+static int on_message_begin(struct http_parser *parser)
+{
+	struct http_server_conn *conn =
+		CONTAINER_OF(parser, struct http_server_conn, parser);
+
+	conn->url_len = 0;
+	conn->url[0] = '\0';
+	conn->body_len = 0;
+	conn->error = 0;
+	conn->responded = false;
+
+	return 0;
+}
+
+static int on_url(struct http_parser *parser, const char *at, size_t length)
+{
+	struct http_server_conn *conn =
+		CONTAINER_OF(parser, struct http_server_conn, parser);
+
+	if (conn->url_len + length > CONFIG_HTTP_SERVER_MAX_URL_LENGTH) {
+		conn->error = 414;
+		return 0;
+	}
+
+	memcpy(conn->url + conn->url_len, at, length);
+	conn->url_len += length;
+	conn->url[conn->url_len] = '\0';
+
+	return 0;
+}
+
+static int on_body(struct http_parser *parser, const char *at, size_t length)
+{
+	struct http_server_conn *conn =
+		CONTAINER_OF(parser, struct http_server_conn, parser);
+
+	if (conn->body_len + length > sizeof(conn->body)) {
+		conn->error = 413;
+		return 0;
+	}
+
+	memcpy(conn->body + conn->body_len, at, length);
+	conn->body_len += length;
+
+	return 0;
+}
+
+static int on_message_complete(struct http_parser *parser)
+{
+	struct http_server_conn *conn =
+		CONTAINER_OF(parser, struct http_server_conn, parser);
+
+	conn->close = !http_should_keep_alive(parser);
+
+	/* Pipelined requests are answered as they are parsed, in order */
+	if (handle_request(conn) < 0) {
+		conn->close = true;
+	}
+
+	/* Stop parsing if the connection is to be closed */
+	if (conn->close) {
+		return 1;
+	}
+
+	/* The next request waits for the response to be sent */
+	if (conn_sending(conn)) {
+		http_parser_pause(parser, 1);
+	}
+
+	return 0;
+}
+
+static const struct http_parser_settings parser_settings = {
+	.on_message_begin = on_message_begin,
+	.on_url = on_url,
+	.on_body = on_body,
+	.on_message_complete = on_message_complete,
+};
+
+static void conn_close(struct http_server_conn *conn)
+{
+	LOG_DBG("Closing connection %d", conn->sock);
+
+	tx_end(conn);
+
+	(void)zsock_close(conn->sock);
+	conn_pollfd(conn)->fd = -1;
+	conn->sock = -1;
+}
+
+/* Resume the response of a connection once the socket can take more, and
+ * close the connection after it if asked to.
+ */
+static void conn_resume(struct http_server_conn *conn)
+{
+	if (conn_send(conn) < 0) {
+		conn_close(conn);
+		return;
+	}
+
+	if (conn_sending(conn)) {
+		return;
+	}
+
+	conn->last_activity = k_uptime_get();
+
+	if (conn->close) {
+		conn_close(conn);
+	}
+}
+
+static void conn_accept(struct http_server *server)
+{
+	static const char busy[] = "HTTP/1.1 503 Service Unavailable\r\n"
+				   "Content-Length: 0\r\n"
+				   "Connection: close\r\n\r\n";
+	struct http_server_conn *conn;
+	int sock;
+	int i;
+
+	sock = zsock_accept(server->sock, NULL, NULL);
+	if (sock < 0) {
+		LOG_DBG("Cannot accept (%d)", -errno);
+		return;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(server->conns); i++) {
+		if (server->conns[i].sock < 0) {
+			break;
+		}
+	}
+
+	if (i == ARRAY_SIZE(server->conns)) {
+		LOG_DBG("Too many connections");
+		(void)zsock_send(sock, busy, sizeof(busy) - 1,
+				 ZSOCK_MSG_DONTWAIT);
+		(void)zsock_close(sock);
+		return;
+	}
+
+	conn = &server->conns[i];
+	conn->sock = sock;
+	conn->close = false;
+	conn->last_activity = k_uptime_get();
+	http_parser_init(&conn->parser, HTTP_REQUEST);
+
+	server->fds[i + 1].fd = sock;
+	server->fds[i + 1].events = ZSOCK_POLLIN;
+}
+
+static void conn_recv(struct http_server_conn *conn)
+{
+	struct http_server *server = conn->server;
+	size_t parsed;
+	ssize_t len;
+
+	/* The data is only peeked at, as parsing stops at a request whose
+	 * response has to wait, and the requests after it are read again
+	 * once it is sent.
+	 */
+	len = zsock_recv(conn->sock, server->rx_buf, sizeof(server->rx_buf),
+			 ZSOCK_MSG_PEEK | ZSOCK_MSG_DONTWAIT);
+	if (len < 0 && errno == EAGAIN) {
+		return;
+	}
+
+	if (len <= 0) {
+		conn_close(conn);
+		return;
+	}
+
+	conn->last_activity = k_uptime_get();
+
+	parsed = http_parser_execute(&conn->parser, &parser_settings,
+				     (const char *)server->rx_buf, len);
+
+	if (conn->close) {
+		if (!conn_sending(conn)) {
+			conn_close(conn);
+		}
+
+		return;
+	}
+
+	if (HTTP_PARSER_ERRNO(&conn->parser) == HPE_PAUSED) {
+		http_parser_pause(&conn->parser, 0);
+	} else if (HTTP_PARSER_ERRNO(&conn->parser) != HPE_OK) {
+		LOG_DBG("Bad request: %s", http_errno_name(
+				HTTP_PARSER_ERRNO(&conn->parser)));
+		conn->close = true;
+		conn->responded = false;
+		if (http_server_respond(conn, 400, NULL, NULL, 0) < 0 ||
+		    !conn_sending(conn)) {
+			conn_close(conn);
+		}
+
+		return;
+	}
+
+	(void)zsock_recv(conn->sock, server->rx_buf, parsed,
+			 ZSOCK_MSG_DONTWAIT);
+}
+
+/* Run the timers of the connections: resume the sends to retry, close the
+ * connections whose send timed out or which have been idle for too long.
+ * Returns the time in milliseconds until the next timer expires.
+ */
+static int32_t conn_timers(struct http_server *server)
+{
+	int32_t next = SYS_FOREVER_MS;
+	int64_t now = k_uptime_get();
+	int64_t left;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(server->conns); i++) {
+		struct http_server_conn *conn = &server->conns[i];
+
+		if (conn->sock < 0) {
+			continue;
+		}
+
+		if (conn_sending(conn) && now >= conn->tx_deadline) {
+			LOG_DBG("Send timeout on %d", conn->sock);
+			conn_close(conn);
+			continue;
+		}
+
+		if (conn_sending(conn) && conn->tx_retry != 0 &&
+		    now >= conn->tx_retry) {
+			conn_resume(conn);
+			if (conn->sock < 0) {
+				continue;
+			}
+		}
+
+		if (conn_sending(conn)) {
+			left = (conn->tx_retry != 0 ? conn->tx_retry :
+				conn->tx_deadline) - now;
+		} else if (CONFIG_HTTP_SERVER_IDLE_TIMEOUT == 0) {
+			continue;
+		} else {
+			left = conn->last_activity +
+			       CONFIG_HTTP_SERVER_IDLE_TIMEOUT - now;
+			if (left <= 0) {
+				LOG_DBG("Connection %d idle", conn->sock);
+				conn_close(conn);
+				continue;
+			}
+		}
+
+		left = MAX(left, 0);
+		if (next == SYS_FOREVER_MS || left < next) {
+			next = left;
+		}
+	}
+
+	return next;
+}
+
+int http_server_init(struct http_server *server, const struct sockaddr *addr,
+		     socklen_t addrlen, const struct http_server_route *routes,
+		     size_t num_routes, void *user_data)
+{
+	int ret;
+	int i;
+
+	if (!server || !addr || (!routes && num_routes > 0)) {
+		return -EINVAL;
+	}
+
+	memset(server, 0, sizeof(*server));
+	server->routes = routes;
+	server->num_routes = num_routes;
+	server->user_data = user_data;
+
+	for (i = 0; i < ARRAY_SIZE(server->conns); i++) {
+		server->conns[i].server = server;
+		server->conns[i].sock = -1;
+		server->fds[i + 1].fd = -1;
+	}
+
+	server->sock = zsock_socket(addr->sa_family, SOCK_STREAM, IPPROTO_TCP);
+	if (server->sock < 0) {
+		return -errno;
+	}
+
+	if (zsock_bind(server->sock, addr, addrlen) < 0 ||
+	    zsock_listen(server->sock, CONFIG_HTTP_SERVER_MAX_CLIENTS) < 0) {
+		ret = -errno;
+		(void)zsock_close(server->sock);
+		server->sock = -1;
+		return ret;
+	}
+
+	server->fds[0].fd = server->sock;
+	server->fds[0].events = ZSOCK_POLLIN;
+
+	return 0;
+}
+
+int http_server_process(struct http_server *server, int32_t timeout)
+{
+	int32_t next;
+	int ret;
+	int i;
+
+	if (server->sock < 0) {
+		return -EBADF;
+	}
+
+	next = conn_timers(server);
+	if (next != SYS_FOREVER_MS &&
+	    (timeout == SYS_FOREVER_MS || next < timeout)) {
+		timeout = next;
+	}
+
+	ret = zsock_poll(server->fds, ARRAY_SIZE(server->fds), timeout);
+	if (ret < 0) {
+		return -errno;
+	}
+
+	if (server->fds[0].revents & ZSOCK_POLLIN) {
+		conn_accept(server);
+	}
+
+	for (i = 0; i < ARRAY_SIZE(server->conns); i++) {
+		struct zsock_pollfd *pfd = &server->fds[i + 1];
+
+		if (pfd->fd < 0 || !pfd->revents) {
+			continue;
+		}
+
+		if (pfd->revents & ZSOCK_POLLIN) {
+			conn_recv(&server->conns[i]);
+		} else if (pfd->revents & ZSOCK_POLLOUT) {
+			conn_resume(&server->conns[i]);
+		} else {
+			/* POLLERR, POLLHUP or POLLNVAL */
+			conn_close(&server->conns[i]);
+		}
+	}
+
+	return 0;
+}
+
+int http_server_run(struct http_server *server)
+{
+	int ret;
+
+	do {
+		ret = http_server_process(server, SYS_FOREVER_MS);
+	} while (ret == 0);
+
+	return ret;
+}
+
+void http_server_close(struct http_server *server)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(server->conns); i++) {
+		if (server->conns[i].sock >= 0) {
+			conn_close(&server->conns[i]);
+		}
+	}
+
+	if (server->sock >= 0) {
+		(void)zsock_close(server->sock);
+		server->sock = -1;
+		server->fds[0].fd = -1;
+	}
+}
@@ -44,6 +44,12 @@ LOG_MODULE_REGISTER(LOG_MODULE_NAME);
 #ifdef CONFIG_LWM2M_RW_JSON_SUPPORT
 #include "lwm2m_rw_json.h"
 #endif
+#ifdef CONFIG_LWM2M_RW_CBOR_SUPPORT
+#include "lwm2m_rw_cbor.h"
+#endif
+#ifdef CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT
+#include "lwm2m_rw_senml_cbor.h"
+#endif
 #ifdef CONFIG_LWM2M_RD_CLIENT_SUPPORT
 #include "lwm2m_rd_client.h"
 #endif
@@ -82,15 +88,19 @@ LOG_MODULE_REGISTER(LOG_MODULE_NAME);
 
 struct observe_node {
 	sys_snode_t node;
+	sys_snode_t index_node;
 	struct lwm2m_ctx *ctx;
 	struct lwm2m_obj_path path;
 	uint8_t  token[MAX_TOKEN_LEN];
 	int64_t event_timestamp;
 	int64_t last_timestamp;
+	/* time of the next notification, the key of the observer heap */
+	int64_t due_timestamp;
 	uint32_t min_period_sec;
 	uint32_t max_period_sec;
 	uint32_t counter;
 	uint16_t format;
+	uint16_t heap_index;
 	uint8_t  tkl;
 };
 
@@ -122,6 +132,20 @@ static sys_slist_t engine_obj_inst_list;
 static sys_slist_t engine_observer_list;
 static sys_slist_t engine_service_list;
 
+/* Hash indexes over the lists above, so that lookups by path only scan
+ * the entries sharing a bucket.
+ */
+#define INDEX_SIZE CONFIG_LWM2M_ENGINE_INDEX_SIZE
+
+static sys_slist_t engine_obj_index[INDEX_SIZE];
+static sys_slist_t engine_obj_inst_index[INDEX_SIZE];
+static sys_slist_t engine_observer_index[INDEX_SIZE];
+
+/* Observers ordered by the time of their next notification */
+static struct observe_node *observe_heap[CONFIG_LWM2M_ENGINE_MAX_OBSERVER];
+static uint16_t observe_heap_len;
+static struct k_spinlock observe_lock;
+
 static K_THREAD_STACK_DEFINE(engine_thread_stack,
 			      CONFIG_LWM2M_ENGINE_STACK_SIZE);
 static struct k_thread engine_thread_data;
@@ -361,19 +385,154 @@ static void clear_attrs(void *ref)
 	}
 }
 
+/* engine indexes */
+
+static inline uint32_t index_hash(uint16_t obj_id, uint16_t obj_inst_id)
+{
+	return ((uint32_t)obj_id * 31U + obj_inst_id) % INDEX_SIZE;
+}
+
+static inline sys_slist_t *obj_inst_bucket(uint16_t obj_id,
+					   uint16_t obj_inst_id)
+{
+	return &engine_obj_inst_index[index_hash(obj_id, obj_inst_id)];
+}
+
+static inline sys_slist_t *observer_bucket(const struct lwm2m_obj_path *path)
+{
+	return &engine_observer_index[index_hash(path->obj_id,
+						 path->obj_inst_id)];
+}
+
+/* observer scheduling, called with observe_lock held */
+
+static int64_t observe_due_timestamp(const struct observe_node *obs)
+{
+	/* manual notify once min_period_sec has passed */
+	if (obs->event_timestamp > obs->last_timestamp) {
+		return obs->last_timestamp +
+		       MSEC_PER_SEC * obs->min_period_sec;
+	}
+
+	/* without a max period, notify on every engine update */
+	if (obs->max_period_sec == 0U) {
+		return obs->last_timestamp + ENGINE_UPDATE_INTERVAL_MS;
+	}
+
+	return obs->last_timestamp + MSEC_PER_SEC * obs->max_period_sec;
+}
+
+static void observe_heap_set(uint16_t i, struct observe_node *obs)
+{
+	observe_heap[i] = obs;
+	obs->heap_index = i + 1U;
+}
+
+static void observe_heap_sift(uint16_t i)
+{
+	struct observe_node *obs = observe_heap[i];
+	uint16_t child;
+
+	while (i > 0U &&
+	       observe_heap[(i - 1U) / 2U]->due_timestamp >
+	       obs->due_timestamp) {
+		observe_heap_set(i, observe_heap[(i - 1U) / 2U]);
+		i = (i - 1U) / 2U;
+	}
+
+	while (2U * i + 1U < observe_heap_len) {
+		child = 2U * i + 1U;
+		if (child + 1U < observe_heap_len &&
+		    observe_heap[child + 1U]->due_timestamp <
+		    observe_heap[child]->due_timestamp) {
+			child++;
+		}
+
+		if (observe_heap[child]->due_timestamp >=
+		    obs->due_timestamp) {
+			break;
+		}
+
+		observe_heap_set(i, observe_heap[child]);
+		i = child;
+	}
+
+	observe_heap_set(i, obs);
+}
+
+static void observe_schedule(struct observe_node *obs)
+{
+	obs->due_timestamp = observe_due_timestamp(obs);
+
+	if (obs->heap_index == 0U) {
+		observe_heap_set(observe_heap_len++, obs);
+	}
+
+	observe_heap_sift(obs->heap_index - 1U);
+}
+
+static void observe_unschedule(struct observe_node *obs)
+{
+	uint16_t i;
+
+	if (obs->heap_index == 0U) {
+		return;
+	}
+
+	i = obs->heap_index - 1U;
+	obs->heap_index = 0U;
+	if (i < --observe_heap_len) {
+		observe_heap_set(i, observe_heap[observe_heap_len]);
+		observe_heap_sift(i);
+	}
+}
+
+static void observer_link(struct observe_node *obs)
+{
+	k_spinlock_key_t key = k_spin_lock(&observe_lock);
+
+	sys_slist_append(&engine_observer_list, &obs->node);
+	sys_slist_append(observer_bucket(&obs->path), &obs->index_node);
+	observe_schedule(obs);
+
+	k_spin_unlock(&observe_lock, key);
+}
+
+static void observer_unlink(struct observe_node *obs, sys_snode_t *prev_node)
+{
+	k_spinlock_key_t key = k_spin_lock(&observe_lock);
+
+	observe_unschedule(obs);
+	sys_slist_find_and_remove(observer_bucket(&obs->path),
+				  &obs->index_node);
+	sys_slist_remove(&engine_observer_list, prev_node, &obs->node);
+	(void)memset(obs, 0, sizeof(*obs));
+
+	k_spin_unlock(&observe_lock, key);
+}
+
 int lwm2m_notify_observer(uint16_t obj_id, uint16_t obj_inst_id, uint16_t res_id)
 {
+	struct lwm2m_obj_path path = {
+		.obj_id = obj_id,
+		.obj_inst_id = obj_inst_id,
+	};
 	struct observe_node *obs;
+	k_spinlock_key_t key;
 	int ret = 0;
 
+	key = k_spin_lock(&observe_lock);
+
 	/* look for observers which match our resource */
-	SYS_SLIST_FOR_EACH_CONTAINER(&engine_observer_list, obs, node) {
+	SYS_SLIST_FOR_EACH_CONTAINER(observer_bucket(&path), obs,
+				     index_node) {
 		if (obs->path.obj_id == obj_id &&
 		    obs->path.obj_inst_id == obj_inst_id &&
 		    (obs->path.level < 3 ||
 		     obs->path.res_id == res_id)) {
 			/* update the event time for this observer */
 			obs->event_timestamp = k_uptime_get();
+			observe_schedule(obs);
 
 			LOG_DBG("NOTIFY EVENT %u/%u/%u",
 				obj_id, obj_inst_id, res_id);
@@ -382,6 +541,8 @@ int lwm2m_notify_observer(uint16_t obj_id, uint16_t obj_inst_id, uint16_t res_id
 		}
 	}
 
+	k_spin_unlock(&observe_lock, key);
+
 	return ret;
 }
 
@@ -422,7 +583,8 @@ static int engine_add_observer(struct lwm2m_message *msg,
 	/* TODO: observe dup checking */
 
 	/* make sure this observer doesn't exist already */
-	SYS_SLIST_FOR_EACH_CONTAINER(&engine_observer_list, obs, node) {
+	SYS_SLIST_FOR_EACH_CONTAINER(observer_bucket(&msg->path), obs,
+				     index_node) {
 		/* TODO: distinguish server object */
 		if (obs->ctx == msg->ctx &&
 		    memcmp(&obs->path, &msg->path, sizeof(msg->path)) == 0) {
@@ -528,8 +690,7 @@ static int engine_add_observer(struct lwm2m_message *msg,
 	observe_node_data[i].max_period_sec = MAX(attrs.pmax, attrs.pmin);
 	observe_node_data[i].format = format;
 	observe_node_data[i].counter = 1U;
-	sys_slist_append(&engine_observer_list,
-			 &observe_node_data[i].node);
+	observer_link(&observe_node_data[i]);
 
 	LOG_DBG("OBSERVER ADDED %u/%u/%u(%u) token:'%s' addr:%s",
 		msg->path.obj_id, msg->path.obj_inst_id,
@@ -565,8 +726,7 @@ static int engine_remove_observer(const uint8_t *token, uint8_t tkl)
 		return -ENOENT;
 	}
 
-	sys_slist_remove(&engine_observer_list, prev_node, &found_obj->node);
-	(void)memset(found_obj, 0, sizeof(*found_obj));
+	observer_unlink(found_obj, prev_node);
 
 	LOG_DBG("observer '%s' removed", log_strdup(sprint_token(token, tkl)));
 
@@ -587,8 +747,7 @@ static void engine_remove_observer_by_id(uint16_t obj_id, int32_t obj_inst_id)
 			continue;
 		}
 
-		sys_slist_remove(&engine_observer_list, prev_node, &obs->node);
-		(void)memset(obs, 0, sizeof(*obs));
+		observer_unlink(obs, prev_node);
 	}
 }
 
@@ -597,11 +756,15 @@ static void engine_remove_observer_by_id(uint16_t obj_id, int32_t obj_inst_id)
 void lwm2m_register_obj(struct lwm2m_engine_obj *obj)
 {
 	sys_slist_append(&engine_obj_list, &obj->node);
+	sys_slist_append(&engine_obj_index[obj->obj_id % INDEX_SIZE],
+			 &obj->index_node);
 }
 
 void lwm2m_unregister_obj(struct lwm2m_engine_obj *obj)
 {
 	engine_remove_observer_by_id(obj->obj_id, -1);
+	sys_slist_find_and_remove(&engine_obj_index[obj->obj_id % INDEX_SIZE],
+				  &obj->index_node);
 	sys_slist_find_and_remove(&engine_obj_list, &obj->node);
 }
 
@@ -609,7 +772,12 @@ static struct lwm2m_engine_obj *get_engine_obj(int obj_id)
 {
 	struct lwm2m_engine_obj *obj;
 
-	SYS_SLIST_FOR_EACH_CONTAINER(&engine_obj_list, obj, node) {
+	if (obj_id < 0 || obj_id > UINT16_MAX) {
+		return NULL;
+	}
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&engine_obj_index[obj_id % INDEX_SIZE],
+				     obj, index_node) {
 		if (obj->obj_id == obj_id) {
 			return obj;
 		}
@@ -624,6 +792,12 @@ lwm2m_get_engine_obj_field(struct lwm2m_engine_obj *obj, int res_id)
 	int i;
 
 	if (obj && obj->fields && obj->field_count > 0) {
+		/* fields are usually declared in resource ID order */
+		if (res_id >= 0 && res_id < obj->field_count &&
+		    obj->fields[res_id].res_id == res_id) {
+			return &obj->fields[res_id];
+		}
+
 		for (i = 0; i < obj->field_count; i++) {
 			if (obj->fields[i].res_id == res_id) {
 				return &obj->fields[i];
@@ -639,12 +813,18 @@ lwm2m_get_engine_obj_field(struct lwm2m_engine_obj *obj, int res_id)
 static void engine_register_obj_inst(struct lwm2m_engine_obj_inst *obj_inst)
 {
 	sys_slist_append(&engine_obj_inst_list, &obj_inst->node);
+	sys_slist_append(obj_inst_bucket(obj_inst->obj->obj_id,
+					 obj_inst->obj_inst_id),
+			 &obj_inst->index_node);
 }
 
 static void engine_unregister_obj_inst(struct lwm2m_engine_obj_inst *obj_inst)
 {
 	engine_remove_observer_by_id(
 			obj_inst->obj->obj_id, obj_inst->obj_inst_id);
+	sys_slist_find_and_remove(obj_inst_bucket(obj_inst->obj->obj_id,
+						  obj_inst->obj_inst_id),
+				  &obj_inst->index_node);
 	sys_slist_find_and_remove(&engine_obj_inst_list, &obj_inst->node);
 }
 
@@ -653,8 +833,13 @@ static struct lwm2m_engine_obj_inst *get_engine_obj_inst(int obj_id,
 {
 	struct lwm2m_engine_obj_inst *obj_inst;
 
-	SYS_SLIST_FOR_EACH_CONTAINER(&engine_obj_inst_list, obj_inst,
-				     node) {
+	if (obj_id < 0 || obj_id > UINT16_MAX ||
+	    obj_inst_id < 0 || obj_inst_id > UINT16_MAX) {
+		return NULL;
+	}
+
+	SYS_SLIST_FOR_EACH_CONTAINER(obj_inst_bucket(obj_id, obj_inst_id),
+				     obj_inst, index_node) {
 		if (obj_inst->obj->obj_id == obj_id &&
 		    obj_inst->obj_inst_id == obj_inst_id) {
 			return obj_inst;
@@ -1122,6 +1307,18 @@ static int select_writer(struct lwm2m_output_context *out, uint16_t accept)
 		break;
 #endif
 
+#ifdef CONFIG_LWM2M_RW_CBOR_SUPPORT
+	case LWM2M_FORMAT_APP_CBOR:
+		out->writer = &cbor_writer;
+		break;
+#endif
+
+#ifdef CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT
+	case LWM2M_FORMAT_APP_SENML_CBOR:
+		out->writer = &senml_cbor_writer;
+		break;
+#endif
+
 	default:
 		LOG_WRN("Unknown content type %u", accept);
 		return -ENOMSG;
@@ -1153,6 +1350,15 @@ static int select_reader(struct lwm2m_input_context *in, uint16_t format)
 		break;
 #endif
 
+#ifdef CONFIG_LWM2M_RW_CBOR_SUPPORT
+	case LWM2M_FORMAT_APP_CBOR:
+#ifdef CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT
+	case LWM2M_FORMAT_APP_SENML_CBOR:
+#endif
+		in->reader = &cbor_reader;
+		break;
+#endif
+
 	default:
 		LOG_WRN("Unknown content type %u", format);
 		return -ENOMSG;
@@ -1262,10 +1468,15 @@ static int path_to_objs(const struct lwm2m_obj_path *path,
 		return -ENOENT;
 	}
 
-	for (i = 0; i < oi->resource_count; i++) {
+	/* resources are usually initialized in resource ID order */
+	if (path->res_id < oi->resource_count &&
+	    oi->resources[path->res_id].res_id == path->res_id) {
+		r = &oi->resources[path->res_id];
+	}
+
+	for (i = 0; !r && i < oi->resource_count; i++) {
 		if (oi->resources[i].res_id == path->res_id) {
 			r = &oi->resources[i];
-			break;
 		}
 	}
 
@@ -2395,14 +2606,21 @@ int lwm2m_write_handler(struct lwm2m_engine_obj_inst *obj_inst,
 			break;
 
 		case LWM2M_RES_TYPE_FLOAT32:
-			engine_get_float32fix(&msg->in,
-					      (float32_value_t *)data_ptr);
+			/* the value may not fit in fixed point */
+			if (engine_get_float32fix(&msg->in,
+					(float32_value_t *)data_ptr) == 0) {
+				return -EINVAL;
+			}
+
 			len = sizeof(float32_value_t);
 			break;
 
 		case LWM2M_RES_TYPE_FLOAT64:
-			engine_get_float64fix(&msg->in,
-					      (float64_value_t *)data_ptr);
+			if (engine_get_float64fix(&msg->in,
+					(float64_value_t *)data_ptr) == 0) {
+				return -EINVAL;
+			}
+
 			len = sizeof(float64_value_t);
 			break;
 
@@ -2447,6 +2665,7 @@ static int lwm2m_write_attr_handler(struct lwm2m_engine_obj *obj,
 	struct lwm2m_attr *attr;
 	struct notification_attrs nattrs = { 0 };
 	struct observe_node *obs;
+	k_spinlock_key_t key;
 	uint8_t type = 0U;
 	void *nattr_ptrs[NR_LWM2M_ATTR] = {
 		&nattrs.pmin, &nattrs.pmax, &nattrs.gt, &nattrs.lt, &nattrs.st
@@ -2762,8 +2981,11 @@ static int lwm2m_write_attr_handler(struct lwm2m_engine_obj *obj,
 			obs->path.res_id, obs->path.level,
 			obs->min_period_sec, obs->max_period_sec,
 			nattrs.pmin, MAX(nattrs.pmin, nattrs.pmax));
+		key = k_spin_lock(&observe_lock);
 		obs->min_period_sec = (uint32_t)nattrs.pmin;
 		obs->max_period_sec = (uint32_t)MAX(nattrs.pmin, nattrs.pmax);
+		observe_schedule(obs);
+		k_spin_unlock(&observe_lock, key);
 		(void)memset(&nattrs, 0, sizeof(nattrs));
 	}
 
@@ -2830,6 +3052,16 @@ static int do_read_op(struct lwm2m_message *msg, uint16_t content_format)
 		return do_read_op_json(msg, content_format);
 #endif
 
+#if defined(CONFIG_LWM2M_RW_CBOR_SUPPORT)
+	case LWM2M_FORMAT_APP_CBOR:
+		return do_read_op_cbor(msg, content_format);
+#endif
+
+#if defined(CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT)
+	case LWM2M_FORMAT_APP_SENML_CBOR:
+		return do_read_op_senml_cbor(msg, content_format);
+#endif
+
 	default:
 		LOG_ERR("Unsupported content-format: %u", content_format);
 		return -ENOMSG;
@@ -2843,7 +3075,7 @@ int lwm2m_perform_read_op(struct lwm2m_message *msg, uint16_t content_format)
 	struct lwm2m_engine_res *res = NULL;
 	struct lwm2m_engine_obj_field *obj_field;
 	struct lwm2m_obj_path temp_path;
-	int ret = 0, index;
+	int ret = 0, index, end;
 	uint8_t num_read = 0U;
 
 	if (msg->path.level >= 2U) {
@@ -2957,11 +3189,16 @@ move_forward:
 		}
 	}
 
-	engine_put_end(&msg->out, &msg->path);
+	end = engine_put_end(&msg->out, &msg->path);
 
 	/* restore original path values */
 	memcpy(&msg->path, &temp_path, sizeof(temp_path));
 
+	if (end < 0) {
+		LOG_ERR("Error closing the payload: %d", end);
+		return end;
+	}
+
 	/* did not read anything even if we should have - on single item */
 	if (ret == 0 && num_read == 0U && msg->path.level == 3U) {
 		return -ENOENT;
@@ -3233,6 +3470,17 @@ static int do_write_op(struct lwm2m_message *msg,
 		return do_write_op_json(msg);
 #endif
 
+#ifdef CONFIG_LWM2M_RW_CBOR_SUPPORT
+	/* a single resource, read with the CBOR reader */
+	case LWM2M_FORMAT_APP_CBOR:
+		return do_write_op_plain_text(msg);
+#endif
+
+#ifdef CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT
+	case LWM2M_FORMAT_APP_SENML_CBOR:
+		return do_write_op_senml_cbor(msg);
+#endif
+
 	default:
 		LOG_ERR("Unsupported format: %u", format);
 		return -ENOMSG;
@@ -3962,36 +4210,36 @@ static int lwm2m_engine_service(void)
 	struct observe_node *obs;
 	struct service_node *srv;
 	int64_t timestamp, service_due_timestamp;
+	k_spinlock_key_t key;
+	int32_t timeout;
+	bool manual;
 
 	/*
-	 * 1. scan the observer list
-	 * 2. For each notify event found, scan the observer list
-	 * 3. For each observer match, generate a NOTIFY message,
-	 *    attaching the notify response handler
+	 * Pop the observers which are due from the observer heap, and
+	 * generate a NOTIFY message for each of them, attaching the notify
+	 * response handler:
+	 * - manual notify once event_timestamp > last_timestamp and
+	 *   min_period_sec has passed
+	 * - automatic time-based notify once max_period_sec has passed
 	 */
 	timestamp = k_uptime_get();
-	SYS_SLIST_FOR_EACH_CONTAINER(&engine_observer_list, obs, node) {
-		/*
-		 * manual notify requirements:
-		 * - event_timestamp > last_timestamp
-		 * - current timestamp > last_timestamp + min_period_sec
-		 */
-		if (obs->event_timestamp > obs->last_timestamp &&
-		    timestamp > obs->last_timestamp +
-				MSEC_PER_SEC * obs->min_period_sec) {
-			obs->last_timestamp = k_uptime_get();
-			generate_notify_message(obs, true);
+	while (true) {
+		key = k_spin_lock(&observe_lock);
 
-		/*
-		 * automatic time-based notify requirements:
-		 * - current timestamp > last_timestamp + max_period_sec
-		 */
-		} else if (timestamp > obs->last_timestamp +
-				MSEC_PER_SEC * obs->max_period_sec) {
-			obs->last_timestamp = k_uptime_get();
-			generate_notify_message(obs, false);
+		if (observe_heap_len == 0U ||
+		    observe_heap[0]->due_timestamp > timestamp) {
+			k_spin_unlock(&observe_lock, key);
+			break;
 		}
 
+		obs = observe_heap[0];
+		manual = obs->event_timestamp > obs->last_timestamp;
+		obs->last_timestamp = k_uptime_get();
+		observe_schedule(obs);
+
+		k_spin_unlock(&observe_lock, key);
+
+		generate_notify_message(obs, manual);
 	}
 
 	timestamp = k_uptime_get();
@@ -4005,8 +4253,21 @@ static int lwm2m_engine_service(void)
 		}
 	}
 
-	/* calculate how long to sleep till the next service */
-	return engine_next_service_timeout_ms(ENGINE_UPDATE_INTERVAL_MS);
+	/* calculate how long to sleep till the next service or notify */
+	timeout = engine_next_service_timeout_ms(ENGINE_UPDATE_INTERVAL_MS);
+
+	key = k_spin_lock(&observe_lock);
+
+	if (observe_heap_len > 0U) {
+		timestamp = observe_heap[0]->due_timestamp - k_uptime_get();
+		if (timestamp < timeout) {
+			timeout = MAX(timestamp, 0);
+		}
+	}
+
+	k_spin_unlock(&observe_lock, key);
+
+	return timeout;
 }
 
 int lwm2m_engine_context_close(struct lwm2m_ctx *client_ctx)
@@ -4024,9 +4285,7 @@ int lwm2m_engine_context_close(struct lwm2m_ctx *client_ctx)
 	SYS_SLIST_FOR_EACH_CONTAINER_SAFE(&engine_observer_list,
 					  obs, tmp, node) {
 		if (obs->ctx == client_ctx) {
-			sys_slist_remove(&engine_observer_list, prev_node,
-					 &obs->node);
-			(void)memset(obs, 0, sizeof(*obs));
+			observer_unlink(obs, prev_node);
 		} else {
 			prev_node = &obs->node;
 		}
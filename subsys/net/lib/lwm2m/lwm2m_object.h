@@ -177,6 +177,9 @@ struct lwm2m_engine_obj {
 	/* object list */
 	sys_snode_t node;
 
+	/* object index bucket */
+	sys_snode_t index_node;
+
 	/* object field definitions */
 	struct lwm2m_engine_obj_field *fields;
 
@@ -343,6 +346,9 @@ struct lwm2m_engine_obj_inst {
 	/* instance list */
 	sys_snode_t node;
 
+	/* instance index bucket */
+	sys_snode_t index_node;
+
 	struct lwm2m_engine_obj *obj;
 	struct lwm2m_engine_res *resources;
 
@@ -430,8 +436,8 @@ struct lwm2m_message {
 struct lwm2m_writer {
 	size_t (*put_begin)(struct lwm2m_output_context *out,
 			    struct lwm2m_obj_path *path);
-	size_t (*put_end)(struct lwm2m_output_context *out,
-			  struct lwm2m_obj_path *path);
+	int (*put_end)(struct lwm2m_output_context *out,
+		       struct lwm2m_obj_path *path);
 	size_t (*put_begin_oi)(struct lwm2m_output_context *out,
 			       struct lwm2m_obj_path *path);
 	size_t (*put_end_oi)(struct lwm2m_output_context *out,
@@ -543,8 +549,8 @@ static inline size_t engine_put_begin(struct lwm2m_output_context *out,
 	return 0;
 }
 
-static inline size_t engine_put_end(struct lwm2m_output_context *out,
-				    struct lwm2m_obj_path *path)
+static inline int engine_put_end(struct lwm2m_output_context *out,
+				 struct lwm2m_obj_path *path)
 {
 	if (out->writer->put_end) {
 		return out->writer->put_end(out, path);
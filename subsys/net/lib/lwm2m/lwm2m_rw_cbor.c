@@ -0,0 +1,650 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * CBOR content format (application/cbor), which carries the value of a
+ * single resource. The encoding and decoding helpers are shared with the
+ * SenML CBOR format.
+ */
+
+#define LOG_MODULE_NAME net_lwm2m_cbor
+#define LOG_LEVEL CONFIG_LWM2M_LOG_LEVEL
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(LOG_MODULE_NAME);
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/byteorder.h>
+
+#include "lwm2m_object.h"
+#include "lwm2m_rw_cbor.h"
+#include "lwm2m_engine.h"
+
+/* simple values, and floats sharing their major type */
+#define CBOR_FALSE		20
+#define CBOR_TRUE		21
+
+#define CBOR_BUF_READ(cpkt)	(cpkt)->data, (cpkt)->offset
+
+/* Fixed point values keep the sign in val1, or in val2 when val1 is 0 */
+static double fix_to_double(int64_t val1, int64_t val2, double scale)
+{
+	double frac = (double)(val2 < 0 ? -val2 : val2) / scale;
+
+	if (val1 < 0 || (val1 == 0 && val2 < 0)) {
+		return (double)val1 - frac;
+	}
+
+	return (double)val1 + frac;
+}
+
+size_t cbor_put_head(struct lwm2m_output_context *out, uint8_t major,
+		     uint64_t value)
+{
+	uint8_t buf[9];
+	uint16_t len;
+
+	if (value < CBOR_AI_UINT8) {
+		buf[0] = CBOR_HEAD(major, value);
+		len = 1U;
+	} else if (value <= UINT8_MAX) {
+		buf[0] = CBOR_HEAD(major, CBOR_AI_UINT8);
+		buf[1] = value;
+		len = 2U;
+	} else if (value <= UINT16_MAX) {
+		buf[0] = CBOR_HEAD(major, CBOR_AI_UINT16);
+		sys_put_be16(value, &buf[1]);
+		len = 3U;
+	} else if (value <= UINT32_MAX) {
+		buf[0] = CBOR_HEAD(major, CBOR_AI_UINT32);
+		sys_put_be32(value, &buf[1]);
+		len = 5U;
+	} else {
+		buf[0] = CBOR_HEAD(major, CBOR_AI_UINT64);
+		sys_put_be64(value, &buf[1]);
+		len = 9U;
+	}
+
+	if (buf_append(CPKT_BUF_WRITE(out->out_cpkt), buf, len) < 0) {
+		return 0;
+	}
+
+	return len;
+}
+
+size_t cbor_put_int(struct lwm2m_output_context *out, int64_t value)
+{
+	if (value < 0) {
+		return cbor_put_head(out, CBOR_MAJOR_NINT,
+				     (uint64_t)(-(value + 1)));
+	}
+
+	return cbor_put_head(out, CBOR_MAJOR_UINT, (uint64_t)value);
+}
+
+size_t cbor_put_data(struct lwm2m_output_context *out, uint8_t major,
+		     const void *buf, size_t buflen)
+{
+	size_t len;
+
+	len = cbor_put_head(out, major, buflen);
+	if (len == 0) {
+		return 0;
+	}
+
+	if (buf_append(CPKT_BUF_WRITE(out->out_cpkt), (uint8_t *)buf,
+		       buflen) < 0) {
+		return 0;
+	}
+
+	return len + buflen;
+}
+
+/* Floats are sent in single precision when that is exact */
+static size_t put_double(struct lwm2m_output_context *out, double value)
+{
+	float single = (float)value;
+	uint8_t buf[9];
+	uint16_t len;
+	uint64_t u64;
+	uint32_t u32;
+
+	if ((double)single == value) {
+		memcpy(&u32, &single, sizeof(u32));
+		buf[0] = CBOR_HEAD(CBOR_MAJOR_SIMPLE, CBOR_AI_UINT32);
+		sys_put_be32(u32, &buf[1]);
+		len = 5U;
+	} else {
+		memcpy(&u64, &value, sizeof(u64));
+		buf[0] = CBOR_HEAD(CBOR_MAJOR_SIMPLE, CBOR_AI_UINT64);
+		sys_put_be64(u64, &buf[1]);
+		len = 9U;
+	}
+
+	if (buf_append(CPKT_BUF_WRITE(out->out_cpkt), buf, len) < 0) {
+		return 0;
+	}
+
+	return len;
+}
+
+static size_t put_s32(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path, int32_t value)
+{
+	return cbor_put_int(out, value);
+}
+
+static size_t put_s16(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path, int16_t value)
+{
+	return cbor_put_int(out, value);
+}
+
+static size_t put_s8(struct lwm2m_output_context *out,
+		     struct lwm2m_obj_path *path, int8_t value)
+{
+	return cbor_put_int(out, value);
+}
+
+static size_t put_s64(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path, int64_t value)
+{
+	return cbor_put_int(out, value);
+}
+
+static size_t put_string(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path,
+			 char *buf, size_t buflen)
+{
+	return cbor_put_data(out, CBOR_MAJOR_TSTR, buf, buflen);
+}
+
+static size_t put_float32fix(struct lwm2m_output_context *out,
+			     struct lwm2m_obj_path *path,
+			     float32_value_t *value)
+{
+	return put_double(out, fix_to_double(value->val1, value->val2,
+					     LWM2M_FLOAT32_DEC_MAX));
+}
+
+static size_t put_float64fix(struct lwm2m_output_context *out,
+			     struct lwm2m_obj_path *path,
+			     float64_value_t *value)
+{
+	return put_double(out, fix_to_double(value->val1, value->val2,
+					     LWM2M_FLOAT64_DEC_MAX));
+}
+
+static size_t put_bool(struct lwm2m_output_context *out,
+		       struct lwm2m_obj_path *path,
+		       bool value)
+{
+	return cbor_put_head(out, CBOR_MAJOR_SIMPLE,
+			     value ? CBOR_TRUE : CBOR_FALSE);
+}
+
+static size_t put_opaque(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path,
+			 char *buf, size_t buflen)
+{
+	return cbor_put_data(out, CBOR_MAJOR_BSTR, buf, buflen);
+}
+
+static size_t put_objlnk(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path,
+			 struct lwm2m_objlnk *value)
+{
+	char buf[sizeof("65535:65535")];
+	int len;
+
+	len = snprintk(buf, sizeof(buf), "%u:%u", value->obj_id,
+		       value->obj_inst);
+	if (len < 0) {
+		return 0;
+	}
+
+	return cbor_put_data(out, CBOR_MAJOR_TSTR, buf, len);
+}
+
+int cbor_get_head(struct lwm2m_input_context *in, uint8_t *major,
+		  uint64_t *value)
+{
+	uint8_t buf[8];
+	uint8_t head;
+	uint16_t len;
+
+	if (buf_read_u8(&head, CBOR_BUF_READ(in->in_cpkt), &in->offset) < 0) {
+		return -EINVAL;
+	}
+
+	*major = head >> 5;
+	head &= 0x1f;
+
+	if (head < CBOR_AI_UINT8) {
+		*value = head;
+		return 0;
+	}
+
+	if (head > CBOR_AI_UINT64) {
+		/* indefinite lengths are not supported */
+		return -EINVAL;
+	}
+
+	len = 1U << (head - CBOR_AI_UINT8);
+	if (buf_read(buf, len, CBOR_BUF_READ(in->in_cpkt), &in->offset) < 0) {
+		return -EINVAL;
+	}
+
+	switch (len) {
+	case 1:
+		*value = buf[0];
+		break;
+	case 2:
+		*value = sys_get_be16(buf);
+		break;
+	case 4:
+		*value = sys_get_be32(buf);
+		break;
+	default:
+		*value = sys_get_be64(buf);
+		break;
+	}
+
+	return 0;
+}
+
+int cbor_skip(struct lwm2m_input_context *in)
+{
+	uint16_t left;
+	uint32_t items = 1U;
+	uint64_t value;
+	uint8_t major;
+
+	while (items > 0U) {
+		if (cbor_get_head(in, &major, &value) < 0) {
+			return -EINVAL;
+		}
+
+		items--;
+		left = in->in_cpkt->offset - in->offset;
+
+		switch (major) {
+		case CBOR_MAJOR_BSTR:
+		case CBOR_MAJOR_TSTR:
+			if (value > left) {
+				return -EINVAL;
+			}
+
+			in->offset += value;
+			break;
+
+		case CBOR_MAJOR_ARRAY:
+		case CBOR_MAJOR_MAP:
+			/* every item takes at least a byte */
+			if (value > left) {
+				return -EINVAL;
+			}
+
+			items += (major == CBOR_MAJOR_MAP) ? 2U * value : value;
+			break;
+
+		case CBOR_MAJOR_TAG:
+			items++;
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	return 0;
+}
+
+static size_t get_int(struct lwm2m_input_context *in, int64_t *value)
+{
+	uint16_t start = in->offset;
+	uint64_t tmp;
+	uint8_t major;
+
+	if (cbor_get_head(in, &major, &tmp) < 0) {
+		return 0;
+	}
+
+	if (major == CBOR_MAJOR_UINT && tmp <= INT64_MAX) {
+		*value = (int64_t)tmp;
+	} else if (major == CBOR_MAJOR_NINT && tmp <= INT64_MAX) {
+		*value = -1 - (int64_t)tmp;
+	} else {
+		in->offset = start;
+		return 0;
+	}
+
+	return in->offset - start;
+}
+
+static size_t get_s64(struct lwm2m_input_context *in, int64_t *value)
+{
+	return get_int(in, value);
+}
+
+static size_t get_s32(struct lwm2m_input_context *in, int32_t *value)
+{
+	int64_t tmp = 0;
+	size_t len;
+
+	len = get_int(in, &tmp);
+	if (len > 0) {
+		*value = (int32_t)tmp;
+	}
+
+	return len;
+}
+
+/* Read the head of a text or byte string and check its length */
+static int get_data_head(struct lwm2m_input_context *in, uint8_t major,
+			 uint16_t *len)
+{
+	uint64_t value;
+	uint8_t type;
+
+	if (cbor_get_head(in, &type, &value) < 0 || type != major ||
+	    value > in->in_cpkt->offset - in->offset) {
+		return -EINVAL;
+	}
+
+	*len = value;
+	return 0;
+}
+
+static size_t get_string(struct lwm2m_input_context *in,
+			 uint8_t *buf, size_t buflen)
+{
+	uint16_t start = in->offset;
+	uint16_t len, copy;
+
+	if (buflen == 0 || get_data_head(in, CBOR_MAJOR_TSTR, &len) < 0) {
+		in->offset = start;
+		return 0;
+	}
+
+	copy = MIN(len, buflen - 1);
+	memcpy(buf, in->in_cpkt->data + in->offset, copy);
+	buf[copy] = '\0';
+	in->offset += len;
+
+	return in->offset - start;
+}
+
+/* A number read as mant * 2^exp, so that floats are converted to fixed
+ * point from their bits, without floating point arithmetic.
+ */
+struct cbor_number {
+	uint64_t mant;
+	int exp;
+	bool neg;
+};
+
+/* Split the bits of an IEEE 754 float of any precision */
+static int float_bits_to_number(uint64_t bits, int exp_bits, int mant_bits,
+				struct cbor_number *num)
+{
+	int bias = (1 << (exp_bits - 1)) - 1;
+	int exp = (bits >> mant_bits) & ((1 << exp_bits) - 1);
+
+	/* infinity and NaN cannot be held in fixed point */
+	if (exp == (1 << exp_bits) - 1) {
+		return -EINVAL;
+	}
+
+	num->neg = (bits >> (exp_bits + mant_bits)) & 1;
+	num->mant = bits & ((1ULL << mant_bits) - 1);
+
+	if (exp == 0) {
+		/* subnormal */
+		num->exp = 1 - bias - mant_bits;
+	} else {
+		num->mant |= 1ULL << mant_bits;
+		num->exp = exp - bias - mant_bits;
+	}
+
+	return 0;
+}
+
+static size_t get_number(struct lwm2m_input_context *in,
+			 struct cbor_number *num)
+{
+	uint16_t start = in->offset;
+	uint64_t tmp;
+	uint8_t major;
+	int64_t i64;
+	int ret;
+
+	/* integers are valid numbers as well */
+	if (get_int(in, &i64) > 0) {
+		num->neg = i64 < 0;
+		num->mant = num->neg ? -(uint64_t)i64 : (uint64_t)i64;
+		num->exp = 0;
+		return in->offset - start;
+	}
+
+	if (cbor_get_head(in, &major, &tmp) < 0 ||
+	    major != CBOR_MAJOR_SIMPLE) {
+		in->offset = start;
+		return 0;
+	}
+
+	switch (in->in_cpkt->data[start] & 0x1f) {
+	case CBOR_AI_UINT16:
+		ret = float_bits_to_number(tmp, 5, 10, num);
+		break;
+	case CBOR_AI_UINT32:
+		ret = float_bits_to_number(tmp, 8, 23, num);
+		break;
+	case CBOR_AI_UINT64:
+		ret = float_bits_to_number(tmp, 11, 52, num);
+		break;
+	default:
+		ret = -EINVAL;
+		break;
+	}
+
+	if (ret < 0) {
+		in->offset = start;
+		return 0;
+	}
+
+	return in->offset - start;
+}
+
+/* Convert a number to fixed point, rounding the fraction to 1 / scale.
+ * Returns -EINVAL if the integer part is larger than max.
+ */
+static int number_to_fix(const struct cbor_number *num, uint64_t max,
+			 uint64_t scale, int64_t *val1, int64_t *val2)
+{
+	uint64_t ipart = 0U, frac = 0U;
+	int shift;
+
+	if (num->exp >= 0) {
+		if (num->mant != 0U &&
+		    (num->exp >= 64 || num->mant > (max >> num->exp))) {
+			return -EINVAL;
+		}
+
+		if (num->mant != 0U) {
+			ipart = num->mant << num->exp;
+		}
+	} else {
+		shift = -num->exp;
+
+		/* keep 32 bits of the fraction, below the resolution of
+		 * the largest scale
+		 */
+		if (shift < 64) {
+			ipart = num->mant >> shift;
+			frac = num->mant & ((1ULL << shift) - 1);
+		} else {
+			frac = num->mant;
+		}
+
+		if (shift <= 32) {
+			frac <<= 32 - shift;
+		} else if (shift - 32 < 64) {
+			frac >>= shift - 32;
+		} else {
+			frac = 0U;
+		}
+
+		/* scale is below 2^32, so this does not overflow */
+		frac = (frac * scale + BIT64(31)) >> 32;
+		if (frac == scale) {
+			ipart++;
+			frac = 0U;
+		}
+
+		if (ipart > max) {
+			return -EINVAL;
+		}
+	}
+
+	/* fixed point values keep the sign in val1, and in val2 */
+	*val1 = num->neg ? -(int64_t)ipart : (int64_t)ipart;
+	*val2 = num->neg ? -(int64_t)frac : (int64_t)frac;
+
+	return 0;
+}
+
+static size_t get_float32fix(struct lwm2m_input_context *in,
+			     float32_value_t *value)
+{
+	struct cbor_number num;
+	int64_t val1, val2;
+	uint16_t start = in->offset;
+	size_t len;
+
+	len = get_number(in, &num);
+	if (len == 0 ||
+	    number_to_fix(&num, INT32_MAX, LWM2M_FLOAT32_DEC_MAX,
+			  &val1, &val2) < 0) {
+		in->offset = start;
+		return 0;
+	}
+
+	value->val1 = (int32_t)val1;
+	value->val2 = (int32_t)val2;
+
+	return len;
+}
+
+static size_t get_float64fix(struct lwm2m_input_context *in,
+			     float64_value_t *value)
+{
+	struct cbor_number num;
+	uint16_t start = in->offset;
+	size_t len;
+
+	len = get_number(in, &num);
+	if (len == 0 ||
+	    number_to_fix(&num, INT64_MAX, LWM2M_FLOAT64_DEC_MAX,
+			  &value->val1, &value->val2) < 0) {
+		in->offset = start;
+		return 0;
+	}
+
+	return len;
+}
+
+static size_t get_bool(struct lwm2m_input_context *in, bool *value)
+{
+	uint16_t start = in->offset;
+	uint64_t tmp;
+	uint8_t major;
+
+	if (cbor_get_head(in, &major, &tmp) < 0 ||
+	    major != CBOR_MAJOR_SIMPLE ||
+	    (tmp != CBOR_FALSE && tmp != CBOR_TRUE)) {
+		in->offset = start;
+		return 0;
+	}
+
+	*value = (tmp == CBOR_TRUE);
+	return 1;
+}
+
+static size_t get_opaque(struct lwm2m_input_context *in,
+			 uint8_t *buf, size_t buflen, bool *last_block)
+{
+	uint16_t len;
+
+	if (get_data_head(in, CBOR_MAJOR_BSTR, &len) < 0) {
+		*last_block = true;
+		return 0;
+	}
+
+	in->opaque_len = len;
+	return lwm2m_engine_get_opaque_more(in, buf, buflen, last_block);
+}
+
+static size_t get_objlnk(struct lwm2m_input_context *in,
+			 struct lwm2m_objlnk *value)
+{
+	char buf[sizeof("65535:65535")];
+	char *sep;
+	size_t len;
+
+	len = get_string(in, buf, sizeof(buf));
+	if (len == 0) {
+		return 0;
+	}
+
+	sep = strchr(buf, ':');
+	if (!sep) {
+		return 0;
+	}
+
+	value->obj_id = (uint16_t)strtoul(buf, NULL, 10);
+	value->obj_inst = (uint16_t)strtoul(sep + 1, NULL, 10);
+
+	return len;
+}
+
+const struct lwm2m_writer cbor_writer = {
+	.put_s8 = put_s8,
+	.put_s16 = put_s16,
+	.put_s32 = put_s32,
+	.put_s64 = put_s64,
+	.put_string = put_string,
+	.put_float32fix = put_float32fix,
+	.put_float64fix = put_float64fix,
+	.put_bool = put_bool,
+	.put_opaque = put_opaque,
+	.put_objlnk = put_objlnk,
+};
+
+const struct lwm2m_reader cbor_reader = {
+	.get_s32 = get_s32,
+	.get_s64 = get_s64,
+	.get_string = get_string,
+	.get_float32fix = get_float32fix,
+	.get_float64fix = get_float64fix,
+	.get_bool = get_bool,
+	.get_opaque = get_opaque,
+	.get_objlnk = get_objlnk,
+};
+
+int do_read_op_cbor(struct lwm2m_message *msg, int content_format)
+{
+	/* CBOR can only return single resource */
+	if (msg->path.level != 3U) {
+		return -EPERM; /* NOT_ALLOWED */
+	}
+
+	return lwm2m_perform_read_op(msg, content_format);
+}
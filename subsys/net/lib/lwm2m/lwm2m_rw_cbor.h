@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef LWM2M_RW_CBOR_H_
+#define LWM2M_RW_CBOR_H_
+
+#include "lwm2m_object.h"
+
+/* CBOR major types (RFC 7049) */
+#define CBOR_MAJOR_UINT		0
+#define CBOR_MAJOR_NINT		1
+#define CBOR_MAJOR_BSTR		2
+#define CBOR_MAJOR_TSTR		3
+#define CBOR_MAJOR_ARRAY	4
+#define CBOR_MAJOR_MAP		5
+#define CBOR_MAJOR_TAG		6
+#define CBOR_MAJOR_SIMPLE	7
+
+/* additional information values */
+#define CBOR_AI_UINT8		24
+#define CBOR_AI_UINT16		25
+#define CBOR_AI_UINT32		26
+#define CBOR_AI_UINT64		27
+
+#define CBOR_HEAD(major, ai)	(uint8_t)(((major) << 5) | (ai))
+
+extern const struct lwm2m_writer cbor_writer;
+extern const struct lwm2m_reader cbor_reader;
+
+/* Encoding helpers, writing straight into the outgoing packet. They return
+ * the number of bytes written, or 0 if the packet is full.
+ */
+size_t cbor_put_head(struct lwm2m_output_context *out, uint8_t major,
+		     uint64_t value);
+size_t cbor_put_int(struct lwm2m_output_context *out, int64_t value);
+size_t cbor_put_data(struct lwm2m_output_context *out, uint8_t major,
+		     const void *buf, size_t buflen);
+
+/* Decoding helpers, reading from in->offset and moving it past the item */
+int cbor_get_head(struct lwm2m_input_context *in, uint8_t *major,
+		  uint64_t *value);
+int cbor_skip(struct lwm2m_input_context *in);
+
+int do_read_op_cbor(struct lwm2m_message *msg, int content_format);
+
+#endif /* LWM2M_RW_CBOR_H_ */
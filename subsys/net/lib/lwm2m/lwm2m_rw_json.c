@@ -280,12 +280,11 @@ static size_t put_begin(struct lwm2m_output_context *out,
 	return (size_t)len;
 }
 
-static size_t put_end(struct lwm2m_output_context *out,
-		      struct lwm2m_obj_path *path)
+static int put_end(struct lwm2m_output_context *out,
+		   struct lwm2m_obj_path *path)
 {
 	if (buf_append(CPKT_BUF_WRITE(out->out_cpkt), "]}", 2) < 0) {
-		/* TODO: Generate error? */
-		return 0;
+		return -ENOMEM;
 	}
 
 	return 2;
@@ -0,0 +1,594 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * SenML CBOR content format (application/senml+cbor, RFC 8428).
+ *
+ * The records are written straight into the outgoing packet as an array
+ * of maps, the first one carrying the base name of the path. The array
+ * head is patched with the number of records once they are all written.
+ * Values are read with the CBOR reader.
+ */
+
+#define LOG_MODULE_NAME net_lwm2m_senml_cbor
+#define LOG_LEVEL CONFIG_LWM2M_LOG_LEVEL
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(LOG_MODULE_NAME);
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include <sys/byteorder.h>
+
+#include "lwm2m_object.h"
+#include "lwm2m_rw_cbor.h"
+#include "lwm2m_rw_senml_cbor.h"
+#include "lwm2m_engine.h"
+
+/* SenML labels */
+#define SENML_LABEL_BN		-2
+#define SENML_LABEL_N		0
+#define SENML_LABEL_V		2
+#define SENML_LABEL_VS		3
+#define SENML_LABEL_VB		4
+#define SENML_LABEL_VD		8
+/* LwM2M object link value, the only label sent as a string */
+#define SENML_LABEL_VLO		0x100
+#define SENML_LABEL_UNKNOWN	0x101
+
+#define SENML_VLO		"vlo"
+
+struct senml_cbor_out_formatter_data {
+	/* offset of the array head */
+	uint16_t mark_pos;
+
+	/* number of records written */
+	uint16_t records;
+
+	/* flags */
+	uint8_t writer_flags;
+
+	/* path storage */
+	uint8_t path_level;
+};
+
+static size_t put_begin(struct lwm2m_output_context *out,
+			struct lwm2m_obj_path *path)
+{
+	struct senml_cbor_out_formatter_data *fd;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	/* one byte holds up to 23 records, more are inserted by put_end */
+	fd->mark_pos = out->out_cpkt->offset;
+	fd->records = 0U;
+
+	return cbor_put_head(out, CBOR_MAJOR_ARRAY, 0);
+}
+
+static int put_end(struct lwm2m_output_context *out,
+		   struct lwm2m_obj_path *path)
+{
+	struct senml_cbor_out_formatter_data *fd;
+	uint8_t head[2];
+	uint8_t ai;
+	uint16_t len;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	if (fd->records < CBOR_AI_UINT8) {
+		out->out_cpkt->data[fd->mark_pos] =
+			CBOR_HEAD(CBOR_MAJOR_ARRAY, fd->records);
+		return 0;
+	}
+
+	if (fd->records <= UINT8_MAX) {
+		ai = CBOR_AI_UINT8;
+		head[0] = fd->records;
+		len = 1U;
+	} else {
+		ai = CBOR_AI_UINT16;
+		sys_put_be16(fd->records, head);
+		len = 2U;
+	}
+
+	/* The head only announces the count once it is in the packet */
+	if (buf_insert(CPKT_BUF_WRITE(out->out_cpkt), fd->mark_pos + 1,
+		       head, len) < 0) {
+		return -ENOMEM;
+	}
+
+	out->out_cpkt->data[fd->mark_pos] = CBOR_HEAD(CBOR_MAJOR_ARRAY, ai);
+
+	return len;
+}
+
+static size_t put_begin_ri(struct lwm2m_output_context *out,
+			   struct lwm2m_obj_path *path)
+{
+	struct senml_cbor_out_formatter_data *fd;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	fd->writer_flags |= WRITER_RESOURCE_INSTANCE;
+	return 0;
+}
+
+static size_t put_end_ri(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path)
+{
+	struct senml_cbor_out_formatter_data *fd;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	fd->writer_flags &= ~WRITER_RESOURCE_INSTANCE;
+	return 0;
+}
+
+/* Write the head of a record, up to the label of its value */
+static size_t put_record_prefix(struct lwm2m_output_context *out,
+				struct lwm2m_obj_path *path, int label)
+{
+	struct senml_cbor_out_formatter_data *fd;
+	char name[sizeof("/65535/65535/65535/")];
+	size_t len;
+	int ret;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	len = cbor_put_head(out, CBOR_MAJOR_MAP, fd->records ? 2 : 3);
+
+	if (fd->records == 0U) {
+		if (fd->path_level >= 2U) {
+			ret = snprintk(name, sizeof(name), "/%u/%u/",
+				       path->obj_id, path->obj_inst_id);
+		} else {
+			ret = snprintk(name, sizeof(name), "/%u/",
+				       path->obj_id);
+		}
+
+		if (ret < 0) {
+			return 0;
+		}
+
+		len += cbor_put_int(out, SENML_LABEL_BN);
+		len += cbor_put_data(out, CBOR_MAJOR_TSTR, name, ret);
+	}
+
+	if (fd->path_level >= 2U) {
+		if (fd->writer_flags & WRITER_RESOURCE_INSTANCE) {
+			ret = snprintk(name, sizeof(name), "%u/%u",
+				       path->res_id, path->res_inst_id);
+		} else {
+			ret = snprintk(name, sizeof(name), "%u",
+				       path->res_id);
+		}
+	} else {
+		if (fd->writer_flags & WRITER_RESOURCE_INSTANCE) {
+			ret = snprintk(name, sizeof(name), "%u/%u/%u",
+				       path->obj_inst_id, path->res_id,
+				       path->res_inst_id);
+		} else {
+			ret = snprintk(name, sizeof(name), "%u/%u",
+				       path->obj_inst_id, path->res_id);
+		}
+	}
+
+	if (ret < 0) {
+		return 0;
+	}
+
+	len += cbor_put_int(out, SENML_LABEL_N);
+	len += cbor_put_data(out, CBOR_MAJOR_TSTR, name, ret);
+
+	if (label == SENML_LABEL_VLO) {
+		len += cbor_put_data(out, CBOR_MAJOR_TSTR, SENML_VLO,
+				     strlen(SENML_VLO));
+	} else {
+		len += cbor_put_int(out, label);
+	}
+
+	fd->records++;
+	return len;
+}
+
+static size_t put_s32(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path, int32_t value)
+{
+	size_t len;
+
+	len = put_record_prefix(out, path, SENML_LABEL_V);
+	len += cbor_writer.put_s32(out, path, value);
+	return len;
+}
+
+static size_t put_s16(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path, int16_t value)
+{
+	return put_s32(out, path, (int32_t)value);
+}
+
+static size_t put_s8(struct lwm2m_output_context *out,
+		     struct lwm2m_obj_path *path, int8_t value)
+{
+	return put_s32(out, path, (int32_t)value);
+}
+
+static size_t put_s64(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path, int64_t value)
+{
+	size_t len;
+
+	len = put_record_prefix(out, path, SENML_LABEL_V);
+	len += cbor_writer.put_s64(out, path, value);
+	return len;
+}
+
+static size_t put_string(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path,
+			 char *buf, size_t buflen)
+{
+	size_t len;
+
+	len = put_record_prefix(out, path, SENML_LABEL_VS);
+	len += cbor_writer.put_string(out, path, buf, buflen);
+	return len;
+}
+
+static size_t put_float32fix(struct lwm2m_output_context *out,
+			     struct lwm2m_obj_path *path,
+			     float32_value_t *value)
+{
+	size_t len;
+
+	len = put_record_prefix(out, path, SENML_LABEL_V);
+	len += cbor_writer.put_float32fix(out, path, value);
+	return len;
+}
+
+static size_t put_float64fix(struct lwm2m_output_context *out,
+			     struct lwm2m_obj_path *path,
+			     float64_value_t *value)
+{
+	size_t len;
+
+	len = put_record_prefix(out, path, SENML_LABEL_V);
+	len += cbor_writer.put_float64fix(out, path, value);
+	return len;
+}
+
+static size_t put_bool(struct lwm2m_output_context *out,
+		       struct lwm2m_obj_path *path,
+		       bool value)
+{
+	size_t len;
+
+	len = put_record_prefix(out, path, SENML_LABEL_VB);
+	len += cbor_writer.put_bool(out, path, value);
+	return len;
+}
+
+static size_t put_opaque(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path,
+			 char *buf, size_t buflen)
+{
+	size_t len;
+
+	len = put_record_prefix(out, path, SENML_LABEL_VD);
+	len += cbor_writer.put_opaque(out, path, buf, buflen);
+	return len;
+}
+
+static size_t put_objlnk(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path,
+			 struct lwm2m_objlnk *value)
+{
+	size_t len;
+
+	len = put_record_prefix(out, path, SENML_LABEL_VLO);
+	len += cbor_writer.put_objlnk(out, path, value);
+	return len;
+}
+
+const struct lwm2m_writer senml_cbor_writer = {
+	.put_begin = put_begin,
+	.put_end = put_end,
+	.put_begin_ri = put_begin_ri,
+	.put_end_ri = put_end_ri,
+	.put_s8 = put_s8,
+	.put_s16 = put_s16,
+	.put_s32 = put_s32,
+	.put_s64 = put_s64,
+	.put_string = put_string,
+	.put_float32fix = put_float32fix,
+	.put_float64fix = put_float64fix,
+	.put_bool = put_bool,
+	.put_opaque = put_opaque,
+	.put_objlnk = put_objlnk,
+};
+
+int do_read_op_senml_cbor(struct lwm2m_message *msg, int content_format)
+{
+	struct senml_cbor_out_formatter_data fd;
+	int ret;
+
+	(void)memset(&fd, 0, sizeof(fd));
+	engine_set_out_user_data(&msg->out, &fd);
+	/* save the level for output processing */
+	fd.path_level = msg->path.level;
+	ret = lwm2m_perform_read_op(msg, content_format);
+	engine_clear_out_user_data(&msg->out);
+
+	return ret;
+}
+
+static int get_label(struct lwm2m_input_context *in, int *label)
+{
+	uint64_t value;
+	uint8_t major;
+
+	if (cbor_get_head(in, &major, &value) < 0) {
+		return -EINVAL;
+	}
+
+	switch (major) {
+	case CBOR_MAJOR_UINT:
+		*label = value <= INT16_MAX ? (int)value : SENML_LABEL_UNKNOWN;
+		break;
+
+	case CBOR_MAJOR_NINT:
+		*label = value < INT16_MAX ? -1 - (int)value :
+					     SENML_LABEL_UNKNOWN;
+		break;
+
+	case CBOR_MAJOR_TSTR:
+		if (value > in->in_cpkt->offset - in->offset) {
+			return -EINVAL;
+		}
+
+		if (value == strlen(SENML_VLO) &&
+		    memcmp(in->in_cpkt->data + in->offset, SENML_VLO,
+			   value) == 0) {
+			*label = SENML_LABEL_VLO;
+		} else {
+			*label = SENML_LABEL_UNKNOWN;
+		}
+
+		in->offset += value;
+		break;
+
+	default:
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int get_name(struct lwm2m_input_context *in, char *buf, size_t buflen)
+{
+	if (cbor_reader.get_string(in, buf, buflen) == 0) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int parse_path(const char *buf, struct lwm2m_obj_path *path)
+{
+	uint32_t val;
+	int level = 0;
+
+	(void)memset(path, 0, sizeof(*path));
+
+	while (*buf) {
+		if (*buf == '/') {
+			buf++;
+			continue;
+		}
+
+		if (!isdigit((unsigned char)*buf) || level == 4) {
+			LOG_ERR("Error: illegal path '%s'", log_strdup(buf));
+			return -EINVAL;
+		}
+
+		val = 0U;
+		while (isdigit((unsigned char)*buf)) {
+			val = val * 10U + (*buf++ - '0');
+			if (val > UINT16_MAX) {
+				return -EINVAL;
+			}
+		}
+
+		if (level == 0) {
+			path->obj_id = val;
+		} else if (level == 1) {
+			path->obj_inst_id = val;
+		} else if (level == 2) {
+			path->res_id = val;
+		} else {
+			path->res_inst_id = val;
+		}
+
+		level++;
+	}
+
+	return level;
+}
+
+/* Write the value at value_offset to the resource named by the record */
+static int write_record(struct lwm2m_message *msg, const char *base_name,
+			const char *name, uint16_t value_offset)
+{
+	struct lwm2m_engine_obj_field *obj_field;
+	struct lwm2m_engine_obj_inst *obj_inst = NULL;
+	struct lwm2m_engine_res *res = NULL;
+	struct lwm2m_engine_res_inst *res_inst = NULL;
+	char full_name[2 * MAX_RESOURCE_LEN];
+	uint8_t created = 0U;
+	int ret, i;
+
+	snprintk(full_name, sizeof(full_name), "%s%s", base_name, name);
+
+	ret = parse_path(full_name, &msg->path);
+	if (ret < 0) {
+		return ret;
+	}
+
+	/* if valid, use the return value as level */
+	msg->path.level = ret;
+
+	ret = lwm2m_get_or_create_engine_obj(msg, &obj_inst, &created);
+	if (ret < 0) {
+		return ret;
+	}
+
+	obj_field = lwm2m_get_engine_obj_field(obj_inst->obj,
+					       msg->path.res_id);
+	if (!obj_field) {
+		return -ENOENT;
+	}
+
+	if (!LWM2M_HAS_PERM(obj_field, LWM2M_PERM_W)) {
+		return -EPERM;
+	}
+
+	if (!obj_inst->resources || obj_inst->resource_count == 0U) {
+		return -EINVAL;
+	}
+
+	for (i = 0; i < obj_inst->resource_count; i++) {
+		if (obj_inst->resources[i].res_id == msg->path.res_id) {
+			res = &obj_inst->resources[i];
+			break;
+		}
+	}
+
+	if (!res) {
+		return -ENOENT;
+	}
+
+	for (i = 0; i < res->res_inst_count; i++) {
+		if (res->res_instances[i].res_inst_id ==
+		    msg->path.res_inst_id) {
+			res_inst = &res->res_instances[i];
+			break;
+		}
+	}
+
+	if (!res_inst) {
+		return -ENOENT;
+	}
+
+	msg->in.offset = value_offset;
+	return lwm2m_write_handler(obj_inst, res, res_inst, obj_field, msg);
+}
+
+int do_write_op_senml_cbor(struct lwm2m_message *msg)
+{
+	struct lwm2m_input_context *in = &msg->in;
+	struct lwm2m_obj_path orig_path;
+	char base_name[MAX_RESOURCE_LEN] = "";
+	char name[MAX_RESOURCE_LEN];
+	uint64_t records, pairs;
+	uint16_t value_offset = 0U, end;
+	bool has_value;
+	uint8_t major;
+	int ret = 0;
+	int label;
+
+	/* store a copy of the original path */
+	memcpy(&orig_path, &msg->path, sizeof(msg->path));
+
+	if (cbor_get_head(in, &major, &records) < 0 ||
+	    major != CBOR_MAJOR_ARRAY) {
+		LOG_ERR("Error parsing SenML pack!");
+		return -EINVAL;
+	}
+
+	while (records-- > 0U) {
+		if (cbor_get_head(in, &major, &pairs) < 0 ||
+		    major != CBOR_MAJOR_MAP) {
+			LOG_ERR("Error parsing SenML record!");
+			ret = -EINVAL;
+			break;
+		}
+
+		name[0] = '\0';
+		has_value = false;
+
+		while (pairs-- > 0U && ret == 0) {
+			ret = get_label(in, &label);
+			if (ret < 0) {
+				break;
+			}
+
+			switch (label) {
+			case SENML_LABEL_BN:
+				ret = get_name(in, base_name,
+					       sizeof(base_name));
+				break;
+
+			case SENML_LABEL_N:
+				ret = get_name(in, name, sizeof(name));
+				break;
+
+			case SENML_LABEL_V:
+			case SENML_LABEL_VS:
+			case SENML_LABEL_VB:
+			case SENML_LABEL_VD:
+			case SENML_LABEL_VLO:
+				has_value = true;
+				value_offset = in->offset;
+				ret = cbor_skip(in);
+				break;
+
+			default:
+				ret = cbor_skip(in);
+				break;
+			}
+		}
+
+		if (ret < 0) {
+			LOG_ERR("Error parsing SenML record!");
+			break;
+		}
+
+		/* a record may only carry the base name */
+		if (!has_value) {
+			continue;
+		}
+
+		end = in->offset;
+		ret = write_record(msg, base_name, name, value_offset);
+		in->offset = end;
+
+		if (ret < 0) {
+			break;
+		}
+	}
+
+	memcpy(&msg->path, &orig_path, sizeof(msg->path));
+
+	return ret;
+}
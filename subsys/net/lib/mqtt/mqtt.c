@@ -25,8 +25,87 @@ static void client_reset(struct mqtt_client *client)
 	client->internal.last_activity = 0U;
 	client->internal.rx_buf_datalen = 0U;
 	client->internal.remaining_payload = 0U;
+#if CONFIG_MQTT_MAX_INFLIGHT > 0
+	client->internal.inflight_count = 0U;
+#endif
+}
+
+#if CONFIG_MQTT_MAX_INFLIGHT > 0
+static int inflight_find(const struct mqtt_client *client,
+			 uint16_t message_id)
+{
+	int i;
+
+	for (i = 0; i < client->internal.inflight_count; i++) {
+		if (client->internal.inflight[i] == message_id) {
+			return i;
+		}
+	}
+
+	return -ENOENT;
+}
+
+/** @brief Check that a QoS 1 or QoS 2 message fits in the in-flight window.
+ *         Retransmissions of a message that is already in flight always fit.
+ */
+static int inflight_check(const struct mqtt_client *client,
+			  const struct mqtt_publish_param *param)
+{
+	if (param->message.topic.qos == MQTT_QOS_0_AT_MOST_ONCE) {
+		return 0;
+	}
+
+	if (client->internal.inflight_count < CONFIG_MQTT_MAX_INFLIGHT ||
+	    inflight_find(client, param->message_id) >= 0) {
+		return 0;
+	}
+
+	return -EAGAIN;
 }
 
+static void inflight_add(struct mqtt_client *client,
+			 const struct mqtt_publish_param *param)
+{
+	if (param->message.topic.qos == MQTT_QOS_0_AT_MOST_ONCE ||
+	    inflight_find(client, param->message_id) >= 0) {
+		return;
+	}
+
+	client->internal.inflight[client->internal.inflight_count++] =
+							param->message_id;
+}
+
+void mqtt_inflight_release(struct mqtt_client *client, uint16_t message_id)
+{
+	int i = inflight_find(client, message_id);
+
+	if (i < 0) {
+		MQTT_TRC("[CID %p]: Ack for unknown message id %u", client,
+			 message_id);
+		return;
+	}
+
+	/* Order does not matter, move the last entry into the hole. */
+	client->internal.inflight[i] =
+		client->internal.inflight[--client->internal.inflight_count];
+}
+#else
+static inline int inflight_check(const struct mqtt_client *client,
+				 const struct mqtt_publish_param *param)
+{
+	return 0;
+}
+
+static inline void inflight_add(struct mqtt_client *client,
+				const struct mqtt_publish_param *param)
+{
+}
+
+void mqtt_inflight_release(struct mqtt_client *client, uint16_t message_id)
+{
+}
+#endif /* CONFIG_MQTT_MAX_INFLIGHT > 0 */
+
 /** @brief Initialize tx buffer. */
 static void tx_buf_init(struct mqtt_client *client, struct buf_ctx *buf)
 {
@@ -160,7 +239,7 @@ static int client_write(struct mqtt_client *client, const uint8_t *data,
 }
 
 static int client_write_msg(struct mqtt_client *client,
-			    const struct msghdr *message)
+			    struct msghdr *message)
 {
 	int err_code;
 
@@ -274,6 +353,11 @@ int mqtt_publish(struct mqtt_client *client,
 		goto error;
 	}
 
+	err_code = inflight_check(client, param);
+	if (err_code < 0) {
+		goto error;
+	}
+
 	err_code = publish_encode(param, &packet);
 	if (err_code < 0) {
 		goto error;
@@ -290,6 +374,9 @@ int mqtt_publish(struct mqtt_client *client,
 	msg.msg_iovlen = ARRAY_SIZE(io_vector);
 
 	err_code = client_write_msg(client, &msg);
+	if (err_code == 0) {
+		inflight_add(client, param);
+	}
 
 error:
 	MQTT_TRC("[CID %p]:[State 0x%02x]: << result 0x%08x",
@@ -162,6 +162,13 @@ void event_notify(struct mqtt_client *client, const struct mqtt_evt *evt);
  */
 int mqtt_handle_rx(struct mqtt_client *client);
 
+/**@brief Releases the in-flight window slot of an acknowledged message.
+ *
+ * @param[in] client Identifies the client for which the ack was received.
+ * @param[in] message_id Message ID of the acknowledged PUBLISH message.
+ */
+void mqtt_inflight_release(struct mqtt_client *client, uint16_t message_id);
+
 /**@brief Constructs/encodes Connect packet.
  *
  * @param[in] client Identifies the client for which the procedure is requested.
@@ -75,6 +75,10 @@ static int mqtt_handle_packet(struct mqtt_client *client,
 		evt.type = MQTT_EVT_PUBACK;
 		err_code = publish_ack_decode(buf, &evt.param.puback);
 		evt.result = err_code;
+		if (err_code == 0) {
+			mqtt_inflight_release(client,
+					      evt.param.puback.message_id);
+		}
 		break;
 
 	case MQTT_PKT_TYPE_PUBREC:
@@ -99,6 +103,10 @@ static int mqtt_handle_packet(struct mqtt_client *client,
 		evt.type = MQTT_EVT_PUBCOMP;
 		err_code = publish_complete_decode(buf, &evt.param.pubcomp);
 		evt.result = err_code;
+		if (err_code == 0) {
+			mqtt_inflight_release(client,
+					      evt.param.pubcomp.message_id);
+		}
 		break;
 
 	case MQTT_PKT_TYPE_SUBACK:
@@ -249,7 +257,7 @@ static int mqtt_read_and_parse_fixed_header(struct mqtt_client *client,
 	return err_code;
 }
 
-int mqtt_handle_rx(struct mqtt_client *client)
+static int mqtt_handle_one_packet(struct mqtt_client *client)
 {
 	int err_code;
 	uint8_t type_and_flags;
@@ -262,7 +270,7 @@ int mqtt_handle_rx(struct mqtt_client *client)
 	err_code = mqtt_read_and_parse_fixed_header(client, &type_and_flags,
 						    &var_length, &buf);
 	if (err_code < 0) {
-		return (err_code == -EAGAIN) ? 0 : err_code;
+		return err_code;
 	}
 
 	if ((type_and_flags & 0xF0) == MQTT_PKT_TYPE_PUBLISH) {
@@ -273,7 +281,7 @@ int mqtt_handle_rx(struct mqtt_client *client)
 	}
 
 	if (err_code < 0) {
-		return (err_code == -EAGAIN) ? 0 : err_code;
+		return err_code;
 	}
 
 	/* At this point, packet is ready to be passed to the application. */
@@ -286,3 +294,30 @@ int mqtt_handle_rx(struct mqtt_client *client)
 
 	return 0;
 }
+
+int mqtt_handle_rx(struct mqtt_client *client)
+{
+	int err_code;
+	int i;
+
+	/* Drain the packets that are already queued on the transport, so
+	 * that a burst of acknowledgments costs a single mqtt_input() call.
+	 */
+	for (i = 0; i < CONFIG_MQTT_RX_BATCH_SIZE; i++) {
+		err_code = mqtt_handle_one_packet(client);
+		if (err_code < 0) {
+			return (err_code == -EAGAIN) ? 0 : err_code;
+		}
+
+		/* The payload of a PUBLISH message has to be read by the
+		 * application first, and the application may have closed
+		 * the connection from the event handler.
+		 */
+		if (client->internal.remaining_payload > 0 ||
+		    !MQTT_HAS_STATE(client, MQTT_STATE_TCP_CONNECTED)) {
+			break;
+		}
+	}
+
+	return 0;
+}
@@ -118,12 +118,9 @@ int mqtt_client_tls_write(struct mqtt_client *client, const uint8_t *data,
 }
 
 int mqtt_client_tls_write_msg(struct mqtt_client *client,
-			      const struct msghdr *message)
+			      struct msghdr *message)
 {
-	int ret;
-
-	ret = sendmsg(client->transport.tls.sock, message, 0);
-	if (ret < 0) {
+	if (zsock_sendmsg_all(client->transport.tls.sock, message, 0) < 0) {
 		return -errno;
 	}
 
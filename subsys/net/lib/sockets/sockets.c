@@ -748,6 +748,117 @@ fail:
 #include <syscalls/zsock_sendmsg_mrsh.c>
 #endif /* CONFIG_USERSPACE */
 
+ssize_t zsock_sendmsg_all(int sock, struct msghdr *msg, int flags)
+{
+	ssize_t total = 0;
+	ssize_t ret;
+
+	while (msg->msg_iovlen > 0) {
+		ret = zsock_sendmsg(sock, msg, flags);
+		if (ret < 0) {
+			return -1;
+		}
+
+		total += ret;
+
+		/* Skip over what has been sent */
+		while (msg->msg_iovlen > 0 && ret >= msg->msg_iov->iov_len) {
+			ret -= msg->msg_iov->iov_len;
+			msg->msg_iov++;
+			msg->msg_iovlen--;
+		}
+
+		if (msg->msg_iovlen > 0) {
+			msg->msg_iov->iov_base =
+				(uint8_t *)msg->msg_iov->iov_base + ret;
+			msg->msg_iov->iov_len -= ret;
+		}
+	}
+
+	return total;
+}
+
+static void mmsg_set_len(unsigned int *msg_len, unsigned int len)
+{
+	*msg_len = len;
+}
+
+static int sock_sendmmsg(int sock, struct mmsghdr *msgvec, unsigned int vlen,
+			 int flags,
+			 ssize_t (*send_fn)(int sock, const struct msghdr *msg,
+					    int flags),
+			 void (*set_len)(unsigned int *msg_len,
+					 unsigned int len))
+{
+	const struct socket_op_vtable *vtable;
+	unsigned int i;
+	ssize_t ret = 0;
+	bool batch = false;
+	void *ctx;
+
+	ctx = get_sock_vtable(sock, &vtable);
+	if (ctx == NULL) {
+		errno = EBADF;
+		return -1;
+	}
+
+	/* With the native stack, hold the datagrams back in the TX batch
+	 * of this thread and queue them all at once at the end, so that
+	 * the TX threads are woken up once. The batch is sent earlier if
+	 * the packet memory runs out.
+	 */
+	if (vtable == &sock_fd_op_vtable &&
+	    net_context_get_type(ctx) == SOCK_DGRAM) {
+		batch = net_if_tx_batch_begin();
+	}
+
+	for (i = 0; i < vlen; i++) {
+		ret = send_fn(sock, &msgvec[i].msg_hdr, flags);
+		if (ret < 0) {
+			break;
+		}
+
+		set_len(&msgvec[i].msg_len, ret);
+	}
+
+	if (batch) {
+		net_if_tx_batch_end();
+	}
+
+	/* Report the error only if nothing was sent */
+	if (i == 0 && ret < 0) {
+		return -1;
+	}
+
+	return i;
+}
+
+int z_impl_zsock_sendmmsg(int sock, struct mmsghdr *msgvec,
+			  unsigned int vlen, int flags)
+{
+	return sock_sendmmsg(sock, msgvec, vlen, flags, z_impl_zsock_sendmsg,
+			     mmsg_set_len);
+}
+
+#ifdef CONFIG_USERSPACE
+static void mmsg_copy_len(unsigned int *msg_len, unsigned int len)
+{
+	Z_OOPS(z_user_to_copy(msg_len, &len, sizeof(len)));
+}
+
+static inline int z_vrfy_zsock_sendmmsg(int sock, struct mmsghdr *msgvec,
+					unsigned int vlen, int flags)
+{
+	Z_OOPS(Z_SYSCALL_MEMORY_ARRAY_WRITE(msgvec, vlen,
+					    sizeof(struct mmsghdr)));
+
+	/* Each message header is copied and checked by sendmsg */
+	return sock_sendmmsg(sock, msgvec, vlen, flags, z_vrfy_zsock_sendmsg,
+			     mmsg_copy_len);
+}
+#include <syscalls/zsock_sendmmsg_mrsh.c>
+#endif /* CONFIG_USERSPACE */
+
 static int sock_get_pkt_src_addr(struct net_pkt *pkt,
 				 enum net_ip_protocol proto,
 				 struct sockaddr *addr,
@@ -851,15 +962,103 @@ error:
 	return ret;
 }
 
+static size_t sock_iov_len(const struct msghdr *msg)
+{
+	size_t len = 0;
+	size_t i;
+
+	for (i = 0; i < msg->msg_iovlen; i++) {
+		len += msg->msg_iov[i].iov_len;
+	}
+
+	return len;
+}
+
+/* Scatter len bytes from the packet cursor into the msg_iov buffers */
+static int sock_pkt_read_iov(struct net_pkt *pkt, const struct msghdr *msg,
+			     size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < msg->msg_iovlen && len > 0; i++) {
+		size_t chunk = MIN(len, msg->msg_iov[i].iov_len);
+
+		if (net_pkt_read(pkt, msg->msg_iov[i].iov_base, chunk)) {
+			return -ENOBUFS;
+		}
+
+		len -= chunk;
+	}
+
+	return 0;
+}
+
+#if defined(CONFIG_NET_SOCKETS_RECV_ZEROCOPY)
+/* Point the msg_iov entries to the packet data starting at the cursor,
+ * one entry per net_buf fragment. The cursor is not moved.
+ */
+static size_t sock_pkt_lend_iov(struct net_pkt *pkt, struct msghdr *msg,
+				size_t len, struct zsock_zc_buf *zc)
+{
+	struct net_buf *buf = pkt->cursor.buf;
+	uint8_t *pos = pkt->cursor.pos;
+	size_t lent = 0;
+	size_t i = 0;
+
+	zc->frag = NULL;
+	zc->offset = 0;
+
+	while (buf && lent < len && i < msg->msg_iovlen) {
+		size_t avail = buf->len - (pos - buf->data);
+
+		if (avail > 0) {
+			avail = MIN(avail, len - lent);
+
+			if (!zc->frag) {
+				zc->frag = buf;
+				zc->offset = pos - buf->data;
+			}
+
+			msg->msg_iov[i].iov_base = pos;
+			msg->msg_iov[i].iov_len = avail;
+			lent += avail;
+			i++;
+		}
+
+		buf = buf->frags;
+		if (buf) {
+			pos = buf->data;
+		}
+	}
+
+	msg->msg_iovlen = i;
+	zc->len = lent;
+
+	return lent;
+}
+
+/* Advance the cursor of a received packet without touching the data */
+static void sock_pkt_consume(struct net_pkt *pkt, size_t len)
+{
+	bool overwrite = net_pkt_is_being_overwritten(pkt);
+
+	net_pkt_set_overwrite(pkt, true);
+	net_pkt_skip(pkt, len);
+	net_pkt_set_overwrite(pkt, overwrite);
+}
+#endif /* CONFIG_NET_SOCKETS_RECV_ZEROCOPY */
+
+/* Either copy the data to the msg_iov buffers (zc == NULL), or lend
+ * the packet data to the caller through the msg_iov entries.
+ */
 static inline ssize_t zsock_recv_dgram(struct net_context *ctx,
-				       void *buf,
-				       size_t max_len,
+				       struct msghdr *msg,
 				       int flags,
-				       struct sockaddr *src_addr,
-				       socklen_t *addrlen)
+				       struct zsock_zc_buf *zc)
 {
 	k_timeout_t timeout = K_FOREVER;
 	size_t recv_len = 0;
+	size_t data_len;
 	struct net_pkt_cursor backup;
 	struct net_pkt *pkt;
 
@@ -889,46 +1088,70 @@ static inline ssize_t zsock_recv_dgram(struct net_context *ctx,
 
 	net_pkt_cursor_backup(pkt, &backup);
 
-	if (src_addr && addrlen) {
+	if (msg->msg_name) {
 		int rv;
 
 		rv = sock_get_pkt_src_addr(pkt, net_context_get_ip_proto(ctx),
-					   src_addr, *addrlen);
+					   msg->msg_name, msg->msg_namelen);
 		if (rv < 0) {
 			errno = -rv;
 			goto fail;
 		}
 
-		/* addrlen is a value-result argument, set to actual
+		/* msg_namelen is a value-result argument, set to actual
 		 * size of source address
 		 */
-		if (src_addr->sa_family == AF_INET) {
-			*addrlen = sizeof(struct sockaddr_in);
-		} else if (src_addr->sa_family == AF_INET6) {
-			*addrlen = sizeof(struct sockaddr_in6);
+		if (((struct sockaddr *)msg->msg_name)->sa_family == AF_INET) {
+			msg->msg_namelen = sizeof(struct sockaddr_in);
+		} else if (((struct sockaddr *)msg->msg_name)->sa_family ==
+			   AF_INET6) {
+			msg->msg_namelen = sizeof(struct sockaddr_in6);
 		} else {
 			errno = ENOTSUP;
 			goto fail;
 		}
 	}
 
-	recv_len = net_pkt_remaining_data(pkt);
-	if (recv_len > max_len) {
-		recv_len = max_len;
+	data_len = net_pkt_remaining_data(pkt);
+
+#if defined(CONFIG_NET_SOCKETS_RECV_ZEROCOPY)
+	if (zc) {
+		recv_len = sock_pkt_lend_iov(pkt, msg, data_len, zc);
+
+		/* When not peeking, the queue reference moves to zc */
+		if (flags & ZSOCK_MSG_PEEK) {
+			net_pkt_ref(pkt);
+		}
+
+		zc->pkt = pkt;
+	} else
+#endif
+	{
+		recv_len = MIN(data_len, sock_iov_len(msg));
+
+		if (sock_pkt_read_iov(pkt, msg, recv_len)) {
+			errno = ENOBUFS;
+			goto fail;
+		}
 	}
 
-	if (net_pkt_read(pkt, buf, recv_len)) {
-		errno = ENOBUFS;
-		goto fail;
+	if (recv_len < data_len) {
+		msg->msg_flags |= ZSOCK_MSG_TRUNC;
 	}
 
 	net_stats_update_tc_rx_time(net_pkt_iface(pkt),
 				    net_pkt_priority(pkt),
 				    net_pkt_timestamp(pkt)->nanosecond,
 				    k_cycle_get_32());
+	net_stats_update_rx_time_detail(net_pkt_iface(pkt),
+					net_pkt_timestamp(pkt)->nanosecond,
+					net_pkt_stats_tick(pkt),
+					k_cycle_get_32());
 
 	if (!(flags & ZSOCK_MSG_PEEK)) {
-		net_pkt_unref(pkt);
+		if (!zc) {
+			net_pkt_unref(pkt);
+		}
 	} else {
 		net_pkt_cursor_restore(pkt, &backup);
 	}
@@ -944,12 +1167,13 @@ fail:
 }
 
 static inline ssize_t zsock_recv_stream(struct net_context *ctx,
-					void *buf,
-					size_t max_len,
-					int flags)
+					struct msghdr *msg,
+					int flags,
+					struct zsock_zc_buf *zc)
 {
 	k_timeout_t timeout = K_FOREVER;
 	size_t recv_len = 0;
+	size_t max_len = sock_iov_len(msg);
 	struct net_pkt_cursor backup;
 	int res;
 
@@ -994,15 +1218,31 @@ static inline ssize_t zsock_recv_stream(struct net_context *ctx,
 		net_pkt_cursor_backup(pkt, &backup);
 
 		data_len = net_pkt_remaining_data(pkt);
-		recv_len = data_len;
-		if (recv_len > max_len) {
-			recv_len = max_len;
-		}
 
-		/* Actually copy data to application buffer */
-		if (net_pkt_read(pkt, buf, recv_len)) {
-			errno = ENOBUFS;
-			return -1;
+#if defined(CONFIG_NET_SOCKETS_RECV_ZEROCOPY)
+		if (zc) {
+			recv_len = sock_pkt_lend_iov(pkt, msg, data_len, zc);
+			if (recv_len > 0) {
+				/* The lent data stays valid until released,
+				 * even when the packet leaves the queue.
+				 */
+				net_pkt_ref(pkt);
+				zc->pkt = pkt;
+
+				if (!(flags & ZSOCK_MSG_PEEK)) {
+					sock_pkt_consume(pkt, recv_len);
+				}
+			}
+		} else
+#endif
+		{
+			recv_len = MIN(data_len, max_len);
+
+			/* Actually copy data to application buffer */
+			if (sock_pkt_read_iov(pkt, msg, recv_len)) {
+				errno = ENOBUFS;
+				return -1;
+			}
 		}
 
 		if (!(flags & ZSOCK_MSG_PEEK)) {
@@ -1020,6 +1260,11 @@ static inline ssize_t zsock_recv_stream(struct net_context *ctx,
 					net_pkt_priority(pkt),
 					net_pkt_timestamp(pkt)->nanosecond,
 					k_cycle_get_32());
+				net_stats_update_rx_time_detail(
+					net_pkt_iface(pkt),
+					net_pkt_timestamp(pkt)->nanosecond,
+					net_pkt_stats_tick(pkt),
+					k_cycle_get_32());
 
 				net_pkt_unref(pkt);
 			}
@@ -1029,32 +1274,135 @@ static inline ssize_t zsock_recv_stream(struct net_context *ctx,
 	} while (recv_len == 0);
 
 	if (!(flags & ZSOCK_MSG_PEEK)) {
-		net_context_update_recv_wnd(ctx, recv_len);
+#if defined(CONFIG_NET_SOCKETS_RECV_ZEROCOPY)
+		/* The peer may only send more once the lent buffers are
+		 * back in the pool.
+		 */
+		if (zc) {
+			net_context_ref(ctx);
+			zc->ctx = ctx;
+			zc->wnd = recv_len;
+		} else
+#endif
+		{
+			net_context_update_recv_wnd(ctx, recv_len);
+		}
 	}
 
 	return recv_len;
 }
 
+static ssize_t zsock_recv_ctx(struct net_context *ctx, struct msghdr *msg,
+			      int flags, struct zsock_zc_buf *zc)
+{
+	enum net_sock_type sock_type = net_context_get_type(ctx);
+
+	if (sock_type == SOCK_DGRAM) {
+		return zsock_recv_dgram(ctx, msg, flags, zc);
+	} else if (sock_type == SOCK_STREAM) {
+		return zsock_recv_stream(ctx, msg, flags, zc);
+	} else {
+		__ASSERT(0, "Unknown socket type");
+	}
+
+	return 0;
+}
+
 ssize_t zsock_recvfrom_ctx(struct net_context *ctx, void *buf, size_t max_len,
 			   int flags,
 			   struct sockaddr *src_addr, socklen_t *addrlen)
 {
-	enum net_sock_type sock_type = net_context_get_type(ctx);
+	struct iovec iov = {
+		.iov_base = buf,
+		.iov_len = max_len,
+	};
+	struct msghdr msg = {
+		.msg_iov = &iov,
+		.msg_iovlen = 1,
+	};
+	ssize_t ret;
 
 	if (max_len == 0) {
 		return 0;
 	}
 
-	if (sock_type == SOCK_DGRAM) {
-		return zsock_recv_dgram(ctx, buf, max_len, flags, src_addr, addrlen);
-	} else if (sock_type == SOCK_STREAM) {
-		return zsock_recv_stream(ctx, buf, max_len, flags);
-	} else {
-		__ASSERT(0, "Unknown socket type");
+	if (src_addr && addrlen) {
+		msg.msg_name = src_addr;
+		msg.msg_namelen = *addrlen;
 	}
 
-	return 0;
+	ret = zsock_recv_ctx(ctx, &msg, flags, NULL);
+
+	if (ret >= 0 && msg.msg_name) {
+		*addrlen = msg.msg_namelen;
+	}
+
+	return ret;
+}
+
+ssize_t zsock_recvmsg_ctx(struct net_context *ctx, struct msghdr *msg,
+			  int flags)
+{
+	msg->msg_flags = 0;
+	msg->msg_controllen = 0;
+
+	if (sock_iov_len(msg) == 0) {
+		return 0;
+	}
+
+	return zsock_recv_ctx(ctx, msg, flags, NULL);
+}
+
+#if defined(CONFIG_NET_SOCKETS_RECV_ZEROCOPY)
+ssize_t zsock_recvmsg_zc(int sock, struct msghdr *msg, int flags,
+			 struct zsock_zc_buf *zc)
+{
+	const struct socket_op_vtable *vtable;
+	struct net_context *ctx;
+	ssize_t ret;
+
+	ctx = get_sock_vtable(sock, &vtable);
+	if (ctx == NULL) {
+		errno = EBADF;
+		return -1;
+	}
+
+	/* Only the native sockets keep the data in net_bufs */
+	if (vtable != &sock_fd_op_vtable) {
+		errno = EOPNOTSUPP;
+		return -1;
+	}
+
+	memset(zc, 0, sizeof(*zc));
+	msg->msg_flags = 0;
+	msg->msg_controllen = 0;
+
+	if (msg->msg_iovlen == 0) {
+		return 0;
+	}
+
+	ret = zsock_recv_ctx(ctx, msg, flags, zc);
+	if (ret < 0) {
+		zsock_recv_zc_release(zc);
+	}
+
+	return ret;
+}
+
+void zsock_recv_zc_release(struct zsock_zc_buf *zc)
+{
+	if (zc->pkt) {
+		net_pkt_unref(zc->pkt);
+	}
+
+	if (zc->ctx) {
+		net_context_update_recv_wnd(zc->ctx, zc->wnd);
+		net_context_unref(zc->ctx);
+	}
+
+	memset(zc, 0, sizeof(*zc));
 }
+#endif /* CONFIG_NET_SOCKETS_RECV_ZEROCOPY */
 
 ssize_t z_impl_zsock_recvfrom(int sock, void *buf, size_t max_len, int flags,
 			     struct sockaddr *src_addr, socklen_t *addrlen)
@@ -1094,6 +1442,130 @@ ssize_t z_vrfy_zsock_recvfrom(int sock, void *buf, size_t max_len, int flags,
 #include <syscalls/zsock_recvfrom_mrsh.c>
 #endif /* CONFIG_USERSPACE */
 
+ssize_t z_impl_zsock_recvmsg(int sock, struct msghdr *msg, int flags)
+{
+	const struct socket_op_vtable *vtable;
+	void *ctx = get_sock_vtable(sock, &vtable);
+
+	if (ctx == NULL) {
+		errno = EBADF;
+		return -1;
+	}
+
+	/* Not all socket implementations (TLS, offloaded, ...) have it */
+	if (vtable->recvmsg == NULL) {
+		errno = EOPNOTSUPP;
+		return -1;
+	}
+
+	return vtable->recvmsg(ctx, msg, flags);
+}
+
+#ifdef CONFIG_USERSPACE
+static inline ssize_t z_vrfy_zsock_recvmsg(int sock, struct msghdr *msg,
+					   int flags)
+{
+	struct msghdr msg_copy;
+	struct iovec *iov;
+	size_t i;
+	ssize_t ret;
+
+	Z_OOPS(z_user_from_copy(&msg_copy, (void *)msg, sizeof(msg_copy)));
+
+	if (msg_copy.msg_iovlen == 0) {
+		iov = NULL;
+	} else {
+		iov = z_user_alloc_from_copy(msg_copy.msg_iov,
+					     msg_copy.msg_iovlen *
+					     sizeof(struct iovec));
+		if (!iov) {
+			errno = ENOMEM;
+			return -1;
+		}
+	}
+
+	for (i = 0; i < msg_copy.msg_iovlen; i++) {
+		if (Z_SYSCALL_MEMORY_WRITE(iov[i].iov_base, iov[i].iov_len)) {
+			k_free(iov);
+			errno = EFAULT;
+			return -1;
+		}
+	}
+
+	Z_OOPS(msg_copy.msg_name &&
+	       Z_SYSCALL_MEMORY_WRITE(msg_copy.msg_name,
+				      msg_copy.msg_namelen));
+
+	msg_copy.msg_iov = iov;
+
+	ret = z_impl_zsock_recvmsg(sock, &msg_copy, flags);
+
+	k_free(iov);
+
+	Z_OOPS(z_user_to_copy(&msg->msg_namelen, &msg_copy.msg_namelen,
+			      sizeof(msg->msg_namelen)));
+	Z_OOPS(z_user_to_copy(&msg->msg_controllen, &msg_copy.msg_controllen,
+			      sizeof(msg->msg_controllen)));
+	Z_OOPS(z_user_to_copy(&msg->msg_flags, &msg_copy.msg_flags,
+			      sizeof(msg->msg_flags)));
+
+	return ret;
+}
+#include <syscalls/zsock_recvmsg_mrsh.c>
+#endif /* CONFIG_USERSPACE */
+
+static int sock_recvmmsg(int sock, struct mmsghdr *msgvec, unsigned int vlen,
+			 int flags,
+			 ssize_t (*recv_fn)(int sock, struct msghdr *msg,
+					    int flags),
+			 void (*set_len)(unsigned int *msg_len,
+					 unsigned int len))
+{
+	unsigned int i;
+	ssize_t ret = 0;
+
+	for (i = 0; i < vlen; i++) {
+		ret = recv_fn(sock, &msgvec[i].msg_hdr, flags);
+		if (ret < 0) {
+			break;
+		}
+
+		set_len(&msgvec[i].msg_len, ret);
+
+		/* Only wait for the first message, then take what is
+		 * already queued.
+		 */
+		flags |= ZSOCK_MSG_DONTWAIT;
+	}
+
+	if (i == 0 && ret < 0) {
+		return -1;
+	}
+
+	return i;
+}
+
+int z_impl_zsock_recvmmsg(int sock, struct mmsghdr *msgvec,
+			  unsigned int vlen, int flags)
+{
+	return sock_recvmmsg(sock, msgvec, vlen, flags, z_impl_zsock_recvmsg,
+			     mmsg_set_len);
+}
+
+#ifdef CONFIG_USERSPACE
+static inline int z_vrfy_zsock_recvmmsg(int sock, struct mmsghdr *msgvec,
+					unsigned int vlen, int flags)
+{
+	Z_OOPS(Z_SYSCALL_MEMORY_ARRAY_WRITE(msgvec, vlen,
+					    sizeof(struct mmsghdr)));
+
+	/* Each message header is copied and checked by recvmsg */
+	return sock_recvmmsg(sock, msgvec, vlen, flags, z_vrfy_zsock_recvmsg,
+			     mmsg_copy_len);
+}
+#include <syscalls/zsock_recvmmsg_mrsh.c>
+#endif /* CONFIG_USERSPACE */
+
 /* As this is limited function, we don't follow POSIX signature, with
  * "..." instead of last arg.
  */
@@ -1179,7 +1651,8 @@ static inline int time_left(uint32_t start, uint32_t timeout)
 	return timeout - elapsed;
 }
 
-int z_impl_zsock_poll(struct zsock_pollfd *fds, int nfds, int poll_timeout)
+int z_zsock_poll_signal(struct zsock_pollfd *fds, int nfds, int poll_timeout,
+			struct k_poll_signal *signal)
 {
 	bool retry;
 	int ret = 0;
@@ -1202,6 +1675,13 @@ int z_impl_zsock_poll(struct zsock_pollfd *fds, int nfds, int poll_timeout)
 	end = z_timeout_end_calc(timeout);
 
 	pev = poll_events;
+
+	/* The signal takes the first event, ahead of the sockets */
+	if (signal) {
+		k_poll_event_init(pev++, K_POLL_TYPE_SIGNAL,
+				  K_POLL_MODE_NOTIFY_ONLY, signal);
+	}
+
 	for (pfd = fds, i = nfds; i--; pfd++) {
 		void *ctx;
 		int result;
@@ -1267,7 +1747,7 @@ int z_impl_zsock_poll(struct zsock_pollfd *fds, int nfds, int poll_timeout)
 		retry = false;
 		ret = 0;
 
-		pev = poll_events;
+		pev = signal ? poll_events + 1 : poll_events;
 		for (pfd = fds, i = nfds; i--; pfd++) {
 			void *ctx;
 			int result;
@@ -1303,7 +1783,7 @@ int z_impl_zsock_poll(struct zsock_pollfd *fds, int nfds, int poll_timeout)
 		}
 
 		if (retry) {
-			if (ret > 0) {
+			if (ret > 0 || (signal && signal->signaled)) {
 				break;
 			}
 
@@ -1326,6 +1806,11 @@ int z_impl_zsock_poll(struct zsock_pollfd *fds, int nfds, int poll_timeout)
 	return ret;
 }
 
+int z_impl_zsock_poll(struct zsock_pollfd *fds, int nfds, int poll_timeout)
+{
+	return z_zsock_poll_signal(fds, nfds, poll_timeout, NULL);
+}
+
 #ifdef CONFIG_USERSPACE
 static inline int z_vrfy_zsock_poll(struct zsock_pollfd *fds,
 				    int nfds, int timeout)
@@ -1793,6 +2278,11 @@ static ssize_t sock_sendmsg_vmeth(void *obj, const struct msghdr *msg,
 	return zsock_sendmsg_ctx(obj, msg, flags);
 }
 
+static ssize_t sock_recvmsg_vmeth(void *obj, struct msghdr *msg, int flags)
+{
+	return zsock_recvmsg_ctx(obj, msg, flags);
+}
+
 static ssize_t sock_recvfrom_vmeth(void *obj, void *buf, size_t max_len,
 				   int flags, struct sockaddr *src_addr,
 				   socklen_t *addrlen)
@@ -1827,6 +2317,7 @@ const struct socket_op_vtable sock_fd_op_vtable = {
 	.sendto = sock_sendto_vmeth,
 	.sendmsg = sock_sendmsg_vmeth,
 	.recvfrom = sock_recvfrom_vmeth,
+	.recvmsg = sock_recvmsg_vmeth,
 	.getsockopt = sock_getsockopt_vmeth,
 	.setsockopt = sock_setsockopt_vmeth,
 };
@@ -46,6 +46,14 @@ struct socket_op_vtable {
 	int (*setsockopt)(void *obj, int level, int optname,
 			  const void *optval, socklen_t optlen);
 	ssize_t (*sendmsg)(void *obj, const struct msghdr *msg, int flags);
+	ssize_t (*recvmsg)(void *obj, struct msghdr *msg, int flags);
 };
 
+/* Same as zsock_poll(), but also returns, with no events on the sockets,
+ * when the signal is raised. The signal takes one of the
+ * CONFIG_NET_SOCKETS_POLL_MAX entries.
+ */
+int z_zsock_poll_signal(struct zsock_pollfd *fds, int nfds, int poll_timeout,
+			struct k_poll_signal *signal);
+
 #endif /* _SOCKETS_INTERNAL_H_ */
@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_sock_svc, CONFIG_NET_SOCKETS_LOG_LEVEL);
+
+#include <kernel.h>
+#include <sys/slist.h>
+#include <net/socket.h>
+#include <net/socket_service.h>
+
+#include "sockets_internal.h"
+
+/* One poll entry is taken by the wakeup signal */
+#define SERVICE_MAX_FDS (CONFIG_NET_SOCKETS_POLL_MAX - 1)
+
+BUILD_ASSERT(SERVICE_MAX_FDS > 0,
+	     "CONFIG_NET_SOCKETS_POLL_MAX is too small for the dispatcher");
+
+static K_MUTEX_DEFINE(lock);
+static sys_slist_t services;
+static int registered_fds;
+
+/* Raised to make the dispatcher rebuild its poll set */
+static struct k_poll_signal wakeup = K_POLL_SIGNAL_INITIALIZER(wakeup);
+
+/* Only used by the dispatcher thread */
+static struct zsock_pollfd fds[SERVICE_MAX_FDS];
+static struct net_socket_service_event *events[SERVICE_MAX_FDS];
+static uint32_t gens[SERVICE_MAX_FDS];
+
+static void service_work(struct k_work *work)
+{
+	struct net_socket_service_event *pev =
+		CONTAINER_OF(work, struct net_socket_service_event, work);
+	bool stale;
+
+	k_mutex_lock(&lock, K_FOREVER);
+	stale = pev->gen != pev->work_gen;
+	k_mutex_unlock(&lock);
+
+	/* Skip the handler if the socket was registered again or
+	 * unregistered since it was ready.
+	 */
+	if (!stale) {
+		pev->svc->handler(pev);
+	}
+
+	/* Poll the socket again */
+	atomic_clear(&pev->busy);
+	k_poll_signal_raise(&wakeup, 0);
+}
+
+static int service_fds(struct net_socket_service_desc *svc)
+{
+	int count = 0;
+	int i;
+
+	for (i = 0; i < svc->pev_len; i++) {
+		if (svc->pev[i].event.fd >= 0) {
+			count++;
+		}
+	}
+
+	return count;
+}
+
+/* Called with the lock held */
+static bool service_is_registered(struct net_socket_service_desc *svc)
+{
+	sys_snode_t *node;
+
+	SYS_SLIST_FOR_EACH_NODE(&services, node) {
+		if (node == &svc->node) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+int net_socket_service_register(struct net_socket_service_desc *svc,
+				struct zsock_pollfd *fds, int len,
+				void *user_data)
+{
+	bool registered;
+	int count = 0;
+	int old;
+	int i;
+
+	if (len < 0 || len > svc->pev_len || (len > 0 && !fds)) {
+		return -EINVAL;
+	}
+
+	for (i = 0; i < len; i++) {
+		if (fds[i].fd >= 0) {
+			count++;
+		}
+	}
+
+	k_mutex_lock(&lock, K_FOREVER);
+
+	registered = service_is_registered(svc);
+	old = registered ? service_fds(svc) : 0;
+
+	if (registered_fds - old + count > SERVICE_MAX_FDS) {
+		NET_DBG("Cannot poll %d more sockets for %s", count - old,
+			svc->owner);
+
+		/* The service keeps its previous sockets */
+		k_mutex_unlock(&lock);
+
+		return -ENOMEM;
+	}
+
+	if (registered) {
+		sys_slist_find_and_remove(&services, &svc->node);
+		registered_fds -= old;
+	}
+
+	for (i = 0; i < svc->pev_len; i++) {
+		struct net_socket_service_event *pev = &svc->pev[i];
+
+		if (i < len) {
+			pev->event = fds[i];
+			pev->event.revents = 0;
+		} else {
+			pev->event.fd = -1;
+		}
+
+		if (!atomic_get(&pev->busy)) {
+			k_work_init(&pev->work, service_work);
+		}
+
+		pev->svc = svc;
+		pev->user_data = user_data;
+		pev->gen++;
+	}
+
+	if (count > 0) {
+		sys_slist_append(&services, &svc->node);
+		registered_fds += count;
+	}
+
+	k_mutex_unlock(&lock);
+
+	k_poll_signal_raise(&wakeup, 0);
+
+	return 0;
+}
+
+/* Called with the lock held */
+static void dispatch(struct net_socket_service_event *pev, int revents)
+{
+	struct net_socket_service_desc *svc = pev->svc;
+
+	pev->event.revents = revents;
+
+	if (svc->work_q) {
+		/* Not polled until the handler has run */
+		atomic_set(&pev->busy, 1);
+		pev->work_gen = pev->gen;
+		k_work_submit_to_queue(svc->work_q, &pev->work);
+	} else {
+		svc->handler(pev);
+	}
+}
+
+static void dispatcher(void *p1, void *p2, void *p3)
+{
+	struct net_socket_service_desc *svc;
+	int nfds;
+	int ret;
+	int i;
+
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	while (1) {
+		nfds = 0;
+
+		k_mutex_lock(&lock, K_FOREVER);
+
+		SYS_SLIST_FOR_EACH_CONTAINER(&services, svc, node) {
+			for (i = 0; i < svc->pev_len; i++) {
+				struct net_socket_service_event *pev =
+					&svc->pev[i];
+
+				if (pev->event.fd < 0 ||
+				    atomic_get(&pev->busy)) {
+					continue;
+				}
+
+				fds[nfds].fd = pev->event.fd;
+				fds[nfds].events = pev->event.events;
+				gens[nfds] = pev->gen;
+				events[nfds++] = pev;
+			}
+		}
+
+		/* Changes made after this point raise the signal again */
+		k_poll_signal_reset(&wakeup);
+
+		k_mutex_unlock(&lock);
+
+		ret = z_zsock_poll_signal(fds, nfds, SYS_FOREVER_MS, &wakeup);
+		if (ret < 0) {
+			NET_ERR("Cannot poll the services (%d)", -errno);
+			k_sleep(K_MSEC(100));
+			continue;
+		}
+
+		/* The sockets may have been registered again or unregistered
+		 * while polling, and their fd numbers reused. Only dispatch
+		 * the events of the registrations that were polled, and keep
+		 * them from changing until the handlers are called.
+		 */
+		k_mutex_lock(&lock, K_FOREVER);
+
+		for (i = 0; ret > 0 && i < nfds; i++) {
+			if (!fds[i].revents) {
+				continue;
+			}
+
+			ret--;
+
+			if (events[i]->gen != gens[i]) {
+				NET_DBG("Dropping events of stale fd %d",
+					fds[i].fd);
+				continue;
+			}
+
+			dispatch(events[i], fds[i].revents);
+		}
+
+		k_mutex_unlock(&lock);
+	}
+}
+
+K_THREAD_DEFINE(net_socket_service, CONFIG_NET_SOCKETS_SERVICE_STACK_SIZE,
+		dispatcher, NULL, NULL, NULL,
+		CONFIG_NET_SOCKETS_SERVICE_THREAD_PRIO, 0, 0);
@@ -102,8 +102,22 @@ struct tls_context {
 
 		/** DTLS role, client by default. */
 		int8_t role;
+
+		/** Information whether the session cache is used. */
+		bool cache_enabled;
+
+		/** Information whether small writes are coalesced. */
+		bool coalesce;
 	} options;
 
+#if defined(CONFIG_NET_SOCKETS_TLS_COALESCE)
+	/** Coalesced writes waiting to be sent. */
+	uint8_t tx_buf[CONFIG_NET_SOCKETS_TLS_COALESCE_SIZE];
+
+	/** Number of bytes in tx_buf. */
+	uint16_t tx_len;
+#endif /* CONFIG_NET_SOCKETS_TLS_COALESCE */
+
 #if defined(CONFIG_NET_SOCKETS_ENABLE_DTLS)
 	/** Context information for DTLS timing. */
 	struct dtls_timing_context dtls_timing;
@@ -594,6 +608,79 @@ static int tls_rx(void *ctx, unsigned char *buf, size_t len)
 	return received;
 }
 
+#if defined(CONFIG_NET_SOCKETS_TLS_COALESCE)
+/* Send the coalesced writes, mbedTLS splits them in records of at most
+ * MBEDTLS_SSL_MAX_CONTENT_LEN bytes.
+ */
+static int tls_tx_flush(struct net_context *ctx)
+{
+	struct tls_context *tls = ctx->tls;
+	int ret;
+
+	while (tls->tx_len > 0) {
+		ret = mbedtls_ssl_write(&tls->ssl, tls->tx_buf, tls->tx_len);
+		if (ret == MBEDTLS_ERR_SSL_WANT_READ ||
+		    ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+			/* mbedTLS wants the same data again on retry, which
+			 * is still at the start of the buffer.
+			 */
+			return -EAGAIN;
+		} else if (ret < 0) {
+			tls->tx_len = 0U;
+			return -EIO;
+		}
+
+		tls->tx_len -= ret;
+		memmove(tls->tx_buf, tls->tx_buf + ret, tls->tx_len);
+	}
+
+	return 0;
+}
+
+/* Buffer a small write. Returns the number of bytes buffered, or 0 if the
+ * data is too large for the buffer and should be sent right away.
+ */
+static int tls_tx_coalesce(struct net_context *ctx, const void *buf,
+			   size_t len)
+{
+	struct tls_context *tls = ctx->tls;
+	int ret;
+
+	if (len > sizeof(tls->tx_buf) - tls->tx_len) {
+		/* Keep the order of the data */
+		ret = tls_tx_flush(ctx);
+		if (ret < 0) {
+			return ret;
+		}
+
+		if (len >= sizeof(tls->tx_buf)) {
+			return 0;
+		}
+	}
+
+	memcpy(tls->tx_buf + tls->tx_len, buf, len);
+	tls->tx_len += len;
+
+	return len;
+}
+
+static inline int tls_tx_flush_pending(struct net_context *ctx)
+{
+	return ctx->tls->tx_len ? tls_tx_flush(ctx) : 0;
+}
+#else
+static inline int tls_tx_coalesce(struct net_context *ctx, const void *buf,
+				  size_t len)
+{
+	return 0;
+}
+
+static inline int tls_tx_flush_pending(struct net_context *ctx)
+{
+	return 0;
+}
+#endif /* CONFIG_NET_SOCKETS_TLS_COALESCE */
+
 static int tls_add_ca_certificate(struct tls_context *tls,
 				  struct tls_credential *ca_cert)
 {
@@ -815,6 +902,402 @@ static int tls_mbedtls_handshake(struct net_context *context, bool block)
 	return ret;
 }
 
+#if defined(CONFIG_NET_SOCKETS_TLS_SESSION_CACHE)
+/** Session of a TLS client, kept to resume the next connection. A
+ *  resumed session skips the verification of the server, so it is only
+ *  resumed by a socket verifying the same server the same way.
+ */
+struct tls_client_session {
+	/** Address of the server. */
+	struct sockaddr peer;
+
+	/** Hostname the server was verified against, empty if none. */
+	char hostname[CONFIG_NET_SOCKETS_TLS_SESSION_HOSTNAME_LEN + 1];
+
+	/** Credentials the server was verified with. */
+	struct sec_tag_list sec_tag_list;
+
+	/** mbedTLS session, including the session ticket if any. */
+	mbedtls_ssl_session session;
+
+	/** Uptime in ms when the session was stored. */
+	int64_t timestamp;
+
+	/** Information whether the entry is used. */
+	bool is_used;
+};
+
+/** Session of a client of a TLS server, found by its session ID. This
+ *  holds what mbedTLS needs to resume a session, see ssl_cache.c.
+ */
+struct tls_server_session {
+	/** Credentials of the listener that established the session. A
+	 *  session is only resumed with the same credentials.
+	 */
+	struct sec_tag_list sec_tag_list;
+
+	/** Session ID. */
+	unsigned char id[32];
+
+	/** Session ID length. */
+	size_t id_len;
+
+	/** Chosen ciphersuite. */
+	int ciphersuite;
+
+	/** Chosen compression method. */
+	int compression;
+
+	/** Master secret. */
+	unsigned char master[48];
+
+	/** Result of the peer verification. */
+	uint32_t verify_result;
+
+	/** Uptime in ms when the session was stored. */
+	int64_t timestamp;
+
+	/** Information whether the entry is used. */
+	bool is_used;
+};
+
+static struct tls_client_session
+client_sessions[CONFIG_NET_SOCKETS_TLS_MAX_CLIENT_SESSIONS];
+static struct tls_server_session
+server_sessions[CONFIG_NET_SOCKETS_TLS_MAX_SERVER_SESSIONS];
+
+/* A mutex for protecting both session caches. */
+static K_MUTEX_DEFINE(session_lock);
+
+static bool session_expired(int64_t timestamp)
+{
+	return k_uptime_get() - timestamp >=
+		(int64_t)CONFIG_NET_SOCKETS_TLS_SESSION_LIFETIME * MSEC_PER_SEC;
+}
+
+static bool session_peer_cmp(const struct sockaddr *addr1,
+			     const struct sockaddr *addr2)
+{
+	if (addr1->sa_family != addr2->sa_family) {
+		return false;
+	}
+
+	if (IS_ENABLED(CONFIG_NET_IPV6) && addr1->sa_family == AF_INET6) {
+		return net_sin6(addr1)->sin6_port ==
+					net_sin6(addr2)->sin6_port &&
+			net_ipv6_addr_cmp(&net_sin6(addr1)->sin6_addr,
+					  &net_sin6(addr2)->sin6_addr);
+	} else if (IS_ENABLED(CONFIG_NET_IPV4) &&
+		   addr1->sa_family == AF_INET) {
+		return net_sin(addr1)->sin_port == net_sin(addr2)->sin_port &&
+			net_ipv4_addr_cmp(&net_sin(addr1)->sin_addr,
+					  &net_sin(addr2)->sin_addr);
+	}
+
+	return false;
+}
+
+static bool session_sec_tag_list_cmp(const struct sec_tag_list *list1,
+				     const struct sec_tag_list *list2)
+{
+	return list1->sec_tag_count == list2->sec_tag_count &&
+	       !memcmp(list1->sec_tags, list2->sec_tags,
+		       list1->sec_tag_count * sizeof(sec_tag_t));
+}
+
+/* Hostname the server certificate is verified against, empty if none. */
+static const char *session_hostname(struct tls_context *tls)
+{
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+	if (tls->ssl.hostname) {
+		return tls->ssl.hostname;
+	}
+#endif
+
+	return "";
+}
+
+static void client_session_release(struct tls_client_session *entry)
+{
+	mbedtls_ssl_session_free(&entry->session);
+	entry->is_used = false;
+}
+
+/* Find the session with a server verified with the hostname and the
+ * credentials of the socket, releasing it if it has expired.
+ */
+static struct tls_client_session *client_session_find(
+					struct tls_context *tls,
+					const struct sockaddr *peer)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(client_sessions); i++) {
+		struct tls_client_session *entry = &client_sessions[i];
+
+		if (!entry->is_used || !session_peer_cmp(&entry->peer, peer) ||
+		    strcmp(entry->hostname, session_hostname(tls)) ||
+		    !session_sec_tag_list_cmp(&entry->sec_tag_list,
+					      &tls->options.sec_tag_list)) {
+			continue;
+		}
+
+		if (session_expired(entry->timestamp)) {
+			client_session_release(entry);
+			return NULL;
+		}
+
+		return entry;
+	}
+
+	return NULL;
+}
+
+/* Let the handshake resume the last session with the server. */
+static void tls_session_restore(struct net_context *context,
+				const struct sockaddr *peer)
+{
+	struct tls_client_session *entry;
+	int ret;
+
+	if (!context->tls->options.cache_enabled) {
+		return;
+	}
+
+	k_mutex_lock(&session_lock, K_FOREVER);
+
+	entry = client_session_find(context->tls, peer);
+	if (entry) {
+		ret = mbedtls_ssl_set_session(&context->tls->ssl,
+					      &entry->session);
+		if (ret != 0) {
+			NET_DBG("Cannot restore TLS session: -%x", -ret);
+		}
+	}
+
+	k_mutex_unlock(&session_lock);
+}
+
+/* Keep the session of a completed handshake, replacing the previous
+ * session with the same server, a free entry or the oldest one. A
+ * session verified against a hostname too long to be kept is not stored.
+ */
+static void tls_session_store(struct net_context *context,
+			      const struct sockaddr *peer, socklen_t addrlen)
+{
+	const char *hostname = session_hostname(context->tls);
+	struct tls_client_session *entry;
+	int ret, i;
+
+	if (!context->tls->options.cache_enabled ||
+	    strlen(hostname) >= sizeof(entry->hostname)) {
+		return;
+	}
+
+	k_mutex_lock(&session_lock, K_FOREVER);
+
+	entry = client_session_find(context->tls, peer);
+	if (!entry) {
+		for (i = 0; i < ARRAY_SIZE(client_sessions); i++) {
+			struct tls_client_session *cur = &client_sessions[i];
+
+			if (!cur->is_used) {
+				entry = cur;
+				break;
+			}
+
+			if (!entry || cur->timestamp < entry->timestamp) {
+				entry = cur;
+			}
+		}
+	}
+
+	client_session_release(entry);
+	mbedtls_ssl_session_init(&entry->session);
+
+	ret = mbedtls_ssl_get_session(&context->tls->ssl, &entry->session);
+	if (ret != 0) {
+		NET_DBG("Cannot store TLS session: -%x", -ret);
+		goto out;
+	}
+
+	(void)memset(&entry->peer, 0, sizeof(entry->peer));
+	memcpy(&entry->peer, peer, MIN(addrlen, sizeof(entry->peer)));
+	strcpy(entry->hostname, hostname);
+	memcpy(&entry->sec_tag_list, &context->tls->options.sec_tag_list,
+	       sizeof(entry->sec_tag_list));
+	entry->timestamp = k_uptime_get();
+	entry->is_used = true;
+
+out:
+	k_mutex_unlock(&session_lock);
+}
+
+/* Forget the session with a server, it could not be resumed. */
+static void tls_session_forget(struct net_context *context,
+			       const struct sockaddr *peer)
+{
+	struct tls_client_session *entry;
+
+	if (!context->tls->options.cache_enabled) {
+		return;
+	}
+
+	k_mutex_lock(&session_lock, K_FOREVER);
+
+	entry = client_session_find(context->tls, peer);
+	if (entry) {
+		client_session_release(entry);
+	}
+
+	k_mutex_unlock(&session_lock);
+}
+
+static void tls_session_purge(void)
+{
+	int i;
+
+	k_mutex_lock(&session_lock, K_FOREVER);
+
+	for (i = 0; i < ARRAY_SIZE(client_sessions); i++) {
+		if (client_sessions[i].is_used) {
+			client_session_release(&client_sessions[i]);
+		}
+	}
+
+	k_mutex_unlock(&session_lock);
+}
+
+/* mbedTLS session cache callback for servers, see mbedtls_ssl_cache_get().
+ * data is the credential list of the server. Returns 0 if the session was
+ * found.
+ */
+static int tls_session_cache_get(void *data, mbedtls_ssl_session *session)
+{
+	const struct sec_tag_list *sec_tag_list = data;
+	int ret = 1;
+	int i;
+
+	k_mutex_lock(&session_lock, K_FOREVER);
+
+	for (i = 0; i < ARRAY_SIZE(server_sessions); i++) {
+		struct tls_server_session *entry = &server_sessions[i];
+
+		if (!entry->is_used) {
+			continue;
+		}
+
+		if (session_expired(entry->timestamp)) {
+			entry->is_used = false;
+			continue;
+		}
+
+		if (!session_sec_tag_list_cmp(&entry->sec_tag_list,
+					      sec_tag_list) ||
+		    entry->ciphersuite != session->ciphersuite ||
+		    entry->compression != session->compression ||
+		    entry->id_len != session->id_len ||
+		    memcmp(entry->id, session->id, entry->id_len)) {
+			continue;
+		}
+
+		memcpy(session->master, entry->master, sizeof(entry->master));
+		session->verify_result = entry->verify_result;
+		ret = 0;
+		break;
+	}
+
+	k_mutex_unlock(&session_lock);
+
+	return ret;
+}
+
+/* mbedTLS session cache callback for servers, see mbedtls_ssl_cache_set().
+ * data is the credential list of the server.
+ */
+static int tls_session_cache_set(void *data,
+				 const mbedtls_ssl_session *session)
+{
+	const struct sec_tag_list *sec_tag_list = data;
+	struct tls_server_session *entry = NULL;
+	int i;
+
+	if (session->id_len > sizeof(entry->id)) {
+		return 1;
+	}
+
+	k_mutex_lock(&session_lock, K_FOREVER);
+
+	for (i = 0; i < ARRAY_SIZE(server_sessions); i++) {
+		struct tls_server_session *cur = &server_sessions[i];
+
+		if (!cur->is_used || session_expired(cur->timestamp)) {
+			entry = cur;
+			break;
+		}
+
+		if (!entry || cur->timestamp < entry->timestamp) {
+			entry = cur;
+		}
+	}
+
+	memcpy(&entry->sec_tag_list, sec_tag_list,
+	       sizeof(entry->sec_tag_list));
+	memcpy(entry->id, session->id, session->id_len);
+	entry->id_len = session->id_len;
+	entry->ciphersuite = session->ciphersuite;
+	entry->compression = session->compression;
+	memcpy(entry->master, session->master, sizeof(entry->master));
+	entry->verify_result = session->verify_result;
+	entry->timestamp = k_uptime_get();
+	entry->is_used = true;
+
+	k_mutex_unlock(&session_lock);
+
+	return 0;
+}
+
+static void tls_session_cache_conf(struct tls_context *tls)
+{
+	/* Only the secrets are cached, not the peer certificate, so the
+	 * sessions of verified clients cannot be resumed.
+	 */
+	if (!tls->options.cache_enabled ||
+	    tls->options.verify_level == MBEDTLS_SSL_VERIFY_OPTIONAL ||
+	    tls->options.verify_level == MBEDTLS_SSL_VERIFY_REQUIRED) {
+		return;
+	}
+
+	/* Each accepted socket has its own mbedTLS configuration, so the
+	 * sessions are kept apart by the credentials of the listener.
+	 */
+	mbedtls_ssl_conf_session_cache(&tls->config,
+				       &tls->options.sec_tag_list,
+				       tls_session_cache_get,
+				       tls_session_cache_set);
+}
+#else
+static inline void tls_session_restore(struct net_context *context,
+				       const struct sockaddr *peer)
+{
+}
+
+static inline void tls_session_store(struct net_context *context,
+				     const struct sockaddr *peer,
+				     socklen_t addrlen)
+{
+}
+
+static inline void tls_session_forget(struct net_context *context,
+				      const struct sockaddr *peer)
+{
+}
+
+static inline void tls_session_cache_conf(struct tls_context *tls)
+{
+}
+#endif /* CONFIG_NET_SOCKETS_TLS_SESSION_CACHE */
+
 static int tls_mbedtls_init(struct net_context *context, bool is_server)
 {
 	int role, type, ret;
@@ -901,6 +1384,10 @@ static int tls_mbedtls_init(struct net_context *context, bool is_server)
 					  context->tls->options.verify_level);
 	}
 
+	if (is_server) {
+		tls_session_cache_conf(context->tls);
+	}
+
 	mbedtls_ssl_conf_rng(&context->tls->config,
 			     mbedtls_ctr_drbg_random,
 			     &tls_ctr_drbg);
@@ -1112,6 +1599,121 @@ static int tls_opt_dtls_role_set(struct net_context *context,
 	return 0;
 }
 
+static int tls_opt_session_cache_set(struct net_context *context,
+				     const void *optval, socklen_t optlen)
+{
+	int *cache;
+
+	if (!IS_ENABLED(CONFIG_NET_SOCKETS_TLS_SESSION_CACHE)) {
+		return -ENOPROTOOPT;
+	}
+
+	if (!optval) {
+		return -EINVAL;
+	}
+
+	if (optlen != sizeof(int)) {
+		return -EINVAL;
+	}
+
+	cache = (int *)optval;
+	if (*cache != TLS_SESSION_CACHE_DISABLED &&
+	    *cache != TLS_SESSION_CACHE_ENABLED) {
+		return -EINVAL;
+	}
+
+	context->tls->options.cache_enabled =
+		(*cache == TLS_SESSION_CACHE_ENABLED);
+
+	return 0;
+}
+
+static int tls_opt_session_cache_get(struct net_context *context,
+				     void *optval, socklen_t *optlen)
+{
+	if (!IS_ENABLED(CONFIG_NET_SOCKETS_TLS_SESSION_CACHE)) {
+		return -ENOPROTOOPT;
+	}
+
+	if (*optlen != sizeof(int)) {
+		return -EINVAL;
+	}
+
+	*(int *)optval = context->tls->options.cache_enabled ?
+				TLS_SESSION_CACHE_ENABLED :
+				TLS_SESSION_CACHE_DISABLED;
+
+	return 0;
+}
+
+static int tls_opt_session_cache_purge_set(struct net_context *context,
+					   const void *optval,
+					   socklen_t optlen)
+{
+	ARG_UNUSED(context);
+	ARG_UNUSED(optval);
+	ARG_UNUSED(optlen);
+
+#if defined(CONFIG_NET_SOCKETS_TLS_SESSION_CACHE)
+	tls_session_purge();
+
+	return 0;
+#else
+	return -ENOPROTOOPT;
+#endif
+}
+
+static int tls_opt_tx_coalesce_set(struct net_context *context,
+				   const void *optval, socklen_t optlen)
+{
+	int *coalesce;
+
+	if (!IS_ENABLED(CONFIG_NET_SOCKETS_TLS_COALESCE)) {
+		return -ENOPROTOOPT;
+	}
+
+	if (!optval) {
+		return -EINVAL;
+	}
+
+	if (optlen != sizeof(int)) {
+		return -EINVAL;
+	}
+
+	coalesce = (int *)optval;
+	if (*coalesce != 0 && *coalesce != 1) {
+		return -EINVAL;
+	}
+
+	if (!*coalesce && context->tls->options.coalesce) {
+		context->tls->flags = 0;
+
+		if (tls_tx_flush_pending(context) < 0) {
+			return -EIO;
+		}
+	}
+
+	context->tls->options.coalesce = *coalesce;
+
+	return 0;
+}
+
+static int tls_opt_tx_coalesce_get(struct net_context *context,
+				   void *optval, socklen_t *optlen)
+{
+	if (!IS_ENABLED(CONFIG_NET_SOCKETS_TLS_COALESCE)) {
+		return -ENOPROTOOPT;
+	}
+
+	if (*optlen != sizeof(int)) {
+		return -EINVAL;
+	}
+
+	*(int *)optval = context->tls->options.coalesce;
+
+	return 0;
+}
+
 static int ztls_socket(int family, int type, int proto)
 {
 	enum net_ip_protocol_secure tls_proto = 0;
@@ -1188,8 +1790,9 @@ int ztls_close_ctx(struct net_context *ctx)
 
 
 	if (ctx->tls != NULL) {
-		/* Try to send close notification. */
+		/* Try to send the coalesced writes and close notification. */
 		ctx->tls->flags = 0;
+		(void)tls_tx_flush_pending(ctx);
 		(void)mbedtls_ssl_close_notify(&ctx->tls->ssl);
 
 		err = tls_release(ctx->tls);
@@ -1236,13 +1839,18 @@ int ztls_connect_ctx(struct net_context *ctx, const struct sockaddr *addr,
 		/* Do not use any socket flags during the handshake. */
 		ctx->tls->flags = 0;
 
+		tls_session_restore(ctx, addr);
+
 		/* TODO For simplicity, TLS handshake blocks the socket
 		 * even for non-blocking socket.
 		 */
 		ret = tls_mbedtls_handshake(ctx, true);
 		if (ret < 0) {
+			tls_session_forget(ctx, addr);
 			goto error;
 		}
+
+		tls_session_store(ctx, addr, addrlen);
 	} else {
 #if defined(CONFIG_NET_SOCKETS_ENABLE_DTLS)
 		/* Just store the address. */
@@ -1353,6 +1961,17 @@ static ssize_t send_tls(struct net_context *ctx, const void *buf,
 {
 	int ret;
 
+	if (ctx->tls->options.coalesce &&
+	    net_context_get_type(ctx) == SOCK_STREAM && len > 0) {
+		ret = tls_tx_coalesce(ctx, buf, len);
+		if (ret > 0) {
+			return ret;
+		} else if (ret < 0) {
+			errno = -ret;
+			return -1;
+		}
+	}
+
 	ret = mbedtls_ssl_write(&ctx->tls->ssl, buf, len);
 	if (ret >= 0) {
 		return ret;
@@ -1676,6 +2295,16 @@ ssize_t ztls_recvfrom_ctx(struct net_context *ctx, void *buf, size_t max_len,
 
 	/* TLS */
 	if (net_context_get_type(ctx) == SOCK_STREAM) {
+		/* The peer might be waiting for the coalesced writes before
+		 * answering.
+		 */
+		int ret = tls_tx_flush_pending(ctx);
+
+		if (ret < 0) {
+			errno = -ret;
+			return -1;
+		}
+
 		return recv_tls(ctx, buf, max_len, flags);
 	}
 
@@ -1694,6 +2323,58 @@ ssize_t ztls_recvfrom_ctx(struct net_context *ctx, void *buf, size_t max_len,
 #endif /* CONFIG_NET_SOCKETS_ENABLE_DTLS */
 }
 
+/* The data is decrypted into the buffers, so it is always copied. For
+ * TLS the buffers are filled in order, only the first read may block.
+ * A DTLS datagram is read at once, into a single buffer.
+ */
+ssize_t ztls_recvmsg_ctx(struct net_context *ctx, struct msghdr *msg,
+			 int flags)
+{
+	ssize_t len = 0;
+	ssize_t ret;
+	int i;
+
+	msg->msg_flags = 0;
+	msg->msg_controllen = 0;
+
+	if (net_context_get_type(ctx) != SOCK_STREAM) {
+		if (msg->msg_iovlen != 1) {
+			errno = EOPNOTSUPP;
+			return -1;
+		}
+
+		return ztls_recvfrom_ctx(ctx, msg->msg_iov[0].iov_base,
+					 msg->msg_iov[0].iov_len, flags,
+					 msg->msg_name, &msg->msg_namelen);
+	}
+
+	msg->msg_namelen = 0;
+
+	for (i = 0; i < msg->msg_iovlen; i++) {
+		if (msg->msg_iov[i].iov_len == 0) {
+			continue;
+		}
+
+		ret = ztls_recvfrom_ctx(ctx, msg->msg_iov[i].iov_base,
+					msg->msg_iov[i].iov_len,
+					len > 0 ? flags | ZSOCK_MSG_DONTWAIT :
+						  flags,
+					NULL, NULL);
+		if (ret < 0) {
+			/* Return what was already received */
+			return len > 0 ? len : ret;
+		}
+
+		len += ret;
+
+		if (ret < msg->msg_iov[i].iov_len) {
+			break;
+		}
+	}
+
+	return len;
+}
+
 static int ztls_poll_prepare_ctx(struct net_context *ctx,
 				 struct zsock_pollfd *pfd,
 				 struct k_poll_event **pev,
@@ -1704,6 +2385,14 @@ static int ztls_poll_prepare_ctx(struct net_context *ctx,
 		return 0;
 	}
 
+	/* Do not leave the coalesced writes behind while waiting, poll()
+	 * must not block here.
+	 */
+	if (ctx->tls->options.coalesce) {
+		ctx->tls->flags = ZSOCK_MSG_DONTWAIT;
+		(void)tls_tx_flush_pending(ctx);
+	}
+
 	if (pfd->events & ZSOCK_POLLIN) {
 		if (*pev == pev_end) {
 			return -ENOMEM;
@@ -1869,6 +2558,14 @@ int ztls_getsockopt_ctx(struct net_context *ctx, int level, int optname,
 		err = tls_opt_ciphersuite_used_get(ctx, optval, optlen);
 		break;
 
+	case TLS_SESSION_CACHE:
+		err = tls_opt_session_cache_get(ctx, optval, optlen);
+		break;
+
+	case TLS_TX_COALESCE:
+		err = tls_opt_tx_coalesce_get(ctx, optval, optlen);
+		break;
+
 	default:
 		/* Unknown or write-only option. */
 		err = -ENOPROTOOPT;
@@ -1919,6 +2616,18 @@ int ztls_setsockopt_ctx(struct net_context *ctx, int level, int optname,
 		err = tls_opt_dtls_role_set(ctx, optval, optlen);
 		break;
 
+	case TLS_SESSION_CACHE:
+		err = tls_opt_session_cache_set(ctx, optval, optlen);
+		break;
+
+	case TLS_SESSION_CACHE_PURGE:
+		err = tls_opt_session_cache_purge_set(ctx, optval, optlen);
+		break;
+
+	case TLS_TX_COALESCE:
+		err = tls_opt_tx_coalesce_set(ctx, optval, optlen);
+		break;
+
 	default:
 		/* Unknown or read-only option. */
 		err = -ENOPROTOOPT;
@@ -2031,6 +2740,12 @@ static ssize_t tls_sock_recvfrom_vmeth(void *obj, void *buf, size_t max_len,
 				 src_addr, addrlen);
 }
 
+static ssize_t tls_sock_recvmsg_vmeth(void *obj, struct msghdr *msg,
+				      int flags)
+{
+	return ztls_recvmsg_ctx(obj, msg, flags);
+}
+
 static int tls_sock_getsockopt_vmeth(void *obj, int level, int optname,
 				     void *optval, socklen_t *optlen)
 {
@@ -2057,6 +2772,7 @@ static const struct socket_op_vtable tls_sock_fd_op_vtable = {
 	.sendto = tls_sock_sendto_vmeth,
 	.sendmsg = tls_sock_sendmsg_vmeth,
 	.recvfrom = tls_sock_recvfrom_vmeth,
+	.recvmsg = tls_sock_recvmsg_vmeth,
 	.getsockopt = tls_sock_getsockopt_vmeth,
 	.setsockopt = tls_sock_setsockopt_vmeth,
 };
@@ -34,6 +34,10 @@ LOG_MODULE_REGISTER(net_websocket, CONFIG_NET_WEBSOCKET_LOG_LEVEL);
 #include "sockets_internal.h"
 #include "websocket_internal.h"
 
+#if defined(CONFIG_WEBSOCKET_DEFLATE)
+#include "websocket_deflate.h"
+#endif
+
 /* If you want to see the data that is being sent or received,
  * then you can enable debugging and set the following variables to 1.
  * This will print a lot of data so is not enabled by default.
@@ -41,6 +45,11 @@ LOG_MODULE_REGISTER(net_websocket, CONFIG_NET_WEBSOCKET_LOG_LEVEL);
 #define HEXDUMP_SENT_PACKETS 0
 #define HEXDUMP_RECV_PACKETS 0
 
+/* Close codes from RFC 6455 chapter 7.4.1 */
+#define CLOSE_PROTOCOL_ERROR 1002
+#define CLOSE_UNSUPPORTED_DATA 1003
+#define CLOSE_MESSAGE_TOO_BIG 1009
+
 static struct websocket_context contexts[CONFIG_WEBSOCKET_MAX_CONTEXTS];
 
 static struct k_sem contexts_lock;
@@ -50,6 +59,15 @@ static const struct socket_op_vtable websocket_fd_op_vtable;
 
 #if defined(CONFIG_NET_TEST)
 int verify_sent_and_received_msg(struct msghdr *msg, bool split_msg);
+
+/* Websocket unit test does not use socket layer but feeds
+ * the data directly to the receive function.
+ */
+struct test_data {
+	uint8_t *input_buf;
+	size_t input_len;
+	struct websocket_context *ctx;
+};
 #endif
 
 static const char *opcode2str(enum websocket_opcode opcode)
@@ -171,6 +189,7 @@ static int on_header_field(struct http_parser *parser, const char *at,
 						internal.parser);
 	struct websocket_context *ctx = req->internal.user_data;
 	const char *ws_accept_str = "Sec-WebSocket-Accept";
+	const char *ws_ext_str = "Sec-WebSocket-Extensions";
 	uint16_t len;
 
 	len = strlen(ws_accept_str);
@@ -178,6 +197,11 @@ static int on_header_field(struct http_parser *parser, const char *at,
 		ctx->sec_accept_present = true;
 	}
 
+	len = strlen(ws_ext_str);
+	if (length >= len && strncasecmp(at, ws_ext_str, len) == 0) {
+		ctx->ext_present = true;
+	}
+
 	if (ctx->http_cb && ctx->http_cb->on_header_field) {
 		ctx->http_cb->on_header_field(parser, at, length);
 	}
@@ -187,6 +211,21 @@ static int on_header_field(struct http_parser *parser, const char *at,
 
 #define MAX_SEC_ACCEPT_LEN 32
 
+static bool header_value_contains(const char *at, size_t length,
+				  const char *str)
+{
+	size_t len = strlen(str);
+	size_t i;
+
+	for (i = 0; i + len <= length; i++) {
+		if (strncasecmp(&at[i], str, len) == 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
 static int on_header_value(struct http_parser *parser, const char *at,
 			   size_t length)
 {
@@ -216,6 +255,15 @@ static int on_header_value(struct http_parser *parser, const char *at,
 		}
 	}
 
+	if (ctx->ext_present) {
+		ctx->ext_present = false;
+
+		/* The server accepted the extension we offered */
+		ctx->deflate = IS_ENABLED(CONFIG_WEBSOCKET_DEFLATE) &&
+			header_value_contains(at, length,
+					      "permessage-deflate");
+	}
+
 	if (ctx->http_cb && ctx->http_cb->on_header_value) {
 		ctx->http_cb->on_header_value(parser, at, length);
 	}
@@ -246,6 +294,10 @@ int websocket_connect(int sock, struct websocket_request *wreq,
 		"Upgrade: websocket\r\n",
 		"Connection: Upgrade\r\n",
 		"Sec-WebSocket-Version: 13\r\n",
+#if defined(CONFIG_WEBSOCKET_DEFLATE)
+		"Sec-WebSocket-Extensions: permessage-deflate; "
+		"client_no_context_takeover; server_no_context_takeover\r\n",
+#endif
 		NULL
 	};
 
@@ -273,6 +325,9 @@ int websocket_connect(int sock, struct websocket_request *wreq,
 	ctx->tmp_buf_len = wreq->tmp_buf_len;
 	ctx->sec_accept_key = sec_accept_key;
 	ctx->http_cb = wreq->http_cb;
+	ctx->header_received = false;
+	ctx->ext_present = false;
+	ctx->deflate = false;
 
 	mbedtls_sha1_ret((const unsigned char *)&rnd_value, sizeof(rnd_value),
 			 sec_accept_key);
@@ -384,6 +439,9 @@ int websocket_connect(int sock, struct websocket_request *wreq,
 	 * in order that to work the amount of data in buffer must be set to 0
 	 */
 	ctx->tmp_buf_pos = 0;
+	ctx->compressed_len = 0;
+	ctx->inflating = false;
+	ctx->failed = false;
 
 	return fd;
 
@@ -437,6 +495,42 @@ static int websocket_ioctl_vmeth(void *obj, unsigned int request, va_list args)
 	return sock_fd_op_vtable.fd_vtable.ioctl(obj, request, args);
 }
 
+/* XOR len bytes of src with the masking key into dst, which may be src.
+ * The key is applied from its byte at offset modulo 4, so that a message
+ * can be unmasked in parts. Most of the data is processed a word at a time.
+ */
+static void websocket_mask(uint8_t *dst, const uint8_t *src, size_t len,
+			   uint32_t masking_value, uint64_t offset)
+{
+	uint8_t key[sizeof(uint32_t)];
+	uint8_t rotated[sizeof(uint32_t)];
+	uint32_t word_key;
+	size_t i = 0;
+	int j;
+
+	sys_put_be32(masking_value, key);
+
+	for (; i < len && ((uintptr_t)&dst[i] & (sizeof(uint32_t) - 1)); i++) {
+		dst[i] = src[i] ^ key[(offset + i) % 4];
+	}
+
+	/* The key as it lines up with the words of dst, in memory order */
+	for (j = 0; j < sizeof(rotated); j++) {
+		rotated[j] = key[(offset + i + j) % 4];
+	}
+
+	memcpy(&word_key, rotated, sizeof(word_key));
+
+	for (; i + sizeof(uint32_t) <= len; i += sizeof(uint32_t)) {
+		*(uint32_t *)&dst[i] = UNALIGNED_GET((uint32_t *)&src[i]) ^
+				       word_key;
+	}
+
+	for (; i < len; i++) {
+		dst[i] = src[i] ^ key[(offset + i) % 4];
+	}
+}
+
 static int websocket_prepare_and_send(struct websocket_context *ctx,
 				      uint8_t *header, size_t header_len,
 				      uint8_t *payload, size_t payload_len,
@@ -467,23 +561,76 @@ static int websocket_prepare_and_send(struct websocket_context *ctx,
 	return verify_sent_and_received_msg(&msg, !(header[1] & BIT(7)));
 #else
 	k_timeout_t tout = K_FOREVER;
+	ssize_t ret;
 
 	if (timeout != SYS_FOREVER_MS) {
 		tout = K_MSEC(timeout);
 	}
 
-	return sendmsg(ctx->real_sock, &msg,
-		       K_TIMEOUT_EQ(tout, K_NO_WAIT) ? MSG_DONTWAIT : 0);
+	ret = zsock_sendmsg_all(ctx->real_sock, &msg,
+				K_TIMEOUT_EQ(tout, K_NO_WAIT) ?
+				ZSOCK_MSG_DONTWAIT : 0);
+	if (ret < 0) {
+		return -errno;
+	}
+
+	return ret;
 #endif /* CONFIG_NET_TEST */
 }
 
-int websocket_send_msg(int ws_sock, const uint8_t *payload, size_t payload_len,
-		       enum websocket_opcode opcode, bool mask, bool final,
-		       int32_t timeout)
+#if defined(CONFIG_WEBSOCKET_DEFLATE)
+/* Compress a final data message into a buffer allocated from the heap,
+ * which starts with the work area of the compressor. *buf is left NULL if
+ * the message is to be sent as is.
+ */
+static int websocket_compress(struct websocket_context *ctx,
+			      const uint8_t *payload, size_t payload_len,
+			      enum websocket_opcode opcode, bool final,
+			      uint8_t **buf)
+{
+	uint8_t *out;
+	int ret;
+
+	*buf = NULL;
+
+	if (!ctx->deflate || !final ||
+	    payload_len < CONFIG_WEBSOCKET_DEFLATE_MIN_SIZE ||
+	    (opcode != WEBSOCKET_OPCODE_DATA_TEXT &&
+	     opcode != WEBSOCKET_OPCODE_DATA_BINARY)) {
+		return 0;
+	}
+
+	out = k_malloc(WS_DEFLATE_WORK_SIZE + payload_len);
+	if (!out) {
+		return -ENOMEM;
+	}
+
+	/* Only keep the compressed message if it is smaller */
+	ret = websocket_deflate(payload, payload_len,
+				out + WS_DEFLATE_WORK_SIZE, payload_len - 1,
+				out);
+	if (ret < 0) {
+		k_free(out);
+		return 0;
+	}
+
+	*buf = out;
+
+	return ret;
+}
+#endif /* CONFIG_WEBSOCKET_DEFLATE */
+
+static int websocket_send_common(int ws_sock, const uint8_t *payload,
+				 size_t payload_len,
+				 enum websocket_opcode opcode, bool mask,
+				 bool final, bool in_place, int32_t timeout)
 {
 	struct websocket_context *ctx;
 	uint8_t header[MAX_HEADER_LEN], hdr_len = 2;
 	uint8_t *data_to_send = (uint8_t *)payload;
+	size_t len = payload_len;
+	uint8_t *buf = NULL;
+	bool compressed = false;
 	int ret;
 
 	if (opcode != WEBSOCKET_OPCODE_DATA_TEXT &&
@@ -514,23 +661,40 @@ int websocket_send_msg(int ws_sock, const uint8_t *payload, size_t payload_len,
 	NET_DBG("[%p] Len %zd %s/%d/%s", ctx, payload_len, opcode2str(opcode),
 		mask, final ? "final" : "more");
 
+#if defined(CONFIG_WEBSOCKET_DEFLATE)
+	ret = websocket_compress(ctx, payload, payload_len, opcode, final,
+				 &buf);
+	if (ret < 0) {
+		return ret;
+	}
+
+	if (buf) {
+		data_to_send = buf + WS_DEFLATE_WORK_SIZE;
+		len = ret;
+		compressed = true;
+	}
+#endif
+
 	memset(header, 0, sizeof(header));
 
 	/* Is this the last packet? */
 	header[0] = final ? BIT(7) : 0;
 
+	/* RSV1 marks a compressed message */
+	header[0] |= compressed ? BIT(6) : 0;
+
 	/* Text, binary, ping, pong or close ? */
 	header[0] |= opcode;
 
 	/* Masking */
 	header[1] = mask ? BIT(7) : 0;
 
-	if (payload_len < 126) {
-		header[1] |= payload_len;
-	} else if (payload_len < 65536) {
+	if (len < 126) {
+		header[1] |= len;
+	} else if (len < 65536) {
 		header[1] |= 126;
-		header[2] = payload_len >> 8;
-		header[3] = payload_len;
+		header[2] = len >> 8;
+		header[3] = len;
 		hdr_len += 2;
 	} else {
 		header[1] |= 127;
@@ -538,17 +702,15 @@ int websocket_send_msg(int ws_sock, const uint8_t *payload, size_t payload_len,
 		header[3] = 0;
 		header[4] = 0;
 		header[5] = 0;
-		header[6] = payload_len >> 24;
-		header[7] = payload_len >> 16;
-		header[8] = payload_len >> 8;
-		header[9] = payload_len;
+		header[6] = len >> 24;
+		header[7] = len >> 16;
+		header[8] = len >> 8;
+		header[9] = len;
 		hdr_len += 8;
 	}
 
 	/* Add masking value if needed */
 	if (mask) {
-		int i;
-
 		ctx->masking_value = sys_rand32_get();
 
 		header[hdr_len++] |= ctx->masking_value >> 24;
@@ -556,38 +718,58 @@ int websocket_send_msg(int ws_sock, const uint8_t *payload, size_t payload_len,
 		header[hdr_len++] |= ctx->masking_value >> 8;
 		header[hdr_len++] |= ctx->masking_value;
 
-		data_to_send = k_malloc(payload_len);
-		if (!data_to_send) {
-			return -ENOMEM;
-		}
-
-		memcpy(data_to_send, payload, payload_len);
+		/* The payload of the caller is only copied if it must be
+		 * kept intact, the copy is masked on the fly.
+		 */
+		if (!buf && !in_place) {
+			buf = k_malloc(len);
+			if (!buf) {
+				return -ENOMEM;
+			}
 
-		for (i = 0; i < payload_len; i++) {
-			data_to_send[i] ^=
-				ctx->masking_value >> (8 * (3 - i % 4));
+			websocket_mask(buf, payload, len, ctx->masking_value,
+				       0);
+			data_to_send = buf;
+		} else {
+			websocket_mask(data_to_send, data_to_send, len,
+				       ctx->masking_value, 0);
 		}
 	}
 
 	ret = websocket_prepare_and_send(ctx, header, hdr_len,
-					 data_to_send, payload_len, timeout);
+					 data_to_send, len, timeout);
+
+	k_free(buf);
+
 	if (ret < 0) {
-		NET_DBG("Cannot send ws msg (%d)", -errno);
-		goto quit;
+		NET_DBG("Cannot send ws msg (%d)", ret);
+		return ret;
 	}
 
-quit:
-	if (data_to_send != payload) {
-		k_free(data_to_send);
-	}
+	return compressed ? payload_len : ret - hdr_len;
+}
 
-	return ret - hdr_len;
+int websocket_send_msg(int ws_sock, const uint8_t *payload, size_t payload_len,
+		       enum websocket_opcode opcode, bool mask, bool final,
+		       int32_t timeout)
+{
+	return websocket_send_common(ws_sock, payload, payload_len, opcode,
+				     mask, final, false, timeout);
+}
+
+int websocket_send_msg_in_place(int ws_sock, uint8_t *payload,
+				size_t payload_len,
+				enum websocket_opcode opcode, bool mask,
+				bool final, int32_t timeout)
+{
+	return websocket_send_common(ws_sock, payload, payload_len, opcode,
+				     mask, final, true, timeout);
 }
 
 static bool websocket_parse_header(uint8_t *buf, size_t buf_len, bool *masked,
 				   uint32_t *mask_value, uint64_t *message_length,
 				   uint32_t *message_type_flag,
-				   size_t *header_len)
+				   bool *compressed, size_t *header_len)
 {
 	uint8_t len_len; /* length of the length field in header */
 	uint8_t len;     /* message length byte */
@@ -598,6 +780,9 @@ static bool websocket_parse_header(uint8_t *buf, size_t buf_len, bool *masked,
 		*message_type_flag |= WEBSOCKET_FLAG_FINAL;
 	}
 
+	/* RSV1 is set on the first frame of a compressed message */
+	*compressed = !!(value & 0x4000);
+
 	switch (value & 0x0f00) {
 	case 0x0100:
 		*message_type_flag |= WEBSOCKET_FLAG_TEXT;
@@ -648,13 +833,232 @@ static bool websocket_parse_header(uint8_t *buf, size_t buf_len, bool *masked,
 	return false;
 }
 
+/* Parse the header in tmp_buf, which follows the compressed data gathered
+ * so far, if all of it is there.
+ */
+static bool websocket_header_buffered(struct websocket_context *ctx,
+				      size_t *header_len)
+{
+	size_t len = ctx->tmp_buf_pos - ctx->compressed_len;
+	bool masked, compressed;
+
+	if (len < MIN_HEADER_LEN) {
+		return false;
+	}
+
+	ctx->message_type = 0U;
+
+	if (!websocket_parse_header(&ctx->tmp_buf[ctx->compressed_len], len,
+				    &masked, &ctx->masking_value,
+				    &ctx->message_len, &ctx->message_type,
+				    &compressed, header_len) ||
+	    len < *header_len) {
+		return false;
+	}
+
+	ctx->masked = masked;
+	ctx->compressed = compressed;
+
+	return true;
+}
+
+/* Read at most len bytes from the peer */
+static int websocket_read(struct websocket_context *ctx, void *input,
+			  uint8_t *buf, size_t len, k_timeout_t tout)
+{
+#if defined(CONFIG_NET_TEST)
+	struct test_data *test_data = input;
+	size_t input_len = MIN(len, test_data->input_len);
+
+	if (input_len == 0) {
+		return -EAGAIN;
+	}
+
+	memcpy(buf, test_data->input_buf, input_len);
+	test_data->input_buf += input_len;
+	test_data->input_len -= input_len;
+
+	return input_len;
+#else
+	ssize_t ret;
+
+	ret = recv(ctx->real_sock, buf, len,
+		   K_TIMEOUT_EQ(tout, K_NO_WAIT) ? MSG_DONTWAIT : 0);
+	if (ret < 0) {
+		return -errno;
+	}
+
+	return ret;
+#endif /* CONFIG_NET_TEST */
+}
+
+static void websocket_message_done(struct websocket_context *ctx)
+{
+	ctx->header_received = false;
+	ctx->message_len = 0;
+	ctx->total_read = 0;
+}
+
+/* Fail the connection, as in RFC 6455 chapter 7.1.7, on a frame which
+ * cannot be received. The peer is sent a close frame with the given code
+ * and the context cannot receive anything more.
+ */
+static int websocket_fail(struct websocket_context *ctx, uint16_t code,
+			  int err, int32_t timeout)
+{
+	uint8_t payload[2];
+
+	NET_DBG("[%p] Failing connection with %u (%d)", ctx, code, err);
+
+	ctx->failed = true;
+
+	sys_put_be16(code, payload);
+
+#if !defined(CONFIG_NET_TEST)
+	(void)websocket_send_msg(ctx->sock, payload, sizeof(payload),
+				 WEBSOCKET_OPCODE_CLOSE, true, true, timeout);
+#endif
+
+	return err;
+}
+
+/* Check the header of a frame against the message being received, and
+ * tell if the frame is part of a compressed message.
+ */
+static int websocket_check_frame(struct websocket_context *ctx,
+				 int32_t timeout)
+{
+	uint32_t data = ctx->message_type &
+			(WEBSOCKET_FLAG_TEXT | WEBSOCKET_FLAG_BINARY);
+	/* WEBSOCKET_FLAG_PONG is the ping flag along with the final one */
+	bool control = ctx->message_type & (WEBSOCKET_FLAG_CLOSE |
+					    WEBSOCKET_FLAG_PING);
+	size_t room;
+
+	if (ctx->compressed) {
+		/* RSV1 is only set on the first frame of a data message */
+		if (!IS_ENABLED(CONFIG_WEBSOCKET_DEFLATE) || !ctx->deflate ||
+		    !data || ctx->inflating) {
+			return websocket_fail(ctx, CLOSE_UNSUPPORTED_DATA,
+					      -ENOTSUP, timeout);
+		}
+
+		ctx->inflating = true;
+		ctx->compressed_type = data;
+	} else if (ctx->inflating) {
+		if (data) {
+			/* A new message before the end of the previous one */
+			return websocket_fail(ctx, CLOSE_PROTOCOL_ERROR,
+					      -EPROTO, timeout);
+		}
+
+		/* Control frames may come between the fragments */
+		ctx->compressed = !control;
+	}
+
+	if (!ctx->compressed) {
+		return 0;
+	}
+
+	/* All of the compressed message must fit in tmp_buf, and the header
+	 * of the next fragment along with it.
+	 */
+	room = ctx->tmp_buf_len - ctx->compressed_len;
+	if (!(ctx->message_type & WEBSOCKET_FLAG_FINAL)) {
+		room = room > MAX_HEADER_LEN ? room - MAX_HEADER_LEN : 0;
+	}
+
+	if (ctx->message_len > room) {
+		return websocket_fail(ctx, CLOSE_MESSAGE_TOO_BIG, -EMSGSIZE,
+				      timeout);
+	}
+
+	return 0;
+}
+
+#if defined(CONFIG_WEBSOCKET_DEFLATE)
+/* The fragments of a compressed message are gathered in tmp_buf, and the
+ * message is inflated into the buffer of the caller, which must hold all
+ * of it, when the final fragment is received.
+ */
+static int websocket_recv_compressed(struct websocket_context *ctx,
+				     void *input, uint8_t *buf,
+				     size_t buf_len, uint64_t *remaining,
+				     k_timeout_t tout)
+{
+	struct ws_inflate_work *work = NULL;
+	uint8_t *data = &ctx->tmp_buf[ctx->compressed_len];
+	size_t end = ctx->compressed_len + ctx->message_len;
+	bool final = ctx->message_type & WEBSOCKET_FLAG_FINAL;
+	int ret;
+
+	if (ctx->tmp_buf_pos < end) {
+		ret = websocket_read(ctx, input, &ctx->tmp_buf[ctx->tmp_buf_pos],
+				     end - ctx->tmp_buf_pos, tout);
+		if (ret <= 0) {
+			return ret;
+		}
+
+		ctx->tmp_buf_pos += ret;
+		if (ctx->tmp_buf_pos < end) {
+			return -EAGAIN;
+		}
+	}
+
+	if (final) {
+		work = k_malloc(sizeof(*work));
+		if (!work) {
+			return -ENOMEM;
+		}
+	}
+
+	if (ctx->masked) {
+		websocket_mask(data, data, ctx->message_len,
+			       ctx->masking_value, 0);
+	}
+
+	ctx->compressed_len = end;
+
+	websocket_message_done(ctx);
+
+	if (!final) {
+		/* Wait for the next fragment */
+		return -EAGAIN;
+	}
+
+	ret = websocket_inflate(ctx->tmp_buf, ctx->compressed_len, buf,
+				buf_len, work);
+
+	k_free(work);
+
+	if (ret < 0) {
+		NET_DBG("[%p] Cannot inflate message (%d)", ctx, ret);
+	}
+
+	/* The message is consumed even if it could not be inflated */
+	ctx->tmp_buf_pos -= ctx->compressed_len;
+	memmove(ctx->tmp_buf, &ctx->tmp_buf[ctx->compressed_len],
+		ctx->tmp_buf_pos);
+
+	ctx->compressed_len = 0;
+	ctx->inflating = false;
+
+	if (remaining) {
+		*remaining = 0;
+	}
+
+	return ret;
+}
+#endif /* CONFIG_WEBSOCKET_DEFLATE */
+
 int websocket_recv_msg(int ws_sock, uint8_t *buf, size_t buf_len,
 		       uint32_t *message_type, uint64_t *remaining, int32_t timeout)
 {
 	struct websocket_context *ctx;
+	void *input = NULL;
 	size_t header_len = 0;
 	int recv_len = 0;
-	size_t can_copy, left;
+	size_t to_read;
 	int ret;
 	k_timeout_t tout = K_FOREVER;
 
@@ -663,18 +1067,10 @@ int websocket_recv_msg(int ws_sock, uint8_t *buf, size_t buf_len,
 	}
 
 #if defined(CONFIG_NET_TEST)
-	/* Websocket unit test does not use socket layer but feeds
-	 * the data directly here when testing this function.
-	 */
-	struct test_data {
-		uint8_t *input_buf;
-		size_t input_len;
-		struct websocket_context *ctx;
-	};
-
 	struct test_data *test_data = INT_TO_POINTER(ws_sock);
 
 	ctx = test_data->ctx;
+	input = test_data;
 #else
 	ctx = z_get_fd_obj(ws_sock, NULL, 0);
 	if (ctx == NULL) {
@@ -686,60 +1082,43 @@ int websocket_recv_msg(int ws_sock, uint8_t *buf, size_t buf_len,
 	}
 #endif /* CONFIG_NET_TEST */
 
-	/* If we have not received the websocket header yet, read it first */
+	if (ctx->failed) {
+		return -ECONNABORTED;
+	}
+
+	/* If we have not received the websocket header yet, read it first,
+	 * unless it came along with the previous message.
+	 */
 	if (!ctx->header_received) {
-#if defined(CONFIG_NET_TEST)
-		size_t input_len = MIN(ctx->tmp_buf_len - ctx->tmp_buf_pos,
-				       test_data->input_len);
+		if (!websocket_header_buffered(ctx, &header_len)) {
+			ret = websocket_read(ctx, input,
+					     &ctx->tmp_buf[ctx->tmp_buf_pos],
+					     ctx->tmp_buf_len - ctx->tmp_buf_pos,
+					     tout);
+			if (ret <= 0) {
+				/* Error or socket closed */
+				return ret;
+			}
 
-		memcpy(&ctx->tmp_buf[ctx->tmp_buf_pos], test_data->input_buf,
-		       input_len);
-		test_data->input_buf += input_len;
-		ret = input_len;
-#else
-		ret = recv(ctx->real_sock, &ctx->tmp_buf[ctx->tmp_buf_pos],
-			   ctx->tmp_buf_len - ctx->tmp_buf_pos,
-			   K_TIMEOUT_EQ(tout, K_NO_WAIT) ? MSG_DONTWAIT : 0);
-#endif /* CONFIG_NET_TEST */
+			ctx->tmp_buf_pos += ret;
 
-		if (ret < 0) {
-			return -errno;
+			if (!websocket_header_buffered(ctx, &header_len)) {
+				return -EAGAIN;
+			}
 		}
 
-		if (ret == 0) {
-			/* Socket closed */
-			return 0;
+		ret = websocket_check_frame(ctx, timeout);
+		if (ret < 0) {
+			return ret;
 		}
 
-		ctx->tmp_buf_pos += ret;
-
-		if (ctx->tmp_buf_pos >= MIN_HEADER_LEN) {
-			bool masked;
+		if (message_type) {
+			*message_type = ctx->message_type;
 
-			/* Now we will be able to figure out what is the
-			 * actual size of the header.
-			 */
-			if (websocket_parse_header(&ctx->tmp_buf[0],
-						   ctx->tmp_buf_pos,
-						   &masked,
-						   &ctx->masking_value,
-						   &ctx->message_len,
-						   &ctx->message_type,
-						   &header_len)) {
-				ctx->masked = masked;
-
-				if (message_type) {
-					*message_type = ctx->message_type;
-				}
-			} else {
-				return -EAGAIN;
+			/* Continuation frames tell the type of the message */
+			if (ctx->compressed) {
+				*message_type |= ctx->compressed_type;
 			}
-		} else {
-			return -EAGAIN;
-		}
-
-		if (ctx->tmp_buf_pos < header_len) {
-			return -EAGAIN;
 		}
 
 		/* All of the header is now received, we can read the payload
@@ -758,89 +1137,75 @@ int websocket_recv_msg(int ws_sock, uint8_t *buf, size_t buf_len,
 
 		ctx->total_read = 0;
 
-		memmove(ctx->tmp_buf, &ctx->tmp_buf[header_len],
-			ctx->tmp_buf_len - header_len);
 		ctx->tmp_buf_pos -= header_len;
+		memmove(&ctx->tmp_buf[ctx->compressed_len],
+			&ctx->tmp_buf[ctx->compressed_len + header_len],
+			ctx->tmp_buf_pos - ctx->compressed_len);
 
-		if (ctx->tmp_buf_pos == 0) {
+		if (ctx->tmp_buf_pos == ctx->compressed_len &&
+		    ctx->message_len > 0 && !ctx->compressed) {
 			/* No data after the header, let the caller call
 			 * this function again to get the payload.
 			 */
 			return -EAGAIN;
 		}
 
-		NET_DBG("There is %zd bytes of data", ctx->tmp_buf_pos);
+		NET_DBG("There is %zd bytes of data",
+			ctx->tmp_buf_pos - ctx->compressed_len);
 	}
 
-	/* Now read the whole payload or parts of it */
-
-	if (ctx->tmp_buf_pos == 0) {
-		/* Read more data into temp buffer */
-#if defined(CONFIG_NET_TEST)
-		size_t input_len = MIN(ctx->tmp_buf_len, test_data->input_len);
-
-		memcpy(ctx->tmp_buf, test_data->input_buf, input_len);
-		test_data->input_buf += input_len;
+#if defined(CONFIG_WEBSOCKET_DEFLATE)
+	if (ctx->compressed) {
+		return websocket_recv_compressed(ctx, input, buf, buf_len,
+						 remaining, tout);
+	}
+#endif
 
-		ret = input_len;
-#else
-		ret = recv(ctx->real_sock, ctx->tmp_buf, ctx->tmp_buf_len,
-			   K_TIMEOUT_EQ(tout, K_NO_WAIT) ? MSG_DONTWAIT : 0);
-#endif /* CONFIG_NET_TEST */
+	/* Now read the whole payload or parts of it */
 
-		if (ret < 0) {
-			return -errno;
-		}
+	if (ctx->tmp_buf_pos > ctx->compressed_len) {
+		/* Return the data read along with the header first. It
+		 * follows the compressed data of the fragments received so
+		 * far, if this is a control frame between them.
+		 */
+		uint8_t *data = &ctx->tmp_buf[ctx->compressed_len];
 
-		if (ret == 0) {
-			return 0;
-		}
+		recv_len = MIN(MIN(ctx->message_len - ctx->total_read,
+				   ctx->tmp_buf_pos - ctx->compressed_len),
+			       buf_len);
 
-		ctx->tmp_buf_pos = ret;
-	}
+		memcpy(buf, data, recv_len);
 
-	if (ctx->tmp_buf_pos <= buf_len) {
-		/* Is there already any data in the temp buffer? If yes,
-		 * just return it to the caller.
-		 */
-		can_copy = MIN(ctx->message_len - ctx->total_read,
-			       ctx->tmp_buf_pos);
+		ctx->tmp_buf_pos -= recv_len;
+		memmove(data, data + recv_len,
+			ctx->tmp_buf_pos - ctx->compressed_len);
 	} else {
-		/* We have more data in tmp buffer that will fit into
-		 * user buffer.
+		/* Read straight into the buffer of the caller, but not past
+		 * the end of the message so that the next header is read
+		 * into the temp buffer.
 		 */
-		can_copy = MIN(ctx->message_len - ctx->total_read, buf_len);
-	}
-
-	left = ctx->tmp_buf_pos - can_copy;
-
-	NET_ASSERT(ctx->tmp_buf_pos >= can_copy);
-
-	memmove(buf, ctx->tmp_buf, can_copy);
-	recv_len = can_copy;
+		to_read = MIN(ctx->message_len - ctx->total_read, buf_len);
+		if (to_read > 0) {
+			ret = websocket_read(ctx, input, buf, to_read, tout);
+			if (ret <= 0) {
+				return ret;
+			}
 
-	if (left > 0) {
-		memmove(ctx->tmp_buf, &ctx->tmp_buf[can_copy], left);
+			recv_len = ret;
+		}
 	}
 
-	ctx->tmp_buf_pos = left;
-	ctx->total_read += recv_len;
-
-	/* Unmask the data */
+	/* Unmask the data in place. As we might have read a part of the
+	 * message which does not start at a multiple of 4 bytes, the key
+	 * is applied from the matching byte.
+	 */
 	if (ctx->masked) {
-		/* As we might have less than 4 received bytes, we must select
-		 * which byte from masking value to take. The mask_shift will
-		 * tell that.
-		 */
-		int mask_shift = (ctx->total_read - recv_len) % sizeof(uint32_t);
-		int i;
-
-		for (i = 0; i < recv_len; i++) {
-			buf[i] ^= ctx->masking_value >>
-				(8 * (3 - (i + mask_shift) % 4));
-		}
+		websocket_mask(buf, buf, recv_len, ctx->masking_value,
+			       ctx->total_read);
 	}
 
+	ctx->total_read += recv_len;
+
 #if HEXDUMP_RECV_PACKETS
 	LOG_HEXDUMP_DBG(buf, recv_len, "Payload");
 #endif
@@ -851,9 +1216,7 @@ int websocket_recv_msg(int ws_sock, uint8_t *buf, size_t buf_len,
 
 	/* Start to read the header again if all the data has been received */
 	if (ctx->message_len == ctx->total_read) {
-		ctx->header_received = false;
-		ctx->message_len = 0;
-		ctx->total_read = 0;
+		websocket_message_done(ctx);
 	}
 
 	return recv_len;
@@ -0,0 +1,523 @@
+/** @file
+ * @brief Websocket permessage-deflate extension
+ *
+ * Raw DEFLATE (RFC 1951) compression and decompression of Websocket
+ * messages, as used by the permessage-deflate extension (RFC 7692).
+ */
+
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/util.h>
+
+#include "websocket_deflate.h"
+
+#define MIN_MATCH 3
+#define MAX_MATCH 258
+#define MAX_DISTANCE 32768
+
+#define END_OF_BLOCK 256
+
+#define BTYPE_STORED 0
+#define BTYPE_FIXED 1
+#define BTYPE_DYNAMIC 2
+
+static const uint16_t len_base[29] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+static const uint8_t len_extra[29] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+static const uint16_t dist_base[30] = {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193,
+	12289, 16385, 24577
+};
+
+static const uint8_t dist_extra[30] = {
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+	7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+/* Order of the code length code lengths in a dynamic block header */
+static const uint8_t clen_order[19] = {
+	16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+struct bit_writer {
+	uint8_t *dst;
+	size_t len;
+	size_t pos;
+	uint32_t bits;
+	uint8_t count;
+	bool overflow;
+};
+
+struct bit_reader {
+	const uint8_t *src;
+	size_t len;
+	size_t pos;
+	uint32_t bits;
+	uint8_t count;
+	bool eof;
+};
+
+static void put_bits(struct bit_writer *w, uint32_t value, uint8_t count)
+{
+	w->bits |= value << w->count;
+	w->count += count;
+
+	while (w->count >= 8) {
+		if (w->pos < w->len) {
+			w->dst[w->pos++] = w->bits;
+		} else {
+			w->overflow = true;
+		}
+
+		w->bits >>= 8;
+		w->count -= 8;
+	}
+}
+
+/* Huffman codes are packed starting with their most significant bit */
+static void put_code(struct bit_writer *w, uint16_t code, uint8_t len)
+{
+	uint16_t reversed = 0U;
+	uint8_t i;
+
+	for (i = 0U; i < len; i++) {
+		reversed = (reversed << 1) | (code & 1U);
+		code >>= 1;
+	}
+
+	put_bits(w, reversed, len);
+}
+
+static void put_literal(struct bit_writer *w, uint16_t value)
+{
+	if (value < 144) {
+		put_code(w, 0x30 + value, 8);
+	} else if (value < 256) {
+		put_code(w, 0x190 + value - 144, 9);
+	} else if (value < 280) {
+		put_code(w, value - 256, 7);
+	} else {
+		put_code(w, 0xc0 + value - 280, 8);
+	}
+}
+
+static void put_match(struct bit_writer *w, size_t len, size_t dist)
+{
+	int i;
+
+	for (i = ARRAY_SIZE(len_base) - 1; len < len_base[i]; i--) {
+	}
+
+	put_literal(w, END_OF_BLOCK + 1 + i);
+	put_bits(w, len - len_base[i], len_extra[i]);
+
+	for (i = ARRAY_SIZE(dist_base) - 1; dist < dist_base[i]; i--) {
+	}
+
+	put_code(w, i, 5);
+	put_bits(w, dist - dist_base[i], dist_extra[i]);
+}
+
+static inline uint32_t hash(const uint8_t *p)
+{
+	uint32_t v = p[0] | (p[1] << 8) | (p[2] << 16);
+
+	return (v * 2654435761U) >> (32 - WS_DEFLATE_HASH_BITS);
+}
+
+int websocket_deflate(const uint8_t *src, size_t len, uint8_t *dst,
+		      size_t dst_len, void *work)
+{
+	struct bit_writer w = {
+		.dst = dst,
+		.len = dst_len,
+	};
+	/* Position + 1 of the last string starting with each hash, modulo
+	 * 2^16, 0 if none
+	 */
+	uint16_t *head = work;
+	size_t best_len, dist = 0;
+	size_t cand, max, i, k;
+	uint16_t stored;
+
+	memset(head, 0, WS_DEFLATE_WORK_SIZE);
+
+	put_bits(&w, BTYPE_FIXED << 1, 3);
+
+	for (i = 0; i < len && !w.overflow; ) {
+		best_len = 0;
+
+		if (i + MIN_MATCH <= len) {
+			uint32_t h = hash(&src[i]);
+
+			stored = head[h];
+			head[h] = i + 1;
+
+			cand = (i & ~0xffffUL) | (uint16_t)(stored - 1U);
+			if (cand >= i) {
+				cand = cand >= 0x10000 ? cand - 0x10000 : i;
+			}
+
+			if (stored && cand < i && i - cand <= MAX_DISTANCE) {
+				dist = i - cand;
+				max = MIN(MAX_MATCH, len - i);
+
+				while (best_len < max &&
+				       src[cand + best_len] == src[i + best_len]) {
+					best_len++;
+				}
+			}
+		}
+
+		if (best_len < MIN_MATCH) {
+			put_literal(&w, src[i]);
+			i++;
+			continue;
+		}
+
+		put_match(&w, best_len, dist);
+
+		for (k = 1; k < best_len && i + k + MIN_MATCH <= len; k++) {
+			head[hash(&src[i + k])] = i + k + 1;
+		}
+
+		i += best_len;
+	}
+
+	put_literal(&w, END_OF_BLOCK);
+
+	/* Empty stored block, its LEN and NLEN are the removed octets */
+	put_bits(&w, BTYPE_STORED << 1, 3);
+	put_bits(&w, 0, (8 - w.count) % 8);
+
+	if (w.overflow) {
+		return -ENOSPC;
+	}
+
+	return w.pos;
+}
+
+static uint32_t get_bits(struct bit_reader *r, uint8_t count)
+{
+	uint32_t value;
+
+	while (r->count < count) {
+		if (r->pos == r->len) {
+			r->eof = true;
+			return 0;
+		}
+
+		r->bits |= (uint32_t)r->src[r->pos++] << r->count;
+		r->count += 8;
+	}
+
+	value = r->bits & (BIT(count) - 1);
+	r->bits >>= count;
+	r->count -= count;
+
+	return value;
+}
+
+static int huffman_build(struct ws_huffman *t, const uint8_t *lengths,
+			 size_t n)
+{
+	uint16_t offs[16];
+	int left = 1;
+	int i;
+
+	memset(t->counts, 0, sizeof(t->counts));
+
+	for (i = 0; i < n; i++) {
+		t->counts[lengths[i]]++;
+	}
+
+	t->counts[0] = 0U;
+
+	for (i = 1; i < 16; i++) {
+		left = (left << 1) - t->counts[i];
+		if (left < 0) {
+			return -EINVAL;
+		}
+	}
+
+	offs[1] = 0U;
+	for (i = 1; i < 15; i++) {
+		offs[i + 1] = offs[i] + t->counts[i];
+	}
+
+	for (i = 0; i < n; i++) {
+		if (lengths[i]) {
+			t->symbols[offs[lengths[i]]++] = i;
+		}
+	}
+
+	return 0;
+}
+
+static int huffman_decode(struct bit_reader *r, const struct ws_huffman *t)
+{
+	int code = 0, first = 0, index = 0;
+	int len;
+
+	for (len = 1; len < 16; len++) {
+		code |= get_bits(r, 1);
+
+		if (code - first < t->counts[len]) {
+			return t->symbols[index + code - first];
+		}
+
+		index += t->counts[len];
+		first = (first + t->counts[len]) << 1;
+		code <<= 1;
+	}
+
+	return -EINVAL;
+}
+
+static int build_fixed(struct ws_inflate_work *work)
+{
+	uint8_t *lengths = work->lengths;
+	int i;
+
+	for (i = 0; i < 288; i++) {
+		lengths[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+	}
+
+	for (i = 0; i < 30; i++) {
+		lengths[288 + i] = 5;
+	}
+
+	if (huffman_build(&work->lit, lengths, 288) < 0 ||
+	    huffman_build(&work->dist, lengths + 288, 30) < 0) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int build_dynamic(struct bit_reader *r, struct ws_inflate_work *work)
+{
+	uint8_t *lengths = work->lengths;
+	int hlit, hdist, hclen;
+	int n, sym, rep;
+	uint8_t prev;
+	int i;
+
+	hlit = get_bits(r, 5) + 257;
+	hdist = get_bits(r, 5) + 1;
+	hclen = get_bits(r, 4) + 4;
+
+	memset(lengths, 0, ARRAY_SIZE(clen_order));
+
+	for (i = 0; i < hclen; i++) {
+		lengths[clen_order[i]] = get_bits(r, 3);
+	}
+
+	/* The code length code is kept in the literal table until the
+	 * code lengths are read.
+	 */
+	if (r->eof || huffman_build(&work->lit, lengths,
+				    ARRAY_SIZE(clen_order)) < 0) {
+		return -EINVAL;
+	}
+
+	for (n = 0; n < hlit + hdist; ) {
+		sym = huffman_decode(r, &work->lit);
+		if (sym < 0 || r->eof) {
+			return -EINVAL;
+		}
+
+		if (sym < 16) {
+			lengths[n++] = sym;
+			continue;
+		}
+
+		prev = 0U;
+
+		if (sym == 16) {
+			if (n == 0) {
+				return -EINVAL;
+			}
+
+			prev = lengths[n - 1];
+			rep = 3 + get_bits(r, 2);
+		} else if (sym == 17) {
+			rep = 3 + get_bits(r, 3);
+		} else {
+			rep = 11 + get_bits(r, 7);
+		}
+
+		if (n + rep > hlit + hdist) {
+			return -EINVAL;
+		}
+
+		memset(&lengths[n], prev, rep);
+		n += rep;
+	}
+
+	if (huffman_build(&work->lit, lengths, hlit) < 0 ||
+	    huffman_build(&work->dist, lengths + hlit, hdist) < 0) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int inflate_block(struct bit_reader *r, struct ws_inflate_work *work,
+			 uint8_t *dst, size_t dst_len, size_t *out)
+{
+	size_t len, dist, pos = *out;
+	int sym;
+
+	for (;;) {
+		sym = huffman_decode(r, &work->lit);
+		if (sym < 0 || r->eof) {
+			return -EINVAL;
+		}
+
+		if (sym < END_OF_BLOCK) {
+			if (pos == dst_len) {
+				return -EMSGSIZE;
+			}
+
+			dst[pos++] = sym;
+			continue;
+		}
+
+		if (sym == END_OF_BLOCK) {
+			break;
+		}
+
+		sym -= END_OF_BLOCK + 1;
+		if (sym >= ARRAY_SIZE(len_base)) {
+			return -EINVAL;
+		}
+
+		len = len_base[sym] + get_bits(r, len_extra[sym]);
+
+		sym = huffman_decode(r, &work->dist);
+		if (sym < 0 || sym >= ARRAY_SIZE(dist_base)) {
+			return -EINVAL;
+		}
+
+		dist = dist_base[sym] + get_bits(r, dist_extra[sym]);
+		if (r->eof || dist > pos) {
+			return -EINVAL;
+		}
+
+		if (len > dst_len - pos) {
+			return -EMSGSIZE;
+		}
+
+		/* The source and destination may overlap */
+		while (len--) {
+			dst[pos] = dst[pos - dist];
+			pos++;
+		}
+	}
+
+	*out = pos;
+
+	return 0;
+}
+
+static int inflate_stored(struct bit_reader *r, uint8_t *dst, size_t dst_len,
+			  size_t *out)
+{
+	uint32_t len, nlen;
+
+	/* Skip to the byte boundary */
+	r->bits >>= r->count % 8;
+	r->count -= r->count % 8;
+
+	len = get_bits(r, 16);
+	nlen = get_bits(r, 16);
+	if (r->eof) {
+		/* The end of the message */
+		return 1;
+	}
+
+	if (len != (~nlen & 0xffff)) {
+		return -EINVAL;
+	}
+
+	if (len > dst_len - *out) {
+		return -EMSGSIZE;
+	}
+
+	while (len--) {
+		dst[(*out)++] = get_bits(r, 8);
+	}
+
+	return r->eof ? -EINVAL : 0;
+}
+
+int websocket_inflate(const uint8_t *src, size_t len, uint8_t *dst,
+		      size_t dst_len, struct ws_inflate_work *work)
+{
+	struct bit_reader r = {
+		.src = src,
+		.len = len,
+	};
+	size_t out = 0;
+	uint8_t final, type;
+	int ret;
+
+	do {
+		final = get_bits(&r, 1);
+		type = get_bits(&r, 2);
+		if (r.eof) {
+			break;
+		}
+
+		switch (type) {
+		case BTYPE_STORED:
+			ret = inflate_stored(&r, dst, dst_len, &out);
+			if (ret > 0) {
+				return out;
+			}
+
+			break;
+		case BTYPE_FIXED:
+			ret = build_fixed(work);
+			if (ret == 0) {
+				ret = inflate_block(&r, work, dst, dst_len,
+						    &out);
+			}
+
+			break;
+		case BTYPE_DYNAMIC:
+			ret = build_dynamic(&r, work);
+			if (ret == 0) {
+				ret = inflate_block(&r, work, dst, dst_len,
+						    &out);
+			}
+
+			break;
+		default:
+			ret = -EINVAL;
+			break;
+		}
+
+		if (ret < 0) {
+			return ret;
+		}
+	} while (!final);
+
+	return out;
+}
@@ -0,0 +1,74 @@
+/** @file
+ @brief Websocket permessage-deflate private header
+
+ This is not to be included by the application.
+ */
+
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/types.h>
+#include <stddef.h>
+#include <sys/util.h>
+
+/* Number of entries of the match finder hash table */
+#define WS_DEFLATE_HASH_BITS 10
+#define WS_DEFLATE_HASH_SIZE BIT(WS_DEFLATE_HASH_BITS)
+
+/* Size of the work area of websocket_deflate() */
+#define WS_DEFLATE_WORK_SIZE (WS_DEFLATE_HASH_SIZE * sizeof(uint16_t))
+
+/** Huffman decoding table, canonical code */
+struct ws_huffman {
+	uint16_t counts[16];
+	uint16_t symbols[288];
+};
+
+/** Work area of websocket_inflate() */
+struct ws_inflate_work {
+	struct ws_huffman lit;
+	struct ws_huffman dist;
+	/* Code lengths of the literal/length and distance codes */
+	uint8_t lengths[288 + 32];
+};
+
+/**
+ * @brief Compress a message for the permessage-deflate extension.
+ *
+ * The message is compressed in a single block with the fixed Huffman
+ * codes and ends with an empty stored block, whose last four octets are
+ * removed as described in RFC 7692 section 7.2.1.
+ *
+ * @param src Message to compress.
+ * @param len Length of the message.
+ * @param dst Buffer for the compressed message.
+ * @param dst_len Size of the buffer.
+ * @param work Work area of WS_DEFLATE_WORK_SIZE bytes, 2-byte aligned.
+ *
+ * @return Length of the compressed message, or -ENOSPC if it does not
+ * fit in dst.
+ */
+int websocket_deflate(const uint8_t *src, size_t len, uint8_t *dst,
+		      size_t dst_len, void *work);
+
+/**
+ * @brief Decompress a message received with the permessage-deflate
+ * extension.
+ *
+ * The message may use any block type. The end of the input is accepted
+ * where the removed octets 0x00 0x00 0xff 0xff would be.
+ *
+ * @param src Compressed message.
+ * @param len Length of the compressed message.
+ * @param dst Buffer for the message.
+ * @param dst_len Size of the buffer.
+ * @param work Work area.
+ *
+ * @return Length of the message, -EMSGSIZE if it does not fit in dst, or
+ * -EINVAL if the compressed data is not valid.
+ */
+int websocket_inflate(const uint8_t *src, size_t len, uint8_t *dst,
+		      size_t dst_len, struct ws_inflate_work *work);
@@ -89,6 +89,14 @@ __net_socket struct websocket_context {
 	/** Message type */
 	uint32_t message_type;
 
+	/** Type of the compressed message being received */
+	uint32_t compressed_type;
+
+	/** Length of the compressed data of the fragments received so far,
+	 * which is kept at the start of tmp_buf.
+	 */
+	size_t compressed_len;
+
 	/** Is the message masked */
 	uint8_t masked : 1;
 
@@ -103,6 +111,21 @@ __net_socket struct websocket_context {
 
 	/** Header received */
 	uint8_t header_received : 1;
+
+	/** Is the frame part of a compressed message */
+	uint8_t compressed : 1;
+
+	/** Is a compressed message being received */
+	uint8_t inflating : 1;
+
+	/** Was the connection failed because of an invalid frame */
+	uint8_t failed : 1;
+
+	/** Did we receive Sec-WebSocket-Extensions: field */
+	uint8_t ext_present : 1;
+
+	/** Was the permessage-deflate extension negotiated */
+	uint8_t deflate : 1;
 };
 
 /**
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+#include <net/net_if.h>
+#include <net/net_ip.h>
+#include <net/net_pkt.h>
+#include <net/dummy.h>
+
+#include "6lo.h"
+#include "corpus.h"
+
+#include "../../common/bench_common.h"
+
+/* Compress and uncompress the packets of the 6lo test corpus, measuring
+ * both directions separately. Every round trip is checked against the
+ * original packet.
+ */
+
+#define N_ROUNDS 1000
+
+static uint8_t src_mac[8] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0xaa, 0xbb };
+static uint8_t dst_mac[8] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0xbb, 0xaa };
+
+/* Same contexts as in tests/net/6lo */
+static struct net_icmpv6_nd_opt_6co ctx1 = {
+	.context_len = 0x40,
+	.flag = 0x11,
+	.lifetime = 0x1234,
+	.prefix = { { { 0xaa, 0xbb, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 } } },
+};
+
+static struct net_icmpv6_nd_opt_6co ctx2 = {
+	.context_len = 0x80,
+	.flag = 0x12,
+	.lifetime = 0x1234,
+	.prefix = { { { 0xcc, 0xdd, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 } } },
+};
+
+static uint8_t buf[128];
+
+static void bench_iface_init(struct net_if *iface)
+{
+	net_if_set_link_addr(iface, src_mac, sizeof(src_mac),
+			     NET_LINK_IEEE802154);
+}
+
+static int bench_send(struct device *dev, struct net_pkt *pkt)
+{
+	return 0;
+}
+
+static int bench_dev_init(struct device *dev)
+{
+	return 0;
+}
+
+static struct dummy_api bench_if_api = {
+	.iface_api.init = bench_iface_init,
+	.send = bench_send,
+};
+
+NET_DEVICE_INIT(sixlo_bench, "sixlo_bench",
+		bench_dev_init, device_pm_control_nop, NULL, NULL,
+		CONFIG_KERNEL_INIT_PRIORITY_DEFAULT,
+		&bench_if_api, DUMMY_L2, NET_L2_GET_CTX_TYPE(DUMMY_L2), 127);
+
+static struct net_pkt *create_pkt(struct net_if *iface, const uint8_t *data,
+				  size_t len)
+{
+	struct net_pkt *pkt;
+
+	pkt = net_pkt_alloc_with_buffer(iface, len, AF_UNSPEC, 0, K_FOREVER);
+	if (!pkt) {
+		return NULL;
+	}
+
+	if (net_pkt_write(pkt, data, len)) {
+		net_pkt_unref(pkt);
+		return NULL;
+	}
+
+	net_pkt_lladdr_src(pkt)->addr = src_mac;
+	net_pkt_lladdr_src(pkt)->len = sizeof(src_mac);
+	net_pkt_lladdr_dst(pkt)->addr = dst_mac;
+	net_pkt_lladdr_dst(pkt)->len = sizeof(dst_mac);
+
+	net_pkt_cursor_init(pkt);
+
+	return pkt;
+}
+
+static void run(struct net_if *iface, int idx)
+{
+	const uint8_t *data = corpus[idx].data;
+	size_t len = corpus[idx].len;
+	uint32_t compress = 0U;
+	uint32_t uncompress = 0U;
+	size_t compressed_len = 0;
+	int mismatch = 0;
+	struct net_pkt *pkt;
+	uint32_t start;
+	int round;
+
+	for (round = 0; round < N_ROUNDS; round++) {
+		pkt = create_pkt(iface, data, len);
+		if (!pkt) {
+			printk("Cannot create packet\n");
+			return;
+		}
+
+		start = bench_start();
+
+		if (net_6lo_compress(pkt, true) < 0) {
+			mismatch++;
+			net_pkt_unref(pkt);
+			continue;
+		}
+
+		compress += bench_cycles(start);
+		compressed_len = net_pkt_get_len(pkt);
+
+		start = bench_start();
+
+		if (!net_6lo_uncompress(pkt)) {
+			mismatch++;
+			net_pkt_unref(pkt);
+			continue;
+		}
+
+		uncompress += bench_cycles(start);
+
+		if (net_pkt_get_len(pkt) != len ||
+		    net_pkt_read(pkt, buf, len) || memcmp(buf, data, len)) {
+			mismatch++;
+		}
+
+		net_pkt_unref(pkt);
+	}
+
+	bench_timed("6lo_compress", N_ROUNDS, compress,
+		    "packet=%s len=%zd compressed=%zd", corpus[idx].name, len,
+		    compressed_len);
+	bench_timed("6lo_uncompress", N_ROUNDS, uncompress,
+		    "packet=%s mismatch=%d", corpus[idx].name, mismatch);
+}
+
+void main(void)
+{
+	struct net_if *iface = net_if_get_default();
+	int i;
+
+	if (!iface) {
+		printk("No interface\n");
+		return;
+	}
+
+	net_6lo_set_context(iface, &ctx1);
+	net_6lo_set_context(iface, &ctx2);
+
+	for (i = 0; i < ARRAY_SIZE(corpus); i++) {
+		run(iface, i);
+	}
+
+	bench_fin();
+}
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+#include <net/net_if.h>
+#include <net/net_pkt.h>
+#include <net/socket.h>
+#include <net/capture.h>
+
+#include "../../common/bench_common.h"
+
+/* Send N_MSGS datagrams over the loopback interface and receive them,
+ * without capture, with a capture filtering them out and with a capture
+ * storing them.
+ */
+
+#define N_MSGS 1000
+#define PAYLOAD_SIZE 32
+#define PORT 4960
+
+static int tx_sock;
+static int rx_sock;
+static uint8_t payload[PAYLOAD_SIZE];
+static uint8_t buf[PAYLOAD_SIZE];
+
+static int discard(const void *data, size_t len, void *user_data)
+{
+	return 0;
+}
+
+static int send_all(bool export)
+{
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_port = htons(PORT),
+		.sin_addr = { { { 127, 0, 0, 1 } } },
+	};
+	int i;
+
+	for (i = 0; i < N_MSGS; i++) {
+		if (sendto(tx_sock, payload, sizeof(payload), 0,
+			   (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+			printk("Cannot send datagram %d (%d)\n", i, errno);
+			return -1;
+		}
+
+		if (recv(rx_sock, buf, sizeof(buf), 0) != sizeof(payload)) {
+			printk("Cannot receive datagram %d (%d)\n", i, errno);
+			return -1;
+		}
+
+		if (export) {
+			net_capture_export(discard, NULL, false);
+		}
+	}
+
+	return 0;
+}
+
+static int run(const char *name, const char *filter)
+{
+	struct net_capture_stats stats;
+	uint32_t start, cycles;
+	int ret;
+
+	if (filter) {
+		ret = net_capture_start(NULL, filter);
+		if (ret < 0) {
+			printk("Cannot start capture (%d)\n", ret);
+			return ret;
+		}
+	}
+
+	start = bench_start();
+	ret = send_all(filter != NULL);
+	cycles = bench_cycles(start);
+
+	net_capture_stop();
+
+	if (ret < 0) {
+		return ret;
+	}
+
+	net_capture_get_stats(&stats);
+	if (filter && stats.dropped) {
+		printk("Dropped %u packets\n", stats.dropped);
+		return -1;
+	}
+
+	bench_timed("capture_udp", N_MSGS, cycles, "mode=%s", name);
+
+	return 0;
+}
+
+static int run_filter(void)
+{
+	struct net_capture_filter filter;
+	struct net_pkt *pkt;
+	uint32_t start, cycles;
+	int matches = 0;
+	int i;
+
+	/* IPv4 UDP 192.0.2.1:5000 -> 192.0.2.2:53 */
+	static const uint8_t data[] = {
+		0x45, 0x00, 0x00, 0x1c, 0x00, 0x00, 0x00, 0x00,
+		0x40, 0x11, 0x00, 0x00, 0xc0, 0x00, 0x02, 0x01,
+		0xc0, 0x00, 0x02, 0x02, 0x13, 0x88, 0x00, 0x35,
+		0x00, 0x08, 0x00, 0x00,
+	};
+
+	if (net_capture_filter_compile(&filter,
+				       "udp and port 53 and not in") < 0) {
+		printk("Cannot compile filter\n");
+		return -1;
+	}
+
+	pkt = net_pkt_alloc_with_buffer(net_if_get_default(), sizeof(data),
+					AF_UNSPEC, 0, K_NO_WAIT);
+	if (!pkt || net_pkt_write(pkt, data, sizeof(data)) < 0) {
+		printk("Cannot create packet\n");
+		return -1;
+	}
+
+	start = bench_start();
+
+	for (i = 0; i < N_MSGS; i++) {
+		matches += net_capture_filter_match(&filter, pkt,
+						    NET_CAPTURE_OUT);
+	}
+
+	cycles = bench_cycles(start);
+
+	net_pkt_unref(pkt);
+
+	if (matches != N_MSGS) {
+		printk("Filter does not match\n");
+		return -1;
+	}
+
+	bench_timed("capture_filter", N_MSGS, cycles, "insns=6");
+
+	return 0;
+}
+
+static int udp_socket(uint16_t port)
+{
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_port = htons(port),
+		.sin_addr = { { { 127, 0, 0, 1 } } },
+	};
+	int sock;
+
+	sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (sock < 0 ||
+	    bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		printk("Cannot set up socket (%d)\n", errno);
+		return -1;
+	}
+
+	return sock;
+}
+
+void main(void)
+{
+	memset(payload, 'x', sizeof(payload));
+
+	rx_sock = udp_socket(PORT);
+	tx_sock = udp_socket(PORT + 1);
+	if (rx_sock < 0 || tx_sock < 0) {
+		return;
+	}
+
+	if (run("off", NULL) < 0 ||
+	    run("filtered", "tcp or port 80") < 0 ||
+	    run("captured", "udp and dst port 4960") < 0 ||
+	    run_filter() < 0) {
+		return;
+	}
+
+	bench_fin();
+}
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+#include <stdio.h>
+#include <string.h>
+#include <net/coap.h>
+
+#include "../../common/bench_common.h"
+
+/* Compare the resource lookup of coap_handle_request() with the one of
+ * coap_handle_request_index() over the same requests.
+ */
+
+#define MAX_RESOURCES 200
+#define MAX_DEPTH 3
+#define N_REQUESTS 1024
+#define MAX_OPTIONS 4
+#define BUF_SIZE 64
+
+static const int resource_counts[] = { 10, 200 };
+
+static const char * const groups[] = {
+	"sensors", "actuators", "config", "fw", "stats",
+};
+
+static const char * const leaves[] = { "value", "unit", "min", "max" };
+
+static char ids[MAX_RESOURCES][4];
+static const char *paths[MAX_RESOURCES][MAX_DEPTH + 1];
+static struct coap_resource resources[MAX_RESOURCES + 1];
+
+COAP_RESOURCE_INDEX_DEFINE(resource_index, resources, 2 * MAX_RESOURCES);
+
+static struct {
+	uint8_t data[BUF_SIZE];
+	struct coap_packet cpkt;
+	struct coap_option options[MAX_OPTIONS];
+} requests[N_REQUESTS];
+
+static struct sockaddr_in6 peer = {
+	.sin6_family = AF_INET6,
+};
+
+static struct coap_resource *called;
+
+static uint32_t rand_state = 1U;
+
+static uint32_t next_rand(void)
+{
+	rand_state = rand_state * 1103515245U + 12345U;
+
+	return rand_state >> 8;
+}
+
+static int resource_get(struct coap_resource *resource,
+			struct coap_packet *request,
+			struct sockaddr *addr, socklen_t addr_len)
+{
+	called = resource;
+
+	return 0;
+}
+
+/* Paths of one to three segments: /<group>, /<group>/<id> and
+ * /<group>/<id>/<leaf>
+ */
+static void gen_resources(int count)
+{
+	int i;
+
+	memset(resources, 0, sizeof(resources));
+
+	for (i = 0; i < count; i++) {
+		int depth = 1 + i % MAX_DEPTH;
+
+		snprintf(ids[i], sizeof(ids[i]), "%d", i / MAX_DEPTH);
+
+		paths[i][0] = groups[i % ARRAY_SIZE(groups)];
+		paths[i][1] = depth > 1 ? ids[i] : NULL;
+		paths[i][2] = depth > 2 ? leaves[i % ARRAY_SIZE(leaves)] :
+					  NULL;
+		paths[i][3] = NULL;
+
+		resources[i].path = paths[i];
+		resources[i].get = resource_get;
+	}
+}
+
+static int gen_request(int idx, int count)
+{
+	static const char * const unknown_path[] = { "sensors", "x", NULL };
+	const char * const *path;
+	int r;
+
+	if (next_rand() % 8 == 0) {
+		path = unknown_path;
+	} else {
+		path = resources[next_rand() % count].path;
+	}
+
+	r = coap_packet_init(&requests[idx].cpkt, requests[idx].data,
+			     BUF_SIZE, 1, COAP_TYPE_NON_CON, 0, NULL,
+			     COAP_METHOD_GET, coap_next_id());
+	if (r < 0) {
+		return r;
+	}
+
+	for (; *path; path++) {
+		r = coap_packet_append_option(&requests[idx].cpkt,
+					      COAP_OPTION_URI_PATH,
+					      *path, strlen(*path));
+		if (r < 0) {
+			return r;
+		}
+	}
+
+	return coap_packet_parse(&requests[idx].cpkt, requests[idx].data,
+				 requests[idx].cpkt.offset,
+				 requests[idx].options, MAX_OPTIONS);
+}
+
+static struct coap_resource *dispatch(int idx, bool indexed)
+{
+	called = NULL;
+
+	if (indexed) {
+		(void)coap_handle_request_index(&requests[idx].cpkt,
+						&resource_index,
+						requests[idx].options,
+						MAX_OPTIONS,
+						(struct sockaddr *)&peer,
+						sizeof(peer));
+	} else {
+		(void)coap_handle_request(&requests[idx].cpkt, resources,
+					  requests[idx].options, MAX_OPTIONS,
+					  (struct sockaddr *)&peer,
+					  sizeof(peer));
+	}
+
+	return called;
+}
+
+static void run(int count)
+{
+	uint32_t linear, indexed, start;
+	int mismatch = 0;
+	int i;
+
+	gen_resources(count);
+
+	if (coap_resource_index_build(&resource_index) < 0) {
+		printk("Cannot build the index\n");
+		return;
+	}
+
+	for (i = 0; i < N_REQUESTS; i++) {
+		if (gen_request(i, count) < 0) {
+			printk("Cannot build request %d\n", i);
+			return;
+		}
+	}
+
+	start = bench_start();
+
+	for (i = 0; i < N_REQUESTS; i++) {
+		(void)dispatch(i, false);
+	}
+
+	linear = bench_cycles(start);
+	start = bench_start();
+
+	for (i = 0; i < N_REQUESTS; i++) {
+		(void)dispatch(i, true);
+	}
+
+	indexed = bench_cycles(start);
+
+	for (i = 0; i < N_REQUESTS; i++) {
+		if (dispatch(i, false) != dispatch(i, true)) {
+			mismatch++;
+		}
+	}
+
+	bench_timed("coap_dispatch", N_REQUESTS, linear,
+		    "resources=%d lookup=linear", count);
+	bench_timed("coap_dispatch", N_REQUESTS, indexed,
+		    "resources=%d lookup=index mismatch=%d", count, mismatch);
+}
+
+void main(void)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(resource_counts); i++) {
+		run(resource_counts[i]);
+	}
+
+	bench_fin();
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_BENCHMARK_NET_COMMON_BENCH_COMMON_H_
+#define ZEPHYR_BENCHMARK_NET_COMMON_BENCH_COMMON_H_
+
+#include <zephyr.h>
+#include <stdarg.h>
+#include <sys/printk.h>
+
+/*
+ * Harness shared by the network benchmarks, see README.rst in the parent
+ * directory. Every result is printed on one line as the name of the
+ * result followed by key=value pairs, and the run ends with "fin".
+ */
+
+/* Start timing a section, returns the cycle counter */
+static inline uint32_t bench_start(void)
+{
+	return k_cycle_get_32();
+}
+
+/* Cycles elapsed since bench_start() returned start */
+static inline uint32_t bench_cycles(uint32_t start)
+{
+	return k_cycle_get_32() - start;
+}
+
+/* Count per second of events which took the given cycles */
+static inline uint32_t bench_rate(uint64_t count, uint32_t cycles)
+{
+	if (cycles == 0U) {
+		return 0;
+	}
+
+	return count * sys_clock_hw_cycles_per_sec() / cycles;
+}
+
+static inline void bench_vprint(const char *name, const char *fmt,
+				va_list ap)
+{
+	printk("%s", name);
+
+	if (fmt[0] != '\0') {
+		printk(" ");
+		vprintk(fmt, ap);
+	}
+}
+
+/* Print a result, fmt gives its key=value pairs */
+static inline __printf_like(2, 3) void bench_result(const char *name,
+						    const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	bench_vprint(name, fmt, ap);
+	va_end(ap);
+
+	printk("\n");
+}
+
+/* Print the result of n operations which took the given cycles. The
+ * key=value pairs of fmt are followed by n, cycles, per_op and per_sec.
+ */
+static inline __printf_like(4, 5) void bench_timed(const char *name,
+						   uint32_t n,
+						   uint32_t cycles,
+						   const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	bench_vprint(name, fmt, ap);
+	va_end(ap);
+
+	printk(" n=%u cycles=%u per_op=%u per_sec=%u\n", n, cycles,
+	       n ? cycles / n : 0U, bench_rate(n, cycles));
+}
+
+/* End of the run, which the console harness waits for */
+static inline void bench_fin(void)
+{
+	printk("fin\n");
+}
+
+#endif /* ZEPHYR_BENCHMARK_NET_COMMON_BENCH_COMMON_H_ */
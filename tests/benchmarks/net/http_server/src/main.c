@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+#include <net/socket.h>
+#include <net/http_server.h>
+
+#include "../../common/bench_common.h"
+
+/* Send N_REQS requests for a small page to the HTTP server over the
+ * loopback interface, first on N_CONNS persistent connections with
+ * PIPELINE requests in flight on each, then with one connection per
+ * request.
+ */
+
+#define N_REQS 2000
+#define N_CONNS CONFIG_HTTP_SERVER_MAX_CLIENTS
+#define PIPELINE 4
+#define N_CLOSE_REQS 200
+#define SERVER_PORT 8080
+#define SERVER_STACK_SIZE 2048
+
+static const char page[] = "<html><body>Hello from the benchmark</body></html>";
+static const char request[] = "GET / HTTP/1.1\r\nHost: bench\r\n\r\n";
+static const char close_request[] = "GET / HTTP/1.1\r\nHost: bench\r\n"
+				    "Connection: close\r\n\r\n";
+
+static const struct http_server_route routes[] = {
+	HTTP_SERVER_ROUTE_BUF("/", "text/html", page, sizeof(page) - 1),
+};
+
+static struct http_server server;
+static K_THREAD_STACK_DEFINE(server_stack, SERVER_STACK_SIZE);
+static struct k_thread server_thread;
+
+static struct sockaddr_in addr = {
+	.sin_family = AF_INET,
+	.sin_port = htons(SERVER_PORT),
+	.sin_addr = { { { 127, 0, 0, 1 } } },
+};
+
+static int socks[N_CONNS];
+static char reqs[PIPELINE * sizeof(request)];
+static char buf[1024];
+static size_t resp_len;
+static size_t close_resp_len;
+
+static void server_fn(void *p1, void *p2, void *p3)
+{
+	int ret = http_server_run(&server);
+
+	printk("Server stopped (%d)\n", ret);
+}
+
+static int client_open(void)
+{
+	int sock;
+
+	sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (sock < 0) {
+		printk("Cannot create client (%d)\n", errno);
+		return -1;
+	}
+
+	if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		printk("Cannot connect client (%d)\n", errno);
+		close(sock);
+		return -1;
+	}
+
+	return sock;
+}
+
+static int send_all(int sock, const char *data, size_t len)
+{
+	while (len > 0) {
+		ssize_t ret = send(sock, data, len, 0);
+
+		if (ret < 0) {
+			printk("Cannot send (%d)\n", errno);
+			return -1;
+		}
+
+		data += ret;
+		len -= ret;
+	}
+
+	return 0;
+}
+
+/* Receive len bytes, and wait for the connection to be closed if
+ * closed is true.
+ */
+static int recv_len(int sock, size_t len, bool closed)
+{
+	size_t total = 0;
+	ssize_t ret;
+
+	do {
+		ret = recv(sock, buf, sizeof(buf), 0);
+		if (ret < 0) {
+			printk("Cannot recv (%d)\n", errno);
+			return -1;
+		}
+
+		total += ret;
+	} while (ret > 0 && (closed || total < len));
+
+	if (total != len) {
+		printk("Unexpected response length (%zu bytes)\n", total);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int run_keep_alive(void)
+{
+	int done = 0;
+	int i;
+
+	for (i = 0; i < N_CONNS; i++) {
+		socks[i] = client_open();
+		if (socks[i] < 0) {
+			return -1;
+		}
+	}
+
+	while (done < N_REQS) {
+		for (i = 0; i < N_CONNS; i++) {
+			if (send_all(socks[i], reqs, strlen(reqs)) < 0) {
+				return -1;
+			}
+		}
+
+		for (i = 0; i < N_CONNS; i++) {
+			if (recv_len(socks[i], PIPELINE * resp_len,
+				     false) < 0) {
+				return -1;
+			}
+		}
+
+		done += N_CONNS * PIPELINE;
+	}
+
+	for (i = 0; i < N_CONNS; i++) {
+		close(socks[i]);
+	}
+
+	return done;
+}
+
+static int run_close(void)
+{
+	int sock;
+	int i;
+
+	for (i = 0; i < N_CLOSE_REQS; i++) {
+		sock = client_open();
+		if (sock < 0) {
+			return -1;
+		}
+
+		/* The server closes the connection after the response */
+		if (send_all(sock, close_request, sizeof(close_request) - 1) ||
+		    recv_len(sock, close_resp_len, true) < 0) {
+			close(sock);
+			return -1;
+		}
+
+		close(sock);
+	}
+
+	return N_CLOSE_REQS;
+}
+
+void main(void)
+{
+	uint32_t start, cycles;
+	int ret;
+	int i;
+
+	resp_len = snprintk(buf, sizeof(buf), "HTTP/1.1 200 OK\r\n"
+			    "Content-Type: text/html\r\n"
+			    "Content-Length: %zu\r\n\r\n%s",
+			    sizeof(page) - 1, page);
+	close_resp_len = resp_len + strlen("Connection: close\r\n");
+
+	for (i = 0; i < PIPELINE; i++) {
+		strcat(reqs, request);
+	}
+
+	ret = http_server_init(&server, (struct sockaddr *)&addr,
+			       sizeof(addr), routes, ARRAY_SIZE(routes),
+			       NULL);
+	if (ret < 0) {
+		printk("Cannot init the server (%d)\n", ret);
+		return;
+	}
+
+	k_thread_create(&server_thread, server_stack,
+			K_THREAD_STACK_SIZEOF(server_stack), server_fn,
+			NULL, NULL, NULL, K_PRIO_PREEMPT(8), 0, K_NO_WAIT);
+
+	start = bench_start();
+
+	ret = run_keep_alive();
+	if (ret < 0) {
+		return;
+	}
+
+	cycles = bench_cycles(start);
+
+	bench_timed("http_requests", ret, cycles,
+		    "mode=keep_alive conns=%d pipeline=%d", N_CONNS, PIPELINE);
+
+	/* Let the server drop the connections closed by the client */
+	k_sleep(K_MSEC(CONFIG_HTTP_SERVER_IDLE_TIMEOUT + 100));
+
+	start = bench_start();
+
+	ret = run_close();
+	if (ret < 0) {
+		return;
+	}
+
+	cycles = bench_cycles(start);
+
+	bench_timed("http_requests", ret, cycles, "mode=close");
+
+	bench_fin();
+}
@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+#include <net/net_if.h>
+#include <net/net_pkt.h>
+#include <net/socket.h>
+#include <net/ieee802154_radio.h>
+
+#include "ipv6.h"
+
+#include "../../common/bench_common.h"
+
+/* Send UDP packets to a neighbor through a radio which takes the air
+ * time of each frame and of its ACK to transmit it, measuring how long
+ * the L2 takes to get all the frames on air.
+ */
+
+#define N_PKTS 100
+#define PORT 4242
+
+/* 250 kbit/s in the 2.4 GHz band */
+#define BYTE_US 32
+/* Preamble, SFD and PHY header */
+#define PHY_HDR_LEN 6
+#define FCS_LEN 2
+/* Turnaround and ACK frame */
+#define ACK_US (192 + (PHY_HDR_LEN + 5) * BYTE_US)
+
+static const int sizes[] = { 64, 400 };
+
+static uint8_t my_mac[8] = { 0x00, 0x12, 0x4b, 0x00, 0x00, 0x9e, 0xa3, 0x01 };
+static uint8_t nbr_mac[8] = { 0x00, 0x12, 0x4b, 0x00, 0x00, 0x9e, 0xa3, 0x02 };
+static struct in6_addr nbr_addr = { { { 0xfe, 0x80, 0, 0, 0, 0, 0, 0,
+					0x02, 0x12, 0x4b, 0x00, 0x00, 0x9e,
+					0xa3, 0x02 } } };
+
+static uint8_t payload[400];
+
+/* Frames the radio transmitted, and when it was done with the last one */
+static atomic_t frames;
+static volatile uint32_t last_cycle;
+static volatile int64_t last_ms;
+
+static enum ieee802154_hw_caps radio_get_capabilities(struct device *dev)
+{
+	return IEEE802154_HW_FCS | IEEE802154_HW_2_4_GHZ |
+	       IEEE802154_HW_TX_RX_ACK;
+}
+
+static int radio_cca(struct device *dev)
+{
+	return 0;
+}
+
+static int radio_set_channel(struct device *dev, uint16_t channel)
+{
+	return 0;
+}
+
+static int radio_set_txpower(struct device *dev, int16_t dbm)
+{
+	return 0;
+}
+
+static int radio_tx(struct device *dev, enum ieee802154_tx_mode mode,
+		    struct net_pkt *pkt, struct net_buf *frag)
+{
+	uint32_t air_us = (PHY_HDR_LEN + frag->len + FCS_LEN) * BYTE_US;
+
+	if (ieee802154_is_ar_flag_set(frag)) {
+		air_us += ACK_US;
+	}
+
+	/* A radio driver waits for the end of the transmission */
+	k_sleep(K_USEC(air_us));
+
+	last_cycle = k_cycle_get_32();
+	last_ms = k_uptime_get();
+	atomic_inc(&frames);
+
+	return 0;
+}
+
+static int radio_start(struct device *dev)
+{
+	return 0;
+}
+
+static int radio_stop(struct device *dev)
+{
+	return 0;
+}
+
+static void radio_iface_init(struct net_if *iface)
+{
+	struct ieee802154_context *ctx = net_if_l2_data(iface);
+
+	net_if_set_link_addr(iface, my_mac, sizeof(my_mac),
+			     NET_LINK_IEEE802154);
+
+	ctx->pan_id = 0xabcd;
+	ctx->channel = 26U;
+}
+
+static int radio_dev_init(struct device *dev)
+{
+	return 0;
+}
+
+static struct ieee802154_radio_api radio_api = {
+	.iface_api.init	= radio_iface_init,
+
+	.get_capabilities	= radio_get_capabilities,
+	.cca			= radio_cca,
+	.set_channel		= radio_set_channel,
+	.set_txpower		= radio_set_txpower,
+	.start			= radio_start,
+	.stop			= radio_stop,
+	.tx			= radio_tx,
+};
+
+NET_DEVICE_INIT(bench_radio, "bench_radio",
+		radio_dev_init, device_pm_control_nop, NULL, NULL,
+		CONFIG_KERNEL_INIT_PRIORITY_DEFAULT,
+		&radio_api, IEEE802154_L2,
+		NET_L2_GET_CTX_TYPE(IEEE802154_L2), 125);
+
+/* Wait until the radio has been idle for a while */
+static void wait_idle(void)
+{
+	atomic_val_t count;
+
+	do {
+		count = atomic_get(&frames);
+		k_sleep(K_MSEC(50));
+	} while (atomic_get(&frames) != count);
+}
+
+static void run(int fd, int size)
+{
+	struct sockaddr_in6 addr = {
+		.sin6_family = AF_INET6,
+		.sin6_port = htons(PORT),
+		.sin6_addr = nbr_addr,
+	};
+	uint32_t start_cycle, cycles;
+	int64_t start_ms;
+	int errors = 0;
+	int count;
+	int i;
+
+	wait_idle();
+	atomic_clear(&frames);
+
+	start_cycle = bench_start();
+	start_ms = k_uptime_get();
+
+	for (i = 0; i < N_PKTS; i++) {
+		if (sendto(fd, payload, size, 0, (struct sockaddr *)&addr,
+			   sizeof(addr)) < 0) {
+			errors++;
+		}
+	}
+
+	wait_idle();
+
+	count = atomic_get(&frames);
+	cycles = last_cycle - start_cycle;
+
+	bench_timed("ieee802154_tx", count, cycles,
+		    "size=%d pkts=%d ms=%u errors=%d", size, N_PKTS,
+		    (uint32_t)(last_ms - start_ms), errors);
+}
+
+void main(void)
+{
+	struct net_if *iface = net_if_get_default();
+	struct net_linkaddr lladdr = {
+		.addr = nbr_mac,
+		.len = sizeof(nbr_mac),
+		.type = NET_LINK_IEEE802154,
+	};
+	int fd;
+	int i;
+
+	if (!net_ipv6_nbr_add(iface, &nbr_addr, &lladdr, false,
+			      NET_IPV6_NBR_STATE_STATIC)) {
+		printk("Cannot add neighbor\n");
+		return;
+	}
+
+	fd = socket(AF_INET6, SOCK_DGRAM, IPPROTO_UDP);
+	if (fd < 0) {
+		printk("Cannot create socket (%d)\n", errno);
+		return;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(sizes); i++) {
+		run(fd, sizes[i]);
+	}
+
+	close(fd);
+
+	bench_fin();
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+#include <random/rand32.h>
+#include <net/lwm2m.h>
+
+#include "lwm2m_object.h"
+#include "lwm2m_engine.h"
+
+#include "../../common/bench_common.h"
+
+/* Register N_OBJS synthetic objects with N_INSTS instances of N_RES
+ * resources each, then time reads and writes of random resources through
+ * the path based API, and the observer lookup of a notification.
+ */
+
+#define N_OBJS 8
+#define N_INSTS 32
+#define N_RES 16
+#define N_OPS 2000
+#define OBJ_ID_BASE 32000
+
+struct bench_obj {
+	struct lwm2m_engine_obj obj;
+	struct lwm2m_engine_obj_field fields[N_RES];
+	struct lwm2m_engine_obj_inst inst[N_INSTS];
+	struct lwm2m_engine_res res[N_INSTS][N_RES];
+	struct lwm2m_engine_res_inst res_inst[N_INSTS][N_RES];
+	uint32_t data[N_INSTS][N_RES];
+};
+
+static struct bench_obj objs[N_OBJS];
+
+static char paths[N_OPS][sizeof("65535/65535/65535")];
+static uint16_t path_ids[N_OPS][3];
+
+/* Object whose instance is being created, the create callback does not
+ * get it.
+ */
+static struct bench_obj *creating;
+
+static struct lwm2m_engine_obj_inst *bench_create(uint16_t obj_inst_id)
+{
+	struct bench_obj *o = creating;
+	int i = 0, j = 0, r;
+
+	if (obj_inst_id >= N_INSTS || o->inst[obj_inst_id].obj) {
+		return NULL;
+	}
+
+	init_res_instance(o->res_inst[obj_inst_id], N_RES);
+
+	for (r = 0; r < N_RES; r++) {
+		INIT_OBJ_RES_DATA(r, o->res[obj_inst_id], i,
+				  o->res_inst[obj_inst_id], j,
+				  &o->data[obj_inst_id][r],
+				  sizeof(o->data[obj_inst_id][r]));
+	}
+
+	o->inst[obj_inst_id].resources = o->res[obj_inst_id];
+	o->inst[obj_inst_id].resource_count = i;
+
+	return &o->inst[obj_inst_id];
+}
+
+static int register_objs(void)
+{
+	struct lwm2m_engine_obj_inst *obj_inst;
+	struct bench_obj *o;
+	int ret;
+	int i, r;
+
+	for (i = 0; i < N_OBJS; i++) {
+		o = &objs[i];
+
+		for (r = 0; r < N_RES; r++) {
+			o->fields[r] = (struct lwm2m_engine_obj_field)
+				OBJ_FIELD_DATA(r, RW, U32);
+		}
+
+		o->obj.obj_id = OBJ_ID_BASE + i;
+		o->obj.fields = o->fields;
+		o->obj.field_count = N_RES;
+		o->obj.max_instance_count = N_INSTS;
+		o->obj.create_cb = bench_create;
+		lwm2m_register_obj(&o->obj);
+	}
+
+	/* Create the instances of the objects in turn, so that they are
+	 * interleaved in the engine lists.
+	 */
+	for (r = 0; r < N_INSTS; r++) {
+		for (i = 0; i < N_OBJS; i++) {
+			creating = &objs[i];
+			ret = lwm2m_create_obj_inst(OBJ_ID_BASE + i, r,
+						    &obj_inst);
+			if (ret < 0) {
+				printk("Cannot create %d/%d (%d)\n",
+				       OBJ_ID_BASE + i, r, ret);
+				return ret;
+			}
+		}
+	}
+
+	return 0;
+}
+
+void main(void)
+{
+	uint32_t start, set, get, notify;
+	uint32_t value;
+	int errors = 0;
+	int i;
+
+	if (register_objs() < 0) {
+		return;
+	}
+
+	for (i = 0; i < N_OPS; i++) {
+		path_ids[i][0] = OBJ_ID_BASE + sys_rand32_get() % N_OBJS;
+		path_ids[i][1] = sys_rand32_get() % N_INSTS;
+		path_ids[i][2] = sys_rand32_get() % N_RES;
+		snprintk(paths[i], sizeof(paths[i]), "%u/%u/%u",
+			 path_ids[i][0], path_ids[i][1], path_ids[i][2]);
+	}
+
+	start = bench_start();
+
+	for (i = 0; i < N_OPS; i++) {
+		if (lwm2m_engine_set_u32(paths[i], i) < 0) {
+			errors++;
+		}
+	}
+
+	set = bench_cycles(start);
+
+	start = bench_start();
+
+	for (i = 0; i < N_OPS; i++) {
+		if (lwm2m_engine_get_u32(paths[i], &value) < 0) {
+			errors++;
+		}
+	}
+
+	get = bench_cycles(start);
+
+	start = bench_start();
+
+	for (i = 0; i < N_OPS; i++) {
+		(void)lwm2m_notify_observer(path_ids[i][0], path_ids[i][1],
+					    path_ids[i][2]);
+	}
+
+	notify = bench_cycles(start);
+
+	bench_result("lwm2m_objects", "instances=%d errors=%d",
+		     N_OBJS * N_INSTS, errors);
+	bench_timed("lwm2m_set", N_OPS, set, "instances=%d",
+		    N_OBJS * N_INSTS);
+	bench_timed("lwm2m_get", N_OPS, get, "instances=%d",
+		    N_OBJS * N_INSTS);
+	bench_timed("lwm2m_notify", N_OPS, notify, "instances=%d",
+		    N_OBJS * N_INSTS);
+
+	bench_fin();
+}
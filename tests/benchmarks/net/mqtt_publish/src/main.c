@@ -0,0 +1,294 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+#include <net/socket.h>
+#include <net/mqtt.h>
+
+#include "../../common/bench_common.h"
+
+/* Publish N_MSGS messages of PAYLOAD_SIZE bytes to a broker stand-in on
+ * the loopback interface, first with QoS 0 and then with QoS 1. The
+ * broker only parses the fixed header and answers CONNECT and QoS 1
+ * PUBLISH packets, so the time is spent in the client and the stack.
+ */
+
+#define N_MSGS 1000
+#define PAYLOAD_SIZE 128
+#define BROKER_PORT 1883
+#define BROKER_STACK_SIZE 2048
+#define BROKER_BUF_SIZE 256
+
+static uint8_t rx_buffer[64];
+static uint8_t tx_buffer[64];
+static uint8_t payload[PAYLOAD_SIZE];
+static uint8_t broker_buf[BROKER_BUF_SIZE];
+
+static struct mqtt_client client;
+static struct sockaddr_in broker_addr = {
+	.sin_family = AF_INET,
+	.sin_port = htons(BROKER_PORT),
+	.sin_addr = { { { 127, 0, 0, 1 } } },
+};
+
+static bool connected;
+static int acked;
+
+static int broker_listener;
+static atomic_t broker_received;
+static atomic_t broker_expected;
+static K_SEM_DEFINE(broker_done, 0, 1);
+static K_THREAD_STACK_DEFINE(broker_stack, BROKER_STACK_SIZE);
+static struct k_thread broker_thread;
+
+static int recv_all(int sock, uint8_t *buf, size_t len)
+{
+	while (len > 0) {
+		ssize_t ret = recv(sock, buf, len, 0);
+
+		if (ret <= 0) {
+			return -1;
+		}
+
+		buf += ret;
+		len -= ret;
+	}
+
+	return 0;
+}
+
+static int broker_read_packet(int sock, uint8_t *type, uint32_t *len)
+{
+	uint8_t byte;
+	int shift = 0;
+
+	if (recv_all(sock, type, 1) < 0) {
+		return -1;
+	}
+
+	*len = 0U;
+
+	do {
+		if (recv_all(sock, &byte, 1) < 0) {
+			return -1;
+		}
+
+		*len |= (uint32_t)(byte & 0x7F) << shift;
+		shift += 7;
+	} while (byte & 0x80);
+
+	if (*len > sizeof(broker_buf)) {
+		return -1;
+	}
+
+	return recv_all(sock, broker_buf, *len);
+}
+
+static void broker(void *p1, void *p2, void *p3)
+{
+	uint8_t ack[4];
+	uint8_t type;
+	uint32_t len;
+	int sock;
+
+	sock = accept(broker_listener, NULL, NULL);
+	if (sock < 0) {
+		printk("Broker cannot accept (%d)\n", errno);
+		return;
+	}
+
+	while (broker_read_packet(sock, &type, &len) == 0) {
+		switch (type & 0xF0) {
+		case 0x10: /* CONNECT */
+			ack[0] = 0x20;
+			ack[1] = 2U;
+			ack[2] = 0U;
+			ack[3] = 0U;
+			send(sock, ack, sizeof(ack), 0);
+			break;
+		case 0x30: /* PUBLISH */
+			if (((type >> 1) & 0x03) == MQTT_QOS_1_AT_LEAST_ONCE) {
+				uint16_t topic_len = (broker_buf[0] << 8) |
+						     broker_buf[1];
+
+				ack[0] = 0x40;
+				ack[1] = 2U;
+				ack[2] = broker_buf[2 + topic_len];
+				ack[3] = broker_buf[3 + topic_len];
+				send(sock, ack, sizeof(ack), 0);
+			}
+
+			if (atomic_inc(&broker_received) + 1 ==
+			    atomic_get(&broker_expected)) {
+				k_sem_give(&broker_done);
+			}
+			break;
+		case 0xE0: /* DISCONNECT */
+			close(sock);
+			return;
+		default:
+			break;
+		}
+	}
+
+	close(sock);
+}
+
+static void mqtt_evt_handler(struct mqtt_client *const c,
+			     const struct mqtt_evt *evt)
+{
+	switch (evt->type) {
+	case MQTT_EVT_CONNACK:
+		connected = (evt->result == 0);
+		break;
+	case MQTT_EVT_PUBACK:
+		acked++;
+		break;
+	default:
+		break;
+	}
+}
+
+/* Wait for input from the broker and process it */
+static int wait_input(int timeout)
+{
+	struct pollfd fds = {
+		.fd = client.transport.tcp.sock,
+		.events = POLLIN,
+	};
+
+	if (poll(&fds, 1, timeout) < 0) {
+		return -errno;
+	}
+
+	return mqtt_input(&client);
+}
+
+static int client_connect(void)
+{
+	int i;
+
+	mqtt_client_init(&client);
+
+	client.broker = &broker_addr;
+	client.evt_cb = mqtt_evt_handler;
+	client.client_id.utf8 = (uint8_t *)"bench";
+	client.client_id.size = strlen("bench");
+	client.protocol_version = MQTT_VERSION_3_1_1;
+	client.transport.type = MQTT_TRANSPORT_NON_SECURE;
+	client.rx_buf = rx_buffer;
+	client.rx_buf_size = sizeof(rx_buffer);
+	client.tx_buf = tx_buffer;
+	client.tx_buf_size = sizeof(tx_buffer);
+
+	if (mqtt_connect(&client) < 0) {
+		return -1;
+	}
+
+	for (i = 0; i < 10 && !connected; i++) {
+		if (wait_input(100) < 0) {
+			return -1;
+		}
+	}
+
+	return connected ? 0 : -1;
+}
+
+static int publish_all(enum mqtt_qos qos)
+{
+	struct mqtt_publish_param param = {
+		.message.topic.topic.utf8 = (uint8_t *)"bench/telemetry",
+		.message.topic.topic.size = strlen("bench/telemetry"),
+		.message.topic.qos = qos,
+		.message.payload.data = payload,
+		.message.payload.len = sizeof(payload),
+	};
+	int ret;
+	int i;
+
+	atomic_set(&broker_received, 0);
+	atomic_set(&broker_expected, N_MSGS);
+	acked = 0;
+
+	for (i = 0; i < N_MSGS; i++) {
+		param.message_id = (qos == MQTT_QOS_0_AT_MOST_ONCE) ? 0 : i + 1;
+
+		while ((ret = mqtt_publish(&client, &param)) == -EAGAIN) {
+			if (wait_input(SYS_FOREVER_MS) < 0) {
+				return -1;
+			}
+		}
+
+		if (ret < 0) {
+			printk("Cannot publish message %d (%d)\n", i, ret);
+			return -1;
+		}
+	}
+
+	if (qos == MQTT_QOS_0_AT_MOST_ONCE) {
+		return k_sem_take(&broker_done, K_SECONDS(10));
+	}
+
+	while (acked < N_MSGS) {
+		if (wait_input(SYS_FOREVER_MS) < 0) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+void main(void)
+{
+	uint32_t start, cycles;
+
+	memset(payload, 'x', sizeof(payload));
+
+	broker_listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (broker_listener < 0 ||
+	    bind(broker_listener, (struct sockaddr *)&broker_addr,
+		 sizeof(broker_addr)) < 0 ||
+	    listen(broker_listener, 1) < 0) {
+		printk("Cannot set up the broker (%d)\n", errno);
+		return;
+	}
+
+	k_thread_create(&broker_thread, broker_stack,
+			K_THREAD_STACK_SIZEOF(broker_stack), broker,
+			NULL, NULL, NULL, K_PRIO_PREEMPT(8), 0, K_NO_WAIT);
+
+	if (client_connect() < 0) {
+		printk("Cannot connect to the broker\n");
+		return;
+	}
+
+	start = bench_start();
+
+	if (publish_all(MQTT_QOS_0_AT_MOST_ONCE) < 0) {
+		return;
+	}
+
+	cycles = bench_cycles(start);
+
+	bench_timed("mqtt_publish", N_MSGS, cycles, "qos=0 bytes=%d",
+		    PAYLOAD_SIZE);
+
+	start = bench_start();
+
+	if (publish_all(MQTT_QOS_1_AT_LEAST_ONCE) < 0) {
+		return;
+	}
+
+	cycles = bench_cycles(start);
+
+	bench_timed("mqtt_publish", N_MSGS, cycles, "qos=1 bytes=%d window=%d",
+		    PAYLOAD_SIZE, CONFIG_MQTT_MAX_INFLIGHT);
+
+	mqtt_disconnect(&client);
+
+	bench_fin();
+}
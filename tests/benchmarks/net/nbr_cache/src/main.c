@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+#include <net/net_if.h>
+#include <net/net_pkt.h>
+#include <net/ethernet.h>
+
+#include "arp.h"
+#include "ipv6.h"
+
+#include "../../common/bench_common.h"
+
+/* Fill the ARP cache and the IPv6 neighbor cache with a growing number
+ * of neighbors, and look them up in turn as the per packet path does.
+ */
+
+#define N_LOOKUPS 4096
+#define MAX_NBRS 64
+
+static const int table_sizes[] = { 4, 16, 64 };
+
+static struct in_addr my_addr = { { { 192, 0, 2, 1 } } };
+static struct in_addr netmask = { { { 255, 255, 255, 0 } } };
+
+static uint8_t fake_mac[] = { 0x00, 0x00, 0x5E, 0x00, 0x53, 0x01 };
+static uint8_t nbr_macs[MAX_NBRS][sizeof(struct net_eth_addr)];
+
+static struct in_addr nbr_addrs[MAX_NBRS];
+static struct in6_addr nbr_addrs6[MAX_NBRS];
+
+static void bench_iface_init(struct net_if *iface)
+{
+	net_if_set_link_addr(iface, fake_mac, sizeof(fake_mac),
+			     NET_LINK_ETHERNET);
+
+	ethernet_init(iface);
+}
+
+static int bench_send(struct device *dev, struct net_pkt *pkt)
+{
+	return 0;
+}
+
+static int bench_dev_init(struct device *dev)
+{
+	return 0;
+}
+
+static const struct ethernet_api bench_if_api = {
+	.iface_api.init = bench_iface_init,
+	.send = bench_send,
+};
+
+NET_DEVICE_INIT(nbr_bench, "nbr_bench",
+		bench_dev_init, device_pm_control_nop, NULL, NULL,
+		CONFIG_KERNEL_INIT_PRIORITY_DEFAULT,
+		&bench_if_api, ETHERNET_L2, NET_L2_GET_CTX_TYPE(ETHERNET_L2),
+		NET_ETH_MTU);
+
+/* Feed an ARP request for our address, which adds its sender to the
+ * cache.
+ */
+static int arp_add(struct net_if *iface, int idx)
+{
+	struct net_arp_hdr *hdr;
+	struct net_eth_hdr *eth;
+	struct net_pkt *pkt;
+
+	pkt = net_pkt_alloc_with_buffer(iface, sizeof(struct net_eth_hdr) +
+					sizeof(struct net_arp_hdr),
+					AF_UNSPEC, 0, K_SECONDS(1));
+	if (!pkt) {
+		return -ENOMEM;
+	}
+
+	eth = (struct net_eth_hdr *)net_buf_add(pkt->buffer, sizeof(*eth));
+	net_buf_pull(pkt->buffer, sizeof(*eth));
+
+	memcpy(&eth->dst, fake_mac, sizeof(eth->dst));
+	memcpy(&eth->src, nbr_macs[idx], sizeof(eth->src));
+	eth->type = htons(NET_ETH_PTYPE_ARP);
+
+	hdr = (struct net_arp_hdr *)net_buf_add(pkt->buffer, sizeof(*hdr));
+
+	hdr->hwtype = htons(NET_ARP_HTYPE_ETH);
+	hdr->protocol = htons(NET_ETH_PTYPE_IP);
+	hdr->hwlen = sizeof(struct net_eth_addr);
+	hdr->protolen = sizeof(struct in_addr);
+	hdr->opcode = htons(NET_ARP_REQUEST);
+
+	memcpy(&hdr->src_hwaddr, nbr_macs[idx], sizeof(hdr->src_hwaddr));
+	(void)memset(&hdr->dst_hwaddr, 0, sizeof(hdr->dst_hwaddr));
+	net_ipaddr_copy(&hdr->src_ipaddr, &nbr_addrs[idx]);
+	net_ipaddr_copy(&hdr->dst_ipaddr, &my_addr);
+
+	if (net_arp_input(pkt, eth) == NET_DROP) {
+		net_pkt_unref(pkt);
+		return -EINVAL;
+	}
+
+	/* Let the TX thread send the reply */
+	k_sleep(K_MSEC(1));
+
+	return 0;
+}
+
+static int ipv6_add(struct net_if *iface, int idx)
+{
+	struct net_linkaddr lladdr = {
+		.addr = nbr_macs[idx],
+		.len = sizeof(nbr_macs[idx]),
+		.type = NET_LINK_ETHERNET,
+	};
+
+	if (!net_ipv6_nbr_add(iface, &nbr_addrs6[idx], &lladdr, false,
+			      NET_IPV6_NBR_STATE_STATIC)) {
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static int run_arp(struct net_if *iface, int count)
+{
+	uint32_t start, cycles;
+	struct net_pkt *pkt;
+	int i;
+
+	pkt = net_pkt_alloc_with_buffer(iface, sizeof(struct net_ipv4_hdr),
+					AF_INET, 0, K_NO_WAIT);
+	if (!pkt) {
+		printk("Cannot allocate packet\n");
+		return -ENOMEM;
+	}
+
+	start = bench_start();
+
+	for (i = 0; i < N_LOOKUPS; i++) {
+		if (net_arp_prepare(pkt, &nbr_addrs[i % count], NULL) != pkt) {
+			printk("Neighbor %d not found\n", i % count);
+			net_pkt_unref(pkt);
+			return -ENOENT;
+		}
+	}
+
+	cycles = bench_cycles(start);
+
+	net_pkt_unref(pkt);
+
+	bench_timed("nbr_lookup", N_LOOKUPS, cycles, "cache=arp entries=%d",
+		    count);
+
+	return 0;
+}
+
+static int run_ipv6(struct net_if *iface, int count)
+{
+	uint32_t start, cycles;
+	int i;
+
+	start = bench_start();
+
+	for (i = 0; i < N_LOOKUPS; i++) {
+		if (!net_ipv6_nbr_lookup(iface, &nbr_addrs6[i % count])) {
+			printk("Neighbor %d not found\n", i % count);
+			return -ENOENT;
+		}
+	}
+
+	cycles = bench_cycles(start);
+
+	bench_timed("nbr_lookup", N_LOOKUPS, cycles, "cache=ipv6 entries=%d",
+		    count);
+
+	return 0;
+}
+
+static int run(struct net_if *iface,
+	       int (*add)(struct net_if *iface, int idx),
+	       int (*lookup)(struct net_if *iface, int count))
+{
+	int added = 0;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(table_sizes); i++) {
+		for (; added < table_sizes[i]; added++) {
+			if (add(iface, added) < 0) {
+				printk("Cannot add neighbor %d\n", added);
+				return -1;
+			}
+		}
+
+		if (lookup(iface, table_sizes[i]) < 0) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+void main(void)
+{
+	struct net_if *iface = net_if_get_default();
+	struct net_if_addr *ifaddr;
+	int i;
+
+	ifaddr = net_if_ipv4_addr_add(iface, &my_addr, NET_ADDR_MANUAL, 0);
+	if (!ifaddr) {
+		printk("Cannot add address\n");
+		return;
+	}
+
+	ifaddr->addr_state = NET_ADDR_PREFERRED;
+	net_if_ipv4_set_netmask(iface, &netmask);
+
+	for (i = 0; i < MAX_NBRS; i++) {
+		nbr_addrs[i].s4_addr[0] = 192;
+		nbr_addrs[i].s4_addr[1] = 0;
+		nbr_addrs[i].s4_addr[2] = 2;
+		nbr_addrs[i].s4_addr[3] = 10 + i;
+
+		net_ipv6_addr_create(&nbr_addrs6[i], 0x2001, 0xdb8, 0, 0, 0, 0,
+				     0, 10 + i);
+
+		memcpy(nbr_macs[i], fake_mac, sizeof(fake_mac));
+		nbr_macs[i][5] = 10 + i;
+	}
+
+	if (run(iface, arp_add, run_arp) < 0 ||
+	    run(iface, ipv6_add, run_ipv6) < 0) {
+		return;
+	}
+
+	bench_fin();
+}
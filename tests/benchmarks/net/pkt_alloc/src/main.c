@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+#include <net/net_pkt.h>
+#include <net/buf.h>
+
+#include "../../common/bench_common.h"
+
+/* Allocate and free TX packets of typical sizes, and report how many
+ * buffers and bytes of buffer memory they hold, and how many of them fit
+ * in the buffer pools at once.
+ */
+
+#define N_ALLOCS 1000
+#define MAX_PKTS CONFIG_NET_PKT_TX_COUNT
+
+static const size_t sizes[] = { 40, 200, 576, 1514 };
+static struct net_pkt *pkts[MAX_PKTS];
+
+/* TX data memory */
+#if defined(CONFIG_NET_BUF_SIZE_CLASSES)
+#define TX_DATA_RAM (CONFIG_NET_BUF_TX_COUNT * CONFIG_NET_BUF_DATA_SIZE + \
+		     CONFIG_NET_BUF_TX_MEDIUM_COUNT *			   \
+		     CONFIG_NET_BUF_MEDIUM_DATA_SIZE +			   \
+		     CONFIG_NET_BUF_TX_LARGE_COUNT *			   \
+		     CONFIG_NET_BUF_LARGE_DATA_SIZE)
+#else
+#define TX_DATA_RAM (CONFIG_NET_BUF_TX_COUNT * CONFIG_NET_BUF_DATA_SIZE)
+#endif
+
+static size_t buf_data_size(struct net_buf *buf)
+{
+	const struct net_buf_pool_fixed *fixed =
+		net_buf_pool_get(buf->pool_id)->alloc->alloc_data;
+
+	return fixed->data_size;
+}
+
+static struct net_pkt *alloc(size_t size)
+{
+	/* Without an interface the exact size is allocated */
+	return net_pkt_alloc_with_buffer(NULL, size, AF_UNSPEC, 0, K_NO_WAIT);
+}
+
+static int run_size(size_t size)
+{
+	uint32_t start, cycles;
+	struct net_pkt *pkt;
+	struct net_buf *buf;
+	size_t held = 0;
+	int frags = 0;
+	int i;
+
+	pkt = alloc(size);
+	if (!pkt) {
+		printk("Cannot allocate %zu bytes\n", size);
+		return -1;
+	}
+
+	for (buf = pkt->buffer; buf; buf = buf->frags) {
+		frags++;
+		held += buf_data_size(buf);
+	}
+
+	net_pkt_unref(pkt);
+
+	start = bench_start();
+
+	for (i = 0; i < N_ALLOCS; i++) {
+		pkt = alloc(size);
+		if (!pkt) {
+			printk("Cannot allocate %zu bytes\n", size);
+			return -1;
+		}
+
+		net_pkt_unref(pkt);
+	}
+
+	cycles = bench_cycles(start);
+
+	bench_timed("pkt_alloc", N_ALLOCS, cycles, "size=%zu frags=%d held=%zu",
+		    size, frags, held);
+
+	return 0;
+}
+
+static void run_capacity(size_t size)
+{
+	int count;
+	int i;
+
+	for (count = 0; count < MAX_PKTS; count++) {
+		pkts[count] = alloc(size);
+		if (!pkts[count]) {
+			break;
+		}
+	}
+
+	for (i = 0; i < count; i++) {
+		net_pkt_unref(pkts[i]);
+	}
+
+	bench_result("pkt_capacity", "size=%zu pkts=%d", size, count);
+}
+
+void main(void)
+{
+	int i;
+
+	bench_result("pkt_ram", "bytes=%d", TX_DATA_RAM);
+
+	for (i = 0; i < ARRAY_SIZE(sizes); i++) {
+		if (run_size(sizes[i]) < 0) {
+			return;
+		}
+	}
+
+	run_capacity(40);
+	run_capacity(1514);
+
+	bench_fin();
+}
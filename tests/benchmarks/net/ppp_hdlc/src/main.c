@@ -0,0 +1,429 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr.h>
+#include <string.h>
+#include <sys/printk.h>
+#include <sys/crc.h>
+#include <sys/byteorder.h>
+#include <random/rand32.h>
+#include <drivers/uart.h>
+#include <net/net_if.h>
+#include <net/ppp.h>
+
+#include "ppp_hdlc.h"
+
+#include "../../common/bench_common.h"
+
+/* Escape, unescape and checksum full size PPP frames byte at a time as
+ * the driver used to do and with the HDLC engine of the driver. Then
+ * feed frames to the PPP driver through a UART which stands in for the
+ * pseudo tty of the host and receives with the async API.
+ */
+
+#define N_ROUNDS 100
+#define N_FRAMES 64
+#define FRAME_LEN 1500
+#define UART_CHUNK 64
+
+static uint8_t frame[FRAME_LEN];
+static uint8_t escaped[2 * FRAME_LEN + 8];
+static uint8_t escaped_ref[sizeof(escaped)];
+static uint8_t unescaped[sizeof(escaped)];
+static uint8_t unescaped_ref[sizeof(escaped)];
+
+static size_t ref_escape(const uint8_t *src, size_t len, uint8_t *dst)
+{
+	size_t out = 0;
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		if (src[i] < 0x20 || src[i] == PPP_HDLC_FLAG ||
+		    src[i] == PPP_HDLC_ESCAPE) {
+			dst[out++] = PPP_HDLC_ESCAPE;
+			dst[out++] = src[i] ^ 0x20;
+		} else {
+			dst[out++] = src[i];
+		}
+	}
+
+	return out;
+}
+
+static size_t ref_unescape(const uint8_t *src, size_t len, uint8_t *dst)
+{
+	bool next_escaped = false;
+	size_t out = 0;
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		if (next_escaped) {
+			dst[out++] = src[i] ^ 0x20;
+			next_escaped = false;
+		} else if (src[i] == PPP_HDLC_ESCAPE) {
+			next_escaped = true;
+		} else {
+			dst[out++] = src[i];
+		}
+	}
+
+	return out;
+}
+
+static size_t engine_escape(const uint8_t *src, size_t len, uint8_t *dst)
+{
+	size_t written = sizeof(escaped);
+
+	/* The destination has room for the whole frame */
+	(void)ppp_hdlc_escape(src, len, dst, &written);
+
+	return written;
+}
+
+static size_t engine_unescape(const uint8_t *src, size_t len, uint8_t *dst)
+{
+	bool next_escaped = false;
+	size_t written;
+
+	(void)ppp_hdlc_unescape(src, len, dst, &written, &next_escaped);
+
+	return written;
+}
+
+static void fill_text(uint8_t *data, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		data[i] = 'a' + i % 26;
+	}
+}
+
+static void fill_random(uint8_t *data, size_t len)
+{
+	sys_rand_get(data, len);
+}
+
+static void fill_control(uint8_t *data, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		data[i] = i % 0x20;
+	}
+}
+
+static const struct {
+	const char *name;
+	void (*fill)(uint8_t *data, size_t len);
+} contents[] = {
+	{ "text", fill_text },
+	{ "random", fill_random },
+	{ "control", fill_control },
+};
+
+static void run_engine(const char *name)
+{
+	uint32_t start, esc_ref, esc, unesc_ref, unesc, fcs_ref, fcs;
+	size_t len, len_ref, out, out_ref;
+	uint16_t crc, crc_ref;
+	int mismatch = 0;
+	int i;
+
+	start = bench_start();
+	for (i = 0; i < N_ROUNDS; i++) {
+		len_ref = ref_escape(frame, sizeof(frame), escaped_ref);
+	}
+	esc_ref = bench_cycles(start);
+
+	start = bench_start();
+	for (i = 0; i < N_ROUNDS; i++) {
+		len = engine_escape(frame, sizeof(frame), escaped);
+	}
+	esc = bench_cycles(start);
+
+	start = bench_start();
+	for (i = 0; i < N_ROUNDS; i++) {
+		out_ref = ref_unescape(escaped_ref, len_ref, unescaped_ref);
+	}
+	unesc_ref = bench_cycles(start);
+
+	start = bench_start();
+	for (i = 0; i < N_ROUNDS; i++) {
+		out = engine_unescape(escaped, len, unescaped);
+	}
+	unesc = bench_cycles(start);
+
+	start = bench_start();
+	for (i = 0; i < N_ROUNDS; i++) {
+		crc_ref = crc16_ccitt(PPP_HDLC_INIT_FCS, frame, sizeof(frame));
+	}
+	fcs_ref = bench_cycles(start);
+
+	start = bench_start();
+	for (i = 0; i < N_ROUNDS; i++) {
+		crc = ppp_hdlc_fcs(PPP_HDLC_INIT_FCS, frame, sizeof(frame));
+	}
+	fcs = bench_cycles(start);
+
+	if (len != len_ref || memcmp(escaped, escaped_ref, len) != 0) {
+		mismatch++;
+	}
+
+	if (out != sizeof(frame) || out_ref != sizeof(frame) ||
+	    memcmp(unescaped, frame, out) != 0) {
+		mismatch++;
+	}
+
+	if (crc != crc_ref) {
+		mismatch++;
+	}
+
+	bench_timed("ppp_escape", N_ROUNDS, esc_ref, "content=%s impl=ref",
+		    name);
+	bench_timed("ppp_escape", N_ROUNDS, esc, "content=%s impl=engine",
+		    name);
+	bench_timed("ppp_unescape", N_ROUNDS, unesc_ref, "content=%s impl=ref",
+		    name);
+	bench_timed("ppp_unescape", N_ROUNDS, unesc, "content=%s impl=engine",
+		    name);
+	bench_timed("ppp_fcs", N_ROUNDS, fcs_ref, "content=%s impl=ref", name);
+	bench_timed("ppp_fcs", N_ROUNDS, fcs, "content=%s impl=engine", name);
+	bench_result("ppp_engine", "content=%s mismatch=%d", name, mismatch);
+}
+
+/* Loopback UART with the async API. Received data is written to the
+ * buffers given by the PPP driver as a DMA would do.
+ */
+struct bench_uart_data {
+	uart_callback_t callback;
+	void *user_data;
+	uint8_t *buf;
+	size_t len;
+	size_t offset;
+	uint8_t *next_buf;
+	size_t next_len;
+	size_t tx_bytes;
+};
+
+static struct bench_uart_data bench_uart_data;
+
+static void bench_uart_event(struct bench_uart_data *data,
+			     struct uart_event *evt)
+{
+	if (data->callback) {
+		data->callback(evt, data->user_data);
+	}
+}
+
+static int bench_uart_callback_set(struct device *dev,
+				   uart_callback_t callback, void *user_data)
+{
+	struct bench_uart_data *data = dev->driver_data;
+
+	data->callback = callback;
+	data->user_data = user_data;
+
+	return 0;
+}
+
+static int bench_uart_tx(struct device *dev, const uint8_t *buf, size_t len,
+			 int32_t timeout)
+{
+	struct bench_uart_data *data = dev->driver_data;
+	struct uart_event evt = {
+		.type = UART_TX_DONE,
+		.data.tx.buf = buf,
+		.data.tx.len = len,
+	};
+
+	data->tx_bytes += len;
+
+	bench_uart_event(data, &evt);
+
+	return 0;
+}
+
+static int bench_uart_rx_enable(struct device *dev, uint8_t *buf, size_t len,
+				int32_t timeout)
+{
+	struct bench_uart_data *data = dev->driver_data;
+	struct uart_event evt = {
+		.type = UART_RX_BUF_REQUEST,
+	};
+
+	if (data->buf) {
+		return -EBUSY;
+	}
+
+	data->buf = buf;
+	data->len = len;
+	data->offset = 0;
+
+	bench_uart_event(data, &evt);
+
+	return 0;
+}
+
+static int bench_uart_rx_buf_rsp(struct device *dev, uint8_t *buf, size_t len)
+{
+	struct bench_uart_data *data = dev->driver_data;
+
+	data->next_buf = buf;
+	data->next_len = len;
+
+	return 0;
+}
+
+static int bench_uart_rx_disable(struct device *dev)
+{
+	struct bench_uart_data *data = dev->driver_data;
+
+	data->buf = NULL;
+	data->next_buf = NULL;
+
+	return 0;
+}
+
+static void bench_uart_rx(struct device *dev, const uint8_t *buf, size_t len)
+{
+	struct bench_uart_data *data = dev->driver_data;
+	struct uart_event evt;
+	size_t count;
+
+	while (len > 0 && data->buf) {
+		count = MIN(len, data->len - data->offset);
+		memcpy(data->buf + data->offset, buf, count);
+
+		evt.type = UART_RX_RDY;
+		evt.data.rx.buf = data->buf;
+		evt.data.rx.offset = data->offset;
+		evt.data.rx.len = count;
+		bench_uart_event(data, &evt);
+
+		data->offset += count;
+		buf += count;
+		len -= count;
+
+		if (data->offset < data->len) {
+			continue;
+		}
+
+		evt.type = UART_RX_BUF_RELEASED;
+		evt.data.rx_buf.buf = data->buf;
+
+		data->buf = data->next_buf;
+		data->len = data->next_len;
+		data->offset = 0;
+		data->next_buf = NULL;
+
+		bench_uart_event(data, &evt);
+
+		if (data->buf) {
+			evt.type = UART_RX_BUF_REQUEST;
+		} else {
+			evt.type = UART_RX_DISABLED;
+		}
+
+		bench_uart_event(data, &evt);
+	}
+}
+
+static int bench_uart_init(struct device *dev)
+{
+	return 0;
+}
+
+static const struct uart_driver_api bench_uart_api = {
+	.callback_set = bench_uart_callback_set,
+	.tx = bench_uart_tx,
+	.rx_enable = bench_uart_rx_enable,
+	.rx_buf_rsp = bench_uart_rx_buf_rsp,
+	.rx_disable = bench_uart_rx_disable,
+};
+
+DEVICE_AND_API_INIT(bench_uart, "BENCH_UART", bench_uart_init,
+		    &bench_uart_data, NULL, POST_KERNEL,
+		    CONFIG_KERNEL_INIT_PRIORITY_DEVICE, &bench_uart_api);
+
+/* Build an IPv4 frame with the reference encoder */
+static size_t build_frame(uint8_t *buf)
+{
+	uint8_t header[] = { 0xff, 0x03, 0x00, 0x21 };
+	uint8_t fcs_bytes[2];
+	uint16_t fcs;
+	size_t len = 0;
+
+	fcs = crc16_ccitt(PPP_HDLC_INIT_FCS, header, sizeof(header));
+	fcs = crc16_ccitt(fcs, frame, sizeof(frame)) ^ 0xffff;
+	sys_put_le16(fcs, fcs_bytes);
+
+	buf[len++] = PPP_HDLC_FLAG;
+	len += ref_escape(header, sizeof(header), &buf[len]);
+	len += ref_escape(frame, sizeof(frame), &buf[len]);
+	len += ref_escape(fcs_bytes, sizeof(fcs_bytes), &buf[len]);
+	buf[len++] = PPP_HDLC_FLAG;
+
+	return len;
+}
+
+static void run_uart(struct net_if *iface)
+{
+	const struct ppp_api *api = net_if_get_device(iface)->driver_api;
+	struct net_stats_ppp *stats = api->get_stats(net_if_get_device(iface));
+	struct device *uart = DEVICE_GET(bench_uart);
+	uint32_t start, cycles = 0;
+	uint32_t rx_before = stats->pkts.rx;
+	size_t len, off, count, total = 0;
+	int i;
+
+	fill_random(frame, sizeof(frame));
+	len = build_frame(escaped);
+
+	for (i = 0; i < N_FRAMES; i++) {
+		start = bench_start();
+
+		for (off = 0; off < len; off += count) {
+			count = MIN(UART_CHUNK, len - off);
+			bench_uart_rx(uart, &escaped[off], count);
+		}
+
+		cycles += bench_cycles(start);
+		total += len;
+
+		/* Let the RX thread free the packet */
+		k_sleep(K_MSEC(1));
+	}
+
+	bench_timed("ppp_uart_rx", N_FRAMES, cycles,
+		    "bytes=%zu received=%u chkerr=%u", total,
+		    stats->pkts.rx - rx_before, stats->chkerr);
+}
+
+void main(void)
+{
+	struct net_if *iface = net_if_get_default();
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(contents); i++) {
+		contents[i].fill(frame, sizeof(frame));
+		run_engine(contents[i].name);
+	}
+
+	/* The PPP driver starts receiving once the interface is up */
+	for (i = 0; i < 100 && !bench_uart_data.callback; i++) {
+		k_sleep(K_MSEC(10));
+	}
+
+	if (!bench_uart_data.callback) {
+		printk("PPP not started on %s\n", DEVICE_GET(bench_uart)->name);
+		return;
+	}
+
+	run_uart(iface);
+
+	bench_fin();
+}
@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+#include <net/net_if.h>
+#include <net/net_ip.h>
+#include <net/dummy.h>
+
+#include "ipv6.h"
+#include "route.h"
+
+#include "../../common/bench_common.h"
+
+/* Compare net_route_lookup() with a linear longest prefix match scan
+ * over the same prefixes, which is also used to verify the results.
+ */
+
+#define N_LOOKUPS 4096
+#define N_HOT 8
+#define MAX_ROUTES CONFIG_NET_MAX_ROUTES
+
+static const int table_sizes[] = { 16, 256, 2048 };
+
+static struct {
+	struct in6_addr addr;
+	uint8_t len;
+} prefixes[MAX_ROUTES];
+
+static struct in6_addr dests[N_LOOKUPS];
+
+static struct in6_addr nexthop = { { { 0xfe, 0x80, 0, 0, 0, 0, 0, 0,
+				       0, 0, 0, 0, 0, 0, 0, 0x1 } } };
+
+static uint8_t fake_mac[] = { 0x00, 0x00, 0x5E, 0x00, 0x53, 0x01 };
+static uint8_t nexthop_mac[] = { 0x00, 0x00, 0x5E, 0x00, 0x53, 0x02 };
+
+static uint32_t rand_state = 1U;
+
+static uint32_t next_rand(void)
+{
+	rand_state = rand_state * 1103515245U + 12345U;
+
+	return rand_state >> 8;
+}
+
+static void bench_iface_init(struct net_if *iface)
+{
+	net_if_set_link_addr(iface, fake_mac, sizeof(fake_mac),
+			     NET_LINK_ETHERNET);
+}
+
+static int bench_send(struct device *dev, struct net_pkt *pkt)
+{
+	return 0;
+}
+
+static int bench_dev_init(struct device *dev)
+{
+	return 0;
+}
+
+static struct dummy_api bench_if_api = {
+	.iface_api.init = bench_iface_init,
+	.send = bench_send,
+};
+
+NET_DEVICE_INIT(route_bench, "route_bench",
+		bench_dev_init, device_pm_control_nop, NULL, NULL,
+		CONFIG_KERNEL_INIT_PRIORITY_DEFAULT,
+		&bench_if_api, DUMMY_L2, NET_L2_GET_CTX_TYPE(DUMMY_L2), 127);
+
+/* Random prefix of 32 to 128 bits in 2001:db8::/32 */
+static void gen_prefix(int idx)
+{
+	struct in6_addr *addr = &prefixes[idx].addr;
+	uint8_t len = 32 + next_rand() % 97;
+	int i;
+
+	addr->s6_addr[0] = 0x20;
+	addr->s6_addr[1] = 0x01;
+	addr->s6_addr[2] = 0x0d;
+	addr->s6_addr[3] = 0xb8;
+
+	for (i = 4; i < 16; i++) {
+		if (i * 8 >= len) {
+			addr->s6_addr[i] = 0U;
+		} else if ((i + 1) * 8 > len) {
+			addr->s6_addr[i] = next_rand() & (0xff << (8 - len % 8));
+		} else {
+			/* Few distinct values keep the prefixes nested */
+			addr->s6_addr[i] = next_rand() % 4;
+		}
+	}
+
+	prefixes[idx].len = len;
+}
+
+static void gen_dest(struct in6_addr *dst, int count)
+{
+	int idx = next_rand() % count;
+	uint8_t len = prefixes[idx].len;
+	int i;
+
+	net_ipaddr_copy(dst, &prefixes[idx].addr);
+
+	for (i = len / 8; i < 16; i++) {
+		uint8_t host = next_rand() % 4;
+
+		if (i == len / 8) {
+			host &= 0xff >> (len % 8);
+		}
+
+		dst->s6_addr[i] |= host;
+	}
+
+	if (next_rand() % 16 == 0) {
+		dst->s6_addr[3] = 0xb9;
+	}
+}
+
+static int linear_lookup(struct in6_addr *dst, int count)
+{
+	uint8_t longest_match = 0U;
+	int i, found = -1;
+
+	for (i = 0; i < count; i++) {
+		if (prefixes[i].len >= longest_match &&
+		    net_ipv6_is_prefix((uint8_t *)dst,
+				       (uint8_t *)&prefixes[i].addr,
+				       prefixes[i].len)) {
+			found = i;
+			longest_match = prefixes[i].len;
+		}
+	}
+
+	return found;
+}
+
+static bool same_prefix(struct net_route_entry *route, int idx)
+{
+	if (!route || idx < 0) {
+		return !route && idx < 0;
+	}
+
+	return route->prefix_len == prefixes[idx].len &&
+	       net_ipv6_addr_cmp(&route->addr, &prefixes[idx].addr);
+}
+
+static void run(struct net_if *iface, int count)
+{
+	uint32_t linear, table, hot, start;
+	int mismatch = 0;
+	int i;
+
+	for (i = 0; i < N_LOOKUPS; i++) {
+		gen_dest(&dests[i], count);
+	}
+
+	start = bench_start();
+
+	for (i = 0; i < N_LOOKUPS; i++) {
+		(void)linear_lookup(&dests[i], count);
+	}
+
+	linear = bench_cycles(start);
+	start = bench_start();
+
+	for (i = 0; i < N_LOOKUPS; i++) {
+		(void)net_route_lookup(iface, &dests[i]);
+	}
+
+	table = bench_cycles(start);
+	start = bench_start();
+
+	for (i = 0; i < N_LOOKUPS; i++) {
+		(void)net_route_lookup(iface, &dests[i % N_HOT]);
+	}
+
+	hot = bench_cycles(start);
+
+	for (i = 0; i < N_LOOKUPS; i++) {
+		if (!same_prefix(net_route_lookup(iface, &dests[i]),
+				 linear_lookup(&dests[i], count))) {
+			mismatch++;
+		}
+	}
+
+	bench_timed("route_lookup", N_LOOKUPS, linear,
+		    "routes=%d lookup=linear", count);
+	bench_timed("route_lookup", N_LOOKUPS, table,
+		    "routes=%d lookup=table", count);
+	bench_timed("route_lookup", N_LOOKUPS, hot,
+		    "routes=%d lookup=hot", count);
+	bench_result("route_check", "routes=%d mismatch=%d", count, mismatch);
+}
+
+void main(void)
+{
+	struct net_linkaddr lladdr = {
+		.addr = nexthop_mac,
+		.len = sizeof(nexthop_mac),
+		.type = NET_LINK_ETHERNET,
+	};
+	struct net_if *iface;
+	int count = 0;
+	int i;
+
+	iface = net_if_get_first_by_type(&NET_L2_GET_NAME(DUMMY));
+	if (!iface) {
+		printk("No interface\n");
+		return;
+	}
+
+	if (!net_ipv6_nbr_add(iface, &nexthop, &lladdr, true,
+			      NET_IPV6_NBR_STATE_REACHABLE)) {
+		printk("Cannot add nexthop neighbor\n");
+		return;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(table_sizes); i++) {
+		if (table_sizes[i] > MAX_ROUTES) {
+			break;
+		}
+
+		while (count < table_sizes[i]) {
+			gen_prefix(count);
+
+			if (!net_route_add(iface, &prefixes[count].addr,
+					   prefixes[count].len, &nexthop)) {
+				printk("Cannot add route %d\n", count);
+				return;
+			}
+
+			count++;
+		}
+
+		run(iface, count);
+	}
+
+	bench_fin();
+}
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+#include <net/socket.h>
+
+#include "../../common/bench_common.h"
+
+/* Compare the copying and the zero-copy socket receive paths. A
+ * datagram is sent over the loopback interface and then received and
+ * "parsed" (summed up), only the receive and the parsing are timed.
+ */
+
+#define N_RUNS 1000
+#define N_SETTLE 10
+#define DGRAM_LEN 512
+#define MAX_FRAGS 16
+#define PORT 4242
+
+static uint8_t tx_buf[DGRAM_LEN];
+static uint8_t rx_buf[DGRAM_LEN];
+
+struct result {
+	uint32_t bytes;
+	uint32_t copied;
+	uint32_t cycles;
+	uint32_t sum;
+};
+
+static uint32_t parse(const uint8_t *data, size_t len)
+{
+	uint32_t sum = 0U;
+
+	while (len--) {
+		sum += *data++;
+	}
+
+	return sum;
+}
+
+static int send_dgram(int sock, struct sockaddr_in *addr)
+{
+	ssize_t ret;
+
+	ret = zsock_sendto(sock, tx_buf, sizeof(tx_buf), 0,
+			   (struct sockaddr *)addr, sizeof(*addr));
+
+	return ret == sizeof(tx_buf) ? 0 : -1;
+}
+
+static int recv_copy(int sock, struct result *res, bool count)
+{
+	uint32_t start = bench_start();
+	ssize_t ret;
+	uint32_t sum;
+
+	ret = zsock_recvfrom(sock, rx_buf, sizeof(rx_buf), 0, NULL, NULL);
+	if (ret < 0) {
+		return -1;
+	}
+
+	sum = parse(rx_buf, ret);
+
+	if (count) {
+		res->cycles += bench_cycles(start);
+		res->bytes += ret;
+		res->copied += ret;
+		res->sum += sum;
+	}
+
+	return 0;
+}
+
+static int recv_zerocopy(int sock, struct result *res, bool count)
+{
+	uint32_t start = bench_start();
+	struct iovec iov[MAX_FRAGS];
+	struct zsock_zc_buf zc;
+	struct msghdr msg = {
+		.msg_iov = iov,
+		.msg_iovlen = ARRAY_SIZE(iov),
+	};
+	uint32_t sum = 0U;
+	ssize_t ret;
+	size_t i;
+
+	ret = zsock_recvmsg_zc(sock, &msg, 0, &zc);
+	if (ret < 0) {
+		return -1;
+	}
+
+	for (i = 0; i < msg.msg_iovlen; i++) {
+		sum += parse(iov[i].iov_base, iov[i].iov_len);
+	}
+
+	zsock_recv_zc_release(&zc);
+
+	if (count) {
+		res->cycles += bench_cycles(start);
+		res->bytes += ret;
+		res->sum += sum;
+	}
+
+	return 0;
+}
+
+static int run(const char *name, int client, int server,
+	       struct sockaddr_in *addr,
+	       int (*recv_fn)(int sock, struct result *res, bool count))
+{
+	struct result res = { 0 };
+	int i;
+
+	for (i = 0; i < N_RUNS + N_SETTLE; i++) {
+		if (send_dgram(client, addr) < 0) {
+			printk("%s: send failed (%d)\n", name, errno);
+			return -1;
+		}
+
+		if (recv_fn(server, &res, i >= N_SETTLE) < 0) {
+			printk("%s: recv failed (%d)\n", name, errno);
+			return -1;
+		}
+	}
+
+	bench_timed("socket_recv", N_RUNS, res.cycles,
+		    "api=%s bytes=%u copied=%u sum=%u", name, res.bytes,
+		    res.copied, res.sum);
+
+	return 0;
+}
+
+void main(void)
+{
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_port = htons(PORT),
+	};
+	int client, server;
+	int i;
+
+	for (i = 0; i < sizeof(tx_buf); i++) {
+		tx_buf[i] = i;
+	}
+
+	zsock_inet_pton(AF_INET, CONFIG_NET_CONFIG_MY_IPV4_ADDR,
+			&addr.sin_addr);
+
+	client = zsock_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	server = zsock_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (client < 0 || server < 0) {
+		printk("Cannot create sockets (%d)\n", errno);
+		return;
+	}
+
+	if (zsock_bind(server, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		printk("Cannot bind (%d)\n", errno);
+		return;
+	}
+
+	if (run("copy", client, server, &addr, recv_copy) < 0 ||
+	    run("zerocopy", client, server, &addr, recv_zerocopy) < 0) {
+		return;
+	}
+
+	zsock_close(client);
+	zsock_close(server);
+
+	bench_fin();
+}
@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+#include <net/socket.h>
+#include <net/socket_service.h>
+
+#include "../../common/bench_common.h"
+
+/* Send N_MSGS requests in turn to N_SERVICES UDP echo services on the
+ * loopback interface and wait for every reply, with the socket service
+ * dispatcher and then with a thread per service.
+ */
+
+#define N_MSGS 1000
+#define N_SERVICES 3
+#define PAYLOAD_SIZE 32
+#define BASE_PORT 4950
+#define SERVICE_STACK_SIZE 1024
+
+static int service_socks[N_SERVICES];
+static int client_sock;
+static uint8_t payload[PAYLOAD_SIZE];
+static uint8_t reply[PAYLOAD_SIZE];
+
+static K_THREAD_STACK_ARRAY_DEFINE(service_stacks, N_SERVICES,
+				   SERVICE_STACK_SIZE);
+static struct k_thread service_threads[N_SERVICES];
+
+static void echo(int sock, int flags)
+{
+	uint8_t buf[PAYLOAD_SIZE];
+	struct sockaddr addr;
+	socklen_t addr_len = sizeof(addr);
+	ssize_t len;
+
+	len = recvfrom(sock, buf, sizeof(buf), flags, &addr,
+		       &addr_len);
+	if (len > 0) {
+		sendto(sock, buf, len, 0, &addr, addr_len);
+	}
+}
+
+static void service_thread(void *p1, void *p2, void *p3)
+{
+	int sock = POINTER_TO_INT(p1);
+
+	while (1) {
+		echo(sock, 0);
+	}
+}
+
+static void service_handler(struct net_socket_service_event *pev)
+{
+	echo(pev->event.fd, MSG_DONTWAIT);
+}
+
+NET_SOCKET_SERVICE_DEFINE(echo_service, NULL, service_handler, N_SERVICES);
+NET_SOCKET_SERVICE_DEFINE(echo_service_wq, &k_sys_work_q, service_handler,
+			  N_SERVICES);
+
+static int udp_socket(uint16_t port)
+{
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_port = htons(port),
+		.sin_addr = { { { 127, 0, 0, 1 } } },
+	};
+	int sock;
+
+	sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (sock < 0 ||
+	    bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		printk("Cannot set up socket (%d)\n", errno);
+		return -1;
+	}
+
+	return sock;
+}
+
+static int request_all(void)
+{
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_addr = { { { 127, 0, 0, 1 } } },
+	};
+	ssize_t len;
+	int i;
+
+	for (i = 0; i < N_MSGS; i++) {
+		addr.sin_port = htons(BASE_PORT + i % N_SERVICES);
+
+		if (sendto(client_sock, payload, sizeof(payload), 0,
+			   (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+			printk("Cannot send request %d (%d)\n", i, errno);
+			return -1;
+		}
+
+		len = recv(client_sock, reply, sizeof(reply), 0);
+		if (len != sizeof(payload)) {
+			printk("Cannot receive reply %d (%d)\n", i, errno);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static void report(const char *name, int threads, int stack, uint32_t cycles)
+{
+	bench_timed("socket_service", N_MSGS, cycles,
+		    "mode=%s threads=%d stack=%d", name, threads, stack);
+}
+
+static int run_service(struct net_socket_service_desc *svc)
+{
+	struct zsock_pollfd fds[N_SERVICES];
+	uint32_t start, cycles;
+	int ret;
+	int i;
+
+	for (i = 0; i < N_SERVICES; i++) {
+		fds[i].fd = service_socks[i];
+		fds[i].events = ZSOCK_POLLIN;
+	}
+
+	ret = net_socket_service_register(svc, fds, N_SERVICES, NULL);
+	if (ret < 0) {
+		printk("Cannot register service (%d)\n", ret);
+		return ret;
+	}
+
+	start = bench_start();
+	ret = request_all();
+	cycles = bench_cycles(start);
+
+	net_socket_service_unregister(svc);
+
+	if (ret < 0) {
+		return ret;
+	}
+
+	report(svc->work_q ? "service_wq" : "service", 1,
+	       CONFIG_NET_SOCKETS_SERVICE_STACK_SIZE, cycles);
+
+	return 0;
+}
+
+static int run_threads(void)
+{
+	uint32_t start, cycles;
+	int ret;
+	int i;
+
+	for (i = 0; i < N_SERVICES; i++) {
+		k_thread_create(&service_threads[i], service_stacks[i],
+				K_THREAD_STACK_SIZEOF(service_stacks[i]),
+				service_thread,
+				INT_TO_POINTER(service_socks[i]), NULL, NULL,
+				CONFIG_NET_SOCKETS_SERVICE_THREAD_PRIO, 0,
+				K_NO_WAIT);
+	}
+
+	start = bench_start();
+	ret = request_all();
+	cycles = bench_cycles(start);
+
+	for (i = 0; i < N_SERVICES; i++) {
+		k_thread_abort(&service_threads[i]);
+	}
+
+	if (ret < 0) {
+		return ret;
+	}
+
+	report("threads", N_SERVICES, N_SERVICES * SERVICE_STACK_SIZE, cycles);
+
+	return 0;
+}
+
+void main(void)
+{
+	int i;
+
+	memset(payload, 'x', sizeof(payload));
+
+	for (i = 0; i < N_SERVICES; i++) {
+		service_socks[i] = udp_socket(BASE_PORT + i);
+		if (service_socks[i] < 0) {
+			return;
+		}
+	}
+
+	client_sock = udp_socket(BASE_PORT + N_SERVICES);
+	if (client_sock < 0) {
+		return;
+	}
+
+	/* The service threads are aborted, so run them last */
+	if (run_service(&echo_service) < 0 ||
+	    run_service(&echo_service_wq) < 0 ||
+	    run_threads() < 0) {
+		return;
+	}
+
+	bench_fin();
+}
@@ -0,0 +1,15 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __BENCH_H
+#define __BENCH_H
+
+#define BENCH_PORT 4242
+
+/* Start the in-process echo server */
+int bench_echo_start(void);
+
+#endif /* __BENCH_H */
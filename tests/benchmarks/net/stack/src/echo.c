@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+#include <net/socket.h>
+
+#include "bench.h"
+
+/* UDP and TCP echo server on both address families, which the
+ * benchmarks talk to when no peer is configured.
+ */
+
+#define MAX_FDS CONFIG_NET_SOCKETS_POLL_MAX
+#define STACK_SIZE 2048
+
+static struct pollfd fds[MAX_FDS];
+static int types[MAX_FDS];
+static int nfds;
+
+static char buf[1024];
+
+static K_THREAD_STACK_DEFINE(echo_stack, STACK_SIZE);
+static struct k_thread echo_thread;
+static K_SEM_DEFINE(echo_ready, 0, 1);
+
+enum {
+	ECHO_UDP,
+	ECHO_LISTENER,
+	ECHO_CONN,
+};
+
+static int add_fd(int fd, int type)
+{
+	if (nfds == MAX_FDS) {
+		return -ENOMEM;
+	}
+
+	fds[nfds].fd = fd;
+	fds[nfds].events = POLLIN;
+	types[nfds] = type;
+	nfds++;
+
+	return 0;
+}
+
+static void del_fd(int idx)
+{
+	close(fds[idx].fd);
+
+	nfds--;
+	fds[idx] = fds[nfds];
+	types[idx] = types[nfds];
+}
+
+static int open_socket(sa_family_t family, int type)
+{
+	struct sockaddr_storage addr = { 0 };
+	socklen_t addrlen;
+	int fd;
+
+	if (family == AF_INET) {
+		net_sin((struct sockaddr *)&addr)->sin_family = AF_INET;
+		net_sin((struct sockaddr *)&addr)->sin_port = htons(BENCH_PORT);
+		addrlen = sizeof(struct sockaddr_in);
+	} else {
+		net_sin6((struct sockaddr *)&addr)->sin6_family = AF_INET6;
+		net_sin6((struct sockaddr *)&addr)->sin6_port = htons(BENCH_PORT);
+		addrlen = sizeof(struct sockaddr_in6);
+	}
+
+	fd = socket(family, type,
+		    type == SOCK_DGRAM ? IPPROTO_UDP : IPPROTO_TCP);
+	if (fd < 0) {
+		return -errno;
+	}
+
+	if (bind(fd, (struct sockaddr *)&addr, addrlen) < 0 ||
+	    (type == SOCK_STREAM && listen(fd, 2) < 0)) {
+		close(fd);
+		return -errno;
+	}
+
+	return fd;
+}
+
+static int send_all(int fd, const char *data, size_t len)
+{
+	ssize_t ret;
+
+	while (len > 0) {
+		ret = send(fd, data, len, 0);
+		if (ret < 0) {
+			return -errno;
+		}
+
+		data += ret;
+		len -= ret;
+	}
+
+	return 0;
+}
+
+static void echo(int idx)
+{
+	struct sockaddr_storage addr;
+	socklen_t addrlen = sizeof(addr);
+	ssize_t len;
+	int fd;
+
+	switch (types[idx]) {
+	case ECHO_UDP:
+		len = recvfrom(fds[idx].fd, buf, sizeof(buf), 0,
+			       (struct sockaddr *)&addr, &addrlen);
+		if (len > 0) {
+			(void)sendto(fds[idx].fd, buf, len, 0,
+				     (struct sockaddr *)&addr, addrlen);
+		}
+
+		break;
+
+	case ECHO_LISTENER:
+		fd = accept(fds[idx].fd, NULL, NULL);
+		if (fd >= 0 && add_fd(fd, ECHO_CONN) < 0) {
+			close(fd);
+		}
+
+		break;
+
+	case ECHO_CONN:
+		len = recv(fds[idx].fd, buf, sizeof(buf), 0);
+		if (len <= 0 || send_all(fds[idx].fd, buf, len) < 0) {
+			del_fd(idx);
+		}
+
+		break;
+	}
+}
+
+static void echo_server(void *p1, void *p2, void *p3)
+{
+	static const sa_family_t families[] = { AF_INET, AF_INET6 };
+	int fd;
+	int i;
+
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	for (i = 0; i < ARRAY_SIZE(families); i++) {
+		fd = open_socket(families[i], SOCK_DGRAM);
+		if (fd < 0 || add_fd(fd, ECHO_UDP) < 0) {
+			printk("Cannot open UDP echo socket (%d)\n", fd);
+			return;
+		}
+
+		fd = open_socket(families[i], SOCK_STREAM);
+		if (fd < 0 || add_fd(fd, ECHO_LISTENER) < 0) {
+			printk("Cannot open TCP echo socket (%d)\n", fd);
+			return;
+		}
+	}
+
+	k_sem_give(&echo_ready);
+
+	while (true) {
+		if (poll(fds, nfds, -1) < 0) {
+			printk("Echo server poll failed (%d)\n", errno);
+			return;
+		}
+
+		/* Handled from the end, as closing a connection moves the
+		 * last descriptor to its place.
+		 */
+		for (i = nfds - 1; i >= 0; i--) {
+			if (fds[i].revents & (POLLIN | POLLERR | POLLHUP)) {
+				echo(i);
+			}
+		}
+	}
+}
+
+int bench_echo_start(void)
+{
+	k_thread_create(&echo_thread, echo_stack,
+			K_THREAD_STACK_SIZEOF(echo_stack), echo_server,
+			NULL, NULL, NULL, CONFIG_MAIN_THREAD_PRIORITY, 0,
+			K_NO_WAIT);
+	k_thread_name_set(&echo_thread, "echo");
+
+	return k_sem_take(&echo_ready, K_SECONDS(1));
+}
@@ -0,0 +1,449 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+#include <net/socket.h>
+#include <net/net_mgmt.h>
+#include <net/net_stats.h>
+
+#include "bench.h"
+#include "../../common/bench_common.h"
+
+/* UDP packet rate, TCP bulk throughput, UDP and TCP round trip time and
+ * TCP connection setup rate, measured with sockets against an echo
+ * server. Each result is printed on one line as the name of the
+ * benchmark followed by key=value pairs, and followed by the average
+ * cycles a packet spent in each layer of the TX and RX paths.
+ */
+
+#define UDP_PKTS 1000
+#define UDP_SIZE 64
+#define UDP_BATCH 8
+#define TCP_BYTES (64 * 1024)
+#define TCP_WRITE 1024
+/* TCP does not limit the data queued for sending, so keep the data in
+ * flight within what the buffer pools hold.
+ */
+#define TCP_IN_FLIGHT (4 * TCP_WRITE)
+#define RTT_ROUNDS 200
+#define RTT_SIZE 64
+#define N_CONNS 50
+#define TIMEOUT_MS 2000
+
+static char tx_buf[TCP_WRITE];
+static char rx_buf[TCP_WRITE];
+
+static const char *peer_str(sa_family_t family)
+{
+#if defined(CONFIG_NET_IPV4)
+	if (family == AF_INET) {
+		return CONFIG_NET_CONFIG_PEER_IPV4_ADDR[0] ?
+			CONFIG_NET_CONFIG_PEER_IPV4_ADDR :
+			CONFIG_NET_CONFIG_MY_IPV4_ADDR;
+	}
+#endif
+#if defined(CONFIG_NET_IPV6)
+	if (family == AF_INET6) {
+		return CONFIG_NET_CONFIG_PEER_IPV6_ADDR[0] ?
+			CONFIG_NET_CONFIG_PEER_IPV6_ADDR :
+			CONFIG_NET_CONFIG_MY_IPV6_ADDR;
+	}
+#endif
+
+	return "";
+}
+
+static bool peer_is_local(void)
+{
+#if defined(CONFIG_NET_IPV4)
+	if (CONFIG_NET_CONFIG_PEER_IPV4_ADDR[0]) {
+		return false;
+	}
+#endif
+#if defined(CONFIG_NET_IPV6)
+	if (CONFIG_NET_CONFIG_PEER_IPV6_ADDR[0]) {
+		return false;
+	}
+#endif
+
+	return true;
+}
+
+static const char *family_str(sa_family_t family)
+{
+	return family == AF_INET ? "ipv4" : "ipv6";
+}
+
+static int open_client(sa_family_t family, int type)
+{
+	struct sockaddr_storage addr = { 0 };
+	socklen_t addrlen;
+	void *inaddr;
+	int fd;
+
+	if (family == AF_INET) {
+		net_sin((struct sockaddr *)&addr)->sin_family = AF_INET;
+		net_sin((struct sockaddr *)&addr)->sin_port = htons(BENCH_PORT);
+		inaddr = &net_sin((struct sockaddr *)&addr)->sin_addr;
+		addrlen = sizeof(struct sockaddr_in);
+	} else {
+		net_sin6((struct sockaddr *)&addr)->sin6_family = AF_INET6;
+		net_sin6((struct sockaddr *)&addr)->sin6_port = htons(BENCH_PORT);
+		inaddr = &net_sin6((struct sockaddr *)&addr)->sin6_addr;
+		addrlen = sizeof(struct sockaddr_in6);
+	}
+
+	if (net_addr_pton(family, peer_str(family), inaddr) < 0) {
+		printk("Invalid peer address %s\n", peer_str(family));
+		return -EINVAL;
+	}
+
+	fd = socket(family, type,
+		    type == SOCK_DGRAM ? IPPROTO_UDP : IPPROTO_TCP);
+	if (fd < 0) {
+		printk("Cannot create socket (%d)\n", errno);
+		return -errno;
+	}
+
+	if (connect(fd, (struct sockaddr *)&addr, addrlen) < 0) {
+		printk("Cannot connect to %s (%d)\n", peer_str(family), errno);
+		close(fd);
+		return -errno;
+	}
+
+	return fd;
+}
+
+static ssize_t recv_wait(int fd, void *buf, size_t len)
+{
+	struct pollfd pfd = {
+		.fd = fd,
+		.events = POLLIN,
+	};
+
+	if (poll(&pfd, 1, TIMEOUT_MS) <= 0) {
+		return -ETIMEDOUT;
+	}
+
+	return recv(fd, buf, len, 0);
+}
+
+#if defined(CONFIG_NET_PKT_TXTIME_STATS_DETAIL) && \
+	defined(CONFIG_NET_PKT_RXTIME_STATS_DETAIL)
+static struct net_stats stats_before;
+static struct net_stats stats_after;
+
+static const char * const tx_layers[] = { "l4", "ip", "queue", "l2" };
+static const char * const rx_layers[] = { "driver", "queue", "l2", "ip",
+					  "l4" };
+
+BUILD_ASSERT(ARRAY_SIZE(tx_layers) == NET_STATS_TX_DETAIL_COUNT + 1);
+BUILD_ASSERT(ARRAY_SIZE(rx_layers) == NET_STATS_RX_DETAIL_COUNT + 1);
+
+static void stats_get(struct net_stats *stats)
+{
+	if (net_mgmt(NET_REQUEST_STATS_GET_ALL, NULL, stats,
+		     sizeof(*stats)) < 0) {
+		memset(stats, 0, sizeof(*stats));
+	}
+}
+
+static uint32_t stats_avg(uint64_t sum, net_stats_t count)
+{
+	return count == 0 ? 0 : sum / count;
+}
+
+static void layers_start(void)
+{
+	stats_get(&stats_before);
+}
+
+/* Average cycles per packet in each layer since layers_start() */
+static void layers_print(const char *name, sa_family_t family)
+{
+	const struct net_stats_tx_time *tx0 = stats_before.tx_time_detail;
+	const struct net_stats_tx_time *tx1 = stats_after.tx_time_detail;
+	const struct net_stats_rx_time *rx0 = stats_before.rx_time_detail;
+	const struct net_stats_rx_time *rx1 = stats_after.rx_time_detail;
+	char layers[96];
+	int pos, i;
+
+	stats_get(&stats_after);
+
+	for (i = 0, pos = 0; i < ARRAY_SIZE(tx_layers); i++) {
+		pos += snprintk(&layers[pos], sizeof(layers) - pos, " %s=%u",
+				tx_layers[i],
+				stats_avg(tx1[i].sum - tx0[i].sum,
+					  tx1[i].count - tx0[i].count));
+	}
+
+	bench_result("layers", "bench=%s family=%s dir=tx%s", name,
+		     family_str(family), layers);
+
+	for (i = 0, pos = 0; i < ARRAY_SIZE(rx_layers); i++) {
+		pos += snprintk(&layers[pos], sizeof(layers) - pos, " %s=%u",
+				rx_layers[i],
+				stats_avg(rx1[i].sum - rx0[i].sum,
+					  rx1[i].count - rx0[i].count));
+	}
+
+	bench_result("layers", "bench=%s family=%s dir=rx%s", name,
+		     family_str(family), layers);
+}
+#else
+static void layers_start(void)
+{
+}
+
+static void layers_print(const char *name, sa_family_t family)
+{
+	ARG_UNUSED(name);
+	ARG_UNUSED(family);
+}
+#endif
+
+static int run_udp_pps(sa_family_t family)
+{
+	uint32_t start, cycles;
+	int sent, lost = 0;
+	int fd, i;
+
+	fd = open_client(family, SOCK_DGRAM);
+	if (fd < 0) {
+		return fd;
+	}
+
+	layers_start();
+	start = bench_start();
+
+	for (sent = 0; sent < UDP_PKTS; sent += UDP_BATCH) {
+		for (i = 0; i < UDP_BATCH; i++) {
+			if (send(fd, tx_buf, UDP_SIZE, 0) < 0) {
+				printk("Cannot send (%d)\n", errno);
+				close(fd);
+				return -errno;
+			}
+		}
+
+		for (i = 0; i < UDP_BATCH; i++) {
+			if (recv_wait(fd, rx_buf, sizeof(rx_buf)) != UDP_SIZE) {
+				lost += UDP_BATCH - i;
+				break;
+			}
+		}
+	}
+
+	cycles = bench_cycles(start);
+
+	close(fd);
+
+	bench_timed("udp_pps", sent, cycles, "family=%s size=%d lost=%d",
+		    family_str(family), UDP_SIZE, lost);
+
+	layers_print("udp_pps", family);
+
+	return 0;
+}
+
+static int run_tcp_bulk(sa_family_t family)
+{
+	size_t sent = 0, received = 0;
+	uint32_t start, cycles;
+	ssize_t ret;
+	int fd;
+
+	fd = open_client(family, SOCK_STREAM);
+	if (fd < 0) {
+		return fd;
+	}
+
+	layers_start();
+	start = bench_start();
+
+	while (sent < TCP_BYTES) {
+		if (sent - received >= TCP_IN_FLIGHT) {
+			ret = recv_wait(fd, rx_buf, sizeof(rx_buf));
+			if (ret <= 0) {
+				break;
+			}
+
+			received += ret;
+			continue;
+		}
+
+		ret = send(fd, tx_buf, MIN(TCP_WRITE, TCP_BYTES - sent), 0);
+		if (ret < 0) {
+			printk("Cannot send (%d)\n", errno);
+			close(fd);
+			return -errno;
+		}
+
+		sent += ret;
+	}
+
+	while (received < TCP_BYTES) {
+		ret = recv_wait(fd, rx_buf, sizeof(rx_buf));
+		if (ret <= 0) {
+			break;
+		}
+
+		received += ret;
+	}
+
+	cycles = bench_cycles(start);
+
+	close(fd);
+
+	bench_timed("tcp_bulk", TCP_BYTES / 1024, cycles,
+		    "family=%s bytes=%zu received=%zu kbps=%u",
+		    family_str(family), sent, received,
+		    bench_rate(8ULL * TCP_BYTES / 1000, cycles));
+
+	layers_print("tcp_bulk", family);
+
+	return 0;
+}
+
+static int run_rtt(sa_family_t family, int type)
+{
+	const char *name = type == SOCK_DGRAM ? "udp_rtt" : "tcp_rtt";
+	uint32_t start, cycles, min = UINT32_MAX, max = 0, total = 0;
+	size_t received;
+	ssize_t ret;
+	int fd, i;
+
+	fd = open_client(family, type);
+	if (fd < 0) {
+		return fd;
+	}
+
+	layers_start();
+
+	for (i = 0; i < RTT_ROUNDS; i++) {
+		start = bench_start();
+
+		if (send(fd, tx_buf, RTT_SIZE, 0) < 0) {
+			printk("Cannot send (%d)\n", errno);
+			close(fd);
+			return -errno;
+		}
+
+		for (received = 0; received < RTT_SIZE; received += ret) {
+			ret = recv_wait(fd, rx_buf, sizeof(rx_buf));
+			if (ret <= 0) {
+				printk("No echo for round %d (%d)\n", i,
+				       (int)ret);
+				close(fd);
+				return -ETIMEDOUT;
+			}
+		}
+
+		cycles = bench_cycles(start);
+
+		min = MIN(min, cycles);
+		max = MAX(max, cycles);
+		total += cycles;
+	}
+
+	close(fd);
+
+	bench_timed(name, RTT_ROUNDS, total,
+		    "family=%s size=%d min=%u max=%u", family_str(family),
+		    RTT_SIZE, min, max);
+
+	layers_print(name, family);
+
+	return 0;
+}
+
+static int run_tcp_conn(sa_family_t family)
+{
+	uint32_t start, cycles;
+	int fd, i;
+
+	layers_start();
+	start = bench_start();
+
+	/* Each connection carries one byte, so that the server has
+	 * accepted it before it is closed.
+	 */
+	for (i = 0; i < N_CONNS; i++) {
+		fd = open_client(family, SOCK_STREAM);
+		if (fd < 0) {
+			return fd;
+		}
+
+		if (send(fd, tx_buf, 1, 0) < 0 ||
+		    recv_wait(fd, rx_buf, sizeof(rx_buf)) != 1) {
+			printk("No echo for connection %d\n", i);
+			close(fd);
+			return -ETIMEDOUT;
+		}
+
+		close(fd);
+	}
+
+	cycles = bench_cycles(start);
+
+	bench_timed("tcp_conn", N_CONNS, cycles, "family=%s",
+		    family_str(family));
+
+	layers_print("tcp_conn", family);
+
+	return 0;
+}
+
+static int run(sa_family_t family)
+{
+	int ret;
+
+	ret = run_udp_pps(family);
+	if (ret < 0) {
+		return ret;
+	}
+
+	ret = run_tcp_bulk(family);
+	if (ret < 0) {
+		return ret;
+	}
+
+	ret = run_rtt(family, SOCK_DGRAM);
+	if (ret < 0) {
+		return ret;
+	}
+
+	ret = run_rtt(family, SOCK_STREAM);
+	if (ret < 0) {
+		return ret;
+	}
+
+	return run_tcp_conn(family);
+}
+
+void main(void)
+{
+	int i;
+
+	for (i = 0; i < sizeof(tx_buf); i++) {
+		tx_buf[i] = 'a' + i % 26;
+	}
+
+	if (peer_is_local() && bench_echo_start() < 0) {
+		printk("Cannot start echo server\n");
+		return;
+	}
+
+	if (IS_ENABLED(CONFIG_NET_IPV4) && run(AF_INET) < 0) {
+		return;
+	}
+
+	if (IS_ENABLED(CONFIG_NET_IPV6) && run(AF_INET6) < 0) {
+		return;
+	}
+
+	bench_fin();
+}
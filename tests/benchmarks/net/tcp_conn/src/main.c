@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+#include <net/socket.h>
+
+#include "../../common/bench_common.h"
+
+/* Open N_CONNS loopback TCP connections and keep them all open, then
+ * exchange one byte on each. Every segment is matched against all the
+ * connections, so the cost of the connection lookup shows up in both
+ * phases.
+ */
+
+#define N_CONNS 500
+#define SERVER_PORT 4242
+
+static int clients[N_CONNS];
+static int servers[N_CONNS];
+
+static int open_conns(int listener, struct sockaddr_in *addr)
+{
+	int i;
+
+	for (i = 0; i < N_CONNS; i++) {
+		clients[i] = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+		if (clients[i] < 0) {
+			printk("Cannot create client %d (%d)\n", i, errno);
+			return -1;
+		}
+
+		if (connect(clients[i], (struct sockaddr *)addr,
+			    sizeof(*addr)) < 0) {
+			printk("Cannot connect client %d (%d)\n", i, errno);
+			return -1;
+		}
+
+		servers[i] = accept(listener, NULL, NULL);
+		if (servers[i] < 0) {
+			printk("Cannot accept client %d (%d)\n", i, errno);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static int ping_conns(void)
+{
+	char c = 'x';
+	int i;
+
+	for (i = 0; i < N_CONNS; i++) {
+		if (send(clients[i], &c, 1, 0) != 1) {
+			printk("Cannot send on client %d (%d)\n", i, errno);
+			return -1;
+		}
+
+		if (recv(servers[i], &c, 1, 0) != 1) {
+			printk("Cannot recv on server %d (%d)\n", i, errno);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+void main(void)
+{
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_port = htons(SERVER_PORT),
+		.sin_addr = { { { 127, 0, 0, 1 } } },
+	};
+	uint32_t start, cycles;
+	int listener;
+
+	listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (listener < 0 ||
+	    bind(listener, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+	    listen(listener, N_CONNS) < 0) {
+		printk("Cannot set up the listener (%d)\n", errno);
+		return;
+	}
+
+	start = bench_start();
+
+	if (open_conns(listener, &addr) < 0) {
+		return;
+	}
+
+	cycles = bench_cycles(start);
+
+	bench_timed("tcp_conn", N_CONNS, cycles, "op=connect");
+
+	start = bench_start();
+
+	if (ping_conns() < 0) {
+		return;
+	}
+
+	cycles = bench_cycles(start);
+
+	bench_timed("tcp_conn", N_CONNS, cycles, "op=send");
+
+	bench_fin();
+}
@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+#include <net/socket.h>
+#include <net/tls_credentials.h>
+
+#include "../../common/bench_common.h"
+
+/* Connect N_CONNS times to a loopback TLS server, first with full
+ * handshakes and then resuming the session of the first connection. Then
+ * send N_WRITES small writes on one connection, first as one record
+ * each and then coalesced.
+ */
+
+#define N_CONNS 10
+#define N_WRITES 200
+#define WRITE_SIZE 16
+#define SERVER_PORT 4243
+#define SERVER_TAG 1
+#define CA_TAG 2
+#define STACK_SIZE 4096
+
+static const unsigned char server_certificate[] = {
+#include "echo-apps-cert.der.inc"
+};
+
+static const unsigned char private_key[] = {
+#include "echo-apps-key.der.inc"
+};
+
+static const struct sockaddr_in addr = {
+	.sin_family = AF_INET,
+	.sin_port = htons(SERVER_PORT),
+	.sin_addr = { { { 127, 0, 0, 1 } } },
+};
+
+/* Bytes the server reads before acknowledging them with one byte */
+static int expected;
+
+static K_SEM_DEFINE(server_ready, 0, 1);
+
+static void server(void)
+{
+	static const sec_tag_t tags[] = { SERVER_TAG };
+	int enable = TLS_SESSION_CACHE_ENABLED;
+	char buf[64];
+	int listener;
+	int received;
+	int sock;
+	int ret;
+
+	listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TLS_1_2);
+	if (listener < 0 ||
+	    setsockopt(listener, SOL_TLS, TLS_SEC_TAG_LIST, tags,
+		       sizeof(tags)) < 0 ||
+	    setsockopt(listener, SOL_TLS, TLS_SESSION_CACHE, &enable,
+		       sizeof(enable)) < 0 ||
+	    bind(listener, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+	    listen(listener, 1) < 0) {
+		printk("Cannot set up the listener (%d)\n", errno);
+		return;
+	}
+
+	k_sem_give(&server_ready);
+
+	while (true) {
+		sock = accept(listener, NULL, NULL);
+		if (sock < 0) {
+			printk("Cannot accept (%d)\n", errno);
+			continue;
+		}
+
+		received = 0;
+
+		while ((ret = recv(sock, buf, sizeof(buf), 0)) > 0) {
+			received += ret;
+
+			if (received == expected) {
+				(void)send(sock, "k", 1, 0);
+			}
+		}
+
+		close(sock);
+	}
+}
+
+K_THREAD_DEFINE(server_id, STACK_SIZE, server, NULL, NULL, NULL,
+		K_PRIO_PREEMPT(8), 0, 0);
+
+static int client_connect(bool resume)
+{
+	static const sec_tag_t tags[] = { CA_TAG };
+	int cache = resume ? TLS_SESSION_CACHE_ENABLED :
+			     TLS_SESSION_CACHE_DISABLED;
+	int sock;
+
+	sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TLS_1_2);
+	if (sock < 0 ||
+	    setsockopt(sock, SOL_TLS, TLS_SEC_TAG_LIST, tags,
+		       sizeof(tags)) < 0 ||
+	    setsockopt(sock, SOL_TLS, TLS_HOSTNAME, "localhost",
+		       sizeof("localhost")) < 0 ||
+	    setsockopt(sock, SOL_TLS, TLS_SESSION_CACHE, &cache,
+		       sizeof(cache)) < 0 ||
+	    connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		printk("Cannot connect (%d)\n", errno);
+		if (sock >= 0) {
+			close(sock);
+		}
+
+		return -1;
+	}
+
+	return sock;
+}
+
+static int open_conns(bool resume)
+{
+	int sock;
+	int i;
+
+	for (i = 0; i < N_CONNS; i++) {
+		sock = client_connect(resume);
+		if (sock < 0) {
+			return -1;
+		}
+
+		close(sock);
+	}
+
+	return 0;
+}
+
+/* Measure the cycles spent sending until the server acks all the data */
+static int send_writes(int coalesce, uint32_t *cycles)
+{
+	char buf[WRITE_SIZE] = { 0 };
+	uint32_t start;
+	char ack;
+	int sock;
+	int i;
+
+	expected = N_WRITES * WRITE_SIZE;
+
+	sock = client_connect(false);
+	if (sock < 0) {
+		return -1;
+	}
+
+	if (setsockopt(sock, SOL_TLS, TLS_TX_COALESCE, &coalesce,
+		       sizeof(coalesce)) < 0) {
+		printk("Cannot set coalescing (%d)\n", errno);
+		goto fail;
+	}
+
+	start = bench_start();
+
+	for (i = 0; i < N_WRITES; i++) {
+		if (send(sock, buf, sizeof(buf), 0) != sizeof(buf)) {
+			printk("Cannot send write %d (%d)\n", i, errno);
+			goto fail;
+		}
+	}
+
+	/* Reading flushes the coalesced writes */
+	if (recv(sock, &ack, 1, 0) != 1) {
+		printk("No ack (%d)\n", errno);
+		goto fail;
+	}
+
+	*cycles = bench_cycles(start);
+
+	close(sock);
+
+	return 0;
+
+fail:
+	close(sock);
+
+	return -1;
+}
+
+void main(void)
+{
+	uint32_t start, cycles;
+	int sock;
+
+	if (tls_credential_add(SERVER_TAG, TLS_CREDENTIAL_SERVER_CERTIFICATE,
+			       server_certificate,
+			       sizeof(server_certificate)) < 0 ||
+	    tls_credential_add(SERVER_TAG, TLS_CREDENTIAL_PRIVATE_KEY,
+			       private_key, sizeof(private_key)) < 0 ||
+	    tls_credential_add(CA_TAG, TLS_CREDENTIAL_CA_CERTIFICATE,
+			       server_certificate,
+			       sizeof(server_certificate)) < 0) {
+		printk("Cannot add the credentials\n");
+		return;
+	}
+
+	k_sem_take(&server_ready, K_FOREVER);
+
+	start = bench_start();
+
+	if (open_conns(false) < 0) {
+		return;
+	}
+
+	cycles = bench_cycles(start);
+
+	bench_timed("tls_connect", N_CONNS, cycles, "session=full");
+
+	/* Get a session to resume */
+	sock = client_connect(true);
+	if (sock < 0) {
+		return;
+	}
+
+	close(sock);
+
+	start = bench_start();
+
+	if (open_conns(true) < 0) {
+		return;
+	}
+
+	cycles = bench_cycles(start);
+
+	bench_timed("tls_connect", N_CONNS, cycles, "session=resumed");
+
+	if (send_writes(0, &cycles) < 0) {
+		return;
+	}
+
+	bench_timed("tls_send", N_WRITES, cycles, "coalesce=0");
+
+	if (send_writes(1, &cycles) < 0) {
+		return;
+	}
+
+	bench_timed("tls_send", N_WRITES, cycles, "coalesce=1");
+
+	bench_fin();
+}
@@ -0,0 +1,344 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr.h>
+#include <sys/printk.h>
+#include <sys/base64.h>
+#include <net/socket.h>
+#include <net/websocket.h>
+#include <mbedtls/sha1.h>
+
+#include "../../common/bench_common.h"
+
+/* Send N_MSGS text messages of PAYLOAD_SIZE bytes to an echo server
+ * stand-in on the loopback interface and receive them back, first with
+ * websocket_send_msg() and then with websocket_send_msg_in_place(). The
+ * server only unmasks the frames and sends them back, so the time is spent
+ * in the client and the stack.
+ */
+
+#define N_MSGS 500
+#define PAYLOAD_SIZE 512
+#define SERVER_PORT 8080
+#define SERVER_STACK_SIZE 2048
+#define SERVER_BUF_SIZE (PAYLOAD_SIZE + 16)
+
+#define WS_MAGIC "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+#define WS_KEY_FIELD "Sec-WebSocket-Key: "
+
+static uint8_t tmp_buf[1024];
+static uint8_t template[PAYLOAD_SIZE];
+static uint8_t payload[PAYLOAD_SIZE];
+static uint8_t recv_buf[PAYLOAD_SIZE];
+static uint8_t server_buf[SERVER_BUF_SIZE];
+
+static struct sockaddr_in server_addr = {
+	.sin_family = AF_INET,
+	.sin_port = htons(SERVER_PORT),
+	.sin_addr = { { { 127, 0, 0, 1 } } },
+};
+
+static int server_listener;
+static atomic_t server_received;
+static K_THREAD_STACK_DEFINE(server_stack, SERVER_STACK_SIZE);
+static struct k_thread server_thread;
+
+static int recv_all(int sock, uint8_t *buf, size_t len)
+{
+	while (len > 0) {
+		ssize_t ret = recv(sock, buf, len, 0);
+
+		if (ret <= 0) {
+			return -1;
+		}
+
+		buf += ret;
+		len -= ret;
+	}
+
+	return 0;
+}
+
+/* Read the upgrade request and answer it */
+static int server_handshake(int sock)
+{
+	uint8_t key[sizeof(WS_KEY_FIELD) + 24 + sizeof(WS_MAGIC)];
+	uint8_t sha1[20];
+	char accept[29];
+	char *start, *end;
+	size_t len = 0;
+	size_t olen;
+	bool deflate;
+	int ret;
+
+	do {
+		ret = recv(sock, server_buf + len, sizeof(server_buf) - len - 1,
+			   0);
+		if (ret <= 0) {
+			return -1;
+		}
+
+		len += ret;
+		server_buf[len] = '\0';
+	} while (!strstr(server_buf, "\r\n\r\n"));
+
+	start = strstr(server_buf, WS_KEY_FIELD);
+	if (!start) {
+		return -1;
+	}
+
+	start += sizeof(WS_KEY_FIELD) - 1;
+	end = strstr(start, "\r\n");
+	if (end - start > 24) {
+		return -1;
+	}
+
+	len = end - start;
+	memcpy(key, start, len);
+	memcpy(key + len, WS_MAGIC, sizeof(WS_MAGIC) - 1);
+	mbedtls_sha1_ret(key, len + sizeof(WS_MAGIC) - 1, sha1);
+
+	if (base64_encode(accept, sizeof(accept), &olen, sha1,
+			  sizeof(sha1)) < 0) {
+		return -1;
+	}
+
+	deflate = strstr(server_buf, "permessage-deflate") != NULL;
+
+	len = snprintk(server_buf, sizeof(server_buf),
+		       "HTTP/1.1 101 Switching Protocols\r\n"
+		       "Upgrade: websocket\r\n"
+		       "Connection: Upgrade\r\n"
+		       "Sec-WebSocket-Accept: %s\r\n"
+		       "%s\r\n", accept,
+		       deflate ? "Sec-WebSocket-Extensions: permessage-deflate; "
+				 "client_no_context_takeover; "
+				 "server_no_context_takeover\r\n" : "");
+
+	return send(sock, server_buf, len, 0) == len ? 0 : -1;
+}
+
+static void server(void *p1, void *p2, void *p3)
+{
+	uint8_t mask[4];
+	size_t hdr_len;
+	size_t len;
+	size_t i;
+	int sock;
+
+	sock = accept(server_listener, NULL, NULL);
+	if (sock < 0) {
+		printk("Server cannot accept (%d)\n", errno);
+		return;
+	}
+
+	if (server_handshake(sock) < 0) {
+		printk("Server handshake failed\n");
+		goto out;
+	}
+
+	while (recv_all(sock, server_buf, 2) == 0) {
+		len = server_buf[1] & 0x7F;
+		hdr_len = 2;
+
+		if (len == 126) {
+			if (recv_all(sock, &server_buf[2], 2) < 0) {
+				break;
+			}
+
+			len = (server_buf[2] << 8) | server_buf[3];
+			hdr_len = 4;
+		} else if (len == 127 || len > sizeof(server_buf) - 4) {
+			break;
+		}
+
+		if (server_buf[1] & 0x80) {
+			if (recv_all(sock, mask, sizeof(mask)) < 0) {
+				break;
+			}
+		} else {
+			memset(mask, 0, sizeof(mask));
+		}
+
+		if (recv_all(sock, &server_buf[hdr_len], len) < 0) {
+			break;
+		}
+
+		for (i = 0; i < len; i++) {
+			server_buf[hdr_len + i] ^= mask[i % 4];
+		}
+
+		atomic_add(&server_received, len);
+
+		if ((server_buf[0] & 0x0F) == WEBSOCKET_OPCODE_CLOSE) {
+			break;
+		}
+
+		/* Echo with the same FIN, RSV1 and opcode, unmasked */
+		server_buf[1] &= 0x7F;
+
+		if (send(sock, server_buf, hdr_len + len, 0) < 0) {
+			break;
+		}
+	}
+
+out:
+	close(sock);
+}
+
+static int echo(int ws_sock, uint8_t *buf, bool in_place)
+{
+	uint64_t remaining = 1;
+	size_t total = 0;
+	int ret;
+
+	if (in_place) {
+		ret = websocket_send_msg_in_place(ws_sock, buf, PAYLOAD_SIZE,
+						  WEBSOCKET_OPCODE_DATA_TEXT,
+						  true, true, SYS_FOREVER_MS);
+	} else {
+		ret = websocket_send_msg(ws_sock, buf, PAYLOAD_SIZE,
+					 WEBSOCKET_OPCODE_DATA_TEXT,
+					 true, true, SYS_FOREVER_MS);
+	}
+
+	if (ret < 0) {
+		printk("Cannot send message (%d)\n", ret);
+		return ret;
+	}
+
+	while (remaining > 0) {
+		ret = websocket_recv_msg(ws_sock, recv_buf + total,
+					 sizeof(recv_buf) - total, NULL,
+					 &remaining, SYS_FOREVER_MS);
+		if (ret == -EAGAIN) {
+			continue;
+		}
+
+		if (ret <= 0) {
+			printk("Cannot receive message (%d)\n", ret);
+			return -1;
+		}
+
+		total += ret;
+	}
+
+	return total == PAYLOAD_SIZE ? 0 : -1;
+}
+
+static int echo_all(int ws_sock, bool in_place)
+{
+	int i;
+
+	atomic_set(&server_received, 0);
+
+	for (i = 0; i < N_MSGS; i++) {
+		/* The application builds every message in its buffer */
+		memcpy(payload, template, sizeof(payload));
+
+		if (echo(ws_sock, payload, in_place) < 0) {
+			return -1;
+		}
+	}
+
+	if (memcmp(recv_buf, template, sizeof(recv_buf)) != 0) {
+		printk("Invalid echoed message\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Fill the template with dashboard like JSON records */
+static void make_template(void)
+{
+	size_t len = 0;
+	int i = 0;
+
+	while (len < sizeof(template)) {
+		char record[64];
+		int ret;
+
+		ret = snprintk(record, sizeof(record),
+			       "{\"sensor\":\"temp-%02d\",\"value\":%d.%d,"
+			       "\"unit\":\"C\"},", i, 20 + i % 7, i % 10);
+
+		memcpy(template + len, record,
+		       MIN(ret, sizeof(template) - len));
+		len += ret;
+		i++;
+	}
+}
+
+void main(void)
+{
+	struct websocket_request req = {
+		.host = "127.0.0.1",
+		.url = "/",
+		.tmp_buf = tmp_buf,
+		.tmp_buf_len = sizeof(tmp_buf),
+	};
+	uint32_t start, cycles;
+	int ws_sock;
+	int sock;
+
+	make_template();
+
+	server_listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (server_listener < 0 ||
+	    bind(server_listener, (struct sockaddr *)&server_addr,
+		 sizeof(server_addr)) < 0 ||
+	    listen(server_listener, 1) < 0) {
+		printk("Cannot set up the server (%d)\n", errno);
+		return;
+	}
+
+	k_thread_create(&server_thread, server_stack,
+			K_THREAD_STACK_SIZEOF(server_stack), server,
+			NULL, NULL, NULL, K_PRIO_PREEMPT(8), 0, K_NO_WAIT);
+
+	sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (sock < 0 ||
+	    connect(sock, (struct sockaddr *)&server_addr,
+		    sizeof(server_addr)) < 0) {
+		printk("Cannot connect to the server (%d)\n", errno);
+		return;
+	}
+
+	ws_sock = websocket_connect(sock, &req, 5 * MSEC_PER_SEC, NULL);
+	if (ws_sock < 0) {
+		printk("Cannot upgrade the connection (%d)\n", ws_sock);
+		return;
+	}
+
+	start = bench_start();
+
+	if (echo_all(ws_sock, false) < 0) {
+		return;
+	}
+
+	cycles = bench_cycles(start);
+
+	bench_timed("websocket_echo", N_MSGS, cycles,
+		    "send=copy bytes=%d wire=%u", PAYLOAD_SIZE,
+		    (uint32_t)atomic_get(&server_received));
+
+	start = bench_start();
+
+	if (echo_all(ws_sock, true) < 0) {
+		return;
+	}
+
+	cycles = bench_cycles(start);
+
+	bench_timed("websocket_echo", N_MSGS, cycles,
+		    "send=in_place bytes=%d wire=%u", PAYLOAD_SIZE,
+		    (uint32_t)atomic_get(&server_received));
+
+	websocket_disconnect(ws_sock);
+
+	bench_fin();
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* IPv6 packets as captured on an 802.15.4 mesh, before compression. The
+ * addresses match the link layer addresses and the 6CO contexts used by
+ * the tests, so that every IPHC address mode shows up.
+ */
+
+#ifndef __6LO_CORPUS_H
+#define __6LO_CORPUS_H
+
+#include <zephyr/types.h>
+
+/* MLE advertisement between link local addresses, 80 bytes */
+static const uint8_t mle_advertisement[] = {
+	0x60, 0x00, 0x00, 0x00, 0x00, 0x28, 0x11, 0xff,
+	0xfe, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xaa, 0xbb,
+	0xff, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+	0x4d, 0x4c, 0x4d, 0x4c, 0x00, 0x28, 0x9b, 0x18,
+	0xff, 0x00, 0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc,
+	0x00, 0x0b, 0x02, 0x00, 0x00, 0x01, 0x04, 0x04,
+	0x00, 0x00, 0x00, 0x10, 0x00, 0x05, 0x01, 0x02,
+	0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a,
+};
+
+/* CoAP confirmable POST using the mesh local context, 83 bytes */
+static const uint8_t coap_mesh_local[] = {
+	0x60, 0x00, 0x00, 0x00, 0x00, 0x2b, 0x11, 0x40,
+	0xaa, 0xbb, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0xff, 0xfe, 0x00, 0x00, 0xbb,
+	0xaa, 0xbb, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xaa,
+	0x16, 0x33, 0x16, 0x33, 0x00, 0x2b, 0xd3, 0x71,
+	0x44, 0x02, 0x12, 0x34, 0xde, 0xad, 0xbe, 0xef,
+	0xb1, 0x61, 0x01, 0x62, 0xff, 0x7b, 0x22, 0x74,
+	0x65, 0x6d, 0x70, 0x22, 0x3a, 0x32, 0x31, 0x2e,
+	0x35, 0x2c, 0x22, 0x68, 0x75, 0x6d, 0x22, 0x3a,
+	0x34, 0x30, 0x7d,
+};
+
+/* UDP over 4 bit ports between global addresses, 96 bytes */
+static const uint8_t udp_4bit_ports_global[] = {
+	0x6b, 0x81, 0x23, 0x45, 0x00, 0x38, 0x11, 0x3f,
+	0x20, 0x01, 0x0d, 0xb8, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+	0x20, 0x01, 0x0d, 0xb8, 0x00, 0x01, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02,
+	0xf0, 0xb1, 0xf0, 0xb2, 0x00, 0x38, 0x98, 0x61,
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+	0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+	0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+	0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f,
+	0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27,
+	0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f,
+};
+
+/* ICMPv6 echo request to a multicast group, 104 bytes */
+static const uint8_t echo_request_mcast[] = {
+	0x60, 0x00, 0x00, 0x00, 0x00, 0x40, 0x3a, 0x01,
+	0xfe, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0xff, 0xfe, 0x00, 0x00, 0xbb,
+	0xff, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x03,
+	0x80, 0x00, 0x78, 0xf7, 0x12, 0x34, 0x00, 0x01,
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+	0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+	0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+	0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f,
+	0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27,
+	0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f,
+	0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37,
+};
+
+/* Router solicitation from the unspecified address, 48 bytes */
+static const uint8_t router_solicitation[] = {
+	0x60, 0x00, 0x00, 0x00, 0x00, 0x08, 0x3a, 0xff,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0xff, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02,
+	0x85, 0x00, 0x7b, 0xb8, 0x00, 0x00, 0x00, 0x00,
+};
+
+/* UDP datagram to a context 2 address over 8 bit ports, 128 bytes */
+static const uint8_t udp_context_8bit_port[] = {
+	0x60, 0x20, 0x00, 0x00, 0x00, 0x58, 0x11, 0x40,
+	0xaa, 0xbb, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xaa,
+	0xcc, 0xdd, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0xff, 0xfe, 0x00, 0x00, 0xbb,
+	0xf0, 0x11, 0xf1, 0x22, 0x00, 0x58, 0xeb, 0x38,
+	0x00, 0x07, 0x0e, 0x15, 0x1c, 0x23, 0x2a, 0x31,
+	0x38, 0x3f, 0x46, 0x4d, 0x54, 0x5b, 0x62, 0x69,
+	0x70, 0x77, 0x7e, 0x85, 0x8c, 0x93, 0x9a, 0xa1,
+	0xa8, 0xaf, 0xb6, 0xbd, 0xc4, 0xcb, 0xd2, 0xd9,
+	0xe0, 0xe7, 0xee, 0xf5, 0xfc, 0x03, 0x0a, 0x11,
+	0x18, 0x1f, 0x26, 0x2d, 0x34, 0x3b, 0x42, 0x49,
+	0x50, 0x57, 0x5e, 0x65, 0x6c, 0x73, 0x7a, 0x81,
+	0x88, 0x8f, 0x96, 0x9d, 0xa4, 0xab, 0xb2, 0xb9,
+	0xc0, 0xc7, 0xce, 0xd5, 0xdc, 0xe3, 0xea, 0xf1,
+	0xf8, 0xff, 0x06, 0x0d, 0x14, 0x1b, 0x22, 0x29,
+};
+
+#define CORPUS_PKT(_name) { #_name, _name, sizeof(_name) }
+
+static const struct {
+	const char *name;
+	const uint8_t *data;
+	size_t len;
+} corpus[] = {
+	CORPUS_PKT(mle_advertisement),
+	CORPUS_PKT(coap_mesh_local),
+	CORPUS_PKT(udp_4bit_ports_global),
+	CORPUS_PKT(echo_request_mcast),
+	CORPUS_PKT(router_solicitation),
+	CORPUS_PKT(udp_context_8bit_port),
+};
+
+#endif /* __6LO_CORPUS_H */
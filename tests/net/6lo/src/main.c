@@ -29,6 +29,7 @@ LOG_MODULE_REGISTER(net_test, CONFIG_NET_6LO_LOG_LEVEL);
 
 #include "6lo.h"
 #include "icmpv6.h"
+#include "corpus.h"
 
 #define NET_LOG_ENABLED 1
 #include "net_private.h"
@@ -1160,9 +1161,105 @@ void test_loop(void)
 	net_pkt_print();
 }
 
+static struct net_pkt *create_corpus_pkt(const uint8_t *data, size_t len,
+				       size_t tailroom)
+{
+	struct net_pkt *pkt;
+
+	pkt = net_pkt_alloc_with_buffer(net_if_get_default(), len + tailroom,
+					AF_UNSPEC, 0, K_FOREVER);
+	if (!pkt) {
+		return NULL;
+	}
+
+	if (net_pkt_write(pkt, data, len)) {
+		net_pkt_unref(pkt);
+		return NULL;
+	}
+
+	net_pkt_lladdr_src(pkt)->addr = src_mac;
+	net_pkt_lladdr_src(pkt)->len = 8U;
+
+	net_pkt_lladdr_dst(pkt)->addr = dst_mac;
+	net_pkt_lladdr_dst(pkt)->len = 8U;
+
+	net_pkt_cursor_init(pkt);
+
+	return pkt;
+}
+
+/* Compress and uncompress every packet of the corpus, the result must be
+ * identical to the original. Without tailroom the headers are put in a
+ * buffer of their own and the payload is not moved, with enough
+ * tailroom they are uncompressed in place.
+ */
+static void test_6lo_corpus_tailroom(size_t tailroom)
+{
+	static uint8_t buf[128];
+	struct net_buf *payload;
+	struct net_pkt *pkt;
+	uint8_t *tail;
+	int count;
+
+	for (count = 0; count < ARRAY_SIZE(corpus); count++) {
+		/* The tailroom must be in the buffer holding the packet */
+		if (corpus[count].len + tailroom > CONFIG_NET_BUF_DATA_SIZE) {
+			continue;
+		}
+
+		TC_PRINT("%s tailroom %zu\n", corpus[count].name, tailroom);
+
+		pkt = create_corpus_pkt(corpus[count].data, corpus[count].len,
+					tailroom);
+		zassert_not_null(pkt, "failed to create packet");
+
+		zassert_true(net_6lo_compress(pkt, true) > 0,
+			     "compression failed");
+		zassert_true(net_pkt_get_len(pkt) < corpus[count].len,
+			     "packet was not compressed");
+
+		payload = pkt->buffer;
+		tail = net_buf_tail(payload);
+
+		zassert_true(net_6lo_uncompress(pkt), "uncompression failed");
+
+		if (tailroom) {
+			zassert_equal_ptr(pkt->buffer, payload,
+					  "headers not uncompressed in place");
+			zassert_is_null(payload->frags, "buffer was added");
+		} else {
+			zassert_equal_ptr(pkt->buffer->frags, payload,
+					  "headers not in a buffer of their own");
+			zassert_equal_ptr(net_buf_tail(payload), tail,
+					  "payload was moved");
+		}
+
+		zassert_equal(net_pkt_get_len(pkt), corpus[count].len,
+			      "length mismatch");
+		zassert_equal(net_pkt_read(pkt, buf, corpus[count].len), 0,
+			      "read failed");
+		zassert_mem_equal(buf, corpus[count].data, corpus[count].len,
+				  "packet mismatch");
+
+		net_pkt_unref(pkt);
+	}
+}
+
+void test_6lo_corpus(void)
+{
+	test_6lo_corpus_tailroom(0);
+}
+
+void test_6lo_corpus_in_place(void)
+{
+	test_6lo_corpus_tailroom(NET_IPV6H_LEN);
+}
+
 /*test case main entry*/
 void test_main(void)
 {
-	ztest_test_suite(test_6lo, ztest_unit_test(test_loop));
+	ztest_test_suite(test_6lo, ztest_unit_test(test_loop),
+			 ztest_unit_test(test_6lo_corpus),
+			 ztest_unit_test(test_6lo_corpus_in_place));
 	ztest_run_test_suite(test_6lo);
 }
@@ -641,9 +641,96 @@ void test_arp(void)
 	}
 }
 
+static struct net_pkt *prepare_ipv4(struct net_if *iface,
+				    struct in_addr *src,
+				    struct in_addr *dst)
+{
+	struct net_ipv4_hdr *ipv4;
+	struct net_pkt *pkt;
+	int len = strlen(app_data);
+
+	pkt = net_pkt_alloc_with_buffer(iface, sizeof(struct net_ipv4_hdr) +
+					len, AF_INET, 0, K_SECONDS(1));
+	zassert_not_null(pkt, "out of mem");
+
+	ipv4 = (struct net_ipv4_hdr *)net_buf_add(pkt->buffer,
+						  sizeof(struct net_ipv4_hdr));
+	net_ipaddr_copy(&ipv4->src, src);
+	net_ipaddr_copy(&ipv4->dst, dst);
+
+	memcpy(net_buf_add(pkt->buffer, len), app_data, len);
+
+	return pkt;
+}
+
+void test_arp_pending_queue(void)
+{
+	struct net_pkt *pkts[CONFIG_NET_NBR_PENDING_QUEUE_SIZE + 1];
+	struct in_addr dst = { { { 192, 168, 0, 3 } } };
+	struct in_addr src = { { { 192, 168, 0, 1 } } };
+	struct net_eth_hdr *eth_hdr = NULL;
+	struct net_pkt *req = NULL;
+	struct net_pkt *pkt;
+	struct net_if *iface;
+	int i;
+
+	iface = net_if_get_default();
+
+	net_arp_clear_cache(iface);
+
+	for (i = 0; i < ARRAY_SIZE(pkts); i++) {
+		pkts[i] = prepare_ipv4(iface, &src, &dst);
+
+		pkt = net_arp_prepare(pkts[i], &dst, NULL);
+		zassert_not_null(pkt, "ARP request not sent");
+		zassert_not_equal(pkt, pkts[i], "Address already resolved");
+
+		if (req) {
+			net_pkt_unref(pkt);
+		} else {
+			req = pkt;
+		}
+	}
+
+	/**TESTPOINT: Check that the packets are queued until the queue
+	 * is full.
+	 */
+	for (i = 0; i < ARRAY_SIZE(pkts); i++) {
+		zassert_equal(atomic_get(&pkts[i]->atomic_ref),
+			      i < CONFIG_NET_NBR_PENDING_QUEUE_SIZE ? 2 : 1,
+			      "Wrong reference count for packet %d", i);
+	}
+
+	pkt = prepare_arp_reply(iface, req, &hwaddr, &eth_hdr);
+	net_pkt_unref(req);
+
+	req_test = true;
+	send_status = -EINVAL;
+
+	zassert_not_equal(net_arp_input(pkt, eth_hdr), NET_DROP,
+			  "ARP reply dropped");
+
+	k_sleep(K_MSEC(10));
+
+	/**TESTPOINT: Check that the queued packets are sent */
+	zassert_false(send_status < 0, "Pending packets were not sent");
+
+	for (i = 0; i < ARRAY_SIZE(pkts); i++) {
+		zassert_equal(atomic_get(&pkts[i]->atomic_ref), 1,
+			      "ARP cache still owns packet %d", i);
+		net_pkt_unref(pkts[i]);
+	}
+
+	entry_found = false;
+	expected_hwaddr = &hwaddr;
+	net_arp_foreach(arp_cb, &dst);
+	zassert_true(entry_found, "Entry not found");
+}
+
 void test_main(void)
 {
 	ztest_test_suite(test_arp_fn,
-		ztest_unit_test(test_arp));
+		ztest_unit_test(test_arp),
+		ztest_unit_test(test_arp_pending_queue));
 	ztest_run_test_suite(test_arp_fn);
 }
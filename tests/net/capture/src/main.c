@@ -0,0 +1,297 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, CONFIG_NET_CAPTURE_LOG_LEVEL);
+
+#include <ztest_assert.h>
+
+#include <net/net_if.h>
+#include <net/net_pkt.h>
+#include <net/socket.h>
+#include <net/capture.h>
+
+#define PORT_A 4321
+#define PORT_B 4322
+#define WAIT_TIME K_MSEC(100)
+
+#define PCAPNG_SHB 0x0A0D0D0A
+#define PCAPNG_IDB 0x00000001
+#define PCAPNG_EPB 0x00000006
+
+/* IPv4 UDP 192.0.2.1:5000 -> 192.0.2.2:53 */
+static const uint8_t udp4_pkt[] = {
+	0x45, 0x00, 0x00, 0x1c, 0x00, 0x00, 0x00, 0x00,
+	0x40, 0x11, 0x00, 0x00, 0xc0, 0x00, 0x02, 0x01,
+	0xc0, 0x00, 0x02, 0x02, 0x13, 0x88, 0x00, 0x35,
+	0x00, 0x08, 0x00, 0x00,
+};
+
+/* IPv6 TCP [2001:db8::1]:80 -> [2001:db8::2]:40000 */
+static const uint8_t tcp6_pkt[] = {
+	0x60, 0x00, 0x00, 0x00, 0x00, 0x14, 0x06, 0x40,
+	0x20, 0x01, 0x0d, 0xb8, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+	0x20, 0x01, 0x0d, 0xb8, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02,
+	0x00, 0x50, 0x9c, 0x40, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x50, 0x02, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00,
+};
+
+static struct net_pkt *make_pkt(const uint8_t *data, size_t len)
+{
+	struct net_pkt *pkt;
+
+	pkt = net_pkt_alloc_with_buffer(net_if_get_default(), len, AF_UNSPEC,
+					0, K_NO_WAIT);
+	zassert_not_null(pkt, "Cannot allocate packet");
+
+	zassert_equal(net_pkt_write(pkt, data, len), 0, "Cannot write packet");
+
+	return pkt;
+}
+
+static bool match(const char *expr, struct net_pkt *pkt,
+		  enum net_capture_dir dir)
+{
+	struct net_capture_filter filter;
+	int ret;
+
+	ret = net_capture_filter_compile(&filter, expr);
+	zassert_equal(ret, 0, "Cannot compile '%s' (%d)", expr, ret);
+
+	return net_capture_filter_match(&filter, pkt, dir);
+}
+
+static void test_filter_compile(void)
+{
+	static const char * const invalid[] = {
+		"udp and", "port", "port 70000", "host gateway", "(udp",
+		"udp)", "tcp udp", "not", "foo", "&& udp",
+	};
+	struct net_capture_filter filter;
+	char expr[128];
+	int ret;
+	int i;
+
+	zassert_equal(net_capture_filter_compile(&filter, ""), 0, "");
+	zassert_equal(filter.len, 0, "Empty filter has instructions");
+	zassert_equal(net_capture_filter_compile(&filter, NULL), 0, "");
+
+	ret = net_capture_filter_compile(&filter,
+					 "(udp||tcp)&&!dst port 53");
+	zassert_equal(ret, 0, "Cannot compile (%d)", ret);
+	zassert_equal(filter.len, 6, "Wrong length %d", filter.len);
+
+	for (i = 0; i < ARRAY_SIZE(invalid); i++) {
+		ret = net_capture_filter_compile(&filter, invalid[i]);
+		zassert_equal(ret, -EINVAL, "'%s' accepted (%d)", invalid[i],
+			      ret);
+		zassert_equal(filter.len, 0, "Invalid filter has instructions");
+	}
+
+	/* One instruction per primitive and one per operator */
+	strcpy(expr, "udp");
+	for (i = 1; i < CONFIG_NET_CAPTURE_FILTER_MAX_INSNS / 2; i++) {
+		strcat(expr, " or udp");
+	}
+
+	ret = net_capture_filter_compile(&filter, expr);
+	zassert_equal(ret, 0, "Cannot compile (%d)", ret);
+
+	strcat(expr, " or udp");
+	ret = net_capture_filter_compile(&filter, expr);
+	zassert_equal(ret, -ENOMEM, "Too long filter accepted (%d)", ret);
+}
+
+static void test_filter_match(void)
+{
+	struct net_pkt *udp4 = make_pkt(udp4_pkt, sizeof(udp4_pkt));
+	struct net_pkt *tcp6 = make_pkt(tcp6_pkt, sizeof(tcp6_pkt));
+
+	zassert_true(match("", udp4, NET_CAPTURE_IN), "");
+	zassert_true(match("ip and udp", udp4, NET_CAPTURE_IN), "");
+	zassert_false(match("ip6", udp4, NET_CAPTURE_IN), "");
+	zassert_false(match("tcp", udp4, NET_CAPTURE_IN), "");
+	zassert_true(match("port 53", udp4, NET_CAPTURE_IN), "");
+	zassert_true(match("port 5000", udp4, NET_CAPTURE_IN), "");
+	zassert_true(match("dst port 53", udp4, NET_CAPTURE_IN), "");
+	zassert_false(match("src port 53", udp4, NET_CAPTURE_IN), "");
+	zassert_true(match("src host 192.0.2.1", udp4, NET_CAPTURE_IN), "");
+	zassert_false(match("dst host 192.0.2.1", udp4, NET_CAPTURE_IN), "");
+	zassert_true(match("host 192.0.2.2", udp4, NET_CAPTURE_IN), "");
+	zassert_true(match("in", udp4, NET_CAPTURE_IN), "");
+	zassert_false(match("in", udp4, NET_CAPTURE_OUT), "");
+	zassert_true(match("out or port 53", udp4, NET_CAPTURE_IN), "");
+	zassert_false(match("not (udp and port 53)", udp4, NET_CAPTURE_IN),
+		      "");
+
+	zassert_true(match("ip6 and tcp", tcp6, NET_CAPTURE_OUT), "");
+	zassert_false(match("udp or icmp6", tcp6, NET_CAPTURE_OUT), "");
+	zassert_true(match("src port 80 && dst port 40000", tcp6,
+			   NET_CAPTURE_OUT), "");
+	zassert_true(match("src host 2001:db8::1", tcp6, NET_CAPTURE_OUT), "");
+	zassert_false(match("host 2001:db8::3", tcp6, NET_CAPTURE_OUT), "");
+	zassert_false(match("host 192.0.2.1", tcp6, NET_CAPTURE_OUT), "");
+
+	net_pkt_unref(udp4);
+	net_pkt_unref(tcp6);
+}
+
+struct export_data {
+	int shb;
+	int idb;
+	int epb;
+	uint32_t flags;
+	uint32_t orig_len;
+	uint16_t dst_port;
+};
+
+static int export_cb(const void *data, size_t len, void *user_data)
+{
+	struct export_data *export = user_data;
+	const uint32_t *block = data;
+	const uint8_t *pkt;
+
+	zassert_equal(len % 4, 0, "Unaligned block length %zu", len);
+	zassert_equal(block[1], len, "Wrong block length");
+	zassert_equal(block[len / 4 - 1], len, "Wrong trailing length");
+
+	switch (block[0]) {
+	case PCAPNG_SHB:
+		export->shb++;
+		break;
+	case PCAPNG_IDB:
+		/* LINKTYPE_RAW */
+		zassert_equal(block[2] & 0xffff, 101, "Wrong link type");
+		export->idb++;
+		break;
+	case PCAPNG_EPB:
+		pkt = (const uint8_t *)&block[7];
+		export->epb++;
+		export->orig_len = block[6];
+		export->dst_port = (pkt[22] << 8) | pkt[23];
+		/* epb_flags option value after the padded data */
+		export->flags = block[7 + ROUND_UP(block[5], 4) / 4 + 1];
+		break;
+	default:
+		zassert_unreachable("Unknown block 0x%08x", block[0]);
+	}
+
+	return 0;
+}
+
+static int udp_socket(uint16_t port)
+{
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_port = htons(port),
+		.sin_addr = { { { 127, 0, 0, 1 } } },
+	};
+	int sock;
+
+	sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	zassert_true(sock >= 0, "Cannot create socket (%d)", errno);
+
+	zassert_equal(bind(sock, (struct sockaddr *)&addr, sizeof(addr)), 0,
+		      "Cannot bind socket (%d)", errno);
+
+	return sock;
+}
+
+static void send_to(int sock, uint16_t port)
+{
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_port = htons(port),
+		.sin_addr = { { { 127, 0, 0, 1 } } },
+	};
+	int ret;
+
+	ret = sendto(sock, "ping", 4, 0, (struct sockaddr *)&addr,
+		     sizeof(addr));
+	zassert_equal(ret, 4, "Cannot send (%d)", errno);
+}
+
+static void test_capture(void)
+{
+	struct net_capture_stats stats;
+	struct export_data export;
+	int sock_a = udp_socket(PORT_A);
+	int sock_b = udp_socket(PORT_B);
+	int ret;
+	int i;
+
+	ret = net_capture_start(NULL, "udp and dst port 4321");
+	zassert_equal(ret, 0, "Cannot start capture (%d)", ret);
+	zassert_true(net_capture_is_active(), "Capture not running");
+
+	send_to(sock_a, PORT_B);
+	send_to(sock_b, PORT_A);
+	k_sleep(WAIT_TIME);
+
+	net_capture_get_stats(&stats);
+	zassert_equal(stats.captured, 1, "Captured %u", stats.captured);
+	zassert_true(stats.filtered >= 1, "Filtered %u", stats.filtered);
+	zassert_equal(stats.dropped, 0, "Dropped %u", stats.dropped);
+
+	memset(&export, 0, sizeof(export));
+	ret = net_capture_export(export_cb, &export, true);
+	zassert_equal(ret, 1, "Exported %d packets", ret);
+	zassert_equal(export.shb, 1, "Wrong number of SHB");
+	zassert_true(export.idb >= 1, "No IDB");
+	zassert_equal(export.epb, 1, "Wrong number of EPB");
+	zassert_equal(export.dst_port, PORT_A, "Wrong port %u",
+		      export.dst_port);
+	zassert_equal(export.orig_len, NET_IPV4UDPH_LEN + 4,
+		      "Wrong length %u", export.orig_len);
+	/* Looped back packets are seen when they are sent */
+	zassert_equal(export.flags, NET_CAPTURE_OUT, "Wrong flags %u",
+		      export.flags);
+
+	/* Exported packets are removed from the ring buffer */
+	memset(&export, 0, sizeof(export));
+	ret = net_capture_export(export_cb, &export, false);
+	zassert_equal(ret, 0, "Exported %d packets again", ret);
+	zassert_equal(export.shb + export.idb, 0, "Header written");
+
+	/* Packets are dropped once the ring buffer is full */
+	for (i = 0; i < CONFIG_NET_CAPTURE_SLOTS + 2; i++) {
+		send_to(sock_b, PORT_A);
+	}
+
+	k_sleep(WAIT_TIME);
+
+	net_capture_stop();
+	zassert_false(net_capture_is_active(), "Capture still running");
+
+	send_to(sock_b, PORT_A);
+	k_sleep(WAIT_TIME);
+
+	net_capture_get_stats(&stats);
+	zassert_equal(stats.captured, 1 + CONFIG_NET_CAPTURE_SLOTS,
+		      "Captured %u", stats.captured);
+	zassert_equal(stats.dropped, 2, "Dropped %u", stats.dropped);
+
+	memset(&export, 0, sizeof(export));
+	ret = net_capture_export(export_cb, &export, false);
+	zassert_equal(ret, CONFIG_NET_CAPTURE_SLOTS, "Exported %d packets",
+		      ret);
+
+	close(sock_a);
+	close(sock_b);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(net_capture,
+			 ztest_unit_test(test_filter_compile),
+			 ztest_unit_test(test_filter_match),
+			 ztest_unit_test(test_capture));
+
+	ztest_run_test_suite(net_capture);
+}
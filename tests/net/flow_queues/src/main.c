@@ -0,0 +1,240 @@
+/* main.c - Application main entry point */
+
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, CONFIG_NET_TC_LOG_LEVEL);
+
+#include <zephyr.h>
+#include <ztest.h>
+
+#include <net/net_core.h>
+#include <net/net_pkt.h>
+#include <net/net_ip.h>
+#include <net/dummy.h>
+
+#include "ipv6.h"
+#include "udp_internal.h"
+
+#define FLOWS 8
+#define PKTS_PER_FLOW 16
+#define LOCAL_PORT 4242
+#define FLOW_PORT_BASE 5000
+
+#define WAIT_TIME K_SECONDS(1)
+
+static struct in6_addr my_addr = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+				       0, 0, 0, 0, 0, 0, 0, 0x1 } } };
+static struct in6_addr peer_addr = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+					 0, 0, 0, 0, 0, 0, 0, 0x2 } } };
+
+static struct net_if *iface;
+static struct net_conn_handle *handle;
+static struct k_sem recv_sem;
+
+static struct {
+	k_tid_t thread;
+	uint32_t next_seq;
+	bool out_of_order;
+	bool thread_changed;
+} flows[FLOWS];
+
+static uint8_t fake_mac[] = { 0x00, 0x00, 0x5E, 0x00, 0x53, 0x01 };
+
+static void fq_iface_init(struct net_if *iface)
+{
+	net_if_set_link_addr(iface, fake_mac, sizeof(fake_mac),
+			     NET_LINK_ETHERNET);
+}
+
+static int fq_send(struct device *dev, struct net_pkt *pkt)
+{
+	return 0;
+}
+
+static int fq_dev_init(struct device *dev)
+{
+	return 0;
+}
+
+static struct dummy_api fq_if_api = {
+	.iface_api.init = fq_iface_init,
+	.send = fq_send,
+};
+
+NET_DEVICE_INIT(fq_test, "fq_test",
+		fq_dev_init, device_pm_control_nop, NULL, NULL,
+		CONFIG_KERNEL_INIT_PRIORITY_DEFAULT,
+		&fq_if_api, DUMMY_L2, NET_L2_GET_CTX_TYPE(DUMMY_L2), 127);
+
+static enum net_verdict recv_cb(struct net_conn *conn,
+				struct net_pkt *pkt,
+				union net_ip_header *ip_hdr,
+				union net_proto_header *proto_hdr,
+				void *user_data)
+{
+	int flow = ntohs(proto_hdr->udp->src_port) - FLOW_PORT_BASE;
+	uint32_t seq;
+
+	net_pkt_cursor_init(pkt);
+	net_pkt_skip(pkt, net_pkt_ip_hdr_len(pkt) + NET_UDPH_LEN);
+
+	if (flow < 0 || flow >= FLOWS || net_pkt_read_be32(pkt, &seq)) {
+		return NET_DROP;
+	}
+
+	if (!flows[flow].thread) {
+		flows[flow].thread = k_current_get();
+	} else if (flows[flow].thread != k_current_get()) {
+		flows[flow].thread_changed = true;
+	}
+
+	if (seq != flows[flow].next_seq) {
+		flows[flow].out_of_order = true;
+	}
+
+	flows[flow].next_seq = seq + 1;
+
+	net_pkt_unref(pkt);
+	k_sem_give(&recv_sem);
+
+	return NET_OK;
+}
+
+static void test_setup(void)
+{
+	struct sockaddr_in6 local = {
+		.sin6_family = AF_INET6,
+		.sin6_addr = my_addr,
+	};
+	struct net_if_addr *ifaddr;
+	int ret;
+
+	iface = net_if_get_first_by_type(&NET_L2_GET_NAME(DUMMY));
+	zassert_not_null(iface, "No interface");
+
+	ifaddr = net_if_ipv6_addr_add(iface, &my_addr, NET_ADDR_MANUAL, 0);
+	zassert_not_null(ifaddr, "Cannot add address");
+
+	ret = net_udp_register(AF_INET6, NULL, (struct sockaddr *)&local,
+			       0, LOCAL_PORT, recv_cb, NULL, &handle);
+	zassert_equal(ret, 0, "Cannot register UDP handler (%d)", ret);
+
+	k_sem_init(&recv_sem, 0, UINT_MAX);
+}
+
+static void recv_pkt(int flow, uint32_t seq, uint32_t hash)
+{
+	struct net_pkt *pkt;
+
+	pkt = net_pkt_rx_alloc_with_buffer(iface, sizeof(seq), AF_INET6,
+					   IPPROTO_UDP, K_NO_WAIT);
+	zassert_not_null(pkt, "Cannot allocate packet");
+
+	zassert_equal(net_ipv6_create(pkt, &peer_addr, &my_addr), 0,
+		      "Cannot create IPv6 header");
+	zassert_equal(net_udp_create(pkt, htons(FLOW_PORT_BASE + flow),
+				     htons(LOCAL_PORT)), 0,
+		      "Cannot create UDP header");
+	zassert_equal(net_pkt_write_be32(pkt, seq), 0, "Cannot write data");
+
+	net_pkt_cursor_init(pkt);
+	net_ipv6_finalize(pkt, IPPROTO_UDP);
+
+	net_pkt_set_flow_hash(pkt, hash);
+
+	zassert_equal(net_recv_data(iface, pkt), 0, "Cannot receive packet");
+}
+
+static void wait_pkts(int count)
+{
+	while (count--) {
+		zassert_equal(k_sem_take(&recv_sem, WAIT_TIME), 0,
+			      "Packet not received");
+	}
+}
+
+static void test_flow_order(void)
+{
+	k_tid_t threads[NET_RX_FLOW_QUEUES] = { 0 };
+	int used = 0;
+	int flow, seq, i;
+
+	memset(flows, 0, sizeof(flows));
+
+	/* Interleave the flows */
+	for (seq = 0; seq < PKTS_PER_FLOW; seq++) {
+		for (flow = 0; flow < FLOWS; flow++) {
+			recv_pkt(flow, seq, 0);
+		}
+	}
+
+	wait_pkts(FLOWS * PKTS_PER_FLOW);
+
+	for (flow = 0; flow < FLOWS; flow++) {
+		zassert_equal(flows[flow].next_seq, PKTS_PER_FLOW,
+			      "Flow %d lost packets", flow);
+		zassert_false(flows[flow].out_of_order,
+			      "Flow %d out of order", flow);
+		zassert_false(flows[flow].thread_changed,
+			      "Flow %d handled by several threads", flow);
+
+		for (i = 0; i < used; i++) {
+			if (threads[i] == flows[flow].thread) {
+				break;
+			}
+		}
+
+		if (i == used) {
+			zassert_true(used < NET_RX_FLOW_QUEUES,
+				     "Too many RX threads");
+			threads[used++] = flows[flow].thread;
+		}
+	}
+
+	zassert_true(used > 1, "Flows not spread over the queues");
+}
+
+static void test_driver_hash(void)
+{
+	int flow;
+
+	memset(flows, 0, sizeof(flows));
+
+	/* Flows 0 and 1 get the same queue by their hash, flow 2 the next */
+	recv_pkt(0, 0, 1);
+	recv_pkt(1, 0, 1 + NET_RX_FLOW_QUEUES);
+	recv_pkt(2, 0, 2);
+
+	wait_pkts(3);
+
+	for (flow = 0; flow < 3; flow++) {
+		zassert_equal(flows[flow].next_seq, 1, "Packet lost");
+	}
+
+	zassert_equal(flows[0].thread, flows[1].thread,
+		      "Same hash queue, different threads");
+	zassert_not_equal(flows[0].thread, flows[2].thread,
+			  "Different hash queue, same thread");
+}
+
+static void test_cleanup(void)
+{
+	zassert_equal(net_udp_unregister(handle), 0,
+		      "Cannot unregister UDP handler");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(net_flow_queues,
+			 ztest_unit_test(test_setup),
+			 ztest_unit_test(test_flow_order),
+			 ztest_unit_test(test_driver_hash),
+			 ztest_unit_test(test_cleanup));
+
+	ztest_run_test_suite(net_flow_queues);
+}
@@ -19,10 +19,13 @@ LOG_MODULE_REGISTER(net_ieee802154_fake_driver, LOG_LEVEL_DBG);
 
 extern struct net_pkt *current_pkt;
 extern struct k_sem driver_lock;
+extern enum ieee802154_hw_caps fake_caps;
+extern int fake_tx_err;
+extern int fake_tx_err_frame;
 
 static enum ieee802154_hw_caps fake_get_capabilities(struct device *dev)
 {
-	return IEEE802154_HW_FCS | IEEE802154_HW_2_4_GHZ;
+	return IEEE802154_HW_FCS | IEEE802154_HW_2_4_GHZ | fake_caps;
 }
 
 static int fake_cca(struct device *dev)
@@ -67,6 +70,15 @@ static int fake_tx(struct device *dev,
 	NET_INFO("Sending packet %p - length %zu\n",
 		 pkt, net_pkt_get_len(pkt));
 
+	if (fake_tx_err) {
+		k_sem_give(&driver_lock);
+		return fake_tx_err;
+	}
+
+	if (fake_tx_err_frame && --fake_tx_err_frame == 0) {
+		return -EIO;
+	}
+
 	if (!current_pkt) {
 		return 0;
 	}
@@ -16,8 +16,11 @@ LOG_MODULE_REGISTER(net_ieee802154_test, LOG_LEVEL_DBG);
 #include <net/net_ip.h>
 #include <net/net_pkt.h>
 
+#include <net/ieee802154_radio.h>
+
 #include <ieee802154_frame.h>
 #include <ipv6.h>
+#include <udp_internal.h>
 
 struct ieee802154_pkt_test {
 	char *name;
@@ -104,6 +107,10 @@ struct ieee802154_pkt_test test_sec_data_pkt = {
 struct net_pkt *current_pkt;
 struct net_if *iface;
 K_SEM_DEFINE(driver_lock, 0, UINT_MAX);
+enum ieee802154_hw_caps fake_caps;
+int fake_tx_err;
+/* Number of the next frame the radio fails to transmit, 0 for none */
+int fake_tx_err_frame;
 
 static void pkt_hexdump(uint8_t *pkt, uint8_t length)
 {
@@ -200,25 +207,24 @@ static bool test_ns_sending(struct ieee802154_pkt_test *t)
 	return true;
 }
 
-static bool test_ack_reply(struct ieee802154_pkt_test *t)
+/* Data frame requesting an ACK */
+static uint8_t data_pkt[] = {
+	0x61, 0xdc, 0x16, 0xcd, 0xab, 0x26, 0x11, 0x32, 0x00, 0x00, 0x4b,
+	0x12, 0x00, 0x26, 0x18, 0x32, 0x00, 0x00, 0x4b, 0x12, 0x00, 0x7b,
+	0x00, 0x3a, 0x20, 0x01, 0x0d, 0xb8, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x20, 0x01, 0x0d, 0xb8,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x02, 0x87, 0x00, 0x8b, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20, 0x01,
+	0x0d, 0xb8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff,
+	0x16, 0xf0, 0x02, 0xff, 0x16, 0xf0, 0x12, 0xff, 0x16, 0xf0, 0x32,
+	0xff, 0x16, 0xf0, 0x00, 0xff, 0x16, 0xf0, 0x00, 0xff, 0x16
+};
+
+static bool receive_data_pkt(void)
 {
-	static uint8_t data_pkt[] = {
-		0x61, 0xdc, 0x16, 0xcd, 0xab, 0x26, 0x11, 0x32, 0x00, 0x00, 0x4b,
-		0x12, 0x00, 0x26, 0x18, 0x32, 0x00, 0x00, 0x4b, 0x12, 0x00, 0x7b,
-		0x00, 0x3a, 0x20, 0x01, 0x0d, 0xb8, 0x00, 0x00, 0x00, 0x00, 0x00,
-		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x20, 0x01, 0x0d, 0xb8,
-		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-		0x02, 0x87, 0x00, 0x8b, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20, 0x01,
-		0x0d, 0xb8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff,
-		0x16, 0xf0, 0x02, 0xff, 0x16, 0xf0, 0x12, 0xff, 0x16, 0xf0, 0x32,
-		0xff, 0x16, 0xf0, 0x00, 0xff, 0x16, 0xf0, 0x00, 0xff, 0x16
-	};
-	struct ieee802154_mpdu mpdu;
 	struct net_pkt *pkt;
 	struct net_buf *frag;
 
-	NET_INFO("- Sending ACK reply to a data packet\n");
-
 	pkt = net_pkt_rx_alloc(K_FOREVER);
 	frag = net_pkt_get_frag(pkt, K_FOREVER);
 
@@ -232,6 +238,19 @@ static bool test_ack_reply(struct ieee802154_pkt_test *t)
 		return false;
 	}
 
+	return true;
+}
+
+static bool test_ack_reply(struct ieee802154_pkt_test *t)
+{
+	struct ieee802154_mpdu mpdu;
+
+	NET_INFO("- Sending ACK reply to a data packet\n");
+
+	if (!receive_data_pkt()) {
+		return false;
+	}
+
 	k_yield();
 	k_sem_take(&driver_lock, K_SECONDS(1));
 
@@ -356,6 +375,165 @@ static void test_parsing_sec_data_pkt(void)
 	zassert_true(ret, "Secured data frame parsed");
 }
 
+static void test_hw_ack_no_reply(void)
+{
+	NET_INFO("- Receiving a data packet with a radio sending ACKs\n");
+
+	fake_caps = IEEE802154_HW_RX_TX_ACK;
+
+	zassert_true(receive_data_pkt(), "Data packet received");
+
+	k_yield();
+
+	zassert_not_equal(k_sem_take(&driver_lock, K_MSEC(100)), 0,
+			  "ACK replied by the L2");
+	zassert_is_null(current_pkt->frags, "Frame sent");
+
+	fake_caps = 0;
+}
+
+/* Count the attempts to send a NS the radio fails to transmit */
+static int ns_tx_attempts(void)
+{
+	int attempts = 0;
+
+	fake_tx_err = -EIO;
+
+	zassert_equal(net_ipv6_send_ns(iface, NULL, &test_ns_pkt.src,
+				       &test_ns_pkt.dst, &test_ns_pkt.dst,
+				       false), 0, "NS not created");
+
+	while (k_sem_take(&driver_lock, K_MSEC(100)) == 0) {
+		attempts++;
+	}
+
+	fake_tx_err = 0;
+
+	return attempts;
+}
+
+static void test_hw_retransmission(void)
+{
+	NET_INFO("- Sending to a radio retransmitting by itself\n");
+
+	zassert_equal(ns_tx_attempts(),
+		      CONFIG_NET_L2_IEEE802154_RADIO_TX_RETRIES,
+		      "L2 did not retry");
+
+	fake_caps = IEEE802154_HW_RETRANSMISSION;
+
+	zassert_equal(ns_tx_attempts(), 1, "L2 retried");
+
+	fake_caps = 0;
+}
+
+/* Large enough to be sent in fragments */
+#define LARGE_PAYLOAD_LEN 200
+#define TEST_PORT 4242
+
+/* Send a UDP packet to all the nodes */
+static void send_udp_pkt(uint16_t len)
+{
+	struct in6_addr dst = { { { 0xff, 0x02, 0, 0, 0, 0, 0, 0,
+				    0, 0, 0, 0, 0, 0, 0, 0x01 } } };
+	struct net_pkt *pkt;
+
+	pkt = net_pkt_alloc_with_buffer(iface, len, AF_INET6, IPPROTO_UDP,
+					K_SECONDS(1));
+	zassert_not_null(pkt, "Out of mem");
+
+	zassert_equal(net_ipv6_create(pkt, &test_ns_pkt.src, &dst), 0,
+		      "Cannot create the IPv6 header");
+	zassert_equal(net_udp_create(pkt, htons(TEST_PORT), htons(TEST_PORT)),
+		      0, "Cannot create the UDP header");
+	zassert_equal(net_pkt_memset(pkt, 0, len), 0, "Cannot add the data");
+
+	net_pkt_cursor_init(pkt);
+	net_ipv6_finalize(pkt, IPPROTO_UDP);
+
+	zassert_true(net_send_data(pkt) >= 0, "Packet not sent");
+}
+
+/* Wait for the radio to be done, and describe the frames it sent: F for
+ * a first fragment, N for a next one, P for a whole packet.
+ */
+static void sent_frames(char *frames, size_t size)
+{
+	struct ieee802154_mpdu mpdu;
+	struct net_buf *frag;
+	int sequence = -1;
+	uint8_t dispatch;
+	size_t i = 0;
+
+	while (k_sem_take(&driver_lock, K_MSEC(100)) == 0) {
+	}
+
+	for (frag = current_pkt->frags; frag; frag = frag->frags) {
+		zassert_true(ieee802154_validate_frame(frag->data, frag->len,
+						       &mpdu),
+			     "Sent frame is not valid");
+		zassert_true(mpdu.mhr.fs->sequence > sequence,
+			     "Frame sent out of order");
+		zassert_true(i < size - 1, "Too many frames");
+
+		sequence = mpdu.mhr.fs->sequence;
+		dispatch = *(uint8_t *)mpdu.payload & 0xF8;
+
+		if (dispatch == 0xC0) {
+			frames[i++] = 'F';
+		} else if (dispatch == 0xE0) {
+			frames[i++] = 'N';
+		} else {
+			frames[i++] = 'P';
+		}
+	}
+
+	frames[i] = '\0';
+
+	net_pkt_frag_unref(current_pkt->frags);
+	current_pkt->frags = NULL;
+}
+
+static void test_tx_order(void)
+{
+	struct ieee802154_context *ctx = net_if_l2_data(iface);
+	struct k_mem_slab *tx;
+	uint32_t tx_free;
+	char frames[8];
+
+	NET_INFO("- Sending a fragmented packet and a whole one\n");
+
+	net_pkt_get_info(NULL, &tx, NULL, NULL);
+	tx_free = k_mem_slab_num_free_get(tx);
+
+	fake_caps = IEEE802154_HW_RETRANSMISSION;
+
+	/* Keep the sequence numbers from wrapping around */
+	ctx->sequence = 0U;
+
+	send_udp_pkt(LARGE_PAYLOAD_LEN);
+	send_udp_pkt(0);
+
+	sent_frames(frames, sizeof(frames));
+	zassert_equal(strcmp(frames, "FNNP"), 0, "Unexpected frames: %s",
+		      frames);
+
+	/* A failed frame drops the rest of its packet only */
+	fake_tx_err_frame = 2;
+
+	send_udp_pkt(LARGE_PAYLOAD_LEN);
+	send_udp_pkt(LARGE_PAYLOAD_LEN);
+
+	sent_frames(frames, sizeof(frames));
+	zassert_equal(strcmp(frames, "FFNN"), 0, "Unexpected frames: %s",
+		      frames);
+
+	fake_caps = 0;
+
+	/* The packets are released once their last frame was handled */
+	zassert_equal(k_mem_slab_num_free_get(tx), tx_free, "Packet leaked");
+}
+
 void test_main(void)
 {
 	ztest_test_suite(ieee802154_l2,
@@ -365,7 +543,10 @@ void test_main(void)
 			 ztest_unit_test(test_parsing_ack_pkt),
 			 ztest_unit_test(test_replying_ack_pkt),
 			 ztest_unit_test(test_parsing_beacon_pkt),
-			 ztest_unit_test(test_parsing_sec_data_pkt)
+			 ztest_unit_test(test_parsing_sec_data_pkt),
+			 ztest_unit_test(test_hw_ack_no_reply),
+			 ztest_unit_test(test_hw_retransmission),
+			 ztest_unit_test(test_tx_order)
 		);
 
 	ztest_run_test_suite(ieee802154_l2);
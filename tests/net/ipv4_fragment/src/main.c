@@ -0,0 +1,562 @@
+/* main.c - Application main entry point */
+
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, CONFIG_NET_IPV4_LOG_LEVEL);
+
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/printk.h>
+
+#include <ztest.h>
+
+#include <net/dummy.h>
+#include <net/buf.h>
+#include <net/net_ip.h>
+#include <net/net_if.h>
+
+#define NET_LOG_ENABLED 1
+#include "net_private.h"
+
+#include "ipv4.h"
+#include "udp_internal.h"
+
+#define PEER_PORT 4242
+#define MY_PORT 4343
+
+/* The UDP header and payload are split in four fragments */
+#define PAYLOAD_LEN 1400
+#define UDP_LEN (NET_UDPH_LEN + PAYLOAD_LEN)
+#define DGRAM_LEN (NET_IPV4H_LEN + UDP_LEN)
+#define FRAG_LEN (UDP_LEN / 4)
+
+#define THROUGHPUT_COUNT 100
+
+#define WAIT_TIME K_MSEC(100)
+
+static struct in_addr my_addr = { { { 192, 0, 2, 1 } } };
+static struct in_addr peer_addr = { { { 192, 0, 2, 2 } } };
+static struct in_addr peer2_addr = { { { 192, 0, 2, 3 } } };
+
+static uint8_t mac_addr[] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+
+static struct net_if *iface;
+
+/* Datagram from a peer, the fragments are cut out of it */
+static uint8_t dgram[DGRAM_LEN];
+static uint8_t payload[PAYLOAD_LEN];
+
+static K_SEM_DEFINE(recv_sem, 0, UINT_MAX);
+static bool recv_failed;
+
+#define MAX_SENT 8
+static struct net_pkt *sent[MAX_SENT];
+static int sent_count;
+static bool capture;
+
+static void net_iface_init(struct net_if *iface)
+{
+	net_if_set_link_addr(iface, mac_addr, sizeof(mac_addr),
+			     NET_LINK_ETHERNET);
+}
+
+static int sender_iface(struct device *dev, struct net_pkt *pkt)
+{
+	/* The L2 releases the packet after this */
+	if (capture && sent_count < MAX_SENT) {
+		sent[sent_count++] = net_pkt_ref(pkt);
+	}
+
+	return 0;
+}
+
+static int net_iface_dev_init(struct device *dev)
+{
+	return 0;
+}
+
+static struct dummy_api net_iface_api = {
+	.iface_api.init = net_iface_init,
+	.send = sender_iface,
+};
+
+NET_DEVICE_INIT(net_ipv4_frag_test, "net_ipv4_frag_test",
+		net_iface_dev_init, device_pm_control_nop, NULL, NULL,
+		CONFIG_KERNEL_INIT_PRIORITY_DEFAULT,
+		&net_iface_api, DUMMY_L2, NET_L2_GET_CTX_TYPE(DUMMY_L2), 127);
+
+static enum net_verdict udp_data_received(struct net_conn *conn,
+					  struct net_pkt *pkt,
+					  union net_ip_header *ip_hdr,
+					  union net_proto_header *proto_hdr,
+					  void *user_data)
+{
+	static uint8_t data[PAYLOAD_LEN];
+	size_t len = net_pkt_get_len(pkt) - NET_IPV4H_LEN - NET_UDPH_LEN;
+
+	net_pkt_cursor_init(pkt);
+
+	if (len != PAYLOAD_LEN ||
+	    net_pkt_skip(pkt, NET_IPV4H_LEN + NET_UDPH_LEN) ||
+	    net_pkt_read(pkt, data, len) ||
+	    memcmp(data, payload, len)) {
+		NET_DBG("Invalid data received, len %zd", len);
+		recv_failed = true;
+	}
+
+	net_pkt_unref(pkt);
+
+	k_sem_give(&recv_sem);
+
+	return NET_OK;
+}
+
+static void pending_cb(struct net_reassembly *reass, void *user_data)
+{
+	(*(int *)user_data)++;
+}
+
+static int pending(void)
+{
+	int count = 0;
+
+	/* Let the RX thread process the injected fragments */
+	k_sleep(K_MSEC(10));
+
+	net_ipv4_frag_foreach(pending_cb, &count);
+
+	return count;
+}
+
+/* Create the datagram the fragments are cut from */
+static void build_dgram(struct in_addr *src)
+{
+	struct net_pkt *pkt;
+
+	pkt = net_pkt_alloc_with_buffer(iface, UDP_LEN, AF_INET,
+					IPPROTO_UDP, K_NO_WAIT);
+	zassert_not_null(pkt, "Cannot allocate pkt");
+
+	zassert_equal(net_ipv4_create(pkt, src, &my_addr), 0,
+		      "Cannot create IPv4 header");
+	zassert_equal(net_udp_create(pkt, htons(PEER_PORT), htons(MY_PORT)),
+		      0, "Cannot create UDP header");
+	zassert_equal(net_pkt_write(pkt, payload, sizeof(payload)), 0,
+		      "Cannot write payload");
+
+	net_pkt_cursor_init(pkt);
+	zassert_equal(net_ipv4_finalize(pkt, IPPROTO_UDP), 0,
+		      "Cannot finalize");
+
+	net_pkt_cursor_init(pkt);
+	zassert_equal(net_pkt_read(pkt, dgram, sizeof(dgram)), 0,
+		      "Cannot read datagram");
+
+	net_pkt_unref(pkt);
+}
+
+static void set_frag_hdr(struct net_pkt *pkt, uint16_t id, uint16_t offset,
+			 uint16_t len, bool more)
+{
+	NET_PKT_DATA_ACCESS_CONTIGUOUS_DEFINE(ipv4_access, struct net_ipv4_hdr);
+	struct net_ipv4_hdr *hdr;
+	uint16_t flag = offset / 8U;
+
+	if (more) {
+		flag |= NET_IPV4_MORE_FRAG_MASK;
+	}
+
+	net_pkt_cursor_init(pkt);
+	net_pkt_set_overwrite(pkt, true);
+	net_pkt_set_ip_hdr_len(pkt, NET_IPV4H_LEN);
+
+	hdr = (struct net_ipv4_hdr *)net_pkt_get_data(pkt, &ipv4_access);
+	zassert_not_null(hdr, "No IPv4 header");
+
+	hdr->len = htons(NET_IPV4H_LEN + len);
+	hdr->id[0] = id >> 8;
+	hdr->id[1] = id;
+	hdr->offset[0] = flag >> 8;
+	hdr->offset[1] = flag;
+	hdr->chksum = 0U;
+	hdr->chksum = net_calc_chksum_ipv4(pkt);
+
+	net_pkt_set_data(pkt, &ipv4_access);
+
+	net_pkt_cursor_init(pkt);
+	net_pkt_set_overwrite(pkt, false);
+}
+
+/* Feed a fragment of the datagram to the stack */
+static void recv_frag(uint16_t id, uint16_t offset, uint16_t len, bool more)
+{
+	struct net_pkt *pkt;
+
+	pkt = net_pkt_rx_alloc_with_buffer(iface, NET_IPV4H_LEN + len,
+					   AF_INET, 0, K_NO_WAIT);
+	zassert_not_null(pkt, "Cannot allocate pkt");
+
+	zassert_equal(net_pkt_write(pkt, dgram, NET_IPV4H_LEN), 0,
+		      "Cannot write header");
+	zassert_equal(net_pkt_write(pkt, dgram + NET_IPV4H_LEN + offset,
+				    len), 0, "Cannot write payload");
+
+	set_frag_hdr(pkt, id, offset, len, more);
+
+	zassert_equal(net_recv_data(iface, pkt), 0, "Cannot receive pkt");
+}
+
+static void recv_nth_frag(uint16_t id, int n)
+{
+	recv_frag(id, n * FRAG_LEN, FRAG_LEN, n < 3);
+}
+
+static void expect_recv(void)
+{
+	zassert_equal(k_sem_take(&recv_sem, WAIT_TIME), 0,
+		      "Packet not reassembled");
+	zassert_false(recv_failed, "Invalid packet reassembled");
+}
+
+static void expect_no_recv(void)
+{
+	zassert_equal(k_sem_take(&recv_sem, K_MSEC(20)), -EAGAIN,
+		      "Packet should not have been received");
+}
+
+static void test_setup(void)
+{
+	struct net_conn_handle *handle;
+	struct sockaddr local_addr = { 0 };
+	struct net_if_addr *ifaddr;
+	int ret, i;
+
+	for (i = 0; i < sizeof(payload); i++) {
+		payload[i] = i;
+	}
+
+	iface = net_if_get_first_by_type(&NET_L2_GET_NAME(DUMMY));
+	zassert_not_null(iface, "Interface");
+
+	ifaddr = net_if_ipv4_addr_add(iface, &my_addr, NET_ADDR_MANUAL, 0);
+	zassert_not_null(ifaddr, "Cannot add IPv4 address");
+
+	net_ipaddr_copy(&net_sin(&local_addr)->sin_addr, &my_addr);
+	local_addr.sa_family = AF_INET;
+
+	ret = net_udp_register(AF_INET, NULL, &local_addr, 0, MY_PORT,
+			       udp_data_received, NULL, &handle);
+	zassert_equal(ret, 0, "Cannot register UDP handler");
+
+	build_dgram(&peer_addr);
+}
+
+static void test_recv_in_order(void)
+{
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		recv_nth_frag(1, i);
+	}
+
+	expect_recv();
+	zassert_equal(pending(), 0, "Reassembly not released");
+}
+
+static void test_recv_reverse_order(void)
+{
+	int i;
+
+	for (i = 3; i >= 0; i--) {
+		recv_nth_frag(2, i);
+	}
+
+	expect_recv();
+	zassert_equal(pending(), 0, "Reassembly not released");
+}
+
+static void test_recv_out_of_order(void)
+{
+	static const int order[] = { 1, 3, 0, 2 };
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(order); i++) {
+		recv_nth_frag(3, order[i]);
+	}
+
+	expect_recv();
+	zassert_equal(pending(), 0, "Reassembly not released");
+}
+
+static void test_recv_duplicate(void)
+{
+	recv_nth_frag(4, 0);
+	recv_nth_frag(4, 2);
+	recv_nth_frag(4, 2);
+	recv_nth_frag(4, 1);
+	recv_nth_frag(4, 0);
+	recv_nth_frag(4, 3);
+
+	expect_recv();
+	expect_no_recv();
+	zassert_equal(pending(), 0, "Reassembly not released");
+}
+
+static void test_recv_overlap(void)
+{
+	recv_nth_frag(5, 0);
+	zassert_equal(pending(), 1, "Reassembly not started");
+
+	/* Overlapping fragments drop the whole packet */
+	recv_frag(5, FRAG_LEN - 8, FRAG_LEN, true);
+	zassert_equal(pending(), 0, "Reassembly not cancelled");
+
+	expect_no_recv();
+}
+
+static void test_recv_too_many_frags(void)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_NET_IPV4_FRAGMENT_MAX_PKT; i++) {
+		recv_frag(6, i * 8, 8, true);
+	}
+
+	zassert_equal(pending(), 1, "Reassembly not started");
+
+	recv_frag(6, i * 8, 8, true);
+	zassert_equal(pending(), 0, "Reassembly not cancelled");
+}
+
+static void test_recv_per_source_limit(void)
+{
+	int i;
+
+	for (i = 0; i <= CONFIG_NET_REASSEMBLY_MAX_PER_SOURCE; i++) {
+		recv_nth_frag(100 + i, 0);
+	}
+
+	zassert_equal(pending(), CONFIG_NET_REASSEMBLY_MAX_PER_SOURCE,
+		      "Too many reassemblies from one source");
+
+	/* Other sources still get a slot */
+	build_dgram(&peer2_addr);
+	recv_nth_frag(100, 0);
+	build_dgram(&peer_addr);
+
+	zassert_equal(pending(), CONFIG_NET_REASSEMBLY_MAX_PER_SOURCE + 1,
+		      "No reassembly slot for the second source");
+}
+
+static void test_recv_timeout(void)
+{
+	k_sleep(K_SECONDS(CONFIG_NET_IPV4_FRAGMENT_TIMEOUT));
+	k_sleep(K_MSEC(100));
+
+	zassert_equal(pending(), 0, "Reassemblies did not time out");
+
+	/* The slots are usable again */
+	test_recv_in_order();
+}
+
+static void test_send_fragmented(void)
+{
+	NET_PKT_DATA_ACCESS_CONTIGUOUS_DEFINE(ipv4_access, struct net_ipv4_hdr);
+	struct net_ipv4_hdr *hdr;
+	struct net_pkt *pkt;
+	uint16_t offset = 0U;
+	uint16_t id = 0U;
+	int i;
+
+	/* The payload is sent to the peer. The fragments are then fed
+	 * back with the addresses swapped, which keeps the UDP checksum
+	 * valid.
+	 */
+	pkt = net_pkt_alloc_with_buffer(iface, UDP_LEN, AF_INET,
+					IPPROTO_UDP, K_NO_WAIT);
+	zassert_not_null(pkt, "Cannot allocate pkt");
+
+	zassert_equal(net_ipv4_create(pkt, &my_addr, &peer_addr), 0,
+		      "Cannot create IPv4 header");
+	zassert_equal(net_udp_create(pkt, htons(PEER_PORT), htons(MY_PORT)),
+		      0, "Cannot create UDP header");
+	zassert_equal(net_pkt_write(pkt, payload, sizeof(payload)), 0,
+		      "Cannot write payload");
+
+	net_pkt_cursor_init(pkt);
+	zassert_equal(net_ipv4_finalize(pkt, IPPROTO_UDP), 0,
+		      "Cannot finalize");
+
+	capture = true;
+	zassert_true(net_send_data(pkt) >= 0, "Cannot send pkt");
+	k_sleep(K_MSEC(10));
+	capture = false;
+
+	/* The payload of each fragment is a multiple of 8 bytes that
+	 * fits the minimum IPv4 MTU.
+	 */
+	zassert_equal(sent_count, 3, "Invalid number of fragments %d",
+		      sent_count);
+
+	for (i = 0; i < sent_count; i++) {
+		struct net_pkt *frag = sent[i];
+		uint16_t flag, len;
+
+		net_pkt_cursor_init(frag);
+		net_pkt_set_ip_hdr_len(frag, NET_IPV4H_LEN);
+
+		zassert_equal(net_calc_chksum_ipv4(frag), 0,
+			      "Invalid header checksum");
+
+		hdr = (struct net_ipv4_hdr *)net_pkt_get_data(frag,
+							      &ipv4_access);
+		zassert_not_null(hdr, "No IPv4 header");
+
+		len = ntohs(hdr->len);
+		flag = (hdr->offset[0] << 8) | hdr->offset[1];
+
+		zassert_equal(len, net_pkt_get_len(frag), "Invalid length");
+		zassert_true(len <= NET_IPV4_MTU, "Fragment too long");
+		zassert_equal((flag & NET_IPV4_FRAG_OFFSET_MASK) * 8U, offset,
+			      "Invalid offset");
+		zassert_equal(!!(flag & NET_IPV4_MORE_FRAG_MASK),
+			      i < sent_count - 1, "Invalid MF flag");
+
+		if (i == 0) {
+			id = (hdr->id[0] << 8) | hdr->id[1];
+			zassert_not_equal(id, 0, "No fragment id");
+		} else {
+			zassert_equal((hdr->id[0] << 8) | hdr->id[1], id,
+				      "Fragment id mismatch");
+		}
+
+		offset += len - NET_IPV4H_LEN;
+	}
+
+	zassert_equal(offset, UDP_LEN, "Fragments do not cover the packet");
+
+	/* Send the fragments back */
+	for (i = sent_count - 1; i >= 0; i--) {
+		struct net_pkt *frag;
+
+		frag = net_pkt_rx_alloc_with_buffer(iface,
+						    net_pkt_get_len(sent[i]),
+						    AF_INET, 0, K_NO_WAIT);
+		zassert_not_null(frag, "Cannot allocate pkt");
+
+		net_pkt_cursor_init(sent[i]);
+		zassert_equal(net_pkt_copy(frag, sent[i],
+					   net_pkt_get_len(sent[i])), 0,
+			      "Cannot copy fragment");
+
+		net_pkt_unref(sent[i]);
+		sent[i] = NULL;
+
+		net_pkt_cursor_init(frag);
+		net_pkt_set_overwrite(frag, true);
+		net_pkt_set_ip_hdr_len(frag, NET_IPV4H_LEN);
+
+		hdr = (struct net_ipv4_hdr *)net_pkt_get_data(frag,
+							      &ipv4_access);
+		zassert_not_null(hdr, "No IPv4 header");
+
+		net_ipaddr_copy(&hdr->src, &peer_addr);
+		net_ipaddr_copy(&hdr->dst, &my_addr);
+		hdr->chksum = 0U;
+		hdr->chksum = net_calc_chksum_ipv4(frag);
+
+		net_pkt_set_data(frag, &ipv4_access);
+
+		net_pkt_cursor_init(frag);
+		net_pkt_set_overwrite(frag, false);
+
+		zassert_equal(net_recv_data(iface, frag), 0,
+			      "Cannot receive pkt");
+	}
+
+	sent_count = 0;
+
+	expect_recv();
+}
+
+static void test_send_fragmented_error(void)
+{
+	struct in_addr any = { { { 0, 0, 0, 0 } } };
+	struct net_pkt *pkt;
+
+	/* The fragments of a packet to the unspecified address cannot be
+	 * sent, the packet must be dropped and not reported as sent.
+	 */
+	pkt = net_pkt_alloc_with_buffer(iface, UDP_LEN, AF_INET,
+					IPPROTO_UDP, K_NO_WAIT);
+	zassert_not_null(pkt, "Cannot allocate pkt");
+
+	zassert_equal(net_ipv4_create(pkt, &my_addr, &any), 0,
+		      "Cannot create IPv4 header");
+	zassert_equal(net_udp_create(pkt, htons(PEER_PORT), htons(MY_PORT)),
+		      0, "Cannot create UDP header");
+	zassert_equal(net_pkt_write(pkt, payload, sizeof(payload)), 0,
+		      "Cannot write payload");
+
+	net_pkt_cursor_init(pkt);
+	zassert_equal(net_ipv4_finalize(pkt, IPPROTO_UDP), 0,
+		      "Cannot finalize");
+
+	zassert_equal(net_ipv4_prepare_for_send(pkt), NET_DROP,
+		      "Packet not dropped");
+	zassert_equal(atomic_get(&pkt->atomic_ref), 1, "Packet released");
+	zassert_false(net_pkt_sent(pkt), "Packet reported as sent");
+
+	net_pkt_unref(pkt);
+}
+
+static void test_reassembly_throughput(void)
+{
+	uint32_t start, cycles;
+	int i, n;
+
+	start = k_cycle_get_32();
+
+	for (i = 0; i < THROUGHPUT_COUNT; i++) {
+		for (n = 3; n >= 0; n--) {
+			recv_nth_frag(1000 + i, n);
+		}
+
+		expect_recv();
+	}
+
+	cycles = k_cycle_get_32() - start;
+
+	printk("reassembled %d packets of %d fragments in %u cycles\n",
+	       THROUGHPUT_COUNT, 4, cycles);
+
+	zassert_equal(pending(), 0, "Reassembly not released");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(net_ipv4_fragment_test,
+			 ztest_unit_test(test_setup),
+			 ztest_unit_test(test_recv_in_order),
+			 ztest_unit_test(test_recv_reverse_order),
+			 ztest_unit_test(test_recv_out_of_order),
+			 ztest_unit_test(test_recv_duplicate),
+			 ztest_unit_test(test_recv_overlap),
+			 ztest_unit_test(test_recv_too_many_frags),
+			 ztest_unit_test(test_recv_per_source_limit),
+			 ztest_unit_test(test_recv_timeout),
+			 ztest_unit_test(test_send_fragmented),
+			 ztest_unit_test(test_send_fragmented_error),
+			 ztest_unit_test(test_reassembly_throughput)
+			 );
+
+	ztest_run_test_suite(net_ipv4_fragment_test);
+}
@@ -38,6 +38,12 @@ static struct in6_addr peer_addr = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
 					 0, 0, 0, 0, 0, 0, 0, 0x2 } } };
 static struct in6_addr mcast_addr = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
 					  0, 0, 0, 0, 0, 0, 0, 0x1 } } };
+/* On-link prefix of the neighbor cache LRU and pending queue tests */
+static struct in6_addr nbr_prefix = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 1,
+					  0, 0, 0, 0, 0, 0, 0, 0 } } };
+static struct in6_addr nbr_pending_addr = { { { 0x20, 0x01, 0x0d, 0xb8,
+						0, 0, 0, 1, 0, 0, 0, 0,
+						0, 0, 0x10, 0x01 } } };
 
 /* ICMPv6 NS frame (74 bytes) */
 static const unsigned char icmpv6_ns_invalid[] = {
@@ -126,6 +132,7 @@ static uint32_t dad_time[3];
 static bool test_failed;
 static struct k_sem wait_data;
 static bool recv_cb_called;
+static int nbr_pending_sent;
 
 #define WAIT_TIME 250
 #define WAIT_TIME_LONG MSEC_PER_SEC
@@ -236,6 +243,13 @@ static int tester_send(struct device *dev, struct net_pkt *pkt)
 
 	icmp = get_icmp_hdr(pkt);
 
+	/* First frag is the ll header */
+	if (net_ipv6_addr_cmp(&((struct net_ipv6_hdr *)
+				pkt->buffer->frags->data)->dst,
+			      &nbr_pending_addr)) {
+		nbr_pending_sent++;
+	}
+
 	/* Reply with RA messge */
 	if (icmp->type == NET_ICMPV6_RS) {
 		if (expecting_ra) {
@@ -1347,6 +1361,103 @@ static void test_dst_iface_scope_mcast_send(void)
 	net_context_put(ctx);
 }
 
+static void nbr_add_onlink(struct in6_addr *addr, uint8_t id)
+{
+	struct net_linkaddr_storage llstorage = {
+		.addr = { 0x02, 0x00, 0x5e, 0x00, 0x10, id },
+	};
+	struct net_linkaddr lladdr = {
+		.addr = llstorage.addr,
+		.len = 6U,
+		.type = NET_LINK_ETHERNET,
+	};
+	struct net_nbr *nbr;
+
+	net_ipaddr_copy(addr, &nbr_prefix);
+	addr->s6_addr[15] = id;
+
+	nbr = net_ipv6_nbr_add(net_if_get_default(), addr, &lladdr, false,
+			       NET_IPV6_NBR_STATE_REACHABLE);
+	zassert_not_null(nbr, "Cannot add peer %s to neighbor cache",
+			 net_sprint_ipv6_addr(addr));
+}
+
+/**
+ * @brief IPv6 neighbor cache removes the least recently used neighbor
+ */
+static void test_nbr_lru(void)
+{
+	struct in6_addr used, unused, addr;
+	struct net_if *iface = net_if_get_default();
+	int i;
+
+	zassert_not_null(net_if_ipv6_prefix_add(iface, &nbr_prefix, 64,
+						NET_IPV6_ND_INFINITE_LIFETIME),
+			 "Cannot add prefix");
+
+	nbr_add_onlink(&used, 1);
+	nbr_add_onlink(&unused, 2);
+
+	/* Sending to a neighbor makes it the most recently used one */
+	zassert_equal(send_msg(&my_addr, &used), 0, "Send failed");
+
+	for (i = 0; i < CONFIG_NET_IPV6_MAX_NEIGHBORS; i++) {
+		nbr_add_onlink(&addr, 3 + i);
+
+		if (!net_ipv6_nbr_lookup(iface, &unused)) {
+			break;
+		}
+	}
+
+	zassert_true(i < CONFIG_NET_IPV6_MAX_NEIGHBORS,
+		     "Least recently used neighbor not removed");
+	zassert_not_null(net_ipv6_nbr_lookup(iface, &used),
+			 "Recently used neighbor removed");
+}
+
+/**
+ * @brief IPv6 packets are queued until neighbor discovery finishes
+ */
+static void test_nbr_pending_queue(void)
+{
+	struct in6_addr dst;
+	struct net_if *iface = net_if_get_default();
+	struct net_nbr *nbr;
+	int ret;
+	int i;
+
+	/* One more packet than fits in the queue */
+	for (i = 0; i < CONFIG_NET_NBR_PENDING_QUEUE_SIZE + 1; i++) {
+		ret = send_msg(&my_addr, &nbr_pending_addr);
+		zassert_equal(ret, 0, "Send %d failed (%d)", i, ret);
+	}
+
+	nbr = net_ipv6_nbr_lookup(iface, &nbr_pending_addr);
+	zassert_not_null(nbr, "Neighbor not being resolved");
+	zassert_equal(net_ipv6_nbr_data(nbr)->state,
+		      NET_IPV6_NBR_STATE_INCOMPLETE, "Wrong state");
+	zassert_equal(net_ipv6_nbr_data(nbr)->pending.count,
+		      CONFIG_NET_NBR_PENDING_QUEUE_SIZE,
+		      "Wrong number of pending packets");
+
+	/* The NA is looped back by the test driver */
+	net_ipv6_addr_create(&dst, 0xff02, 0, 0, 0, 0, 0, 0, 1);
+
+	ret = net_ipv6_send_na(iface, &nbr_pending_addr, &dst,
+			       &nbr_pending_addr,
+			       NET_ICMPV6_NA_FLAG_OVERRIDE);
+	zassert_false(ret < 0, "Cannot send NA");
+
+	k_sleep(K_MSEC(WAIT_TIME));
+
+	zassert_equal(net_ipv6_nbr_data(nbr)->pending.count, 0,
+		      "Pending packets not sent");
+	zassert_equal(nbr_pending_sent, CONFIG_NET_NBR_PENDING_QUEUE_SIZE,
+		      "Sent %d pending packets", nbr_pending_sent);
+
+	net_if_ipv6_prefix_rm(iface, &nbr_prefix, 64);
+}
+
 void test_main(void)
 {
 	ztest_test_suite(test_ipv6_fn,
@@ -1376,7 +1487,9 @@ void test_main(void)
 			 ztest_unit_test(test_dst_zero_scope_mcast_recv),
 			 ztest_unit_test(test_dst_site_scope_mcast_recv_drop),
 			 ztest_unit_test(test_dst_site_scope_mcast_recv_ok),
-			 ztest_unit_test(test_dst_org_scope_mcast_recv)
+			 ztest_unit_test(test_dst_org_scope_mcast_recv),
+			 ztest_unit_test(test_nbr_lru),
+			 ztest_unit_test(test_nbr_pending_queue)
 			 );
 	ztest_run_test_suite(test_ipv6_fn);
 }
@@ -1454,6 +1454,119 @@ done:
 	return result;
 }
 
+static int index_resource_get(struct coap_resource *resource,
+			      struct coap_packet *request,
+			      struct sockaddr *addr, socklen_t addr_len)
+{
+	resource->age++;
+
+	return 0;
+}
+
+static const char * const index_path_s1[] = { "s", "1", NULL };
+static const char * const index_path_s2[] = { "s", "2", NULL };
+static const char * const index_path_s[] = { "s", NULL };
+static const char * const index_path_root[] = { NULL };
+static struct coap_resource index_resources[] = {
+	{ .path = index_path_s1, .get = index_resource_get },
+	{ .path = index_path_s2, .get = index_resource_get },
+	{ .path = index_path_s, .get = index_resource_get },
+	{ .path = index_path_root, .get = index_resource_get },
+	/* Shadowed by the first resource */
+	{ .path = index_path_s1, .get = index_resource_get },
+	{ },
+};
+
+COAP_RESOURCE_INDEX_DEFINE(resource_index, index_resources, 8);
+COAP_RESOURCE_INDEX_DEFINE(small_index, index_resources, 5);
+
+static int index_request(uint8_t method, const char * const *path)
+{
+	struct coap_packet req;
+	struct coap_option options[4];
+	uint8_t data[COAP_BUF_SIZE];
+	int r;
+
+	r = coap_packet_init(&req, data, sizeof(data), 1, COAP_TYPE_CON,
+			     0, NULL, method, coap_next_id());
+	if (r < 0) {
+		return r;
+	}
+
+	for (; *path; path++) {
+		r = coap_packet_append_option(&req, COAP_OPTION_URI_PATH,
+					      *path, strlen(*path));
+		if (r < 0) {
+			return r;
+		}
+	}
+
+	r = coap_packet_parse(&req, data, req.offset, options,
+			      ARRAY_SIZE(options));
+	if (r < 0) {
+		return r;
+	}
+
+	return coap_handle_request_index(&req, &resource_index, options,
+					 ARRAY_SIZE(options),
+					 (struct sockaddr *)&dummy_addr,
+					 sizeof(dummy_addr));
+}
+
+static int test_resource_index(void)
+{
+	static const char * const unknown_path[] = { "s", "3", NULL };
+	static const char * const long_path[] = { "s", "1", "x", NULL };
+	int result = TC_FAIL;
+	int i;
+
+	if (coap_resource_index_build(&small_index) != -ENOMEM) {
+		TC_PRINT("The index should be too small\n");
+		goto done;
+	}
+
+	if (coap_resource_index_build(&resource_index) < 0) {
+		TC_PRINT("Could not build the index\n");
+		goto done;
+	}
+
+	for (i = 0; i < 4; i++) {
+		if (index_request(COAP_METHOD_GET,
+				  index_resources[i].path) < 0) {
+			TC_PRINT("Resource %d not found\n", i);
+			goto done;
+		}
+
+		if (index_resources[i].age != 1) {
+			TC_PRINT("Resource %d was not called\n", i);
+			goto done;
+		}
+	}
+
+	if (index_resources[4].age != 0) {
+		TC_PRINT("The shadowed resource was called\n");
+		goto done;
+	}
+
+	if (index_request(COAP_METHOD_GET, unknown_path) != -ENOENT ||
+	    index_request(COAP_METHOD_GET, long_path) != -ENOENT) {
+		TC_PRINT("Unknown paths should not be found\n");
+		goto done;
+	}
+
+	if (index_request(COAP_METHOD_POST, index_path_s1) != -EPERM) {
+		TC_PRINT("POST should not be allowed\n");
+		goto done;
+	}
+
+	result = TC_PASS;
+
+done:
+	TC_END_RESULT(result);
+
+	return result;
+}
+
 static const struct {
 	const char *name;
 	int (*func)(void);
@@ -1476,6 +1589,7 @@ static const struct {
 	{ "Test retransmission", test_retransmit_second_round, },
 	{ "Test observer server", test_observer_server, },
 	{ "Test observer client", test_observer_client, },
+	{ "Test resource index", test_resource_index, },
 };
 
 void main(void)
@@ -0,0 +1,480 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, CONFIG_COAP_LOG_LEVEL);
+
+#include <ztest.h>
+#include <net/socket.h>
+#include <net/coap.h>
+#include <net/coap_client.h>
+
+/* The test acts as the CoAP server on a second loopback socket */
+
+#define SERVER_PORT 15683
+#define WAIT_MS 2000
+#define MAX_MSG_SIZE 128
+#define LARGE_SIZE 200
+
+struct response {
+	int result;
+	int calls;
+	bool last;
+	size_t len;
+	uint8_t data[LARGE_SIZE];
+};
+
+static struct coap_client client;
+static int client_sock;
+static int server_sock;
+
+static struct sockaddr_in server_addr = {
+	.sin_family = AF_INET,
+	.sin_port = htons(SERVER_PORT),
+	.sin_addr = { { { 127, 0, 0, 1 } } },
+};
+
+static struct sockaddr client_addr;
+static socklen_t client_addrlen;
+
+static uint8_t rx_buf[MAX_MSG_SIZE];
+static uint8_t tx_buf[MAX_MSG_SIZE];
+static uint8_t large[LARGE_SIZE];
+
+static struct response resp;
+static int order[CONFIG_COAP_CLIENT_MAX_REQUESTS];
+static int order_len;
+
+static void response_cb(int result, size_t offset, const uint8_t *payload,
+			size_t len, bool last, void *user_data)
+{
+	struct response *r = user_data;
+
+	r->result = result;
+	r->calls++;
+	r->last = last;
+
+	if (payload && offset + len <= sizeof(r->data)) {
+		memcpy(r->data + offset, payload, len);
+		r->len = offset + len;
+	}
+}
+
+static void order_cb(int result, size_t offset, const uint8_t *payload,
+		     size_t len, bool last, void *user_data)
+{
+	order[order_len++] = POINTER_TO_INT(user_data);
+}
+
+static int request(const char *path, uint8_t method, bool confirmable,
+		   const uint8_t *payload, size_t len)
+{
+	struct coap_client_request req = {
+		.method = method,
+		.confirmable = confirmable,
+		.path = path,
+		.fmt = -1,
+		.payload = payload,
+		.len = len,
+		.cb = response_cb,
+		.user_data = &resp,
+	};
+
+	memset(&resp, 0, sizeof(resp));
+
+	return coap_client_req(&client, &req);
+}
+
+/* Receive a message on the server socket, running the client meanwhile */
+static int server_recv(struct coap_packet *cpkt, int32_t timeout)
+{
+	struct pollfd fds = {
+		.fd = server_sock,
+		.events = POLLIN,
+	};
+	int64_t end = k_uptime_get() + timeout;
+	int len;
+
+	do {
+		(void)coap_client_process(&client);
+
+		if (poll(&fds, 1, 10) > 0) {
+			client_addrlen = sizeof(client_addr);
+			len = recvfrom(server_sock, rx_buf, sizeof(rx_buf), 0,
+				       &client_addr, &client_addrlen);
+			zassert_true(len > 0, "recvfrom failed (%d)", errno);
+
+			return coap_packet_parse(cpkt, rx_buf, len, NULL, 0);
+		}
+	} while (k_uptime_get() < end);
+
+	return -EAGAIN;
+}
+
+static void server_send(const struct coap_packet *req, uint8_t type,
+			uint8_t code, uint16_t block_opt, int block,
+			const uint8_t *payload, uint16_t len)
+{
+	struct coap_packet cpkt;
+	uint8_t token[8];
+	uint8_t tkl;
+	uint16_t id;
+	int r;
+
+	tkl = coap_header_get_token(req, token);
+	id = type == COAP_TYPE_ACK || type == COAP_TYPE_RESET ?
+	     coap_header_get_id(req) : coap_next_id();
+
+	if (code == COAP_CODE_EMPTY) {
+		tkl = 0U;
+	}
+
+	r = coap_packet_init(&cpkt, tx_buf, sizeof(tx_buf), 1, type, tkl,
+			     token, code, id);
+	zassert_equal(r, 0, "Cannot build the response");
+
+	if (block >= 0) {
+		r = coap_append_option_int(&cpkt, block_opt, block);
+		zassert_equal(r, 0, "Cannot add the block option");
+	}
+
+	if (len) {
+		r = coap_packet_append_payload_marker(&cpkt);
+		zassert_equal(r, 0, "Cannot add the payload marker");
+		r = coap_packet_append_payload(&cpkt, (uint8_t *)payload, len);
+		zassert_equal(r, 0, "Cannot add the payload");
+	}
+
+	r = sendto(server_sock, tx_buf, cpkt.offset, 0, &client_addr,
+		   client_addrlen);
+	zassert_equal(r, cpkt.offset, "sendto failed (%d)", errno);
+}
+
+static void reply(const struct coap_packet *req, uint8_t code,
+		  const char *payload)
+{
+	server_send(req, COAP_TYPE_ACK, code, 0, -1, (const uint8_t *)payload,
+		    payload ? strlen(payload) : 0);
+}
+
+static void client_wait(void)
+{
+	zassert_equal(coap_client_wait(&client, WAIT_MS), 0,
+		      "The requests are not done");
+}
+
+static void test_init(void)
+{
+	int r;
+
+	server_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	zassert_true(server_sock >= 0, "Cannot create the server socket");
+
+	r = bind(server_sock, (struct sockaddr *)&server_addr,
+		 sizeof(server_addr));
+	zassert_equal(r, 0, "Cannot bind the server socket (%d)", errno);
+
+	client_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	zassert_true(client_sock >= 0, "Cannot create the client socket");
+
+	r = coap_client_init(&client, client_sock,
+			     (struct sockaddr *)&server_addr,
+			     sizeof(server_addr));
+	zassert_equal(r, 0, "Cannot initialize the client");
+
+	for (r = 0; r < sizeof(large); r++) {
+		large[r] = r;
+	}
+}
+
+static void test_piggybacked(void)
+{
+	struct coap_option options[3];
+	struct coap_packet req;
+	int r;
+
+	zassert_equal(request("/sensors/temp", COAP_METHOD_GET, true, NULL, 0),
+		      0, "Cannot send the request");
+
+	zassert_equal(server_recv(&req, WAIT_MS), 0, "No request");
+	zassert_equal(coap_header_get_type(&req), COAP_TYPE_CON,
+		      "Not confirmable");
+	zassert_equal(coap_header_get_code(&req), COAP_METHOD_GET, "Not GET");
+
+	r = coap_find_options(&req, COAP_OPTION_URI_PATH, options,
+			      ARRAY_SIZE(options));
+	zassert_equal(r, 2, "Wrong number of path segments");
+	zassert_true(options[0].len == 7 &&
+		     !memcmp(options[0].value, "sensors", 7), "Wrong path");
+	zassert_true(options[1].len == 4 &&
+		     !memcmp(options[1].value, "temp", 4), "Wrong path");
+
+	reply(&req, COAP_RESPONSE_CODE_CONTENT, "21.5");
+	client_wait();
+
+	zassert_equal(resp.result, COAP_RESPONSE_CODE_CONTENT, "Wrong code");
+	zassert_equal(resp.calls, 1, "Wrong number of callbacks");
+	zassert_true(resp.last, "Not the last callback");
+	zassert_true(resp.len == 4 && !memcmp(resp.data, "21.5", 4),
+		     "Wrong payload");
+}
+
+static void test_retransmission(void)
+{
+	struct coap_packet req, retry;
+	uint8_t token[8], retry_token[8];
+
+	zassert_equal(request("a", COAP_METHOD_GET, true, NULL, 0), 0,
+		      "Cannot send the request");
+
+	zassert_equal(server_recv(&req, WAIT_MS), 0, "No request");
+	coap_header_get_token(&req, token);
+
+	zassert_equal(server_recv(&retry, WAIT_MS), 0, "No retransmission");
+	coap_header_get_token(&retry, retry_token);
+
+	zassert_equal(coap_header_get_id(&req), coap_header_get_id(&retry),
+		      "The retransmission has another ID");
+	zassert_mem_equal(token, retry_token, sizeof(token),
+			  "The retransmission has another token");
+
+	reply(&retry, COAP_RESPONSE_CODE_CONTENT, NULL);
+	client_wait();
+
+	zassert_equal(resp.result, COAP_RESPONSE_CODE_CONTENT, "Wrong code");
+}
+
+static void test_timeout(void)
+{
+	struct coap_packet req;
+	int i;
+
+	zassert_equal(request("a", COAP_METHOD_GET, true, NULL, 0), 0,
+		      "Cannot send the request");
+
+	for (i = 0; i <= CONFIG_COAP_CLIENT_MAX_RETRANSMIT; i++) {
+		zassert_equal(server_recv(&req, WAIT_MS), 0,
+			      "No transmission %d", i);
+	}
+
+	client_wait();
+
+	zassert_equal(resp.result, -ETIMEDOUT, "The request did not time out");
+	zassert_equal(server_recv(&req, 100), -EAGAIN,
+		      "Too many retransmissions");
+}
+
+static void test_separate(void)
+{
+	struct coap_packet req, ack;
+
+	zassert_equal(request("a", COAP_METHOD_GET, true, NULL, 0), 0,
+		      "Cannot send the request");
+
+	zassert_equal(server_recv(&req, WAIT_MS), 0, "No request");
+	server_send(&req, COAP_TYPE_ACK, COAP_CODE_EMPTY, 0, -1, NULL, 0);
+
+	/* An acknowledged request is not retransmitted */
+	zassert_equal(server_recv(&ack, 500), -EAGAIN,
+		      "The request was retransmitted");
+
+	server_send(&req, COAP_TYPE_CON, COAP_RESPONSE_CODE_CONTENT, 0, -1,
+		    (const uint8_t *)"late", 4);
+	client_wait();
+
+	zassert_equal(resp.result, COAP_RESPONSE_CODE_CONTENT, "Wrong code");
+	zassert_true(resp.len == 4 && !memcmp(resp.data, "late", 4),
+		     "Wrong payload");
+
+	zassert_equal(server_recv(&ack, WAIT_MS), 0, "No ACK");
+	zassert_equal(coap_header_get_type(&ack), COAP_TYPE_ACK, "Not an ACK");
+	zassert_equal(coap_header_get_code(&ack), COAP_CODE_EMPTY,
+		      "Not empty");
+}
+
+static void test_reset(void)
+{
+	struct coap_packet req;
+
+	zassert_equal(request("a", COAP_METHOD_GET, true, NULL, 0), 0,
+		      "Cannot send the request");
+
+	zassert_equal(server_recv(&req, WAIT_MS), 0, "No request");
+	server_send(&req, COAP_TYPE_RESET, COAP_CODE_EMPTY, 0, -1, NULL, 0);
+	client_wait();
+
+	zassert_equal(resp.result, -ECONNRESET, "The request was not reset");
+}
+
+static void test_nstart(void)
+{
+	struct coap_client_request req = {
+		.method = COAP_METHOD_GET,
+		.path = "a",
+		.fmt = -1,
+		.cb = order_cb,
+	};
+	struct coap_packet msg;
+	int i;
+
+	order_len = 0;
+
+	for (i = 0; i < CONFIG_COAP_CLIENT_MAX_REQUESTS; i++) {
+		req.user_data = INT_TO_POINTER(i);
+		zassert_equal(coap_client_req(&client, &req), 0,
+			      "Cannot send request %d", i);
+	}
+
+	for (i = 0; i < CONFIG_COAP_CLIENT_MAX_REQUESTS; i++) {
+		zassert_equal(server_recv(&msg, WAIT_MS), 0,
+			      "No request %d", i);
+
+		/* Only CONFIG_COAP_CLIENT_NSTART requests are outstanding */
+		zassert_equal(server_recv(&msg, 200), -EAGAIN,
+			      "Too many outstanding requests");
+
+		server_send(&msg, COAP_TYPE_NON_CON,
+			    COAP_RESPONSE_CODE_CONTENT, 0, -1, NULL, 0);
+	}
+
+	client_wait();
+
+	zassert_equal(order_len, CONFIG_COAP_CLIENT_MAX_REQUESTS,
+		      "Missing responses");
+
+	for (i = 0; i < order_len; i++) {
+		zassert_equal(order[i], i, "Requests out of order");
+	}
+}
+
+static void test_no_slot(void)
+{
+	struct coap_packet msg;
+	int i;
+
+	for (i = 0; i < CONFIG_COAP_CLIENT_MAX_REQUESTS; i++) {
+		zassert_equal(request("a", COAP_METHOD_GET, false, NULL, 0),
+			      0, "Cannot send request %d", i);
+	}
+
+	zassert_equal(request("a", COAP_METHOD_GET, false, NULL, 0), -ENOMEM,
+		      "Too many requests accepted");
+
+	coap_client_cancel(&client);
+
+	zassert_equal(resp.result, -ECANCELED, "Not cancelled");
+	zassert_equal(coap_client_process(&client), SYS_FOREVER_MS,
+		      "Requests left");
+
+	zassert_equal(server_recv(&msg, WAIT_MS), 0, "No request");
+}
+
+static void test_block2(void)
+{
+	struct coap_packet req;
+	size_t offset;
+	uint16_t len;
+	int block;
+	bool more;
+
+	zassert_equal(request("large", COAP_METHOD_GET, true, NULL, 0), 0,
+		      "Cannot send the request");
+
+	do {
+		zassert_equal(server_recv(&req, WAIT_MS), 0, "No request");
+
+		block = coap_get_option_int(&req, COAP_OPTION_BLOCK2);
+		offset = block < 0 ? 0 : (block >> 4) * 64;
+		zassert_true(block < 0 || (block & 0x7) == COAP_BLOCK_64,
+			     "Wrong block size");
+
+		len = MIN(64, sizeof(large) - offset);
+		more = offset + len < sizeof(large);
+
+		server_send(&req, COAP_TYPE_ACK, COAP_RESPONSE_CODE_CONTENT,
+			    COAP_OPTION_BLOCK2,
+			    ((offset / 64) << 4) | (more << 3) | COAP_BLOCK_64,
+			    large + offset, len);
+	} while (more);
+
+	client_wait();
+
+	zassert_equal(resp.result, COAP_RESPONSE_CODE_CONTENT, "Wrong code");
+	zassert_equal(resp.calls, 4, "Wrong number of callbacks");
+	zassert_true(resp.last, "Not the last callback");
+	zassert_equal(resp.len, sizeof(large), "Wrong length");
+	zassert_mem_equal(resp.data, large, sizeof(large), "Wrong payload");
+}
+
+static void test_block1(void)
+{
+	static uint8_t received[LARGE_SIZE];
+	struct coap_packet req;
+	const uint8_t *payload;
+	size_t offset;
+	uint16_t len;
+	int blocks = 0;
+	int block;
+
+	zassert_equal(request("upload", COAP_METHOD_PUT, true, large,
+			      sizeof(large)), 0, "Cannot send the request");
+
+	do {
+		zassert_equal(server_recv(&req, WAIT_MS), 0, "No block");
+
+		block = coap_get_option_int(&req, COAP_OPTION_BLOCK1);
+		zassert_true(block >= 0, "No Block1 option");
+
+		if (!blocks) {
+			zassert_equal(coap_get_option_int(&req,
+							  COAP_OPTION_SIZE1),
+				      sizeof(large), "Wrong Size1 option");
+		}
+
+		offset = (block >> 4) << ((block & 0x7) + 4);
+		payload = coap_packet_get_payload(&req, &len);
+		zassert_true(offset + len <= sizeof(received), "Too long");
+		memcpy(received + offset, payload, len);
+		blocks++;
+
+		/* Ask for blocks of 32 bytes after the first one */
+		if (block & 0x8) {
+			server_send(&req, COAP_TYPE_ACK,
+				    COAP_RESPONSE_CODE_CONTINUE,
+				    COAP_OPTION_BLOCK1,
+				    (block & ~0x7) | COAP_BLOCK_32, NULL, 0);
+		} else {
+			server_send(&req, COAP_TYPE_ACK,
+				    COAP_RESPONSE_CODE_CHANGED,
+				    COAP_OPTION_BLOCK1, block, NULL, 0);
+		}
+	} while (block & 0x8);
+
+	client_wait();
+
+	zassert_equal(resp.result, COAP_RESPONSE_CODE_CHANGED, "Wrong code");
+	zassert_equal(resp.calls, 1, "Wrong number of callbacks");
+	/* One block of 64 bytes, then 136 bytes in blocks of 32 */
+	zassert_equal(blocks, 6, "Wrong number of blocks");
+	zassert_mem_equal(received, large, sizeof(large), "Wrong payload");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(coap_client,
+			 ztest_unit_test(test_init),
+			 ztest_unit_test(test_piggybacked),
+			 ztest_unit_test(test_retransmission),
+			 ztest_unit_test(test_timeout),
+			 ztest_unit_test(test_separate),
+			 ztest_unit_test(test_reset),
+			 ztest_unit_test(test_nstart),
+			 ztest_unit_test(test_no_slot),
+			 ztest_unit_test(test_block2),
+			 ztest_unit_test(test_block1));
+
+	ztest_run_test_suite(coap_client);
+}
@@ -0,0 +1,422 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, CONFIG_DNS_RESOLVER_LOG_LEVEL);
+
+#include <ztest.h>
+#include <strings.h>
+#include <sys/byteorder.h>
+#include <net/socket.h>
+#include <net/dns_resolve.h>
+
+#define STACK_SIZE (1024 + CONFIG_TEST_EXTRA_STACKSIZE)
+#define THREAD_PRIORITY K_PRIO_COOP(8)
+#define DNS_TIMEOUT 1000 /* ms */
+#define MAX_MSG_SIZE 256
+#define MAX_RESULTS 4
+
+#define DNS_TYPE_A 1
+#define DNS_TYPE_AAAA 28
+#define DNS_RCODE_NXDOMAIN 3
+
+/* What the local DNS server answers */
+struct dns_record {
+	const char *name;
+	uint16_t type;
+	uint8_t rcode;
+	uint32_t ttl;
+	const char *addr[3];
+};
+
+static const struct dns_record records[] = {
+	{ "two.example.com", DNS_TYPE_A, 0, 60, { "192.0.2.1", "192.0.2.2" } },
+	{ "two.example.com", DNS_TYPE_AAAA, 0, 60, { "2001:db8::1" } },
+	{ "three.example.com", DNS_TYPE_A, 0, 60,
+	  { "192.0.2.1", "192.0.2.2", "192.0.2.3" } },
+	{ "short.example.com", DNS_TYPE_A, 0, 1, { "192.0.2.4" } },
+	{ "nocache.example.com", DNS_TYPE_A, 0, 0, { "192.0.2.5" } },
+	{ "missing.example.com", DNS_TYPE_A, DNS_RCODE_NXDOMAIN, 0, { } },
+	{ "noaddr.example.com", DNS_TYPE_A, 0, 60, { } },
+	{ "e1.example.com", DNS_TYPE_A, 0, 60, { "192.0.2.11" } },
+	{ "e2.example.com", DNS_TYPE_A, 0, 60, { "192.0.2.12" } },
+	{ "e3.example.com", DNS_TYPE_A, 0, 60, { "192.0.2.13" } },
+	{ "e4.example.com", DNS_TYPE_A, 0, 60, { "192.0.2.14" } },
+	{ "e5.example.com", DNS_TYPE_A, 0, 60, { "192.0.2.15" } },
+};
+
+static uint8_t msg[MAX_MSG_SIZE];
+static int queries;
+
+static struct dns_result {
+	struct sockaddr addr[MAX_RESULTS];
+	int count;
+	int status;
+} result;
+
+static K_SEM_DEFINE(result_sem, 0, 1);
+
+static const struct dns_record *find_record(const char *name, uint16_t type)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(records); i++) {
+		if (records[i].type == type &&
+		    !strncasecmp(records[i].name, name,
+				 strlen(records[i].name) + 1)) {
+			return &records[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* Turn the query in msg into its answer, return the answer length */
+static int build_answer(int len)
+{
+	const struct dns_record *record;
+	char name[64];
+	int name_len = 0;
+	int pos = 12;
+	uint16_t type;
+	int i;
+
+	while (pos < len && msg[pos]) {
+		if (name_len) {
+			name[name_len++] = '.';
+		}
+
+		if (name_len + msg[pos] >= sizeof(name) - 1) {
+			return -EINVAL;
+		}
+
+		memcpy(&name[name_len], &msg[pos + 1], msg[pos]);
+		name_len += msg[pos];
+		pos += msg[pos] + 1;
+	}
+
+	name[name_len] = '\0';
+
+	/* Zero label, type and class */
+	pos += 5;
+	if (pos > len) {
+		return -EINVAL;
+	}
+
+	type = (msg[pos - 4] << 8) | msg[pos - 3];
+
+	queries++;
+
+	record = find_record(name, type);
+
+	msg[2] = 0x81; /* Response, recursion desired */
+	msg[3] = 0x80 | (record ? record->rcode : DNS_RCODE_NXDOMAIN);
+	msg[6] = msg[7] = 0U;
+	msg[8] = msg[9] = msg[10] = msg[11] = 0U;
+
+	for (i = 0; record && i < ARRAY_SIZE(record->addr) &&
+		     record->addr[i]; i++) {
+		int addr_len = type == DNS_TYPE_A ? 4 : 16;
+
+		msg[7]++;
+
+		/* Pointer to the query name */
+		msg[pos++] = 0xc0;
+		msg[pos++] = 12;
+		sys_put_be16(type, &msg[pos]);
+		sys_put_be16(1, &msg[pos + 2]);
+		sys_put_be32(record->ttl, &msg[pos + 4]);
+		sys_put_be16(addr_len, &msg[pos + 8]);
+		pos += 10;
+
+		zassert_equal(net_addr_pton(type == DNS_TYPE_A ?
+					    AF_INET : AF_INET6,
+					    record->addr[i], &msg[pos]), 0,
+			      "Invalid address %s", record->addr[i]);
+		pos += addr_len;
+	}
+
+	return pos;
+}
+
+static void dns_server(void)
+{
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_port = htons(15353),
+		.sin_addr = INADDR_ANY_INIT,
+	};
+	struct sockaddr peer;
+	socklen_t peer_len;
+	int sock;
+	int len;
+
+	sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	zassert_true(sock >= 0, "Cannot create socket (%d)", errno);
+
+	zassert_equal(bind(sock, (struct sockaddr *)&addr, sizeof(addr)), 0,
+		      "Cannot bind (%d)", errno);
+
+	while (true) {
+		peer_len = sizeof(peer);
+
+		len = recvfrom(sock, msg, sizeof(msg), 0, &peer, &peer_len);
+		if (len < 12) {
+			continue;
+		}
+
+		len = build_answer(len);
+		if (len < 0) {
+			continue;
+		}
+
+		(void)sendto(sock, msg, len, 0, &peer, peer_len);
+	}
+}
+
+K_THREAD_DEFINE(dns_server_id, STACK_SIZE, dns_server, NULL, NULL, NULL,
+		THREAD_PRIORITY, 0, 0);
+
+static void dns_result_cb(enum dns_resolve_status status,
+			  struct dns_addrinfo *info, void *user_data)
+{
+	if (status == DNS_EAI_INPROGRESS) {
+		if (result.count < MAX_RESULTS) {
+			memcpy(&result.addr[result.count], &info->ai_addr,
+			       sizeof(struct sockaddr));
+		}
+
+		result.count++;
+		return;
+	}
+
+	result.status = status;
+	k_sem_give(&result_sem);
+}
+
+static void resolve(const char *name, enum dns_query_type type,
+		    int expected_status, int expected_count)
+{
+	int ret;
+
+	(void)memset(&result, 0, sizeof(result));
+	k_sem_reset(&result_sem);
+
+	ret = dns_get_addr_info(name, type, NULL, dns_result_cb, NULL,
+				DNS_TIMEOUT);
+	zassert_equal(ret, 0, "Cannot resolve %s (%d)", name, ret);
+
+	zassert_equal(k_sem_take(&result_sem, K_MSEC(DNS_TIMEOUT * 2)), 0,
+		      "No result for %s", name);
+
+	zassert_equal(result.status, expected_status,
+		      "Invalid status %d for %s", result.status, name);
+	zassert_equal(result.count, expected_count,
+		      "Invalid address count %d for %s", result.count, name);
+}
+
+static void check_ipv4(int idx, const char *expected)
+{
+	struct in_addr addr;
+
+	zassert_equal(net_addr_pton(AF_INET, expected, &addr), 0, "");
+	zassert_equal(result.addr[idx].sa_family, AF_INET,
+		      "Invalid family of address %d", idx);
+	zassert_true(net_ipv4_addr_cmp(&net_sin(&result.addr[idx])->sin_addr,
+				       &addr),
+		     "Address %d is not %s", idx, expected);
+}
+
+static void count_cb(const struct dns_cache_entry *entry, void *user_data)
+{
+	(*(int *)user_data)++;
+}
+
+static int cache_entries(void)
+{
+	int count = 0;
+
+	dns_cache_foreach(count_cb, &count);
+
+	return count;
+}
+
+static void test_positive(void)
+{
+	struct dns_cache_stats before, after;
+
+	dns_cache_flush();
+	queries = 0;
+
+	resolve("two.example.com", DNS_QUERY_TYPE_A, DNS_EAI_ALLDONE, 2);
+	check_ipv4(0, "192.0.2.1");
+	check_ipv4(1, "192.0.2.2");
+	zassert_equal(queries, 1, "Query not sent");
+
+	dns_cache_get_stats(&before);
+
+	resolve("two.example.com", DNS_QUERY_TYPE_A, DNS_EAI_ALLDONE, 2);
+	check_ipv4(0, "192.0.2.1");
+	check_ipv4(1, "192.0.2.2");
+	zassert_equal(queries, 1, "Query sent for a cached name");
+
+	/* Names are case insensitive */
+	resolve("TWO.Example.com", DNS_QUERY_TYPE_A, DNS_EAI_ALLDONE, 2);
+	zassert_equal(queries, 1, "Query sent for a cached name");
+
+	dns_cache_get_stats(&after);
+	zassert_equal(after.hits, before.hits + 2, "Hits not counted");
+	zassert_equal(after.misses, before.misses, "Invalid misses");
+}
+
+static void test_max_addrs(void)
+{
+	dns_cache_flush();
+	queries = 0;
+
+	resolve("three.example.com", DNS_QUERY_TYPE_A, DNS_EAI_ALLDONE, 3);
+	resolve("three.example.com", DNS_QUERY_TYPE_A, DNS_EAI_ALLDONE,
+		CONFIG_DNS_RESOLVER_CACHE_MAX_ADDRS);
+	zassert_equal(queries, 1, "Query sent for a cached name");
+	check_ipv4(0, "192.0.2.1");
+	check_ipv4(1, "192.0.2.2");
+}
+
+static void test_query_type(void)
+{
+	dns_cache_flush();
+	queries = 0;
+
+	resolve("two.example.com", DNS_QUERY_TYPE_A, DNS_EAI_ALLDONE, 2);
+	resolve("two.example.com", DNS_QUERY_TYPE_AAAA, DNS_EAI_ALLDONE, 1);
+	zassert_equal(queries, 2, "AAAA answered from the A entry");
+
+	resolve("two.example.com", DNS_QUERY_TYPE_AAAA, DNS_EAI_ALLDONE, 1);
+	zassert_equal(queries, 2, "Query sent for a cached name");
+	zassert_equal(result.addr[0].sa_family, AF_INET6, "Not IPv6");
+}
+
+static void test_negative(void)
+{
+	struct dns_cache_stats before, after;
+
+	dns_cache_flush();
+	queries = 0;
+
+	resolve("missing.example.com", DNS_QUERY_TYPE_A, DNS_EAI_NONAME, 0);
+	zassert_equal(queries, 1, "Query not sent");
+
+	dns_cache_get_stats(&before);
+
+	/* A cached name error is not reported as an empty answer */
+	resolve("missing.example.com", DNS_QUERY_TYPE_A, DNS_EAI_NONAME, 0);
+	zassert_equal(queries, 1, "Query sent for a cached name");
+
+	dns_cache_get_stats(&after);
+	zassert_equal(after.negative_hits, before.negative_hits + 1,
+		      "Negative hit not counted");
+
+	/* The name exists, but has no address of the queried type */
+	resolve("noaddr.example.com", DNS_QUERY_TYPE_A, DNS_EAI_NODATA, 0);
+	zassert_equal(queries, 2, "Query not sent");
+
+	resolve("noaddr.example.com", DNS_QUERY_TYPE_A, DNS_EAI_NODATA, 0);
+	zassert_equal(queries, 2, "Query sent for a cached name");
+
+	dns_cache_get_stats(&after);
+	zassert_equal(after.negative_hits, before.negative_hits + 2,
+		      "Negative hit not counted");
+}
+
+static void test_ttl(void)
+{
+	dns_cache_flush();
+	queries = 0;
+
+	/* A zero TTL answer is not cached */
+	resolve("nocache.example.com", DNS_QUERY_TYPE_A, DNS_EAI_ALLDONE, 1);
+	resolve("nocache.example.com", DNS_QUERY_TYPE_A, DNS_EAI_ALLDONE, 1);
+	zassert_equal(queries, 2, "Zero TTL answer was cached");
+	zassert_equal(cache_entries(), 0, "Zero TTL answer was cached");
+
+	resolve("short.example.com", DNS_QUERY_TYPE_A, DNS_EAI_ALLDONE, 1);
+	resolve("short.example.com", DNS_QUERY_TYPE_A, DNS_EAI_ALLDONE, 1);
+	zassert_equal(queries, 3, "Query sent for a cached name");
+
+	k_sleep(K_MSEC(1100));
+
+	zassert_equal(cache_entries(), 0, "Entry did not expire");
+
+	resolve("short.example.com", DNS_QUERY_TYPE_A, DNS_EAI_ALLDONE, 1);
+	zassert_equal(queries, 4, "Expired answer was used");
+}
+
+static void test_flush(void)
+{
+	resolve("two.example.com", DNS_QUERY_TYPE_A, DNS_EAI_ALLDONE, 2);
+	zassert_true(cache_entries() > 0, "Answer not cached");
+
+	dns_cache_flush();
+	zassert_equal(cache_entries(), 0, "Cache not flushed");
+
+	queries = 0;
+
+	resolve("two.example.com", DNS_QUERY_TYPE_A, DNS_EAI_ALLDONE, 2);
+	zassert_equal(queries, 1, "Flushed answer was used");
+}
+
+static void test_eviction(void)
+{
+	static const char * const names[] = {
+		"e1.example.com", "e2.example.com", "e3.example.com",
+		"e4.example.com", "e5.example.com",
+	};
+	struct dns_cache_stats before, after;
+	int i;
+
+	dns_cache_flush();
+	dns_cache_get_stats(&before);
+
+	for (i = 0; i < ARRAY_SIZE(names); i++) {
+		resolve(names[i], DNS_QUERY_TYPE_A, DNS_EAI_ALLDONE, 1);
+
+		/* Make the expiry times differ */
+		k_sleep(K_MSEC(10));
+	}
+
+	zassert_equal(cache_entries(), CONFIG_DNS_RESOLVER_CACHE_MAX_ENTRIES,
+		      "Cache is not bounded");
+
+	dns_cache_get_stats(&after);
+	zassert_equal(after.added - before.added, ARRAY_SIZE(names), "");
+	zassert_equal(after.evicted - before.evicted,
+		      ARRAY_SIZE(names) - CONFIG_DNS_RESOLVER_CACHE_MAX_ENTRIES,
+		      "Evictions not counted");
+
+	/* The oldest entry made room for the last one */
+	queries = 0;
+
+	resolve(names[ARRAY_SIZE(names) - 1], DNS_QUERY_TYPE_A,
+		DNS_EAI_ALLDONE, 1);
+	zassert_equal(queries, 0, "Newest entry was evicted");
+
+	resolve(names[0], DNS_QUERY_TYPE_A, DNS_EAI_ALLDONE, 1);
+	zassert_equal(queries, 1, "Oldest entry was not evicted");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(dns_cache,
+			 ztest_unit_test(test_positive),
+			 ztest_unit_test(test_max_addrs),
+			 ztest_unit_test(test_query_type),
+			 ztest_unit_test(test_negative),
+			 ztest_unit_test(test_ttl),
+			 ztest_unit_test(test_flush),
+			 ztest_unit_test(test_eviction));
+
+	ztest_run_test_suite(dns_cache);
+}
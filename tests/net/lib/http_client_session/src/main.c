@@ -0,0 +1,468 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <ztest.h>
+#include <net/socket.h>
+#include <net/http_server.h>
+#include <net/http_client_session.h>
+#include <storage/flash_map.h>
+#include <storage/stream_flash.h>
+#include <drivers/flash.h>
+
+#define SERVER_PORT 8080
+#define PEER_PORT 8081
+#define SERVER_STACK_SIZE 2048
+#define WAIT_TIMEOUT 2000
+
+/* Larger than CONFIG_HTTP_CLIENT_SESSION_BUF_SIZE, so it is received in
+ * several fragments
+ */
+#define FLASH_CONTENT_LEN 1000
+#define FLASH_DOWNLOAD_OFFSET 0x2000
+
+static const char index_html[] = "<html>hello</html>";
+
+static int echo_handler(struct http_server_conn *conn,
+			const struct http_server_request *req,
+			void *user_data)
+{
+	return http_server_respond(conn, 200, "text/plain", req->body,
+				   req->body_len);
+}
+
+static const struct http_server_route routes[] = {
+	HTTP_SERVER_ROUTE_BUF("/", "text/html", index_html,
+			      sizeof(index_html) - 1),
+	HTTP_SERVER_ROUTE_FLASH("/blob", "application/octet-stream",
+				FLASH_AREA_ID(storage), 0, FLASH_CONTENT_LEN),
+	HTTP_SERVER_ROUTE_HANDLER("/echo", BIT64(HTTP_POST), echo_handler),
+};
+
+static struct http_server server;
+static K_THREAD_STACK_DEFINE(server_stack, SERVER_STACK_SIZE);
+static struct k_thread server_thread;
+
+static struct sockaddr_in server_addr = {
+	.sin_family = AF_INET,
+	.sin_port = htons(SERVER_PORT),
+	.sin_addr = { { { 127, 0, 0, 1 } } },
+};
+
+static struct sockaddr_in peer_addr = {
+	.sin_family = AF_INET,
+	.sin_port = htons(PEER_PORT),
+	.sin_addr = { { { 127, 0, 0, 1 } } },
+};
+
+static struct http_session session;
+
+/* Result of a request, given as the user data of the request */
+struct result {
+	int status;
+	int order;
+	size_t len;
+	char body[64];
+};
+
+static int done_count;
+
+static int collect_data(struct http_session_req *req, const uint8_t *data,
+			size_t len)
+{
+	struct result *r = req->user_data;
+
+	zassert_true(r->len + len <= sizeof(r->body), "Body too large");
+	memcpy(r->body + r->len, data, len);
+	r->len += len;
+
+	return 0;
+}
+
+static void collect_done(struct http_session_req *req, int result)
+{
+	struct result *r = req->user_data;
+
+	r->status = result;
+	r->order = done_count++;
+}
+
+static void req_init(struct http_session_req *req, struct result *r,
+		     enum http_method method, const char *url)
+{
+	memset(req, 0, sizeof(*req));
+	memset(r, 0, sizeof(*r));
+	req->method = method;
+	req->url = url;
+	req->data_cb = collect_data;
+	req->done_cb = collect_done;
+	req->user_data = r;
+}
+
+static int open_conns(void)
+{
+	int count = 0;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(session.conns); i++) {
+		if (session.conns[i].sock >= 0) {
+			count++;
+		}
+	}
+
+	return count;
+}
+
+static void server_fn(void *p1, void *p2, void *p3)
+{
+	(void)http_server_run(&server);
+}
+
+static void test_init(void)
+{
+	const struct flash_area *fa;
+	uint8_t data[FLASH_CONTENT_LEN];
+	int i;
+
+	for (i = 0; i < sizeof(data); i++) {
+		data[i] = i * 7;
+	}
+
+	zassert_equal(flash_area_open(FLASH_AREA_ID(storage), &fa), 0,
+		      "Cannot open flash area");
+	zassert_equal(flash_area_erase(fa, 0, fa->fa_size), 0,
+		      "Cannot erase flash area");
+	zassert_equal(flash_area_write(fa, 0, data, sizeof(data)), 0,
+		      "Cannot write flash area");
+	flash_area_close(fa);
+
+	zassert_equal(http_server_init(&server,
+				       (struct sockaddr *)&server_addr,
+				       sizeof(server_addr), routes,
+				       ARRAY_SIZE(routes), NULL), 0,
+		      "Cannot init server");
+
+	k_thread_create(&server_thread, server_stack,
+			K_THREAD_STACK_SIZEOF(server_stack), server_fn,
+			NULL, NULL, NULL, K_PRIO_PREEMPT(8), 0, K_NO_WAIT);
+
+	zassert_equal(http_session_init(&session,
+					(struct sockaddr *)&server_addr,
+					sizeof(server_addr), "test"), 0,
+		      "Cannot init session");
+}
+
+static void test_get(void)
+{
+	struct http_session_req req;
+	struct result r;
+	int sock;
+
+	req_init(&req, &r, HTTP_GET, "/");
+	zassert_equal(http_session_send(&session, &req), 0, "Cannot send");
+	zassert_equal(http_session_wait(&session, WAIT_TIMEOUT), 0,
+		      "No response");
+	zassert_equal(r.status, 200, "Unexpected status %d", r.status);
+	zassert_equal(req.content_length, strlen(index_html),
+		      "Wrong Content-Length");
+	zassert_equal(r.len, strlen(index_html), "Wrong body length");
+	zassert_mem_equal(r.body, index_html, r.len, "Wrong body");
+
+	/* The connection is kept for the next request */
+	zassert_equal(open_conns(), 1, "Connection not kept");
+	sock = session.conns[0].sock;
+
+	req_init(&req, &r, HTTP_GET, "/");
+	zassert_equal(http_session_send(&session, &req), 0, "Cannot send");
+	zassert_equal(http_session_wait(&session, WAIT_TIMEOUT), 0,
+		      "No response");
+	zassert_equal(r.status, 200, "Unexpected status %d", r.status);
+	zassert_equal(session.conns[0].sock, sock, "Connection not reused");
+}
+
+static void test_pipelining(void)
+{
+	static const char * const urls[] = { "/", "/missing", "/", "/" };
+	struct http_session_req reqs[ARRAY_SIZE(urls)];
+	struct result results[ARRAY_SIZE(urls)];
+	int i;
+
+	done_count = 0;
+
+	for (i = 0; i < ARRAY_SIZE(urls); i++) {
+		req_init(&reqs[i], &results[i], HTTP_GET, urls[i]);
+		zassert_equal(http_session_send(&session, &reqs[i]), 0,
+			      "Cannot send request %d", i);
+	}
+
+	zassert_equal(open_conns(), 1, "Requests not pipelined");
+	zassert_equal(session.conns[0].count, ARRAY_SIZE(urls),
+		      "Requests not pipelined");
+
+	zassert_equal(http_session_wait(&session, WAIT_TIMEOUT), 0,
+		      "No response");
+
+	for (i = 0; i < ARRAY_SIZE(urls); i++) {
+		zassert_equal(results[i].order, i, "Responses out of order");
+		zassert_equal(results[i].status, i == 1 ? 404 : 200,
+			      "Unexpected status %d", results[i].status);
+	}
+
+	zassert_mem_equal(results[3].body, index_html, strlen(index_html),
+			  "Wrong body");
+}
+
+static void test_head(void)
+{
+	struct http_session_req reqs[2];
+	struct result results[2];
+
+	/* The GET behind the HEAD shows the HEAD response had no body */
+	req_init(&reqs[0], &results[0], HTTP_HEAD, "/");
+	req_init(&reqs[1], &results[1], HTTP_GET, "/");
+	zassert_equal(http_session_send(&session, &reqs[0]), 0, "Cannot send");
+	zassert_equal(http_session_send(&session, &reqs[1]), 0, "Cannot send");
+	zassert_equal(http_session_wait(&session, WAIT_TIMEOUT), 0,
+		      "No response");
+
+	zassert_equal(results[0].status, 200, "Unexpected status");
+	zassert_equal(results[0].len, 0, "Body in HEAD response");
+	zassert_equal(reqs[0].content_length, strlen(index_html),
+		      "Wrong Content-Length");
+	zassert_equal(results[1].status, 200, "Unexpected status");
+	zassert_equal(results[1].len, strlen(index_html), "Wrong body");
+}
+
+static void test_range(void)
+{
+	static const char * const headers[] = {
+		"X-Test: 1\r\n",
+		"Accept: */*\r\n",
+		NULL
+	};
+	static const char expected[] = "GET /fw HTTP/1.1\r\n"
+				       "Host: peer\r\n"
+				       "Range: bytes=10-19\r\n"
+				       "X-Test: 1\r\n"
+				       "Accept: */*\r\n\r\n";
+	static const char response[] = "HTTP/1.1 206 Partial Content\r\n"
+				       "Content-Range: bytes 10-19/100\r\n"
+				       "Content-Length: 10\r\n\r\n"
+				       "0123456789";
+	struct http_session peer_session;
+	struct http_session_req req;
+	struct result r;
+	char buf[128];
+	size_t len = 0;
+	ssize_t ret;
+	int listener;
+	int sock;
+
+	listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	zassert_true(listener >= 0, "Cannot create socket");
+	zassert_equal(bind(listener, (struct sockaddr *)&peer_addr,
+			   sizeof(peer_addr)), 0, "Cannot bind");
+	zassert_equal(listen(listener, 1), 0, "Cannot listen");
+
+	zassert_equal(http_session_init(&peer_session,
+					(struct sockaddr *)&peer_addr,
+					sizeof(peer_addr), "peer"), 0,
+		      "Cannot init session");
+
+	req_init(&req, &r, HTTP_GET, "/fw");
+	req.headers = (const char **)headers;
+	req.range_start = 10;
+	req.range_end = 19;
+	zassert_equal(http_session_send(&peer_session, &req), 0,
+		      "Cannot send");
+
+	sock = accept(listener, NULL, NULL);
+	zassert_true(sock >= 0, "Cannot accept");
+
+	while (len < sizeof(expected) - 1) {
+		ret = recv(sock, buf + len, sizeof(buf) - 1 - len, 0);
+		zassert_true(ret > 0, "Connection closed");
+		len += ret;
+	}
+
+	buf[len] = '\0';
+	zassert_equal(strcmp(buf, expected), 0, "Unexpected request %s", buf);
+	zassert_equal(send(sock, response, sizeof(response) - 1, 0),
+		      sizeof(response) - 1, "Cannot send response");
+
+	zassert_equal(http_session_wait(&peer_session, WAIT_TIMEOUT), 0,
+		      "No response");
+	zassert_equal(r.status, 206, "Unexpected status %d", r.status);
+	zassert_equal(r.len, 10, "Wrong body length");
+	zassert_mem_equal(r.body, "0123456789", 10, "Wrong body");
+
+	http_session_close(&peer_session);
+	close(sock);
+	close(listener);
+}
+
+static const char * const parts[] = { "hello ", "chunked ", "world" };
+
+static int produce_body(struct http_session_req *req, uint8_t *buf,
+			size_t len)
+{
+	int *part = &((struct result *)req->user_data)->order;
+	size_t part_len;
+
+	if (*part == ARRAY_SIZE(parts)) {
+		return 0;
+	}
+
+	part_len = strlen(parts[*part]);
+	zassert_true(part_len <= len, "No room for the body");
+	memcpy(buf, parts[(*part)++], part_len);
+
+	return part_len;
+}
+
+static void test_upload(void)
+{
+	static const char payload[] = "payload";
+	struct http_session_req req;
+	struct result r;
+
+	req_init(&req, &r, HTTP_POST, "/echo");
+	req.content_type = "text/plain";
+	req.payload = payload;
+	req.payload_len = sizeof(payload) - 1;
+	zassert_equal(http_session_send(&session, &req), 0, "Cannot send");
+	zassert_equal(http_session_wait(&session, WAIT_TIMEOUT), 0,
+		      "No response");
+	zassert_equal(r.status, 200, "Unexpected status %d", r.status);
+	zassert_equal(r.len, strlen(payload), "Wrong body length");
+	zassert_mem_equal(r.body, payload, r.len, "Wrong body");
+
+	/* Produced by the callback with the chunked transfer coding */
+	req_init(&req, &r, HTTP_POST, "/echo");
+	req.body_cb = produce_body;
+	zassert_equal(http_session_send(&session, &req), 0, "Cannot send");
+	zassert_equal(http_session_wait(&session, WAIT_TIMEOUT), 0,
+		      "No response");
+	zassert_equal(r.status, 200, "Unexpected status %d", r.status);
+	zassert_equal(r.len, strlen("hello chunked world"),
+		      "Wrong body length");
+	zassert_mem_equal(r.body, "hello chunked world", r.len, "Wrong body");
+}
+
+static void test_busy(void)
+{
+	struct http_session_req reqs[3];
+	struct result results[3];
+	int i;
+
+	/* Requests with a body are not pipelined */
+	for (i = 0; i < ARRAY_SIZE(reqs); i++) {
+		req_init(&reqs[i], &results[i], HTTP_POST, "/echo");
+		reqs[i].payload = "x";
+		reqs[i].payload_len = 1;
+	}
+
+	zassert_equal(http_session_send(&session, &reqs[0]), 0, "Cannot send");
+	zassert_equal(http_session_send(&session, &reqs[1]), 0, "Cannot send");
+	zassert_equal(open_conns(), 2, "Second connection not opened");
+	zassert_equal(http_session_send(&session, &reqs[2]), -EAGAIN,
+		      "Request accepted while busy");
+
+	zassert_equal(http_session_wait(&session, WAIT_TIMEOUT), 0,
+		      "No response");
+	zassert_equal(http_session_send(&session, &reqs[2]), 0, "Cannot send");
+	zassert_equal(http_session_wait(&session, WAIT_TIMEOUT), 0,
+		      "No response");
+
+	for (i = 0; i < ARRAY_SIZE(reqs); i++) {
+		zassert_equal(results[i].status, 200, "Unexpected status");
+	}
+
+	zassert_equal(open_conns(), 2, "Connection not kept");
+}
+
+static void test_flash_download(void)
+{
+	const struct flash_area *fa;
+	struct stream_flash_ctx ctx;
+	struct http_session_req req;
+	struct result r;
+	uint8_t expected[FLASH_CONTENT_LEN];
+	uint8_t data[FLASH_CONTENT_LEN];
+	uint8_t buf[64];
+	int i;
+
+	zassert_equal(flash_area_open(FLASH_AREA_ID(storage), &fa), 0,
+		      "Cannot open flash area");
+	zassert_equal(stream_flash_init(&ctx,
+					device_get_binding(fa->fa_dev_name),
+					buf, sizeof(buf),
+					fa->fa_off + FLASH_DOWNLOAD_OFFSET,
+					fa->fa_size - FLASH_DOWNLOAD_OFFSET,
+					NULL), 0,
+		      "Cannot init stream flash");
+
+	req_init(&req, &r, HTTP_GET, "/blob");
+	req.data_cb = NULL;
+	req.flash = &ctx;
+	zassert_equal(http_session_send(&session, &req), 0, "Cannot send");
+	zassert_equal(http_session_wait(&session, WAIT_TIMEOUT), 0,
+		      "No response");
+	zassert_equal(r.status, 200, "Unexpected status %d", r.status);
+	zassert_equal(req.received, FLASH_CONTENT_LEN, "Wrong body length");
+	zassert_equal(stream_flash_bytes_written(&ctx), FLASH_CONTENT_LEN,
+		      "Body not written");
+
+	zassert_equal(flash_area_read(fa, 0, expected, sizeof(expected)), 0,
+		      "Cannot read flash area");
+	zassert_equal(flash_area_read(fa, FLASH_DOWNLOAD_OFFSET, data,
+				      sizeof(data)), 0,
+		      "Cannot read flash area");
+	flash_area_close(fa);
+
+	for (i = 0; i < FLASH_CONTENT_LEN; i++) {
+		zassert_equal(data[i], expected[i], "Wrong byte %d", i);
+	}
+}
+
+static void test_server_close(void)
+{
+	struct http_session_req req;
+	struct result r;
+
+	zassert_true(open_conns() > 0, "No connection kept");
+
+	/* Let the server close the connections, the request is sent again
+	 * on a new connection.
+	 */
+	k_sleep(K_MSEC(CONFIG_HTTP_SERVER_IDLE_TIMEOUT + 200));
+
+	req_init(&req, &r, HTTP_GET, "/");
+	zassert_equal(http_session_send(&session, &req), 0, "Cannot send");
+	zassert_equal(http_session_wait(&session, WAIT_TIMEOUT), 0,
+		      "No response");
+	zassert_equal(r.status, 200, "Unexpected status %d", r.status);
+	zassert_mem_equal(r.body, index_html, strlen(index_html),
+			  "Wrong body");
+
+	http_session_close(&session);
+	zassert_equal(open_conns(), 0, "Connections not closed");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(http_client_session,
+			 ztest_unit_test(test_init),
+			 ztest_unit_test(test_get),
+			 ztest_unit_test(test_pipelining),
+			 ztest_unit_test(test_head),
+			 ztest_unit_test(test_range),
+			 ztest_unit_test(test_upload),
+			 ztest_unit_test(test_busy),
+			 ztest_unit_test(test_flash_download),
+			 ztest_unit_test(test_server_close));
+
+	ztest_run_test_suite(http_client_session);
+}
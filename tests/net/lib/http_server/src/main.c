@@ -0,0 +1,463 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <ztest.h>
+#include <stdlib.h>
+#include <net/socket.h>
+#include <net/http_server.h>
+#include <storage/flash_map.h>
+
+#define SERVER_PORT 8080
+#define SERVER_STACK_SIZE 2048
+
+/* Larger than CONFIG_HTTP_SERVER_BUF_SIZE, so it is sent in chunks */
+#define FLASH_CONTENT_LEN 1000
+
+/* Enough requests for the responses to exhaust the network buffers */
+#define STALL_REQUESTS 16
+
+static const char index_html[] = "<html>hello</html>";
+
+static int echo_handler(struct http_server_conn *conn,
+			const struct http_server_request *req,
+			void *user_data)
+{
+	return http_server_respond(conn, 200, "text/plain", req->body,
+				   req->body_len);
+}
+
+static int fail_handler(struct http_server_conn *conn,
+			const struct http_server_request *req,
+			void *user_data)
+{
+	return -EIO;
+}
+
+static const struct http_server_route routes[] = {
+	HTTP_SERVER_ROUTE_BUF("/", "text/html", index_html,
+			      sizeof(index_html) - 1),
+	HTTP_SERVER_ROUTE_FLASH("/blob", "application/octet-stream",
+				FLASH_AREA_ID(storage), 0, FLASH_CONTENT_LEN),
+	HTTP_SERVER_ROUTE_HANDLER("/echo", BIT64(HTTP_POST) | BIT64(HTTP_PUT) |
+				  BIT64(HTTP_UNLINK), echo_handler),
+	HTTP_SERVER_ROUTE_HANDLER("/fail", BIT64(HTTP_GET), fail_handler),
+};
+
+static struct http_server server;
+static K_THREAD_STACK_DEFINE(server_stack, SERVER_STACK_SIZE);
+static struct k_thread server_thread;
+
+static struct sockaddr_in server_addr = {
+	.sin_family = AF_INET,
+	.sin_port = htons(SERVER_PORT),
+	.sin_addr = { { { 127, 0, 0, 1 } } },
+};
+
+static char resp[2048];
+
+struct response {
+	int status;
+	const char *headers;
+	const char *body;
+	size_t body_len;
+};
+
+static void server_fn(void *p1, void *p2, void *p3)
+{
+	(void)http_server_run(&server);
+}
+
+static int client_open(void)
+{
+	int sock;
+
+	sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	zassert_true(sock >= 0, "Cannot create socket (%d)", errno);
+	zassert_equal(connect(sock, (struct sockaddr *)&server_addr,
+			      sizeof(server_addr)), 0,
+		      "Cannot connect (%d)", errno);
+
+	return sock;
+}
+
+static void client_send(int sock, const char *req)
+{
+	zassert_equal(send(sock, req, strlen(req), 0), strlen(req),
+		      "Cannot send request");
+}
+
+/* Read one response from sock into resp. *pending is the number of bytes
+ * at the start of resp which were read along with the previous response,
+ * and is set to the number of bytes read past this one. The response to a
+ * HEAD request has no body.
+ */
+static void recv_response(int sock, struct response *r, size_t *pending,
+			  bool head)
+{
+	size_t len = *pending;
+	size_t hdr_len = 0;
+	size_t total = 0;
+	char *end;
+	char *cl;
+	ssize_t ret;
+
+	for (;;) {
+		resp[len] = '\0';
+
+		if (!hdr_len) {
+			end = strstr(resp, "\r\n\r\n");
+			if (end) {
+				hdr_len = end + 4 - resp;
+				cl = strstr(resp, "Content-Length: ");
+				zassert_not_null(cl, "No Content-Length");
+				total = hdr_len;
+				if (!head) {
+					total += strtoul(cl + 16, NULL, 10);
+				}
+			}
+		}
+
+		if (hdr_len && len >= total) {
+			break;
+		}
+
+		ret = recv(sock, resp + len, sizeof(resp) - 1 - len, 0);
+		zassert_true(ret > 0, "Connection closed (%d)", errno);
+		len += ret;
+	}
+
+	r->status = strtol(resp + strlen("HTTP/1.1 "), NULL, 10);
+	r->headers = resp;
+	r->body = resp + hdr_len;
+	r->body_len = total - hdr_len;
+	*pending = len - total;
+}
+
+static void client_recv(int sock, struct response *r, size_t *pending)
+{
+	recv_response(sock, r, pending, false);
+}
+
+static void expect_response(struct response *r, size_t *pending, int status,
+			    const char *body)
+{
+	zassert_equal(r->status, status, "Unexpected status %d", r->status);
+
+	if (body) {
+		zassert_equal(r->body_len, strlen(body), "Wrong body length");
+		zassert_mem_equal(r->body, body, r->body_len, "Wrong body");
+	}
+
+	/* Drop the response so the next one starts at resp */
+	memmove(resp, r->body + r->body_len, *pending);
+}
+
+static void expect_closed(int sock)
+{
+	char c;
+
+	zassert_equal(recv(sock, &c, 1, 0), 0, "Connection not closed");
+}
+
+static void test_init(void)
+{
+	const struct flash_area *fa;
+	uint8_t data[FLASH_CONTENT_LEN];
+	int i;
+
+	for (i = 0; i < sizeof(data); i++) {
+		data[i] = i;
+	}
+
+	zassert_equal(flash_area_open(FLASH_AREA_ID(storage), &fa), 0,
+		      "Cannot open flash area");
+	zassert_equal(flash_area_erase(fa, 0, fa->fa_size), 0,
+		      "Cannot erase flash area");
+	zassert_equal(flash_area_write(fa, 0, data, sizeof(data)), 0,
+		      "Cannot write flash area");
+	flash_area_close(fa);
+
+	zassert_equal(http_server_init(&server,
+				       (struct sockaddr *)&server_addr,
+				       sizeof(server_addr), routes,
+				       ARRAY_SIZE(routes), NULL), 0,
+		      "Cannot init server");
+
+	k_thread_create(&server_thread, server_stack,
+			K_THREAD_STACK_SIZEOF(server_stack), server_fn,
+			NULL, NULL, NULL, K_PRIO_PREEMPT(8), 0, K_NO_WAIT);
+}
+
+static void test_get(void)
+{
+	struct response r;
+	size_t pending = 0;
+	int sock = client_open();
+
+	client_send(sock, "GET / HTTP/1.1\r\nHost: test\r\n\r\n");
+	client_recv(sock, &r, &pending);
+	zassert_not_null(strstr(r.headers, "Content-Type: text/html\r\n"),
+			 "No Content-Type");
+	expect_response(&r, &pending, 200, index_html);
+
+	/* The query string is not part of the path */
+	client_send(sock, "GET /?a=b HTTP/1.1\r\n\r\n");
+	client_recv(sock, &r, &pending);
+	expect_response(&r, &pending, 200, index_html);
+
+	client_send(sock, "HEAD / HTTP/1.1\r\n\r\n");
+	recv_response(sock, &r, &pending, true);
+	zassert_not_null(strstr(r.headers, "Content-Length: 18\r\n"),
+			 "Wrong Content-Length");
+	expect_response(&r, &pending, 200, "");
+
+	/* Nothing was sent after the header */
+	client_send(sock, "GET / HTTP/1.1\r\n\r\n");
+	client_recv(sock, &r, &pending);
+	expect_response(&r, &pending, 200, index_html);
+
+	close(sock);
+}
+
+static void test_errors(void)
+{
+	struct response r;
+	size_t pending = 0;
+	int sock = client_open();
+
+	client_send(sock, "GET /nothing HTTP/1.1\r\n\r\n");
+	client_recv(sock, &r, &pending);
+	expect_response(&r, &pending, 404, "");
+
+	client_send(sock, "DELETE / HTTP/1.1\r\n\r\n");
+	client_recv(sock, &r, &pending);
+	expect_response(&r, &pending, 405, "");
+
+	/* Methods numbered 32 and above */
+	client_send(sock, "UNLINK / HTTP/1.1\r\n\r\n");
+	client_recv(sock, &r, &pending);
+	expect_response(&r, &pending, 405, "");
+
+	client_send(sock, "UNLINK /echo HTTP/1.1\r\nContent-Length: 2\r\n"
+			  "\r\nok");
+	client_recv(sock, &r, &pending);
+	expect_response(&r, &pending, 200, "ok");
+
+	client_send(sock, "GET /fail HTTP/1.1\r\n\r\n");
+	client_recv(sock, &r, &pending);
+	expect_response(&r, &pending, 500, "");
+
+	client_send(sock, "GET /a/very/long/path/which/does/not/fit "
+			  "HTTP/1.1\r\n\r\n");
+	client_recv(sock, &r, &pending);
+	expect_response(&r, &pending, 414, "");
+
+	/* The connection is still usable after the errors */
+	client_send(sock, "GET / HTTP/1.1\r\n\r\n");
+	client_recv(sock, &r, &pending);
+	expect_response(&r, &pending, 200, index_html);
+
+	client_send(sock, "NOT HTTP\r\n\r\n");
+	client_recv(sock, &r, &pending);
+	expect_response(&r, &pending, 400, "");
+	expect_closed(sock);
+
+	close(sock);
+}
+
+static void test_pipelining(void)
+{
+	struct response r;
+	size_t pending = 0;
+	int sock = client_open();
+
+	client_send(sock, "GET / HTTP/1.1\r\n\r\n"
+			  "POST /echo HTTP/1.1\r\nContent-Length: 5\r\n\r\n"
+			  "hello"
+			  "GET /nothing HTTP/1.1\r\n\r\n"
+			  "PUT /echo HTTP/1.1\r\nContent-Length: 3\r\n"
+			  "Connection: close\r\n\r\nbye");
+
+	client_recv(sock, &r, &pending);
+	expect_response(&r, &pending, 200, index_html);
+	client_recv(sock, &r, &pending);
+	expect_response(&r, &pending, 200, "hello");
+	client_recv(sock, &r, &pending);
+	expect_response(&r, &pending, 404, "");
+	client_recv(sock, &r, &pending);
+	zassert_not_null(strstr(r.headers, "Connection: close\r\n"),
+			 "No Connection: close");
+	expect_response(&r, &pending, 200, "bye");
+	expect_closed(sock);
+
+	close(sock);
+}
+
+static void test_keep_alive_http10(void)
+{
+	struct response r;
+	size_t pending = 0;
+	int sock = client_open();
+
+	client_send(sock, "GET / HTTP/1.0\r\nConnection: keep-alive\r\n\r\n");
+	client_recv(sock, &r, &pending);
+	zassert_not_null(strstr(r.headers, "Connection: keep-alive\r\n"),
+			 "No Connection: keep-alive");
+	expect_response(&r, &pending, 200, index_html);
+
+	client_send(sock, "GET / HTTP/1.0\r\n\r\n");
+	client_recv(sock, &r, &pending);
+	expect_response(&r, &pending, 200, index_html);
+	expect_closed(sock);
+
+	close(sock);
+}
+
+static void test_body_too_large(void)
+{
+	static char req[256];
+	struct response r;
+	size_t pending = 0;
+	int sock = client_open();
+	int len;
+
+	len = snprintk(req, sizeof(req),
+		       "POST /echo HTTP/1.1\r\nContent-Length: %d\r\n\r\n",
+		       CONFIG_HTTP_SERVER_MAX_BODY_SIZE + 1);
+	memset(req + len, 'x', CONFIG_HTTP_SERVER_MAX_BODY_SIZE + 1);
+	req[len + CONFIG_HTTP_SERVER_MAX_BODY_SIZE + 1] = '\0';
+
+	client_send(sock, req);
+	client_recv(sock, &r, &pending);
+	expect_response(&r, &pending, 413, "");
+
+	close(sock);
+}
+
+static void test_flash(void)
+{
+	struct response r;
+	size_t pending = 0;
+	int sock = client_open();
+	int i;
+
+	client_send(sock, "GET /blob HTTP/1.1\r\n\r\n");
+	client_recv(sock, &r, &pending);
+	zassert_equal(r.status, 200, "Unexpected status %d", r.status);
+	zassert_equal(r.body_len, FLASH_CONTENT_LEN, "Wrong body length");
+
+	for (i = 0; i < FLASH_CONTENT_LEN; i++) {
+		zassert_equal((uint8_t)r.body[i], (uint8_t)i,
+			      "Wrong byte %d", i);
+	}
+
+	expect_response(&r, &pending, 200, NULL);
+
+	close(sock);
+}
+
+static void test_stalled_client(void)
+{
+	static char buf[256];
+	struct response r;
+	size_t pending = 0;
+	size_t total = 0;
+	int stalled;
+	int sock;
+	ssize_t ret;
+	int i;
+
+	/* Let the connections of the other tests expire */
+	k_sleep(K_MSEC(CONFIG_HTTP_SERVER_IDLE_TIMEOUT + 200));
+
+	stalled = client_open();
+
+	/* Ask for more than the stack can buffer, and do not read it */
+	for (i = 0; i < STALL_REQUESTS; i++) {
+		client_send(stalled, "GET /blob HTTP/1.1\r\n\r\n");
+	}
+
+	k_sleep(K_MSEC(100));
+
+	/* The other clients are served once the server gives up */
+	sock = client_open();
+	client_send(sock, "GET / HTTP/1.1\r\n\r\n");
+	client_recv(sock, &r, &pending);
+	expect_response(&r, &pending, 200, index_html);
+	close(sock);
+
+	/* Let the send time out, a send waiting for a buffer in the stack
+	 * takes up to a second.
+	 */
+	k_sleep(K_MSEC(CONFIG_HTTP_SERVER_SEND_TIMEOUT + 1500));
+
+	/* The stalled connection was closed before all the responses */
+	do {
+		ret = recv(stalled, buf, sizeof(buf), 0);
+		total += MAX(ret, 0);
+	} while (ret > 0);
+
+	zassert_equal(ret, 0, "Connection not closed (%d)", errno);
+	zassert_true(total < STALL_REQUESTS * FLASH_CONTENT_LEN,
+		     "All the responses were sent");
+
+	close(stalled);
+}
+
+static void test_max_clients(void)
+{
+	int socks[CONFIG_HTTP_SERVER_MAX_CLIENTS];
+	struct response r;
+	size_t pending = 0;
+	int sock;
+	int i;
+
+	/* Let the connections of the other tests expire */
+	k_sleep(K_MSEC(CONFIG_HTTP_SERVER_IDLE_TIMEOUT + 200));
+
+	for (i = 0; i < ARRAY_SIZE(socks); i++) {
+		socks[i] = client_open();
+		client_send(socks[i], "GET / HTTP/1.1\r\n\r\n");
+		client_recv(socks[i], &r, &pending);
+		expect_response(&r, &pending, 200, index_html);
+	}
+
+	sock = client_open();
+	client_recv(sock, &r, &pending);
+	expect_response(&r, &pending, 503, "");
+	expect_closed(sock);
+	close(sock);
+
+	/* The idle connections are closed by the server */
+	k_sleep(K_MSEC(CONFIG_HTTP_SERVER_IDLE_TIMEOUT + 200));
+
+	for (i = 0; i < ARRAY_SIZE(socks); i++) {
+		expect_closed(socks[i]);
+		close(socks[i]);
+	}
+
+	sock = client_open();
+	client_send(sock, "GET / HTTP/1.1\r\n\r\n");
+	client_recv(sock, &r, &pending);
+	expect_response(&r, &pending, 200, index_html);
+	close(sock);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(http_server,
+			 ztest_unit_test(test_init),
+			 ztest_unit_test(test_get),
+			 ztest_unit_test(test_errors),
+			 ztest_unit_test(test_pipelining),
+			 ztest_unit_test(test_keep_alive_http10),
+			 ztest_unit_test(test_body_too_large),
+			 ztest_unit_test(test_flash),
+			 ztest_unit_test(test_stalled_client),
+			 ztest_unit_test(test_max_clients));
+
+	ztest_run_test_suite(http_server);
+}
@@ -0,0 +1,493 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <ztest.h>
+#include <string.h>
+#include <net/coap.h>
+
+#include "lwm2m_object.h"
+#include "lwm2m_engine.h"
+#include "lwm2m_rw_plain_text.h"
+#include "lwm2m_rw_json.h"
+#include "lwm2m_rw_cbor.h"
+#include "lwm2m_rw_senml_cbor.h"
+
+#define TEST_OBJ_ID 32769
+#define TEST_BASE_NAME "/32769/0/"
+#define N_MULTI 30
+#define N_RES 9
+#define N_RUNS 100
+
+static char string_value[16];
+static int32_t s32_value;
+static int64_t s64_value;
+static bool bool_value;
+static float32_value_t float32_value;
+static float64_value_t float64_value;
+static struct lwm2m_objlnk objlnk_value;
+static uint8_t opaque_value[4];
+static uint16_t multi_value[N_MULTI];
+
+static struct lwm2m_engine_obj test_obj;
+static struct lwm2m_engine_obj_field fields[] = {
+	OBJ_FIELD_DATA(0, RW, STRING),
+	OBJ_FIELD_DATA(1, RW, S32),
+	OBJ_FIELD_DATA(2, RW, S64),
+	OBJ_FIELD_DATA(3, RW, BOOL),
+	OBJ_FIELD_DATA(4, RW, FLOAT32),
+	OBJ_FIELD_DATA(5, RW, FLOAT64),
+	OBJ_FIELD_DATA(6, RW, OBJLNK),
+	OBJ_FIELD_DATA(7, RW, OPAQUE),
+	OBJ_FIELD_DATA(8, RW, U16),
+};
+
+static struct lwm2m_engine_obj_inst test_inst;
+static struct lwm2m_engine_res res[N_RES];
+static struct lwm2m_engine_res_inst res_inst[N_RES - 1 + N_MULTI];
+
+static uint8_t out_buf[1024];
+static uint16_t out_size = sizeof(out_buf);
+static uint8_t in_buf[1024];
+static struct coap_packet out_cpkt;
+static struct coap_packet in_cpkt;
+static struct lwm2m_ctx ctx;
+static struct lwm2m_message msg;
+
+static const struct lwm2m_obj_path inst_path = {
+	.obj_id = TEST_OBJ_ID,
+	.level = 2,
+};
+
+static struct lwm2m_engine_obj_inst *test_create(uint16_t obj_inst_id)
+{
+	int i = 0, j = 0;
+
+	init_res_instance(res_inst, ARRAY_SIZE(res_inst));
+
+	INIT_OBJ_RES_DATA(0, res, i, res_inst, j, string_value,
+			  sizeof(string_value));
+	INIT_OBJ_RES_DATA(1, res, i, res_inst, j, &s32_value,
+			  sizeof(s32_value));
+	INIT_OBJ_RES_DATA(2, res, i, res_inst, j, &s64_value,
+			  sizeof(s64_value));
+	INIT_OBJ_RES_DATA(3, res, i, res_inst, j, &bool_value,
+			  sizeof(bool_value));
+	INIT_OBJ_RES_DATA(4, res, i, res_inst, j, &float32_value,
+			  sizeof(float32_value));
+	INIT_OBJ_RES_DATA(5, res, i, res_inst, j, &float64_value,
+			  sizeof(float64_value));
+	INIT_OBJ_RES_DATA(6, res, i, res_inst, j, &objlnk_value,
+			  sizeof(objlnk_value));
+	INIT_OBJ_RES_DATA(7, res, i, res_inst, j, opaque_value,
+			  sizeof(opaque_value));
+	INIT_OBJ_RES_MULTI_DATA(8, res, i, res_inst, j, N_MULTI, true,
+				multi_value, sizeof(multi_value[0]));
+
+	test_inst.resources = res;
+	test_inst.resource_count = i;
+
+	return &test_inst;
+}
+
+static void set_values(void)
+{
+	int i;
+
+	strcpy(string_value, "Zephyr");
+	s32_value = -42;
+	s64_value = 5000000000LL;
+	bool_value = true;
+	float32_value.val1 = 3;
+	float32_value.val2 = 500000;
+	float64_value.val1 = -1;
+	float64_value.val2 = 250000000;
+	objlnk_value.obj_id = 3;
+	objlnk_value.obj_inst = 0;
+	memcpy(opaque_value, "\x01\x02\x03\x04", sizeof(opaque_value));
+
+	for (i = 0; i < N_MULTI; i++) {
+		multi_value[i] = i * 100;
+	}
+}
+
+static void clear_values(void)
+{
+	memset(string_value, 0, sizeof(string_value));
+	s32_value = 0;
+	s64_value = 0;
+	bool_value = false;
+	memset(&float32_value, 0, sizeof(float32_value));
+	memset(&float64_value, 0, sizeof(float64_value));
+	memset(&objlnk_value, 0, sizeof(objlnk_value));
+	memset(opaque_value, 0, sizeof(opaque_value));
+	memset(multi_value, 0, sizeof(multi_value));
+}
+
+/* Read a path and return the payload of the response */
+static int do_read(const struct lwm2m_obj_path *path,
+		   const struct lwm2m_writer *writer,
+		   int (*read_op)(struct lwm2m_message *msg, int format),
+		   int format, const uint8_t **payload, uint16_t *len)
+{
+	uint16_t start;
+	int ret;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.ctx = &ctx;
+	msg.path = *path;
+	msg.out.writer = writer;
+	msg.out.out_cpkt = &out_cpkt;
+
+	ret = coap_packet_init(&out_cpkt, out_buf, out_size, 1,
+			       COAP_TYPE_ACK, 0, NULL,
+			       COAP_RESPONSE_CODE_CONTENT, 0);
+	zassert_equal(ret, 0, "Cannot init the response");
+
+	ret = read_op(&msg, format);
+	if (ret < 0) {
+		return ret;
+	}
+
+	/* skip the payload marker */
+	start = out_cpkt.hdr_len + out_cpkt.opt_len + 1;
+	*payload = out_buf + start;
+	*len = out_cpkt.offset - start;
+
+	return 0;
+}
+
+/* Write a payload to a path */
+static int do_write(const struct lwm2m_obj_path *path,
+		    const struct lwm2m_reader *reader,
+		    int (*write_op)(struct lwm2m_message *msg),
+		    const uint8_t *payload, uint16_t len)
+{
+	int ret;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.ctx = &ctx;
+	msg.path = *path;
+	msg.in.reader = reader;
+	msg.in.in_cpkt = &in_cpkt;
+
+	ret = coap_packet_init(&in_cpkt, in_buf, sizeof(in_buf), 1,
+			       COAP_TYPE_CON, 0, NULL, COAP_METHOD_PUT, 0);
+	zassert_equal(ret, 0, "Cannot init the request");
+	ret = coap_packet_append_payload_marker(&in_cpkt);
+	zassert_equal(ret, 0, "Cannot append the payload marker");
+
+	msg.in.offset = in_cpkt.offset;
+
+	ret = coap_packet_append_payload(&in_cpkt, (uint8_t *)payload, len);
+	zassert_equal(ret, 0, "Cannot append the payload");
+
+	return write_op(&msg);
+}
+
+/* Check that a payload is a single well formed CBOR item */
+static void check_cbor_item(const uint8_t *payload, uint16_t len)
+{
+	struct lwm2m_input_context in = {
+		.in_cpkt = &in_cpkt,
+	};
+	int ret;
+
+	memcpy(in_buf, payload, len);
+	in_cpkt.data = in_buf;
+	in_cpkt.offset = len;
+	in_cpkt.max_len = sizeof(in_buf);
+
+	ret = cbor_skip(&in);
+	zassert_equal(ret, 0, "Payload is not valid CBOR");
+	zassert_equal(in.offset, len, "Payload has trailing bytes");
+}
+
+static void test_cbor_read_resource(void)
+{
+	struct lwm2m_obj_path path = inst_path;
+	const uint8_t *payload;
+	uint16_t len;
+	int ret;
+
+	set_values();
+
+	path.level = 3;
+	path.res_id = 1;
+	ret = do_read(&path, &cbor_writer, do_read_op_cbor,
+		      LWM2M_FORMAT_APP_CBOR, &payload, &len);
+	zassert_equal(ret, 0, "Cannot read the integer");
+	zassert_equal(len, 2, "Wrong length %u", len);
+	/* -42 is encoded as the negative integer 41 */
+	zassert_mem_equal(payload, "\x38\x29", 2, "Wrong integer");
+
+	path.res_id = 0;
+	ret = do_read(&path, &cbor_writer, do_read_op_cbor,
+		      LWM2M_FORMAT_APP_CBOR, &payload, &len);
+	zassert_equal(ret, 0, "Cannot read the string");
+	zassert_equal(len, 7, "Wrong length %u", len);
+	zassert_mem_equal(payload, "\x66Zephyr", 7, "Wrong string");
+
+	ret = do_read(&inst_path, &cbor_writer, do_read_op_cbor,
+		      LWM2M_FORMAT_APP_CBOR, &payload, &len);
+	zassert_equal(ret, -EPERM, "Read an instance as CBOR");
+}
+
+static void test_cbor_write_resource(void)
+{
+	struct lwm2m_obj_path path = inst_path;
+	int ret;
+
+	clear_values();
+
+	path.level = 3;
+	path.res_id = 2;
+	/* 5000000000 as a 64 bit unsigned integer */
+	ret = do_write(&path, &cbor_reader, do_write_op_plain_text,
+		       "\x1b\x00\x00\x00\x01\x2a\x05\xf2\x00", 9);
+	zassert_equal(ret, 0, "Cannot write the integer");
+	zassert_equal(s64_value, 5000000000LL, "Wrong integer");
+
+	path.res_id = 4;
+	/* 1.5 as a half precision float */
+	ret = do_write(&path, &cbor_reader, do_write_op_plain_text,
+		       "\xf9\x3e\x00", 3);
+	zassert_equal(ret, 0, "Cannot write the float");
+	zassert_equal(float32_value.val1, 1, "Wrong integer part");
+	zassert_equal(float32_value.val2, 500000, "Wrong fractional part");
+
+	path.res_id = 5;
+	/* -2.25 as a double precision float */
+	ret = do_write(&path, &cbor_reader, do_write_op_plain_text,
+		       "\xfb\xc0\x02\x00\x00\x00\x00\x00\x00", 9);
+	zassert_equal(ret, 0, "Cannot write the float");
+	zassert_equal(float64_value.val1, -2, "Wrong integer part");
+	zassert_equal(float64_value.val2, -250000000,
+		      "Wrong fractional part");
+}
+
+static void test_cbor_write_invalid_float(void)
+{
+	struct lwm2m_obj_path path = inst_path;
+	int ret;
+
+	set_values();
+
+	path.level = 3;
+	path.res_id = 4;
+	/* NaN as a half precision float */
+	ret = do_write(&path, &cbor_reader, do_write_op_plain_text,
+		       "\xf9\x7e\x00", 3);
+	zassert_equal(ret, -EINVAL, "Wrote NaN");
+
+	/* infinity as a single precision float */
+	ret = do_write(&path, &cbor_reader, do_write_op_plain_text,
+		       "\xfa\x7f\x80\x00\x00", 5);
+	zassert_equal(ret, -EINVAL, "Wrote infinity");
+
+	/* 3e9 as a single precision float, out of the float32 range */
+	ret = do_write(&path, &cbor_reader, do_write_op_plain_text,
+		       "\xfa\x4f\x32\xd0\x5e", 5);
+	zassert_equal(ret, -EINVAL, "Wrote an out of range float32");
+
+	zassert_equal(float32_value.val1, 3, "float32 changed");
+	zassert_equal(float32_value.val2, 500000, "float32 changed");
+
+	path.res_id = 5;
+	/* 1e19 as a double precision float, out of the float64 range */
+	ret = do_write(&path, &cbor_reader, do_write_op_plain_text,
+		       "\xfb\x43\xe1\x58\xe4\x60\x91\x3d\x00", 9);
+	zassert_equal(ret, -EINVAL, "Wrote an out of range float64");
+
+	zassert_equal(float64_value.val1, -1, "float64 changed");
+	zassert_equal(float64_value.val2, 250000000, "float64 changed");
+}
+
+static void test_senml_cbor_read_instance(void)
+{
+	const uint8_t *payload;
+	uint16_t len;
+	int ret;
+
+	set_values();
+
+	ret = do_read(&inst_path, &senml_cbor_writer, do_read_op_senml_cbor,
+		      LWM2M_FORMAT_APP_SENML_CBOR, &payload, &len);
+	zassert_equal(ret, 0, "Cannot read the instance");
+
+	/* more than 23 records need a second byte of array head */
+	zassert_equal(payload[0], 0x98, "Wrong array head");
+	zassert_equal(payload[1], N_RES - 1 + N_MULTI, "Wrong record count");
+
+	/* the first record carries the base name */
+	zassert_equal(payload[2], 0xa3, "Wrong map head");
+	zassert_equal(payload[3], 0x21, "Base name label expected");
+	zassert_equal(payload[4], 0x60 + strlen(TEST_BASE_NAME),
+		      "Wrong base name length");
+	zassert_mem_equal(&payload[5], TEST_BASE_NAME, strlen(TEST_BASE_NAME),
+			  "Wrong base name");
+
+	check_cbor_item(payload, len);
+}
+
+static void test_senml_cbor_read_no_room(void)
+{
+	const uint8_t *payload, *head;
+	uint16_t len;
+	int ret;
+
+	set_values();
+
+	ret = do_read(&inst_path, &senml_cbor_writer, do_read_op_senml_cbor,
+		      LWM2M_FORMAT_APP_SENML_CBOR, &head, &len);
+	zassert_equal(ret, 0, "Cannot read the instance");
+
+	/* the records fit, but not the second byte of the array head */
+	out_size = out_cpkt.offset - 1;
+	ret = do_read(&inst_path, &senml_cbor_writer, do_read_op_senml_cbor,
+		      LWM2M_FORMAT_APP_SENML_CBOR, &payload, &len);
+	out_size = sizeof(out_buf);
+
+	zassert_equal(ret, -ENOMEM, "Read without room for the array head");
+	zassert_equal(head[0], 0x80, "Array head patched");
+}
+
+static void test_senml_cbor_round_trip(void)
+{
+	static uint8_t copy[sizeof(out_buf)];
+	const uint8_t *payload;
+	uint16_t len;
+	int ret;
+	int i;
+
+	set_values();
+
+	ret = do_read(&inst_path, &senml_cbor_writer, do_read_op_senml_cbor,
+		      LWM2M_FORMAT_APP_SENML_CBOR, &payload, &len);
+	zassert_equal(ret, 0, "Cannot read the instance");
+	memcpy(copy, payload, len);
+
+	clear_values();
+
+	ret = do_write(&inst_path, &cbor_reader, do_write_op_senml_cbor,
+		       copy, len);
+	zassert_equal(ret, 0, "Cannot write the instance");
+
+	zassert_true(strcmp(string_value, "Zephyr") == 0, "Wrong string");
+	zassert_equal(s32_value, -42, "Wrong s32");
+	zassert_equal(s64_value, 5000000000LL, "Wrong s64");
+	zassert_true(bool_value, "Wrong bool");
+	zassert_equal(float32_value.val1, 3, "Wrong float32");
+	zassert_equal(float32_value.val2, 500000, "Wrong float32");
+	zassert_equal(float64_value.val1, -1, "Wrong float64");
+	zassert_equal(float64_value.val2, -250000000, "Wrong float64");
+	zassert_equal(objlnk_value.obj_id, 3, "Wrong objlnk");
+	zassert_equal(objlnk_value.obj_inst, 0, "Wrong objlnk");
+	zassert_mem_equal(opaque_value, "\x01\x02\x03\x04",
+			  sizeof(opaque_value), "Wrong opaque");
+
+	for (i = 0; i < N_MULTI; i++) {
+		zassert_equal(multi_value[i], i * 100,
+			      "Wrong resource instance %d", i);
+	}
+}
+
+static void test_senml_cbor_write(void)
+{
+	/* [{bn: "/32769/0/", n: "1", v: 7},
+	 *  {n: "6", vlo: "2:3"},
+	 *  {bt: 100, n: "3", vb: false}]
+	 */
+	static const uint8_t payload[] = {
+		0x83,
+		0xa3, 0x21, 0x69, '/', '3', '2', '7', '6', '9', '/', '0', '/',
+		0x00, 0x61, '1', 0x02, 0x07,
+		0xa2, 0x00, 0x61, '6', 0x63, 'v', 'l', 'o', 0x63, '2', ':', '3',
+		0xa3, 0x22, 0x18, 0x64, 0x00, 0x61, '3', 0x04, 0xf4,
+	};
+	int ret;
+
+	set_values();
+
+	ret = do_write(&inst_path, &cbor_reader, do_write_op_senml_cbor,
+		       payload, sizeof(payload));
+	zassert_equal(ret, 0, "Cannot write the pack");
+	zassert_equal(s32_value, 7, "Wrong s32");
+	zassert_equal(objlnk_value.obj_id, 2, "Wrong objlnk");
+	zassert_equal(objlnk_value.obj_inst, 3, "Wrong objlnk");
+	zassert_false(bool_value, "Wrong bool");
+
+	/* a truncated pack is rejected */
+	ret = do_write(&inst_path, &cbor_reader, do_write_op_senml_cbor,
+		       payload, 10);
+	zassert_equal(ret, -EINVAL, "Truncated pack accepted");
+}
+
+/* Compare the payload size and encoding time of JSON and SenML CBOR */
+static void test_senml_cbor_vs_json(void)
+{
+	const uint8_t *payload;
+	uint32_t start, json_cycles, cbor_cycles;
+	uint16_t json_len, cbor_len;
+	int ret;
+	int i;
+
+	set_values();
+
+	start = k_cycle_get_32();
+
+	for (i = 0; i < N_RUNS; i++) {
+		ret = do_read(&inst_path, &json_writer, do_read_op_json,
+			      LWM2M_FORMAT_OMA_JSON, &payload, &json_len);
+		zassert_equal(ret, 0, "Cannot read the instance as JSON");
+	}
+
+	json_cycles = (k_cycle_get_32() - start) / N_RUNS;
+
+	start = k_cycle_get_32();
+
+	for (i = 0; i < N_RUNS; i++) {
+		ret = do_read(&inst_path, &senml_cbor_writer,
+			      do_read_op_senml_cbor,
+			      LWM2M_FORMAT_APP_SENML_CBOR, &payload,
+			      &cbor_len);
+		zassert_equal(ret, 0, "Cannot read the instance as CBOR");
+	}
+
+	cbor_cycles = (k_cycle_get_32() - start) / N_RUNS;
+
+	TC_PRINT("JSON       %u bytes %u cycles\n", json_len, json_cycles);
+	TC_PRINT("SenML CBOR %u bytes %u cycles\n", cbor_len, cbor_cycles);
+
+	zassert_true(cbor_len < json_len, "SenML CBOR is larger than JSON");
+}
+
+void test_main(void)
+{
+	struct lwm2m_engine_obj_inst *obj_inst;
+	int ret;
+
+	test_obj.obj_id = TEST_OBJ_ID;
+	test_obj.fields = fields;
+	test_obj.field_count = ARRAY_SIZE(fields);
+	test_obj.max_instance_count = 1U;
+	test_obj.create_cb = test_create;
+	lwm2m_register_obj(&test_obj);
+
+	ret = lwm2m_create_obj_inst(TEST_OBJ_ID, 0, &obj_inst);
+	zassert_equal(ret, 0, "Cannot create the test instance");
+
+	ztest_test_suite(lwm2m_content_senml_cbor,
+			 ztest_unit_test(test_cbor_read_resource),
+			 ztest_unit_test(test_cbor_write_resource),
+			 ztest_unit_test(test_cbor_write_invalid_float),
+			 ztest_unit_test(test_senml_cbor_read_instance),
+			 ztest_unit_test(test_senml_cbor_read_no_room),
+			 ztest_unit_test(test_senml_cbor_round_trip),
+			 ztest_unit_test(test_senml_cbor_write),
+			 ztest_unit_test(test_senml_cbor_vs_json));
+
+	ztest_run_test_suite(lwm2m_content_senml_cbor);
+}
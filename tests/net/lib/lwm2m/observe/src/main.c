@@ -0,0 +1,314 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <ztest.h>
+#include <stdio.h>
+#include <string.h>
+#include <net/socket.h>
+#include <net/coap.h>
+
+#include "lwm2m_object.h"
+#include "lwm2m_engine.h"
+
+/* The test acts as the LwM2M server on a loopback socket. It observes
+ * resources of a test object with different notification attributes and
+ * checks the order in which the engine sends the notifications.
+ */
+
+#define TEST_OBJ_ID 32769
+#define N_RES 2
+#define SERVER_PORT 5683
+#define ENGINE_PORT 5684
+#define RECV_TIMEOUT_MS 1000
+
+static int32_t values[N_RES];
+
+static struct lwm2m_engine_obj test_obj;
+static struct lwm2m_engine_obj_field fields[] = {
+	OBJ_FIELD_DATA(0, RW, S32),
+	OBJ_FIELD_DATA(1, RW, S32),
+};
+
+static struct lwm2m_engine_obj_inst test_inst;
+static struct lwm2m_engine_res res[N_RES];
+static struct lwm2m_engine_res_inst res_inst[N_RES];
+
+static struct sockaddr_in6 server_addr = {
+	.sin6_family = AF_INET6,
+	.sin6_port = htons(SERVER_PORT),
+	.sin6_addr = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+			   0, 0, 0, 0, 0, 0, 0, 0x1 } } },
+};
+
+static struct lwm2m_ctx ctx;
+static int server_sock;
+static uint8_t buf[256];
+
+static struct lwm2m_engine_obj_inst *test_create(uint16_t obj_inst_id)
+{
+	int i = 0, j = 0;
+
+	init_res_instance(res_inst, ARRAY_SIZE(res_inst));
+
+	INIT_OBJ_RES_DATA(0, res, i, res_inst, j, &values[0],
+			  sizeof(values[0]));
+	INIT_OBJ_RES_DATA(1, res, i, res_inst, j, &values[1],
+			  sizeof(values[1]));
+
+	test_inst.resources = res;
+	test_inst.resource_count = i;
+
+	return &test_inst;
+}
+
+/* Receive a message from the engine, acknowledging notifications. Returns
+ * the first byte of its token, or 0 if none came within timeout_ms.
+ */
+static char recv_msg(int timeout_ms, uint8_t *code)
+{
+	struct pollfd pfd = { .fd = server_sock, .events = POLLIN };
+	struct coap_packet cpkt;
+	uint8_t token[8];
+	ssize_t len;
+	int r;
+
+	if (poll(&pfd, 1, timeout_ms) <= 0) {
+		return 0;
+	}
+
+	len = recv(server_sock, buf, sizeof(buf), 0);
+	zassert_true(len > 0, "Cannot receive");
+
+	r = coap_packet_parse(&cpkt, buf, len, NULL, 0);
+	zassert_equal(r, 0, "Invalid message");
+
+	*code = coap_header_get_code(&cpkt);
+	zassert_equal(coap_header_get_token(&cpkt, token), 1,
+		      "Unexpected token length");
+
+	if (coap_header_get_type(&cpkt) == COAP_TYPE_CON) {
+		struct coap_packet ack;
+		uint8_t ack_buf[8];
+
+		r = coap_packet_init(&ack, ack_buf, sizeof(ack_buf), 1,
+				     COAP_TYPE_ACK, 0, NULL,
+				     COAP_CODE_EMPTY,
+				     coap_header_get_id(&cpkt));
+		zassert_equal(r, 0, "Cannot build the ACK");
+		zassert_equal(send(server_sock, ack.data, ack.offset, 0),
+			      ack.offset, "Cannot send the ACK");
+	}
+
+	return token[0];
+}
+
+/* Send a request on a resource of the test object and wait for its
+ * piggybacked response.
+ */
+static void request(uint8_t method, int res_id, char token, int observe,
+		    const char *query)
+{
+	struct coap_packet cpkt;
+	char res_str[4];
+	uint8_t code;
+	int r;
+
+	snprintf(res_str, sizeof(res_str), "%d", res_id);
+
+	r = coap_packet_init(&cpkt, buf, sizeof(buf), 1, COAP_TYPE_CON, 1,
+			     (uint8_t *)&token, method, coap_next_id());
+	zassert_equal(r, 0, "Cannot build the request");
+
+	if (observe >= 0) {
+		r = coap_append_option_int(&cpkt, COAP_OPTION_OBSERVE,
+					   observe);
+		zassert_equal(r, 0, "Cannot add the observe option");
+	}
+
+	r = coap_packet_append_option(&cpkt, COAP_OPTION_URI_PATH,
+				      STRINGIFY(TEST_OBJ_ID),
+				      strlen(STRINGIFY(TEST_OBJ_ID)));
+	r |= coap_packet_append_option(&cpkt, COAP_OPTION_URI_PATH, "0", 1);
+	r |= coap_packet_append_option(&cpkt, COAP_OPTION_URI_PATH, res_str,
+				       strlen(res_str));
+	zassert_equal(r, 0, "Cannot add the path");
+
+	if (method == COAP_METHOD_GET) {
+		r = coap_append_option_int(&cpkt, COAP_OPTION_ACCEPT,
+					   LWM2M_FORMAT_PLAIN_TEXT);
+		zassert_equal(r, 0, "Cannot add the accept option");
+	}
+
+	while (query && *query) {
+		r = coap_packet_append_option(&cpkt, COAP_OPTION_URI_QUERY,
+					      query, strlen(query));
+		zassert_equal(r, 0, "Cannot add the query");
+		query += strlen(query) + 1;
+	}
+
+	zassert_equal(send(server_sock, cpkt.data, cpkt.offset, 0),
+		      cpkt.offset, "Cannot send the request");
+
+	zassert_equal(recv_msg(RECV_TIMEOUT_MS, &code), token,
+		      "No response");
+	zassert_equal(COAP_RESPONSE_CODE_CLASS(code), 2,
+		      "Request failed");
+}
+
+static void write_attrs(int res_id, const char *attrs)
+{
+	request(COAP_METHOD_PUT, res_id, 'w', -1, attrs);
+}
+
+static void observe(int res_id, char token)
+{
+	request(COAP_METHOD_GET, res_id, token, 0, NULL);
+}
+
+static void cancel(int res_id, char token)
+{
+	request(COAP_METHOD_GET, res_id, token, 1, NULL);
+}
+
+/* Collect the tokens of the notifications received until timeout_ms */
+static void recv_notifications(char *tokens, size_t n, int timeout_ms)
+{
+	int64_t end = k_uptime_get() + timeout_ms;
+	uint8_t code;
+	size_t i = 0;
+	char token;
+
+	memset(tokens, 0, n);
+
+	while (k_uptime_get() < end) {
+		token = recv_msg(end - k_uptime_get(), &code);
+		if (!token) {
+			break;
+		}
+
+		zassert_true(i < n - 1, "Too many notifications");
+		zassert_equal(code, COAP_RESPONSE_CODE_CONTENT,
+			      "Unexpected notification code");
+		tokens[i++] = token;
+	}
+}
+
+static void test_setup(void)
+{
+	struct sockaddr_in6 engine_addr = server_addr;
+	int r;
+
+	engine_addr.sin6_port = htons(ENGINE_PORT);
+
+	server_sock = socket(AF_INET6, SOCK_DGRAM, IPPROTO_UDP);
+	zassert_true(server_sock >= 0, "Cannot create the server socket");
+
+	r = bind(server_sock, (struct sockaddr *)&server_addr,
+		 sizeof(server_addr));
+	zassert_equal(r, 0, "Cannot bind the server socket");
+
+	r = connect(server_sock, (struct sockaddr *)&engine_addr,
+		    sizeof(engine_addr));
+	zassert_equal(r, 0, "Cannot connect the server socket");
+
+	/* Set up the engine socket like lwm2m_socket_start(), but on a
+	 * known port.
+	 */
+	memcpy(&ctx.remote_addr, &server_addr, sizeof(server_addr));
+	lwm2m_engine_context_init(&ctx);
+
+	ctx.sock_fd = socket(AF_INET6, SOCK_DGRAM, IPPROTO_UDP);
+	zassert_true(ctx.sock_fd >= 0, "Cannot create the engine socket");
+
+	r = bind(ctx.sock_fd, (struct sockaddr *)&engine_addr,
+		 sizeof(engine_addr));
+	zassert_equal(r, 0, "Cannot bind the engine socket");
+
+	r = connect(ctx.sock_fd, &ctx.remote_addr, sizeof(server_addr));
+	zassert_equal(r, 0, "Cannot connect the engine socket");
+
+	r = lwm2m_socket_add(&ctx);
+	zassert_equal(r, 0, "Cannot add the engine socket");
+}
+
+/* Observers are notified in the order of their max periods */
+static void test_pmax_order(void)
+{
+	char tokens[8];
+
+	write_attrs(0, "pmin=0\0pmax=5\0");
+	write_attrs(1, "pmin=0\0pmax=2\0");
+
+	observe(0, 'a');
+	observe(1, 'b');
+
+	recv_notifications(tokens, sizeof(tokens), 5500);
+	zassert_equal(strcmp(tokens, "bba"), 0,
+		      "Unexpected notifications: %s", tokens);
+
+	cancel(0, 'a');
+	cancel(1, 'b');
+
+	recv_notifications(tokens, sizeof(tokens), 6000);
+	zassert_equal(strlen(tokens), 0, "Notified after the cancel: %s",
+		      tokens);
+}
+
+/* A value change is notified once pmin has passed, ahead of an observer
+ * due before the max period of the changed resource.
+ */
+static void test_value_change_order(void)
+{
+	int64_t start;
+	uint8_t code;
+	int r;
+
+	write_attrs(0, "pmin=1\0pmax=10\0");
+	write_attrs(1, "pmin=0\0pmax=2\0");
+
+	observe(0, 'a');
+	observe(1, 'b');
+
+	start = k_uptime_get();
+
+	/* Changes are only seen after the time of the last notification */
+	k_sleep(K_MSEC(100));
+
+	r = lwm2m_engine_set_s32(STRINGIFY(TEST_OBJ_ID) "/0/0", 42);
+	zassert_equal(r, 0, "Cannot set the value");
+
+	zassert_equal(recv_msg(1500, &code), 'a', "Change not notified");
+	zassert_true(k_uptime_get() - start >= 1000, "Notified before pmin");
+
+	zassert_equal(recv_msg(1500, &code), 'b', "Max period not notified");
+
+	cancel(0, 'a');
+	cancel(1, 'b');
+}
+
+void test_main(void)
+{
+	struct lwm2m_engine_obj_inst *obj_inst;
+	int ret;
+
+	test_obj.obj_id = TEST_OBJ_ID;
+	test_obj.fields = fields;
+	test_obj.field_count = ARRAY_SIZE(fields);
+	test_obj.max_instance_count = 1U;
+	test_obj.create_cb = test_create;
+	lwm2m_register_obj(&test_obj);
+
+	ret = lwm2m_create_obj_inst(TEST_OBJ_ID, 0, &obj_inst);
+	zassert_equal(ret, 0, "Cannot create the test instance");
+
+	ztest_test_suite(lwm2m_observe,
+			 ztest_unit_test(test_setup),
+			 ztest_unit_test(test_pmax_order),
+			 ztest_unit_test(test_value_change_order)
+			 );
+
+	ztest_run_test_suite(lwm2m_observe);
+}
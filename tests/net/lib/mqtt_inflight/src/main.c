@@ -0,0 +1,339 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <ztest.h>
+#include <net/socket.h>
+#include <net/mqtt.h>
+
+/* Publish to a broker stand-in on the loopback interface, which reports
+ * the messages it receives and only acknowledges them when the test asks,
+ * to check that mqtt_publish() enforces CONFIG_MQTT_MAX_INFLIGHT.
+ */
+
+#define BROKER_PORT 1883
+#define BROKER_STACK_SIZE 2048
+#define BROKER_BUF_SIZE 256
+#define WAIT_MS 1000
+#define TOPIC "test/inflight"
+
+#define PKT_CONNECT 0x10
+#define PKT_PUBLISH 0x30
+#define PKT_PUBACK 0x40
+#define PKT_PUBREC 0x50
+#define PKT_PUBREL 0x60
+#define PKT_PUBCOMP 0x70
+
+/* A packet received by the broker */
+struct broker_pkt {
+	uint8_t type;
+	uint16_t message_id;
+};
+
+static uint8_t rx_buffer[64];
+static uint8_t tx_buffer[64];
+static uint8_t broker_buf[BROKER_BUF_SIZE];
+
+static struct mqtt_client client;
+static struct sockaddr_in broker_addr = {
+	.sin_family = AF_INET,
+	.sin_port = htons(BROKER_PORT),
+	.sin_addr = { { { 127, 0, 0, 1 } } },
+};
+
+static bool connected;
+static int broker_listener;
+static int broker_sock = -1;
+K_MSGQ_DEFINE(broker_pkts, sizeof(struct broker_pkt), 16, 4);
+static K_THREAD_STACK_DEFINE(broker_stack, BROKER_STACK_SIZE);
+static struct k_thread broker_thread;
+
+static int recv_all(int sock, uint8_t *buf, size_t len)
+{
+	while (len > 0) {
+		ssize_t ret = recv(sock, buf, len, 0);
+
+		if (ret <= 0) {
+			return -1;
+		}
+
+		buf += ret;
+		len -= ret;
+	}
+
+	return 0;
+}
+
+static int broker_read_packet(int sock, uint8_t *type, uint32_t *len)
+{
+	uint8_t byte;
+	int shift = 0;
+
+	if (recv_all(sock, type, 1) < 0) {
+		return -1;
+	}
+
+	*len = 0U;
+
+	do {
+		if (recv_all(sock, &byte, 1) < 0) {
+			return -1;
+		}
+
+		*len |= (uint32_t)(byte & 0x7F) << shift;
+		shift += 7;
+	} while (byte & 0x80);
+
+	if (*len > sizeof(broker_buf)) {
+		return -1;
+	}
+
+	return recv_all(sock, broker_buf, *len);
+}
+
+static void broker(void *p1, void *p2, void *p3)
+{
+	static const uint8_t connack[] = { 0x20, 2U, 0U, 0U };
+	struct broker_pkt pkt;
+	uint16_t topic_len;
+	uint32_t len;
+	uint8_t type;
+
+	broker_sock = accept(broker_listener, NULL, NULL);
+	if (broker_sock < 0) {
+		return;
+	}
+
+	while (broker_read_packet(broker_sock, &type, &len) == 0) {
+		pkt.type = type & 0xF0;
+		pkt.message_id = 0U;
+
+		switch (pkt.type) {
+		case PKT_CONNECT:
+			send(broker_sock, connack, sizeof(connack), 0);
+			continue;
+		case PKT_PUBLISH:
+			if (((type >> 1) & 0x03) != MQTT_QOS_0_AT_MOST_ONCE) {
+				topic_len = (broker_buf[0] << 8) |
+					    broker_buf[1];
+				pkt.message_id =
+					(broker_buf[2 + topic_len] << 8) |
+					broker_buf[3 + topic_len];
+			}
+			break;
+		case PKT_PUBREL:
+			pkt.message_id = (broker_buf[0] << 8) | broker_buf[1];
+			break;
+		default:
+			continue;
+		}
+
+		k_msgq_put(&broker_pkts, &pkt, K_NO_WAIT);
+	}
+}
+
+static void mqtt_evt_handler(struct mqtt_client *const c,
+			     const struct mqtt_evt *evt)
+{
+	struct mqtt_pubrel_param rel;
+
+	switch (evt->type) {
+	case MQTT_EVT_CONNACK:
+		connected = (evt->result == 0);
+		break;
+	case MQTT_EVT_PUBREC:
+		rel.message_id = evt->param.pubrec.message_id;
+		mqtt_publish_qos2_release(c, &rel);
+		break;
+	default:
+		break;
+	}
+}
+
+/* Wait for input from the broker and process it */
+static void wait_input(void)
+{
+	struct pollfd fds = {
+		.fd = client.transport.tcp.sock,
+		.events = POLLIN,
+	};
+
+	zassert_equal(poll(&fds, 1, WAIT_MS), 1, "No input from the broker");
+	zassert_equal(mqtt_input(&client), 0, "Cannot process the input");
+}
+
+static void broker_send_ack(uint8_t type, uint16_t message_id)
+{
+	uint8_t ack[] = { type, 2U, message_id >> 8, message_id & 0xFF };
+
+	zassert_equal(send(broker_sock, ack, sizeof(ack), 0), sizeof(ack),
+		      "Cannot send the ack");
+	wait_input();
+}
+
+/* Check the next packet the broker received, -1 for none */
+static void broker_expect(int type, uint16_t message_id)
+{
+	struct broker_pkt pkt;
+	int ret;
+
+	ret = k_msgq_get(&broker_pkts, &pkt, K_MSEC(WAIT_MS));
+	if (type < 0) {
+		zassert_not_equal(ret, 0, "Unexpected packet");
+		return;
+	}
+
+	zassert_equal(ret, 0, "No packet");
+	zassert_equal(pkt.type, type, "Unexpected packet type");
+	zassert_equal(pkt.message_id, message_id, "Unexpected message id");
+}
+
+static int publish(enum mqtt_qos qos, uint16_t message_id, bool dup)
+{
+	struct mqtt_publish_param param = {
+		.message.topic.topic.utf8 = (uint8_t *)TOPIC,
+		.message.topic.topic.size = sizeof(TOPIC) - 1,
+		.message.topic.qos = qos,
+		.message.payload.data = (uint8_t *)"x",
+		.message.payload.len = 1U,
+		.message_id = message_id,
+		.dup_flag = dup,
+	};
+
+	return mqtt_publish(&client, &param);
+}
+
+static void test_connect(void)
+{
+	int ret;
+
+	broker_listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	zassert_true(broker_listener >= 0, "Cannot create the listener");
+
+	ret = bind(broker_listener, (struct sockaddr *)&broker_addr,
+		   sizeof(broker_addr));
+	zassert_equal(ret, 0, "Cannot bind the listener");
+	zassert_equal(listen(broker_listener, 1), 0, "Cannot listen");
+
+	k_thread_create(&broker_thread, broker_stack,
+			K_THREAD_STACK_SIZEOF(broker_stack), broker,
+			NULL, NULL, NULL, K_PRIO_PREEMPT(8), 0, K_NO_WAIT);
+
+	mqtt_client_init(&client);
+
+	client.broker = &broker_addr;
+	client.evt_cb = mqtt_evt_handler;
+	client.client_id.utf8 = (uint8_t *)"test";
+	client.client_id.size = strlen("test");
+	client.protocol_version = MQTT_VERSION_3_1_1;
+	client.transport.type = MQTT_TRANSPORT_NON_SECURE;
+	client.rx_buf = rx_buffer;
+	client.rx_buf_size = sizeof(rx_buffer);
+	client.tx_buf = tx_buffer;
+	client.tx_buf_size = sizeof(tx_buffer);
+
+	zassert_equal(mqtt_connect(&client), 0, "Cannot connect");
+	wait_input();
+	zassert_true(connected, "Not connected");
+}
+
+static void test_window_full(void)
+{
+	int i;
+
+	for (i = 1; i <= CONFIG_MQTT_MAX_INFLIGHT; i++) {
+		zassert_equal(publish(MQTT_QOS_1_AT_LEAST_ONCE, i, false), 0,
+			      "Cannot publish in the window");
+		broker_expect(PKT_PUBLISH, i);
+	}
+
+	zassert_equal(publish(MQTT_QOS_1_AT_LEAST_ONCE, i, false), -EAGAIN,
+		      "Published beyond the window");
+	broker_expect(-1, 0);
+
+	/* QoS 0 messages are not acknowledged, so not limited */
+	zassert_equal(publish(MQTT_QOS_0_AT_MOST_ONCE, 0, false), 0,
+		      "Cannot publish with QoS 0");
+	broker_expect(PKT_PUBLISH, 0);
+
+	/* A retransmission does not take another slot */
+	zassert_equal(publish(MQTT_QOS_1_AT_LEAST_ONCE, 2, true), 0,
+		      "Cannot retransmit");
+	broker_expect(PKT_PUBLISH, 2);
+}
+
+static void test_puback_release(void)
+{
+	uint16_t next = CONFIG_MQTT_MAX_INFLIGHT + 1;
+
+	/* An ack for a message which is not in flight changes nothing */
+	broker_send_ack(PKT_PUBACK, 1000);
+	zassert_equal(publish(MQTT_QOS_1_AT_LEAST_ONCE, next, false),
+		      -EAGAIN, "Unknown ack released a slot");
+
+	broker_send_ack(PKT_PUBACK, 2);
+	zassert_equal(publish(MQTT_QOS_1_AT_LEAST_ONCE, next, false), 0,
+		      "Ack did not release a slot");
+	broker_expect(PKT_PUBLISH, next);
+
+	zassert_equal(publish(MQTT_QOS_1_AT_LEAST_ONCE, next + 1, false),
+		      -EAGAIN, "Ack released more than one slot");
+	broker_expect(-1, 0);
+
+	/* Empty the window */
+	broker_send_ack(PKT_PUBACK, next);
+	for (next = 1; next <= CONFIG_MQTT_MAX_INFLIGHT; next++) {
+		if (next != 2) {
+			broker_send_ack(PKT_PUBACK, next);
+		}
+	}
+}
+
+static void test_pubcomp_release(void)
+{
+	int i;
+
+	for (i = 1; i <= CONFIG_MQTT_MAX_INFLIGHT; i++) {
+		zassert_equal(publish(MQTT_QOS_2_EXACTLY_ONCE, 100 + i, false),
+			      0, "Cannot publish in the window");
+		broker_expect(PKT_PUBLISH, 100 + i);
+	}
+
+	zassert_equal(publish(MQTT_QOS_2_EXACTLY_ONCE, 100 + i, false),
+		      -EAGAIN, "Published beyond the window");
+
+	/* The message is only done once PUBCOMP is received */
+	broker_send_ack(PKT_PUBREC, 101);
+	broker_expect(PKT_PUBREL, 101);
+	zassert_equal(publish(MQTT_QOS_2_EXACTLY_ONCE, 100 + i, false),
+		      -EAGAIN, "PUBREC released a slot");
+
+	broker_send_ack(PKT_PUBCOMP, 101);
+	zassert_equal(publish(MQTT_QOS_2_EXACTLY_ONCE, 100 + i, false),
+		      0, "PUBCOMP did not release a slot");
+	broker_expect(PKT_PUBLISH, 100 + i);
+}
+
+static void test_disconnect(void)
+{
+	zassert_equal(mqtt_disconnect(&client), 0, "Cannot disconnect");
+
+	/* The window is empty again on the next connection */
+	zassert_equal(client.internal.inflight_count, 0,
+		      "Window not reset");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(mqtt_inflight,
+			 ztest_unit_test(test_connect),
+			 ztest_unit_test(test_window_full),
+			 ztest_unit_test(test_puback_release),
+			 ztest_unit_test(test_pubcomp_release),
+			 ztest_unit_test(test_disconnect)
+			 );
+
+	ztest_run_test_suite(mqtt_inflight);
+}
@@ -784,6 +784,87 @@ void test_net_pkt_clone(void)
 	net_pkt_unref(cloned_pkt);
 }
 
+#if defined(CONFIG_NET_BUF_SIZE_CLASSES)
+static int pkt_frag_count(struct net_pkt *pkt)
+{
+	struct net_buf *buf;
+	int count = 0;
+
+	for (buf = pkt->buffer; buf; buf = buf->frags) {
+		count++;
+	}
+
+	return count;
+}
+#endif
+
+static void test_net_pkt_size_classes(void)
+{
+#if defined(CONFIG_NET_BUF_SIZE_CLASSES)
+	struct net_pkt *large[CONFIG_NET_BUF_TX_LARGE_COUNT];
+	struct net_buf_pool *tx_data;
+	struct net_pkt *pkt;
+	size_t frame_len = net_if_get_mtu(eth_if) + L2_HDR_SIZE;
+	int i;
+
+	net_pkt_get_info(NULL, NULL, NULL, &tx_data);
+
+	/* A small segment takes a small buffer */
+	pkt = net_pkt_alloc_with_buffer(eth_if, 20, AF_INET, IPPROTO_UDP,
+					K_NO_WAIT);
+	zassert_not_null(pkt, "Pkt not allocated");
+	zassert_equal(pkt_frag_count(pkt), 1, "Small pkt is fragmented");
+	zassert_equal(net_buf_pool_get(pkt->buffer->pool_id), tx_data,
+		      "Small pkt not in the small class");
+	net_pkt_unref(pkt);
+
+	pkt = net_pkt_alloc_with_buffer(eth_if,
+					CONFIG_NET_BUF_MEDIUM_DATA_SIZE,
+					AF_UNSPEC, 0, K_NO_WAIT);
+	zassert_not_null(pkt, "Pkt not allocated");
+	zassert_equal(pkt_frag_count(pkt), 1, "Medium pkt is fragmented");
+	zassert_not_equal(net_buf_pool_get(pkt->buffer->pool_id), tx_data,
+			  "Medium pkt in the small class");
+	net_pkt_unref(pkt);
+
+	/* Two medium and one small buffer waste less than a large one */
+	pkt = net_pkt_alloc_with_buffer(eth_if,
+					2 * CONFIG_NET_BUF_MEDIUM_DATA_SIZE +
+					CONFIG_NET_BUF_DATA_SIZE / 2,
+					AF_UNSPEC, 0, K_NO_WAIT);
+	zassert_not_null(pkt, "Pkt not allocated");
+	zassert_equal(pkt_frag_count(pkt), 3, "Pkt not made of smaller bufs");
+	zassert_equal(net_buf_pool_get(pkt->buffer->frags->frags->pool_id),
+		      tx_data, "Last buf not in the small class");
+	net_pkt_unref(pkt);
+
+	/* A full sized frame is a single buffer */
+	for (i = 0; i < ARRAY_SIZE(large); i++) {
+		large[i] = net_pkt_alloc_with_buffer(eth_if, frame_len,
+						     AF_UNSPEC, 0, K_NO_WAIT);
+		zassert_not_null(large[i], "Pkt not allocated");
+		zassert_equal(pkt_frag_count(large[i]), 1,
+			      "Large pkt is fragmented");
+		zassert_true(pkt_is_of_size(large[i], frame_len),
+			     "Pkt size is not right");
+	}
+
+	/* Once the large class is exhausted the other classes are used */
+	pkt = net_pkt_alloc_with_buffer(eth_if, frame_len, AF_UNSPEC, 0,
+					K_NO_WAIT);
+	zassert_not_null(pkt, "Pkt not allocated");
+	zassert_true(pkt_frag_count(pkt) > 1, "Large class not exhausted");
+	zassert_true(pkt_is_of_size(pkt, frame_len), "Pkt size is not right");
+	net_pkt_unref(pkt);
+
+	for (i = 0; i < ARRAY_SIZE(large); i++) {
+		net_pkt_unref(large[i]);
+	}
+#else
+	ztest_test_skip();
+#endif
+}
+
 void test_main(void)
 {
 	eth_if = net_if_get_default();
@@ -796,7 +877,8 @@ void test_main(void)
 			 ztest_unit_test(test_net_pkt_easier_rw_usage),
 			 ztest_unit_test(test_net_pkt_copy),
 			 ztest_unit_test(test_net_pkt_pull),
-			 ztest_unit_test(test_net_pkt_clone)
+			 ztest_unit_test(test_net_pkt_clone),
+			 ztest_unit_test(test_net_pkt_size_classes)
 		);
 
 	ztest_run_test_suite(net_pkt_tests);
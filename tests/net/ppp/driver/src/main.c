@@ -29,6 +29,7 @@ LOG_MODULE_REGISTER(net_test, NET_LOG_LEVEL);
 
 #define NET_LOG_ENABLED 1
 #include "net_private.h"
+#include "ppp_hdlc.h"
 
 typedef enum net_verdict (*ppp_l2_callback_t)(struct net_if *iface,
 					      struct net_pkt *pkt);
@@ -537,6 +538,81 @@ static void test_send_ppp_8(void)
 	}
 }
 
+static void test_ppp_hdlc_fcs(void)
+{
+	static uint8_t data[67];
+	uint16_t fcs;
+	int i, len;
+
+	for (i = 0; i < sizeof(data); i++) {
+		data[i] = i * 37 + 11;
+	}
+
+	/* All lengths and alignments of the word at a time loop */
+	for (len = 0; len < sizeof(data) - 3; len++) {
+		for (i = 0; i < 4; i++) {
+			fcs = ppp_hdlc_fcs(PPP_HDLC_INIT_FCS, &data[i], len);
+			zassert_equal(fcs,
+				      crc16_ccitt(PPP_HDLC_INIT_FCS,
+						  &data[i], len),
+				      "Invalid FCS, len %d off %d", len, i);
+		}
+	}
+}
+
+static void test_ppp_hdlc_escape(void)
+{
+	static uint8_t data[256];
+	static uint8_t escaped[2 * sizeof(data)];
+	static uint8_t unescaped[sizeof(escaped)];
+	size_t count, written, total = 0, out = 0;
+	bool next_escaped = false;
+	int i;
+
+	for (i = 0; i < sizeof(data); i++) {
+		data[i] = i;
+	}
+
+	/* 32 control characters and the flag and escape are escaped */
+	while (total < sizeof(data)) {
+		/* A small destination so that escapes reach its end */
+		written = MIN(7, sizeof(escaped) - out);
+		count = ppp_hdlc_escape(&data[total], sizeof(data) - total,
+					&escaped[out], &written);
+		zassert_true(count > 0, "No progress");
+
+		total += count;
+		out += written;
+	}
+
+	zassert_equal(out, sizeof(data) + 34, "Invalid escaped length %zu",
+		      out);
+	zassert_is_null(memchr(escaped, PPP_HDLC_FLAG, out),
+			"Flag in escaped data");
+
+	/* Split at an escape character */
+	count = ppp_hdlc_unescape(escaped, 1, unescaped, &written,
+				  &next_escaped);
+	zassert_equal(count, 1, "Invalid count");
+	zassert_equal(written, 0, "Invalid length");
+	zassert_true(next_escaped, "Escape not saved");
+
+	count = ppp_hdlc_unescape(&escaped[1], out - 1, unescaped, &written,
+				  &next_escaped);
+	zassert_equal(count, out - 1, "Invalid count");
+	zassert_equal(written, sizeof(data), "Invalid unescaped length");
+	zassert_mem_equal(unescaped, data, sizeof(data), "Invalid data");
+
+	/* Stop before the flag and unescape in place */
+	escaped[out] = PPP_HDLC_FLAG;
+	next_escaped = false;
+	count = ppp_hdlc_unescape(escaped, out + 1, escaped, &written,
+				  &next_escaped);
+	zassert_equal(count, out, "Flag not found");
+	zassert_equal(written, sizeof(data), "Invalid unescaped length");
+	zassert_mem_equal(escaped, data, sizeof(data), "Invalid data");
+}
+
 void test_main(void)
 {
 	ztest_test_suite(net_ppp_test,
@@ -551,7 +627,9 @@ void test_main(void)
 			 ztest_unit_test(test_send_ppp_5),
 			 ztest_unit_test(test_send_ppp_6),
 			 ztest_unit_test(test_send_ppp_7),
-			 ztest_unit_test(test_send_ppp_8)
+			 ztest_unit_test(test_send_ppp_8),
+			 ztest_unit_test(test_ppp_hdlc_fcs),
+			 ztest_unit_test(test_ppp_hdlc_escape)
 		);
 
 	ztest_run_test_suite(net_ppp_test);
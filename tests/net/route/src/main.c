@@ -472,6 +472,126 @@ static void test_route_del_many(void)
 	}
 }
 
+static void test_route_longest_prefix(void)
+{
+	struct in6_addr prefix32 = { { { 0x20, 0x01, 0x0d, 0xb8 } } };
+	struct in6_addr prefix64 = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0x1 } } };
+	struct in6_addr host = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0x1,
+				     0, 0, 0, 0, 0, 0, 0, 0x42 } } };
+	struct in6_addr in64 = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0x1,
+				     0, 0, 0, 0, 0, 0, 0, 0x43 } } };
+	struct in6_addr in32 = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 0x2, 0, 0x1,
+				     0, 0, 0, 0, 0, 0, 0, 0x42 } } };
+	struct in6_addr outside = { { { 0x20, 0x01, 0x0d, 0xb9, 0, 0, 0, 0x1,
+					0, 0, 0, 0, 0, 0, 0, 0x42 } } };
+	struct net_route_entry *route32, *route64, *route128;
+
+	/* Add the more specific routes first, a shorter prefix must not
+	 * be taken as an update of them.
+	 */
+	route128 = net_route_add(my_iface, &host, 128, &peer_addr);
+	zassert_not_null(route128, "Route /128 add failed");
+
+	route64 = net_route_add(my_iface, &prefix64, 64, &peer_addr);
+	zassert_not_null(route64, "Route /64 add failed");
+	zassert_not_equal(route64, route128, "Route /64 replaced /128");
+
+	route32 = net_route_add(my_iface, &prefix32, 32, &peer_addr);
+	zassert_not_null(route32, "Route /32 add failed");
+	zassert_not_equal(route32, route64, "Route /32 replaced /64");
+
+	zassert_equal_ptr(net_route_lookup(my_iface, &host), route128,
+			  "Host route not found");
+	zassert_equal_ptr(net_route_lookup(my_iface, &in64), route64,
+			  "/64 route not found");
+	zassert_equal_ptr(net_route_lookup(my_iface, &in32), route32,
+			  "/32 route not found");
+	zassert_equal_ptr(net_route_lookup(NULL, &in32), route32,
+			  "/32 route not found for any interface");
+	zassert_is_null(net_route_lookup(my_iface, &outside),
+			"Route found outside of the prefixes");
+	zassert_is_null(net_route_lookup(peer_iface, &host),
+			"Route found for wrong interface");
+
+	zassert_equal(net_route_del(route64), 0, "Route /64 del failed");
+
+	zassert_equal_ptr(net_route_lookup(my_iface, &in64), route32,
+			  "/32 route not found after /64 del");
+	zassert_equal_ptr(net_route_lookup(my_iface, &host), route128,
+			  "Host route not found after /64 del");
+
+	zassert_equal(net_route_del(route128), 0, "Route /128 del failed");
+
+	zassert_equal_ptr(net_route_lookup(my_iface, &host), route32,
+			  "/32 route not found after /128 del");
+
+	zassert_equal(net_route_del(route32), 0, "Route /32 del failed");
+
+	zassert_is_null(net_route_lookup(my_iface, &host),
+			"Route found after del");
+}
+
+#if defined(CONFIG_NET_ROUTE_IPV4)
+static void route_ipv4_cb(struct net_route_entry_ipv4 *entry,
+			  void *user_data)
+{
+	zassert_equal_ptr(entry->iface, my_iface, "Wrong route interface");
+}
+
+static void test_route_ipv4(void)
+{
+	struct in_addr net8 = { { { 10, 0, 0, 0 } } };
+	struct in_addr net16 = { { { 10, 1, 0, 0 } } };
+	struct in_addr gw1 = { { { 192, 0, 2, 1 } } };
+	struct in_addr gw2 = { { { 192, 0, 2, 2 } } };
+	struct in_addr in16 = { { { 10, 1, 2, 3 } } };
+	struct in_addr in8 = { { { 10, 2, 0, 1 } } };
+	struct in_addr outside = { { { 11, 1, 2, 3 } } };
+	struct net_route_entry_ipv4 *route8, *route16;
+
+	route8 = net_route_ipv4_add(my_iface, &net8, 8, &gw1);
+	zassert_not_null(route8, "Route /8 add failed");
+
+	route16 = net_route_ipv4_add(my_iface, &net16, 16,
+				     (struct in_addr *)net_ipv4_unspecified_address());
+	zassert_not_null(route16, "Route /16 add failed");
+
+	zassert_equal_ptr(net_route_ipv4_add(my_iface, &net16, 16, &gw2),
+			  route16, "Route /16 update failed");
+	zassert_true(net_ipv4_addr_cmp(&route16->gw, &gw2),
+		     "Gateway not updated");
+
+	zassert_equal_ptr(net_route_ipv4_lookup(my_iface, &in16), route16,
+			  "/16 route not found");
+	zassert_equal_ptr(net_route_ipv4_lookup(my_iface, &in8), route8,
+			  "/8 route not found");
+	zassert_is_null(net_route_ipv4_lookup(my_iface, &outside),
+			"Route found outside of the prefixes");
+	zassert_is_null(net_route_ipv4_lookup(peer_iface, &in8),
+			"Route found for wrong interface");
+
+	zassert_equal(net_route_ipv4_foreach(route_ipv4_cb, NULL), 2,
+		      "Wrong number of IPv4 routes");
+
+	zassert_equal(net_route_ipv4_del(route16), 0, "Route /16 del failed");
+	zassert_equal(net_route_ipv4_del(route16), -ENOENT,
+		      "Route /16 del again succeeded");
+
+	zassert_equal_ptr(net_route_ipv4_lookup(my_iface, &in16), route8,
+			  "/8 route not found after /16 del");
+
+	zassert_equal(net_route_ipv4_del(route8), 0, "Route /8 del failed");
+
+	zassert_is_null(net_route_ipv4_lookup(my_iface, &in8),
+			"Route found after del");
+}
+#else
+static void test_route_ipv4(void)
+{
+	ztest_test_skip();
+}
+#endif
+
 /*test case main entry*/
 void test_main(void)
 {
@@ -491,6 +611,8 @@ void test_main(void)
 			ztest_unit_test(test_route_del_nexthop_again),
 			ztest_unit_test(test_populate_nbr_cache),
 			ztest_unit_test(test_route_add_many),
-			ztest_unit_test(test_route_del_many));
+			ztest_unit_test(test_route_del_many),
+			ztest_unit_test(test_route_longest_prefix),
+			ztest_unit_test(test_route_ipv4));
 	ztest_run_test_suite(test_route);
 }
@@ -0,0 +1,301 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, CONFIG_NET_SOCKETS_LOG_LEVEL);
+
+#include <ztest_assert.h>
+
+#include <net/socket.h>
+#include <net/socket_service.h>
+
+#define PORT_A 4240
+#define PORT_B 4241
+#define PORT_C 4242
+#define WAIT_TIME K_MSEC(200)
+
+static int sock_a = -1;
+static int sock_b = -1;
+static int sock_c = -1;
+static int sock_tx = -1;
+
+static K_SEM_DEFINE(handled, 0, 8);
+static struct net_socket_service_event *last_pev;
+static void *last_user_data;
+static int last_fd;
+static int calls;
+
+static void handler(struct net_socket_service_event *pev)
+{
+	uint8_t buf[16];
+
+	last_pev = pev;
+	last_user_data = pev->user_data;
+	last_fd = pev->event.fd;
+	calls++;
+
+	/* Consume one datagram */
+	(void)recv(pev->event.fd, buf, sizeof(buf), MSG_DONTWAIT);
+
+	k_sem_give(&handled);
+}
+
+/* Work queue which the test can keep busy */
+static K_THREAD_STACK_DEFINE(test_q_stack, 1024);
+static struct k_work_q test_q;
+static K_SEM_DEFINE(unblock, 0, 1);
+
+static void block_work(struct k_work *work)
+{
+	k_sem_take(&unblock, K_FOREVER);
+}
+
+static K_WORK_DEFINE(blocker, block_work);
+
+NET_SOCKET_SERVICE_DEFINE(sync_service, NULL, handler, 2);
+NET_SOCKET_SERVICE_DEFINE(work_q_service, &k_sys_work_q, handler, 1);
+NET_SOCKET_SERVICE_DEFINE(extra_service, NULL, handler, 1);
+NET_SOCKET_SERVICE_DEFINE(test_q_service, &test_q, handler, 1);
+
+static int udp_socket(uint16_t port)
+{
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_port = htons(port),
+		.sin_addr = { { { 127, 0, 0, 1 } } },
+	};
+	int sock;
+
+	sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	zassert_true(sock >= 0, "Cannot create socket (%d)", errno);
+
+	zassert_equal(bind(sock, (struct sockaddr *)&addr, sizeof(addr)), 0,
+		      "Cannot bind socket (%d)", errno);
+
+	return sock;
+}
+
+static void send_to(uint16_t port)
+{
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_port = htons(port),
+		.sin_addr = { { { 127, 0, 0, 1 } } },
+	};
+	int ret;
+
+	ret = sendto(sock_tx, "ping", 4, 0, (struct sockaddr *)&addr,
+		     sizeof(addr));
+	zassert_equal(ret, 4, "Cannot send (%d)", errno);
+}
+
+static void reset(void)
+{
+	k_sem_reset(&handled);
+	last_pev = NULL;
+	last_user_data = NULL;
+	last_fd = -1;
+	calls = 0;
+}
+
+static void test_setup(void)
+{
+	sock_a = udp_socket(PORT_A);
+	sock_b = udp_socket(PORT_B);
+	sock_c = udp_socket(PORT_C);
+	sock_tx = udp_socket(0);
+
+	k_work_q_start(&test_q, test_q_stack,
+		       K_THREAD_STACK_SIZEOF(test_q_stack), K_PRIO_PREEMPT(1));
+}
+
+static void test_sync(void)
+{
+	struct zsock_pollfd fds[] = {
+		{ .fd = sock_a, .events = ZSOCK_POLLIN },
+		{ .fd = sock_b, .events = ZSOCK_POLLIN },
+	};
+	int ret;
+
+	reset();
+
+	ret = net_socket_service_register(&sync_service, fds,
+					  ARRAY_SIZE(fds), &sync_service);
+	zassert_equal(ret, 0, "Cannot register service (%d)", ret);
+
+	send_to(PORT_B);
+
+	zassert_equal(k_sem_take(&handled, WAIT_TIME), 0,
+		      "Handler not called");
+	zassert_equal(last_fd, sock_b, "Wrong socket %d", last_fd);
+	zassert_equal(last_user_data, &sync_service, "Wrong user data");
+	zassert_true(last_pev->event.revents & ZSOCK_POLLIN,
+		     "Wrong events 0x%x", last_pev->event.revents);
+	zassert_equal(last_pev->svc, &sync_service, "Wrong service");
+
+	send_to(PORT_A);
+
+	zassert_equal(k_sem_take(&handled, WAIT_TIME), 0,
+		      "Handler not called");
+	zassert_equal(last_fd, sock_a, "Wrong socket %d", last_fd);
+
+	ret = net_socket_service_unregister(&sync_service);
+	zassert_equal(ret, 0, "Cannot unregister service (%d)", ret);
+
+	send_to(PORT_A);
+
+	zassert_not_equal(k_sem_take(&handled, WAIT_TIME), 0,
+			  "Handler called after unregistering");
+
+	/* Drain the datagram sent while unregistered */
+	ret = recv(sock_a, fds, sizeof(fds), MSG_DONTWAIT);
+	zassert_equal(ret, 4, "Datagram lost (%d)", ret);
+}
+
+static void test_work_q(void)
+{
+	struct zsock_pollfd fds[] = {
+		{ .fd = sock_a, .events = ZSOCK_POLLIN },
+	};
+	int ret;
+	int i;
+
+	reset();
+
+	ret = net_socket_service_register(&work_q_service, fds,
+					  ARRAY_SIZE(fds), NULL);
+	zassert_equal(ret, 0, "Cannot register service (%d)", ret);
+
+	/* Every datagram is handled once, the socket is polled again only
+	 * after the handler has run.
+	 */
+	for (i = 0; i < 3; i++) {
+		send_to(PORT_A);
+	}
+
+	for (i = 0; i < 3; i++) {
+		zassert_equal(k_sem_take(&handled, WAIT_TIME), 0,
+			      "Handler not called %d", i);
+	}
+
+	zassert_not_equal(k_sem_take(&handled, WAIT_TIME), 0,
+			  "Handler called too many times");
+	zassert_equal(calls, 3, "Handler called %d times", calls);
+
+	ret = net_socket_service_unregister(&work_q_service);
+	zassert_equal(ret, 0, "Cannot unregister service (%d)", ret);
+}
+
+static void test_unregister_pending(void)
+{
+	struct zsock_pollfd fds[] = {
+		{ .fd = sock_a, .events = ZSOCK_POLLIN },
+	};
+	int ret;
+
+	reset();
+
+	ret = net_socket_service_register(&test_q_service, fds,
+					  ARRAY_SIZE(fds), NULL);
+	zassert_equal(ret, 0, "Cannot register service (%d)", ret);
+
+	/* The handler is pending behind the blocker when unregistering */
+	k_work_submit_to_queue(&test_q, &blocker);
+	send_to(PORT_A);
+	k_sleep(WAIT_TIME);
+
+	ret = net_socket_service_unregister(&test_q_service);
+	zassert_equal(ret, 0, "Cannot unregister service (%d)", ret);
+
+	k_sem_give(&unblock);
+
+	zassert_not_equal(k_sem_take(&handled, WAIT_TIME), 0,
+			  "Handler called after unregistering");
+
+	ret = recv(sock_a, fds, sizeof(fds), MSG_DONTWAIT);
+	zassert_equal(ret, 4, "Datagram lost (%d)", ret);
+}
+
+static void test_limits(void)
+{
+	struct zsock_pollfd fds[] = {
+		{ .fd = sock_a, .events = ZSOCK_POLLIN },
+		{ .fd = sock_b, .events = ZSOCK_POLLIN },
+	};
+	int ret;
+
+	ret = net_socket_service_register(&work_q_service, fds,
+					  ARRAY_SIZE(fds), NULL);
+	zassert_equal(ret, -EINVAL, "Too many sockets accepted (%d)", ret);
+
+	/* The dispatcher polls CONFIG_NET_SOCKETS_POLL_MAX - 1 sockets */
+	BUILD_ASSERT(CONFIG_NET_SOCKETS_POLL_MAX == 4);
+
+	ret = net_socket_service_register(&sync_service, fds,
+					  ARRAY_SIZE(fds), NULL);
+	zassert_equal(ret, 0, "Cannot register service (%d)", ret);
+
+	fds[0].fd = sock_tx;
+	ret = net_socket_service_register(&work_q_service, fds, 1, NULL);
+	zassert_equal(ret, 0, "Cannot register service (%d)", ret);
+
+	/* Registering again replaces the sockets */
+	ret = net_socket_service_register(&work_q_service, fds, 1, NULL);
+	zassert_equal(ret, 0, "Cannot register service again (%d)", ret);
+
+	fds[0].fd = sock_c;
+	ret = net_socket_service_register(&extra_service, fds, 1, NULL);
+	zassert_equal(ret, -ENOMEM, "Too many sockets polled (%d)", ret);
+
+	/* Negative fds are ignored */
+	fds[0].fd = sock_a;
+	fds[1].fd = -1;
+	ret = net_socket_service_register(&sync_service, fds,
+					  ARRAY_SIZE(fds), NULL);
+	zassert_equal(ret, 0, "Cannot replace sockets (%d)", ret);
+
+	fds[0].fd = sock_c;
+	ret = net_socket_service_register(&extra_service, fds, 1, NULL);
+	zassert_equal(ret, 0, "Cannot register service (%d)", ret);
+
+	/* A failed registration keeps the previous sockets */
+	fds[0].fd = sock_a;
+	fds[1].fd = sock_b;
+	ret = net_socket_service_register(&sync_service, fds,
+					  ARRAY_SIZE(fds), NULL);
+	zassert_equal(ret, -ENOMEM, "Too many sockets polled (%d)", ret);
+
+	reset();
+	send_to(PORT_A);
+	zassert_equal(k_sem_take(&handled, WAIT_TIME), 0,
+		      "Previous socket not polled");
+	zassert_equal(last_fd, sock_a, "Wrong socket %d", last_fd);
+
+	net_socket_service_unregister(&sync_service);
+	net_socket_service_unregister(&work_q_service);
+	net_socket_service_unregister(&extra_service);
+}
+
+static void test_cleanup(void)
+{
+	close(sock_a);
+	close(sock_b);
+	close(sock_c);
+	close(sock_tx);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(socket_service,
+			 ztest_unit_test(test_setup),
+			 ztest_unit_test(test_sync),
+			 ztest_unit_test(test_work_q),
+			 ztest_unit_test(test_unregister_pending),
+			 ztest_unit_test(test_limits),
+			 ztest_unit_test(test_cleanup));
+
+	ztest_run_test_suite(socket_service);
+}
@@ -31,6 +31,15 @@ void test_socketpair_unsupported_calls(void)
 		.sun_family = AF_UNIX,
 	};
 	socklen_t len = sizeof(addr);
+	char buf[1];
+	struct iovec iov = {
+		.iov_base = buf,
+		.iov_len = sizeof(buf),
+	};
+	struct msghdr msg = {
+		.msg_iov = &iov,
+		.msg_iovlen = 1,
+	};
 
 	res = socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
 	zassert_equal(res, 0,
@@ -62,6 +71,12 @@ void test_socketpair_unsupported_calls(void)
 			"accept should fail on a socketpair endpoint");
 		zassert_equal(errno, EOPNOTSUPP,
 			"accept should set errno to EOPNOTSUPP");
+
+		res = recvmsg(sv[i], &msg, 0);
+		zassert_equal(res, -1,
+			"recvmsg should fail on a socketpair endpoint");
+		zassert_equal(errno, EOPNOTSUPP,
+			"recvmsg should set errno to EOPNOTSUPP");
 	}
 
 	res = close(sv[0]);
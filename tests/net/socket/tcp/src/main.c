@@ -13,6 +13,8 @@ LOG_MODULE_REGISTER(net_test, CONFIG_NET_SOCKETS_LOG_LEVEL);
 
 #include "../../socket_helpers.h"
 
+#include "tcp_internal.h"
+
 #define TEST_STR_SMALL "test"
 
 #define ANY_PORT 0
@@ -157,6 +159,7 @@ void test_v4_send_recv(void)
 	struct sockaddr_in s_saddr;
 	struct sockaddr addr;
 	socklen_t addrlen = sizeof(addr);
+	struct msghdr msg = { 0 };
 
 	prepare_sock_tcp_v4(CONFIG_NET_CONFIG_MY_IPV4_ADDR, ANY_PORT,
 			    &c_sock, &c_saddr);
@@ -172,6 +175,10 @@ void test_v4_send_recv(void)
 	test_accept(s_sock, &new_sock, &addr, &addrlen);
 	zassert_equal(addrlen, sizeof(struct sockaddr_in), "wrong addrlen");
 
+	/* A message without buffers receives nothing, also from user mode */
+	zassert_equal(recvmsg(new_sock, &msg, 0), 0,
+		      "unexpected received bytes");
+
 	test_recv(new_sock, MSG_PEEK);
 	test_recv(new_sock, 0);
 
@@ -184,6 +191,94 @@ void test_v4_send_recv(void)
 	k_sleep(TCP_TEARDOWN_TIMEOUT);
 }
 
+void test_v4_recvmsg(void)
+{
+	/* Test recvmsg() and the zero-copy receive on a stream socket. */
+	int c_sock;
+	int s_sock;
+	int new_sock;
+	struct sockaddr_in c_saddr;
+	struct sockaddr_in s_saddr;
+	struct sockaddr addr;
+	socklen_t addrlen = sizeof(addr);
+	char rx_buf[8] = {0};
+	struct iovec io_vector[2];
+	struct msghdr msg;
+	ssize_t recved;
+
+	prepare_sock_tcp_v4(CONFIG_NET_CONFIG_MY_IPV4_ADDR, ANY_PORT,
+			    &c_sock, &c_saddr);
+	prepare_sock_tcp_v4(CONFIG_NET_CONFIG_MY_IPV4_ADDR, SERVER_PORT,
+			    &s_sock, &s_saddr);
+
+	test_bind(s_sock, (struct sockaddr *)&s_saddr, sizeof(s_saddr));
+	test_listen(s_sock);
+
+	test_connect(c_sock, (struct sockaddr *)&s_saddr, sizeof(s_saddr));
+	test_send(c_sock, TEST_STR_SMALL, strlen(TEST_STR_SMALL), 0);
+
+	test_accept(s_sock, &new_sock, &addr, &addrlen);
+
+	/* Read the segment in two parts, scattered over two buffers */
+	io_vector[0].iov_base = rx_buf;
+	io_vector[0].iov_len = 1;
+	io_vector[1].iov_base = rx_buf + 1;
+	io_vector[1].iov_len = 1;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = io_vector;
+	msg.msg_iovlen = 2;
+
+	recved = recvmsg(new_sock, &msg, 0);
+	zassert_equal(recved, 2, "unexpected received bytes");
+	zassert_equal(msg.msg_flags, 0, "unexpected flags");
+
+	io_vector[0].iov_base = rx_buf + 2;
+	io_vector[0].iov_len = sizeof(rx_buf) - 2;
+	msg.msg_iovlen = 1;
+
+#if defined(CONFIG_NET_SOCKETS_RECV_ZEROCOPY)
+	/* The rest is lent without copying, peek first */
+	struct zsock_zc_buf zc;
+
+	recved = zsock_recvmsg_zc(new_sock, &msg, MSG_PEEK, &zc);
+	zassert_equal(recved, strlen(TEST_STR_SMALL) - 2,
+		      "unexpected received bytes");
+	zassert_equal(msg.msg_iovlen, 1, "unexpected iov count");
+	zsock_recv_zc_release(&zc);
+
+	struct net_context *ctx = zsock_get_context_object(new_sock);
+	uint32_t wnd = net_tcp_get_recv_wnd(ctx->tcp);
+
+	recved = zsock_recvmsg_zc(new_sock, &msg, 0, &zc);
+	zassert_equal(recved, strlen(TEST_STR_SMALL) - 2,
+		      "unexpected received bytes");
+	memcpy(rx_buf + 2, io_vector[0].iov_base, recved);
+
+	/* The window is only reopened once the buffers are released */
+	zassert_equal(net_tcp_get_recv_wnd(ctx->tcp), wnd,
+		      "window reopened before the release");
+	zsock_recv_zc_release(&zc);
+	zassert_equal(net_tcp_get_recv_wnd(ctx->tcp), wnd + recved,
+		      "window not reopened by the release");
+#else
+	recved = recvmsg(new_sock, &msg, 0);
+	zassert_equal(recved, strlen(TEST_STR_SMALL) - 2,
+		      "unexpected received bytes");
+#endif
+
+	zassert_equal(strncmp(rx_buf, TEST_STR_SMALL, strlen(TEST_STR_SMALL)),
+		      0, "unexpected data");
+
+	test_close(c_sock);
+	test_eof(new_sock);
+
+	test_close(new_sock);
+	test_close(s_sock);
+
+	k_sleep(TCP_TEARDOWN_TIMEOUT);
+}
+
 void test_v6_send_recv(void)
 {
 	/* Test if send() and recv() work on a ipv6 stream socket. */
@@ -517,6 +612,7 @@ void test_main(void)
 		socket_tcp,
 		ztest_user_unit_test(test_v4_send_recv),
 		ztest_user_unit_test(test_v6_send_recv),
+		ztest_unit_test(test_v4_recvmsg),
 		ztest_user_unit_test(test_v4_sendto_recvfrom),
 		ztest_user_unit_test(test_v6_sendto_recvfrom),
 		ztest_user_unit_test(test_v4_sendto_recvfrom_null_dest),
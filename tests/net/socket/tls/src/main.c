@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2020 Intel Corporation
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <ztest.h>
+#include <net/socket.h>
+#include <net/tls_credentials.h>
+
+#define SERVER_PORT 4243
+#define SERVER_TAG 1
+#define CA_TAG 2
+#define OTHER_SERVER_TAG 3
+#define OTHER_CA_TAG 4
+#define STACK_SIZE 4096
+
+/* The certificate is issued to "localhost". A client fails to verify it
+ * with another hostname, or when its CA tag holds the other certificate.
+ * The handshake then only succeeds if the server resumes a session and
+ * does not send its certificate.
+ */
+#define HOSTNAME "localhost"
+#define WRONG_HOSTNAME "wrong.example.com"
+
+static const unsigned char server_certificate[] = {
+#include "echo-apps-cert.der.inc"
+};
+
+static const unsigned char other_certificate[] = {
+#include "other-ca-cert.der.inc"
+};
+
+static const unsigned char private_key[] = {
+#include "echo-apps-key.der.inc"
+};
+
+static const struct sockaddr_in addr = {
+	.sin_family = AF_INET,
+	.sin_port = htons(SERVER_PORT),
+	.sin_addr = { { { 127, 0, 0, 1 } } },
+};
+
+static int listener;
+
+static K_THREAD_STACK_DEFINE(server_stack, STACK_SIZE);
+static struct k_thread server_thread;
+
+static void server(void *p1, void *p2, void *p3)
+{
+	char buf[16];
+	int sock;
+
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	while (true) {
+		/* Fails when the client rejects the certificate */
+		sock = accept(listener, NULL, NULL);
+		if (sock < 0) {
+			continue;
+		}
+
+		while (recv(sock, buf, sizeof(buf), 0) > 0) {
+		}
+
+		close(sock);
+	}
+}
+
+static void set_server_tag(sec_tag_t tag)
+{
+	zassert_equal(setsockopt(listener, SOL_TLS, TLS_SEC_TAG_LIST, &tag,
+				 sizeof(tag)), 0, "Cannot set the server tag");
+}
+
+/* Make the certificates of the CA tag of the clients the wrong ones, so
+ * that only a resumed session succeeds.
+ */
+static void set_ca(const unsigned char *cert, size_t len)
+{
+	zassert_equal(tls_credential_delete(CA_TAG,
+					    TLS_CREDENTIAL_CA_CERTIFICATE), 0,
+		      "Cannot delete the CA certificate");
+	zassert_equal(tls_credential_add(CA_TAG,
+					 TLS_CREDENTIAL_CA_CERTIFICATE,
+					 cert, len), 0,
+		      "Cannot add the CA certificate");
+}
+
+/* Returns 0 if the handshake succeeded */
+static int client_connect(const char *hostname, sec_tag_t tag)
+{
+	const sec_tag_t tags[] = { tag };
+	int cache = TLS_SESSION_CACHE_ENABLED;
+	int sock;
+	int ret;
+
+	sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TLS_1_2);
+	zassert_true(sock >= 0, "Cannot create the client socket");
+
+	zassert_equal(setsockopt(sock, SOL_TLS, TLS_SEC_TAG_LIST, tags,
+				 sizeof(tags)), 0, "Cannot set the CA tag");
+	zassert_equal(setsockopt(sock, SOL_TLS, TLS_HOSTNAME, hostname,
+				 strlen(hostname) + 1), 0,
+		      "Cannot set the hostname");
+	zassert_equal(setsockopt(sock, SOL_TLS, TLS_SESSION_CACHE, &cache,
+				 sizeof(cache)), 0,
+		      "Cannot enable the session cache");
+
+	ret = connect(sock, (struct sockaddr *)&addr, sizeof(addr));
+
+	close(sock);
+
+	return ret;
+}
+
+static void test_setup(void)
+{
+	int enable = TLS_SESSION_CACHE_ENABLED;
+
+	zassert_equal(tls_credential_add(SERVER_TAG,
+					 TLS_CREDENTIAL_SERVER_CERTIFICATE,
+					 server_certificate,
+					 sizeof(server_certificate)), 0,
+		      "Cannot add the server certificate");
+	zassert_equal(tls_credential_add(SERVER_TAG,
+					 TLS_CREDENTIAL_PRIVATE_KEY,
+					 private_key, sizeof(private_key)), 0,
+		      "Cannot add the private key");
+	zassert_equal(tls_credential_add(OTHER_SERVER_TAG,
+					 TLS_CREDENTIAL_SERVER_CERTIFICATE,
+					 server_certificate,
+					 sizeof(server_certificate)), 0,
+		      "Cannot add the other server certificate");
+	zassert_equal(tls_credential_add(OTHER_SERVER_TAG,
+					 TLS_CREDENTIAL_PRIVATE_KEY,
+					 private_key, sizeof(private_key)), 0,
+		      "Cannot add the other private key");
+	zassert_equal(tls_credential_add(CA_TAG,
+					 TLS_CREDENTIAL_CA_CERTIFICATE,
+					 server_certificate,
+					 sizeof(server_certificate)), 0,
+		      "Cannot add the CA certificate");
+	zassert_equal(tls_credential_add(OTHER_CA_TAG,
+					 TLS_CREDENTIAL_CA_CERTIFICATE,
+					 other_certificate,
+					 sizeof(other_certificate)), 0,
+		      "Cannot add the other CA certificate");
+
+	listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TLS_1_2);
+	zassert_true(listener >= 0, "Cannot create the listener");
+
+	set_server_tag(SERVER_TAG);
+
+	zassert_equal(setsockopt(listener, SOL_TLS, TLS_SESSION_CACHE,
+				 &enable, sizeof(enable)), 0,
+		      "Cannot enable the server session cache");
+	zassert_equal(bind(listener, (struct sockaddr *)&addr, sizeof(addr)),
+		      0, "Cannot bind");
+	zassert_equal(listen(listener, 1), 0, "Cannot listen");
+
+	k_thread_create(&server_thread, server_stack,
+			K_THREAD_STACK_SIZEOF(server_stack), server,
+			NULL, NULL, NULL, K_PRIO_PREEMPT(8), 0, K_NO_WAIT);
+}
+
+static void test_session_resume(void)
+{
+	zassert_equal(client_connect(HOSTNAME, OTHER_CA_TAG), -1,
+		      "Full handshake with a wrong CA succeeded");
+	zassert_equal(client_connect(WRONG_HOSTNAME, CA_TAG), -1,
+		      "Full handshake with a wrong hostname succeeded");
+
+	zassert_equal(client_connect(HOSTNAME, CA_TAG), 0,
+		      "Full handshake failed");
+
+	/* Only a resumed session skips the certificate */
+	set_ca(other_certificate, sizeof(other_certificate));
+
+	zassert_equal(client_connect(HOSTNAME, CA_TAG), 0,
+		      "Session not resumed");
+	zassert_equal(client_connect(HOSTNAME, CA_TAG), 0,
+		      "Session not resumed twice");
+
+	set_ca(server_certificate, sizeof(server_certificate));
+}
+
+static void test_session_resume_other_credentials(void)
+{
+	zassert_equal(client_connect(HOSTNAME, CA_TAG), 0,
+		      "Full handshake failed");
+
+	/* The client has a session, but it was established with other
+	 * credentials than the listener now uses.
+	 */
+	set_server_tag(OTHER_SERVER_TAG);
+	set_ca(other_certificate, sizeof(other_certificate));
+
+	zassert_equal(client_connect(HOSTNAME, CA_TAG), -1,
+		      "Session resumed with other credentials");
+
+	/* The client forgot its session when the handshake failed */
+	set_ca(server_certificate, sizeof(server_certificate));
+
+	zassert_equal(client_connect(HOSTNAME, CA_TAG), 0,
+		      "Full handshake failed");
+
+	set_ca(other_certificate, sizeof(other_certificate));
+
+	zassert_equal(client_connect(HOSTNAME, CA_TAG), 0,
+		      "Session not resumed");
+
+	set_ca(server_certificate, sizeof(server_certificate));
+	set_server_tag(SERVER_TAG);
+}
+
+/* A session is only resumed by a socket verifying the server the same
+ * way, even though it connects to the same address.
+ */
+static void test_session_other_client(void)
+{
+	zassert_equal(client_connect(HOSTNAME, CA_TAG), 0,
+		      "Full handshake failed");
+
+	zassert_equal(client_connect(WRONG_HOSTNAME, CA_TAG), -1,
+		      "Session resumed with another hostname");
+	zassert_equal(client_connect(HOSTNAME, OTHER_CA_TAG), -1,
+		      "Session resumed with other credentials");
+
+	/* The failures did not drop the session of the first socket */
+	set_ca(other_certificate, sizeof(other_certificate));
+
+	zassert_equal(client_connect(HOSTNAME, CA_TAG), 0,
+		      "Session not resumed");
+
+	set_ca(server_certificate, sizeof(server_certificate));
+}
+
+void test_main(void)
+{
+	ztest_test_suite(socket_tls,
+			 ztest_unit_test(test_setup),
+			 ztest_unit_test(test_session_resume),
+			 ztest_unit_test(test_session_resume_other_credentials),
+			 ztest_unit_test(test_session_other_client)
+			 );
+
+	ztest_run_test_suite(socket_tls);
+}
@@ -954,6 +954,304 @@ void test_v6_sendmsg_with_txtime(void)
 	test_started = false;
 }
 
+#define BATCH_MSGS (2 * CONFIG_NET_PKT_TX_COUNT)
+
+static ZTEST_BMEM struct mmsghdr batch_msgs[BATCH_MSGS];
+static ZTEST_BMEM struct iovec batch_iov;
+
+void test_v6_sendmmsg_batch(void)
+{
+	int rv;
+	int i;
+	int client_sock;
+	struct sockaddr_in6 client_addr;
+
+	prepare_sock_udp_v6(MY_IPV6_ADDR, ANY_PORT, &client_sock,
+			    &client_addr);
+
+	rv = bind(client_sock,
+		  (struct sockaddr *)&client_addr,
+		  sizeof(client_addr));
+	zassert_equal(rv, 0, "client bind failed");
+
+	rv = connect(client_sock, (struct sockaddr *)&server_addr,
+		     sizeof(server_addr));
+	zassert_equal(rv, 0, "connect failed");
+
+	batch_iov.iov_base = TEST_STR_SMALL;
+	batch_iov.iov_len = strlen(TEST_STR_SMALL);
+
+	memset(batch_msgs, 0, sizeof(batch_msgs));
+	for (i = 0; i < BATCH_MSGS; i++) {
+		batch_msgs[i].msg_hdr.msg_iov = &batch_iov;
+		batch_msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	/* The batch does not fit in the TX packets, so the datagrams held
+	 * back must be sent to make room for the rest.
+	 */
+	rv = sendmmsg(client_sock, batch_msgs, BATCH_MSGS, 0);
+	zassert_equal(rv, BATCH_MSGS, "sendmmsg failed (%d)", errno);
+
+	for (i = 0; i < BATCH_MSGS; i++) {
+		zassert_equal(batch_msgs[i].msg_len, batch_iov.iov_len,
+			      "invalid sent length");
+	}
+
+	rv = close(client_sock);
+	zassert_equal(rv, 0, "close failed");
+}
+
+static void prepare_v4_pair(int *client_sock, struct sockaddr_in *client_addr,
+			    int *server_sock, struct sockaddr_in *server_addr)
+{
+	int rv;
+
+	prepare_sock_udp_v4(CONFIG_NET_CONFIG_MY_IPV4_ADDR, ANY_PORT,
+			    client_sock, client_addr);
+	prepare_sock_udp_v4(CONFIG_NET_CONFIG_MY_IPV4_ADDR, SERVER_PORT,
+			    server_sock, server_addr);
+
+	rv = bind(*server_sock, (struct sockaddr *)server_addr,
+		  sizeof(*server_addr));
+	zassert_equal(rv, 0, "bind failed");
+}
+
+void test_v4_recvmsg(void)
+{
+	int rv;
+	int client_sock;
+	int server_sock;
+	struct sockaddr_in client_addr;
+	struct sockaddr_in server_addr;
+	struct sockaddr_in src_addr;
+	struct iovec io_vector[2];
+	struct msghdr msg;
+
+	prepare_v4_pair(&client_sock, &client_addr, &server_sock,
+			&server_addr);
+
+	rv = sendto(client_sock, BUF_AND_SIZE(TEST_STR2), 0,
+		    (struct sockaddr *)&server_addr, sizeof(server_addr));
+	zassert_equal(rv, STRLEN(TEST_STR2), "sendto failed");
+
+	/* Scatter the datagram over two buffers */
+	memset(rx_buf, 0, sizeof(rx_buf));
+	memset(&src_addr, 0, sizeof(src_addr));
+	io_vector[0].iov_base = rx_buf;
+	io_vector[0].iov_len = 100;
+	io_vector[1].iov_base = rx_buf + 100;
+	io_vector[1].iov_len = sizeof(rx_buf) - 100;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_name = &src_addr;
+	msg.msg_namelen = sizeof(src_addr);
+	msg.msg_iov = io_vector;
+	msg.msg_iovlen = 2;
+
+	rv = recvmsg(server_sock, &msg, 0);
+	zassert_equal(rv, STRLEN(TEST_STR2), "recvmsg failed");
+	zassert_mem_equal(rx_buf, TEST_STR2, STRLEN(TEST_STR2),
+			  "invalid rx data");
+	zassert_equal(msg.msg_flags, 0, "unexpected flags");
+	zassert_equal(msg.msg_namelen, sizeof(struct sockaddr_in),
+		      "invalid address length");
+	zassert_equal(src_addr.sin_family, AF_INET, "invalid address family");
+
+	/* A datagram not fitting in the buffers is truncated */
+	rv = sendto(client_sock, BUF_AND_SIZE(TEST_STR2), 0,
+		    (struct sockaddr *)&server_addr, sizeof(server_addr));
+	zassert_equal(rv, STRLEN(TEST_STR2), "sendto failed");
+
+	memset(rx_buf, 0, sizeof(rx_buf));
+	io_vector[0].iov_len = 10;
+	io_vector[1].iov_base = rx_buf + 10;
+	io_vector[1].iov_len = 10;
+	msg.msg_name = NULL;
+	msg.msg_namelen = 0;
+
+	rv = recvmsg(server_sock, &msg, 0);
+	zassert_equal(rv, 20, "recvmsg failed");
+	zassert_mem_equal(rx_buf, TEST_STR2, 20, "invalid rx data");
+	zassert_equal(msg.msg_flags, MSG_TRUNC, "MSG_TRUNC not set");
+
+	/* The rest of the truncated datagram is discarded */
+	rv = recv(server_sock, rx_buf, sizeof(rx_buf), MSG_DONTWAIT);
+	zassert_equal(rv, -1, "recv should fail");
+	zassert_equal(errno, EAGAIN, "invalid errno");
+
+	rv = close(client_sock);
+	zassert_equal(rv, 0, "close failed");
+	rv = close(server_sock);
+	zassert_equal(rv, 0, "close failed");
+}
+
+void test_v4_sendmmsg_recvmmsg(void)
+{
+	int rv;
+	int i;
+	int client_sock;
+	int server_sock;
+	struct sockaddr_in client_addr;
+	struct sockaddr_in server_addr;
+	struct iovec tx_iov[3];
+	struct iovec rx_iov[4];
+	struct mmsghdr msgs[4];
+	static const char * const tx_data[] = {
+		"first", "second datagram", "3",
+	};
+
+	prepare_v4_pair(&client_sock, &client_addr, &server_sock,
+			&server_addr);
+
+	rv = connect(client_sock, (struct sockaddr *)&server_addr,
+		     sizeof(server_addr));
+	zassert_equal(rv, 0, "connect failed");
+
+	memset(msgs, 0, sizeof(msgs));
+	for (i = 0; i < ARRAY_SIZE(tx_iov); i++) {
+		tx_iov[i].iov_base = (void *)tx_data[i];
+		tx_iov[i].iov_len = strlen(tx_data[i]);
+		msgs[i].msg_hdr.msg_iov = &tx_iov[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	rv = sendmmsg(client_sock, msgs, ARRAY_SIZE(tx_iov), 0);
+	zassert_equal(rv, ARRAY_SIZE(tx_iov), "sendmmsg failed");
+
+	for (i = 0; i < ARRAY_SIZE(tx_iov); i++) {
+		zassert_equal(msgs[i].msg_len, strlen(tx_data[i]),
+			      "invalid sent length");
+	}
+
+	/* Ask for more than there is, only the queued ones are returned */
+	memset(rx_buf, 0, sizeof(rx_buf));
+	memset(msgs, 0, sizeof(msgs));
+	for (i = 0; i < ARRAY_SIZE(rx_iov); i++) {
+		rx_iov[i].iov_base = rx_buf + i * 32;
+		rx_iov[i].iov_len = 32;
+		msgs[i].msg_hdr.msg_iov = &rx_iov[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	rv = recvmmsg(server_sock, msgs, ARRAY_SIZE(rx_iov), 0);
+	zassert_equal(rv, ARRAY_SIZE(tx_iov), "recvmmsg failed");
+
+	for (i = 0; i < ARRAY_SIZE(tx_iov); i++) {
+		zassert_equal(msgs[i].msg_len, strlen(tx_data[i]),
+			      "invalid received length");
+		zassert_mem_equal(rx_iov[i].iov_base, tx_data[i],
+				  strlen(tx_data[i]), "invalid rx data");
+	}
+
+	rv = recvmmsg(server_sock, msgs, ARRAY_SIZE(rx_iov), MSG_DONTWAIT);
+	zassert_equal(rv, -1, "recvmmsg should fail");
+	zassert_equal(errno, EAGAIN, "invalid errno");
+
+	rv = close(client_sock);
+	zassert_equal(rv, 0, "close failed");
+	rv = close(server_sock);
+	zassert_equal(rv, 0, "close failed");
+}
+
+#if defined(CONFIG_NET_SOCKETS_RECV_ZEROCOPY)
+static size_t gather_iov(struct msghdr *msg, char *buf, size_t len)
+{
+	size_t total = 0;
+	size_t i;
+
+	for (i = 0; i < msg->msg_iovlen; i++) {
+		zassert_true(total + msg->msg_iov[i].iov_len <= len,
+			     "too much data");
+		memcpy(buf + total, msg->msg_iov[i].iov_base,
+		       msg->msg_iov[i].iov_len);
+		total += msg->msg_iov[i].iov_len;
+	}
+
+	return total;
+}
+
+void test_v4_recvmsg_zc(void)
+{
+	int rv;
+	int client_sock;
+	int server_sock;
+	struct sockaddr_in client_addr;
+	struct sockaddr_in server_addr;
+	struct iovec io_vector[8];
+	struct zsock_zc_buf zc;
+	struct msghdr msg;
+
+	prepare_v4_pair(&client_sock, &client_addr, &server_sock,
+			&server_addr);
+
+	rv = sendto(client_sock, BUF_AND_SIZE(TEST_STR2), 0,
+		    (struct sockaddr *)&server_addr, sizeof(server_addr));
+	zassert_equal(rv, STRLEN(TEST_STR2), "sendto failed");
+
+	/* Peeking lends the data but leaves the datagram queued */
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = io_vector;
+	msg.msg_iovlen = ARRAY_SIZE(io_vector);
+
+	rv = zsock_recvmsg_zc(server_sock, &msg, MSG_PEEK, &zc);
+	zassert_equal(rv, STRLEN(TEST_STR2), "recvmsg_zc failed");
+	zassert_equal(zc.len, STRLEN(TEST_STR2), "invalid zc length");
+	zassert_not_null(zc.frag, "no fragment");
+	zassert_true(msg.msg_iovlen > 1, "data not in several fragments");
+
+	memset(rx_buf, 0, sizeof(rx_buf));
+	rv = gather_iov(&msg, rx_buf, sizeof(rx_buf));
+	zassert_equal(rv, STRLEN(TEST_STR2), "invalid iov length");
+	zassert_mem_equal(rx_buf, TEST_STR2, STRLEN(TEST_STR2),
+			  "invalid rx data");
+	zsock_recv_zc_release(&zc);
+
+	/* Now consume it */
+	msg.msg_iovlen = ARRAY_SIZE(io_vector);
+
+	rv = zsock_recvmsg_zc(server_sock, &msg, 0, &zc);
+	zassert_equal(rv, STRLEN(TEST_STR2), "recvmsg_zc failed");
+
+	memset(rx_buf, 0, sizeof(rx_buf));
+	rv = gather_iov(&msg, rx_buf, sizeof(rx_buf));
+	zassert_mem_equal(rx_buf, TEST_STR2, STRLEN(TEST_STR2),
+			  "invalid rx data");
+	zsock_recv_zc_release(&zc);
+	zsock_recv_zc_release(&zc);
+
+	/* Not enough entries for all the fragments */
+	rv = sendto(client_sock, BUF_AND_SIZE(TEST_STR2), 0,
+		    (struct sockaddr *)&server_addr, sizeof(server_addr));
+	zassert_equal(rv, STRLEN(TEST_STR2), "sendto failed");
+
+	msg.msg_iovlen = 1;
+
+	rv = zsock_recvmsg_zc(server_sock, &msg, 0, &zc);
+	zassert_true(rv > 0 && rv < STRLEN(TEST_STR2), "recvmsg_zc failed");
+	zassert_equal(msg.msg_iovlen, 1, "invalid iov count");
+	zassert_equal(msg.msg_flags, MSG_TRUNC, "MSG_TRUNC not set");
+	zassert_mem_equal(io_vector[0].iov_base, TEST_STR2, rv,
+			  "invalid rx data");
+	zsock_recv_zc_release(&zc);
+
+	msg.msg_iovlen = ARRAY_SIZE(io_vector);
+	rv = zsock_recvmsg_zc(server_sock, &msg, MSG_DONTWAIT, &zc);
+	zassert_equal(rv, -1, "recvmsg_zc should fail");
+	zassert_equal(errno, EAGAIN, "invalid errno");
+
+	rv = close(client_sock);
+	zassert_equal(rv, 0, "close failed");
+	rv = close(server_sock);
+	zassert_equal(rv, 0, "close failed");
+}
+#else
+void test_v4_recvmsg_zc(void)
+{
+	ztest_test_skip();
+}
+#endif /* CONFIG_NET_SOCKETS_RECV_ZEROCOPY */
+
 void test_main(void)
 {
 	k_thread_system_pool_assign(k_current_get());
@@ -976,9 +1274,16 @@ void test_main(void)
 			 ztest_user_unit_test(test_v4_sendmsg_recvfrom_connected),
 			 ztest_unit_test(test_v6_sendmsg_recvfrom_connected),
 			 ztest_user_unit_test(test_v6_sendmsg_recvfrom_connected),
+			 ztest_unit_test(test_v4_recvmsg),
+			 ztest_user_unit_test(test_v4_recvmsg),
+			 ztest_unit_test(test_v4_recvmsg_zc),
+			 ztest_unit_test(test_v4_sendmmsg_recvmmsg),
+			 ztest_user_unit_test(test_v4_sendmmsg_recvmmsg),
 			 ztest_unit_test(test_setup_eth),
 			 ztest_unit_test(test_v6_sendmsg_with_txtime),
-			 ztest_user_unit_test(test_v6_sendmsg_with_txtime)
+			 ztest_user_unit_test(test_v6_sendmsg_with_txtime),
+			 ztest_unit_test(test_v6_sendmmsg_batch),
+			 ztest_user_unit_test(test_v6_sendmmsg_batch)
 		);
 
 	ztest_run_test_suite(socket_udp);
@@ -14,6 +14,9 @@ LOG_MODULE_REGISTER(net_test, CONFIG_NET_WEBSOCKET_LOG_LEVEL);
 #include <net/websocket.h>
 
 #include "websocket_internal.h"
+#if defined(CONFIG_WEBSOCKET_DEFLATE)
+#include "websocket_deflate.h"
+#endif
 
 /* Generated by http://www.lipsum.com/
  * 2 paragraphs, 178 words, 1160 bytes of Lorem Ipsum
@@ -373,6 +376,205 @@ static void test_recv_two_large_split_msg(void)
 		      test_msg_len, ret);
 }
 
+#if defined(CONFIG_WEBSOCKET_DEFLATE)
+/* Compressed frame from RFC 7692 chapter 7.2.3.1, RSV1 and FIN bits set,
+ * opcode is text (1), payload length is 7, unmasked data is "Hello"
+ */
+static const unsigned char deflate_frame[] = {
+	0xc1, 0x07, 0xf2, 0x48, 0xcd, 0xc9, 0xc9, 0x07, 0x00
+};
+
+static void test_deflate_recv(void)
+{
+	struct websocket_context ctx;
+	uint32_t msg_type = -1;
+	uint64_t remaining = -1;
+	int ret;
+
+	memset(&ctx, 0, sizeof(ctx));
+
+	ctx.tmp_buf = temp_recv_buf;
+	ctx.tmp_buf_len = sizeof(temp_recv_buf);
+	ctx.deflate = true;
+
+	memcpy(feed_buf, deflate_frame, sizeof(deflate_frame));
+
+	/* The message is returned only when all of it is received */
+	ret = test_recv_buf(&feed_buf[0], 4, &ctx, &msg_type, &remaining,
+			    recv_buf, sizeof(recv_buf));
+	zassert_equal(ret, -EAGAIN, "Partial message returned (%d)", ret);
+	zassert_equal(msg_type, WEBSOCKET_FLAG_FINAL | WEBSOCKET_FLAG_TEXT,
+		      "Invalid message type 0x%x", msg_type);
+
+	ret = test_recv_buf(&feed_buf[4], sizeof(deflate_frame) - 4, &ctx,
+			    &msg_type, &remaining, recv_buf, sizeof(recv_buf));
+	zassert_equal(ret, 5, "Cannot inflate message (%d)", ret);
+	zassert_mem_equal(recv_buf, "Hello", 5, "Invalid message");
+	zassert_equal(remaining, 0, "Msg not empty");
+
+	/* Then an uncompressed message on the same context */
+	memcpy(feed_buf, frame1, sizeof(frame1));
+
+	ret = test_recv_buf(&feed_buf[0], sizeof(frame1), &ctx, &msg_type,
+			    &remaining, recv_buf, sizeof(recv_buf));
+	zassert_equal(ret, sizeof(frame1_msg) - 1, "Cannot read data (%d)",
+		      ret);
+	zassert_mem_equal(recv_buf, frame1_msg, sizeof(frame1_msg) - 1,
+			  "Invalid message");
+}
+
+static void test_deflate_recv_not_negotiated(void)
+{
+	struct websocket_context ctx;
+	uint32_t msg_type = -1;
+	uint64_t remaining = -1;
+	int ret;
+
+	memset(&ctx, 0, sizeof(ctx));
+
+	ctx.tmp_buf = temp_recv_buf;
+	ctx.tmp_buf_len = sizeof(temp_recv_buf);
+
+	memcpy(feed_buf, deflate_frame, sizeof(deflate_frame));
+
+	ret = test_recv_buf(&feed_buf[0], sizeof(deflate_frame), &ctx,
+			    &msg_type, &remaining, recv_buf, sizeof(recv_buf));
+	zassert_equal(ret, -ENOTSUP, "Compressed message accepted (%d)", ret);
+
+	/* The connection is failed rather than stuck on the frame */
+	ret = test_recv_buf(&feed_buf[0], 0, &ctx, &msg_type, &remaining,
+			    recv_buf, sizeof(recv_buf));
+	zassert_equal(ret, -ECONNABORTED, "Connection not failed (%d)", ret);
+}
+
+/* The compressed frame above in two fragments, from the same chapter of
+ * RFC 7692, with a ping carrying "hi" between them
+ */
+static const unsigned char deflate_fragments[] = {
+	0x41, 0x03, 0xf2, 0x48, 0xcd,
+	0x89, 0x02, 'h', 'i',
+	0x80, 0x04, 0xc9, 0xc9, 0x07, 0x00
+};
+
+static void test_deflate_recv_fragmented(void)
+{
+	struct websocket_context ctx;
+	uint32_t msg_type = -1;
+	uint64_t remaining = -1;
+	int ret;
+
+	memset(&ctx, 0, sizeof(ctx));
+
+	ctx.tmp_buf = temp_recv_buf;
+	ctx.tmp_buf_len = sizeof(temp_recv_buf);
+	ctx.deflate = true;
+
+	memcpy(feed_buf, deflate_fragments, sizeof(deflate_fragments));
+
+	/* All the frames are buffered by the first call */
+	ret = test_recv_buf(&feed_buf[0], sizeof(deflate_fragments), &ctx,
+			    &msg_type, &remaining, recv_buf, sizeof(recv_buf));
+	zassert_equal(ret, -EAGAIN, "Partial message returned (%d)", ret);
+	zassert_equal(msg_type, WEBSOCKET_FLAG_TEXT,
+		      "Invalid message type 0x%x", msg_type);
+
+	ret = test_recv_buf(&feed_buf[0], 0, &ctx, &msg_type, &remaining,
+			    recv_buf, sizeof(recv_buf));
+	zassert_equal(ret, 2, "Cannot read the ping (%d)", ret);
+	zassert_equal(msg_type, WEBSOCKET_FLAG_FINAL | WEBSOCKET_FLAG_PING,
+		      "Invalid message type 0x%x", msg_type);
+	zassert_mem_equal(recv_buf, "hi", 2, "Invalid ping");
+
+	ret = test_recv_buf(&feed_buf[0], 0, &ctx, &msg_type, &remaining,
+			    recv_buf, sizeof(recv_buf));
+	zassert_equal(ret, 5, "Cannot inflate message (%d)", ret);
+	zassert_equal(msg_type, WEBSOCKET_FLAG_FINAL | WEBSOCKET_FLAG_TEXT,
+		      "Invalid message type 0x%x", msg_type);
+	zassert_mem_equal(recv_buf, "Hello", 5, "Invalid message");
+	zassert_equal(remaining, 0, "Msg not empty");
+	zassert_equal(ctx.tmp_buf_pos, 0, "Data left in the temp buffer");
+}
+
+static void test_deflate_recv_too_big(void)
+{
+	struct websocket_context ctx;
+	uint32_t msg_type = -1;
+	uint64_t remaining = -1;
+	int ret;
+
+	memset(&ctx, 0, sizeof(ctx));
+
+	/* The first fragment fits, but not the header of the next one */
+	ctx.tmp_buf = temp_recv_buf;
+	ctx.tmp_buf_len = 8;
+	ctx.deflate = true;
+
+	memcpy(feed_buf, deflate_fragments, sizeof(deflate_fragments));
+
+	ret = test_recv_buf(&feed_buf[0], sizeof(deflate_fragments), &ctx,
+			    &msg_type, &remaining, recv_buf, sizeof(recv_buf));
+	zassert_equal(ret, -EMSGSIZE, "Too big message accepted (%d)", ret);
+
+	ret = test_recv_buf(&feed_buf[0], 0, &ctx, &msg_type, &remaining,
+			    recv_buf, sizeof(recv_buf));
+	zassert_equal(ret, -ECONNABORTED, "Connection not failed (%d)", ret);
+}
+
+static void test_deflate_round_trip(void)
+{
+	static uint16_t deflate_work[WS_DEFLATE_WORK_SIZE / sizeof(uint16_t)];
+	static struct ws_inflate_work inflate_work;
+	static uint8_t compressed[sizeof(lorem_ipsum)];
+	size_t len = sizeof(lorem_ipsum) - 1;
+	int compressed_len;
+	int ret;
+
+	compressed_len = websocket_deflate(lorem_ipsum, len, compressed,
+					   sizeof(compressed), deflate_work);
+	zassert_true(compressed_len > 0 && compressed_len < len,
+		     "Cannot deflate message (%d)", compressed_len);
+
+	ret = websocket_inflate(compressed, compressed_len, recv_buf,
+				sizeof(recv_buf), &inflate_work);
+	zassert_equal(ret, len, "Cannot inflate message (%d)", ret);
+	zassert_mem_equal(recv_buf, lorem_ipsum, len, "Invalid message");
+
+	/* The message does not fit */
+	ret = websocket_inflate(compressed, compressed_len, recv_buf,
+				len - 1, &inflate_work);
+	zassert_equal(ret, -EMSGSIZE, "Too long message inflated (%d)", ret);
+
+	ret = websocket_deflate(lorem_ipsum, len, compressed, 16,
+				deflate_work);
+	zassert_equal(ret, -ENOSPC, "Too long message deflated (%d)", ret);
+}
+#else
+static void test_deflate_recv(void)
+{
+	ztest_test_skip();
+}
+
+static void test_deflate_recv_not_negotiated(void)
+{
+	ztest_test_skip();
+}
+
+static void test_deflate_recv_fragmented(void)
+{
+	ztest_test_skip();
+}
+
+static void test_deflate_recv_too_big(void)
+{
+	ztest_test_skip();
+}
+
+static void test_deflate_round_trip(void)
+{
+	ztest_test_skip();
+}
+#endif /* CONFIG_WEBSOCKET_DEFLATE */
+
 void test_main(void)
 {
 	k_thread_system_pool_assign(k_current_get());
@@ -390,7 +592,12 @@ void test_main(void)
 			 ztest_unit_test(test_recv_whole_msg),
 			 ztest_unit_test(test_recv_two_msg),
 			 ztest_unit_test(test_send_and_recv_lorem_ipsum),
-			 ztest_unit_test(test_recv_two_large_split_msg)
+			 ztest_unit_test(test_recv_two_large_split_msg),
+			 ztest_unit_test(test_deflate_recv),
+			 ztest_unit_test(test_deflate_recv_not_negotiated),
+			 ztest_unit_test(test_deflate_recv_fragmented),
+			 ztest_unit_test(test_deflate_recv_too_big),
+			 ztest_unit_test(test_deflate_round_trip)
 		);
 
 	ztest_run_test_suite(websocket);
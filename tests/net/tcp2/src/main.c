@@ -94,6 +94,8 @@ static void handle_server_test(sa_family_t af, struct tcphdr *th);
 static void handle_syn_resend(void);
 static void handle_client_fin_wait_2_test(sa_family_t af, struct tcphdr *th);
 static void handle_client_closing_test(sa_family_t af, struct tcphdr *th);
+static void handle_syn_queue_test(struct tcphdr *th);
+static void handle_client_refused_test(sa_family_t af, struct tcphdr *th);
 
 static void verify_flags(struct tcphdr *th, uint8_t flags,
 			 const char *fun, int line)
@@ -376,6 +378,12 @@ static int tester_send(struct device *dev, struct net_pkt *pkt)
 	case 8:
 		handle_client_closing_test(net_pkt_family(pkt), &th);
 		break;
+	case 9:
+		handle_syn_queue_test(&th);
+		break;
+	case 10:
+		handle_client_refused_test(net_pkt_family(pkt), &th);
+		break;
 	default:
 		zassert_true(false, "Undefined test case");
 	}
@@ -466,6 +474,33 @@ fail:
 	zassert_true(false, "%s failed", __func__);
 }
 
+static void tcp_info_cb(const struct net_tcp_info *info, void *user_data)
+{
+	struct net_tcp_info *found = user_data;
+
+	if (info->context == found->context) {
+		*found = *info;
+	}
+}
+
+static void test_tcp_info_verify(struct net_context *ctx)
+{
+	struct net_tcp_info info = { .context = ctx };
+
+	net_tcp_info_foreach(tcp_info_cb, &info);
+
+	zassert_not_null(info.state, "Connection not found");
+	zassert_true(info.rto >= CONFIG_NET_TCP_MIN_RETRANSMISSION_TIMEOUT,
+		     "RTO %u below the minimum", info.rto);
+	zassert_true(info.rto < CONFIG_NET_TCP_INIT_RETRANSMISSION_TIMEOUT,
+		     "RTO %u not adapted to the RTT", info.rto);
+#if defined(CONFIG_NET_TCP_CONGESTION_CONTROL)
+	zassert_not_null(info.cc, "No congestion control");
+	zassert_true(info.cwnd >= 2 * info.mss, "Invalid cwnd %u",
+		     info.cwnd);
+#endif
+}
+
 /* Test case scenario IPv4
  *   send SYN,
  *   expect SYN ACK,
@@ -515,6 +550,9 @@ static void test_client_ipv4(void)
 	/* Peer will release the semaphone after it sends ACK for data */
 	test_sem_take(K_MSEC(100), __LINE__);
 
+	/* The data was acknowledged, so RTT should have been sampled */
+	test_tcp_info_verify(ctx);
+
 	net_tcp_put(ctx);
 
 	/* Peer will release the semaphone after it receives
@@ -1167,6 +1205,276 @@ static void test_client_closing_ipv6(void)
 	k_sleep(K_MSEC(CONFIG_NET_TCP_TIME_WAIT_DELAY));
 }
 
+static struct tcphdr syn_queue_th;
+
+static void handle_syn_queue_test(struct tcphdr *th)
+{
+	syn_queue_th = *th;
+	test_sem_give();
+}
+
+static void syn_queue_send(uint16_t port, uint8_t flags)
+{
+	struct net_pkt *pkt;
+
+	pkt = tester_prepare_tcp_pkt(AF_INET, htons(port), htons(MY_PORT),
+				     flags, NULL, 0U);
+	zassert_not_null(pkt, "Failed to prepare packet");
+
+	zassert_true(net_recv_data(iface, pkt) >= 0, "Failed to recv packet");
+}
+
+/* Test case scenario IPv4
+ *   listen with one SYN queue entry,
+ *   send SYN from two ports,
+ *   expect SYN ACK to the first one,
+ *   expect the second one to be dropped, or SYN ACK with a cookie
+ *   if SYN cookies are enabled,
+ *   send ACK, expect the connections to be accepted,
+ *   send ACK with an invalid cookie, expect RST.
+ *   any failures cause test case to fail.
+ */
+static void test_server_syn_queue(void)
+{
+	struct net_context *ctx;
+	uint32_t isn, cookie = 0U;
+	int ret;
+
+	test_case_no = 9;
+	seq = ack = 0;
+
+	ret = net_context_get(AF_INET, SOCK_STREAM, IPPROTO_TCP, &ctx);
+	if (ret < 0) {
+		zassert_true(false, "Failed to get net_context");
+	}
+
+	ret = net_context_bind(ctx, (struct sockaddr *)&my_addr_s,
+			       sizeof(struct sockaddr_in));
+	if (ret < 0) {
+		zassert_true(false, "Failed to bind net_context");
+	}
+
+	ret = net_context_listen(ctx, 1);
+	if (ret < 0) {
+		zassert_true(false, "Failed to listen on net_context");
+	}
+
+	ret = net_context_accept(ctx, test_tcp_accept_cb, K_FOREVER, NULL);
+	if (ret < 0) {
+		zassert_true(false, "Failed to set accept on net_context");
+	}
+
+	syn_queue_send(PEER_PORT + 1, SYN);
+	test_sem_take(K_MSEC(100), __LINE__);
+	test_verify_flags(&syn_queue_th, SYN | ACK);
+	zassert_equal(ntohl(syn_queue_th.th_ack), seq + 1U, "Invalid ack");
+	isn = ntohl(syn_queue_th.th_seq);
+
+	syn_queue_send(PEER_PORT + 2, SYN);
+
+	if (IS_ENABLED(CONFIG_NET_TCP_SYN_COOKIES)) {
+		test_sem_take(K_MSEC(100), __LINE__);
+		test_verify_flags(&syn_queue_th, SYN | ACK);
+		cookie = ntohl(syn_queue_th.th_seq);
+	} else {
+		zassert_equal(k_sem_take(&test_sem, K_MSEC(100)), -EAGAIN,
+			      "SYN accepted with a full SYN queue");
+	}
+
+	seq = 1U;
+	ack = isn + 1U;
+	syn_queue_send(PEER_PORT + 1, ACK);
+
+	/* test_tcp_accept_cb will release the semaphore */
+	test_sem_take(K_MSEC(100), __LINE__);
+
+	if (IS_ENABLED(CONFIG_NET_TCP_SYN_COOKIES)) {
+		ack = cookie + 1U;
+		syn_queue_send(PEER_PORT + 2, ACK);
+		test_sem_take(K_MSEC(100), __LINE__);
+
+		ack = cookie + 2U;
+		syn_queue_send(PEER_PORT + 3, ACK);
+		test_sem_take(K_MSEC(100), __LINE__);
+		test_verify_flags(&syn_queue_th, RST);
+	}
+
+	net_context_put(ctx);
+}
+
+static void handle_client_refused_test(sa_family_t af, struct tcphdr *th)
+{
+	struct net_pkt *reply;
+
+	/* Only reset the first connection, the peer of the second one
+	 * does not answer.
+	 */
+	if (t_state != T_SYN) {
+		return;
+	}
+
+	test_verify_flags(th, SYN);
+
+	seq = 0U;
+	ack = ntohl(th->th_seq) + 1U;
+	reply = tester_prepare_tcp_pkt(af, htons(MY_PORT), th->th_sport,
+				       RST | ACK, NULL, 0U);
+	t_state = T_SYN_ACK;
+
+	if (net_recv_data(iface, reply) < 0) {
+		zassert_true(false, "%s failed", __func__);
+	}
+}
+
+/* Test case scenario IPv4
+ *   send SYN,
+ *   expect RST, connect fails with ECONNREFUSED,
+ *   send SYN,
+ *   peer doesn't reply, connect fails with ETIMEDOUT.
+ *   The connection of the first attempt is released while
+ *   net_context_connect() waits for it.
+ */
+static void test_client_refused(void)
+{
+	struct net_context *ctx;
+	int ret;
+
+	t_state = T_SYN;
+	test_case_no = 10;
+
+	ret = net_context_get(AF_INET, SOCK_STREAM, IPPROTO_TCP, &ctx);
+	if (ret < 0) {
+		zassert_true(false, "Failed to get net_context");
+	}
+
+	ret = net_context_connect(ctx, (struct sockaddr *)&peer_addr_s,
+				  sizeof(struct sockaddr_in),
+				  NULL, K_MSEC(500), NULL);
+	zassert_equal(ret, -ECONNREFUSED, "Connection not refused (%d)", ret);
+
+	net_context_put(ctx);
+
+	ret = net_context_get(AF_INET, SOCK_STREAM, IPPROTO_TCP, &ctx);
+	if (ret < 0) {
+		zassert_true(false, "Failed to get net_context");
+	}
+
+	ret = net_context_connect(ctx, (struct sockaddr *)&peer_addr_s,
+				  sizeof(struct sockaddr_in),
+				  NULL, K_MSEC(100), NULL);
+	zassert_equal(ret, -ETIMEDOUT, "Connection not timed out (%d)", ret);
+
+	net_context_put(ctx);
+}
+
+#if defined(CONFIG_NET_TCP_CONGESTION_CONTROL)
+#define TEST_MSS 1000U
+
+/* Test NewReno: slow start, fast retransmit/fast recovery with
+ * partial and full ACKs, congestion avoidance and the RTO reaction.
+ */
+static void test_cc_newreno(void)
+{
+	struct tcp_cc cc;
+	uint32_t recover = 1000U;
+
+	tcp_cc_init(&cc, tcp_cc_find("newreno"), TEST_MSS);
+
+	zassert_equal(cc.cwnd, 10U * TEST_MSS, "Invalid initial window");
+
+	tcp_cc_ack(&cc, 0U, TEST_MSS, 0U);
+	zassert_equal(cc.cwnd, 11U * TEST_MSS, "No slow start");
+
+	zassert_false(tcp_cc_dup_ack(&cc, 8U * TEST_MSS, recover), "");
+	zassert_false(tcp_cc_dup_ack(&cc, 8U * TEST_MSS, recover), "");
+	zassert_true(tcp_cc_dup_ack(&cc, 8U * TEST_MSS, recover),
+		     "No fast retransmit on the third duplicate ACK");
+	zassert_true(cc.in_recovery, "Not in fast recovery");
+	zassert_equal(cc.ssthresh, 4U * TEST_MSS, "Invalid ssthresh");
+	zassert_equal(cc.cwnd, 7U * TEST_MSS, "Invalid cwnd in recovery");
+
+	zassert_false(tcp_cc_dup_ack(&cc, 8U * TEST_MSS, recover), "");
+	zassert_equal(cc.cwnd, 8U * TEST_MSS, "cwnd not inflated");
+
+	/* Partial ACK keeps the recovery going */
+	tcp_cc_ack(&cc, recover - 1U, 2U * TEST_MSS, 0U);
+	zassert_true(cc.in_recovery, "Partial ACK ended the recovery");
+	zassert_equal(cc.cwnd, 7U * TEST_MSS, "cwnd not deflated");
+
+	tcp_cc_ack(&cc, recover, TEST_MSS, 0U);
+	zassert_false(cc.in_recovery, "Full ACK did not end the recovery");
+	zassert_equal(cc.cwnd, cc.ssthresh, "cwnd not set to ssthresh");
+
+	/* One MSS per window worth of ACKed data */
+	tcp_cc_ack(&cc, 0U, 2U * TEST_MSS, 0U);
+	zassert_equal(cc.cwnd, 4U * TEST_MSS, "Too fast increase");
+	tcp_cc_ack(&cc, 0U, 2U * TEST_MSS, 0U);
+	zassert_equal(cc.cwnd, 5U * TEST_MSS, "No congestion avoidance");
+
+	tcp_cc_timeout(&cc, 5U * TEST_MSS);
+	zassert_equal(cc.cwnd, TEST_MSS, "Invalid loss window");
+	zassert_equal(cc.ssthresh, 2500U, "Invalid ssthresh after RTO");
+}
+
+/* Test CUBIC: multiplicative decrease by beta, concave growth up to the
+ * previous maximum, convex growth beyond it and the fast convergence.
+ */
+static void test_cc_cubic(void)
+{
+	uint32_t w_max = 20U * TEST_MSS;
+	uint32_t now = 1000U;
+	struct tcp_cc cc;
+	int i;
+
+	tcp_cc_init(&cc, tcp_cc_find("cubic"), TEST_MSS);
+	cc.cwnd = w_max;
+	cc.ssthresh = w_max;
+
+	for (i = 0; i < TCP_CC_DUPACK_THRESHOLD; i++) {
+		tcp_cc_dup_ack(&cc, w_max, 0U);
+	}
+
+	zassert_equal(cc.ssthresh, 14U * TEST_MSS, "Invalid beta");
+	tcp_cc_ack(&cc, 0U, TEST_MSS, now);
+	zassert_equal(cc.cwnd, 14U * TEST_MSS, "Invalid cwnd after loss");
+
+	/* K = cbrt(6 / 0.4) ~ 2.466 s, ack one window every 250 ms */
+	for (i = 0; i < 9; i++) {
+		now += 250U;
+		tcp_cc_ack(&cc, 0U, cc.cwnd, now);
+		zassert_true(cc.cwnd <= w_max, "cwnd %u exceeded W_max before K",
+			     cc.cwnd);
+	}
+
+	zassert_true(cc.cwnd > 17U * TEST_MSS, "cwnd %u not grown",
+		     cc.cwnd);
+
+	for (i = 0; i < 8; i++) {
+		now += 250U;
+		tcp_cc_ack(&cc, 0U, cc.cwnd, now);
+	}
+
+	zassert_true(cc.cwnd > w_max + 2U * TEST_MSS,
+		     "cwnd %u not probing beyond W_max", cc.cwnd);
+
+	/* Second loss before reaching the last maximum */
+	cc.cwnd = 16U * TEST_MSS;
+	tcp_cc_timeout(&cc, cc.cwnd);
+	zassert_equal(cc.cubic.w_max, 13600U, "No fast convergence");
+	zassert_equal(cc.cwnd, TEST_MSS, "Invalid loss window");
+}
+#else
+static void test_cc_newreno(void)
+{
+	ztest_test_skip();
+}
+
+static void test_cc_cubic(void)
+{
+	ztest_test_skip();
+}
+#endif /* CONFIG_NET_TCP_CONGESTION_CONTROL */
+
 /** Test case main entry */
 void test_main(void)
 {
@@ -1179,7 +1487,11 @@ void test_main(void)
 			 ztest_unit_test(test_server_ipv6),
 			 ztest_unit_test(test_client_syn_resend),
 			 ztest_unit_test(test_client_fin_wait_2_ipv4),
-			 ztest_unit_test(test_client_closing_ipv6)
+			 ztest_unit_test(test_client_closing_ipv6),
+			 ztest_unit_test(test_server_syn_queue),
+			 ztest_unit_test(test_client_refused),
+			 ztest_unit_test(test_cc_newreno),
+			 ztest_unit_test(test_cc_cubic)
 			 );
 
 	ztest_run_test_suite(test_tcp_fn);